@@ -0,0 +1,59 @@
+//  File
+//      FontCompiler.cpp
+//
+//  Abstract
+//      A console application for compiling a Hershey single-stroke font
+//      (*.jhf) into a glyph store file for LoadCharSet.
+//
+//  Usage
+//      FontCompiler <font.jhf> <store.rsf> [first code]
+//
+//  Necessary Sources
+//      RTC5Font.h, RTC5Font.cpp, RTC5List.h, RTC5List.cpp
+//
+//  Environment: Win32, Linux
+
+// System header files
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "RTC5Font.h"
+
+int main( int argc, char* argv[] )
+{
+    if ( argc < 3 )
+    {
+        printf( "Usage: FontCompiler <font.jhf> <store.rsf> [first code]\n" );
+        return 1;
+
+    }
+
+    const UINT FirstCode = argc > 3 ? (UINT) atoi( argv[ 3 ] ) : 32;
+
+    GlyphStore Store;
+    UINT ErrorCode = Store.CompileHershey( argv[ 1 ], FirstCode );
+
+    if ( ErrorCode )
+    {
+        printf( "Font file %s: Error %d detected\n", argv[ 1 ], ErrorCode );
+        return 1;
+
+    }
+
+    ErrorCode = Store.Save( argv[ 2 ] );
+
+    if ( ErrorCode )
+    {
+        printf( "Glyph store %s: Error %d detected\n", argv[ 2 ], ErrorCode );
+        return 1;
+
+    }
+
+    printf( "Glyphs:      %u\n", Store.GlyphCount() );
+    printf( "Vertices:    %u\n", Store.VertexCount() );
+    printf( "Height:      %d [font units]\n", Store.Height() );
+    printf( "Hash:        %016llX\n", (unsigned long long) Store.Hash() );
+
+    return 0;
+
+}
@@ -0,0 +1,3944 @@
+//  File
+//      HostBench.cpp
+//
+//  Abstract
+//      A console application for benchmarking the host library against
+//      the RTC5 emulator. The emulator runs free (time scale 0), every RTC5
+//      function call costs the given host call latency in simulated time.
+//
+//  Usage
+//      HostBench serial [parts] [call latency us]
+//          Serial number marking, list rebuilt per part against the
+//          preloaded part list of SerialEngine started externally.
+//      HostBench slots [parts] [call latency us]
+//          Recipe changes per part, list download per part against
+//          SlotManager with resident jobs selected by set_extstartpos.
+//      HostBench subs [copies] [call latency us]
+//          Array job of one logo, every vector transferred against
+//          SubCompiler with one subroutine and sub_call per copy.
+//      HostBench jobs [vectors] [call latency us]
+//          Hatch job generated in code against a mapped job file,
+//          both streamed by the ListFeeder.
+//      HostBench timing [parts] [call latency us]
+//          TimeEstimator breakdown and throughput of a job with polylines,
+//          arcs, pixel lines, delays and sky writing, checked against the
+//          marking time of the emulator.
+//      HostBench wave [vectors] [call latency us]
+//          Hatch job streamed by the ListFeeder while a WaveCapture records
+//          two and four channels, the wave file checked for gaps.
+//      HostBench track [vectors] [call latency us]
+//          TrackAnalyzer on a four channel capture of the emulator with
+//          a galvo model, SSE2 against scalar loops, and its report.
+//      HostBench monitor [vectors] [call latency us]
+//          Hatch job fed in chunks with host stalls in between, fill level
+//          events of a ListMonitor, Chrome trace written to HostBench.json.
+//      HostBench head [vectors] [call latency us]
+//          Values of two intelliSCANs read the way of Demo7 against a
+//          HeadTelemetry polling them while the ListFeeder streams a hatch
+//          job.
+//      HostBench tune [patterns]
+//          DelayTuner on a test pattern of squares, stars, circles and
+//          hatch lines, one thread against all, profile written to
+//          HostBench.ini.
+//      HostBench galvo [seconds] [call latency us]
+//          GalvoModel kernel, SSE2 against scalar, and a hatch job of the
+//          given marking time run by the emulator without and with the
+//          galvo model, wall time per simulated hour.
+//      HostBench preview [parts] [pixels]
+//          PreviewRenderer on an array of parts with subroutines, text,
+//          arcs and pixel lines, scalar against SSE2 and one thread against
+//          all, preview written to HostBench.pgm, HostBench.png and the
+//          dwell map to HostBenchHeat.png.
+//      HostBench poly [patterns]
+//          PolyDelayTable of the default head, a job of test patterns run
+//          by the emulator with one polygon delay for all corners against
+//          the table, written to HostBenchPoly.ini and loaded.
+//      HostBench sky [parts]
+//          SkyPlanner on parts of squares, stars, circles and hatch lines
+//          at two mark speeds for several corner errors, cycle time before
+//          and after the plan.
+//      HostBench hatch [shapes]
+//          HatchEngine on rings, stars and combs imported from a job, one
+//          thread against all and scalar against SSE2, marking time of the
+//          orderings, and the hatch streamed by the ListFeeder after and
+//          while it is computed.
+//      HostBench contour [shapes]
+//          ContourEngine on pairs of overlapping rings, stars and combs,
+//          union, difference and the offsets for a hatch border and a kerf,
+//          one thread against all, and the hatch of the result.
+//      HostBench slice [parts]
+//          SliceEngine on a binary STL of standing tori, time to the first
+//          layer and layers per second for contours and hatch, one thread
+//          against all, and the 3D layers streamed by the ListFeeder after
+//          and while they are sliced.
+//      HostBench clip [vectors]
+//          FieldClipper on polylines, arcs and park jumps within the field,
+//          reaching beyond it and around a keep-out star, scalar against
+//          SSE2, the clipped stream fed to the emulator, and the contours
+//          of an area clipped before the hatch.
+//      HostBench tile [parts]
+//          TileEngine on clusters of parts spread over 12 x 9 fields,
+//          stage travel of serpentine rows against the planned order, one
+//          thread against all, and the tiles streamed by the ListFeeder
+//          with stage moves of the emulated stepper motors.
+//      HostBench conveyor [parts]
+//          ConveyorScheduler on rings, stars and combs passing on a
+//          conveyor, the highest sustainable speed, and the parts streamed
+//          by the ListFeeder at speeds below and above it with the encoder
+//          of the emulator, fly overflows against the plan.
+//      HostBench prepare [parts]
+//          PrepareEngine on parts scattered in random order, transformed
+//          and reordered per chunk, time to the first mark for growing
+//          jobs prepared whole on one thread against in chunks on all,
+//          and both streamed by the ListFeeder.
+//      HostBench arena [figures]
+//          Stars, raster lines and serial numbers built into a ListJob per
+//          figure against a CommandBuffer per figure and fed to the
+//          emulator, heap calls per million commands and percentiles of
+//          the host time of the feeder loop, and the slabs a PrepareEngine
+//          allocates from run to run.
+//      HostBench font [glyphs]
+//          GlyphStore compiled from a generated Hershey font, saved and
+//          loaded, and LoadCharSet called repeatedly: the transfer is
+//          skipped while the card holds the tag of the same store and
+//          scale, repeated after a scale change and load_program_file.
+//      HostBench server [jobs] [call latency us]
+//          JobServer on the emulator shared by four client processes, each
+//          submitting hatch jobs at its own priority in shared memory, the
+//          time queued per priority, the longest switch between jobs and
+//          the round trip of a status request (Linux only).
+//      HostBench ring [million commands]
+//          CommandRing between a producer process and this one, commands
+//          per second for batches of 1 to 4096 commands against a socket,
+//          and a hatch job fed to the emulator from the ring against in
+//          process (Linux only).
+//
+//  Necessary Sources
+//      RTC5Arena.h, RTC5Clip.h, RTC5Contour.h, RTC5Conveyor.h, RTC5Emu.h, RTC5Feeder.h, RTC5Font.h,
+//      RTC5Galvo.h, RTC5Hatch.h, RTC5Head.h, RTC5Job.h, RTC5Monitor.h, RTC5Poly.h, RTC5Prepare.h,
+//      RTC5Preview.h, RTC5Ring.h, RTC5Serial.h, RTC5Server.h, RTC5Sky.h, RTC5Slice.h, RTC5Slots.h,
+//      RTC5Subs.h, RTC5Tile.h, RTC5Timing.h, RTC5Track.h, RTC5Tune.h, RTC5Wave.h, HostHeap.cpp and the
+//      RTC5Host library
+//
+//  Environment: Win32, Linux
+
+// System header files
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#endif
+
+#include "RTC5Arena.h"
+#include "RTC5Clip.h"
+#include "RTC5Contour.h"
+#include "RTC5Conveyor.h"
+#include "RTC5Emu.h"
+#include "RTC5Feeder.h"
+#include "RTC5Font.h"
+#include "RTC5Galvo.h"
+#include "RTC5Hatch.h"
+#include "RTC5Head.h"
+#include "RTC5Job.h"
+#include "RTC5Monitor.h"
+#include "RTC5Poly.h"
+#include "RTC5Prepare.h"
+#include "RTC5Preview.h"
+#ifndef _WIN32
+#include "RTC5Ring.h"
+#endif
+#include "RTC5Serial.h"
+#ifndef _WIN32
+#include "RTC5Server.h"
+#endif
+#include "RTC5Sky.h"
+#include "RTC5Slice.h"
+#include "RTC5Slots.h"
+#include "RTC5Subs.h"
+#include "RTC5Tile.h"
+#include "RTC5Timing.h"
+#include "RTC5Track.h"
+#include "RTC5Tune.h"
+#include "RTC5Wave.h"
+
+//  Heap calls of the whole program, counted for BenchArena by HostHeap.cpp
+extern std::atomic< uint64_t > HeapCalls;
+
+const UINT   CharWidth            =          600;   //  [bits]
+const UINT   CharHeight           =         1000;   //  [bits]
+const UINT   CharAdvance          =          800;   //  [bits]
+
+struct BenchResult
+{
+    UINT     Parts;
+    double   SimSeconds;
+    uint64_t HostCalls;
+    double   WallSeconds;
+
+};
+
+//  Every character is a box, so the marking time does not depend on the
+//  characters but the number of vectors is realistic.
+static void LoadBoxFont( UINT CharSet )
+{
+    for ( UINT c = 32; c < 128; c++ )
+    {
+        load_char( CharSet * 256 + c );
+
+        if ( c != ' ' )
+        {
+            mark_rel( CharWidth, 0 );
+            mark_rel( 0, CharHeight );
+            mark_rel( -(LONG) CharWidth, 0 );
+            mark_rel( 0, -(LONG) CharHeight );
+
+        }
+
+        jump_rel( CharAdvance, 0 );
+        list_return();
+
+    }
+
+}
+
+static UINT OpenEmulator( double Latency )
+{
+    if ( RTC5EmuOpen() ) return 1;
+
+    RTC5EmuSetTimeScale( 0.0 );
+    RTC5EmuSetCallLatency( Latency );
+
+    if ( load_program_file( 0 ) ) return 1;
+
+    config_list( 4000, 4000 );
+
+    set_start_list( 1 );
+        set_jump_speed( 5000.0 );   //  [bits/ms]
+        set_mark_speed( 1000.0 );   //  [bits/ms]
+        set_scanner_delays( 25, 10, 5 );
+    set_end_of_list();
+    execute_list( 1 );
+
+    LoadBoxFont( 0 );
+
+    return get_last_error() ? 1 : 0;
+
+}
+
+//  The host waits without polling, one get_status confirms the end
+static void WaitIdle()
+{
+    UINT Busy, Pos;
+
+    do
+    {
+        RTC5EmuRunToIdle();
+        get_status( &Busy, &Pos );
+
+    } while ( Busy );
+
+}
+
+static void Report( const char* Name, const BenchResult& r )
+{
+    printf( "%-22s %8u parts  %10.1f parts/min  %8.2f host calls/part  %8.1f ms wall\n",
+            Name, r.Parts,
+            r.SimSeconds > 0.0 ? r.Parts * 60.0 / r.SimSeconds : 0.0,
+            r.Parts ? (double) r.HostCalls / r.Parts : 0.0,
+            r.WallSeconds * 1e3 );
+
+}
+
+//  Reference: the host builds and starts the list of every part
+static BenchResult SerialRebuild( UINT Parts )
+{
+    BenchResult r;
+    const auto     Wall  = std::chrono::steady_clock::now();
+    const double   Sim   = RTC5EmuTime();
+    const uint64_t Calls = RTC5EmuHostCalls();
+
+    for ( UINT i = 0; i < Parts; i++ )
+    {
+        char Serial[ 16 ];
+        sprintf( Serial, "%08u", i + 1 );
+
+        WaitIdle();
+
+        load_list( 1, 0 );
+            select_char_set( 0 );
+            jump_abs( -8000, 0 );
+            mark_text( "SN" );
+            jump_abs( -6000, 0 );
+            mark_text( Serial );
+            jump_abs( -6000, -1500 );
+            mark_date( 0, 1 );
+        set_end_of_list();
+        execute_list( 1 );
+
+    }
+
+    WaitIdle();
+
+    r.Parts       = Parts;
+    r.SimSeconds  = RTC5EmuTime() - Sim;
+    r.HostCalls   = RTC5EmuHostCalls() - Calls;
+    r.WallSeconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count();
+    return r;
+
+}
+
+//  SerialEngine: one preload, the parts are started by /START
+static BenchResult SerialPreloaded( UINT Parts )
+{
+    BenchResult r;
+    const auto     Wall  = std::chrono::steady_clock::now();
+    const double   Sim   = RTC5EmuTime();
+    const uint64_t Calls = RTC5EmuHostCalls();
+
+    SerialJob Job;
+    Job.Literal( -8000, 0, "SN" );
+    Job.Number( -6000, 0, 0, 1, 8 );
+    Job.Date( -6000, -1500, 0, 1 );
+
+    SerialEngine Engine;
+    WaitIdle();
+
+    //  A second field of set 0 would mark the next number
+    SerialJob Twice = Job;
+    Twice.Number( -6000, -3000, 0, 1, 8 );
+
+    if ( Engine.Preload( Twice, 2, 0, Parts ) != SerialRangeError || Engine.Preload( Job, 2, 0, Parts ) )
+    {
+        printf( "Preload failed\n" );
+        memset( &r, 0, sizeof( r ) );
+        return r;
+
+    }
+
+    UINT Started = 0;
+
+    //  /START of the next part as soon as the card is idle
+    do
+    {
+        RTC5EmuRunToIdle();
+
+    } while ( Started < Parts && RTC5EmuExtStart() && ++Started );
+
+    RTC5EmuRunToIdle();
+
+    r.Parts       = Engine.PartsDone();
+    r.SimSeconds  = RTC5EmuTime() - Sim;
+    r.HostCalls   = RTC5EmuHostCalls() - Calls;
+    r.WallSeconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count();
+
+    printf( "Last serial number:    %.0f\n", Engine.LastSerial() );
+    return r;
+
+}
+
+static int BenchSerial( int argc, char* argv[] )
+{
+    const UINT   Parts   = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 10000;
+    const double Latency = ( argc > 3 ? atof( argv[ 3 ] ) : 50.0 ) * 1e-6;
+
+    if ( OpenEmulator( Latency ) )
+    {
+        printf( "Emulator could not be initialized\n" );
+        return 1;
+
+    }
+
+    const BenchResult Rebuild   = SerialRebuild( Parts );
+    const BenchResult Preloaded = SerialPreloaded( Parts );
+
+    printf( "Host call latency:     %.1f us\n", Latency * 1e6 );
+    Report( "list per part", Rebuild );
+    Report( "preloaded, /START", Preloaded );
+
+    RTC5EmuClose();
+    return Preloaded.Parts == Parts ? 0 : 1;
+
+}
+
+//  A recipe: speeds and delays followed by a closed star polygon
+static ListJob MakeRecipe( UINT Recipe, UINT Vertices )
+{
+    ListJob Job;
+    Job.push_back( ListMakeD( OpSetJumpSpeed, 5000.0 ) );
+    Job.push_back( ListMakeD( OpSetMarkSpeed, 500.0 + 50.0 * Recipe ) );
+    Job.push_back( ListMake( OpSetScannerDelays, 25, 10, 5 ) );
+
+    const double R = 200.0 + 10.0 * Recipe;
+
+    for ( UINT i = 0; i <= Vertices; i++ )
+    {
+        const double a = 2.0 * 3.14159265358979 * i / Vertices;
+        const double r = i % 2 ? R : 0.6 * R;
+        const LONG   x = (LONG) ( r * cos( a ) );
+        const LONG   y = (LONG) ( r * sin( a ) );
+        Job.push_back( ListMake( i ? OpMarkAbs : OpJumpAbs, x, y ) );
+
+    }
+
+    Job.push_back( ListMake( OpEndOfList ) );
+    return Job;
+
+}
+
+struct SwitchResult
+{
+    BenchResult Run;
+    double      MeanLatency;    //  recipe request until ready for /START [s]
+    double      MaxLatency;
+
+};
+
+static int BenchSlots( int argc, char* argv[] )
+{
+    const UINT   Parts   = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 5000;
+    const double Latency = ( argc > 3 ? atof( argv[ 3 ] ) : 50.0 ) * 1e-6;
+    const UINT   Recipes = 24;
+    const UINT   ListSize = 6000;      //  fits about half of the recipes
+
+    if ( OpenEmulator( Latency ) )
+    {
+        printf( "Emulator could not be initialized\n" );
+        return 1;
+
+    }
+
+    config_list( ListSize, ListSize );
+
+    std::mt19937 Random( 5 );
+    std::vector< ListJob >  Jobs;
+    std::vector< uint64_t > Ids;
+
+    for ( UINT i = 0; i < Recipes; i++ )
+    {
+        Jobs.push_back( MakeRecipe( i, 200 + (UINT) ( Random() % 1300 ) ) );
+        Ids.push_back( ListHash( Jobs[ i ].data(), Jobs[ i ].size() ) );
+
+    }
+
+    //  Mostly a few hot recipes, sometimes any other
+    std::vector< UINT > Sequence( Parts );
+
+    for ( UINT i = 0; i < Parts; i++ )
+    {
+        Sequence[ i ] = Random() % 10 < 8 ? Random() % 6 : Random() % Recipes;
+
+    }
+
+    SwitchResult Result[ 2 ];
+
+    for ( UINT Mode = 0; Mode < 2; Mode++ )
+    {
+        SlotManager Slots;
+        Slots.Init( ListSize, ListSize );
+
+        const auto     Wall  = std::chrono::steady_clock::now();
+        const double   Sim   = RTC5EmuTime();
+        const uint64_t Calls = RTC5EmuHostCalls();
+        double Sum = 0.0, Max = 0.0;
+
+        set_control_mode( 1 );
+
+        for ( UINT i = 0; i < Parts; i++ )
+        {
+            const ListJob& Job = Jobs[ Sequence[ i ] ];
+
+            WaitIdle();
+            const double Request = RTC5EmuTime();
+
+            if ( Mode == 0 )
+            {
+                //  Download the recipe into list 1 for every part
+                load_list( 1, 0 );
+                ListReplay( Job.data(), Job.size() );
+                set_extstartpos( 0 );
+
+            }
+            else if (   Slots.Load( Ids[ Sequence[ i ] ], Job )
+                     || Slots.Select( Ids[ Sequence[ i ] ] )
+                    )
+            {
+                printf( "Slot error\n" );
+                return 1;
+
+            }
+
+            const double Ready = RTC5EmuTime() - Request;
+            Sum += Ready;
+            Max  = std::max( Max, Ready );
+
+            RTC5EmuExtStart();
+
+        }
+
+        WaitIdle();
+
+        BenchResult& r = Result[ Mode ].Run;
+        r.Parts       = Parts;
+        r.SimSeconds  = RTC5EmuTime() - Sim;
+        r.HostCalls   = RTC5EmuHostCalls() - Calls;
+        r.WallSeconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count();
+        Result[ Mode ].MeanLatency = Sum / Parts;
+        Result[ Mode ].MaxLatency  = Max;
+
+        if ( Mode == 1 )
+        {
+            printf( "Slots: %llu hits, %llu loads, %llu evictions, %u resident, %u free\n",
+                    (unsigned long long) Slots.Hits, (unsigned long long) Slots.Loads,
+                    (unsigned long long) Slots.Evictions, Slots.Resident(), Slots.FreeSpace() );
+
+        }
+
+    }
+
+    printf( "Host call latency:     %.1f us\n", Latency * 1e6 );
+    Report( "list per part", Result[ 0 ].Run );
+    Report( "job slots", Result[ 1 ].Run );
+    printf( "Recipe change:         list per part %.2f ms mean %.2f ms max, job slots %.3f ms mean %.2f ms max\n",
+            Result[ 0 ].MeanLatency * 1e3, Result[ 0 ].MaxLatency * 1e3,
+            Result[ 1 ].MeanLatency * 1e3, Result[ 1 ].MaxLatency * 1e3 );
+
+    //  A text at the end of list 2 taking more positions than records wraps
+    //  to the start of list 2, list 1 is not touched. A job only list 1
+    //  can hold evicts from list 1 only.
+    {
+        config_list( 1000, 600 );
+        RTC5EmuSetTextBytes( 4 );
+
+        SlotManager Slots;
+        Slots.Init( 1000, 600 );
+
+        ListJob Text;
+        Text.push_back( ListMake( OpJumpAbs, 0, 0 ) );
+        ListAppendText( Text, OpMarkTextAbs, std::string( 200, 'A' ).c_str() );
+        Text.push_back( ListMake( OpEndOfList ) );
+
+        const ListJob Job[ 4 ] = { MakeRecipe( 0, 595 ), MakeRecipe( 1, 390 ), MakeRecipe( 2, 195 ), MakeRecipe( 3, 380 ) };
+        UINT Error = SlotNoError;
+
+        for ( UINT i = 0; i < 4; i++ ) Error |= Slots.Load( i, Job[ i ] );     //  list 1: 0 and 1, list 2: 2 and 3
+
+        Error |= Slots.Load( 4, Text );         //  11 records at the last 15 positions of list 2, 53 positions
+
+        const bool Wrapped =    Slots.Position( 0 ) != SlotNone && Slots.Position( 1 ) != SlotNone
+                             && Slots.Position( 2 ) == SlotNone && Slots.Position( 3 ) != SlotNone
+                             && Slots.Position( 4 ) != SlotNone && Slots.FreeSpace() == 1600 - 600 - 395 - 385 - 53;
+        const UINT Free = Slots.FreeSpace();
+
+        Error |= Slots.Load( 0, Job[ 0 ] );     //  list 2 jobs the least recently used
+        Error |= Slots.Load( 1, Job[ 1 ] );
+        Error |= Slots.Load( 5, MakeRecipe( 5, 695 ) );
+
+        const bool Kept = Slots.Position( 5 ) < 1000 && Slots.Position( 3 ) != SlotNone && Slots.Position( 4 ) != SlotNone;
+
+        RTC5EmuSetTextBytes( ListTextBytes );
+
+        printf( "Wrap in list 2:        list 1 jobs %s, %u free, a job for list 1 only %s\n",
+                Wrapped ? "kept" : "LOST", Free, Kept ? "kept list 2" : "EVICTED list 2" );
+
+        if ( Error || !Wrapped || !Kept )
+        {
+            printf( "Slot error %u\n", Error );
+            RTC5EmuClose();
+            return 1;
+
+        }
+
+    }
+
+    RTC5EmuClose();
+    return 0;
+
+}
+
+//  A logo at X, Y: a circle of 64 vectors and three strokes inside
+static void AppendLogo( ListJob& Job, LONG X, LONG Y )
+{
+    const double R = 1500.0;
+
+    for ( UINT i = 0; i <= 64; i++ )
+    {
+        const double a = 2.0 * 3.14159265358979 * i / 64;
+        Job.push_back( ListMake( i ? OpMarkAbs : OpJumpAbs, X + (LONG) ( R * cos( a ) ), Y + (LONG) ( R * sin( a ) ) ) );
+
+    }
+
+    for ( LONG k = -1; k <= 1; k++ )
+    {
+        Job.push_back( ListMake( OpJumpAbs, X + k * 600, Y - 1000 ) );
+        Job.push_back( ListMake( OpMarkAbs, X + k * 600, Y + 1000 ) );
+
+    }
+
+}
+
+//  Loads Job into list 1 and runs it, returns the load time [s]
+static double LoadAndRun( const ListJob& Job, double* RunTime )
+{
+    WaitIdle();
+    const double Load = RTC5EmuTime();
+
+    load_list( 1, 0 );
+    ListReplay( Job.data(), Job.size() );
+    set_end_of_list();
+
+    const double Start = RTC5EmuTime();
+    execute_list( 1 );
+    WaitIdle();
+
+    *RunTime = RTC5EmuTime() - Start;
+    return Start - Load;
+
+}
+
+static int BenchSubs( int argc, char* argv[] )
+{
+    const UINT   Copies  = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 400;
+    const double Latency = ( argc > 3 ? atof( argv[ 3 ] ) : 50.0 ) * 1e-6;
+
+    if ( OpenEmulator( Latency ) )
+    {
+        printf( "Emulator could not be initialized\n" );
+        return 1;
+
+    }
+
+    config_list( 500000, 4000 );
+
+    //  Array of copies on a square grid, 4000 bits apart
+    const UINT Columns = (UINT) ceil( sqrt( (double) Copies ) );
+    ListJob Flat;
+
+    for ( UINT i = 0; i < Copies; i++ )
+    {
+        AppendLogo( Flat, -30000 + 4000 * (LONG) ( i % Columns ), -30000 + 4000 * (LONG) ( i / Columns ) );
+
+    }
+
+    SubCompiler Compiler;
+    ListJob     Compiled;
+    Compiler.BlockGap = 3000;   //  circle and strokes form one block
+
+    const auto Wall = std::chrono::steady_clock::now();
+    Compiler.Compile( Flat, Compiled );
+    const double CompileTime = std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count();
+
+    double FlatRun, SubRun;
+    uint64_t Calls = RTC5EmuHostCalls();
+    const double FlatLoad = LoadAndRun( Flat, &FlatRun );
+    const uint64_t FlatCalls = RTC5EmuHostCalls() - Calls;
+
+    Calls = RTC5EmuHostCalls();
+    double SubLoad = RTC5EmuTime();
+    Compiler.LoadSubs();
+    SubLoad = RTC5EmuTime() - SubLoad;
+    SubLoad += LoadAndRun( Compiled, &SubRun );
+    const uint64_t SubCalls = RTC5EmuHostCalls() - Calls;
+
+    printf( "Host call latency:     %.1f us\n", Latency * 1e6 );
+    printf( "Blocks: %u, subroutines: %u, sub_call: %u, compile %.2f ms\n",
+            Compiler.Stats.Blocks, Compiler.SubCount(), Compiler.Stats.Instances, CompileTime * 1e3 );
+    printf( "%-22s %8u records  %8llu host calls  %9.2f ms load  %9.2f ms marking\n",
+            "every vector", (UINT) Flat.size(), (unsigned long long) FlatCalls, FlatLoad * 1e3, FlatRun * 1e3 );
+    printf( "%-22s %8u records  %8llu host calls  %9.2f ms load  %9.2f ms marking\n",
+            "sub_call per copy", (UINT) ( Compiled.size() + Compiler.Stats.SubRecords ),
+            (unsigned long long) SubCalls, SubLoad * 1e3, SubRun * 1e3 );
+
+    //  The same array moved by an offset and a matrix of its own, then by an
+    //  offset for both heads: the compiled job must draw the same image
+    {
+        ListJob Moved, MovedCompiled;
+        ListCommand Offset = ListMake( OpSetOffset, 1000, -500 );
+        Offset.Arg = 1;
+        Moved.push_back( Offset );
+
+        for ( UINT i = 1; i <= 2; i++ )
+        {
+            ListCommand Scale = ListMakeD( OpSetMatrix, 0.5 );
+            Scale.Arg    = 1;
+            Scale.I[ 0 ] = Scale.I[ 1 ] = i;
+            Moved.push_back( Scale );
+
+        }
+
+        Moved.insert( Moved.end(), Flat.begin(), Flat.begin() + Flat.size() / 2 );
+        Moved.push_back( ListMake( OpSetOffset, -2000, 700 ) );
+        Moved.insert( Moved.end(), Flat.begin() + Flat.size() / 2, Flat.end() );
+
+        SubCompiler MovedCompiler;
+        MovedCompiler.BlockGap = Compiler.BlockGap;
+        MovedCompiler.Compile( Moved, MovedCompiled );
+
+        PreviewRenderer FlatPreview, SubPreview;
+        FlatPreview.Render( Moved.data(), Moved.size() );
+
+        for ( UINT i = 0; i < MovedCompiler.SubCount(); i++ )
+        {
+            SubPreview.SetSub( i, MovedCompiler.Sub( i ).data(), MovedCompiler.Sub( i ).size() );
+
+        }
+
+        SubPreview.Render( MovedCompiled.data(), MovedCompiled.size() );
+
+        const bool Same =    FlatPreview.Image == SubPreview.Image && FlatPreview.MinX == SubPreview.MinX
+                          && FlatPreview.MinY == SubPreview.MinY && FlatPreview.Strokes == SubPreview.Strokes;
+
+        printf( "Preset offset, matrix: %u sub_call, image %s\n", MovedCompiler.Stats.Instances, Same ? "equal" : "DIFFERS" );
+
+        if ( !Same || !MovedCompiler.Stats.Instances )
+        {
+            RTC5EmuClose();
+            return 1;
+
+        }
+
+    }
+
+    RTC5EmuClose();
+    return 0;
+
+}
+
+//  Hatching of a circle, the way a program computes it from the geometry
+static void MakeHatch( ListJob& Job, UINT Vectors )
+{
+    const double R = 2000.0;
+
+    for ( UINT i = 0; i < Vectors; i++ )
+    {
+        const double y = -R + 2.0 * R * ( i + 0.5 ) / Vectors;
+        const double x = sqrt( R * R - y * y );
+        const LONG   s = i % 2 ? -1 : 1;
+
+        Job.push_back( ListMake( OpJumpAbs, (LONG) ( -s * x ), (LONG) y ) );
+        Job.push_back( ListMake( OpMarkAbs, (LONG) (  s * x ), (LONG) y ) );
+
+    }
+
+}
+
+static void ReportFeed( const char* Name, double Prepare, double Wall, double Sim, const ListFeeder& Feeder )
+{
+    printf( "%-22s %9.2f ms prepare  %9.2f ms wall  %9.1f ms simulated  %8llu chunks  %6llu polls  %4llu waits\n",
+            Name, Prepare * 1e3, Wall * 1e3, Sim * 1e3,
+            (unsigned long long) Feeder.Chunks, (unsigned long long) Feeder.Polls, (unsigned long long) Feeder.Waits );
+
+}
+
+static int BenchJobs( int argc, char* argv[] )
+{
+    const UINT   Vectors  = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 100000;
+    const double Latency  = ( argc > 3 ? atof( argv[ 3 ] ) : 50.0 ) * 1e-6;
+    const UINT   ListSize = 8000;
+    const char*  Name     = "HostBench.rjb";
+
+    if ( OpenEmulator( Latency ) )
+    {
+        printf( "Emulator could not be initialized\n" );
+        return 1;
+
+    }
+
+    config_list( ListSize, 0 );
+
+    JobFileHeader Params;
+    JobDefaults( Params );
+    Params.JumpSpeed = 5000.0;
+    Params.MarkSpeed = 2000.0;
+
+    //  Compiled once
+    {
+        ListJob Job;
+        MakeHatch( Job, Vectors );
+
+        if ( JobWrite( Name, Params, Job.data(), Job.size() ) )
+        {
+            printf( "%s could not be written\n", Name );
+            return 1;
+
+        }
+
+    }
+
+    for ( UINT Mode = 0; Mode < 2; Mode++ )
+    {
+        ListFeeder Feeder;
+        JobFile    File;
+        ListJob    Job;
+
+        const auto   Wall = std::chrono::steady_clock::now();
+        const double Sim  = RTC5EmuTime();
+
+        //  Recipe switch: compute the geometry or map the file
+        if ( Mode == 0 )
+        {
+            JobSetup( Params, Job );
+            MakeHatch( Job, Vectors );
+
+        }
+        else if ( File.Open( Name ) )
+        {
+            printf( "%s could not be mapped\n", Name );
+            return 1;
+
+        }
+
+        const double Prepare = std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count();
+
+        Feeder.Pause = RTC5EmuAdvance;
+
+        UINT Error = Feeder.Open( ListSize, 2000 );
+
+        if ( !Error ) Error = Mode == 0 ? Feeder.Feed( Job.data(), Job.size() ) : Feeder.Feed( File );
+        if ( !Error ) Error = Feeder.Finish();
+
+        if ( Error )
+        {
+            printf( "Feeder error %u\n", Error );
+            return 1;
+
+        }
+
+        ReportFeed( Mode == 0 ? "generated per run" : "mapped job file",
+                    Prepare,
+                    std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count(),
+                    RTC5EmuTime() - Sim, Feeder );
+
+    }
+
+    remove( Name );
+    RTC5EmuClose();
+    return 0;
+
+}
+
+//  One part: a star, an arc, a pixel line and a subroutine, every second
+//  part with sky writing
+static void MakeTimingPart( ListJob& Job, UINT Part )
+{
+    const LONG x0 = (LONG) ( Part % 8 ) * 4000 - 16000;
+    const LONG y0 = (LONG) ( Part / 8 % 8 ) * 4000 - 16000;
+
+    Job.push_back( ListMake( OpSaveAndRestartTimer ) );
+
+    if ( Part % 2 )
+    {
+        ListCommand Para = ListMake( OpSetSkyWritingPara, 0, 20, 20 );
+        Para.D[ 0 ] = 200.0;
+        Job.push_back( Para );
+        Job.push_back( ListMakeD( OpSetSkyWritingLimit, 0.5 ) );
+        Job.push_back( ListMake( OpSetSkyWritingMode, 3 ) );
+
+    }
+
+    Job.push_back( ListMake( OpJumpAbs, x0 + 1500, y0 ) );
+
+    for ( UINT k = 1; k <= 10; k++ )
+    {
+        const double a = k * 3.14159265358979323846 / 5.0;
+        const double r = k % 2 ? 600.0 : 1500.0;
+        Job.push_back( ListMake( OpMarkAbs, x0 + (LONG) ( r * cos( a ) ), y0 + (LONG) ( r * sin( a ) ) ) );
+
+    }
+
+    if ( Part % 2 ) Job.push_back( ListMake( OpSetSkyWritingMode, 0 ) );
+
+    Job.push_back( ListMake( OpJumpAbs, x0 + 1800, y0 ) );
+    ListCommand Arc = ListMake( OpArcRel, -1800, 0 );
+    Arc.D[ 0 ] = 270.0;
+    Job.push_back( Arc );
+
+    Job.push_back( ListMake( OpJumpAbs, x0 - 1000, y0 - 1900 ) );
+    ListCommand Line = ListMakeD( OpSetPixelLine, 50.0, 0.0 );
+    Line.Arg    = 1;
+    Line.I[ 0 ] = 20 * 64;
+    Job.push_back( Line );
+    Job.push_back( ListMake( OpSetNPixel, 40, 1023, 20 ) );
+    Job.push_back( ListMake( OpSetNPixel,  0,    0, 20 ) );
+
+    Job.push_back( ListMake( OpLongDelay, 20 ) );
+    Job.push_back( ListMake( OpJumpAbs, x0 - 500, y0 + 1000 ) );
+    Job.push_back( ListMake( OpSubCallAbs, 0 ) );
+
+}
+
+//  A job whose times are worked out by hand, independent of the model:
+//  jump 1000 bits/ms = 10 bits and mark 250 bits/ms = 2.5 bits per 10 us,
+//  jump delay 250 us, mark delay 100 us, polygon delay 50 us, laser on
+//  delay -40 us, laser off delay 300 us
+static bool CheckTimingModel()
+{
+    ListJob Job;
+    Job.push_back( ListMakeD( OpSetJumpSpeed, 1000.0 ) );
+    Job.push_back( ListMakeD( OpSetMarkSpeed,  250.0 ) );
+    Job.push_back( ListMake( OpSetScannerDelays, 25, 10, 5 ) );
+    Job.push_back( ListMake( OpSetLaserDelays, -40, 300 ) );
+    Job.push_back( ListMake( OpJumpAbs, 1000,   0 ) );     //  1000 bits: 1 ms + jump delay
+    Job.push_back( ListMake( OpMarkAbs, 1000, 500 ) );     //  laser on delay + 500 bits: 2 ms
+    Job.push_back( ListMake( OpMarkAbs,    0, 500 ) );     //  polygon delay + 1000 bits: 4 ms
+    Job.push_back( ListMake( OpJumpAbs,    0,   0 ) );     //  mark delay + 200 us laser off + 500 bits: 0.5 ms + jump delay
+
+    TimeBreakdown Expected;
+    Expected.Clear();
+    Expected.T[ TimeJump ]         = 1.5e-3;
+    Expected.T[ TimeMark ]         = 6.0e-3;
+    Expected.T[ TimeJumpDelay ]    = 2 * 250e-6;
+    Expected.T[ TimeMarkDelay ]    = 100e-6;
+    Expected.T[ TimePolygonDelay ] = 50e-6;
+    Expected.T[ TimeLaserDelay ]   = 40e-6 + 200e-6;
+
+    TimeEstimator Estimator;
+    const double Estimate = Estimator.Estimate( Job.data(), Job.size() );
+    bool Ok = fabs( Estimate - Expected.Total() ) < 1e-9;
+
+    for ( UINT c = 0; c < TimeClasses; c++ )
+    {
+        if ( fabs( Estimator.Model.Time.T[ c ] - Expected.T[ c ] ) < 1e-9 ) continue;
+
+        printf( "Model: %s %.3f ms, %.3f ms expected\n", TimeClassName( c ),
+                Estimator.Model.Time.T[ c ] * 1e3, Expected.T[ c ] * 1e3 );
+        Ok = false;
+
+    }
+
+    printf( "Model: %.3f ms for the test job, %.3f ms expected%s\n", Estimate * 1e3, Expected.Total() * 1e3,
+            Ok ? "" : ", differs" );
+
+    return Ok;
+
+}
+
+static int BenchTiming( int argc, char* argv[] )
+{
+    const UINT   Parts   = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 10000;
+    const double Latency = ( argc > 3 ? atof( argv[ 3 ] ) : 50.0 ) * 1e-6;
+
+    if ( !CheckTimingModel() ) return 1;
+
+    ListJob Setup, Job, Sub;
+    Setup.push_back( ListMakeD( OpSetJumpSpeed, 5000.0 ) );
+    Setup.push_back( ListMakeD( OpSetMarkSpeed, 1000.0 ) );
+    Setup.push_back( ListMake( OpSetScannerDelays, 25, 10, 5 ) );
+    Setup.push_back( ListMake( OpSetLaserDelays, -40, 300 ) );
+    ListCommand Mode = ListMake( OpSetDelayMode, 1, 0, 3000 );
+    Mode.J[ 0 ] = 5;
+    Mode.J[ 1 ] = 2000;
+    Setup.push_back( Mode );
+
+    for ( UINT i = 0; i < Parts; i++ ) MakeTimingPart( Job, i );
+
+    Job.push_back( ListMake( OpSaveAndRestartTimer ) );
+
+    //  A small square with a diagonal, relative to the position of the call
+    Sub.push_back( ListMake( OpMarkRel,  400,    0 ) );
+    Sub.push_back( ListMake( OpMarkRel,    0,  400 ) );
+    Sub.push_back( ListMake( OpMarkRel, -400,    0 ) );
+    Sub.push_back( ListMake( OpMarkRel,    0, -400 ) );
+    Sub.push_back( ListMake( OpMarkRel,  400,  400 ) );
+    Sub.push_back( ListMake( OpListReturn ) );
+
+    //  Estimate
+    TimeEstimator Estimator;
+    std::vector< TimeSegment > Segments;
+    Estimator.SetSub( 0, Sub.data(), Sub.size() );
+    Estimator.Estimate( Setup.data(), Setup.size() );
+
+    const auto   Wall     = std::chrono::steady_clock::now();
+    const double Estimate = Estimator.Estimate( Job.data(), Job.size(), &Segments );
+    const double Seconds  = std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count();
+
+    printf( "Estimate: %.3f s for %llu commands, %.1f M commands/s, %llu unresolved\n",
+            Estimate, (unsigned long long) Estimator.Commands,
+            Seconds > 0.0 ? Estimator.Commands / Seconds * 1e-6 : 0.0,
+            (unsigned long long) Estimator.Unresolved );
+
+    for ( UINT c = 0; c < TimeClasses; c++ )
+    {
+        printf( "    %-16s %10.3f ms  %5.1f %%\n", TimeClassName( c ), Estimator.Model.Time.T[ c ] * 1e3,
+                Estimate > 0.0 ? Estimator.Model.Time.T[ c ] / Estimate * 100.0 : 0.0 );
+
+    }
+
+    double Min = 0.0, Max = 0.0;
+
+    for ( size_t i = 0; i < Segments.size(); i++ )
+    {
+        const double t = Segments[ i ].Time.Total();
+
+        if ( t <= 0.0 ) continue;
+        if ( Min == 0.0 || t < Min ) Min = t;
+        if ( t > Max ) Max = t;
+
+    }
+
+    printf( "Cycle time per part: %.3f ms .. %.3f ms, %u segments\n", Min * 1e3, Max * 1e3, (UINT) Segments.size() );
+
+    //  Marking time on the emulator, measured by save_and_restart_timer as in Demo6.
+    //  The emulator times its list memory with the same model, this checks
+    //  the replay of the job and the subroutine, not the model.
+    if ( OpenEmulator( Latency ) )
+    {
+        printf( "Emulator could not be initialized\n" );
+        return 1;
+
+    }
+
+    config_list( (UINT) ( Setup.size() + Job.size() + 16 ), 0 );
+    load_sub( 0 );
+    ListReplay( Sub.data(), Sub.size() );
+
+    set_start_list( 1 );
+    ListReplay( Setup.data(), Setup.size() );
+    ListReplay( Job.data(), Job.size() );
+    set_end_of_list();
+
+    if ( get_last_error() )
+    {
+        printf( "Job does not fit into the list memory\n" );
+        return 1;
+
+    }
+
+    //  The card starts with execute_list and ends without further host calls
+    execute_list( 1 );
+    const double Start = RTC5EmuTime();
+    RTC5EmuRunToIdle();
+    const double Marked = RTC5EmuTime() - Start;
+    const double SetupTime = Estimator.Model.Time.Total() - Estimate;
+
+    printf( "Emulator: %.3f s marking, estimate %+.4f %%\n",
+            Marked, Marked > 0.0 ? ( Estimate + SetupTime - Marked ) / Marked * 100.0 : 0.0 );
+
+    RTC5EmuClose();
+    return 0;
+
+}
+
+//  Two threads pausing in simulated time, each lets the other one in
+static void AdvanceShared( double Seconds )
+{
+    RTC5EmuAdvance( Seconds );
+    std::this_thread::yield();
+
+}
+
+//  Streams Setup and Job by a ListFeeder while Capture records the
+//  command (signals 7, 8) and, with four channels, the real position
+//  (signals 1, 2). The job starts at the origin like the estimates.
+//  Estimate receives the marking time of the job, Expected the periods of
+//  its windows. The card samples at the start of a window and then once
+//  per period, and once more at the end when the end falls on a sample.
+static UINT CaptureJob( const ListJob& Setup, const ListJob& Body, UINT Channels, UINT ListSize, const char* Name,
+                        WaveCapture& Capture, ListFeeder& Feeder, double* Estimate, uint64_t* Expected )
+{
+    const UINT Signals[ 4 ] = { 7, 8, 1, 2 };
+    ListJob Job( Setup );
+    Job.push_back( ListMake( OpJumpAbs, 0, 0 ) );
+
+    const size_t First = Job.size();
+
+    Capture.Configure( 1, Channels, Signals );
+    Capture.PollInterval = 1e-4;
+    Capture.Pause        = AdvanceShared;
+    Capture.Timing.Estimate( Job.data(), First, 0, false );
+    Capture.Instrument( Body.data(), Body.size(), Job );
+
+    TimeEstimator Estimator;
+    std::vector< TimeSegment > Windows;     //  split by the set_wait of each window
+    Estimator.Estimate( Job.data(), First, 0, false );
+    *Estimate = Estimator.Estimate( Job.data() + First, Job.size() - First, &Windows );
+    *Expected = 0;
+
+    for ( size_t w = 0; w < Windows.size() && w < Capture.Planned; w++ )
+    {
+        *Expected += (uint64_t) floor( Windows[ w ].Time.Total() / 10e-6 + 0.5 );
+
+    }
+
+    Feeder.Pause        = AdvanceShared;
+    Feeder.PollInterval = 1e-4;
+
+    UINT Error = Capture.Start( Name ) ? FeedCardError : Feeder.Open( ListSize, 2000 );
+
+    if ( !Error ) Error = Feeder.Feed( Job.data(), Job.size() );
+    if ( !Error ) Error = Feeder.Finish();
+
+    const UINT WaveError = Capture.Stop();
+
+    if ( Error || WaveError ) printf( "Feeder error %u, wave error %u\n", Error, WaveError );
+
+    return Error || WaveError;
+
+}
+
+//  The capture thread releases the card from its own waits while the main
+//  thread feeds list 1. Within a recording the position moves by at most
+//  the jump speed times the sample period, a missing window would show
+//  as a larger step.
+static int BenchWave( int argc, char* argv[] )
+{
+    const UINT   Vectors  = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 5000;
+    const double Latency  = ( argc > 3 ? atof( argv[ 3 ] ) : 50.0 ) * 1e-6;
+    const UINT   ListSize = 8000;
+    const char*  Name     = "HostBench.rwv";
+
+    if ( OpenEmulator( Latency ) )
+    {
+        printf( "Emulator could not be initialized\n" );
+        return 1;
+
+    }
+
+    config_list( ListSize, 0 );
+
+    ListJob Setup, Hatch;
+    Setup.push_back( ListMakeD( OpSetJumpSpeed, 5000.0 ) );
+    Setup.push_back( ListMakeD( OpSetMarkSpeed, 2000.0 ) );
+    Setup.push_back( ListMake( OpSetScannerDelays, 25, 10, 5 ) );
+    MakeHatch( Hatch, Vectors );
+
+    for ( UINT Channels = 2; Channels <= 4; Channels += 2 )
+    {
+        WaveCapture Capture;
+        ListFeeder  Feeder;
+        double      Estimate;
+        uint64_t    Expected;
+
+        const auto   Wall = std::chrono::steady_clock::now();
+        const double Sim  = RTC5EmuTime();
+
+        if ( CaptureJob( Setup, Hatch, Channels, ListSize, Name, Capture, Feeder, &Estimate, &Expected ) ) return 1;
+
+        const double Seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count();
+
+        //  Read back
+        WaveFile File;
+
+        if ( File.Open( Name ) )
+        {
+            printf( "%s could not be read\n", Name );
+            return 1;
+
+        }
+
+        const uint64_t Count = File.Header().SampleCount;
+        std::vector< int32_t > X( (size_t) Count ), Y( (size_t) Count );
+        const bool Complete = File.Read( 1, 0, X.size(), X.data() ) == X.size()
+                           && File.Read( 2, 0, Y.size(), Y.data() ) == Y.size();
+        double Step = 0.0;
+
+        for ( size_t i = 1; i < X.size(); i++ )
+        {
+            const double dX = X[ i ] - X[ i - 1 ], dY = Y[ i ] - Y[ i - 1 ];
+            Step = std::max( Step, sqrt( dX * dX + dY * dY ) );
+
+        }
+
+        //  One sample per period and at most one more per window
+        const bool Differs = Count < Expected || Count > Expected + Capture.Planned;
+
+        printf( "%u channels: %llu windows, %llu blocks, %llu samples (%llu to %llu expected), %llu overflows, "
+                "max step %.1f bits (jump %.1f bits)%s%s\n",
+                Channels, (unsigned long long) Capture.Planned, (unsigned long long) Capture.Blocks,
+                (unsigned long long) Count, (unsigned long long) Expected,
+                (unsigned long long) ( Expected + Capture.Planned ), (unsigned long long) Capture.Overflows,
+                Step, 5000.0 * 10e-3, Complete ? "" : ", read error", Differs ? ", count differs" : "" );
+        printf( "    %.1f MB, %.1f ms simulated (%.1f ms marking), %.1f ms wall, %llu feeder waits\n",
+                ( sizeof( WaveFileHeader ) + File.Blocks().size() * ( sizeof( WaveBlockHeader ) + sizeof( WaveIndexEntry ) )
+                  + Count * Channels * sizeof( int32_t ) ) / 1048576.0,
+                ( RTC5EmuTime() - Sim ) * 1e3, Estimate * 1e3, Seconds * 1e3, (unsigned long long) Feeder.Waits );
+
+        if ( Differs || !Complete )
+        {
+            remove( Name );
+            RTC5EmuClose();
+            return 1;
+
+        }
+
+    }
+
+    remove( Name );
+    RTC5EmuClose();
+    return 0;
+
+}
+
+//  The emulator's head follows a galvo model, the wave file holds the
+//  command and the real position
+static int BenchTrack( int argc, char* argv[] )
+{
+    const UINT   Vectors  = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 5000;
+    const double Latency  = ( argc > 3 ? atof( argv[ 3 ] ) : 50.0 ) * 1e-6;
+    const UINT   ListSize = 8000;
+    const char*  Name     = "HostBench.rwv";
+
+    if ( OpenEmulator( Latency ) )
+    {
+        printf( "Emulator could not be initialized\n" );
+        return 1;
+
+    }
+
+    config_list( ListSize, 0 );
+
+    ListJob Setup, Hatch;
+    Setup.push_back( ListMakeD( OpSetJumpSpeed, 5000.0 ) );
+    Setup.push_back( ListMakeD( OpSetMarkSpeed, 2000.0 ) );
+    Setup.push_back( ListMake( OpSetScannerDelays, 25, 10, 5 ) );
+    MakeHatch( Hatch, Vectors );
+
+    GalvoModel Galvo;
+
+    for ( UINT a = 0; a < 2; a++ )
+    {
+        Galvo.Axis[ a ].Frequency = 3000.0;
+        Galvo.Axis[ a ].Damping   = 0.7;
+
+    }
+
+    RTC5EmuSetGalvo( &Galvo );
+
+    WaveCapture Capture;
+    ListFeeder  Feeder;
+    WaveFile    File;
+    double      Estimate;
+    uint64_t    Expected;
+
+    if ( CaptureJob( Setup, Hatch, 4, ListSize, Name, Capture, Feeder, &Estimate, &Expected ) ) return 1;
+
+    if ( File.Open( Name ) )
+    {
+        printf( "%s could not be read\n", Name );
+        return 1;
+
+    }
+
+    for ( UINT Mode = 0; Mode < 2; Mode++ )
+    {
+        TrackAnalyzer Analyzer;
+        Analyzer.Vectorized = Mode == 0;
+        Analyzer.Tolerance  = 5.0;
+
+        const auto Wall = std::chrono::steady_clock::now();
+        const UINT Error = Analyzer.Analyze( File );
+        const double Seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count();
+
+        if ( Error )
+        {
+            printf( "Analysis error %u\n", Error );
+            return 1;
+
+        }
+
+        printf( "%-22s %10llu samples  %8.1f ms  %8.1f M samples/s  %llu segments  max error %.2f bits\n",
+                Mode == 0 ? "wave file, SSE2" : "wave file, scalar",
+                (unsigned long long) Analyzer.Samples, Seconds * 1e3,
+                Seconds > 0.0 ? Analyzer.Samples / Seconds * 1e-6 : 0.0,
+                (unsigned long long) Analyzer.Segments.size(), Analyzer.MaxError );
+
+        if ( Mode ) continue;
+
+        printf( "\nEmulated head, 3 kHz, damping 0.7, scanner delays 250 / 100 / 50 us, tolerance 5 bits:\n" );
+        Analyzer.Print( stdout );
+        printf( "\n" );
+
+    }
+
+    File.Close();
+    remove( Name );
+    RTC5EmuClose();
+    return 0;
+
+}
+
+//  Feeds the hatch in chunks, every chunk followed by Stall seconds the
+//  host spends elsewhere, while a ListMonitor samples list 1
+static int BenchMonitor( int argc, char* argv[] )
+{
+    const UINT   Vectors  = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 20000;
+    const double Latency  = ( argc > 3 ? atof( argv[ 3 ] ) : 50.0 ) * 1e-6;
+    const UINT   ListSize = 1000;
+    const UINT   Chunk    = 500;
+    const char*  Name     = "HostBench.json";
+
+    if ( OpenEmulator( Latency ) )
+    {
+        printf( "Emulator could not be initialized\n" );
+        return 1;
+
+    }
+
+    config_list( ListSize, 0 );
+
+    ListJob Setup, Hatch;
+    Setup.push_back( ListMakeD( OpSetJumpSpeed, 5000.0 ) );
+    Setup.push_back( ListMakeD( OpSetMarkSpeed, 2000.0 ) );
+    Setup.push_back( ListMake( OpSetScannerDelays, 25, 10, 5 ) );
+    MakeHatch( Hatch, Vectors );
+
+    const double Stalls[ 3 ] = { 0.0, 1.0, 3.0 };
+
+    for ( UINT Mode = 0; Mode < 3; Mode++ )
+    {
+        ListMonitor Monitor;
+        ListFeeder  Feeder;
+
+        Monitor.Clock    = RTC5EmuTime;
+        Monitor.Pause    = AdvanceShared;
+        Monitor.Interval = 1e-3;
+        Feeder.Pause        = AdvanceShared;
+        Feeder.PollInterval = 1e-4;
+
+        const double Sim = RTC5EmuTime();
+        UINT Error = Monitor.Start( ListSize, ListSize / 4 ) ? FeedRangeError : Feeder.Open( ListSize, 500 );
+
+        if ( !Error ) Error = Feeder.Feed( Setup.data(), Setup.size() );
+
+        for ( size_t i = 0; i < Hatch.size() && !Error; i += Chunk )
+        {
+            const double Begin = RTC5EmuTime();
+            Error = Feeder.Feed( Hatch.data() + i, std::min< size_t >( Chunk, Hatch.size() - i ) );
+            Monitor.Span( "feed", Begin, RTC5EmuTime() );
+
+            if ( Stalls[ Mode ] > 0.0 )
+            {
+                const double Stall = RTC5EmuTime();
+                while ( RTC5EmuTime() < Stall + Stalls[ Mode ] ) AdvanceShared( 1e-3 );
+                Monitor.Span( "host busy", Stall, RTC5EmuTime() );
+
+            }
+
+            Monitor.Collect();
+
+        }
+
+        if ( !Error ) Error = Feeder.Finish();
+
+        Monitor.Stop();
+
+        if ( Error )
+        {
+            printf( "Feeder error %u\n", Error );
+            return 1;
+
+        }
+
+        printf( "stall %4.0f ms per %u records  %7llu samples  %3llu dropped  %3llu events dropped  %4llu below 1/4  %4llu dry  %4llu waiting  "
+                "min fill %4u  %8.1f ms simulated\n",
+                Stalls[ Mode ] * 1e3, Chunk, (unsigned long long) Monitor.Samples.size(), (unsigned long long) Monitor.Dropped,
+                (unsigned long long) Monitor.DroppedEvents,
+                (unsigned long long) Monitor.LowCount, (unsigned long long) Monitor.DryCount,
+                (unsigned long long) Monitor.WaitCount, Monitor.MinFill, ( RTC5EmuTime() - Sim ) * 1e3 );
+
+        if ( Mode == 2 && Monitor.WriteTrace( Name ) == MonitorNoError ) printf( "Chrome trace: %s\n", Name );
+
+    }
+
+    RTC5EmuClose();
+    return 0;
+
+}
+
+//  Demo7: control_command, ten read_status for 100 us and get_value per
+//  value, here for both axes of both heads
+static void ReadLikeDemo7( int16_t* Data )
+{
+    const UINT Codes[ HeadStatusWord ] = { 0x0500, 0x0512, 0x0514, 0x0515, 0x0516, 0x0517, 0x0518, 0x0519, 0x051A, 0x0522 };
+
+    for ( UINT v = 0; v < HeadStatusWord; v++ )
+    {
+        for ( UINT Channel = 0; Channel < 4; Channel++ ) control_command( Channel / 2 + 1, Channel % 2 + 1, Codes[ v ] );
+        for ( UINT i = 0; i < 10; i++ ) (void) read_status();
+        for ( UINT Channel = 0; Channel < 4; Channel++ ) Data[ 4 * v + Channel ] = (int16_t) ( get_value( Channel + 1 ) >> 4 );
+
+    }
+
+    for ( UINT Channel = 0; Channel < 4; Channel++ ) control_command( Channel / 2 + 1, Channel % 2 + 1, 0x0501 );
+
+}
+
+static int BenchHead( int argc, char* argv[] )
+{
+    const UINT   Vectors  = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 5000;
+    const double Latency  = ( argc > 3 ? atof( argv[ 3 ] ) : 50.0 ) * 1e-6;
+    const UINT   ListSize = 4000;
+    const UINT   Chunk    = 1000;
+
+    if ( OpenEmulator( Latency ) )
+    {
+        printf( "Emulator could not be initialized\n" );
+        return 1;
+
+    }
+
+    config_list( ListSize, 0 );
+
+    //  All values once on the thread driving the card
+    int16_t Data[ 4 * HeadStatusWord ];
+    uint64_t Calls = RTC5EmuHostCalls();
+    double   Sim   = RTC5EmuTime();
+
+    ReadLikeDemo7( Data );
+
+    printf( "Demo7 reads          %4u values  %5llu calls  %8.2f ms of the marking thread\n",
+            4 * HeadStatusWord, (unsigned long long) ( RTC5EmuHostCalls() - Calls ), ( RTC5EmuTime() - Sim ) * 1e3 );
+
+    ListJob Setup, Hatch;
+    Setup.push_back( ListMakeD( OpSetJumpSpeed, 5000.0 ) );
+    Setup.push_back( ListMakeD( OpSetMarkSpeed, 2000.0 ) );
+    Setup.push_back( ListMake( OpSetScannerDelays, 25, 10, 5 ) );
+    MakeHatch( Hatch, Vectors );
+
+    UINT Values[ HeadValues ];
+    for ( UINT v = 0; v < HeadValues; v++ ) Values[ v ] = v;
+
+    for ( UINT Mode = 0; Mode < 2; Mode++ )
+    {
+        HeadTelemetry Telemetry;
+        ListFeeder    Feeder;
+
+        Telemetry.Clock    = RTC5EmuTime;
+        Telemetry.Pause    = AdvanceShared;
+        Telemetry.Interval = 1e-3;
+        Feeder.Pause        = AdvanceShared;
+        Feeder.PollInterval = 1e-4;
+
+        Calls = RTC5EmuHostCalls();
+        Sim   = RTC5EmuTime();
+
+        UINT Error = Mode && Telemetry.Start( HeadA | HeadB, Values, HeadValues ) ? FeedRangeError : Feeder.Open( ListSize, 2000 );
+
+        if ( !Error ) Error = Feeder.Feed( Setup.data(), Setup.size() );
+
+        for ( size_t i = 0; i < Hatch.size() && !Error; i += Chunk )
+        {
+            Error = Feeder.Feed( Hatch.data() + i, std::min< size_t >( Chunk, Hatch.size() - i ) );
+            Telemetry.Collect();
+
+        }
+
+        if ( !Error ) Error = Feeder.Finish();
+
+        Telemetry.Stop();
+
+        if ( Error )
+        {
+            printf( "Feeder error %u\n", Error );
+            return 1;
+
+        }
+
+        const double Time = RTC5EmuTime() - Sim;
+
+        printf( "%-20s %8.1f ms simulated  %8llu calls  %6llu rounds  %5.1f calls/round  %6llu values  %llu dropped\n",
+                Mode ? "feed with telemetry" : "feed", Time * 1e3, (unsigned long long) ( RTC5EmuHostCalls() - Calls ),
+                (unsigned long long) Telemetry.Rounds, Telemetry.Rounds ? (double) Telemetry.Calls / Telemetry.Rounds : 0.0,
+                (unsigned long long) Telemetry.History.size(), (unsigned long long) Telemetry.Dropped );
+
+        if ( !Mode ) continue;
+
+        printf( "every value refreshed each %.1f ms\n", HeadValues * Telemetry.Interval * 1e3 );
+
+        const char* Names[ HeadValues ] = { "status", "status 2", "galvo temperature", "head temperature", "AGC",
+                                            "Vcc DSP", "Vcc DSP IO", "Vcc analog", "Vcc ADC", "firmware", "head status" };
+
+        for ( UINT v = 0; v < HeadValues; v++ )
+        {
+            for ( UINT Axis = v == HeadStatusWord ? 0 : 1; Axis <= ( v == HeadStatusWord ? 0u : 2u ); Axis++ )
+            {
+                int16_t Value;
+                double  At;
+
+                if ( !Telemetry.Latest( 1, Axis, v, &Value, &At ) ) continue;
+
+                const double  Unit = HeadTelemetry::Unit( v );
+                const int16_t Demo = v == HeadStatusWord ? 0 : Data[ 4 * v + Axis - 1 ];
+
+                printf( "  head A %s %-18s", Axis ? ( Axis == 1 ? "X" : "Y" ) : " ", Names[ v ] );
+
+                if ( Unit != 1.0 )                printf( "%8.2f   Demo7 %8.2f", Value * Unit, Demo * Unit );
+                else if ( v != HeadStatusWord )   printf( "  0x%04X   Demo7   0x%04X", (UINT) (uint16_t) Value, (UINT) (uint16_t) Demo );
+                else                              printf( "  0x%04X", (UINT) (uint16_t) Value );
+
+                printf( "%*s   read %5.1f ms before the end\n", v == HeadStatusWord ? 17 : 0, "", ( RTC5EmuTime() - At ) * 1e3 );
+
+            }
+
+        }
+
+    }
+
+    RTC5EmuClose();
+    return 0;
+
+}
+
+//  Squares, stars, a circle and hatch lines: corners, arcs and short jumps
+static void MakeTuningPattern( ListJob& Job, LONG X, LONG Y )
+{
+    const double Pi = 3.14159265358979323846;
+
+    Job.push_back( ListMake( OpJumpAbs, X - 1500, Y - 1500 ) );
+    Job.push_back( ListMake( OpMarkAbs, X + 1500, Y - 1500 ) );
+    Job.push_back( ListMake( OpMarkAbs, X + 1500, Y + 1500 ) );
+    Job.push_back( ListMake( OpMarkAbs, X - 1500, Y + 1500 ) );
+    Job.push_back( ListMake( OpMarkAbs, X - 1500, Y - 1500 ) );
+
+    for ( UINT k = 0; k <= 5; k++ )
+    {
+        const double a = Pi / 2.0 + k * 4.0 * Pi / 5.0;
+        Job.push_back( ListMake( k ? OpMarkAbs : OpJumpAbs, X + 4000 + (LONG) ( 1500.0 * cos( a ) ), Y + (LONG) ( 1500.0 * sin( a ) ) ) );
+
+    }
+
+    Job.push_back( ListMake( OpJumpAbs, X + 1500, Y + 4000 ) );
+    ListCommand Arc = ListMake( OpArcAbs, X, Y + 4000 );
+    Arc.D[ 0 ] = 360.0;
+    Job.push_back( Arc );
+
+    for ( UINT i = 0; i < 20; i++ )
+    {
+        const LONG y = Y - 5500 + 100 * (LONG) i;
+        Job.push_back( ListMake( OpJumpAbs, X + ( i % 2 ? 2000 : -2000 ), y ) );
+        Job.push_back( ListMake( OpMarkAbs, X + ( i % 2 ? -2000 : 2000 ), y ) );
+
+    }
+
+}
+
+static int BenchTune( int argc, char* argv[] )
+{
+    const UINT  Patterns = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 4;
+    const char* Name     = "HostBench.ini";
+
+    ListJob Job;
+
+    for ( UINT i = 0; i < Patterns; i++ ) MakeTuningPattern( Job, -6000 + 12000 * (LONG) ( i % 2 ), -6000 + 12000 * (LONG) ( i / 2 % 2 ) );
+
+    DelayTuner Tuner;
+    Tuner.SetJob( Job.data(), Job.size() );
+    Tuner.MaxError     = 5.0;
+    Tuner.MinJumpSpeed = 2000.0;
+    Tuner.MaxJumpSpeed = 10000.0;
+    Tuner.JumpSpeeds   = 5;
+    Tuner.MinMarkSpeed = 500.0;
+    Tuner.MaxMarkSpeed = 2000.0;
+    Tuner.MarkSpeeds   = 4;
+
+    //  The delays of the demos
+    const TuneParameters Demo = { 2500.0, 1000.0, 25, 10, 5, 100, 100 };
+    TuneResult r;
+    Tuner.Evaluate( Demo, r );
+
+    printf( "%u patterns, %u records, head %.0f Hz, damping %.2f, max error %.1f bits\n", Patterns, (UINT) Job.size(),
+            Tuner.Galvo.Axis[ 0 ].Frequency, Tuner.Galvo.Axis[ 0 ].Damping, Tuner.MaxError );
+    printf( "demo delays: %.3f ms, error %.1f bits (path %.1f, start %.1f, end %.1f)\n\n", r.CycleTime * 1e3, r.Error,
+            r.PathError, r.StartError, r.EndError );
+
+    const UINT Threads = std::max( 4u, std::thread::hardware_concurrency() );
+    double Wall[ 2 ];
+    UINT Error = TuneNoError;
+
+    for ( UINT Mode = 0; Mode < 2; Mode++ )
+    {
+        Tuner.Threads = Mode ? Threads : 1;
+
+        const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        Error = Tuner.Tune();
+        Wall[ Mode ] = std::chrono::duration< double >( std::chrono::steady_clock::now() - t0 ).count();
+
+    }
+
+    Tuner.Print( stdout );
+
+    printf( "\n%llu runs of the job, %.1f ms on one thread, %.1f ms on %u threads\n",
+            (unsigned long long) Tuner.Evaluations, Wall[ 0 ] * 1e3, Wall[ 1 ] * 1e3, Threads );
+    printf( "%u processors\n", std::thread::hardware_concurrency() );
+
+    if ( Error )
+    {
+        printf( "Tuner error %u\n", Error );
+        return 1;
+
+    }
+
+    printf( "best: %.3f ms, %.1f %% of the demo delays, error %.1f bits\n", Tuner.Best.CycleTime * 1e3,
+            100.0 * Tuner.Best.CycleTime / r.CycleTime, Tuner.Best.Error );
+
+    if ( Tuner.WriteProfile( Name ) == TuneNoError ) printf( "Profile: %s\n", Name );
+
+    return 0;
+
+}
+
+//  The kernel alone on a sine sweep, then a hatch job of the given marking
+//  time streamed to the emulator without and with the galvo model
+static int BenchGalvo( int argc, char* argv[] )
+{
+    const double Seconds  = argc > 2 ? atof( argv[ 2 ] ) : 60.0;
+    const double Latency  = ( argc > 3 ? atof( argv[ 3 ] ) : 50.0 ) * 1e-6;
+    const UINT   ListSize = 8000;
+    const size_t Steps    = 1 << 23;
+
+    GalvoModel Galvo;
+
+    for ( UINT a = 0; a < 2; a++ )
+    {
+        Galvo.Axis[ a ].Frequency = 3000.0;
+        Galvo.Axis[ a ].Damping   = 0.7;
+        Galvo.Axis[ a ].Delay     = 2;
+        Galvo.Axis[ a ].MaxError  = 2000.0;
+        Galvo.Axis[ a ].MaxAccel  = 4e9;
+
+    }
+
+    std::vector< double > CmdX( Steps ), CmdY( Steps ), Real[ 2 ][ 2 ];
+
+    for ( size_t i = 0; i < Steps; i++ )
+    {
+        const double t = i * 10e-6;
+        CmdX[ i ] = 20000.0 * sin( 2.0 * 3.14159265358979323846 * ( 10.0 + 0.1 * t ) * t );
+        CmdY[ i ] = 20000.0 * cos( 2.0 * 3.14159265358979323846 * ( 5.0 + 0.2 * t ) * t );
+
+    }
+
+    double Kernel[ 2 ];
+
+    for ( UINT Mode = 0; Mode < 2; Mode++ )
+    {
+        Real[ Mode ][ 0 ].resize( Steps );
+        Real[ Mode ][ 1 ].resize( Steps );
+        Galvo.Vectorized = Mode == 0;
+        Galvo.Configure();
+        Galvo.Reset( CmdX[ 0 ], CmdY[ 0 ] );
+
+        const auto Wall = std::chrono::steady_clock::now();
+        Galvo.Run( CmdX.data(), CmdY.data(), Steps, Real[ Mode ][ 0 ].data(), Real[ Mode ][ 1 ].data() );
+        Kernel[ Mode ] = std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count();
+
+    }
+
+    double Diff = 0.0, Error = 0.0;
+
+    for ( size_t i = 0; i < Steps; i++ )
+    {
+        Diff  = std::max( Diff, fabs( Real[ 0 ][ 0 ][ i ] - Real[ 1 ][ 0 ][ i ] ) + fabs( Real[ 0 ][ 1 ][ i ] - Real[ 1 ][ 1 ][ i ] ) );
+        Error = std::max( Error, hypot( Real[ 0 ][ 0 ][ i ] - CmdX[ i ], Real[ 0 ][ 1 ][ i ] - CmdY[ i ] ) );
+
+    }
+
+    printf( "kernel, %llu periods (%.1f s): SSE2 %.1f ms, %.1f M periods/s; scalar %.1f ms, %.1f M periods/s\n",
+            (unsigned long long) Steps, Steps * 10e-6, Kernel[ 0 ] * 1e3, Steps / Kernel[ 0 ] * 1e-6,
+            Kernel[ 1 ] * 1e3, Steps / Kernel[ 1 ] * 1e-6 );
+    printf( "    max difference %.2g bits, max tracking error %.1f bits\n\n", Diff, Error );
+
+    if ( OpenEmulator( Latency ) )
+    {
+        printf( "Emulator could not be initialized\n" );
+        return 1;
+
+    }
+
+    config_list( ListSize, 0 );
+
+    //  About 2 ms per vector at these speeds
+    ListJob Job;
+    Job.push_back( ListMakeD( OpSetJumpSpeed, 5000.0 ) );
+    Job.push_back( ListMakeD( OpSetMarkSpeed, 2000.0 ) );
+    Job.push_back( ListMake( OpSetScannerDelays, 25, 10, 5 ) );
+    MakeHatch( Job, (UINT) std::max( 1.0, Seconds * 500.0 ) );
+
+    Galvo.Vectorized = true;
+
+    for ( UINT Mode = 0; Mode < 2; Mode++ )
+    {
+        RTC5EmuSetGalvo( Mode ? &Galvo : 0 );
+
+        ListFeeder Feeder;
+        Feeder.Pause = RTC5EmuAdvance;
+
+        const auto   Wall = std::chrono::steady_clock::now();
+        const double Sim  = RTC5EmuTime();
+
+        UINT Error = Feeder.Open( ListSize, 2000 );
+
+        if ( !Error ) Error = Feeder.Feed( Job.data(), Job.size() );
+        if ( !Error ) Error = Feeder.Finish();
+
+        if ( Error )
+        {
+            printf( "Feeder error %u\n", Error );
+            return 1;
+
+        }
+
+        const double Elapsed = std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count();
+        const double Marked  = RTC5EmuTime() - Sim;
+
+        printf( "%-22s %9.1f s simulated  %8.3f s wall  %7.0fx real time  %6.1f s wall per simulated hour\n",
+                Mode ? "galvo model" : "output position", Marked, Elapsed, Marked / Elapsed, 3600.0 * Elapsed / Marked );
+
+    }
+
+    RTC5EmuClose();
+    return 0;
+
+}
+
+//  A part of 16000 bits scaled by s and every second one turned by 90 deg:
+//  the tuning pattern, the logo as subroutine 0, a text and a pixel line
+static void MakePreviewPart( ListJob& Job, UINT Part, LONG X, LONG Y, double s )
+{
+    const double m[ 2 ][ 2 ] = { { Part % 2 ? 0.0 : s, Part % 2 ? -s : 0.0 }, { Part % 2 ? s : 0.0, Part % 2 ? 0.0 : s } };
+
+    for ( UINT i = 0; i < 4; i++ )
+    {
+        ListCommand Cmd = ListMakeD( OpSetMatrix, m[ i / 2 ][ i % 2 ] );
+        Cmd.I[ 0 ] = i / 2 + 1;
+        Cmd.I[ 1 ] = i % 2 + 1;
+        Job.push_back( Cmd );
+
+    }
+
+    Job.push_back( ListMake( OpSetOffset, X, Y ) );
+    MakeTuningPattern( Job, -2000, 0 );
+
+    Job.push_back( ListMake( OpJumpAbs, -2000, 7600 ) );
+    Job.push_back( ListMake( OpSubCallAbs, 0 ) );
+    Job.push_back( ListMake( OpJumpAbs, 1000, 7000 ) );
+    ListAppendText( Job, OpMarkText, "RTC5" );
+
+    ListCommand Line = ListMakeD( OpSetPixelLine, 10.0, 0.0 );
+    Line.I[ 0 ] = 64;
+    Job.push_back( ListMake( OpJumpAbs, -6000, -7000 ) );
+    Job.push_back( Line );
+    Job.push_back( ListMake( OpSetNPixel, 32 * ( Part % 8 + 1 ), 0, 200 ) );
+
+}
+
+//  Preview of an array of parts, one thread scalar and SSE2, then all
+static int BenchPreview( int argc, char* argv[] )
+{
+    const UINT Parts = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 70000;
+    const UINT Size  = argc > 3 ? (UINT) atoi( argv[ 3 ] ) : 4096;
+    const UINT Grid  = (UINT) ceil( sqrt( (double) Parts ) );
+
+    ListJob Job, Logo, Chars[ 128 ];
+
+    Job.push_back( ListMakeD( OpSetJumpSpeed, 5000.0 ) );
+    Job.push_back( ListMakeD( OpSetMarkSpeed, 1000.0 ) );
+    Job.push_back( ListMake( OpSetScannerDelays, 25, 10, 5 ) );
+
+    for ( UINT i = 0; i < Parts; i++ )
+    {
+        const LONG Pitch = 900000 / (LONG) Grid;
+        MakePreviewPart( Job, i, -450000 + Pitch / 2 + Pitch * (LONG) ( i % Grid ), 450000 - Pitch / 2 - Pitch * (LONG) ( i / Grid ),
+                         0.8 * Pitch / 16000.0 );
+
+    }
+
+    AppendLogo( Logo, 0, 0 );
+
+    //  The box font of the emulator
+    for ( UINT c = 33; c < 128; c++ )
+    {
+        Chars[ c ].push_back( ListMake( OpMarkRel, CharWidth, 0 ) );
+        Chars[ c ].push_back( ListMake( OpMarkRel, 0, CharHeight ) );
+        Chars[ c ].push_back( ListMake( OpMarkRel, -(LONG) CharWidth, 0 ) );
+        Chars[ c ].push_back( ListMake( OpMarkRel, 0, -(LONG) CharHeight ) );
+        Chars[ c ].push_back( ListMake( OpJumpRel, CharAdvance, 0 ) );
+
+    }
+
+    size_t Vectors = 0;
+
+    for ( size_t i = 0; i < Job.size(); i++ )
+    {
+        const UINT Op = Job[ i ].Op;
+        if ( Op == OpJumpAbs || Op == OpMarkAbs || Op == OpArcAbs ) Vectors++;
+        if ( Op == OpSubCallAbs ) Vectors += Logo.size();
+        if ( Op == OpMarkText ) Vectors += 5 * Job[ i ].Arg;
+
+    }
+
+    printf( "%u parts, %llu records, %.1f M vectors, %u x %u pixels, %u processors\n", Parts,
+            (unsigned long long) Job.size(), Vectors * 1e-6, Size, Size, std::thread::hardware_concurrency() );
+
+    std::vector< uint8_t > First;
+    const UINT Threads = std::max( 4u, std::thread::hardware_concurrency() );
+
+    for ( UINT Mode = 0; Mode < 3; Mode++ )
+    {
+        PreviewRenderer Preview;
+        Preview.Width      = Preview.Height = Size;
+        Preview.Vectorized = Mode > 0;
+        Preview.Threads    = Mode < 2 ? 1 : Threads;
+        Preview.SetSub( 0, Logo.data(), Logo.size() );
+
+        for ( UINT c = 33; c < 128; c++ ) Preview.SetChar( 0, c, Chars[ c ].data(), Chars[ c ].size() );
+
+        const auto Wall = std::chrono::steady_clock::now();
+        const UINT Error = Preview.Render( Job.data(), Job.size() );
+        const double Seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count();
+
+        if ( Error )
+        {
+            printf( "Preview error %u\n", Error );
+            return 1;
+
+        }
+
+        if ( Mode == 0 ) First = Preview.Image;
+
+        char Name[ 32 ];
+        sprintf( Name, Mode == 0 ? "scalar, 1 thread" : "SSE2, %u thread%s", Preview.Threads, Preview.Threads > 1 ? "s" : "" );
+
+        printf( "%-22s %8.1f ms  walk %7.1f  bin %7.1f  draw %7.1f ms  %6.1f M vectors/s  %.1f M strokes  %.1f M pixels%s\n",
+                Name, Seconds * 1e3, Preview.WalkTime * 1e3, Preview.BinTime * 1e3, Preview.DrawTime * 1e3,
+                Vectors / Seconds * 1e-6, Preview.Strokes * 1e-6, Preview.Pixels * 1e-6,
+                Preview.Image == First ? "" : ", image differs" );
+
+        if ( Mode < 2 ) continue;
+
+        printf( "%.1f bits per pixel, hottest pixel %.1f us, %llu unresolved\n", Preview.Scale, Preview.MaxDwell * 1e6,
+                (unsigned long long) Preview.Unresolved );
+
+        if (   Preview.WritePgm( "HostBench.pgm" ) || Preview.WritePng( "HostBench.png" )
+            || Preview.WritePng( "HostBenchHeat.png", true )
+           )
+        {
+            printf( "Preview not written\n" );
+            return 1;
+
+        }
+
+        printf( "Preview: HostBench.pgm, HostBench.png, dwell: HostBenchHeat.png\n" );
+
+    }
+
+    return 0;
+
+}
+
+//  Table of the variable polygon delay for the default head, a job of test
+//  patterns and logos run by the emulator with the longest delay at every
+//  corner and with the table loaded
+static int BenchPoly( int argc, char* argv[] )
+{
+    const UINT  Patterns = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 20;
+    const char* Name     = "HostBenchPoly.ini";
+
+    PolyDelayTable Table;
+    Table.MarkSpeed = 1000.0;
+    Table.MaxError  = 5.0;
+
+    const auto Wall = std::chrono::steady_clock::now();
+    UINT Error = Table.Compute();
+    const double Seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count();
+
+    printf( "head %.0f Hz, damping %.2f, %.0f bits/ms, max error %.1f bits, %.1f ms\n\n", Table.Galvo.Axis[ 0 ].Frequency,
+            Table.Galvo.Axis[ 0 ].Damping, Table.MarkSpeed, Table.MaxError, Seconds * 1e3 );
+    Table.Print( stdout );
+
+    if ( Error || OpenEmulator( 50e-6 ) )
+    {
+        printf( "Table error %u or emulator could not be initialized\n", Error );
+        return 1;
+
+    }
+
+    ListJob Job;
+    Job.push_back( ListMakeD( OpSetJumpSpeed, 5000.0 ) );
+    Job.push_back( ListMakeD( OpSetMarkSpeed, Table.MarkSpeed ) );
+    Job.push_back( ListMake( OpSetScannerDelays, 25, 10, Table.PolygonDelay ) );
+    Job.push_back( ListMake( OpSetDelayMode, 0 ) );
+
+    for ( UINT i = 0; i < Patterns; i++ )
+    {
+        const LONG X = -20000 + 12000 * (LONG) ( i % 4 ), Y = -20000 + 12000 * (LONG) ( i / 4 % 4 );
+        MakeTuningPattern( Job, X, Y );
+        AppendLogo( Job, X + 4000, Y - 4000 );
+
+    }
+
+    //  Back to the start for the next run
+    Job.push_back( ListMake( OpJumpAbs, 0, 0 ) );
+
+    double Run[ 2 ], Estimate[ 2 ];
+
+    for ( UINT Mode = 0; Mode < 2; Mode++ )
+    {
+        if ( Mode )
+        {
+            Error = Table.Load( Name );
+            Job[ 3 ].I[ 0 ] = 1;
+
+        }
+
+        LoadAndRun( Job, &Run[ Mode ] );
+
+        TimeEstimator Estimator;
+
+        if ( Mode )
+        {
+            std::vector< double > Angle, Scale;
+            PolyReadTable( Name, 0, Angle, Scale );
+            Estimator.Model.SetVarPolyTable( Angle.data(), Scale.data(), (UINT) Angle.size() );
+
+        }
+
+        Estimate[ Mode ] = Estimator.Estimate( Job.data(), Job.size() );
+
+    }
+
+    RTC5EmuClose();
+
+    if ( Error )
+    {
+        printf( "Table not loaded\n" );
+        return 1;
+
+    }
+
+    printf( "\n%u patterns, %u records\n", Patterns, (UINT) Job.size() );
+    printf( "PolygonDelay %u us at every corner: %8.3f ms, estimated %8.3f ms\n", Table.PolygonDelay * 10,
+            Run[ 0 ] * 1e3, Estimate[ 0 ] * 1e3 );
+    printf( "table %-22s         %8.3f ms, estimated %8.3f ms, %.1f %% shorter\n", Name, Run[ 1 ] * 1e3,
+            Estimate[ 1 ] * 1e3, 100.0 * ( 1.0 - Run[ 1 ] / Run[ 0 ] ) );
+
+    return 0;
+
+}
+
+//  Parts of squares, stars, circles, hatch lines, a D and a logo at two mark
+//  speeds, planned for several corner errors
+static int BenchSky( int argc, char* argv[] )
+{
+    const UINT Parts = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 1000;
+
+    ListJob Job, Logo, Planned;
+    ListCommand Mode = ListMake( OpSetDelayMode, 1 );
+
+    Job.push_back( ListMakeD( OpSetJumpSpeed, 5000.0 ) );
+    Job.push_back( ListMake( OpSetScannerDelays, 25, 10, 60 ) );
+    Job.push_back( ListMake( OpSetLaserDelays, 100, 100 ) );
+    Job.push_back( Mode );
+
+    for ( UINT i = 0; i < Parts; i++ )
+    {
+        const LONG X = -400000 + 16000 * (LONG) ( i % 50 ), Y = -400000 + 16000 * (LONG) ( i / 50 % 50 );
+
+        Job.push_back( ListMakeD( OpSetMarkSpeed, i % 2 ? 2000.0 : 500.0 ) );
+        MakeTuningPattern( Job, X, Y );
+        AppendLogo( Job, X + 4000, Y - 4000 );
+
+        //  A D of chords: shallow corners and two right angles
+        for ( UINT k = 0; k <= 32; k++ )
+        {
+            const double a = 3.14159265358979 * ( k / 32.0 - 0.5 );
+            Job.push_back( ListMake( k ? OpMarkAbs : OpJumpAbs, X - 4000 + (LONG) ( 1500.0 * cos( a ) ), Y + 4000 + (LONG) ( 1500.0 * sin( a ) ) ) );
+
+        }
+
+        Job.push_back( ListMake( OpMarkAbs, X - 4000, Y + 2500 ) );
+        Job.push_back( ListMake( OpJumpAbs, X + 4000, Y + 4000 ) );
+        Job.push_back( ListMake( OpSubCallAbs, 0 ) );
+
+    }
+
+    AppendLogo( Logo, 0, 0 );
+    Logo.push_back( ListMake( OpListReturn ) );
+
+    printf( "%u parts, %llu records, polygon delay 600 us at 180 deg, mark speed 500 and 2000 bits/ms\n\n", Parts,
+            (unsigned long long) Job.size() );
+    printf( "max error [bits]  skied corners  cycle time [ms]  planned [ms]  delta [%%]   plan [ms]  M records/s\n" );
+
+    const double Errors[] = { 1e9, 12.0, 5.0, 1.0 };
+    SkyPlanner Planner;
+    Planner.SetSub( 0, Logo.data(), Logo.size() );
+
+    for ( UINT e = 0; e < sizeof( Errors ) / sizeof( Errors[ 0 ] ); e++ )
+    {
+        Planner.MaxError = Errors[ e ];
+
+        const auto Wall = std::chrono::steady_clock::now();
+        const UINT Error = Planner.Plan( Job.data(), Job.size(), Planned );
+        const double Seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count();
+
+        if ( Error )
+        {
+            printf( "Planner error %u\n", Error );
+            return 1;
+
+        }
+
+        printf( "%16.0f  %8llu/%-6u  %15.3f  %12.3f  %8.2f  %10.1f  %11.2f\n", Errors[ e ],
+                (unsigned long long) Planner.Skied, (UINT) Planner.Corners.size(), Planner.Before * 1e3,
+                Planner.After * 1e3, 100.0 * ( Planner.After - Planner.Before ) / Planner.Before, Seconds * 1e3,
+                Job.size() / Seconds * 1e-6 );
+
+    }
+
+    Planner.MaxError = 12.0;
+    Planner.Plan( Job.data(), Job.size(), Planned );
+
+    printf( "\nTimeLag %.0f us, max error %.1f bits:\n", Planner.TimeLag, Planner.MaxError );
+    Planner.Print( stdout );
+
+    return 0;
+
+}
+
+//  A ring, a star or a comb at X, Y as polylines, as an import gives them
+static void MakeHatchShape( ListJob& Job, UINT Shape, LONG X, LONG Y )
+{
+    const double Pi = 3.14159265358979;
+
+    if ( Shape % 3 == 0 )
+    {
+        for ( UINT c = 0; c < 2; c++ )
+        {
+            const double R = c ? 1000.0 : 2000.0;
+
+            for ( UINT i = 0; i <= 96; i++ )
+            {
+                const double a = 2.0 * Pi * i / 96;
+                Job.push_back( ListMake( i ? OpMarkAbs : OpJumpAbs, X + (LONG) ( R * cos( a ) ), Y + (LONG) ( R * sin( a ) ) ) );
+
+            }
+
+        }
+
+    }
+    else if ( Shape % 3 == 1 )
+    {
+        for ( UINT i = 0; i <= 20; i++ )
+        {
+            const double a = 2.0 * Pi * i / 20 + Pi / 2, R = i % 2 ? 900.0 : 2000.0;
+            Job.push_back( ListMake( i ? OpMarkAbs : OpJumpAbs, X + (LONG) ( R * cos( a ) ), Y + (LONG) ( R * sin( a ) ) ) );
+
+        }
+
+    }
+    else
+    {
+        //  Five teeth open to the top
+        Job.push_back( ListMake( OpJumpAbs, X - 2000, Y - 2000 ) );
+        Job.push_back( ListMake( OpMarkAbs, X + 2000, Y - 2000 ) );
+
+        for ( LONG k = 4; k >= 0; k-- )
+        {
+            Job.push_back( ListMake( OpMarkAbs, X - 2000 + k * 900 + 400, Y + 2000 ) );
+            Job.push_back( ListMake( OpMarkAbs, X - 2000 + k * 900, Y + 2000 ) );
+            if ( k ) Job.push_back( ListMake( OpMarkAbs, X - 2000 + k * 900, Y - 1000 ) );
+
+        }
+
+        Job.push_back( ListMake( OpMarkAbs, X - 2000, Y - 2000 ) );
+
+    }
+
+}
+
+//  Rings, stars and combs hatched by one thread against all, scalar against
+//  SSE2, the orderings by their marking time, and the hatch streamed into
+//  the emulator while it is computed
+static int BenchHatch( int argc, char* argv[] )
+{
+    const UINT Shapes = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 2000;
+    const UINT Grid   = (UINT) ceil( sqrt( (double) Shapes ) );
+
+    ListJob Import, Setup;
+
+    for ( UINT i = 0; i < Shapes; i++ )
+    {
+        MakeHatchShape( Import, i, -450000 + 4500 + 9000 * (LONG) ( i % Grid ), -450000 + 4500 + 9000 * (LONG) ( i / Grid ) );
+
+    }
+
+    Setup.push_back( ListMakeD( OpSetJumpSpeed, 5000.0 ) );
+    Setup.push_back( ListMakeD( OpSetMarkSpeed, 2000.0 ) );
+    Setup.push_back( ListMake( OpSetScannerDelays, 25, 10, 5 ) );
+
+    HatchEngine Engine;
+    Engine.AddJob( Import.data(), Import.size() );
+    Engine.Pitch      = 50.0;
+    Engine.Angles[ 0 ] = 45.0;
+    Engine.CrossHatch = true;
+
+    printf( "%u shapes, %u regions, pitch %.0f bits, 45 deg cross-hatched, %u processors\n\n", Shapes,
+            (UINT) Engine.Regions.size(), Engine.Pitch, std::thread::hardware_concurrency() );
+
+    ListJob First;
+    const UINT Threads = std::max( 4u, std::thread::hardware_concurrency() );
+
+    for ( UINT Mode = 0; Mode < 3; Mode++ )
+    {
+        ListJob Out;
+        Engine.Vectorized = Mode > 0;
+        Engine.Threads    = Mode < 2 ? 1 : Threads;
+
+        const UINT Error = Engine.Hatch( Out );
+
+        if ( Error )
+        {
+            printf( "Hatch error %u\n", Error );
+            return 1;
+
+        }
+
+        if ( Mode == 0 ) First.swap( Out );
+
+        char Name[ 32 ];
+        sprintf( Name, Mode == 0 ? "scalar, 1 thread" : "SSE2, %u thread%s", Engine.Threads, Engine.Threads > 1 ? "s" : "" );
+
+        printf( "%-22s %8.1f ms  %6.1f M edges/s  %6.2f M lines/s  %.2f M records%s\n", Name, Engine.WriteTime * 1e3,
+                Engine.Edges / Engine.HatchTime * 1e-6, Engine.Lines / Engine.HatchTime * 1e-6, Engine.Records * 1e-6,
+                Mode == 0 || ( Out.size() == First.size() && !memcmp( Out.data(), First.data(), Out.size() * sizeof( ListCommand ) ) )
+                ? "" : ", output differs" );
+
+    }
+
+    //  Ordering against the marking time
+    printf( "\nordering               lines     jumps     links    marking time [s]\n" );
+
+    for ( UINT Mode = 0; Mode < 3; Mode++ )
+    {
+        ListJob Out( Setup );
+        Engine.Threads      = 0;
+        Engine.Vectorized   = true;
+        Engine.Serpentine   = Mode > 0;
+        Engine.LinkDistance = Mode > 1 ? 3.0 * Engine.Pitch : 0.0;
+        Engine.Hatch( Out );
+
+        TimeEstimator Estimator;
+        const double Time = Estimator.Estimate( Out.data(), Out.size() );
+
+        printf( "%-18s %9llu %9llu %9llu %16.3f\n", Mode == 0 ? "line by line" : Mode == 1 ? "serpentine" : "serpentine, linked",
+                (unsigned long long) Engine.Lines, (unsigned long long) Engine.Jumps, (unsigned long long) Engine.Links, Time );
+
+    }
+
+    //  Hatched while list 1 marks
+    const UINT ListSize = 8000;
+
+    if ( OpenEmulator( 50e-6 ) )
+    {
+        printf( "Emulator could not be initialized\n" );
+        return 1;
+
+    }
+
+    config_list( ListSize, 0 );
+    printf( "\n" );
+
+    for ( UINT Mode = 0; Mode < 2; Mode++ )
+    {
+        ListFeeder Feeder;
+        ListJob    Out( Setup );
+
+        const auto   Wall = std::chrono::steady_clock::now();
+        const double Sim  = RTC5EmuTime();
+
+        if ( Mode == 0 ) Engine.Hatch( Out );
+
+        const double Prepare = std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count();
+
+        Feeder.Pause = RTC5EmuAdvance;
+
+        UINT Error = Feeder.Open( ListSize, 2000 );
+
+        if ( !Error ) Error = Mode == 0 ? Feeder.Feed( Out.data(), Out.size() ) : Feeder.Feed( Setup.data(), Setup.size() );
+        if ( !Error && Mode == 1 ) Error = Engine.Hatch( Feeder ) ? Engine.FeedError : FeedNoError;
+        if ( !Error ) Error = Feeder.Finish();
+
+        if ( Error )
+        {
+            printf( "Feeder error %u\n", Error );
+            return 1;
+
+        }
+
+        ReportFeed( Mode == 0 ? "hatched, then fed" : "fed while hatched",
+                    Mode == 0 ? Prepare : Engine.HatchTime,
+                    std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count(),
+                    RTC5EmuTime() - Sim, Feeder );
+
+    }
+
+    RTC5EmuClose();
+    return 0;
+
+}
+
+//  Pairs of shapes overlapping by half their size united and subtracted,
+//  the union offset inwards by the beam radius and outwards by the kerf, by
+//  one thread against all, then hatched within the border
+static int BenchContour( int argc, char* argv[] )
+{
+    const UINT Shapes = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 2000;
+    const UINT Grid   = (UINT) ceil( sqrt( (double) Shapes ) );
+
+    HatchEngine Left, Right;
+
+    for ( UINT i = 0; i < Shapes; i++ )
+    {
+        const LONG X = -450000 + 4500 + 9000 * (LONG) ( i % Grid ), Y = -450000 + 4500 + 9000 * (LONG) ( i / Grid );
+        ListJob a, b;
+
+        MakeHatchShape( a, i, X - 1000, Y );
+        MakeHatchShape( b, i + 1, X + 1000, Y + 500 );
+        Left.AddJob( a.data(), a.size() );
+        Right.AddJob( b.data(), b.size() );
+
+    }
+
+    std::vector< HatchRegion > Both( Left.Regions );
+    Both.insert( Both.end(), Right.Regions.begin(), Right.Regions.end() );
+
+    const double Beam = 25.0, Kerf = 40.0;
+
+    printf( "%u pairs, beam radius %.0f bits, kerf %.0f bits, %u processors\n\n", Shapes, Beam, Kerf,
+            std::thread::hardware_concurrency() );
+    printf( "operation              threads  time [ms]   edges    splits  unresolved  contours  M edges/s\n" );
+
+    ContourEngine Engine;
+    std::vector< HatchRegion > United, Border;
+    const UINT Threads = std::max( 4u, std::thread::hardware_concurrency() );
+
+    for ( UINT Mode = 0; Mode < 2; Mode++ )
+    {
+        Engine.Threads = Mode ? Threads : 1;
+
+        for ( UINT Op = 0; Op < 4; Op++ )
+        {
+            std::vector< HatchRegion > Out;
+            UINT Error;
+
+            if ( Op == 0 )      Error = Engine.Union( Both, United );
+            else if ( Op == 1 ) Error = Engine.Difference( Left.Regions, Right.Regions, Out );
+            else if ( Op == 2 ) Error = Engine.Offset( United, -Beam, Border );
+            else                Error = Engine.Offset( United, Kerf, Out );
+
+            if ( Error && Error != ContourUnresolved )
+            {
+                printf( "Contour error %u\n", Error );
+                return 1;
+
+            }
+
+            printf( "%-22s %7u %10.1f %9llu %9llu %11llu %9llu %10.2f\n",
+                    Op == 0 ? "union" : Op == 1 ? "difference" : Op == 2 ? "offset -beam radius" : "offset +kerf",
+                    Engine.Threads, Engine.Time * 1e3, (unsigned long long) Engine.Edges, (unsigned long long) Engine.Splits,
+                    (unsigned long long) Engine.Unresolved, (unsigned long long) Engine.Contours, Engine.Edges / Engine.Time * 1e-6 );
+
+        }
+
+    }
+
+    //  The border hatched, its contours marked by the HatchEngine
+    HatchEngine Hatch;
+    Hatch.Regions      = Border;
+    Hatch.Pitch        = 50.0;
+    Hatch.Angles[ 0 ]  = 45.0;
+    Hatch.LinkDistance = 150.0;
+
+    ListJob Out;
+    Hatch.Hatch( Out );
+
+    ListJob Marks;
+    ContourMarks( United, Marks );
+
+    printf( "\n%u regions united into %u, hatched within the border: %llu lines, %.2f M records, %.1f ms\n",
+            (UINT) Both.size(), (UINT) United.size(), (unsigned long long) Hatch.Lines, Hatch.Records * 1e-6,
+            Hatch.WriteTime * 1e3 );
+    printf( "outline of the union:  %u records\n", (UINT) Marks.size() );
+
+    return 0;
+
+}
+
+//  A binary STL of Parts tori standing on a grid of 12 mm, their axes
+//  alternating between x and y, 96 x 48 quads each
+static bool WriteTori( const char* Name, UINT Parts )
+{
+    const double Pi = 3.14159265358979;
+    const UINT   Nu = 96, Nv = 48, Grid = (UINT) ceil( sqrt( (double) Parts ) );
+    const double R = 4.0, r = 1.5;
+
+    FILE* f = fopen( Name, "wb" );
+    if ( !f ) return false;
+
+    char Header[ 80 ];
+    memset( Header, 0, sizeof( Header ) );
+    strcpy( Header, "HostBench tori" );
+
+    const uint32_t Count = Parts * Nu * Nv * 2;
+    bool Ok = fwrite( Header, sizeof( Header ), 1, f ) == 1 && fwrite( &Count, sizeof( Count ), 1, f ) == 1;
+
+    std::vector< float > p( Nu * Nv * 3 );
+    std::vector< char >  Buffer( Nu * Nv * 2 * 50, 0 );
+
+    for ( UINT k = 0; k < Parts && Ok; k++ )
+    {
+        const double cx = 12.0 * ( k % Grid ), cy = 12.0 * ( k / Grid ), cz = R + r;
+
+        for ( UINT i = 0; i < Nu; i++ )
+        {
+            for ( UINT j = 0; j < Nv; j++ )
+            {
+                const double u = 2.0 * Pi * i / Nu, v = 2.0 * Pi * j / Nv;
+                const double lx = ( R + r * cos( v ) ) * cos( u ), ly = ( R + r * cos( v ) ) * sin( u ), lz = r * sin( v );
+                float* q = &p[ 3 * ( i * Nv + j ) ];
+
+                //  Rotated to stand, axis along y or x
+                q[ 0 ] = (float) ( cx + ( k % 2 ? lz : lx ) );
+                q[ 1 ] = (float) ( cy + ( k % 2 ? lx : -lz ) );
+                q[ 2 ] = (float) ( cz + ly );
+
+            }
+
+        }
+
+        char* t = Buffer.data();
+
+        for ( UINT i = 0; i < Nu; i++ )
+        {
+            for ( UINT j = 0; j < Nv; j++ )
+            {
+                const UINT a = i * Nv + j, b = ( ( i + 1 ) % Nu ) * Nv + j;
+                const UINT c = ( ( i + 1 ) % Nu ) * Nv + ( j + 1 ) % Nv, d = i * Nv + ( j + 1 ) % Nv;
+                const UINT Tri[ 2 ][ 3 ] = { { a, b, c }, { a, c, d } };
+
+                for ( UINT h = 0; h < 2; h++, t += 50 )
+                {
+                    for ( UINT m = 0; m < 3; m++ ) memcpy( t + 12 + 12 * m, &p[ 3 * Tri[ h ][ m ] ], 12 );
+
+                }
+
+            }
+
+        }
+
+        Ok = fwrite( Buffer.data(), Buffer.size(), 1, f ) == 1;
+
+    }
+
+    return fclose( f ) == 0 && Ok;
+
+}
+
+//  Time to the first layer and layers per second, then the layers marked
+//  by the emulator, fed after and while they are sliced
+static int BenchSlice( int argc, char* argv[] )
+{
+    const UINT  Parts = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 64;
+    const char* Name  = "HostBench.stl";
+
+    if ( !WriteTori( Name, std::max( Parts, 1u ) ) )
+    {
+        printf( "STL file %s could not be written\n", Name );
+        return 1;
+
+    }
+
+    SliceEngine Engine;
+
+    auto t0 = std::chrono::steady_clock::now();
+    const UINT Error = Engine.Open( Name );
+    const double OpenTime = std::chrono::duration< double >( std::chrono::steady_clock::now() - t0 ).count();
+
+    if ( Error )
+    {
+        printf( "STL file %s: Error %u detected\n", Name, Error );
+        remove( Name );
+        return 1;
+
+    }
+
+    Engine.Scale        = 1000.0;
+    Engine.OffsetX      = -0.5 * ( Engine.Min[ 0 ] + Engine.Max[ 0 ] ) * Engine.Scale;
+    Engine.OffsetY      = -0.5 * ( Engine.Min[ 1 ] + Engine.Max[ 1 ] ) * Engine.Scale;
+    Engine.LayerHeight  = 0.05;
+    Engine.Pitch        = 100.0;
+    Engine.LinkDistance = 300.0;
+
+    printf( "%u tori, %.2f M triangles, %.1f x %.1f x %.1f mm, layers of %.2f mm, mapped in %.1f ms, %u processors\n\n",
+            Parts, Engine.Triangles * 1e-6, Engine.Max[ 0 ] - Engine.Min[ 0 ], Engine.Max[ 1 ] - Engine.Min[ 1 ],
+            Engine.Max[ 2 ] - Engine.Min[ 2 ], Engine.LayerHeight, OpenTime * 1e3, std::thread::hardware_concurrency() );
+    printf( "mode                      index [ms]  first layer [ms]  total [ms]  layers/s  contours  open   M records\n" );
+
+    const UINT Threads = std::max( 4u, std::thread::hardware_concurrency() );
+
+    for ( UINT Mode = 0; Mode < 4; Mode++ )
+    {
+        ListJob Out;
+        Engine.Fill    = Mode > 1;
+        Engine.Threads = Mode % 2 ? Threads : 1;
+
+        if ( Engine.Slice( Out ) )
+        {
+            printf( "Slice error\n" );
+            remove( Name );
+            return 1;
+
+        }
+
+        char Mode_[ 40 ];
+        sprintf( Mode_, "%s, %u thread%s", Engine.Fill ? "hatch" : "contours", Engine.Threads, Engine.Threads > 1 ? "s" : "" );
+
+        printf( "%-24s %11.1f %17.1f %11.1f %9.0f %9llu %5llu %11.2f\n", Mode_, Engine.IndexTime * 1e3,
+                Engine.FirstLayerTime * 1e3, Engine.WriteTime * 1e3, Engine.Layers / Engine.WriteTime,
+                (unsigned long long) Engine.Contours, (unsigned long long) Engine.OpenChains, Engine.Records * 1e-6 );
+
+    }
+
+    //  3D layers at the focus of each, sliced while list 1 marks
+    const UINT ListSize = 8000;
+
+    if ( OpenEmulator( 50e-6 ) )
+    {
+        printf( "Emulator could not be initialized\n" );
+        remove( Name );
+        return 1;
+
+    }
+
+    config_list( ListSize, 0 );
+    printf( "\n" );
+
+    Engine.Fill    = true;
+    Engine.Threads = 0;
+    Engine.ZStep   = 50;
+
+    for ( UINT Mode = 0; Mode < 2; Mode++ )
+    {
+        ListFeeder Feeder;
+        ListJob    Out;
+
+        const auto   Wall = std::chrono::steady_clock::now();
+        const double Sim  = RTC5EmuTime();
+
+        if ( Mode == 0 ) Engine.Slice( Out );
+
+        const double Prepare = std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count();
+
+        Feeder.Pause = RTC5EmuAdvance;
+
+        UINT Error = Feeder.Open( ListSize, 2000 );
+
+        if ( !Error && Mode == 0 ) Error = Feeder.Feed( Out.data(), Out.size() );
+        if ( !Error && Mode == 1 ) Error = Engine.Slice( Feeder ) ? Engine.FeedError : FeedNoError;
+        if ( !Error ) Error = Feeder.Finish();
+
+        if ( Error )
+        {
+            printf( "Feeder error %u\n", Error );
+            remove( Name );
+            return 1;
+
+        }
+
+        ReportFeed( Mode == 0 ? "sliced, then fed" : "fed while sliced", Mode == 0 ? Prepare : Engine.FirstLayerTime,
+                    std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count(),
+                    RTC5EmuTime() - Sim, Feeder );
+
+    }
+
+    RTC5EmuClose();
+    Engine.Close();
+    remove( Name );
+    return 0;
+
+}
+
+//  Polylines of ten marks from random starts within Reach times the field,
+//  every 50th a half circle, every 200th a jump to the park position
+static void MakeClipJob( ListJob& Job, UINT Vectors, double Reach )
+{
+    std::mt19937 Random( 5 );
+    std::uniform_real_distribution< double > Start( -Reach * 524287.0, Reach * 524287.0 ), Step( -20000.0, 20000.0 );
+
+    for ( UINT i = 0; i < Vectors; i++ )
+    {
+        if ( i % 200 == 199 )     Job.push_back( ListMake( OpJumpAbs, 600000, 600000 ) );
+        else if ( i % 10 == 0 )   Job.push_back( ListMake( OpJumpAbs, (LONG) Start( Random ), (LONG) Start( Random ) ) );
+        else if ( i % 50 == 25 )
+        {
+            ListCommand Arc = ListMake( OpArcRel, (LONG) Step( Random ), (LONG) Step( Random ) );
+            Arc.D[ 0 ] = 180.0;
+            Job.push_back( Arc );
+
+        }
+        else Job.push_back( ListMake( OpMarkRel, (LONG) Step( Random ), (LONG) Step( Random ) ) );
+
+        if ( i % 10 == 5 ) Job.push_back( ListMake( OpMarkAbs, (LONG) Start( Random ), (LONG) Start( Random ) ) );
+
+    }
+
+}
+
+//  Absolute positions of the clipped stream beyond the field, relative
+//  vectors followed from the last absolute one
+static UINT BeyondField( const ListJob& Job, const FieldClipper& Clipper )
+{
+    UINT   Beyond = 0;
+    double X = 0.0, Y = 0.0;
+
+    for ( size_t i = 0; i < Job.size(); i++ )
+    {
+        const ListCommand& c = Job[ i ];
+
+        if ( c.Op == OpJumpAbs || c.Op == OpMarkAbs )      { X = c.I[ 0 ]; Y = c.I[ 1 ]; }
+        else if ( c.Op == OpJumpRel || c.Op == OpMarkRel ) { X += c.I[ 0 ]; Y += c.I[ 1 ]; }
+        else continue;
+
+        if ( X < Clipper.Field[ 0 ] || X > Clipper.Field[ 2 ] || Y < Clipper.Field[ 1 ] || Y > Clipper.Field[ 3 ] ) Beyond++;
+
+    }
+
+    return Beyond;
+
+}
+
+//  Streams within the field, beyond it and around a keep-out star, scalar
+//  against SSE2, then clipped in chunks while the emulator marks
+static int BenchClip( int argc, char* argv[] )
+{
+    const UINT   Vectors = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 2000000;
+    const double Pi      = 3.14159265358979;
+
+    HatchContour Star;
+
+    for ( UINT i = 0; i < 16; i++ )
+    {
+        const double a = 2.0 * Pi * i / 16, R = i % 2 ? 60000.0 : 150000.0;
+        const HatchPoint p = { R * cos( a ), R * sin( a ) };
+        Star.push_back( p );
+
+    }
+
+    printf( "%u vectors, field +-524287 bits, keep-out star of 16 corners\n\n", Vectors );
+    printf( "stream               mode     M cmd/s  inside  clipped  split  removed  clamped  arcs  beyond  records\n" );
+
+    ListJob Jobs[ 2 ];
+    MakeClipJob( Jobs[ 0 ], Vectors, 0.5 );
+    MakeClipJob( Jobs[ 1 ], Vectors, 1.3 );
+
+    for ( UINT Case = 0; Case < 3; Case++ )
+    {
+        const ListJob& In = Jobs[ Case ? 1 : 0 ];
+        ListJob First;
+
+        for ( UINT Mode = 0; Mode < 2; Mode++ )
+        {
+            FieldClipper Clipper;
+            ListJob Out;
+
+            Clipper.Vectorized = Mode > 0;
+            if ( Case == 2 ) Clipper.KeepOut.push_back( Star );
+
+            Clipper.Clip( In.data(), In.size(), Out );
+
+            const char* Note = "";
+            if ( Mode == 0 ) First.swap( Out );
+            else if ( Out.size() != First.size() || memcmp( Out.data(), First.data(), Out.size() * sizeof( ListCommand ) ) ) Note = ", output differs";
+            if ( Case == 0 && ( Mode ? Out : First ).size() == In.size()
+                 && !memcmp( ( Mode ? Out : First ).data(), In.data(), In.size() * sizeof( ListCommand ) ) ) Note = ", unchanged";
+
+            printf( "%-20s %-6s %9.1f %7.0fk %7.0fk %6.0fk %7.0fk %8llu %5llu %7u %7.2fM%s\n",
+                    Case == 0 ? "within" : Case == 1 ? "beyond" : "beyond, keep-out", Mode ? "SSE2" : "scalar",
+                    Clipper.Commands / Clipper.Time * 1e-6, Clipper.Inside * 1e-3, Clipper.Clipped * 1e-3, Clipper.Split * 1e-3,
+                    Clipper.Removed * 1e-3, (unsigned long long) Clipper.Clamped, (unsigned long long) Clipper.Arcs,
+                    BeyondField( Mode ? Out : First, Clipper ), Clipper.Records * 1e-6, Note );
+
+        }
+
+    }
+
+    //  The first 200000 commands clipped in chunks between the generator
+    //  and the ListFeeder
+    const UINT ListSize = 8000, Chunk = 4096;
+
+    if ( OpenEmulator( 50e-6 ) )
+    {
+        printf( "Emulator could not be initialized\n" );
+        return 1;
+
+    }
+
+    config_list( ListSize, 0 );
+    printf( "\n" );
+
+    for ( UINT Mode = 0; Mode < 2; Mode++ )
+    {
+        const ListJob& In = Jobs[ Mode ? 1 : 0 ];
+        const size_t Count = std::min< size_t >( In.size(), 200000 );
+        ListFeeder   Feeder;
+        FieldClipper Clipper;
+        Clipper.KeepOut.push_back( Star );
+        Feeder.Pause = RTC5EmuAdvance;
+
+        const auto   Wall = std::chrono::steady_clock::now();
+        const double Sim  = RTC5EmuTime();
+
+        UINT Error = Feeder.Open( ListSize, 2000 );
+
+        for ( size_t i = 0; i < Count && !Error; i += Chunk )
+        {
+            Error = Clipper.Clip( In.data() + i, std::min< size_t >( Chunk, Count - i ), Feeder ) ? Clipper.FeedError : FeedNoError;
+
+        }
+
+        if ( !Error ) Error = Feeder.Finish();
+
+        if ( Error )
+        {
+            printf( "Feeder error %u\n", Error );
+            return 1;
+
+        }
+
+        ReportFeed( Mode ? "beyond, clipped" : "within, clipped", Clipper.Time,
+                    std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count(),
+                    RTC5EmuTime() - Sim, Feeder );
+
+    }
+
+    RTC5EmuClose();
+
+    //  Rings reaching beyond the field, clipped before the hatch
+    ListJob Import;
+
+    for ( UINT i = 0; i < 400; i++ )
+    {
+        MakeHatchShape( Import, 0, -650000 + 65000 * (LONG) ( i % 20 ) + 32500, -650000 + 65000 * (LONG) ( i / 20 ) + 32500 );
+
+    }
+
+    for ( size_t i = 0; i < Import.size(); i++ )
+    {
+        Import[ i ].I[ 0 ] = Import[ i ].I[ 0 ] / 2 * 3;
+        Import[ i ].I[ 1 ] = Import[ i ].I[ 1 ] / 2 * 3;
+
+    }
+
+    HatchEngine  Engine;
+    FieldClipper Clipper;
+    Engine.AddJob( Import.data(), Import.size() );
+
+    const auto t0 = std::chrono::steady_clock::now();
+    size_t Dropped = 0;
+
+    for ( size_t r = 0; r < Engine.Regions.size(); r++ )
+    {
+        Clipper.ClipRegion( Engine.Regions[ r ], Engine.Regions[ r ] );
+        if ( Engine.Regions[ r ].empty() ) Dropped++;
+
+    }
+
+    const double Time = std::chrono::duration< double >( std::chrono::steady_clock::now() - t0 ).count();
+
+    printf( "\nClipRegion: %u regions, %llu contours cut, %u regions dropped, %.2f ms\n", (UINT) Engine.Regions.size(),
+            (unsigned long long) Clipper.Polygons, (UINT) Dropped, Time * 1e3 );
+
+    return 0;
+
+}
+
+//  Marked length [bits] of the marks and arcs of a job
+static double MarkLength( const ListJob& Job )
+{
+    const double Pi = 3.14159265358979;
+    double X = 0.0, Y = 0.0, Length = 0.0;
+
+    for ( size_t i = 0; i < Job.size(); i++ )
+    {
+        const ListCommand& c = Job[ i ];
+
+        switch ( c.Op )
+        {
+        case OpJumpAbs:
+        case OpJumpAbs3D:   X = c.I[ 0 ]; Y = c.I[ 1 ];                                     break;
+        case OpMarkAbs:
+        case OpMarkAbs3D:   Length += hypot( c.I[ 0 ] - X, c.I[ 1 ] - Y ); X = c.I[ 0 ]; Y = c.I[ 1 ];  break;
+
+        case OpArcAbs:
+        {
+            const double a = c.D[ 0 ] * Pi / 180.0, vX = X - c.I[ 0 ], vY = Y - c.I[ 1 ];
+            Length += hypot( vX, vY ) * fabs( a );
+            X = c.I[ 0 ] + vX * cos( a ) + vY * sin( a );
+            Y = c.I[ 1 ] + vY * cos( a ) - vX * sin( a );
+            break;
+
+        }
+
+        default:
+            break;
+
+        }
+
+    }
+
+    return Length;
+
+}
+
+//  Parts in clusters over an area of 12 x 9 fields, circles and a line
+//  through the clusters, tiled by serpentine rows against the planned order, one thread
+//  against all, and the tiles streamed by the ListFeeder with the stage
+//  moved by the emulated stepper motors
+static int BenchTile( int argc, char* argv[] )
+{
+    const UINT   Parts    = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 300;
+    const LONG   Width    = 12000000, Height = 9000000;    //  [bits]
+    const UINT   ListSize = 8000;
+
+    std::mt19937 Random( 45 );
+    std::uniform_int_distribution< LONG > PosX( 1500000, Width - 1500000 ), PosY( 1500000, Height - 1500000 );
+    std::uniform_int_distribution< LONG > Spread( -1200000, 1200000 );
+    ListJob Job;
+    LONG    Cluster[ 8 ][ 2 ];
+
+    for ( UINT c = 0; c < 8; c++ )
+    {
+        Cluster[ c ][ 0 ] = PosX( Random );
+        Cluster[ c ][ 1 ] = PosY( Random );
+
+    }
+
+    Job.push_back( ListMakeD( OpSetJumpSpeed, 5000.0 ) );
+
+    //  Parts in eight clusters, in the order they were placed
+    for ( UINT i = 0; i < Parts; i++ )
+    {
+        const LONG X = Cluster[ i % 8 ][ 0 ] + Spread( Random ), Y = Cluster[ i % 8 ][ 1 ] + Spread( Random );
+        const size_t First = Job.size();
+
+        if ( i % 40 == 0 ) Job.push_back( ListMakeD( OpSetMarkSpeed, i % 80 ? 800.0 : 1200.0 ) );
+
+        MakeHatchShape( Job, i, 0, 0 );
+
+        for ( size_t k = First; k < Job.size(); k++ )
+        {
+            if ( Job[ k ].Op != OpJumpAbs && Job[ k ].Op != OpMarkAbs ) continue;
+
+            Job[ k ].I[ 0 ] = X + Job[ k ].I[ 0 ] * 60;
+            Job[ k ].I[ 1 ] = Y + Job[ k ].I[ 1 ] * 60;
+
+        }
+
+        if ( i % 10 == 0 )
+        {
+            ListCommand Arc = ListMake( OpArcAbs, X, Y );
+            Arc.D[ 0 ] = 360.0;
+            Job.push_back( ListMake( OpJumpAbs, X + 200000, Y ) );
+            Job.push_back( Arc );
+
+        }
+
+    }
+
+    //  A line through the clusters
+    Job.push_back( ListMake( OpJumpAbs, Cluster[ 0 ][ 0 ], Cluster[ 0 ][ 1 ] ) );
+
+    for ( UINT c = 1; c < 8; c++ ) Job.push_back( ListMake( OpMarkAbs, Cluster[ c ][ 0 ], Cluster[ c ][ 1 ] ) );
+
+    printf( "%u parts on %.0f x %.0f Mbits, %u commands, tiles of 1 Mbits\n\n", Parts, Width * 1e-6, Height * 1e-6, (UINT) Job.size() );
+
+    TileEngine Engine;
+    Engine.TileSize = 1000000;
+
+    for ( UINT Mode = 0; Mode < 2; Mode++ )
+    {
+        Engine.Optimize = Mode > 0;
+
+        if ( Engine.Plan( Job.data(), Job.size() ) )
+        {
+            printf( "Plan failed\n" );
+            return 1;
+
+        }
+
+        printf( "%-12s %3u x %u grid, %3u tiles, %7llu vectors, %7llu entries, %llu skipped, stage %7.2f s "
+                "(serpentine %.2f s), %.2f ms\n",
+                Mode ? "planned" : "serpentine", Engine.Columns, Engine.Rows, Engine.Tiles,
+                (unsigned long long) Engine.Vectors, (unsigned long long) Engine.Entries, (unsigned long long) Engine.Skipped,
+                Engine.Travel, Engine.SerpentineTravel, Engine.PlanTime * 1e3 );
+
+    }
+
+    printf( "\n" );
+
+    ListJob First;
+    const UINT Most = std::max( 4u, std::thread::hardware_concurrency() );
+
+    for ( UINT Mode = 0; Mode < 2; Mode++ )
+    {
+        ListJob Out;
+        Engine.Threads = Mode ? Most : 1;
+        Engine.Run( Out );
+
+        const char* Note = "";
+        if ( Mode == 0 ) First.swap( Out );
+        else if ( Out.size() != First.size() || memcmp( Out.data(), First.data(), Out.size() * sizeof( ListCommand ) ) ) Note = ", output differs";
+
+        printf( "%2u threads   %8.2f ms  first tile %6.2f ms  %8llu records  %6llu clipped%s\n", Engine.Threads,
+                Engine.WriteTime * 1e3, Engine.FirstTileTime * 1e3, (unsigned long long) Engine.Records,
+                (unsigned long long) Engine.Clipped, Note );
+
+    }
+
+    TimeEstimator Estimator;
+    Estimator.Model.JumpSpeed = 5000.0;
+
+    for ( UINT m = 0; m < 2; m++ ) Estimator.Model.StepperPeriod[ m ] = Engine.StepperPeriod[ m ];
+
+    const double Estimate = Estimator.Estimate( First.data(), First.size() );
+
+    printf( "\nmarked length %.1f Mbits of %.1f Mbits, estimated %.2f s, of it %.2f s stage\n",
+            MarkLength( First ) * 1e-6, MarkLength( Job ) * 1e-6, Estimate, Estimator.Model.Time.T[ TimeStage ] );
+
+    //  Streamed while the later tiles are prepared
+    if ( OpenEmulator( 50e-6 ) )
+    {
+        printf( "Emulator could not be initialized\n" );
+        return 1;
+
+    }
+
+    config_list( ListSize, 0 );
+
+    for ( UINT m = 0; m < 2; m++ ) stepper_init( m + 1, Engine.StepperPeriod[ m ], 0, Engine.StageHome[ m ], 0, 1, 0 );
+
+    ListFeeder Feeder;
+    Feeder.Pause = RTC5EmuAdvance;
+    Engine.Threads = 0;
+
+    const auto   Wall = std::chrono::steady_clock::now();
+    const double Sim  = RTC5EmuTime();
+
+    UINT Error = Feeder.Open( ListSize, 2000 );
+    if ( !Error ) Error = Engine.Run( Feeder ) ? Engine.FeedError : FeedNoError;
+    if ( !Error ) Error = Feeder.Finish();
+
+    if ( Error )
+    {
+        printf( "Feeder error %u\n", Error );
+        return 1;
+
+    }
+
+    printf( "\n" );
+    ReportFeed( "tiles, fed", Engine.FirstTileTime,
+                std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count(),
+                RTC5EmuTime() - Sim, Feeder );
+
+    UINT Status[ 2 ];
+    LONG Pos[ 2 ], Last[ 2 ];
+    get_stepper_status( &Status[ 0 ], &Pos[ 0 ], &Status[ 1 ], &Pos[ 1 ] );
+    Engine.StagePosition( Engine.Order.back(), Last );
+    printf( "stage at %ld, %ld steps, last tile %ld, %ld\n", (long) Pos[ 0 ], (long) Pos[ 1 ], (long) Last[ 0 ], (long) Last[ 1 ] );
+
+    RTC5EmuClose();
+
+    return 0;
+
+}
+
+//  Rings, stars and combs passing on a conveyor at random pitches, planned
+//  at one speed, checked at others, and streamed into the emulator below
+//  and above the highest sustainable speed with the conveyor's encoder
+static int BenchConveyor( int argc, char* argv[] )
+{
+    const UINT   Parts    = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 1000;
+    const UINT   ListSize = 8000;
+
+    ConveyorScheduler Scheduler;
+    Scheduler.Scale = 1.0;              //  [bits/count]
+    Scheduler.Rate  = 200000.0;         //  [counts/s]
+    Scheduler.Lead  = 20000;            //  [counts]
+    Scheduler.Home[ 0 ] = -200000;      //  upstream, where the parts come in
+
+    Scheduler.Setup.push_back( ListMakeD( OpSetJumpSpeed, 5000.0 ) );
+    Scheduler.Setup.push_back( ListMakeD( OpSetMarkSpeed, 1000.0 ) );
+    Scheduler.Setup.push_back( ListMake( OpSetScannerDelays, 25, 10, 5 ) );
+
+    for ( UINT p = 0; p < 3; p++ )
+    {
+        ListJob Pattern;
+        MakeHatchShape( Pattern, p, 0, 0 );
+
+        for ( size_t k = 0; k < Pattern.size(); k++ )
+        {
+            Pattern[ k ].I[ 0 ] *= 10;
+            Pattern[ k ].I[ 1 ] *= 10;
+
+        }
+
+        Scheduler.Patterns.push_back( Pattern );
+
+    }
+
+    std::mt19937 Random( 46 );
+    std::uniform_int_distribution< LONG > Pitch( 40000, 80000 );    //  [counts]
+    std::vector< ConveyorPart > Queue( Parts );
+    LONG Trigger = 100000;
+
+    for ( UINT i = 0; i < Parts; i++ )
+    {
+        Queue[ i ].Trigger = Trigger;
+        Queue[ i ].Pattern = i % 3;
+        Trigger += Pitch( Random );
+
+    }
+
+    if ( Scheduler.Plan( Queue.data(), Queue.size() ) )
+    {
+        printf( "Plan failed\n" );
+        return 1;
+
+    }
+
+    printf( "%u parts at pitches of 40000..80000 counts, 1 bit/count, ring %.1f ms, star %.1f ms, comb %.1f ms, "
+            "%.2f s marking\n\n", Parts, Scheduler.PatternTime[ 0 ] * 1e3, Scheduler.PatternTime[ 1 ] * 1e3,
+            Scheduler.PatternTime[ 2 ] * 1e3, Scheduler.MarkTime );
+
+    printf( "planned at %.0f counts/s in %.2f ms, highest sustainable speed %.0f counts/s\n\n",
+            Scheduler.Rate, Scheduler.PlanTime * 1e3, Scheduler.MaxRate );
+
+    const double Factor[ 6 ] = { 0.5, 0.9, 0.99, 1.0, 1.01, 1.2 };
+
+    for ( UINT k = 0; k < 6; k++ )
+    {
+        Scheduler.Check( Factor[ k ] * Scheduler.MaxRate );
+        printf( "%5.2f x %8.0f counts/s  %-13s margin %9.0f bits  %4u beyond  %4u late  lag %8.1f ms  end %7.2f s\n",
+                Factor[ k ], Factor[ k ] * Scheduler.MaxRate, Scheduler.Sustainable ? "sustainable" : "unsustainable",
+                Scheduler.Margin, Scheduler.Beyond, Scheduler.Late, Scheduler.MaxLag * 1e3, Scheduler.EndTime );
+
+    }
+
+    printf( "\n" );
+
+    //  Streamed at speeds below and above the highest sustainable one
+    const double Speed[ 2 ] = { 0.97 * Scheduler.MaxRate, 1.05 * Scheduler.MaxRate };
+
+    for ( UINT k = 0; k < 2; k++ )
+    {
+        if ( OpenEmulator( 50e-6 ) )
+        {
+            printf( "Emulator could not be initialized\n" );
+            return 1;
+
+        }
+
+        config_list( ListSize, 0 );
+        RTC5EmuSetEncoder( 0, Speed[ k ] );
+
+        LONG Count;
+        get_encoder( &Count, 0 );
+        Scheduler.StartCount = Count;
+        Scheduler.Check( Speed[ k ] );
+
+        ListFeeder Feeder;
+        Feeder.Pause = RTC5EmuAdvance;
+
+        const auto   Wall = std::chrono::steady_clock::now();
+        const double Sim  = RTC5EmuTime();
+
+        UINT Error = Feeder.Open( ListSize, 2000 );
+        if ( !Error ) Error = Scheduler.Run( Feeder ) ? Scheduler.FeedError : FeedNoError;
+        if ( !Error ) Error = Feeder.Finish();
+
+        if ( Error )
+        {
+            printf( "Feeder error %u\n", Error );
+            return 1;
+
+        }
+
+        char Name[ 32 ];
+        snprintf( Name, sizeof( Name ), "%.0f counts/s, fed", Speed[ k ] );
+        ReportFeed( Name, 0.0, std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count(),
+                    RTC5EmuTime() - Sim, Feeder );
+
+        printf( "%-22s planned %s, end %.2f s, fly overflow bits 0x%X, %u parts fed late, least %.0f counts ahead\n",
+                "", Scheduler.Sustainable ? "sustainable" : "unsustainable", Scheduler.EndTime, get_marking_info(),
+                Scheduler.HostLate, Scheduler.MinAhead );
+
+        RTC5EmuClose();
+
+    }
+
+    return 0;
+
+}
+
+//  Rings, stars and combs scattered in random order over the field, rotated
+//  and scaled on the host and reordered per chunk, prepared whole on one
+//  thread before streaming against prepared in chunks while streaming
+static int BenchPrepare( int argc, char* argv[] )
+{
+    const UINT   Parts    = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 500;
+    const UINT   ListSize = 8000;
+    const double Pi       = 3.14159265358979;
+
+    std::mt19937 Random( 49 );
+    std::uniform_int_distribution< LONG > Pos( -12000, 12000 );
+    ListJob Job;
+    std::vector< size_t > PartEnd;
+
+    Job.push_back( ListMakeD( OpSetJumpSpeed, 5000.0 ) );
+    Job.push_back( ListMakeD( OpSetMarkSpeed, 1000.0 ) );
+
+    for ( UINT i = 0; i < 16 * Parts; i++ )
+    {
+        const size_t First = Job.size();
+        MakeHatchShape( Job, i, 0, 0 );
+
+        const LONG X = Pos( Random ), Y = Pos( Random );
+
+        for ( size_t k = First; k < Job.size(); k++ )
+        {
+            Job[ k ].I[ 0 ] = X + Job[ k ].I[ 0 ] * 20;
+            Job[ k ].I[ 1 ] = Y + Job[ k ].I[ 1 ] * 20;
+
+        }
+
+        PartEnd.push_back( Job.size() );
+
+    }
+
+    PrepareEngine Engine;
+    Engine.Matrix[ 0 ] = Engine.Matrix[ 3 ] = 0.5 * cos( Pi / 6 );
+    Engine.Matrix[ 1 ] = -0.5 * sin( Pi / 6 );
+    Engine.Matrix[ 2 ] =  0.5 * sin( Pi / 6 );
+    Engine.Offset[ 0 ] = 20000.0;
+    Engine.Offset[ 1 ] = -10000.0;
+
+    const UINT Most = std::max( 4u, std::thread::hardware_concurrency() );
+
+    printf( "transform 0.5 at 30 deg, chunks of %u records, %u threads\n\n", (UINT) Engine.ChunkSize, Most );
+
+    //  Time to the first chunk against the size of the job
+    for ( UINT Scale = 1; Scale <= 16; Scale *= 4 )
+    {
+        const size_t Count = PartEnd[ Scale * Parts - 1 ];
+        ListJob Whole, Chunked;
+
+        Engine.Plan( Job.data(), Count );
+        Engine.Threads = 1;
+        Engine.Run( Whole );
+        const double WholeTime = Engine.PlanTime + Engine.WriteTime;
+
+        Engine.Plan( Job.data(), Count );
+        Engine.Threads = Most;
+        Engine.Run( Chunked );
+
+        const char* Note = "";
+        if ( Whole.size() != Chunked.size() || memcmp( Whole.data(), Chunked.data(), Whole.size() * sizeof( ListCommand ) ) ) Note = ", output differs";
+
+        printf( "%6u parts %8u records %5u chunks  first mark after %8.2f ms whole, %6.2f ms chunked  "
+                "%8.2f ms all chunks  %3llu steals%s\n",
+                Scale * Parts, (UINT) Count, Engine.Chunks, WholeTime * 1e3,
+                ( Engine.PlanTime + Engine.FirstChunkTime ) * 1e3, Engine.WriteTime * 1e3,
+                (unsigned long long) Engine.Steals, Note );
+
+        if ( Scale == 16 )
+        {
+            const double   Before    = Engine.JumpLength;
+            const uint64_t Reordered = Engine.Reordered;
+            ListJob Unordered;
+            Engine.Optimize = false;
+            Engine.Run( Unordered );
+            Engine.Optimize = true;
+
+            printf( "\nmarked length %.1f Mbits of %.1f Mbits, jumps %.1f Mbits, %.1f Mbits in job order, "
+                    "%llu polylines reordered\n",
+                    MarkLength( Whole ) * 1e-6, MarkLength( Job ) * 1e-6, Before * 1e-6, Engine.JumpLength * 1e-6,
+                    (unsigned long long) Reordered );
+
+        }
+
+    }
+
+    //  Relative vectors after a run of polylines start where they did in
+    //  job order, whether the run is reordered or not
+    {
+        const ListCommand Tail[] =
+        {
+            ListMake( OpJumpAbs, 0, 0 ),        ListMake( OpSetLaserDelays, 100, 100 ),
+            ListMake( OpJumpAbs, 1000, 0 ),     ListMake( OpMarkAbs, 1100, 0 ),
+            ListMake( OpJumpAbs, 10, 0 ),       ListMake( OpMarkAbs, 20, 0 ),
+            ListMake( OpJumpRel, 5, 5 ),        ListMake( OpMarkRel, 10, 0 )
+        };
+
+        PrepareEngine Check;
+        double   End[ 2 ][ 2 ];
+        uint64_t Moved = 0;
+
+        for ( UINT Mode = 0; Mode < 2; Mode++ )
+        {
+            ListJob Out;
+            Check.Optimize = Mode != 0;
+            Check.Plan( Tail, sizeof( Tail ) / sizeof( Tail[ 0 ] ) );
+            Check.Run( Out );
+
+            TimeEstimator Estimator;
+            Estimator.Estimate( Out.data(), Out.size() );
+            End[ Mode ][ 0 ] = Estimator.Model.X;
+            End[ Mode ][ 1 ] = Estimator.Model.Y;
+            if ( Mode ) Moved = Check.Reordered;
+
+        }
+
+        const bool Same = End[ 0 ][ 0 ] == End[ 1 ][ 0 ] && End[ 0 ][ 1 ] == End[ 1 ][ 1 ];
+
+        printf( "end after a run and relative vectors (%.0f, %.0f) in job order, (%.0f, %.0f) optimized, "
+                "%llu polylines reordered%s\n",
+                End[ 0 ][ 0 ], End[ 0 ][ 1 ], End[ 1 ][ 0 ], End[ 1 ][ 1 ], (unsigned long long) Moved,
+                Same ? "" : ", position differs" );
+
+        if ( !Same ) return 1;
+
+    }
+
+    //  Streamed into the emulator, whole against chunked
+    for ( UINT Mode = 0; Mode < 2; Mode++ )
+    {
+        if ( OpenEmulator( 50e-6 ) )
+        {
+            printf( "Emulator could not be initialized\n" );
+            return 1;
+
+        }
+
+        config_list( ListSize, 0 );
+
+        ListFeeder Feeder;
+        Feeder.Pause = RTC5EmuAdvance;
+
+        const auto   Wall = std::chrono::steady_clock::now();
+        const double Sim  = RTC5EmuTime();
+        double First = 0.0;
+
+        Engine.Threads = Mode ? Most : 1;
+        Engine.Plan( Job.data(), Job.size() );
+
+        UINT Error = Feeder.Open( ListSize, 2000 );
+
+        if ( !Error && !Mode )
+        {
+            ListJob Whole;
+            Engine.Run( Whole );
+            First = std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count();
+            Error = Feeder.Feed( Whole.data(), Whole.size() );
+
+        }
+        else if ( !Error )
+        {
+            Error = Engine.Run( Feeder ) ? Engine.FeedError : FeedNoError;
+            First = Engine.PlanTime + Engine.FirstChunkTime;
+
+        }
+
+        if ( !Error ) Error = Feeder.Finish();
+
+        if ( Error )
+        {
+            printf( "Feeder error %u\n", Error );
+            return 1;
+
+        }
+
+        if ( !Mode ) printf( "\n" );
+        ReportFeed( Mode ? "chunked, fed" : "whole, then fed", First,
+                    std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count(),
+                    RTC5EmuTime() - Sim, Feeder );
+
+        RTC5EmuClose();
+
+    }
+
+    return 0;
+
+}
+
+//  Figures as a program builds them for its lists: polygons, raster lines
+//  and serial numbers
+static void Put( ListJob& Job, const ListCommand& Cmd )
+{
+    Job.push_back( Cmd );
+
+}
+
+static void Put( CommandBuffer& Buffer, const ListCommand& Cmd )
+{
+    Buffer.Add( Cmd );
+
+}
+
+static void PutText( ListJob& Job, const char* Text )
+{
+    ListAppendText( Job, OpMarkTextAbs, Text );
+
+}
+
+static void PutText( CommandBuffer& Buffer, const char* Text )
+{
+    Buffer.AddText( OpMarkTextAbs, Text );
+
+}
+
+template< class Buffer > static void MakeFigure( Buffer& Out, UINT i )
+{
+    const double Pi = 3.14159265358979;
+    const LONG   X  = (LONG) ( i % 40 ) * 5000 - 100000, Y = (LONG) ( i / 40 % 40 ) * 5000 - 100000;
+
+    if ( i % 3 == 0 )
+    {
+        //  A star of 24 points
+        for ( UINT k = 0; k <= 48; k++ )
+        {
+            const double a = 2.0 * Pi * k / 48, R = k % 2 ? 900.0 : 2000.0;
+            Put( Out, ListMake( k ? OpMarkAbs : OpJumpAbs, X + (LONG) ( R * cos( a ) ), Y + (LONG) ( R * sin( a ) ) ) );
+
+        }
+
+    }
+    else if ( i % 3 == 1 )
+    {
+        //  A raster line of 256 pixels
+        ListCommand Line = ListMake( OpSetPixelLine, 0, 10 );
+        Line.D[ 0 ] = 10.0;
+        Line.D[ 1 ] = 0.0;
+        Put( Out, ListMake( OpJumpAbs, X - 1280, Y ) );
+        Put( Out, Line );
+
+        for ( UINT k = 0; k < 256; k++ ) Put( Out, ListMake( OpSetPixel, 2 + ( k * 7 + i ) % 13, 0 ) );
+
+    }
+    else
+    {
+        char Text[ 32 ];
+        sprintf( Text, "SN %08u", i );
+        Put( Out, ListMake( OpJumpAbs, X, Y ) );
+        PutText( Out, Text );
+
+    }
+
+}
+
+//  Time the emulator spends in ListFeeder::Pause, not the host's
+static double PausedTime = 0.0;
+
+static void TimedAdvance( double Seconds )
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    RTC5EmuAdvance( Seconds );
+    PausedTime += std::chrono::duration< double >( std::chrono::steady_clock::now() - t0 ).count();
+
+}
+
+//  Figures built into a ListJob each against a CommandBuffer each and fed,
+//  heap calls per million commands and the host time of an iteration of
+//  the feeder loop, then the chunks of a PrepareEngine from run to run
+static int BenchArena( int argc, char* argv[] )
+{
+    const UINT   Figures  = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 30000;
+    const UINT   Warmup   = 1000;
+    const UINT   ListSize = 8000;
+
+    SlabPool Pool;
+    std::vector< double > Latency;
+    Latency.reserve( Figures );
+
+    //  The slabs of an arena allocated and touched before timing
+    {
+        CommandArena  Arena( Pool );
+        CommandBuffer Touch( Arena );
+        for ( UINT i = 0; i < ( Arena.Keep + Arena.Batch ) * SlabRecords; i++ ) Touch.Add( ListMake( OpNop ) );
+
+    }
+
+    printf( "%u figures of stars, raster lines and serial numbers, host time per figure built and fed\n\n", Figures );
+
+    for ( UINT Mode = 0; Mode < 2; Mode++ )
+    {
+        if ( OpenEmulator( 50e-6 ) )
+        {
+            printf( "Emulator could not be initialized\n" );
+            return 1;
+
+        }
+
+        config_list( ListSize, 0 );
+
+        ListFeeder Feeder;
+        Feeder.Pause = TimedAdvance;
+
+        CommandArena Arena( Pool );
+        UINT Error = Feeder.Open( ListSize, 2000 );
+        uint64_t Commands = 0, Calls = 0;
+
+        Latency.clear();
+
+        for ( UINT i = 0; i < Warmup + Figures && !Error; i++ )
+        {
+            if ( i == Warmup )
+            {
+                Calls    = HeapCalls;
+                Commands = Feeder.Records;
+
+            }
+
+            const auto t0 = std::chrono::steady_clock::now();
+            PausedTime = 0.0;
+
+            if ( Mode == 0 )
+            {
+                ListJob Figure;
+                MakeFigure( Figure, i );
+                Error = Feeder.Feed( Figure.data(), Figure.size() );
+
+            }
+            else
+            {
+                CommandBuffer Figure( Arena );
+                MakeFigure( Figure, i );
+                Error = Figure.Feed( Feeder );
+
+            }
+
+            if ( i >= Warmup ) Latency.push_back( std::chrono::duration< double >( std::chrono::steady_clock::now() - t0 ).count() - PausedTime );
+
+        }
+
+        Calls    = HeapCalls - Calls;
+        Commands = Feeder.Records - Commands;
+
+        if ( !Error ) Error = Feeder.Finish();
+
+        if ( Error )
+        {
+            printf( "Feeder error %u\n", Error );
+            return 1;
+
+        }
+
+        std::sort( Latency.begin(), Latency.end() );
+        const size_t n    = Latency.size();
+        const size_t Slow = Latency.end() - std::upper_bound( Latency.begin(), Latency.end(), 100e-6 );
+
+        printf( "%-16s %9.1f heap calls per million commands  p50 %6.2f us  p99 %6.2f us  p99.9 %7.2f us  max %8.2f us  "
+                "%4u over 100 us\n",
+                Mode ? "CommandBuffer" : "ListJob", Commands ? Calls * 1e6 / Commands : 0.0,
+                Latency[ n / 2 ] * 1e6, Latency[ n * 99 / 100 ] * 1e6, Latency[ n * 999 / 1000 ] * 1e6, Latency[ n - 1 ] * 1e6,
+                (UINT) Slow );
+
+        RTC5EmuClose();
+
+    }
+
+    printf( "%-16s %9llu slabs allocated, %llu in the pool\n\n", "", (unsigned long long) Pool.Slabs, (unsigned long long) Pool.Free );
+
+    //  The chunks of a PrepareEngine, the pool grows in the first run only
+    ListJob Job;
+    for ( UINT i = 0; i < Figures; i++ ) MakeFigure( Job, i );
+
+    PrepareEngine Engine;
+    Engine.Matrix[ 0 ] = Engine.Matrix[ 3 ] = 0.5;
+    Engine.Plan( Job.data(), Job.size() );
+
+    for ( UINT Run = 0; Run < 3; Run++ )
+    {
+        ListJob Out;
+        Out.reserve( Job.size() );
+
+        const uint64_t Calls = HeapCalls;
+        Engine.Run( Out );
+
+        printf( "prepare, run %u  %9.1f heap calls per million commands  %5llu slabs allocated  %u chunks  %8.2f ms\n",
+                Run + 1, Engine.Records ? ( HeapCalls - Calls ) * 1e6 / Engine.Records : 0.0,
+                (unsigned long long) Engine.Allocations, Engine.Chunks, Engine.WriteTime * 1e3 );
+
+    }
+
+    return 0;
+
+}
+
+//  A Hershey font of boxes with a diagonal, one per letter, loaded into
+//  character set 1 again and again: the transfer is skipped while the
+//  card holds the same tag
+static int BenchFont( int argc, char* argv[] )
+{
+    const UINT  Glyphs   = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 26;
+    const char* FontName = "HostBench.jhf";
+    const char* Name     = "HostBench.rsf";
+    const UINT  Tag      = 7;
+
+    FILE* f = fopen( FontName, "wb" );
+
+    if ( !f )
+    {
+        printf( "%s could not be written\n", FontName );
+        return 1;
+
+    }
+
+    //  Bounds -5, 5, a box from -5, -9 to 5, 0 and a diagonal per glyph
+    for ( UINT k = 0; k < Glyphs && k < FontCharsPerSet - 'A'; k++ )
+    {
+        fprintf( f, "%5u  9MWMIWIWRMRMI RM%cWR\n", 501 + k, 'I' + k % 9 );
+
+    }
+
+    fclose( f );
+
+    GlyphStore Store, Loaded;
+    UINT Error = Store.CompileHershey( FontName, 'A' );
+    if ( !Error ) Error = Store.Save( Name );
+    if ( !Error ) Error = Loaded.Load( Name );
+
+    if ( Error || Loaded.Hash() != Store.Hash() )
+    {
+        printf( "Glyph store error %u\n", Error );
+        return 1;
+
+    }
+
+    printf( "%u glyphs, %u vertices, hash %016llX\n\n", Loaded.GlyphCount(), Loaded.VertexCount(),
+            (unsigned long long) Loaded.Hash() );
+
+    if ( OpenEmulator( 50e-6 ) )
+    {
+        printf( "Emulator could not be initialized\n" );
+        return 1;
+
+    }
+
+    //  Expected: transferred, skipped, transferred at another scale,
+    //  skipped, transferred after load_program_file cleared the card
+    const double Scale[ 5 ]  = { 100.0, 100.0, 120.0, 120.0, 120.0 };
+    const bool   Expect[ 5 ] = { true, false, true, false, true };
+    bool Ok = true;
+
+    for ( UINT Load = 0; Load < 5; Load++ )
+    {
+        if ( Load == 4 ) load_program_file( 0 );
+
+        bool Reloaded = false;
+        const auto   Wall = std::chrono::steady_clock::now();
+        const double Sim  = RTC5EmuTime();
+
+        Error = LoadCharSet( Loaded, 1, Scale[ Load ], Tag, &Reloaded );
+
+        const bool Right = !Error && Reloaded == Expect[ Load ];
+        Ok = Ok && Right;
+
+        printf( "load %u  %5.0f bits/unit  %-11s %8.3f ms wall  %8.3f ms simulated  %s\n", Load + 1, Scale[ Load ],
+                Reloaded ? "transferred" : "skipped",
+                std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count() * 1e3,
+                ( RTC5EmuTime() - Sim ) * 1e3, Right ? "ok" : "unexpected" );
+
+    }
+
+    RTC5EmuClose();
+
+    return Ok ? 0 : 1;
+
+}
+
+#ifndef _WIN32
+//  What a client process of BenchServer reports through its pipe
+struct ClientResult
+{
+    UINT     Jobs;
+    UINT     Errors;
+    double   Submit;            //  [s] sum of the Submit calls
+    double   QueueTime;         //  [s] sum
+    double   MaxQueueTime;      //  [s]
+    double   MarkTime;          //  [s] sum
+    double   Status;            //  [s] per Status round trip
+
+};
+
+//  A client process: submits all its jobs at once, then waits for them
+static ClientResult ServerClient( const char* Path, int Priority, UINT Jobs, UINT Vectors )
+{
+    ClientResult r;
+    memset( &r, 0, sizeof( r ) );
+
+    JobClient Client;
+    JobFileHeader Params;
+    JobDefaults( Params );
+    Params.JumpSpeed = 5000.0;
+    Params.MarkSpeed = 2000.0;
+
+    ListJob Job;
+    MakeHatch( Job, Vectors );
+
+    if ( Client.Connect( Path ) )
+    {
+        r.Errors = Jobs;
+        return r;
+
+    }
+
+    std::vector< uint64_t > Id( Jobs );
+
+    for ( UINT j = 0; j < Jobs; j++ )
+    {
+        const auto Wall = std::chrono::steady_clock::now();
+
+        if ( Client.Submit( Params, Job.data(), Job.size(), Priority, &Id[ j ] ) ) r.Errors++;
+
+        r.Submit += std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count();
+
+    }
+
+    const UINT Polls = 1000;
+    const auto Wall  = std::chrono::steady_clock::now();
+    JobStatus  Status;
+
+    for ( UINT k = 0; k < Polls; k++ ) Client.Status( Id[ Jobs - 1 ], &Status );
+
+    r.Status = std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count() / Polls;
+
+    for ( UINT j = 0; j < Jobs; j++ )
+    {
+        if ( Client.Wait( Id[ j ], &Status ) || Status.State != ServerDone )
+        {
+            r.Errors++;
+            continue;
+
+        }
+
+        r.Jobs++;
+        r.QueueTime   += Status.QueueTime;
+        r.MaxQueueTime = std::max( r.MaxQueueTime, Status.QueueTime );
+        r.MarkTime    += Status.MarkTime;
+
+    }
+
+    return r;
+
+}
+
+static int BenchServer( int argc, char* argv[] )
+{
+    const UINT   Jobs     = argc > 2 ? (UINT) atoi( argv[ 2 ] ) : 8;
+    const double Latency  = ( argc > 3 ? atof( argv[ 3 ] ) : 50.0 ) * 1e-6;
+    const UINT   Clients  = 4;
+    const UINT   ListSize = 8000;
+    const char*  Path     = "HostBench.sock";
+
+    //  The socket exists before the clients are forked, they connect at once
+    JobServer Server;
+
+    if ( Server.Open( Path ) )
+    {
+        printf( "%s could not be opened\n", Path );
+        return 1;
+
+    }
+
+    pid_t Pid[ Clients ];
+    int   Result[ Clients ];
+
+    for ( UINT c = 0; c < Clients; c++ )
+    {
+        int Pipe[ 2 ];
+
+        if ( pipe( Pipe ) || ( Pid[ c ] = fork() ) < 0 )
+        {
+            printf( "Client %u could not be started\n", c );
+            return 1;
+
+        }
+
+        if ( !Pid[ c ] )
+        {
+            close( Pipe[ 0 ] );
+            const ClientResult r = ServerClient( Path, (int) c, Jobs, 5000 * ( c + 1 ) );
+            const bool Written   = write( Pipe[ 1 ], &r, sizeof( r ) ) == (ssize_t) sizeof( r );
+            _exit( Written ? 0 : 1 );
+
+        }
+
+        close( Pipe[ 1 ] );
+        Result[ c ] = Pipe[ 0 ];
+
+    }
+
+    if ( OpenEmulator( Latency ) )
+    {
+        printf( "Emulator could not be initialized\n" );
+        return 1;
+
+    }
+
+    config_list( ListSize, 0 );
+
+    Server.ListSize = ListSize;
+    Server.StartGap = 2000;
+    Server.Pause    = RTC5EmuAdvance;
+
+    const auto   Wall = std::chrono::steady_clock::now();
+    const double Sim  = RTC5EmuTime();
+    UINT Error = ServerNoError;
+    std::thread Serving( [ & ] { Error = Server.Serve(); } );
+
+    printf( "%u client processes, %u hatch jobs each of 5000 .. %u vectors, priority = client\n\n",
+            Clients, Jobs, 5000 * Clients );
+
+    for ( UINT c = 0; c < Clients; c++ )
+    {
+        ClientResult r;
+        int Status;
+        const bool Read = read( Result[ c ], &r, sizeof( r ) ) == (ssize_t) sizeof( r );
+
+        close( Result[ c ] );
+        waitpid( Pid[ c ], &Status, 0 );
+
+        if ( !Read )
+        {
+            printf( "client %u: no result\n", c );
+            continue;
+
+        }
+
+        printf( "client %u  %3u done  %2u errors  submit %7.3f ms  queued %8.2f ms mean %8.2f ms max  "
+                "marking %7.2f ms wall  status %6.1f us\n",
+                c, r.Jobs, r.Errors, r.Jobs ? r.Submit / Jobs * 1e3 : 0.0,
+                r.Jobs ? r.QueueTime / r.Jobs * 1e3 : 0.0, r.MaxQueueTime * 1e3,
+                r.Jobs ? r.MarkTime / r.Jobs * 1e3 : 0.0, r.Status * 1e6 );
+
+    }
+
+    Server.Stop();
+    Serving.join();
+
+    printf( "\nserver: %llu submitted, %llu done, %llu failed, %llu records, at most %u queued, "
+            "%.3f ms longest switch, %.1f ms idle, %.1f ms wall, %.1f ms simulated\n",
+            (unsigned long long) Server.Submitted, (unsigned long long) Server.Done,
+            (unsigned long long) Server.Failed, (unsigned long long) Server.Records, Server.MaxQueue,
+            Server.SwitchTime * 1e3, Server.IdleTime * 1e3,
+            std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count() * 1e3,
+            ( RTC5EmuTime() - Sim ) * 1e3 );
+
+    Server.Close();
+    RTC5EmuClose();
+    return Error ? 1 : 0;
+
+}
+
+//  Record i of the stream of BenchRing
+static ListCommand RingRecord( uint64_t i )
+{
+    return ListMake( i & 1 ? OpMarkAbs : OpJumpAbs, (int32_t) ( i & 0xFFFF ), (int32_t) ( i >> 16 ) );
+
+}
+
+//  The producer process: Count records in place, Batch per Commit
+static void RingProducer( int Descriptor, uint64_t Count, size_t Batch )
+{
+    CommandRing Ring;
+
+    if ( Ring.Attach( Descriptor ) ) _exit( 1 );
+
+    for ( uint64_t i = 0; i < Count; )
+    {
+        size_t       Free;
+        ListCommand* To = Ring.Reserve( &Free );
+
+        if ( !To ) _exit( 1 );
+
+        const size_t n = (size_t) std::min< uint64_t >( std::min( Free, Batch ), Count - i );
+
+        for ( size_t k = 0; k < n; k++ ) To[ k ] = RingRecord( i + k );
+
+        Ring.Commit( n );
+        i += n;
+
+    }
+
+    Ring.Finish();
+    _exit( 0 );
+
+}
+
+//  The same stream through a socket: generated into a buffer, then written
+static void SocketProducer( int Socket, uint64_t Count, size_t Batch )
+{
+    std::vector< ListCommand > Buffer( Batch );
+
+    for ( uint64_t i = 0; i < Count; )
+    {
+        const size_t n = (size_t) std::min< uint64_t >( Batch, Count - i );
+
+        for ( size_t k = 0; k < n; k++ ) Buffer[ k ] = RingRecord( i + k );
+
+        for ( size_t Done = 0; Done < n * sizeof( ListCommand ); )
+        {
+            const ssize_t w = write( Socket, (const char*) Buffer.data() + Done, n * sizeof( ListCommand ) - Done );
+
+            if ( w <= 0 ) _exit( 1 );
+
+            Done += (size_t) w;
+
+        }
+
+        i += n;
+
+    }
+
+    _exit( 0 );
+
+}
+
+static bool Reap( pid_t Pid )
+{
+    int Status;
+
+    return waitpid( Pid, &Status, 0 ) == Pid && WIFEXITED( Status ) && !WEXITSTATUS( Status );
+
+}
+
+static int BenchRing( int argc, char* argv[] )
+{
+    const uint64_t Count    = (uint64_t) ( ( argc > 2 ? atof( argv[ 2 ] ) : 10.0 ) * 1e6 );
+    const size_t   Capacity = 1 << 16;
+    const size_t   Batch[ 4 ] = { 1, 16, 256, 4096 };
+
+    printf( "%.1f million commands from a producer process, ring of %u records\n\n", Count * 1e-6, (UINT) Capacity );
+
+    for ( UINT b = 0; b < 5; b++ )
+    {
+        const bool Socket = b == 4;
+        CommandRing Ring;
+        int Pair[ 2 ] = { -1, -1 };
+
+        if ( Socket ? socketpair( AF_UNIX, SOCK_STREAM, 0, Pair ) != 0 : Ring.Create( Capacity ) != RingNoError )
+        {
+            printf( "%s could not be created\n", Socket ? "Socket pair" : "Ring" );
+            return 1;
+
+        }
+
+        const auto  Wall = std::chrono::steady_clock::now();
+        const pid_t Pid  = fork();
+
+        if ( !Pid )
+        {
+            if ( Socket ) SocketProducer( Pair[ 1 ], Count, 256 );
+            else          RingProducer( dup( Ring.Descriptor() ), Count, Batch[ b ] );
+
+        }
+
+        uint64_t Received   = 0;
+        uint64_t Mismatches = 0;
+
+        if ( Socket )
+        {
+            close( Pair[ 1 ] );
+
+            std::vector< ListCommand > Buffer( 256 );
+            size_t  Bytes = 0;
+            ssize_t r;
+
+            while ( ( r = read( Pair[ 0 ], (char*) Buffer.data() + Bytes, Buffer.size() * sizeof( ListCommand ) - Bytes ) ) > 0 )
+            {
+                Bytes += (size_t) r;
+
+                const size_t n = Bytes / sizeof( ListCommand );
+
+                for ( size_t k = 0; k < n; k++ )
+                {
+                    const ListCommand Expected = RingRecord( Received + k );
+                    Mismatches += Buffer[ k ].Op != Expected.Op || Buffer[ k ].I[ 0 ] != Expected.I[ 0 ] || Buffer[ k ].I[ 1 ] != Expected.I[ 1 ];
+
+                }
+
+                Received += n;
+                Bytes    -= n * sizeof( ListCommand );
+                memmove( Buffer.data(), Buffer.data() + n, Bytes );
+
+            }
+
+            close( Pair[ 0 ] );
+
+        }
+        else
+        {
+            const ListCommand* Cmd;
+            size_t  n;
+            UINT    Error;
+
+            while ( ( Error = Ring.Read( &Cmd, &n ) ) != RingEnded )
+            {
+                if ( Error ) break;
+
+                for ( size_t k = 0; k < n; k++ )
+                {
+                    const ListCommand Expected = RingRecord( Received + k );
+                    Mismatches += Cmd[ k ].Op != Expected.Op || Cmd[ k ].I[ 0 ] != Expected.I[ 0 ] || Cmd[ k ].I[ 1 ] != Expected.I[ 1 ];
+
+                }
+
+                Received += n;
+                Ring.Release( n );
+
+            }
+
+        }
+
+        const bool   Ok      = Reap( Pid ) && Received == Count && !Mismatches;
+        const double Seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count();
+        char Name[ 32 ];
+
+        if ( Socket ) snprintf( Name, sizeof( Name ), "socket, batch %u", 256 );
+        else          snprintf( Name, sizeof( Name ), "ring, batch %u", (UINT) Batch[ b ] );
+
+        printf( "%-18s %8.2f M commands/s  %9.1f ms  %8llu sleeps  %8llu rings  %s\n",
+                Name, Received / Seconds * 1e-6, Seconds * 1e3,
+                (unsigned long long) Ring.Sleeps, (unsigned long long) Ring.Rings, Ok ? "ok" : "LOST OR CORRUPTED" );
+
+    }
+
+    //  The card fed from the ring against the job fed in process
+    const UINT ListSize = 8000;
+    ListJob    Job;
+    JobFileHeader Params;
+    JobDefaults( Params );
+    JobSetup( Params, Job );
+    MakeHatch( Job, 100000 );
+
+    CommandRing Ring;
+
+    if ( Ring.Create( Capacity ) )
+    {
+        printf( "Ring could not be created\n" );
+        return 1;
+
+    }
+
+    const pid_t Pid = fork();
+
+    if ( !Pid )
+    {
+        CommandRing Producer;
+
+        if ( Producer.Attach( dup( Ring.Descriptor() ) ) ) _exit( 1 );
+
+        for ( size_t i = 0; i < Job.size(); i += 1000 )
+        {
+            if ( Producer.Write( Job.data() + i, std::min< size_t >( 1000, Job.size() - i ) ) ) _exit( 1 );
+
+        }
+
+        Producer.Finish();
+        _exit( 0 );
+
+    }
+
+    if ( OpenEmulator( 50e-6 ) )
+    {
+        printf( "Emulator could not be initialized\n" );
+        return 1;
+
+    }
+
+    config_list( ListSize, 0 );
+    printf( "\n" );
+
+    for ( UINT Mode = 0; Mode < 2; Mode++ )
+    {
+        ListFeeder Feeder;
+        Feeder.Pause = RTC5EmuAdvance;
+        Ring.MaxRead = ListSize / 4;
+
+        const auto   Wall = std::chrono::steady_clock::now();
+        const double Sim  = RTC5EmuTime();
+        UINT Error = Feeder.Open( ListSize, 2000 );
+
+        if ( !Error && Mode == 0 ) Error = Feeder.Feed( Job.data(), Job.size() );
+
+        while ( !Error && Mode == 1 && ( Error = RingFeed( Ring, Feeder ) ) == RingTimeout ) Error = 0;
+
+        if ( !Error ) Error = Feeder.Finish();
+
+        if ( Error || ( Mode == 1 && !Reap( Pid ) ) )
+        {
+            printf( "Feeder error %u\n", Error );
+            return 1;
+
+        }
+
+        ReportFeed( Mode == 0 ? "in process" : "from the ring", 0.0,
+                    std::chrono::duration< double >( std::chrono::steady_clock::now() - Wall ).count(),
+                    RTC5EmuTime() - Sim, Feeder );
+
+    }
+
+    printf( "%-22s %llu records read, %llu sleeps, %llu rings\n", "", (unsigned long long) Ring.Records,
+            (unsigned long long) Ring.Sleeps, (unsigned long long) Ring.Rings );
+
+    RTC5EmuClose();
+    return 0;
+
+}
+#endif
+
+int main( int argc, char* argv[] )
+{
+    if ( argc > 1 && !strcmp( argv[ 1 ], "serial" ) ) return BenchSerial( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "slots" ) )  return BenchSlots( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "subs" ) )   return BenchSubs( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "jobs" ) )   return BenchJobs( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "timing" ) ) return BenchTiming( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "wave" ) )   return BenchWave( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "track" ) )  return BenchTrack( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "monitor" ) ) return BenchMonitor( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "head" ) )   return BenchHead( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "tune" ) )   return BenchTune( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "galvo" ) )  return BenchGalvo( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "preview" ) ) return BenchPreview( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "poly" ) )   return BenchPoly( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "sky" ) )    return BenchSky( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "hatch" ) )  return BenchHatch( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "contour" ) ) return BenchContour( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "slice" ) )  return BenchSlice( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "clip" ) )   return BenchClip( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "tile" ) )   return BenchTile( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "conveyor" ) ) return BenchConveyor( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "prepare" ) ) return BenchPrepare( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "arena" ) )  return BenchArena( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "font" ) )   return BenchFont( argc, argv );
+#ifndef _WIN32
+    if ( argc > 1 && !strcmp( argv[ 1 ], "server" ) ) return BenchServer( argc, argv );
+    if ( argc > 1 && !strcmp( argv[ 1 ], "ring" ) )   return BenchRing( argc, argv );
+#endif
+
+    printf( "Usage: HostBench serial | slots | subs | jobs | timing | wave | track | monitor | head | tune | galvo | preview | poly | sky | hatch | contour | slice | clip | tile | conveyor | prepare | arena | font | server | ring\n"
+            "                 [count] [call latency us | pixels]\n" );
+    return 1;
+
+}
@@ -0,0 +1,90 @@
+//  File
+//      HostHeap.cpp
+//
+//  Abstract
+//      Counting operator new and delete of HostBench.
+//      All forms of new and delete are replaced, so every pair runs on
+//      malloc and free, and HeapCalls counts the allocations of the whole
+//      program for HostBench arena.
+//
+//  Comment
+//      The replacements are kept out of HostBench.cpp: inlined there, the
+//      compiler would see free called on the result of operator new and
+//      warn of a mismatched pair.
+//
+//  Necessary Sources
+//      HostHeap.cpp
+//
+//  Environment: Win32, Linux
+
+// System header files
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <new>
+
+std::atomic< uint64_t > HeapCalls( 0 );
+
+void* operator new( size_t Size, const std::nothrow_t& ) noexcept
+{
+    HeapCalls++;
+    return malloc( Size ? Size : 1 );
+
+}
+
+void* operator new( size_t Size )
+{
+    void* p = operator new( Size, std::nothrow );
+    if ( !p ) throw std::bad_alloc();
+    return p;
+
+}
+
+void* operator new[]( size_t Size )
+{
+    return operator new( Size );
+
+}
+
+void* operator new[]( size_t Size, const std::nothrow_t& ) noexcept
+{
+    return operator new( Size, std::nothrow );
+
+}
+
+void operator delete( void* p ) noexcept
+{
+    free( p );
+
+}
+
+void operator delete[]( void* p ) noexcept
+{
+    free( p );
+
+}
+
+void operator delete( void* p, const std::nothrow_t& ) noexcept
+{
+    free( p );
+
+}
+
+void operator delete[]( void* p, const std::nothrow_t& ) noexcept
+{
+    free( p );
+
+}
+
+void operator delete( void* p, size_t ) noexcept
+{
+    free( p );
+
+}
+
+void operator delete[]( void* p, size_t ) noexcept
+{
+    free( p );
+
+}
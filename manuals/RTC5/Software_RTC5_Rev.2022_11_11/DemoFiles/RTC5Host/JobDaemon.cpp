@@ -0,0 +1,124 @@
+//  File
+//      JobDaemon.cpp
+//
+//  Abstract
+//      A console application sharing an RTC5 among several processes.
+//      It initializes the card once like Demo2, acquires it and marks the
+//      jobs JobClients submit on a Unix domain socket (see RTC5Server.h)
+//      until SIGINT or SIGTERM.
+//
+//  Usage
+//      JobDaemon <socket> [card no] [list size] [program file path]
+//      JobDaemon <socket> emulate [list size]
+//          The emulator in real time instead of a card.
+//
+//  Necessary Sources
+//      RTC5Emu.h, RTC5Server.h and the RTC5Host library
+//
+//  Environment: Linux
+
+// System header files
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "RTC5Emu.h"
+#include "RTC5Server.h"
+
+static JobServer Server;
+
+static void Terminate( int )
+{
+    Server.Stop();
+
+}
+
+int main( int argc, char* argv[] )
+{
+    if ( argc < 2 )
+    {
+        printf( "Usage: JobDaemon <socket> [card no] [list size] [program file path]\n"
+                "       JobDaemon <socket> emulate [list size]\n" );
+        return 1;
+
+    }
+
+    const bool Emulate  = argc > 2 && !strcmp( argv[ 2 ], "emulate" );
+    const UINT CardNo   = argc > 2 && !Emulate ? (UINT) atoi( argv[ 2 ] ) : 1;
+    const UINT ListSize = argc > 3 ? (UINT) atoi( argv[ 3 ] ) : 8000;
+
+    if ( Emulate ? RTC5EmuOpen() : RTC5open() )
+    {
+        printf( "Error: %s\n", Emulate ? "emulator could not be opened" : "RTC5DLL not found" );
+        return 1;
+
+    }
+
+    if ( Emulate ) RTC5EmuSetTimeScale( 1.0 );
+
+    UINT ErrorCode = init_rtc5_dll();
+
+    if ( ErrorCode || select_rtc( CardNo ) != CardNo || acquire_rtc( CardNo ) != CardNo )
+    {
+        printf( "No access to card no. %u: Error %u detected\n", CardNo, ErrorCode ? ErrorCode : n_get_last_error( CardNo ) );
+        free_rtc5_dll();
+        Emulate ? RTC5EmuClose() : RTC5close();
+        return 1;
+
+    }
+
+    //  A list of the previous owner might still be running
+    stop_execution();
+
+    ErrorCode = load_program_file( argc > 4 && !Emulate ? argv[ 4 ] : 0 );
+
+    if ( !ErrorCode ) ErrorCode = load_correction_file( 0, 1, 2 );
+
+    if ( ErrorCode )
+    {
+        printf( "Program or correction file loading error: %u\n", ErrorCode );
+        release_rtc( CardNo );
+        free_rtc5_dll();
+        Emulate ? RTC5EmuClose() : RTC5close();
+        return 1;
+
+    }
+
+    select_cor_table( 1, 0 );
+    reset_error( -1 );
+    config_list( ListSize, 0 );
+    set_laser_control( 0 );
+
+    Server.ListSize = ListSize;
+    Server.StartGap = ListSize / 4;
+    ErrorCode = Server.Open( argv[ 1 ] );
+
+    if ( !ErrorCode )
+    {
+        struct sigaction Action;
+        memset( &Action, 0, sizeof( Action ) );
+        Action.sa_handler = Terminate;
+        sigaction( SIGINT, &Action, 0 );
+        sigaction( SIGTERM, &Action, 0 );
+
+        printf( "Card no. %u serving %s\n", CardNo, argv[ 1 ] );
+        ErrorCode = Server.Serve();
+        Server.Close();
+
+        printf( "%llu jobs submitted, %llu done, %llu failed, %llu cancelled, %llu refused, %llu records, %llu connections\n",
+                (unsigned long long) Server.Submitted, (unsigned long long) Server.Done,
+                (unsigned long long) Server.Failed, (unsigned long long) Server.Cancelled,
+                (unsigned long long) Server.Refused, (unsigned long long) Server.Records,
+                (unsigned long long) Server.Connections );
+
+    }
+
+    if ( ErrorCode ) printf( "Server error %u on %s\n", ErrorCode, argv[ 1 ] );
+
+    release_rtc( CardNo );
+    free_rtc5_dll();
+    Emulate ? RTC5EmuClose() : RTC5close();
+    return ErrorCode ? 1 : 0;
+
+}
@@ -0,0 +1,375 @@
+//  File
+//      RTC5Arena.cpp
+//
+//  Abstract
+//      Command buffers without heap allocation while streaming
+//
+//  Comment
+//      Free slabs are chained by Next, in the pool as well as in an
+//      arena, a buffer chains its slabs in the order of its records.
+//
+//  Necessary Sources
+//      RTC5Arena.h, RTC5Feeder.h, RTC5Job.h, RTC5List.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <assert.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "RTC5Arena.h"
+
+//  SlabPool
+
+SlabPool::SlabPool()
+    : Allocations( 0 ), Slabs( 0 ), Free( 0 ), Chain( 0 )
+{
+}
+
+SlabPool::~SlabPool()
+{
+    Trim();
+
+}
+
+//  Take
+//
+//  Description:
+//
+//  Unchains Count free slabs, allocating those the pool is short of. The
+//  heap is called outside the lock.
+//
+
+CommandSlab* SlabPool::Take( UINT Count )
+{
+    CommandSlab* Taken = 0;
+    UINT n = 0;
+
+    {
+        std::lock_guard< std::mutex > Guard( Lock );
+
+        while ( n < Count && Chain )
+        {
+            CommandSlab* s = Chain;
+            Chain   = s->Next;
+            s->Next = Taken;
+            Taken   = s;
+            n++;
+
+        }
+
+        Free    -= n;
+        Slabs   += Count - n;
+        Allocations += Count - n;
+
+    }
+
+    for ( ; n < Count; n++ )
+    {
+        CommandSlab* s = new CommandSlab;
+        s->Next = Taken;
+        Taken   = s;
+
+    }
+
+    return Taken;
+
+}
+
+void SlabPool::Give( CommandSlab* First )
+{
+    if ( !First ) return;
+
+    CommandSlab* Last = First;
+    size_t n = 1;
+
+    for ( ; Last->Next; Last = Last->Next ) n++;
+
+    std::lock_guard< std::mutex > Guard( Lock );
+    Last->Next = Chain;
+    Chain = First;
+    Free += n;
+
+}
+
+void SlabPool::Reserve( size_t Count )
+{
+    for ( size_t i = 0; i < Count; i++ )
+    {
+        CommandSlab* s = new CommandSlab;
+
+        std::lock_guard< std::mutex > Guard( Lock );
+        s->Next = Chain;
+        Chain = s;
+        Free++;
+        Slabs++;
+        Allocations++;
+
+    }
+
+}
+
+void SlabPool::Trim()
+{
+    CommandSlab* Freed;
+
+    {
+        std::lock_guard< std::mutex > Guard( Lock );
+        Freed  = Chain;
+        Chain  = 0;
+        Slabs -= Free;
+        Free   = 0;
+
+    }
+
+    while ( Freed )
+    {
+        CommandSlab* s = Freed;
+        Freed = s->Next;
+        delete s;
+
+    }
+
+}
+
+//  CommandArena
+
+CommandArena::CommandArena( SlabPool& Pool )
+    : Batch( 8 ), Keep( 16 ), PoolCalls( 0 ), p( Pool ), Chain( 0 ), Count( 0 )
+{
+}
+
+CommandArena::~CommandArena()
+{
+    p.Give( Chain );
+
+}
+
+CommandSlab* CommandArena::Take()
+{
+    if ( !Chain )
+    {
+        Chain = p.Take( Batch ? Batch : 1 );
+        Count = Batch ? Batch : 1;
+        PoolCalls++;
+
+    }
+
+    CommandSlab* s = Chain;
+    Chain = s->Next;
+    Count--;
+
+    s->Next  = 0;
+    s->Count = 0;
+    return s;
+
+}
+
+//  Give
+//
+//  Description:
+//
+//  Keeps the slab. Beyond Keep free slabs, Batch of them go back to the
+//  pool, the arena still holds enough for the next figures.
+//
+
+void CommandArena::Give( CommandSlab* Slab )
+{
+    Slab->Next = Chain;
+    Chain = Slab;
+    Count++;
+
+    if ( Count <= Keep || Count <= Batch ) return;
+
+    CommandSlab* Last = Chain;
+    for ( UINT i = 1; i < Batch; i++ ) Last = Last->Next;
+
+    CommandSlab* Given = Chain;
+    Chain = Last->Next;
+    Last->Next = 0;
+    Count -= Batch;
+
+    p.Give( Given );
+    PoolCalls++;
+
+}
+
+//  CommandBuffer
+
+CommandBuffer::CommandBuffer()
+    : a( 0 ), Head( 0 ), Tail( 0 ), Records( 0 )
+{
+}
+
+CommandBuffer::CommandBuffer( CommandArena& Arena )
+    : a( &Arena ), Head( 0 ), Tail( 0 ), Records( 0 )
+{
+}
+
+CommandBuffer::~CommandBuffer()
+{
+    Clear();
+
+}
+
+void CommandBuffer::Use( CommandArena& Arena )
+{
+    a = &Arena;
+
+}
+
+void CommandBuffer::Clear()
+{
+    while ( Head )
+    {
+        CommandSlab* s = Head;
+        Head = s->Next;
+        a->Give( s );
+
+    }
+
+    Tail    = 0;
+    Records = 0;
+
+}
+
+void CommandBuffer::Grow()
+{
+    CommandSlab* s = a->Take();
+
+    if ( Tail ) Tail->Next = s;
+    else Head = s;
+
+    Tail = s;
+
+}
+
+//  Add
+//
+//  Description:
+//
+//  Appends the records slab by slab. A slab is never ended between a text
+//  command and its text records, unless they fill more than a slab.
+//
+
+void CommandBuffer::Add( const ListCommand* Cmd, size_t Count )
+{
+    size_t i = 0;
+
+    while ( i < Count )
+    {
+        if ( !Tail || Tail->Count == SlabRecords ) Grow();
+
+        const size_t Space = SlabRecords - Tail->Count;
+        size_t n = Count - i < Space ? Count - i : Space;
+
+        //  Text records stay with their text command, as in the ListFeeder
+        if ( n < Count - i )
+        {
+            size_t m = n;
+            while ( m && Cmd[ i + m ].Op == OpTextData ) m--;
+
+            if ( m < n && Cmd[ i + m ].Op != OpTextData ) n = m;
+
+            if ( !n && Tail->Count )
+            {
+                Grow();
+                continue;
+
+            }
+
+            if ( !n ) n = Space;
+
+        }
+
+        memcpy( Tail->Cmd + Tail->Count, Cmd + i, n * sizeof( ListCommand ) );
+        Tail->Count += n;
+        Records += n;
+        i += n;
+
+    }
+
+}
+
+void CommandBuffer::AddText( UINT Op, const char* Text )
+{
+    const size_t Length = Text ? strlen( Text ) : 0;
+    ListCommand  Cmd = ListMake( Op );
+    Cmd.Arg = (uint16_t) ( Length > 0xFFFF ? 0xFFFF : Length );
+
+    const size_t Count = 1 + ListTextRecords( Cmd.Arg );
+
+    if ( Count > SlabRecords )
+    {
+        ListJob Job;
+        ListAppendText( Job, Op, Text );
+        Add( Job.data(), Job.size() );
+        return;
+
+    }
+
+    ListCommand* Out = Extend( Count );
+    Out[ 0 ] = Cmd;
+
+    for ( size_t i = 0; i < Cmd.Arg; i += ListTextBytes )
+    {
+        ListCommand& Data = *++Out;
+        const size_t n = Cmd.Arg - i < ListTextBytes ? Cmd.Arg - i : ListTextBytes;
+        Data = ListMake( OpTextData );
+        Data.Arg = (uint16_t) n;
+        memcpy( ListText( Data ), Text + i, n );
+
+    }
+
+}
+
+//  Extend
+//
+//  Description:
+//
+//  Reserves Count records in a row in the last slab, or in a new one when
+//  they do not fit. A row longer than a slab cannot be given, larger
+//  counts go through Add.
+//
+
+ListCommand* CommandBuffer::Extend( size_t Count )
+{
+    assert( Count <= SlabRecords );
+
+    if ( !Tail || SlabRecords - Tail->Count < Count ) Grow();
+
+    ListCommand* Out = Tail->Cmd + Tail->Count;
+    Tail->Count += Count;
+    Records += Count;
+    return Out;
+
+}
+
+UINT CommandBuffer::Feed( ListFeeder& Feeder ) const
+{
+    for ( const CommandSlab* s = Head; s; s = s->Next )
+    {
+        const UINT Error = s->Count ? Feeder.Feed( s->Cmd, s->Count ) : FeedNoError;
+        if ( Error ) return Error;
+
+    }
+
+    return FeedNoError;
+
+}
+
+void CommandBuffer::CopyTo( ListJob& Out ) const
+{
+    for ( const CommandSlab* s = Head; s; s = s->Next ) Out.insert( Out.end(), s->Cmd, s->Cmd + s->Count );
+
+}
+
+//  The records change places, each buffer keeps its arena
+void CommandBuffer::Swap( CommandBuffer& Other )
+{
+    std::swap( Head, Other.Head );
+    std::swap( Tail, Other.Tail );
+    std::swap( Records, Other.Records );
+
+}
@@ -0,0 +1,146 @@
+//  File
+//      RTC5Arena.h
+//
+//  Abstract
+//      Command buffers without heap allocation while streaming.
+//      A program building its list commands figure by figure, polygons,
+//      raster lines or text, into a ListJob per figure allocates and frees
+//      memory for every figure. A CommandBuffer holds its records in slabs
+//      of SlabRecords records instead, which it takes from the
+//      CommandArena of the thread using it and gives back on Clear. Slabs
+//      are recycled, once the pool has grown to the records in flight no
+//      more memory is allocated.
+//
+//  Comment
+//      A SlabPool is shared by the threads and locked, a CommandArena is
+//      owned by one thread and keeps up to Keep free slabs of its own. An
+//      arena takes slabs from the pool and gives them back Batch at a
+//      time, so the pool is locked once per Batch slabs. A buffer filled by
+//      a worker and fed by the writer thread changes its arena by Use, or
+//      its records are swapped into a buffer of the writer.
+//      A text command and its text records are kept in one slab, the
+//      ListFeeder never splits them, texts longer than a slab are split.
+//      Slabs return to the pool when an arena is destroyed and to the heap
+//      by Trim or when the pool is destroyed, which must be after all its
+//      arenas and buffers.
+//
+//  Necessary Sources
+//      RTC5Arena.h, RTC5Arena.cpp, RTC5Feeder.h, RTC5Feeder.cpp, RTC5Job.h,
+//      RTC5Job.cpp, RTC5List.h, RTC5List.cpp, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+
+#include <mutex>
+
+#include "RTC5Feeder.h"
+#include "RTC5List.h"
+
+const size_t SlabRecords          =         1024;   //  32 KiB of records per slab
+
+struct CommandSlab
+{
+    CommandSlab* Next;
+    size_t   Count;                                 //  records used
+    ListCommand Cmd[ SlabRecords ];
+
+};
+
+class SlabPool
+{
+public:
+    SlabPool();
+    ~SlabPool();
+
+    CommandSlab* Take( UINT Count );                //  a chain of Count slabs, allocated as needed
+    void     Give( CommandSlab* Chain );            //  a chain of free slabs
+    void     Reserve( size_t Slabs );               //  allocated ahead, free in the pool
+    void     Trim();                                //  free slabs back to the heap
+
+    //  Results
+    uint64_t Allocations;                           //  slabs allocated from the heap
+    size_t   Slabs;                                 //  allocated, in use or free
+    size_t   Free;                                  //  in the pool, not in arenas
+
+private:
+    SlabPool( const SlabPool& );
+    SlabPool& operator=( const SlabPool& );
+
+    std::mutex Lock;
+    CommandSlab* Chain;
+
+};
+
+class CommandArena
+{
+public:
+    CommandArena( SlabPool& Pool );
+    ~CommandArena();                                //  the free slabs back to the pool
+
+    CommandSlab* Take();
+    void     Give( CommandSlab* Slab );
+
+    //  Settings
+    UINT     Batch;                                 //  slabs taken from and given to the pool at once
+    UINT     Keep;                                  //  free slabs kept before Batch go back to the pool
+
+    //  Results
+    uint64_t PoolCalls;                             //  locks of the pool
+
+private:
+    CommandArena( const CommandArena& );
+    CommandArena& operator=( const CommandArena& );
+
+    SlabPool& p;
+    CommandSlab* Chain;                             //  free slabs of this thread
+    UINT     Count;
+
+};
+
+class CommandBuffer
+{
+public:
+    CommandBuffer();
+    explicit CommandBuffer( CommandArena& Arena );
+    ~CommandBuffer();                               //  clears
+
+    void     Use( CommandArena& Arena );            //  of the thread using the buffer from now on
+    void     Clear();                               //  the slabs back to the arena
+
+    void     Add( const ListCommand& Cmd );
+    void     Add( const ListCommand* Cmd, size_t Count );
+    void     AddText( UINT Op, const char* Text );  //  as ListAppendText
+    ListCommand* Extend( size_t Count );            //  Count records in a row to fill, asserted at most SlabRecords
+
+    UINT     Feed( ListFeeder& Feeder ) const;      //  slab by slab
+    void     CopyTo( ListJob& Out ) const;
+    void     Swap( CommandBuffer& Other );          //  the records, not the arenas
+
+    size_t   Count() const { return Records; }
+    bool     Empty() const { return !Records; }
+    const CommandSlab* First() const { return Head; }
+
+private:
+    CommandBuffer( const CommandBuffer& );
+    CommandBuffer& operator=( const CommandBuffer& );
+
+    void     Grow();
+
+    CommandArena* a;
+    CommandSlab* Head;
+    CommandSlab* Tail;
+    size_t   Records;
+
+};
+
+inline void CommandBuffer::Add( const ListCommand& Cmd )
+{
+    if ( !Tail || Tail->Count == SlabRecords ) Grow();
+
+    Tail->Cmd[ Tail->Count++ ] = Cmd;
+    Records++;
+
+}
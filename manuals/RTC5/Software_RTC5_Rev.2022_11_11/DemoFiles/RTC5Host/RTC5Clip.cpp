@@ -0,0 +1,709 @@
+//  File
+//      RTC5Clip.cpp
+//
+//  Abstract
+//      Clipping of list command streams against the scan field
+//
+//  Comment
+//      The clipper follows two positions: the pen, where the stream would
+//      be, and the card, where the commands written so far leave it. A
+//      jump only moves the pen, it is written as it is while both agree
+//      and the target lies in the field, otherwise when the next command
+//      needs the card at the pen: the next mark writes a jump to where its
+//      visible part starts, any command but a parameter writes a jump to the
+//      pen clamped to the field. A jump to a park position beyond the field
+//      followed by marks within is thus dropped.
+//      A mark cut by a keep-out polygon is split at its crossings with the
+//      edges, a part is dropped if its midpoint lies within by the even-odd
+//      rule. Vectors of a keep-out polygon's edge are marked.
+//
+//  Necessary Sources
+//      RTC5Clip.h, RTC5Feeder.h, RTC5Hatch.h, RTC5List.h, RTC5Util.h,
+//      RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <math.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#include "RTC5Clip.h"
+#include "RTC5Util.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define CLIP_SSE2
+#include <emmintrin.h>
+#endif
+
+static const UINT   MaxArcChords         =         4096;
+
+static double Round( double v )
+{
+    return floor( v + 0.5 );
+
+}
+
+//  Commands that do not depend on the position
+static bool IsParameter( UINT Op )
+{
+    switch ( Op )
+    {
+    case OpNop:
+    case OpSetJumpSpeed:
+    case OpSetMarkSpeed:
+    case OpSetScannerDelays:
+    case OpSetLaserDelays:
+    case OpSetLaserPulses:
+    case OpSetFirstPulseKiller:
+    case OpWriteDaX:
+    case OpSelectCharSet:
+    case OpSelectSerialSet:
+    case OpSetSerialStep:
+    case OpSaveAndRestartTimer:
+    case OpSetExtStartPos:
+    case OpSetControlMode:
+    case OpSetFreeVariable:
+    case OpSetDelayMode:
+    case OpSetSkyWritingPara:
+    case OpSetSkyWritingMode:
+    case OpSetSkyWritingLimit:
+    case OpSetDefocus:
+    case OpTextData:
+        return true;
+
+    default:
+        return false;
+
+    }
+
+}
+
+//  Commands after which the position is not known
+static bool IsOpaque( UINT Op )
+{
+    return ( Op >= OpMarkText && Op <= OpMarkTimeAbs ) || Op == OpSetPixel || Op == OpSetNPixel
+        || Op == OpSubCall || Op == OpSubCallAbs || Op == OpListCall || Op == OpListCallAbs || Op == OpListJumpPos
+        || Op == OpFlyReturn;
+
+}
+
+FieldClipper::FieldClipper()
+    : Tolerance( 0.5 ), Vectorized( true ), Out( 0 )
+{
+    Field[ 0 ] = Field[ 1 ] = -524288;
+    Field[ 2 ] = Field[ 3 ] =  524287;
+
+    Reset();
+
+}
+
+void FieldClipper::Reset()
+{
+    Commands = Inside = Clipped = Split = Removed = Clamped = Arcs = Unchecked = Polygons = Records = 0;
+    FeedError = FeedNoError;
+    Time      = 0.0;
+
+    Known = Pen3D = false;
+    PenX  = PenY  = PenZ  = 0.0;
+    CardX = CardY = CardZ = std::numeric_limits< double >::quiet_NaN();
+
+}
+
+UINT FieldClipper::Check()
+{
+    if ( Field[ 0 ] > Field[ 2 ] || Field[ 1 ] > Field[ 3 ] || !( Tolerance > 0.0 ) ) return ClipRangeError;
+
+    Box[ 0 ] = Box[ 1 ] =  std::numeric_limits< double >::infinity();
+    Box[ 2 ] = Box[ 3 ] = -std::numeric_limits< double >::infinity();
+
+    for ( size_t c = 0; c < KeepOut.size(); c++ )
+    {
+        if ( KeepOut[ c ].size() < 3 ) return ClipRangeError;
+
+        for ( size_t i = 0; i < KeepOut[ c ].size(); i++ )
+        {
+            Box[ 0 ] = std::min( Box[ 0 ], KeepOut[ c ][ i ].X );
+            Box[ 1 ] = std::min( Box[ 1 ], KeepOut[ c ][ i ].Y );
+            Box[ 2 ] = std::max( Box[ 2 ], KeepOut[ c ][ i ].X );
+            Box[ 3 ] = std::max( Box[ 3 ], KeepOut[ c ][ i ].Y );
+
+        }
+
+    }
+
+    return ClipNoError;
+
+}
+
+void FieldClipper::Put( UINT Op, double X, double Y, double Z )
+{
+    CardX = Round( X );
+    CardY = Round( Y );
+
+    ListCommand Cmd = ListMake( Op, (int32_t) CardX, (int32_t) CardY );
+
+    if ( Op == OpJumpAbs3D || Op == OpMarkAbs3D )
+    {
+        CardZ = Round( Z );
+        Cmd.I[ 2 ] = (int32_t) CardZ;
+
+    }
+
+    Out->push_back( Cmd );
+
+}
+
+//  The card to the pen, clamped to the field
+void FieldClipper::Flush()
+{
+    if ( !Known || ( CardX == PenX && CardY == PenY && ( !Pen3D || CardZ == PenZ ) ) ) return;
+
+    const double X = std::min( std::max( PenX, (double) Field[ 0 ] ), (double) Field[ 2 ] );
+    const double Y = std::min( std::max( PenY, (double) Field[ 1 ] ), (double) Field[ 3 ] );
+
+    if ( X != PenX || Y != PenY ) Clamped++;
+
+    if ( X != CardX || Y != CardY || ( Pen3D && CardZ != PenZ ) ) Put( Pen3D ? OpJumpAbs3D : OpJumpAbs, X, Y, PenZ );
+
+}
+
+//  Liang-Barsky: the part T0..T1 of the segment within the field
+bool FieldClipper::Barsky( double X0, double Y0, double X1, double Y1, double& T0, double& T1 ) const
+{
+    const double dx = X1 - X0, dy = Y1 - Y0;
+
+#ifdef CLIP_SSE2
+    if ( Vectorized )
+    {
+        //  Boundaries x min, x max in one register, y min, y max in the other
+        const __m128d px = _mm_set_pd( dx, -dx ), qx = _mm_set_pd( Field[ 2 ] - X0, X0 - Field[ 0 ] );
+        const __m128d py = _mm_set_pd( dy, -dy ), qy = _mm_set_pd( Field[ 3 ] - Y0, Y0 - Field[ 1 ] );
+        const __m128d Zero = _mm_setzero_pd();
+
+        //  Parallel to a boundary beyond it
+        const __m128d Away = _mm_or_pd( _mm_and_pd( _mm_cmpeq_pd( px, Zero ), _mm_cmplt_pd( qx, Zero ) ),
+                                        _mm_and_pd( _mm_cmpeq_pd( py, Zero ), _mm_cmplt_pd( qy, Zero ) ) );
+        if ( _mm_movemask_pd( Away ) ) return false;
+
+        const __m128d rx = _mm_div_pd( qx, px ), ry = _mm_div_pd( qy, py );
+        const __m128d Lo = _mm_set1_pd( 0.0 ), High = _mm_set1_pd( 1.0 );
+
+        //  Entering where p < 0, leaving where p > 0, the others ignored
+        const __m128d ex = _mm_cmplt_pd( px, Zero ), ey = _mm_cmplt_pd( py, Zero );
+        const __m128d lx = _mm_cmpgt_pd( px, Zero ), ly = _mm_cmpgt_pd( py, Zero );
+
+        __m128d Enter = _mm_max_pd( _mm_or_pd( _mm_and_pd( ex, rx ), _mm_andnot_pd( ex, Lo ) ),
+                                    _mm_or_pd( _mm_and_pd( ey, ry ), _mm_andnot_pd( ey, Lo ) ) );
+        __m128d Leave = _mm_min_pd( _mm_or_pd( _mm_and_pd( lx, rx ), _mm_andnot_pd( lx, High ) ),
+                                    _mm_or_pd( _mm_and_pd( ly, ry ), _mm_andnot_pd( ly, High ) ) );
+
+        Enter = _mm_max_sd( Enter, _mm_unpackhi_pd( Enter, Enter ) );
+        Leave = _mm_min_sd( Leave, _mm_unpackhi_pd( Leave, Leave ) );
+
+        T0 = _mm_cvtsd_f64( Enter );
+        T1 = _mm_cvtsd_f64( Leave );
+        return T0 <= T1;
+
+    }
+#endif
+
+    const double p[ 4 ] = { -dx, dx, -dy, dy };
+    const double q[ 4 ] = { X0 - Field[ 0 ], Field[ 2 ] - X0, Y0 - Field[ 1 ], Field[ 3 ] - Y0 };
+
+    T0 = 0.0;
+    T1 = 1.0;
+
+    for ( UINT i = 0; i < 4; i++ )
+    {
+        if ( p[ i ] == 0.0 )
+        {
+            if ( q[ i ] < 0.0 ) return false;
+            continue;
+
+        }
+
+        const double r = q[ i ] / p[ i ];
+
+        if ( p[ i ] < 0.0 ) T0 = std::max( T0, r );
+        else                T1 = std::min( T1, r );
+
+    }
+
+    return T0 <= T1;
+
+}
+
+bool FieldClipper::InKeepOut( double X, double Y ) const
+{
+    bool In = false;
+
+    for ( size_t c = 0; c < KeepOut.size(); c++ )
+    {
+        const HatchContour& k = KeepOut[ c ];
+
+        for ( size_t i = 0, j = k.size() - 1; i < k.size(); j = i++ )
+        {
+            if ( ( k[ i ].Y > Y ) != ( k[ j ].Y > Y )
+                 && X < k[ i ].X + ( Y - k[ i ].Y ) * ( k[ j ].X - k[ i ].X ) / ( k[ j ].Y - k[ i ].Y ) ) In = !In;
+
+        }
+
+    }
+
+    return In;
+
+}
+
+//  The parts of T0..T1 outside the keep-out polygons into Pieces
+void FieldClipper::Cut( double X0, double Y0, double X1, double Y1, double T0, double T1 )
+{
+    const double dx = X1 - X0, dy = Y1 - Y0;
+    std::vector< double >& t = Pieces;
+
+    t.clear();
+    t.push_back( T0 );
+
+    for ( size_t c = 0; c < KeepOut.size(); c++ )
+    {
+        const HatchContour& k = KeepOut[ c ];
+
+        for ( size_t i = 0, j = k.size() - 1; i < k.size(); j = i++ )
+        {
+            const double ex = k[ i ].X - k[ j ].X, ey = k[ i ].Y - k[ j ].Y;
+            const double d  = dx * ey - dy * ex;
+            if ( d == 0.0 ) continue;
+
+            const double wx = k[ j ].X - X0, wy = k[ j ].Y - Y0;
+            const double s  = ( wx * ey - wy * ex ) / d;
+            const double u  = ( wx * dy - wy * dx ) / d;
+
+            if ( s > T0 && s < T1 && u >= 0.0 && u <= 1.0 ) t.push_back( s );
+
+        }
+
+    }
+
+    t.push_back( T1 );
+    std::sort( t.begin() + 1, t.end() - 1 );
+
+    //  Parts outside as pairs, neighbours joined
+    size_t n = 0;
+
+    for ( size_t i = 0; i + 1 < t.size(); i++ )
+    {
+        const double m = 0.5 * ( t[ i ] + t[ i + 1 ] );
+        if ( InKeepOut( X0 + m * dx, Y0 + m * dy ) ) continue;
+
+        if ( n && t[ n - 1 ] == t[ i ] ) t[ n - 1 ] = t[ i + 1 ];
+        else
+        {
+            const double a = t[ i ], b = t[ i + 1 ];
+            t[ n++ ] = a;
+            t[ n++ ] = b;
+
+        }
+
+    }
+
+    t.resize( n );
+
+}
+
+//  A vector from the pen, Original is written unchanged if nothing is cut
+void FieldClipper::Mark( double X, double Y, double Z, bool Is3D, const ListCommand* Original )
+{
+    if ( !Known )
+    {
+        const bool Visible = X >= Field[ 0 ] && X <= Field[ 2 ] && Y >= Field[ 1 ] && Y <= Field[ 3 ] && !InKeepOut( X, Y );
+
+        if ( Visible ) Out->push_back( *Original );
+
+        if ( Visible ) Unchecked++;
+        else           Removed++;
+
+        Known = true;
+        Pen3D = Is3D;
+        PenX  = CardX = X;
+        PenY  = CardY = Y;
+        PenZ  = CardZ = Z;
+
+        if ( !Visible ) CardX = std::numeric_limits< double >::quiet_NaN();
+        return;
+
+    }
+
+    const double X0 = PenX, Y0 = PenY, Z0 = PenZ;
+    double T0, T1;
+
+    Pieces.clear();
+
+    if ( Barsky( X0, Y0, X, Y, T0, T1 ) )
+    {
+        if (   KeepOut.empty() || std::max( X0, X ) < Box[ 0 ] || std::min( X0, X ) > Box[ 2 ]
+            || std::max( Y0, Y ) < Box[ 1 ] || std::min( Y0, Y ) > Box[ 3 ] )
+        {
+            Pieces.push_back( T0 );
+            Pieces.push_back( T1 );
+
+        }
+        else Cut( X0, Y0, X, Y, T0, T1 );
+
+    }
+
+    if ( Pieces.size() == 2 && Pieces[ 0 ] == 0.0 && Pieces[ 1 ] == 1.0 && Original )
+    {
+        //  The pen is in the field, so the card reaches it unclamped
+        Flush();
+        Out->push_back( *Original );
+        Inside++;
+
+        Pen3D = Is3D;
+        PenX  = CardX = X;
+        PenY  = CardY = Y;
+        PenZ  = CardZ = Z;
+        return;
+
+    }
+
+    Pen3D = Is3D;
+    PenX  = X;
+    PenY  = Y;
+    PenZ  = Z;
+
+    if ( Original )
+    {
+        if ( Pieces.empty() ) Removed++;
+        else                  Clipped++;
+
+        if ( Pieces.size() > 2 || ( !Pieces.empty() && ( Pieces[ 0 ] != T0 || Pieces.back() != T1 ) ) ) Split++;
+
+    }
+
+    for ( size_t i = 0; i + 1 < Pieces.size(); i += 2 )
+    {
+        const double a = Pieces[ i ], b = Pieces[ i + 1 ];
+        const double sx = Round( X0 + a * ( X - X0 ) ), sy = Round( Y0 + a * ( Y - Y0 ) ), sz = Z0 + a * ( Z - Z0 );
+        const double ex = Round( X0 + b * ( X - X0 ) ), ey = Round( Y0 + b * ( Y - Y0 ) ), ez = Z0 + b * ( Z - Z0 );
+
+        if ( sx == ex && sy == ey ) continue;
+
+        if ( sx != CardX || sy != CardY || ( Is3D && Round( sz ) != CardZ ) ) Put( Is3D ? OpJumpAbs3D : OpJumpAbs, sx, sy, sz );
+        Put( Is3D ? OpMarkAbs3D : OpMarkAbs, ex, ey, ez );
+
+    }
+
+}
+
+//  Written unchanged if the circle lies in the field and apart from the
+//  keep-out box, otherwise as chords
+void FieldClipper::Arc( double CenterX, double CenterY, double Angle, const ListCommand& Original )
+{
+    const double vX = PenX - CenterX, vY = PenY - CenterY, r = sqrt( vX * vX + vY * vY );
+    const double a  = Angle * Pi / 180.0;
+
+    const bool InField = CenterX - r >= Field[ 0 ] && CenterX + r <= Field[ 2 ] && CenterY - r >= Field[ 1 ] && CenterY + r <= Field[ 3 ];
+    const bool Apart   = KeepOut.empty() || CenterX + r < Box[ 0 ] || CenterX - r > Box[ 2 ] || CenterY + r < Box[ 1 ] || CenterY - r > Box[ 3 ];
+
+    if ( InField && Apart )
+    {
+        Flush();
+        Out->push_back( Original );
+        Inside++;
+
+        PenX = CardX = CenterX + vX * cos( a ) + vY * sin( a );
+        PenY = CardY = CenterY + vY * cos( a ) - vX * sin( a );
+        return;
+
+    }
+
+    const double Step = r > Tolerance ? 2.0 * acos( 1.0 - Tolerance / r ) : Pi;
+    const UINT   n    = (UINT) std::min( (double) MaxArcChords, std::max( 1.0, ceil( fabs( a ) / Step ) ) );
+
+    for ( UINT k = 1; k <= n; k++ )
+    {
+        const double b = a * k / n;
+        Mark( CenterX + vX * cos( b ) + vY * sin( b ), CenterY + vY * cos( b ) - vX * sin( b ), PenZ, false, 0 );
+
+    }
+
+    Arcs++;
+
+}
+
+void FieldClipper::Run( const ListCommand* Cmd, size_t Count )
+{
+    const size_t Begin = Out->size();
+    Out->reserve( Begin + Count );
+
+#ifdef CLIP_SSE2
+    const __m128d FieldLo = _mm_set_pd( Field[ 1 ], Field[ 0 ] ), FieldHi = _mm_set_pd( Field[ 3 ], Field[ 2 ] );
+    const __m128d BoxLo   = _mm_set_pd( Box[ 1 ], Box[ 0 ] ),     BoxHi   = _mm_set_pd( Box[ 3 ], Box[ 2 ] );
+#endif
+
+    for ( size_t i = 0; i < Count; i++ )
+    {
+        const ListCommand& c = Cmd[ i ];
+
+        //  Trivial accept: the card at the pen, the target in the field and
+        //  a mark apart from the keep-out box
+        const bool Vector = c.Op == OpMarkAbs || c.Op == OpJumpAbs || c.Op == OpMarkRel || c.Op == OpJumpRel;
+
+        if ( Vector && Known && CardX == PenX && CardY == PenY )
+        {
+            const bool Rel     = c.Op == OpMarkRel || c.Op == OpJumpRel;
+            const bool IsMark  = c.Op == OpMarkAbs || c.Op == OpMarkRel;
+            const bool Shadows = IsMark && !KeepOut.empty();
+            double x, y;
+            bool   Accept;
+
+#ifdef CLIP_SSE2
+            if ( Vectorized )
+            {
+                const __m128d q = _mm_set_pd( PenY, PenX );
+                __m128d p = _mm_cvtepi32_pd( _mm_loadl_epi64( (const __m128i*) c.I ) );
+                if ( Rel ) p = _mm_add_pd( p, q );
+
+                Accept = !_mm_movemask_pd( _mm_or_pd( _mm_cmplt_pd( p, FieldLo ), _mm_cmpgt_pd( p, FieldHi ) ) );
+
+                if ( Accept && Shadows )
+                {
+                    Accept = _mm_movemask_pd( _mm_or_pd( _mm_cmplt_pd( _mm_max_pd( p, q ), BoxLo ),
+                                                         _mm_cmpgt_pd( _mm_min_pd( p, q ), BoxHi ) ) ) != 0;
+
+                }
+
+                _mm_storel_pd( &x, p );
+                _mm_storeh_pd( &y, p );
+
+            }
+            else
+#endif
+            {
+                x = Rel ? PenX + c.I[ 0 ] : c.I[ 0 ];
+                y = Rel ? PenY + c.I[ 1 ] : c.I[ 1 ];
+                Accept = x >= Field[ 0 ] && x <= Field[ 2 ] && y >= Field[ 1 ] && y <= Field[ 3 ];
+
+                if ( Accept && Shadows )
+                {
+                    Accept = std::max( x, PenX ) < Box[ 0 ] || std::min( x, PenX ) > Box[ 2 ]
+                          || std::max( y, PenY ) < Box[ 1 ] || std::min( y, PenY ) > Box[ 3 ];
+
+                }
+
+            }
+
+            if ( Accept )
+            {
+                Out->push_back( c );
+                PenX  = CardX = x;
+                PenY  = CardY = y;
+                Pen3D = false;
+                if ( IsMark ) Inside++;
+                continue;
+
+            }
+
+        }
+
+        switch ( c.Op )
+        {
+        case OpJumpAbs:
+        case OpJumpRel:
+        case OpJumpAbs3D:
+        {
+            if ( c.Op == OpJumpRel && !Known )
+            {
+                Out->push_back( c );
+                Unchecked++;
+                break;
+
+            }
+
+            const bool Synced = Known && CardX == PenX && CardY == PenY && ( !Pen3D || CardZ == PenZ );
+
+            PenX  = c.Op == OpJumpRel ? PenX + c.I[ 0 ] : c.I[ 0 ];
+            PenY  = c.Op == OpJumpRel ? PenY + c.I[ 1 ] : c.I[ 1 ];
+            PenZ  = c.Op == OpJumpAbs3D ? c.I[ 2 ] : PenZ;
+            Pen3D = c.Op == OpJumpAbs3D;
+            Known = true;
+
+            //  Deferred unless it may be written as it is
+            if ( Synced && PenX >= Field[ 0 ] && PenX <= Field[ 2 ] && PenY >= Field[ 1 ] && PenY <= Field[ 3 ] )
+            {
+                Out->push_back( c );
+                CardX = PenX;
+                CardY = PenY;
+                CardZ = PenZ;
+
+            }
+
+            break;
+
+        }
+
+        case OpMarkAbs:     Mark( c.I[ 0 ], c.I[ 1 ], PenZ, false, &c );                  break;
+        case OpMarkAbs3D:   Mark( c.I[ 0 ], c.I[ 1 ], c.I[ 2 ], true, &c );               break;
+
+        case OpMarkRel:
+            if ( Known ) Mark( PenX + c.I[ 0 ], PenY + c.I[ 1 ], PenZ, false, &c );
+            else
+            {
+                Out->push_back( c );
+                Unchecked++;
+
+            }
+
+            break;
+
+        case OpArcAbs:
+        case OpArcRel:
+            if ( Known ) Arc( c.Op == OpArcRel ? PenX + c.I[ 0 ] : c.I[ 0 ], c.Op == OpArcRel ? PenY + c.I[ 1 ] : c.I[ 1 ], c.D[ 0 ], c );
+            else
+            {
+                Out->push_back( c );
+                Unchecked++;
+
+            }
+
+            break;
+
+        default:
+            if ( !IsParameter( c.Op ) ) Flush();
+
+            Out->push_back( c );
+
+            if ( IsOpaque( c.Op ) )
+            {
+                Known = false;
+                CardX = std::numeric_limits< double >::quiet_NaN();
+
+            }
+
+            break;
+
+        }
+
+    }
+
+    Commands += Count;
+    Records  += Out->size() - Begin;
+
+}
+
+//  Clip
+//
+//  Description:
+//
+//  Clips Count commands of the stream and appends them to Out, or feeds
+//  them to the ListFeeder. The position carries over from the last call,
+//  so a stream may be clipped in chunks.
+//
+//      Return                  Meaning
+//
+//      ClipNoError             clipped
+//      ClipRangeError          empty field, tolerance not positive or a
+//                              keep-out contour of less than 3 points
+//      ClipFeedError           the ListFeeder failed with FeedError
+//
+
+UINT FieldClipper::Clip( const ListCommand* Cmd, size_t Count, ListJob& Out_ )
+{
+    if ( Check() ) return ClipRangeError;
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    Out = &Out_;
+    Run( Cmd, Count );
+    Out = 0;
+
+    Time += Seconds( t0 );
+    return ClipNoError;
+
+}
+
+UINT FieldClipper::Clip( const ListCommand* Cmd, size_t Count, ListFeeder& Feeder )
+{
+    if ( Check() ) return ClipRangeError;
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    Buffer.clear();
+    Out = &Buffer;
+    Run( Cmd, Count );
+    Out = 0;
+
+    Time += Seconds( t0 );
+
+    if ( !Buffer.empty() ) FeedError = Feeder.Feed( Buffer.data(), Buffer.size() );
+
+    return FeedError ? ClipFeedError : ClipNoError;
+
+}
+
+//  ClipRegion
+//
+//  Description:
+//
+//  Clips the contours of In to the field by Sutherland-Hodgman, a contour
+//  along the border keeps the edges on it. The keep-out polygons are not
+//  applied, see ContourEngine::Difference.
+//
+//      Return      ClipNoError or ClipRangeError
+//
+
+UINT FieldClipper::ClipRegion( const HatchRegion& In, HatchRegion& Out_ )
+{
+    if ( Check() ) return ClipRangeError;
+
+    HatchRegion Result;
+    HatchContour a, b;
+
+    for ( size_t c = 0; c < In.size(); c++ )
+    {
+        a = In[ c ];
+        bool Cut = false;
+
+        for ( UINT Edge = 0; Edge < 4 && !a.empty(); Edge++ )
+        {
+            //  Edge 0: x >= XMin, 1: y >= YMin, 2: x <= XMax, 3: y <= YMax
+            const UINT   Axis  = Edge & 1;
+            const double Limit = Field[ Edge ], Sign = Edge < 2 ? 1.0 : -1.0;
+
+            auto Value = [ Axis ]( const HatchPoint& p ) { return Axis ? p.Y : p.X; };
+
+            b.clear();
+
+            for ( size_t i = 0; i < a.size(); i++ )
+            {
+                const HatchPoint& p = a[ i ];
+                const HatchPoint& q = a[ ( i + 1 ) % a.size() ];
+                const double dp = Sign * ( Value( p ) - Limit ), dq = Sign * ( Value( q ) - Limit );
+
+                if ( dp >= 0.0 ) b.push_back( p );
+                else             Cut = true;
+
+                if ( ( dp >= 0.0 ) != ( dq >= 0.0 ) )
+                {
+                    const double t = dp / ( dp - dq );
+                    const HatchPoint s = { p.X + t * ( q.X - p.X ), p.Y + t * ( q.Y - p.Y ) };
+                    b.push_back( s );
+
+                }
+
+            }
+
+            a.swap( b );
+
+        }
+
+        if ( Cut ) Polygons++;
+        if ( a.size() >= 3 ) Result.push_back( a );
+
+    }
+
+    Out_.swap( Result );
+    return ClipNoError;
+
+}
@@ -0,0 +1,103 @@
+//  File
+//      RTC5Clip.h
+//
+//  Abstract
+//      Clipping of list command streams against the scan field.
+//      A FieldClipper sits in the stream between the generation of a job
+//      and the ListFeeder or the list. Marks are cut at the field rectangle
+//      and at the keep-out polygons, jumps to positions beyond the field are
+//      dropped or, where the position matters, clamped to its border, so the
+//      card neither clips silently nor trips range_checking. It counts what
+//      it changed. ClipRegion clips the contours of an area to the field
+//      before it is hatched.
+//
+//  Comment
+//      Segments are clipped by Liang-Barsky, two boundaries at a time with
+//      SSE2 where available, after a trivial accept of vectors within the
+//      field and apart from the keep-out box. Arcs reaching beyond are
+//      replaced by chords. Contours are clipped by Sutherland-Hodgman, the
+//      keep-out of an area is ContourEngine::Difference.
+//      The clipper works in list coordinates, before set_offset_list and
+//      set_matrix_list. Text, pixel lines, fly_return and calls of
+//      subroutines or lists are passed unchanged, the position after them
+//      is unknown until the next absolute vector, relative vectors in
+//      between are passed unchecked.
+//      A stream not changed by clipping is passed record by record.
+//
+//  Necessary Sources
+//      RTC5Clip.h, RTC5Clip.cpp, RTC5Feeder.h, RTC5Feeder.cpp, RTC5Hatch.h,
+//      RTC5List.h, RTC5List.cpp, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "RTC5Feeder.h"
+#include "RTC5Hatch.h"
+#include "RTC5List.h"
+
+//  Error codes of the clipper
+const UINT   ClipNoError          =            0;
+const UINT   ClipRangeError       =            1;   //  empty field, keep-out contour of less than 3 points
+const UINT   ClipFeedError        =            2;   //  ListFeeder error, see FieldClipper::FeedError
+
+class FieldClipper
+{
+public:
+    FieldClipper();
+
+    void     Reset();                               //  a new stream, position unknown, results cleared
+
+    UINT     Clip( const ListCommand* Cmd, size_t Count, ListJob& Out );
+    UINT     Clip( const ListCommand* Cmd, size_t Count, ListFeeder& Feeder );
+    UINT     ClipRegion( const HatchRegion& In, HatchRegion& Out );
+
+    //  Settings
+    LONG     Field[ 4 ];                            //  [bits] XMin, YMin, XMax, YMax, inclusive
+    std::vector< HatchContour > KeepOut;            //  [bits] not marked, even-odd
+    double   Tolerance;                             //  [bits] of the chords of clipped arcs
+    bool     Vectorized;                            //  false: scalar loops, for comparison
+
+    //  Results, summed since Reset
+    uint64_t Commands;                              //  in
+    uint64_t Inside;                                //  vectors passed
+    uint64_t Clipped;                               //  vectors shortened or split
+    uint64_t Split;                                 //  of them split by a keep-out polygon
+    uint64_t Removed;                               //  vectors dropped
+    uint64_t Clamped;                               //  jumps moved to the border of the field
+    uint64_t Arcs;                                  //  replaced by chords
+    uint64_t Unchecked;                             //  vectors at an unknown position
+    uint64_t Polygons;                              //  contours of ClipRegion cut or dropped
+    uint64_t Records;                               //  out
+    UINT     FeedError;                             //  of the ListFeeder with ClipFeedError
+    double   Time;                                  //  [s] wall clock in Clip
+
+private:
+    FieldClipper( const FieldClipper& );
+    FieldClipper& operator=( const FieldClipper& );
+
+    UINT     Check();
+    void     Run( const ListCommand* Cmd, size_t Count );
+    void     Flush();
+    void     Mark( double X, double Y, double Z, bool Is3D, const ListCommand* Original );
+    void     Arc( double CenterX, double CenterY, double Angle, const ListCommand& Original );
+    bool     Barsky( double X0, double Y0, double X1, double Y1, double& T0, double& T1 ) const;
+    void     Cut( double X0, double Y0, double X1, double Y1, double T0, double T1 );
+    bool     InKeepOut( double X, double Y ) const;
+    void     Put( UINT Op, double X, double Y, double Z );
+
+    ListJob* Out;
+    ListJob  Buffer;
+    std::vector< double > Pieces;                   //  t from, to of the parts marked
+
+    double   Box[ 4 ];                              //  of the keep-out polygons
+    bool     Known;                                 //  pen position
+    bool     Pen3D;                                 //  last vector was 3D
+    double   PenX, PenY, PenZ;                      //  of the stream
+    double   CardX, CardY, CardZ;                   //  of the commands written
+
+};
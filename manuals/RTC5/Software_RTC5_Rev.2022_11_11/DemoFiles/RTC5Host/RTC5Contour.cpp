@@ -0,0 +1,1266 @@
+//  File
+//      RTC5Contour.cpp
+//
+//  Abstract
+//      Offsets and boolean operations of contours
+//
+//  Comment
+//      A ContourGraph resolves a set of closed grid polygons of two
+//      operands:
+//      1.  Split: the edges are swept by their lowest point, every pair
+//          whose boxes overlap is tested by exact orientations. Edges are
+//          split at touching vertices, at the ends of collinear overlaps
+//          and at crossings rounded to the grid. Rounding may make a piece
+//          cross another edge, so the sweep is repeated until no edge is
+//          split. Cuts still found after MaxPasses splits are left and
+//          counted as Unresolved, the operation returns ContourUnresolved.
+//      2.  Merge: the edges are turned upwards, identical ones are merged
+//          by adding their windings.
+//      3.  Classify: a sweep over the distinct y of the vertices sorts the
+//          edges crossing every slab by their x at the middle of the slab,
+//          by exact products of 128 bits, and sums the windings from the
+//          right. An edge is classified in its first slab, a horizontal
+//          one by the windings just below and above its midpoint.
+//      4.  Link: the kept edges, inside on their left, are joined into
+//          loops taking the leftmost turn at every vertex, compared by
+//          exact cross and dot products, so regions touching at a vertex
+//          stay separate loops.
+//      Grid coordinates stay below 2^26, the orientations below 2^56 and
+//      the numerators of the slab sort below 2^57.
+//
+//  Necessary Sources
+//      RTC5Contour.h, RTC5Hatch.h, RTC5List.h, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include "RTC5Contour.h"
+#include "RTC5Util.h"
+
+static const double Unit                 =          8.0;   //  grid points per bit
+static const double MaxBits              =    8388608.0;   //  [bits] 2^23
+static const UINT   MaxPasses            =            8;   //  of the split
+static const UINT   MaxArcSteps          =         1024;
+
+typedef int64_t Coord;
+
+struct GridPoint
+{
+    Coord    X, Y;
+
+};
+
+typedef std::vector< GridPoint > GridLoop;
+
+//  The inside of two operands, each by even-odd or by a positive winding
+struct ContourRule
+{
+    bool     EvenOdd[ 2 ];
+    bool     Subtract;          //  first and not second, else first or second
+
+    bool     Inside( const int* w ) const
+    {
+        const bool a = EvenOdd[ 0 ] ? ( w[ 0 ] & 1 ) != 0 : w[ 0 ] > 0;
+        const bool b = EvenOdd[ 1 ] ? ( w[ 1 ] & 1 ) != 0 : w[ 1 ] > 0;
+        return Subtract ? a && !b : a || b;
+
+    }
+
+};
+
+//  > 0 if c lies left of a -> b
+static Coord Orient( Coord ax, Coord ay, Coord bx, Coord by, Coord cx, Coord cy )
+{
+    return ( bx - ax ) * ( cy - ay ) - ( by - ay ) * ( cx - ax );
+
+}
+
+//  Rank of the turn from u to v: right, straight on, left, back
+static int TurnClass( Coord ux, Coord uy, Coord vx, Coord vy )
+{
+    const Coord Cross = ux * vy - uy * vx, Dot = ux * vx + uy * vy;
+
+    return Cross < 0 ? 0 : Cross > 0 ? 2 : Dot > 0 ? 1 : 3;
+
+}
+
+//  Whether coming along u, turning to v is further left than turning to w,
+//  exact, the angles of the turns in ( -180, 180 ] deg
+static bool TurnsLeftOf( Coord ux, Coord uy, Coord vx, Coord vy, Coord wx, Coord wy )
+{
+    const int a = TurnClass( ux, uy, vx, vy ), b = TurnClass( ux, uy, wx, wy );
+
+    if ( a != b ) return a > b;
+
+    //  Within the same half plane v lies left of w
+    return a != 1 && a != 3 && wx * vy - wy * vx > 0;
+
+}
+
+//  |a| * |b| as 128 bits
+static void Product( uint64_t a, uint64_t b, uint64_t& Hi, uint64_t& Lo )
+{
+    const uint64_t a0 = a & 0xffffffffu, a1 = a >> 32, b0 = b & 0xffffffffu, b1 = b >> 32;
+    const uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    const uint64_t Mid = ( p00 >> 32 ) + ( p01 & 0xffffffffu ) + ( p10 & 0xffffffffu );
+
+    Lo = ( p00 & 0xffffffffu ) | ( Mid << 32 );
+    Hi = p11 + ( p01 >> 32 ) + ( p10 >> 32 ) + ( Mid >> 32 );
+
+}
+
+//  Sign of a b - c d, exact
+static int CompareProducts( int64_t a, int64_t b, int64_t c, int64_t d )
+{
+    const int s = ( a > 0 && b > 0 ) || ( a < 0 && b < 0 ) ? 1 : a && b ? -1 : 0;
+    const int t = ( c > 0 && d > 0 ) || ( c < 0 && d < 0 ) ? 1 : c && d ? -1 : 0;
+
+    if ( s != t ) return s > t ? 1 : -1;
+    if ( !s ) return 0;
+
+    uint64_t H0, L0, H1, L1;
+    Product( a < 0 ? 0 - (uint64_t) a : (uint64_t) a, b < 0 ? 0 - (uint64_t) b : (uint64_t) b, H0, L0 );
+    Product( c < 0 ? 0 - (uint64_t) c : (uint64_t) c, d < 0 ? 0 - (uint64_t) d : (uint64_t) d, H1, L1 );
+
+    const int m = H0 != H1 ? ( H0 > H1 ? 1 : -1 ) : L0 != L1 ? ( L0 > L1 ? 1 : -1 ) : 0;
+    return s * m;
+
+}
+
+//  ContourGraph
+//
+//  The edges of the polygons of two operands and their resolution
+
+class ContourGraph
+{
+public:
+    ContourGraph();
+
+    void     Add( const HatchContour& c, UINT Operand );    //  [bits]
+    void     Add( const GridLoop& c, UINT Operand );
+    void     Resolve( const ContourRule& Rule, std::vector< GridLoop >& Loops );
+
+    uint64_t Edges, Splits, Unresolved;
+
+private:
+    ContourGraph& operator=( const ContourGraph& );
+
+    struct Segment
+    {
+        Coord  X0, Y0, X1, Y1;
+        int    W[ 2 ];          //  windings of the operands along 0 -> 1
+
+    };
+
+    struct Cut
+    {
+        size_t Seg;
+        Coord  X, Y;
+        Coord  Along;           //  projection on the segment, the order of the cuts
+
+    };
+
+    struct Edge
+    {
+        Coord  AX, AY, BX, BY;
+
+    };
+
+    void     Intersect( size_t i, size_t j, std::vector< Cut >& Cuts ) const;
+    void     AddCut( size_t i, Coord X, Coord Y, std::vector< Cut >& Cuts ) const;
+    void     Split();
+    void     Merge();
+    void     Classify( const ContourRule& Rule, std::vector< Edge >& Kept ) const;
+    void     Link( const std::vector< Edge >& Kept, std::vector< GridLoop >& Loops ) const;
+
+    std::vector< Segment > Segs;
+
+};
+
+ContourGraph::ContourGraph()
+    : Edges( 0 ), Splits( 0 ), Unresolved( 0 )
+{
+}
+
+void ContourGraph::Add( const GridLoop& c, UINT Operand )
+{
+    if ( c.size() < 3 ) return;
+
+    for ( size_t i = 0; i < c.size(); i++ )
+    {
+        const GridPoint& p = c[ i ];
+        const GridPoint& q = c[ ( i + 1 ) % c.size() ];
+        if ( p.X == q.X && p.Y == q.Y ) continue;
+
+        Segment s = { p.X, p.Y, q.X, q.Y, { 0, 0 } };
+        s.W[ Operand ] = 1;
+        Segs.push_back( s );
+
+    }
+
+}
+
+void ContourGraph::Add( const HatchContour& c, UINT Operand )
+{
+    GridLoop g( c.size() );
+
+    for ( size_t i = 0; i < c.size(); i++ )
+    {
+        g[ i ].X = (Coord) floor( c[ i ].X * Unit + 0.5 );
+        g[ i ].Y = (Coord) floor( c[ i ].Y * Unit + 0.5 );
+
+    }
+
+    Add( g, Operand );
+
+}
+
+//  Cuts segment i at X, Y if it lies between its ends
+void ContourGraph::AddCut( size_t i, Coord X, Coord Y, std::vector< Cut >& Cuts ) const
+{
+    const Segment& s = Segs[ i ];
+    const Coord Along = ( X - s.X0 ) * ( s.X1 - s.X0 ) + ( Y - s.Y0 ) * ( s.Y1 - s.Y0 );
+    const Coord Back  = ( X - s.X1 ) * ( s.X0 - s.X1 ) + ( Y - s.Y1 ) * ( s.Y0 - s.Y1 );
+
+    if ( Along <= 0 || Back <= 0 ) return;
+
+    const Cut c = { i, X, Y, Along };
+    Cuts.push_back( c );
+
+}
+
+void ContourGraph::Intersect( size_t i, size_t j, std::vector< Cut >& Cuts ) const
+{
+    const Segment& a = Segs[ i ];
+    const Segment& b = Segs[ j ];
+
+    const Coord d1 = Orient( a.X0, a.Y0, a.X1, a.Y1, b.X0, b.Y0 );
+    const Coord d2 = Orient( a.X0, a.Y0, a.X1, a.Y1, b.X1, b.Y1 );
+
+    if ( ( d1 > 0 && d2 > 0 ) || ( d1 < 0 && d2 < 0 ) ) return;
+
+    const Coord d3 = Orient( b.X0, b.Y0, b.X1, b.Y1, a.X0, a.Y0 );
+    const Coord d4 = Orient( b.X0, b.Y0, b.X1, b.Y1, a.X1, a.Y1 );
+
+    if ( ( d3 > 0 && d4 > 0 ) || ( d3 < 0 && d4 < 0 ) ) return;
+
+    //  Touching or collinear: vertices on the other segment
+    if ( !d1 || !d2 || !d3 || !d4 )
+    {
+        if ( !d1 ) AddCut( i, b.X0, b.Y0, Cuts );
+        if ( !d2 ) AddCut( i, b.X1, b.Y1, Cuts );
+        if ( !d3 ) AddCut( j, a.X0, a.Y0, Cuts );
+        if ( !d4 ) AddCut( j, a.X1, a.Y1, Cuts );
+        return;
+
+    }
+
+    const double t = (double) d3 / ( (double) d3 - (double) d4 );
+    const Coord  X = (Coord) floor( a.X0 + t * ( a.X1 - a.X0 ) + 0.5 );
+    const Coord  Y = (Coord) floor( a.Y0 + t * ( a.Y1 - a.Y0 ) + 0.5 );
+
+    AddCut( i, X, Y, Cuts );
+    AddCut( j, X, Y, Cuts );
+
+}
+
+void ContourGraph::Split()
+{
+    std::vector< size_t > Order, Active;
+    std::vector< Cut > Cuts;
+
+    for ( UINT Pass = 0; ; Pass++ )
+    {
+        Order.resize( Segs.size() );
+        for ( size_t i = 0; i < Order.size(); i++ ) Order[ i ] = i;
+
+        std::sort( Order.begin(), Order.end(), [ this ]( size_t a, size_t b )
+        {
+            return std::min( Segs[ a ].Y0, Segs[ a ].Y1 ) < std::min( Segs[ b ].Y0, Segs[ b ].Y1 );
+
+        } );
+
+        Active.clear();
+        Cuts.clear();
+
+        for ( size_t k = 0; k < Order.size(); k++ )
+        {
+            const Segment& s = Segs[ Order[ k ] ];
+            const Coord Low = std::min( s.Y0, s.Y1 );
+            const Coord x0  = std::min( s.X0, s.X1 ), x1 = std::max( s.X0, s.X1 );
+            size_t m = 0;
+
+            for ( size_t j = 0; j < Active.size(); j++ )
+            {
+                const Segment& t = Segs[ Active[ j ] ];
+                if ( std::max( t.Y0, t.Y1 ) < Low ) continue;
+
+                Active[ m++ ] = Active[ j ];
+                if ( std::max( t.X0, t.X1 ) >= x0 && std::min( t.X0, t.X1 ) <= x1 ) Intersect( Order[ k ], Active[ j ], Cuts );
+
+            }
+
+            Active.resize( m );
+            Active.push_back( Order[ k ] );
+
+        }
+
+        if ( Cuts.empty() ) return;
+
+        //  Still crossing after MaxPasses, left as they are and counted
+        if ( Pass == MaxPasses )
+        {
+            Unresolved += Cuts.size();
+            return;
+
+        }
+
+        std::sort( Cuts.begin(), Cuts.end(), []( const Cut& a, const Cut& b )
+        {
+            return a.Seg != b.Seg ? a.Seg < b.Seg : a.Along < b.Along;
+
+        } );
+
+        std::vector< Segment > Next;
+        Next.reserve( Segs.size() + Cuts.size() );
+        size_t c = 0;
+
+        for ( size_t i = 0; i < Segs.size(); i++ )
+        {
+            Segment s = Segs[ i ];
+            const Coord X1 = s.X1, Y1 = s.Y1;
+
+            for ( ; c < Cuts.size() && Cuts[ c ].Seg == i; c++ )
+            {
+                if ( Cuts[ c ].X == s.X0 && Cuts[ c ].Y == s.Y0 ) continue;
+
+                s.X1 = Cuts[ c ].X;
+                s.Y1 = Cuts[ c ].Y;
+                Next.push_back( s );
+                s.X0 = s.X1;
+                s.Y0 = s.Y1;
+                Splits++;
+
+            }
+
+            s.X1 = X1;
+            s.Y1 = Y1;
+            Next.push_back( s );
+
+        }
+
+        Segs.swap( Next );
+
+    }
+
+}
+
+void ContourGraph::Merge()
+{
+    for ( size_t i = 0; i < Segs.size(); i++ )
+    {
+        Segment& s = Segs[ i ];
+        if ( s.Y0 < s.Y1 || ( s.Y0 == s.Y1 && s.X0 < s.X1 ) ) continue;
+
+        std::swap( s.X0, s.X1 );
+        std::swap( s.Y0, s.Y1 );
+        s.W[ 0 ] = -s.W[ 0 ];
+        s.W[ 1 ] = -s.W[ 1 ];
+
+    }
+
+    std::sort( Segs.begin(), Segs.end(), []( const Segment& a, const Segment& b )
+    {
+        if ( a.Y0 != b.Y0 ) return a.Y0 < b.Y0;
+        if ( a.X0 != b.X0 ) return a.X0 < b.X0;
+        if ( a.Y1 != b.Y1 ) return a.Y1 < b.Y1;
+        return a.X1 < b.X1;
+
+    } );
+
+    size_t n = 0;
+
+    for ( size_t i = 0; i < Segs.size(); i++ )
+    {
+        const Segment& s = Segs[ i ];
+
+        if ( n && Segs[ n - 1 ].X0 == s.X0 && Segs[ n - 1 ].Y0 == s.Y0 && Segs[ n - 1 ].X1 == s.X1 && Segs[ n - 1 ].Y1 == s.Y1 )
+        {
+            Segs[ n - 1 ].W[ 0 ] += s.W[ 0 ];
+            Segs[ n - 1 ].W[ 1 ] += s.W[ 1 ];
+
+        }
+        else
+        {
+            if ( n && !Segs[ n - 1 ].W[ 0 ] && !Segs[ n - 1 ].W[ 1 ] ) n--;
+            Segs[ n++ ] = s;
+
+        }
+
+    }
+
+    if ( n && !Segs[ n - 1 ].W[ 0 ] && !Segs[ n - 1 ].W[ 1 ] ) n--;
+    Segs.resize( n );
+
+}
+
+void ContourGraph::Classify( const ContourRule& Rule, std::vector< Edge >& Kept ) const
+{
+    std::vector< Coord > Ys;
+    Ys.reserve( 2 * Segs.size() );
+
+    for ( size_t i = 0; i < Segs.size(); i++ )
+    {
+        Ys.push_back( Segs[ i ].Y0 );
+        Ys.push_back( Segs[ i ].Y1 );
+
+    }
+
+    std::sort( Ys.begin(), Ys.end() );
+    Ys.erase( std::unique( Ys.begin(), Ys.end() ), Ys.end() );
+
+    struct Key
+    {
+        int64_t N, D;           //  x at the middle of the slab = N / D
+        size_t  Seg;
+
+    };
+
+    std::vector< size_t > Active, Above;
+    std::vector< Key > Keys;
+    size_t Next = 0;
+
+    for ( size_t e = 0; e < Ys.size(); e++ )
+    {
+        const Coord y = Ys[ e ];
+        const size_t First = Next;
+
+        Above.clear();
+
+        for ( size_t j = 0; j < Active.size(); j++ ) if ( Segs[ Active[ j ] ].Y1 > y ) Above.push_back( Active[ j ] );
+
+        for ( ; Next < Segs.size() && Segs[ Next ].Y0 == y; Next++ ) if ( Segs[ Next ].Y1 > y ) Above.push_back( Next );
+
+        //  Horizontal edges by the windings right of their midpoint, below and above
+        for ( size_t h = First; h < Next; h++ )
+        {
+            const Segment& s = Segs[ h ];
+            if ( s.Y1 != y ) continue;
+
+            int w[ 2 ][ 2 ] = { { 0, 0 }, { 0, 0 } };
+
+            for ( UINT Side = 0; Side < 2; Side++ )
+            {
+                const std::vector< size_t >& Set = Side ? Above : Active;
+
+                for ( size_t j = 0; j < Set.size(); j++ )
+                {
+                    const Segment& t = Segs[ Set[ j ] ];
+                    const Coord dy = t.Y1 - t.Y0, dx = t.X1 - t.X0;
+
+                    if ( 2 * ( t.X0 * dy + ( y - t.Y0 ) * dx ) > ( s.X0 + s.X1 ) * dy )
+                    {
+                        w[ Side ][ 0 ] += t.W[ 0 ];
+                        w[ Side ][ 1 ] += t.W[ 1 ];
+
+                    }
+
+                }
+
+            }
+
+            const bool Below = Rule.Inside( w[ 0 ] ), Top = Rule.Inside( w[ 1 ] );
+            if ( Below == Top ) continue;
+
+            const Edge k = { Top ? s.X0 : s.X1, y, Top ? s.X1 : s.X0, y };
+            Kept.push_back( k );
+
+        }
+
+        Active.swap( Above );
+
+        if ( e + 1 == Ys.size() || Active.empty() ) continue;
+
+        //  Slab up to the next y, sorted by x at its middle
+        const Coord Sum = y + Ys[ e + 1 ];
+        Keys.resize( Active.size() );
+
+        for ( size_t j = 0; j < Active.size(); j++ )
+        {
+            const Segment& t = Segs[ Active[ j ] ];
+            const Coord dy = t.Y1 - t.Y0;
+
+            Keys[ j ].N   = 2 * t.X0 * dy + ( Sum - 2 * t.Y0 ) * ( t.X1 - t.X0 );
+            Keys[ j ].D   = 2 * dy;
+            Keys[ j ].Seg = Active[ j ];
+
+        }
+
+        std::sort( Keys.begin(), Keys.end(), []( const Key& a, const Key& b )
+        {
+            return CompareProducts( a.N, b.D, b.N, a.D ) < 0;
+
+        } );
+
+        int w[ 2 ] = { 0, 0 };
+
+        for ( size_t j = Keys.size(); j-- > 0; )
+        {
+            const Segment& t = Segs[ Keys[ j ].Seg ];
+            const bool Right = Rule.Inside( w );
+
+            w[ 0 ] += t.W[ 0 ];
+            w[ 1 ] += t.W[ 1 ];
+
+            if ( t.Y0 != y ) continue;
+
+            const bool Left = Rule.Inside( w );
+            if ( Left == Right ) continue;
+
+            //  Upwards if the inside lies on the left
+            const Edge k = { Left ? t.X0 : t.X1, Left ? t.Y0 : t.Y1, Left ? t.X1 : t.X0, Left ? t.Y1 : t.Y0 };
+            Kept.push_back( k );
+
+        }
+
+    }
+
+}
+
+void ContourGraph::Link( const std::vector< Edge >& Kept, std::vector< GridLoop >& Loops ) const
+{
+    std::vector< size_t > Order( Kept.size() );
+    for ( size_t i = 0; i < Order.size(); i++ ) Order[ i ] = i;
+
+    auto Less = [ &Kept ]( size_t a, size_t b )
+    {
+        return Kept[ a ].AX != Kept[ b ].AX ? Kept[ a ].AX < Kept[ b ].AX : Kept[ a ].AY < Kept[ b ].AY;
+
+    };
+
+    std::sort( Order.begin(), Order.end(), Less );
+
+    std::vector< uint8_t > Used( Kept.size(), 0 );
+    GridLoop Loop;
+
+    for ( size_t s = 0; s < Kept.size(); s++ )
+    {
+        if ( Used[ s ] ) continue;
+
+        Loop.clear();
+        size_t Cur = s;
+        bool Closed = false;
+
+        for ( ;; )
+        {
+            const Edge& c = Kept[ Cur ];
+            const GridPoint p = { c.AX, c.AY };
+            Loop.push_back( p );
+            Used[ Cur ] = 1;
+
+            //  Out edges of the end, the leftmost turn wins
+            size_t Lo = 0, Hi = Order.size();
+
+            while ( Lo < Hi )
+            {
+                const size_t m = ( Lo + Hi ) / 2;
+                const Edge& e = Kept[ Order[ m ] ];
+
+                if ( e.AX < c.BX || ( e.AX == c.BX && e.AY < c.BY ) ) Lo = m + 1;
+                else Hi = m;
+
+            }
+
+            size_t Best = Kept.size();
+            const Coord ux = c.BX - c.AX, uy = c.BY - c.AY;
+
+            for ( size_t m = Lo; m < Order.size() && Kept[ Order[ m ] ].AX == c.BX && Kept[ Order[ m ] ].AY == c.BY; m++ )
+            {
+                const size_t i = Order[ m ];
+                if ( Used[ i ] && i != s ) continue;
+
+                const Edge& e = Kept[ i ];
+
+                if ( Best == Kept.size() || TurnsLeftOf( ux, uy, e.BX - e.AX, e.BY - e.AY,
+                                                         Kept[ Best ].BX - Kept[ Best ].AX, Kept[ Best ].BY - Kept[ Best ].AY ) )
+                {
+                    Best = i;
+
+                }
+
+            }
+
+            if ( Best == Kept.size() ) break;
+
+            if ( Best == s )
+            {
+                Closed = true;
+                break;
+
+            }
+
+            Cur = Best;
+
+        }
+
+        if ( !Closed ) continue;
+
+        //  Collinear points dropped
+        GridLoop Out;
+
+        for ( size_t i = 0; i < Loop.size(); i++ )
+        {
+            const GridPoint& p = Loop[ i ];
+
+            while ( Out.size() >= 2 && !Orient( Out[ Out.size() - 2 ].X, Out[ Out.size() - 2 ].Y, Out.back().X, Out.back().Y, p.X, p.Y ) )
+            {
+                Out.pop_back();
+
+            }
+
+            Out.push_back( p );
+
+        }
+
+        while ( Out.size() >= 3 && !Orient( Out[ Out.size() - 2 ].X, Out[ Out.size() - 2 ].Y, Out.back().X, Out.back().Y, Out[ 0 ].X, Out[ 0 ].Y ) )
+        {
+            Out.pop_back();
+
+        }
+
+        while ( Out.size() >= 3 && !Orient( Out.back().X, Out.back().Y, Out[ 0 ].X, Out[ 0 ].Y, Out[ 1 ].X, Out[ 1 ].Y ) )
+        {
+            Out.erase( Out.begin() );
+
+        }
+
+        if ( Out.size() >= 3 ) Loops.push_back( Out );
+
+    }
+
+}
+
+void ContourGraph::Resolve( const ContourRule& Rule, std::vector< GridLoop >& Loops )
+{
+    Loops.clear();
+
+    Split();
+    Merge();
+    Edges += Segs.size();
+
+    std::vector< Edge > Kept;
+    Classify( Rule, Kept );
+    Link( Kept, Loops );
+
+}
+
+//  Twice the signed area [grid^2], > 0 counterclockwise
+static double Area( const GridLoop& l )
+{
+    double a = 0.0;
+
+    for ( size_t i = 0; i < l.size(); i++ )
+    {
+        const GridPoint& p = l[ i ];
+        const GridPoint& q = l[ ( i + 1 ) % l.size() ];
+        a += (double) p.X * q.Y - (double) q.X * p.Y;
+
+    }
+
+    return a;
+
+}
+
+//  Twice x, y in the loop by the even-odd rule
+static bool Contains( const GridLoop& l, Coord x, Coord y )
+{
+    bool In = false;
+
+    for ( size_t i = 0, j = l.size() - 1; i < l.size(); j = i++ )
+    {
+        const Coord yi = 2 * l[ i ].Y, yj = 2 * l[ j ].Y;
+        if ( ( yi > y ) == ( yj > y ) ) continue;
+
+        //  x < x of the edge at y
+        const Coord xi = 2 * l[ i ].X, xj = 2 * l[ j ].X;
+        if ( ( ( x - xi ) * ( yj - yi ) < ( xj - xi ) * ( y - yi ) ) == ( yj > yi ) ) In = !In;
+
+    }
+
+    return In;
+
+}
+
+//  Regions of one outer loop and the holes within it, in bits
+static void Assemble( const std::vector< GridLoop >& Loops, std::vector< HatchRegion >& Out )
+{
+    std::vector< double > Areas( Loops.size() );
+    std::vector< size_t > Owner( Loops.size() );
+
+    for ( size_t i = 0; i < Loops.size(); i++ ) Areas[ i ] = Area( Loops[ i ] );
+
+    for ( size_t i = 0; i < Loops.size(); i++ )
+    {
+        Owner[ i ] = i;
+        if ( Areas[ i ] > 0.0 ) continue;
+
+        //  The smallest outer loop around the midpoint of the first edge
+        const Coord x = Loops[ i ][ 0 ].X + Loops[ i ][ 1 ].X, y = Loops[ i ][ 0 ].Y + Loops[ i ][ 1 ].Y;
+        double Best = 0.0;
+
+        for ( size_t j = 0; j < Loops.size(); j++ )
+        {
+            if ( Areas[ j ] <= 0.0 || Areas[ j ] < -Areas[ i ] || ( Owner[ i ] != i && Areas[ j ] >= Best ) ) continue;
+
+            if ( Contains( Loops[ j ], x, y ) )
+            {
+                Owner[ i ] = j;
+                Best = Areas[ j ];
+
+            }
+
+        }
+
+    }
+
+    std::vector< size_t > Index( Loops.size(), (size_t) -1 );
+
+    for ( UINT Pass = 0; Pass < 2; Pass++ )
+    {
+        for ( size_t i = 0; i < Loops.size(); i++ )
+        {
+            //  Outer loops first, then the holes
+            if ( ( Owner[ i ] == i ) != ( Pass == 0 ) ) continue;
+
+            HatchContour c( Loops[ i ].size() );
+
+            for ( size_t k = 0; k < c.size(); k++ )
+            {
+                c[ k ].X = Loops[ i ][ k ].X / Unit;
+                c[ k ].Y = Loops[ i ][ k ].Y / Unit;
+
+            }
+
+            if ( Pass == 0 )
+            {
+                Index[ i ] = Out.size();
+                Out.push_back( HatchRegion( 1, c ) );
+
+            }
+            else Out[ Index[ Owner[ i ] ] ].push_back( c );
+
+        }
+
+    }
+
+}
+
+//  The offset of a loop before its union: edges moved by d to their right,
+//  arcs around the corners turning away from that side, the vertex itself
+//  at the others
+static void OffsetLoop( const GridLoop& l, double d, double Step, GridLoop& Raw )
+{
+    const size_t n = l.size();
+    Raw.clear();
+
+    auto Put = [ &Raw ]( double x, double y )
+    {
+        const GridPoint p = { (Coord) floor( x + 0.5 ), (Coord) floor( y + 0.5 ) };
+        Raw.push_back( p );
+
+    };
+
+    for ( size_t i = 0; i < n; i++ )
+    {
+        const GridPoint& a = l[ ( i + n - 1 ) % n ];
+        const GridPoint& p = l[ i ];
+        const GridPoint& b = l[ ( i + 1 ) % n ];
+
+        const double ux = (double) ( p.X - a.X ), uy = (double) ( p.Y - a.Y ), lu = hypot( ux, uy );
+        const double vx = (double) ( b.X - p.X ), vy = (double) ( b.Y - p.Y ), lv = hypot( vx, vy );
+        const double n1x = uy / lu, n1y = -ux / lu, n2x = vy / lv, n2y = -vx / lv;
+        const Coord  Turn = Orient( a.X, a.Y, p.X, p.Y, b.X, b.Y );
+
+        if ( ( d > 0.0 && Turn > 0 ) || ( d < 0.0 && Turn < 0 ) )
+        {
+            const double Angle = atan2( ux * vy - uy * vx, ux * vx + uy * vy );
+            const UINT   m = (UINT) std::min( (double) MaxArcSteps, std::max( 1.0, ceil( fabs( Angle ) / Step ) ) );
+
+            for ( UINT k = 0; k <= m; k++ )
+            {
+                const double c = cos( Angle * k / m ), s = sin( Angle * k / m );
+                Put( p.X + d * ( n1x * c - n1y * s ), p.Y + d * ( n1x * s + n1y * c ) );
+
+            }
+
+        }
+        else
+        {
+            Put( p.X + d * n1x, p.Y + d * n1y );
+            if ( Turn ) Raw.push_back( p );
+            if ( Turn ) Put( p.X + d * n2x, p.Y + d * n2y );
+
+        }
+
+    }
+
+}
+
+static void Extend( const GridLoop& l, Coord* Box )
+{
+    for ( size_t k = 0; k < l.size(); k++ )
+    {
+        Box[ 0 ] = std::min( Box[ 0 ], l[ k ].X );
+        Box[ 1 ] = std::min( Box[ 1 ], l[ k ].Y );
+        Box[ 2 ] = std::max( Box[ 2 ], l[ k ].X );
+        Box[ 3 ] = std::max( Box[ 3 ], l[ k ].Y );
+
+    }
+
+}
+
+static void Bounds( const std::vector< GridLoop >& Loops, Coord* Box )
+{
+    Box[ 0 ] = Box[ 1 ] = INT64_MAX;
+    Box[ 2 ] = Box[ 3 ] = INT64_MIN;
+
+    for ( size_t i = 0; i < Loops.size(); i++ ) Extend( Loops[ i ], Box );
+
+}
+
+static bool Overlap( const Coord* a, const Coord* b )
+{
+    return a[ 0 ] <= b[ 2 ] && b[ 0 ] <= a[ 2 ] && a[ 1 ] <= b[ 3 ] && b[ 1 ] <= a[ 3 ];
+
+}
+
+ContourEngine::ContourEngine()
+    : Tolerance( 0.5 ), Threads( 0 ), Edges( 0 ), Splits( 0 ), Unresolved( 0 ), Contours( 0 ), Time( 0.0 )
+{
+}
+
+UINT ContourEngine::Check( const std::vector< HatchRegion >& In ) const
+{
+    if ( !( Tolerance > 0.0 ) ) return ContourRangeError;
+
+    for ( size_t r = 0; r < In.size(); r++ )
+    {
+        for ( size_t c = 0; c < In[ r ].size(); c++ )
+        {
+            for ( size_t i = 0; i < In[ r ][ c ].size(); i++ )
+            {
+                const HatchPoint& p = In[ r ][ c ][ i ];
+                if ( !( fabs( p.X ) <= MaxBits && fabs( p.Y ) <= MaxBits ) ) return ContourRangeError;
+
+            }
+
+        }
+
+    }
+
+    return ContourNoError;
+
+}
+
+//  The regions of In as loops by the even-odd rule, one per thread at a time
+static void Normalize( const std::vector< HatchRegion >& In, UINT n, std::vector< std::vector< GridLoop > >& Loops,
+                       uint64_t& Edges, uint64_t& Splits, uint64_t& Unresolved )
+{
+    const ContourRule EvenOdd = { { true, true }, false };
+    std::atomic< size_t > Next( 0 );
+    std::mutex Lock;
+
+    Loops.assign( In.size(), std::vector< GridLoop >() );
+
+    Parallel( n, [ & ]( UINT )
+    {
+        uint64_t e = 0, s = 0, u = 0;
+
+        for ( size_t k; ( k = Next++ ) < In.size(); )
+        {
+            ContourGraph g;
+            for ( size_t c = 0; c < In[ k ].size(); c++ ) g.Add( In[ k ][ c ], 0 );
+
+            g.Resolve( EvenOdd, Loops[ k ] );
+            e += g.Edges;
+            s += g.Splits;
+            u += g.Unresolved;
+
+        }
+
+        std::lock_guard< std::mutex > Guard( Lock );
+        Edges  += e;
+        Splits += s;
+        Unresolved += u;
+
+    } );
+
+}
+
+//  Offset
+//
+//  Description:
+//
+//  Offsets every region of In by Distance, a region shrunk to nothing is
+//  dropped, one split by a narrow neck gives several. The regions are
+//  offset on their own, Union merges those grown into each other.
+//
+//      Return                  Meaning
+//
+//      ContourNoError          Out holds the regions
+//      ContourRangeError       Tolerance not positive or points out of range
+//      ContourUnresolved       Out holds the regions, edges still crossing
+//                              after the split, see Unresolved
+//
+
+UINT ContourEngine::Offset( const std::vector< HatchRegion >& In, double Distance, std::vector< HatchRegion >& Out )
+{
+    const auto t0 = std::chrono::steady_clock::now();
+
+    Edges = Splits = Unresolved = Contours = 0;
+    Time  = 0.0;
+
+    if ( Check( In ) || !( fabs( Distance ) <= MaxBits ) ) return ContourRangeError;
+
+    const UINT   n    = std::max( 1u, Threads ? Threads : std::thread::hardware_concurrency() );
+    const double d    = Distance * Unit;
+    const double Step = fabs( d ) > Tolerance * Unit ? 2.0 * acos( 1.0 - Tolerance * Unit / fabs( d ) ) : Pi / 2.0;
+    const ContourRule Positive = { { false, false }, false };
+
+    std::vector< std::vector< GridLoop > > Loops;
+    Normalize( In, n, Loops, Edges, Splits, Unresolved );
+
+    std::vector< std::vector< HatchRegion > > Parts( In.size() );
+    std::atomic< size_t > Next( 0 );
+    std::mutex Lock;
+
+    Parallel( n, [ & ]( UINT )
+    {
+        uint64_t e = 0, s = 0, u = 0;
+        GridLoop Raw;
+        std::vector< GridLoop > Result;
+
+        for ( size_t k; ( k = Next++ ) < In.size(); )
+        {
+            if ( Distance == 0.0 )
+            {
+                Assemble( Loops[ k ], Parts[ k ] );
+                continue;
+
+            }
+
+            ContourGraph g;
+
+            for ( size_t c = 0; c < Loops[ k ].size(); c++ )
+            {
+                const GridLoop& l = Loops[ k ][ c ];
+                Coord b[ 4 ] = { INT64_MAX, INT64_MAX, INT64_MIN, INT64_MIN };
+                Extend( l, b );
+
+                //  Moved inwards by more than half its width, nothing is left
+                if ( ( Area( l ) > 0.0 ) != ( d > 0.0 ) && std::min( b[ 2 ] - b[ 0 ], b[ 3 ] - b[ 1 ] ) < 2.0 * fabs( d ) ) continue;
+
+                OffsetLoop( l, d, Step, Raw );
+                g.Add( Raw, 0 );
+
+            }
+
+            g.Resolve( Positive, Result );
+            Assemble( Result, Parts[ k ] );
+            e += g.Edges;
+            s += g.Splits;
+            u += g.Unresolved;
+
+        }
+
+        std::lock_guard< std::mutex > Guard( Lock );
+        Edges  += e;
+        Splits += s;
+        Unresolved += u;
+
+    } );
+
+    std::vector< HatchRegion > Result;
+
+    for ( size_t k = 0; k < Parts.size(); k++ )
+    {
+        for ( size_t r = 0; r < Parts[ k ].size(); r++ )
+        {
+            Contours += Parts[ k ][ r ].size();
+            Result.push_back( HatchRegion() );
+            Result.back().swap( Parts[ k ][ r ] );
+
+        }
+
+    }
+
+    Out.swap( Result );
+    Time = Seconds( t0 );
+    return Unresolved ? ContourUnresolved : ContourNoError;
+
+}
+
+//  Union
+//
+//  Description:
+//
+//  Merges the regions of In whose bounding boxes overlap, by groups of
+//  overlapping boxes in parallel. A point is inside if it is inside any
+//  region.
+//
+
+UINT ContourEngine::Union( const std::vector< HatchRegion >& In, std::vector< HatchRegion >& Out )
+{
+    const auto t0 = std::chrono::steady_clock::now();
+
+    Edges = Splits = Unresolved = Contours = 0;
+    Time  = 0.0;
+
+    if ( Check( In ) ) return ContourRangeError;
+
+    const UINT n = std::max( 1u, Threads ? Threads : std::thread::hardware_concurrency() );
+    const ContourRule Positive = { { false, false }, false };
+
+    std::vector< std::vector< GridLoop > > Loops;
+    Normalize( In, n, Loops, Edges, Splits, Unresolved );
+
+    //  Groups of overlapping boxes, swept by their left side
+    std::vector< Coord > Box( 4 * In.size() );
+    std::vector< size_t > Order( In.size() ), Root( In.size() );
+
+    for ( size_t k = 0; k < In.size(); k++ )
+    {
+        Bounds( Loops[ k ], &Box[ 4 * k ] );
+        Order[ k ] = Root[ k ] = k;
+
+    }
+
+    std::sort( Order.begin(), Order.end(), [ &Box ]( size_t a, size_t b ) { return Box[ 4 * a ] < Box[ 4 * b ]; } );
+
+    auto Find = [ &Root ]( size_t k )
+    {
+        while ( Root[ k ] != k ) k = Root[ k ] = Root[ Root[ k ] ];
+        return k;
+
+    };
+
+    for ( size_t i = 0; i < Order.size(); i++ )
+    {
+        for ( size_t j = i + 1; j < Order.size() && Box[ 4 * Order[ j ] ] <= Box[ 4 * Order[ i ] + 2 ]; j++ )
+        {
+            if ( !Overlap( &Box[ 4 * Order[ i ] ], &Box[ 4 * Order[ j ] ] ) ) continue;
+
+            const size_t a = Find( Order[ i ] ), b = Find( Order[ j ] );
+            Root[ std::max( a, b ) ] = std::min( a, b );
+
+        }
+
+    }
+
+    //  Members of every group, in the order of their first region
+    std::vector< std::vector< size_t > > Groups;
+    std::vector< size_t > GroupOf( In.size() );
+
+    for ( size_t k = 0; k < In.size(); k++ )
+    {
+        const size_t r = Find( k );
+
+        if ( r == k )
+        {
+            GroupOf[ k ] = Groups.size();
+            Groups.push_back( std::vector< size_t >() );
+
+        }
+
+        Groups[ GroupOf[ r ] ].push_back( k );
+
+    }
+
+    std::vector< std::vector< HatchRegion > > Parts( Groups.size() );
+    std::atomic< size_t > Next( 0 );
+    std::mutex Lock;
+
+    Parallel( n, [ & ]( UINT )
+    {
+        uint64_t e = 0, s = 0, u = 0;
+        std::vector< GridLoop > Result;
+
+        for ( size_t k; ( k = Next++ ) < Groups.size(); )
+        {
+            if ( Groups[ k ].size() == 1 )
+            {
+                Assemble( Loops[ Groups[ k ][ 0 ] ], Parts[ k ] );
+                continue;
+
+            }
+
+            ContourGraph g;
+
+            for ( size_t m = 0; m < Groups[ k ].size(); m++ )
+            {
+                const std::vector< GridLoop >& l = Loops[ Groups[ k ][ m ] ];
+                for ( size_t c = 0; c < l.size(); c++ ) g.Add( l[ c ], 0 );
+
+            }
+
+            g.Resolve( Positive, Result );
+            Assemble( Result, Parts[ k ] );
+            e += g.Edges;
+            s += g.Splits;
+            u += g.Unresolved;
+
+        }
+
+        std::lock_guard< std::mutex > Guard( Lock );
+        Edges  += e;
+        Splits += s;
+        Unresolved += u;
+
+    } );
+
+    std::vector< HatchRegion > Result;
+
+    for ( size_t k = 0; k < Parts.size(); k++ )
+    {
+        for ( size_t r = 0; r < Parts[ k ].size(); r++ )
+        {
+            Contours += Parts[ k ][ r ].size();
+            Result.push_back( HatchRegion() );
+            Result.back().swap( Parts[ k ][ r ] );
+
+        }
+
+    }
+
+    Out.swap( Result );
+    Time = Seconds( t0 );
+    return Unresolved ? ContourUnresolved : ContourNoError;
+
+}
+
+//  Difference
+//
+//  Description:
+//
+//  Subtracts the regions of Cut from every region of In, in parallel over
+//  the regions of In. A point is inside if it is inside a region of In
+//  and not inside any region of Cut.
+//
+
+UINT ContourEngine::Difference( const std::vector< HatchRegion >& In, const std::vector< HatchRegion >& Cut,
+                                std::vector< HatchRegion >& Out )
+{
+    const auto t0 = std::chrono::steady_clock::now();
+
+    Edges = Splits = Unresolved = Contours = 0;
+    Time  = 0.0;
+
+    if ( Check( In ) || Check( Cut ) ) return ContourRangeError;
+
+    const UINT n = std::max( 1u, Threads ? Threads : std::thread::hardware_concurrency() );
+    const ContourRule Rule = { { false, false }, true };
+
+    std::vector< std::vector< GridLoop > > Loops, Cuts;
+    Normalize( In, n, Loops, Edges, Splits, Unresolved );
+    Normalize( Cut, n, Cuts, Edges, Splits, Unresolved );
+
+    std::vector< Coord > Box( 4 * Cut.size() );
+    for ( size_t k = 0; k < Cut.size(); k++ ) Bounds( Cuts[ k ], &Box[ 4 * k ] );
+
+    std::vector< std::vector< HatchRegion > > Parts( In.size() );
+    std::atomic< size_t > Next( 0 );
+    std::mutex Lock;
+
+    Parallel( n, [ & ]( UINT )
+    {
+        uint64_t e = 0, s = 0, u = 0;
+        std::vector< GridLoop > Result;
+
+        for ( size_t k; ( k = Next++ ) < In.size(); )
+        {
+            Coord b[ 4 ];
+            Bounds( Loops[ k ], b );
+
+            ContourGraph g;
+            bool Cutting = false;
+
+            for ( size_t m = 0; m < Cut.size(); m++ )
+            {
+                if ( Cuts[ m ].empty() || !Overlap( b, &Box[ 4 * m ] ) ) continue;
+
+                for ( size_t c = 0; c < Cuts[ m ].size(); c++ ) g.Add( Cuts[ m ][ c ], 1 );
+                Cutting = true;
+
+            }
+
+            if ( !Cutting )
+            {
+                Assemble( Loops[ k ], Parts[ k ] );
+                continue;
+
+            }
+
+            for ( size_t c = 0; c < Loops[ k ].size(); c++ ) g.Add( Loops[ k ][ c ], 0 );
+
+            g.Resolve( Rule, Result );
+            Assemble( Result, Parts[ k ] );
+            e += g.Edges;
+            s += g.Splits;
+            u += g.Unresolved;
+
+        }
+
+        std::lock_guard< std::mutex > Guard( Lock );
+        Edges  += e;
+        Splits += s;
+        Unresolved += u;
+
+    } );
+
+    std::vector< HatchRegion > Result;
+
+    for ( size_t k = 0; k < Parts.size(); k++ )
+    {
+        for ( size_t r = 0; r < Parts[ k ].size(); r++ )
+        {
+            Contours += Parts[ k ][ r ].size();
+            Result.push_back( HatchRegion() );
+            Result.back().swap( Parts[ k ][ r ] );
+
+        }
+
+    }
+
+    Out.swap( Result );
+    Time = Seconds( t0 );
+    return Unresolved ? ContourUnresolved : ContourNoError;
+
+}
+
+void ContourMarks( const std::vector< HatchRegion >& In, ListJob& Out )
+{
+    for ( size_t r = 0; r < In.size(); r++ )
+    {
+        for ( size_t c = 0; c < In[ r ].size(); c++ )
+        {
+            const HatchContour& k = In[ r ][ c ];
+
+            for ( size_t i = 0; i <= k.size() && k.size() > 1; i++ )
+            {
+                const HatchPoint& p = k[ i % k.size() ];
+                Out.push_back( ListMake( i ? OpMarkAbs : OpJumpAbs, (LONG) floor( p.X + 0.5 ), (LONG) floor( p.Y + 0.5 ) ) );
+
+            }
+
+        }
+
+    }
+
+}
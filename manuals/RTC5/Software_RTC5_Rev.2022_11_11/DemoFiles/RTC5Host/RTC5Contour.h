@@ -0,0 +1,79 @@
+//  File
+//      RTC5Contour.h
+//
+//  Abstract
+//      Offsets and boolean operations of contours.
+//      A ContourEngine offsets regions by a distance, e.g. inwards by the
+//      beam radius for the border of a hatch or outwards for the kerf of a
+//      cut, and unites or subtracts overlapping regions, the way a CAD
+//      program prepares the geometry. It works on the regions of the
+//      HatchEngine, so it runs between the import of a job and the hatch,
+//      and ContourMarks writes the contours as a job of their own.
+//      The result regions hold one outer contour, counterclockwise, and
+//      its holes, clockwise, none of them crossing another.
+//
+//  Comment
+//      The points are rounded to a grid of 1/8 bit and all decisions are
+//      taken with exact integer arithmetic, only new points, crossings and
+//      the arcs of offsets, are computed in floating point and rounded to
+//      the grid. The edges are split where they cross or touch until none
+//      crosses another, then every edge is classified by the winding
+//      numbers on both of its sides and kept if it separates inside from
+//      outside. A region of the input is filled by the even-odd rule like
+//      the HatchEngine does.
+//      An offset is the union of the offset edges joined by arcs around
+//      the convex corners, as in the common CAD kernels. Independent
+//      regions and groups of overlapping regions are processed in
+//      parallel.
+//
+//  Necessary Sources
+//      RTC5Contour.h, RTC5Contour.cpp, RTC5Hatch.h, RTC5List.h, RTC5List.cpp,
+//      RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "RTC5Hatch.h"
+
+//  Error codes of the engine
+const UINT   ContourNoError       =            0;
+const UINT   ContourRangeError    =            1;   //  tolerance not positive or points beyond +-2^23 bits
+const UINT   ContourUnresolved    =            2;   //  regions written, edges still crossing, see Unresolved
+
+class ContourEngine
+{
+public:
+    ContourEngine();
+
+    //  Distance [bits] > 0 outwards, < 0 inwards, In and Out may be the same
+    UINT     Offset( const std::vector< HatchRegion >& In, double Distance, std::vector< HatchRegion >& Out );
+    UINT     Union( const std::vector< HatchRegion >& In, std::vector< HatchRegion >& Out );
+    UINT     Difference( const std::vector< HatchRegion >& In, const std::vector< HatchRegion >& Cut,
+                         std::vector< HatchRegion >& Out );
+
+    //  Settings
+    double   Tolerance;                             //  [bits] of the arc chords
+    UINT     Threads;                               //  0: one per processor
+
+    //  Results
+    uint64_t Edges;                                 //  resolved
+    uint64_t Splits;                                //  edges split at crossings and touching points
+    uint64_t Unresolved;                            //  crossings left after the passes of the split
+    uint64_t Contours;                              //  written
+    double   Time;                                  //  [s] wall clock of the last operation
+
+private:
+    ContourEngine( const ContourEngine& );
+    ContourEngine& operator=( const ContourEngine& );
+
+    UINT     Check( const std::vector< HatchRegion >& In ) const;
+
+};
+
+//  Writes every contour as a closed polyline of jump_abs and mark_abs
+void ContourMarks( const std::vector< HatchRegion >& In, ListJob& Out );
@@ -0,0 +1,402 @@
+//  File
+//      RTC5Conveyor.cpp
+//
+//  Abstract
+//      Marking on the fly of a stream of parts on a conveyor
+//
+//  Comment
+//      Check walks the parts in card time from StartCount on: part i is
+//      released at ( Trigger - Lead - StartCount ) / Rate, starts at the
+//      later of its release and the end of the part before and takes the
+//      time of its pattern. The correction at the start and at the end of a
+//      part bounds the one in between, the extent of the pattern is widened
+//      by both along the conveyor and checked against Field, across the
+//      conveyor it is checked as it is.
+//      The room ahead of the patterns only shrinks with the speed, MaxRate
+//      is bisected on it and then checked as a whole.
+//
+//  Necessary Sources
+//      RTC5Conveyor.h, RTC5Feeder.h, RTC5List.h, RTC5Timing.h, RTC5Util.h,
+//      RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <math.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "RTC5Conveyor.h"
+#include "RTC5Timing.h"
+#include "RTC5Util.h"
+
+static const double MaxSearch            =          1e9;   //  [counts/s] bound of MaxRate
+static const double Precision            =         1e-6;   //  of MaxRate, relative
+static const UINT   MaxHalvings          =           64;
+
+static void Extend( double* Box, double X, double Y )
+{
+    if ( X < Box[ 0 ] ) Box[ 0 ] = X;
+    if ( Y < Box[ 1 ] ) Box[ 1 ] = Y;
+    if ( X > Box[ 2 ] ) Box[ 2 ] = X;
+    if ( Y > Box[ 3 ] ) Box[ 3 ] = Y;
+
+}
+
+//  Extent of the vectors and of the circles of the arcs, from Home on
+static void Bounds( const ListJob& Job, const LONG* Home, double* Box )
+{
+    double X = Home[ 0 ], Y = Home[ 1 ];
+
+    Box[ 0 ] = Box[ 2 ] = X;
+    Box[ 1 ] = Box[ 3 ] = Y;
+
+    for ( size_t i = 0; i < Job.size(); i++ )
+    {
+        const ListCommand& c = Job[ i ];
+
+        switch ( c.Op )
+        {
+        case OpJumpAbs:
+        case OpMarkAbs:
+        case OpJumpAbs3D:
+        case OpMarkAbs3D:   X = c.I[ 0 ];  Y = c.I[ 1 ];                                break;
+        case OpJumpRel:
+        case OpMarkRel:     X += c.I[ 0 ]; Y += c.I[ 1 ];                               break;
+
+        case OpArcAbs:
+        case OpArcRel:
+        {
+            const double cX = c.I[ 0 ] + ( c.Op == OpArcRel ? X : 0.0 );
+            const double cY = c.I[ 1 ] + ( c.Op == OpArcRel ? Y : 0.0 );
+            const double a  = c.D[ 0 ] * Pi / 180.0, vX = X - cX, vY = Y - cY;
+            const double r  = hypot( vX, vY );
+            Extend( Box, cX - r, cY - r );
+            Extend( Box, cX + r, cY + r );
+            X = cX + vX * cos( a ) + vY * sin( a );
+            Y = cY + vY * cos( a ) - vX * sin( a );
+            break;
+
+        }
+
+        default:
+            continue;
+
+        }
+
+        Extend( Box, X, Y );
+
+    }
+
+}
+
+ConveyorScheduler::ConveyorScheduler()
+    : Rate( 100000.0 ), Encoder( 0 ), Scale( 1.0 ), Lead( 0 ), StartCount( 0.0 ),
+      MarkTime( 0.0 ), MaxRate( 0.0 ), PlanTime( 0.0 ),
+      Sustainable( false ), Margin( 0.0 ), Beyond( 0 ), Late( 0 ), MaxLag( 0.0 ), EndTime( 0.0 ),
+      Records( 0 ), HostLate( 0 ), MinAhead( 0.0 ), FeedError( FeedNoError ), WriteTime( 0.0 ),
+      SetupTime( 0.0 ), Planned( false )
+{
+    Home[ 0 ]  = Home[ 1 ] = 0;
+    Field[ 0 ] = Field[ 1 ] = -524288;
+    Field[ 2 ] = Field[ 3 ] =  524287;
+
+}
+
+//  Simulate
+//
+//  Description:
+//
+//  Walks the parts at CountRate and returns the least room [bits] to the
+//  field border, negative if a part leaves the field. Ahead receives the
+//  least room in the direction of the conveyor. Report sets the results of
+//  Check.
+//
+
+double ConveyorScheduler::Simulate( double CountRate, bool Report, double* Ahead )
+{
+    const UINT a = Encoder, c = 1 - Encoder;
+    double End = SetupTime, Least = HUGE_VAL, LeastAhead = HUGE_VAL, Lag = 0.0;
+    UINT   Out = 0, Behind = 0;
+
+    for ( size_t i = 0; i < Parts.size(); i++ )
+    {
+        const ConveyorPart& p = Parts[ i ];
+        const double* b = &Box[ 4 * p.Pattern ];
+        const double Release = ( (double) p.Trigger - Lead - StartCount ) / CountRate;
+        const double Start = End > Release ? End : Release;
+
+        End = Start + PatternTime[ p.Pattern ];
+
+        //  Correction at the start and at the end of the part
+        const double o0 = Scale * ( StartCount + CountRate * Start - p.Trigger );
+        const double o1 = Scale * ( StartCount + CountRate * End   - p.Trigger );
+        const double Low  = b[ a ]     + ( o0 < o1 ? o0 : o1 ) - Field[ a ];
+        const double High = Field[ a + 2 ] - b[ a + 2 ] - ( o0 > o1 ? o0 : o1 );
+        const double Across = std::min( b[ c ] - Field[ c ], Field[ c + 2 ] - b[ c + 2 ] );
+        const double Room = std::min( std::min( Low, High ), Across );
+        const double Front = Scale >= 0.0 ? High : Low;
+
+        if ( Room < Least ) Least = Room;
+        if ( Front < LeastAhead ) LeastAhead = Front;
+        if ( Room < 0.0 ) Out++;
+
+        if ( Start > Release + 1e-9 )
+        {
+            Behind++;
+            if ( Start - Release > Lag ) Lag = Start - Release;
+
+        }
+
+    }
+
+    if ( Parts.empty() ) Least = LeastAhead = HUGE_VAL;
+    if ( Ahead ) *Ahead = LeastAhead;
+
+    if ( Report )
+    {
+        Margin      = Least;
+        Sustainable = Least >= 0.0;
+        Beyond      = Out;
+        Late        = Behind;
+        MaxLag      = Lag;
+        EndTime     = End;
+
+    }
+
+    return Least;
+
+}
+
+//  Plan
+//
+//  Description:
+//
+//  Takes over the parts, precomputes the block of every pattern with its
+//  time and extent, checks Rate and finds MaxRate.
+//
+//      Return                  Meaning
+//
+//      ConveyorNoError         planned, see Sustainable
+//      ConveyorRangeError      no pattern, a part of an unknown pattern,
+//                              triggers descending, Encoder not 0 or 1,
+//                              Rate not positive or an empty Field
+//
+
+UINT ConveyorScheduler::Plan( const ConveyorPart* Part, size_t Count )
+{
+    const auto t0 = std::chrono::steady_clock::now();
+
+    Planned = false;
+    Parts.clear();
+    Blocks.clear();
+    Box.clear();
+    PatternTime.clear();
+    MarkTime = MaxRate = PlanTime = SetupTime = 0.0;
+    Sustainable = false;
+    Margin = MaxLag = EndTime = 0.0;
+    Beyond = Late = 0;
+
+    if (   Patterns.empty() || Encoder > 1 || !( Rate > 0.0 )
+        || Field[ 0 ] > Field[ 2 ] || Field[ 1 ] > Field[ 3 ]
+       )
+    {
+        return ConveyorRangeError;
+
+    }
+
+    for ( size_t i = 0; i < Count; i++ )
+    {
+        if ( Part[ i ].Pattern >= Patterns.size() || ( i && Part[ i ].Trigger < Part[ i - 1 ].Trigger ) ) return ConveyorRangeError;
+
+    }
+
+    Parts.assign( Part, Part + Count );
+
+    //  The blocks and their times from the state after Setup on, at Home
+    const ListCommand AtHome = ListMake( OpJumpAbs, Home[ 0 ], Home[ 1 ] );
+    TimeEstimator Base;
+    SetupTime = Base.Estimate( Setup.data(), Setup.size() );
+    Base.Estimate( &AtHome, 1 );
+
+    Blocks.resize( Patterns.size() );
+    Box.resize( 4 * Patterns.size() );
+    PatternTime.resize( Patterns.size() );
+
+    for ( size_t p = 0; p < Patterns.size(); p++ )
+    {
+        Blocks[ p ] = Patterns[ p ];
+        Blocks[ p ].push_back( ListMake( OpFlyReturn, Home[ 0 ], Home[ 1 ] ) );
+
+        TimeEstimator e = Base;
+        PatternTime[ p ] = e.Estimate( Blocks[ p ].data(), Blocks[ p ].size() );
+        Bounds( Patterns[ p ], Home, &Box[ 4 * p ] );
+
+    }
+
+    for ( size_t i = 0; i < Count; i++ ) MarkTime += PatternTime[ Part[ i ].Pattern ];
+
+    Planned = true;
+
+    //  The room ahead shrinks with the speed
+    double Ahead, Lo = 0.0, Hi = Rate;
+    Simulate( Hi, false, &Ahead );
+
+    if ( Ahead >= 0.0 )
+    {
+        while ( Hi < MaxSearch && ( Simulate( Hi * 2.0, false, &Ahead ), Ahead >= 0.0 ) ) Hi *= 2.0;
+
+        Lo = Hi;
+        Hi = Hi * 2.0;
+
+    }
+
+    if ( Lo < MaxSearch )
+    {
+        for ( UINT k = 0; k < MaxHalvings && Hi - Lo > Precision * Hi; k++ )
+        {
+            const double Mid = 0.5 * ( Lo + Hi );
+            Simulate( Mid, false, &Ahead );
+
+            if ( Ahead >= 0.0 ) Lo = Mid;
+            else                Hi = Mid;
+
+        }
+
+    }
+
+    MaxRate = Lo > 0.0 && Simulate( Lo, false, 0 ) >= 0.0 ? Lo : 0.0;
+
+    Simulate( Rate, true, 0 );
+    PlanTime = Seconds( t0 );
+
+    return ConveyorNoError;
+
+}
+
+//  Check
+//
+//  Description:
+//
+//  Walks the planned parts at another conveyor speed, e.g. the one
+//  measured by get_encoder, and sets Sustainable, Margin, Beyond, Late,
+//  MaxLag and EndTime.
+//
+//      Return                  Meaning
+//
+//      ConveyorNoError         checked, see Sustainable
+//      ConveyorRangeError      not planned or CountRate not positive
+//
+
+UINT ConveyorScheduler::Check( double CountRate )
+{
+    if ( !Planned || !( CountRate > 0.0 ) ) return ConveyorRangeError;
+
+    Simulate( CountRate, true, 0 );
+
+    return ConveyorNoError;
+
+}
+
+//  The wait and the correction of a part
+void ConveyorScheduler::Header( const ConveyorPart& Part, ListCommand* Head ) const
+{
+    const int64_t Release = (int64_t) Part.Trigger - Lead;
+
+    Head[ 0 ] = ListMake( OpWaitForEncoder, (int32_t) Release, Encoder );
+    Head[ 1 ] = ListMakeD( OpActivateFlyXYEncoder, Encoder ? 0.0 : Scale, Encoder ? Scale : 0.0 );
+    Head[ 1 ].I[ 0 ] = Encoder ? 0 : Part.Trigger;
+    Head[ 1 ].I[ 1 ] = Encoder ? Part.Trigger : 0;
+
+}
+
+//  Run
+//
+//  Description:
+//
+//  Writes Setup and a block per part to Out or feeds them to the
+//  ListFeeder, which holds them until the card has room, so the list runs
+//  ahead of the conveyor as far as the list size allows. While feeding the
+//  encoder is read by get_encoder before each part, a part fed after its
+//  release is counted in HostLate.
+//
+//      Return                  Meaning
+//
+//      ConveyorNoError         all parts written
+//      ConveyorRangeError      not planned
+//      ConveyorFeedError       the ListFeeder failed with FeedError
+//
+
+UINT ConveyorScheduler::Run( ListJob& Out )
+{
+    return Run( &Out, 0 );
+
+}
+
+UINT ConveyorScheduler::Run( ListFeeder& Feeder )
+{
+    return Run( 0, &Feeder );
+
+}
+
+UINT ConveyorScheduler::Run( ListJob* Out, ListFeeder* Feeder )
+{
+    Records   = 0;
+    HostLate  = 0;
+    MinAhead  = 0.0;
+    FeedError = FeedNoError;
+    WriteTime = 0.0;
+
+    if ( !Planned ) return ConveyorRangeError;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const bool Encoders = Feeder && get_encoder;
+    double Least = HUGE_VAL;
+
+    if ( Out ) Out->insert( Out->end(), Setup.begin(), Setup.end() );
+
+    if ( Feeder && !Setup.empty() ) FeedError = Feeder->Feed( Setup.data(), Setup.size() );
+
+    Records += Setup.size();
+
+    for ( size_t i = 0; i < Parts.size() && !FeedError; i++ )
+    {
+        const ListJob& Block = Blocks[ Parts[ i ].Pattern ];
+        ListCommand Head[ 2 ];
+        Header( Parts[ i ], Head );
+
+        if ( Out )
+        {
+            Out->insert( Out->end(), Head, Head + 2 );
+            Out->insert( Out->end(), Block.begin(), Block.end() );
+
+        }
+
+        if ( Encoders )
+        {
+            LONG Count[ 2 ];
+            get_encoder( &Count[ 0 ], &Count[ 1 ] );
+
+            const double Ahead = (double) Head[ 0 ].I[ 0 ] - Count[ Encoder ];
+            if ( Ahead < Least ) Least = Ahead;
+            if ( Ahead < 0.0 ) HostLate++;
+
+        }
+
+        if ( Feeder )
+        {
+            FeedError = Feeder->Feed( Head, 2 );
+            if ( !FeedError ) FeedError = Feeder->Feed( Block.data(), Block.size() );
+
+        }
+
+        Records += 2 + Block.size();
+
+    }
+
+    if ( Least < HUGE_VAL ) MinAhead = Least;
+    WriteTime = Seconds( t0 );
+
+    return FeedError ? ConveyorFeedError : ConveyorNoError;
+
+}
@@ -0,0 +1,125 @@
+//  File
+//      RTC5Conveyor.h
+//
+//  Abstract
+//      Marking on the fly of a stream of parts on a conveyor.
+//      A ConveyorScheduler takes the parts in the order they arrive, each
+//      at a known encoder count, and the patterns marked on them. Plan
+//      precomputes the list block of every pattern together with its
+//      marking time and extent, Run streams one block per part, each gated
+//      by wait_for_encoder and corrected by activate_fly_xy_encoder, as far
+//      ahead as the list takes it. Check tells whether a conveyor speed is
+//      sustainable, i.e. every part is marked within the field, and Plan
+//      finds the highest such speed.
+//
+//  Comment
+//      The encoder counts up at Rate while the conveyor carries a part
+//      along x (encoder 0) or y (encoder 1). Part coordinates: a pattern
+//      is marked as if the part stood still with its origin at the field
+//      center at the count Trigger of the part. The correction moves the
+//      scanner by Scale * ( count - Trigger ) along the conveyor, the sign
+//      of Scale gives the direction.
+//      A part's block:
+//          wait_for_encoder( Trigger - Lead, Encoder )
+//          activate_fly_xy_encoder with Scale and Trigger on the axis
+//          the pattern
+//          fly_return( Home )
+//      The card starts a part at Trigger - Lead or, if the part before it is
+//      still being marked, later. The correction then grows with the time
+//      marked, so the pattern plus the correction from the start to the end
+//      of the part must stay within Field. A faster conveyor needs more
+//      room ahead of the pattern and never more behind it, the highest
+//      sustainable speed is found by bisection.
+//      The marking times are those of the TimeEstimator from the state after
+//      Setup on, a pattern should set the parameters it changes. Its extent
+//      is that of its vectors and of the circles of its arcs, text and
+//      pixels are not included.
+//
+//  Necessary Sources
+//      RTC5Conveyor.h, RTC5Conveyor.cpp, RTC5Feeder.h, RTC5Feeder.cpp,
+//      RTC5List.h, RTC5List.cpp, RTC5Timing.h, RTC5Timing.cpp, RTC5Util.h,
+//      RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "RTC5Feeder.h"
+#include "RTC5List.h"
+
+//  Error codes of the scheduler
+const UINT   ConveyorNoError      =            0;
+const UINT   ConveyorRangeError   =            1;   //  no plan, bad pattern, triggers descending, Rate not positive
+const UINT   ConveyorFeedError    =            2;   //  ListFeeder error, see ConveyorScheduler::FeedError
+
+//  A part on the conveyor
+struct ConveyorPart
+{
+    LONG     Trigger;                               //  [counts] its origin at the field center
+    UINT     Pattern;                               //  index into ConveyorScheduler::Patterns
+
+};
+
+class ConveyorScheduler
+{
+public:
+    ConveyorScheduler();
+
+    UINT     Plan( const ConveyorPart* Part, size_t Count );    //  parts in the order of their triggers
+    UINT     Check( double CountRate );             //  [counts/s] sustainable at this speed?
+    UINT     Run( ListJob& Out );
+    UINT     Run( ListFeeder& Feeder );             //  opened by the caller, not finished
+
+    //  Settings, read by Plan
+    std::vector< ListJob > Patterns;                //  in part coordinates
+    ListJob  Setup;                                 //  written before the first part, e.g. speeds and delays
+    LONG     Home[ 2 ];                             //  [bits] fly_return after a part
+    double   Rate;                                  //  [counts/s] conveyor speed checked by Plan
+
+    //  Settings, read by Plan, Check and Run
+    UINT     Encoder;                               //  0: conveyor along x, 1: along y
+    double   Scale;                                 //  [bits/count] correction per count
+    LONG     Lead;                                  //  [counts] parts start before their trigger
+    LONG     Field[ 4 ];                            //  [bits] XMin, YMin, XMax, YMax, inclusive
+    double   StartCount;                            //  [counts] when the card starts with Setup
+
+    //  Results of Plan
+    std::vector< double > PatternTime;              //  [s] a part's block without the wait
+    double   MarkTime;                              //  [s] of all parts
+    double   MaxRate;                               //  [counts/s] highest sustainable speed, 0: none
+    double   PlanTime;                              //  [s] wall clock
+
+    //  Results of Plan at Rate and of Check
+    bool     Sustainable;                           //  all parts within the field
+    double   Margin;                                //  [bits] least room to the field border, negative: beyond
+    UINT     Beyond;                                //  parts leaving the field
+    UINT     Late;                                  //  parts started after Trigger - Lead
+    double   MaxLag;                                //  [s] of the latest start
+    double   EndTime;                               //  [s] the last part marked, from StartCount on
+
+    //  Results of Run
+    uint64_t Records;                               //  written
+    UINT     HostLate;                              //  parts fed after the encoder passed Trigger - Lead
+    double   MinAhead;                              //  [counts] least lead of the feed on the encoder
+    UINT     FeedError;                             //  of the ListFeeder with ConveyorFeedError
+    double   WriteTime;                             //  [s] wall clock
+
+private:
+    ConveyorScheduler( const ConveyorScheduler& );
+    ConveyorScheduler& operator=( const ConveyorScheduler& );
+
+    UINT     Run( ListJob* Out, ListFeeder* Feeder );
+    double   Simulate( double CountRate, bool Report, double* Ahead );
+    void     Header( const ConveyorPart& Part, ListCommand* Head ) const;
+
+    std::vector< ConveyorPart > Parts;
+    std::vector< ListJob > Blocks;                  //  per pattern, following the header of a part
+    std::vector< double > Box;                      //  per pattern XMin, YMin, XMax, YMax
+    double   SetupTime;                             //  [s]
+    bool     Planned;
+
+};
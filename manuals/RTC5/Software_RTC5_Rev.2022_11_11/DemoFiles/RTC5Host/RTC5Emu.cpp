@@ -0,0 +1,2429 @@
+//  File
+//      RTC5Emu.cpp
+//
+//  Abstract
+//      In-process emulation of a single RTC5 card
+//
+//  Comment
+//      List memory layout as configured by config_list:
+//          [ 0,           Mem1 )           list 1
+//          [ Mem1,        Mem1 + Mem2 )    list 2
+//          [ Mem1 + Mem2, 2^20 )           protected area for load_sub,
+//                                          load_char and load_text_table
+//      Positions passed to set_start_list_pos, load_list, set_input_pointer
+//      and execute_list_pos are relative to the start of the list, all other
+//      positions are absolute.
+//      Lists are circular: the input and the out pointer wrap around at the
+//      end of their list. If the out pointer reaches the input pointer of the
+//      list being loaded, the card stalls until more commands arrive.
+//
+//      Timing model: the TimingModel of RTC5Timing.h, which tells the time
+//      of vectors, arcs, pixels and delays. load_varpolydelay reads a table
+//      file of RTC5Poly.h into it, load_program_file removes the table.
+//      The vectors of jump_abs_3d and mark_abs_3d are timed by their x and
+//      y, Z and set_defocus_list are accepted but not modelled.
+//
+//      Stepper motors 1 and 2: stepper_init sets the period of a step [us]
+//      and the position, stepper_abs and stepper_abs_list start both motors
+//      towards their targets at one step per period without ramps, the
+//      list goes on. stepper_wait waits for the motor, get_stepper_status
+//      returns the position and status 1 while the motor moves, otherwise 0.
+//      Direction, tolerance, enable and wait time are not modelled.
+//
+//      Encoders 0 and 1 count at a constant rate: 1 MHz while simulated by
+//      simulate_encoder (1: encoder 0, 2: encoder 1, 3: both, 0: none),
+//      otherwise at the rate set by RTC5EmuSetEncoder for an external
+//      encoder, e.g. of a conveyor. wait_for_encoder waits until the count
+//      reaches the value in the direction of counting, a count not reached
+//      at the rate of that moment holds the card until the rate changes.
+//      store_encoder( 1 or 2 ) stores both counts for read_encoder.
+//      Marking on the fly (set_fly_x, activate_fly_xy_encoder): X follows
+//      encoder 0, Y encoder 1, set_fly_x takes the count of its execution
+//      as reference. The correction is not added to the output position,
+//      it is checked at the ends of vectors, arcs and pixel runs: beyond
+//      the field get_marking_info reports bit 0 (x too large), 1 (x too
+//      small), 2 (y too large) or 3 (y too small) until
+//      clear_fly_overflow_ctrl. fly_return ends it with a jump.
+//
+//      Measurement (set_trigger, set_trigger4): the buffer holds 2^16
+//      values shared by the channels, the measurement ends when it is
+//      full. Signals 7, 8 (SampleX, SampleY) read the output position,
+//      signals 1, 2 (status channels with the real position of an
+//      intelliSCAN) the real position, all other signals read 0.
+//
+//      Real position: without a galvo model it is the output position.
+//      RTC5EmuSetGalvo lets a GalvoModel follow the output position in the
+//      10 us periods of the card, also while the card is idle until the
+//      head has settled.
+//
+//      Scan heads: heads A and B behave like intelliSCANs. control_command
+//      selects the data of a status channel, the new data is read 100 us
+//      later, as Demo7 waits for. After a reset the status channels carry
+//      the real position, which follows the output position. The other
+//      data words are constant: status 0x00F8, status 2 0, galvo 38.0 C,
+//      head 35.0 C, AGC 15.30 V, firmware 0x0A12, the supply voltages 5.00,
+//      3.30, 15.00 and 5.00 V. get_value returns a data word shifted by 4
+//      bits, like an SL2-100 value, get_head_status 0x0F (positions
+//      acknowledged, temperature and power OK).
+//
+//      Approximations of the card's text functions:
+//          mark_serial( Mode, Digits )
+//              Mode & 1    pad with '0' instead of ' '
+//              Mode & 2    left aligned, no padding
+//              Digits      0: as many digits as needed, otherwise the
+//                          least significant digits are marked
+//          mark_date( Part, Mode )
+//              Part        0: year (4 digits), 1: year (2 digits),
+//                          2: month, 3: day, 4: day of the year
+//          mark_time( Part, Mode )
+//              Part        0: hours, 1: minutes, 2: seconds
+//          Mode & 1 pads with '0', Mode & 4 marks the text table entry with
+//          the index of the value instead of its digits.
+//
+//  Necessary Sources
+//      RTC5Emu.h, RTC5Galvo.h, RTC5List.h, RTC5Poly.h, RTC5Timing.h,
+//      RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "RTC5Emu.h"
+#include "RTC5Galvo.h"
+#include "RTC5List.h"
+#include "RTC5Poly.h"
+#include "RTC5Timing.h"
+#include "RTC5Util.h"
+
+static const UINT   MemTotal             =      1 << 20;   //  list memory positions
+static const UINT   TableSize            =         1024;   //  entries of the sub, char and text tables
+static const UINT   Unset                =   0xFFFFFFFF;
+static const UINT   FreeVariables        =            8;
+static const UINT   SerialSets           =            4;
+static const UINT   MaxSteps             =      1 << 24;   //  commands per run, guards against endless loops
+static const double MinLatency           =         1e-6;   //  [s] host call duration in free running mode
+static const UINT   MeasureValues        =      1 << 16;   //  measurement buffer
+static const double HeadLatency          =       100e-6;   //  [s] control_command until the data is sent
+static const UINT   SendRealPos          =       0x0501;
+static const double SimEncoderRate       =          1e6;   //  [counts/s] simulate_encoder
+static const double FieldLimit           =     524288.0;   //  [bits]
+
+static const UINT   ErrBusy              =         0x02;   //  RTC5_BUSY
+static const UINT   ErrParam             =         0x40;   //  RTC5_PARAM_ERROR
+
+struct Frame
+{
+    UINT        Return;         //  position to continue, Unset: next character of the text frame below
+    double      OriginX;        //  origin of absolute commands
+    double      OriginY;
+    bool        Relative;       //  absolute commands are relative to the origin
+    bool        TextFrame;      //  characters of Text are marked one by one
+    bool        TextAbs;
+    std::string Text;
+    size_t      TextPos;
+
+};
+
+struct Card
+{
+    std::vector< ListCommand > Mem;
+    UINT    Mem1, Mem2;
+
+    //  Loading
+    UINT    InPos;
+    UINT    InList;             //  1, 2 or 0 for the protected area
+    bool    Open;               //  the list being loaded is not terminated by set_end_of_list
+    UINT    ProtectedNext;
+    UINT    SubPtr[ TableSize ];
+    UINT    CharPtr[ TableSize ];
+    UINT    TextPtr[ TableSize ];
+
+    //  Execution
+    bool    Busy;
+    bool    Waiting;
+    bool    Paused;
+    bool    Stalled;
+    UINT    WaitWord;
+    UINT    Pc;
+    UINT    ExecList;
+    std::vector< Frame > Stack;
+    double  CardTime;           //  [s]
+
+    //  Scanner and laser
+    double  PosX, PosY;         //  list coordinates
+    double  Matrix[ 2 ][ 2 ];   //  set_matrix_list
+    double  Offset[ 2 ];        //  set_offset_list
+    TimingModel Timing;         //  speeds, delays, position after matrix and offset
+
+    //  Stepper motors 1 and 2
+    UINT    StepPeriod[ 2 ];    //  [us]
+    double  StepFrom[ 2 ];      //  [steps]
+    double  StepTo[ 2 ];
+    double  StepStart[ 2 ];     //  [s] card time the move started
+
+    //  Encoders 0 and 1, marking on the fly
+    double  EncRate[ 2 ];       //  [counts/s] external encoder, RTC5EmuSetEncoder
+    bool    EncSimulated[ 2 ];  //  simulate_encoder
+    double  EncBase[ 2 ];       //  [counts] at EncStart
+    double  EncStart[ 2 ];      //  [s] simulated time
+    LONG    EncStored[ 2 ][ 2 ];    //  store_encoder 1 and 2, encoder 0 and 1
+    bool    EncWait;            //  wait_for_encoder for a count not reached at the current rate
+    bool    Fly;
+    double  FlyScale[ 2 ];      //  [bits/count] of x by encoder 0, y by encoder 1
+    double  FlyRef[ 2 ];        //  [counts] no correction
+    UINT    MarkingInfo;        //  fly overflow bits
+
+    //  Real position of the head, RTC5EmuSetGalvo
+    bool    Dynamics;
+    GalvoModel Galvo;
+    double  GalvoTime;          //  [s] card time Galvo has been stepped to
+
+    //  Text and serial numbers
+    UINT    CharSet;
+    UINT    TextBytes;          //  characters per text position, RTC5EmuSetTextBytes
+    double  Serial[ SerialSets ];
+    double  SerialStep[ SerialSets ];
+    UINT    SerialSet;
+    double  LastSerial;
+
+    //  External control
+    UINT    ControlMode;
+    UINT    ExtStartPos;
+    UINT    MaxCounts;
+    UINT    Counts;
+
+    //  Measurement
+    bool    Measuring;
+    UINT    SamplePeriod;       //  [10 us]
+    UINT    Channels;
+    UINT    Signal[ 4 ];
+    double  NextSample;         //  card time of the next sample
+    UINT    Samples;
+    std::vector< int32_t > Wave[ 4 ];
+
+    //  Status channels of heads A and B, X and Y
+    UINT    HeadData[ 2 ][ 2 ];     //  selected by control_command
+    UINT    HeadNext[ 2 ][ 2 ];     //  requested, sent from HeadSwitch on
+    double  HeadSwitch[ 2 ][ 2 ];   //  [s] simulated time
+
+    UINT    FreeVar[ FreeVariables ];
+    UINT    RtcMode;
+    UINT    LastError;
+    UINT    AccError;
+    double  TimerStart, LastTime;
+
+    //  Simulated time
+    double  SimNow;
+    double  SimBase;
+    double  Scale;
+    double  CallLatency;
+    std::chrono::steady_clock::time_point WallBase;
+    uint64_t HostCalls;
+
+};
+
+static Card*      Emu = 0;
+static std::mutex EmuLock;
+
+#define EMU_ENTRY   std::lock_guard< std::mutex > Guard( EmuLock ); Sync()
+
+static void  Sync( bool HostCall = true );
+static void  Run( double Until );
+static void  Idle();
+
+//  List memory regions
+
+static void Region( UINT Pos, UINT* Start, UINT* End )
+{
+    if ( Pos < Emu->Mem1 )
+    {
+        *Start = 0;
+        *End   = Emu->Mem1;
+
+    }
+    else if ( Pos < Emu->Mem1 + Emu->Mem2 )
+    {
+        *Start = Emu->Mem1;
+        *End   = Emu->Mem1 + Emu->Mem2;
+
+    }
+    else
+    {
+        *Start = Emu->Mem1 + Emu->Mem2;
+        *End   = MemTotal;
+
+    }
+
+}
+
+static UINT ListStart( UINT ListNo )
+{
+    return ListNo == 2 ? Emu->Mem1 : 0;
+
+}
+
+static UINT ListSize( UINT ListNo )
+{
+    return ListNo == 2 ? Emu->Mem2 : Emu->Mem1;
+
+}
+
+static UINT NextPos( UINT Pos )
+{
+    UINT Start, End;
+    Region( Pos, &Start, &End );
+
+    //  Lists wrap around, the protected area does not
+    if ( Pos + 1 >= End ) return Start < Emu->Mem1 + Emu->Mem2 ? Start : MemTotal;
+
+    return Pos + 1;
+
+}
+
+//  Loading list commands
+
+static void Put( const ListCommand& Cmd )
+{
+    if ( Emu->InPos >= MemTotal )
+    {
+        Emu->LastError |= ErrParam;
+        Emu->AccError  |= ErrParam;
+        return;
+
+    }
+
+    Emu->Mem[ Emu->InPos ] = Cmd;
+
+    if ( Emu->InList )
+    {
+        Emu->InPos = NextPos( Emu->InPos );
+        Emu->Open  = Cmd.Op != OpEndOfList;
+
+    }
+    else
+    {
+        Emu->InPos++;
+        Emu->ProtectedNext = Emu->InPos;
+
+    }
+
+}
+
+static void PutText( UINT Op, const char* Text )
+{
+    const size_t Length = Text ? strlen( Text ) : 0;
+    ListCommand  Cmd = ListMake( Op );
+    Cmd.Arg = (uint16_t) ( Length > 0xFFFF ? 0xFFFF : Length );
+    Put( Cmd );
+
+    for ( size_t i = 0; i < Cmd.Arg; i += Emu->TextBytes )
+    {
+        ListCommand Data = ListMake( OpTextData );
+        const size_t n = Cmd.Arg - i < Emu->TextBytes ? Cmd.Arg - i : Emu->TextBytes;
+        Data.Arg = (uint16_t) n;
+        memcpy( ListText( Data ), Text + i, n );
+        Put( Data );
+
+    }
+
+}
+
+static void StartLoading( UINT Index, UINT* Table )
+{
+    if ( Index >= TableSize )
+    {
+        Emu->LastError |= ErrParam;
+        Emu->AccError  |= ErrParam;
+        return;
+
+    }
+
+    Table[ Index ] = Emu->ProtectedNext;
+    Emu->InPos     = Emu->ProtectedNext;
+    Emu->InList    = 0;
+
+}
+
+//  Execution
+
+static void Start( UINT Pos )
+{
+    if ( Emu->Busy )
+    {
+        Emu->LastError |= ErrBusy;
+        Emu->AccError  |= ErrBusy;
+        return;
+
+    }
+
+    Emu->Busy     = true;
+    Emu->Waiting  = false;
+    Emu->Paused   = false;
+    Emu->Stalled  = false;
+    Emu->EncWait  = false;
+    Emu->Pc       = Pos;
+    Emu->ExecList = Pos < Emu->Mem1 ? 1 : 2;
+    Emu->Stack.clear();
+
+    if ( Emu->CardTime < Emu->SimNow ) Emu->CardTime = Emu->SimNow;
+
+}
+
+static void Stop()
+{
+    Emu->Busy    = false;
+    Emu->Waiting = false;
+    Emu->Paused  = false;
+    Emu->Stalled = false;
+    Emu->EncWait = false;
+    Emu->Stack.clear();
+
+}
+
+//  Encoders
+
+static double EncoderRate( UINT e )
+{
+    return Emu->EncSimulated[ e ] ? SimEncoderRate : Emu->EncRate[ e ];
+
+}
+
+static double EncoderAt( UINT e, double t )
+{
+    return Emu->EncBase[ e ] + EncoderRate( e ) * ( t - Emu->EncStart[ e ] );
+
+}
+
+//  The counters are 32 bits wide and wrap around
+static LONG EncoderCount( UINT e, double t )
+{
+    return (LONG) (int64_t) floor( EncoderAt( e, t ) );
+
+}
+
+//  Called before a rate changes at the simulated time
+static void EncoderRebase()
+{
+    for ( UINT e = 0; e < 2; e++ )
+    {
+        Emu->EncBase[ e ]  = EncoderAt( e, Emu->SimNow );
+        Emu->EncStart[ e ] = Emu->SimNow;
+
+    }
+
+    Emu->EncWait = false;
+
+}
+
+//  Card time from t on the count of encoder e reaches Value, HUGE_VAL if it
+//  does not at the current rate
+static double EncoderReach( UINT e, LONG Value, double t )
+{
+    const double Count = EncoderAt( e, t ), Rate = EncoderRate( e );
+
+    if ( Rate > 0.0 ) return Count >= Value ? t : t + ( Value - Count ) / Rate;
+    if ( Rate < 0.0 ) return Count <= Value ? t : t + ( Value - Count ) / Rate;
+
+    return floor( Count ) == Value ? t : HUGE_VAL;
+
+}
+
+//  Fly correction at the card time beyond the field
+static void FlyCheck()
+{
+    if ( !Emu->Fly ) return;
+
+    const double X = Emu->Timing.X + Emu->FlyScale[ 0 ] * ( EncoderAt( 0, Emu->CardTime ) - Emu->FlyRef[ 0 ] );
+    const double Y = Emu->Timing.Y + Emu->FlyScale[ 1 ] * ( EncoderAt( 1, Emu->CardTime ) - Emu->FlyRef[ 1 ] );
+
+    if ( X >   FieldLimit - 1.0 ) Emu->MarkingInfo |= 1;
+    if ( X < - FieldLimit )       Emu->MarkingInfo |= 2;
+    if ( Y >   FieldLimit - 1.0 ) Emu->MarkingInfo |= 4;
+    if ( Y < - FieldLimit )       Emu->MarkingInfo |= 8;
+
+}
+
+static void EndOfVector()
+{
+    Emu->CardTime += Emu->Timing.EndOfVector();
+
+}
+
+static void Transform( double X, double Y, double* ox, double* oy )
+{
+    *ox = Emu->Matrix[ 0 ][ 0 ] * X + Emu->Matrix[ 0 ][ 1 ] * Y + Emu->Offset[ 0 ];
+    *oy = Emu->Matrix[ 1 ][ 0 ] * X + Emu->Matrix[ 1 ][ 1 ] * Y + Emu->Offset[ 1 ];
+
+}
+
+static void Move( double X, double Y, bool Mark )
+{
+    double ox, oy;
+    Transform( X, Y, &ox, &oy );
+
+    FlyCheck();
+    Emu->CardTime += Mark ? Emu->Timing.Mark( ox, oy ) : Emu->Timing.Jump( ox, oy );
+    Emu->PosX = X;
+    Emu->PosY = Y;
+    FlyCheck();
+
+}
+
+//  Angle [deg] clockwise around the center X, Y in list coordinates
+static void Arc( double X, double Y, double Angle )
+{
+    double ox, oy;
+    Transform( X, Y, &ox, &oy );
+    FlyCheck();
+    Emu->CardTime += Emu->Timing.Arc( ox, oy, Angle );
+
+    const double a  = Angle * 3.14159265358979323846 / 180.0;
+    const double vx = Emu->PosX - X, vy = Emu->PosY - Y;
+    Emu->PosX = X + vx * cos( a ) + vy * sin( a );
+    Emu->PosY = Y + vy * cos( a ) - vx * sin( a );
+    Transform( Emu->PosX, Emu->PosY, &Emu->Timing.X, &Emu->Timing.Y );
+    FlyCheck();
+
+}
+
+static void Pixels( UINT Count )
+{
+    const double x = Emu->Timing.X, y = Emu->Timing.Y;
+    FlyCheck();
+    Emu->CardTime += Emu->Timing.Pixels( Count );
+    Emu->PosX += Emu->Timing.X - x;
+    Emu->PosY += Emu->Timing.Y - y;
+    FlyCheck();
+
+}
+
+//  Absolute coordinates are relative to the origin of the innermost
+//  sub_call_abs or mark_text_abs frame
+
+static void MoveAbs( LONG X, LONG Y, bool Mark )
+{
+    double ox = 0.0, oy = 0.0;
+
+    if ( !Emu->Stack.empty() && Emu->Stack.back().Relative )
+    {
+        ox = Emu->Stack.back().OriginX;
+        oy = Emu->Stack.back().OriginY;
+
+    }
+
+    Move( ox + X, oy + Y, Mark );
+
+}
+
+static void ArcAbs( LONG X, LONG Y, double Angle )
+{
+    double ox = 0.0, oy = 0.0;
+
+    if ( !Emu->Stack.empty() && Emu->Stack.back().Relative )
+    {
+        ox = Emu->Stack.back().OriginX;
+        oy = Emu->Stack.back().OriginY;
+
+    }
+
+    Arc( ox + X, oy + Y, Angle );
+
+}
+
+static void Call( UINT Pos, UINT Return, bool Relative )
+{
+    Frame f;
+    f.Return    = Return;
+    f.OriginX   = Emu->PosX;
+    f.OriginY   = Emu->PosY;
+    f.Relative  = Relative;
+    f.TextFrame = false;
+    f.TextAbs   = false;
+    f.TextPos   = 0;
+    Emu->Stack.push_back( f );
+    Emu->Pc = Pos;
+
+}
+
+static void MarkString( const std::string& Text, bool Abs, UINT Return )
+{
+    Frame f;
+    f.Return    = Return;
+    f.OriginX   = 0.0;
+    f.OriginY   = 0.0;
+    f.Relative  = false;
+    f.TextFrame = true;
+    f.TextAbs   = Abs;
+    f.Text      = Text;
+    f.TextPos   = 0;
+    Emu->Stack.push_back( f );
+    Emu->Pc = Unset;
+
+}
+
+static std::string Digits( double Value, UINT Mode, UINT Count )
+{
+    char Buffer[ 32 ];
+    snprintf( Buffer, sizeof( Buffer ), "%.0f", floor( Value < 0.0 ? -Value : Value ) );
+    std::string s( Buffer );
+
+    if ( Count )
+    {
+        if ( s.size() > Count )
+        {
+            s = s.substr( s.size() - Count );
+
+        }
+        else if ( !( Mode & 2 ) )
+        {
+            s.insert( 0, Count - s.size(), ( Mode & 1 ) ? '0' : ' ' );
+
+        }
+
+    }
+
+    return s;
+
+}
+
+static void MarkNumber( UINT Value, UINT Mode, UINT Count, bool Abs, UINT Return )
+{
+    if ( ( Mode & 4 ) && Value < TableSize && Emu->TextPtr[ Value ] != Unset )
+    {
+        EndOfVector();
+        Call( Emu->TextPtr[ Value ], Return, Abs );
+        return;
+
+    }
+
+    MarkString( Digits( Value, Mode, Count ), Abs, Return );
+
+}
+
+static void MarkDate( UINT Part, UINT Mode, bool Abs, UINT Return )
+{
+    const time_t Now = time( 0 );
+    const struct tm* t = localtime( &Now );
+
+    switch ( Part )
+    {
+    case 0:  MarkNumber( t->tm_year + 1900,   Mode, 4, Abs, Return );    break;
+    case 1:  MarkNumber( t->tm_year % 100,    Mode, 2, Abs, Return );    break;
+    case 2:  MarkNumber( t->tm_mon + 1,       Mode, 2, Abs, Return );    break;
+    case 3:  MarkNumber( t->tm_mday,          Mode, 2, Abs, Return );    break;
+    default: MarkNumber( t->tm_yday + 1,      Mode, 3, Abs, Return );    break;
+
+    }
+
+}
+
+static void MarkTime( UINT Part, UINT Mode, bool Abs, UINT Return )
+{
+    const time_t Now = time( 0 );
+    const struct tm* t = localtime( &Now );
+
+    switch ( Part )
+    {
+    case 0:  MarkNumber( t->tm_hour,          Mode, 2, Abs, Return );    break;
+    case 1:  MarkNumber( t->tm_min,           Mode, 2, Abs, Return );    break;
+    default: MarkNumber( t->tm_sec,           Mode, 2, Abs, Return );    break;
+
+    }
+
+}
+
+static std::string ReadText( UINT Pos, UINT Length, UINT* Next )
+{
+    std::string Text;
+    UINT p = NextPos( Pos );
+
+    while ( Text.size() < Length && p < MemTotal && Emu->Mem[ p ].Op == OpTextData )
+    {
+        Text.append( ListText( Emu->Mem[ p ] ), Emu->Mem[ p ].Arg );
+        p = NextPos( p );
+
+    }
+
+    *Next = p;
+    return Text;
+
+}
+
+//  Stepper motors
+
+static double StepperEnd( UINT m )
+{
+    return Emu->StepStart[ m ] + fabs( Emu->StepTo[ m ] - Emu->StepFrom[ m ] ) * Emu->StepPeriod[ m ] * 1e-6;
+
+}
+
+static double StepperAt( UINT m, double t )
+{
+    const double End = StepperEnd( m );
+
+    if ( t >= End ) return Emu->StepTo[ m ];
+    if ( t <= Emu->StepStart[ m ] ) return Emu->StepFrom[ m ];
+
+    return Emu->StepFrom[ m ] + ( Emu->StepTo[ m ] - Emu->StepFrom[ m ] ) * ( t - Emu->StepStart[ m ] ) / ( End - Emu->StepStart[ m ] );
+
+}
+
+static void StepperMove( LONG Pos1, LONG Pos2, double t )
+{
+    const LONG Pos[ 2 ] = { Pos1, Pos2 };
+
+    for ( UINT m = 0; m < 2; m++ )
+    {
+        Emu->StepFrom[ m ]  = floor( StepperAt( m, t ) + 0.5 );
+        Emu->StepTo[ m ]    = Pos[ m ];
+        Emu->StepStart[ m ] = t;
+
+    }
+
+}
+
+//  Measurement
+
+static void StartMeasure( UINT Period, UINT Channels, const UINT* Signals )
+{
+    //  Period 0 stops the measurement, the samples stay readable
+    Emu->Measuring = Period > 0;
+
+    if ( !Period ) return;
+
+    Emu->SamplePeriod = Period;
+    Emu->Channels     = Channels;
+    Emu->NextSample   = Emu->CardTime;
+    Emu->Samples      = 0;
+
+    for ( UINT i = 0; i < 4; i++ )
+    {
+        Emu->Signal[ i ] = i < Channels ? Signals[ i ] : 0;
+        Emu->Wave[ i ].assign( i < Channels ? MeasureValues / Channels : 0, 0 );
+
+    }
+
+}
+
+static void Sample( double X, double Y, double RealX, double RealY )
+{
+    for ( UINT i = 0; i < Emu->Channels; i++ )
+    {
+        const UINT s = Emu->Signal[ i ];
+        const double v = s == 7 ? X : s == 8 ? Y : s == 1 ? RealX : s == 2 ? RealY : 0.0;
+        Emu->Wave[ i ][ Emu->Samples ] = (int32_t) floor( v + 0.5 );
+
+    }
+
+    Emu->NextSample += Emu->SamplePeriod * Tick;
+
+    if ( ++Emu->Samples >= MeasureValues / Emu->Channels ) Emu->Measuring = false;
+
+}
+
+//  Output position at card time t. Motion: the command executed from T0 on,
+//  otherwise the position is held.
+static void CommandAt( double t, double T0, bool Motion, double* X, double* Y )
+{
+    const TimingMotion& m = Emu->Timing.Last;
+
+    t -= T0;
+
+    if ( !Motion || m.Duration <= 0.0 || t >= m.Start + m.Duration )
+    {
+        *X = Emu->Timing.X;
+        *Y = Emu->Timing.Y;
+
+    }
+    else if ( t <= m.Start )
+    {
+        *X = m.X0;
+        *Y = m.Y0;
+
+    }
+    else if ( m.Angle != 0.0 )
+    {
+        const double a  = ( t - m.Start ) / m.Duration * m.Angle * 3.14159265358979323846 / 180.0;
+        const double vx = m.X0 - m.CenterX, vy = m.Y0 - m.CenterY;
+        *X = m.CenterX + vx * cos( a ) + vy * sin( a );
+        *Y = m.CenterY + vy * cos( a ) - vx * sin( a );
+
+    }
+    else
+    {
+        const double f = ( t - m.Start ) / m.Duration;
+        *X = m.X0 + ( Emu->Timing.X - m.X0 ) * f;
+        *Y = m.Y0 + ( Emu->Timing.Y - m.Y0 ) * f;
+
+    }
+
+}
+
+//  Follow
+//
+//  Description:
+//
+//  Moves the head up to the card time and takes the samples due. Without
+//  dynamics the head is at the output position. With dynamics the galvo
+//  model steps the 10 us periods from GalvoTime on, in blocks, a sample
+//  reads the real position at the end of its period. A head settled at a
+//  held position is not stepped.
+//
+//      Parameter   Meaning
+//
+//      T0          card time the command executed last started
+//      Motion      false: the output position is held since GalvoTime
+//
+
+static void Follow( double T0, bool Motion )
+{
+    const UINT Block = 256;
+    const double Until = Emu->CardTime;
+    double X, Y;
+
+    if ( !Emu->Dynamics )
+    {
+        while ( Emu->Measuring && Emu->NextSample <= Until )
+        {
+            CommandAt( Emu->NextSample, T0, Motion, &X, &Y );
+            Sample( X, Y, X, Y );
+
+        }
+
+        return;
+
+    }
+
+    GalvoModel& g = Emu->Galvo;
+    double CmdX[ Block ], CmdY[ Block ], RealX[ Block ], RealY[ Block ];
+
+    for ( ;; )
+    {
+        const double Periods = floor( ( Until - Emu->GalvoTime ) / Tick + 1e-6 );
+
+        if ( Periods < 1.0 ) break;
+
+        if ( !Motion && g.Settled( Emu->Timing.X, Emu->Timing.Y ) )
+        {
+            g.X = Emu->Timing.X;
+            g.Y = Emu->Timing.Y;
+            Emu->GalvoTime += Periods * Tick;
+
+            while ( Emu->Measuring && Emu->NextSample <= Emu->GalvoTime ) Sample( g.X, g.Y, g.X, g.Y );
+
+            break;
+
+        }
+
+        const UINT n = Periods < Block ? (UINT) Periods : Block;
+
+        for ( UINT k = 0; k < n; k++ ) CommandAt( Emu->GalvoTime + ( k + 1 ) * Tick, T0, Motion, CmdX + k, CmdY + k );
+
+        g.Run( CmdX, CmdY, n, RealX, RealY );
+
+        const double Start = Emu->GalvoTime;
+        Emu->GalvoTime += n * Tick;
+
+        while ( Emu->Measuring && Emu->NextSample <= Emu->GalvoTime )
+        {
+            const double k = ceil( ( Emu->NextSample - Start ) / Tick - 1e-6 ) - 1.0;
+            const UINT i = k < 0.0 ? 0 : k >= n ? n - 1 : (UINT) k;
+
+            CommandAt( Emu->NextSample, T0, Motion, &X, &Y );
+            Sample( X, Y, RealX[ i ], RealY[ i ] );
+
+        }
+
+    }
+
+}
+
+//  Step
+//
+//  Description:
+//
+//  Executes the command at the out pointer.
+//  Returns false, if the card cannot continue.
+//
+
+static bool Step()
+{
+    if ( Emu->Pc == Unset )
+    {
+        //  Next character of the innermost text frame
+        Frame& f = Emu->Stack.back();
+
+        while ( f.TextPos < f.Text.size() )
+        {
+            const UINT Char = Emu->CharSet * 256 + (unsigned char) f.Text[ f.TextPos++ ];
+
+            if ( Emu->CharPtr[ Char ] != Unset )
+            {
+                Call( Emu->CharPtr[ Char ], Unset, f.TextAbs );
+                return true;
+
+            }
+
+        }
+
+        Emu->Pc = f.Return;
+        Emu->Stack.pop_back();
+        return true;
+
+    }
+
+    if ( Emu->Pc >= MemTotal )
+    {
+        Stop();
+        return false;
+
+    }
+
+    //  The card must not overtake the input pointer of a list being loaded
+    if ( Emu->InList && Emu->Open && Emu->Pc == Emu->InPos )
+    {
+        Emu->Stalled = true;
+        return false;
+
+    }
+
+    if ( Emu->Stalled )
+    {
+        Emu->Stalled = false;
+        if ( Emu->CardTime < Emu->SimNow ) Emu->CardTime = Emu->SimNow;
+
+    }
+
+    const ListCommand& Cmd  = Emu->Mem[ Emu->Pc ];
+    const UINT         Next = NextPos( Emu->Pc );
+    UINT               Jump = Next;
+
+    switch ( Cmd.Op )
+    {
+    case OpNop:
+        Emu->CardTime += Emu->Timing.Nop();
+        break;
+
+    case OpEndOfList:
+        EndOfVector();
+        Emu->Busy = false;
+        return false;
+
+    case OpListReturn:
+        if ( Emu->Stack.empty() )
+        {
+            Emu->Busy = false;
+            return false;
+
+        }
+
+        Jump = Emu->Stack.back().Return;
+        Emu->Stack.pop_back();
+        break;
+
+    case OpListContinue:
+    case OpTextData:
+        break;
+
+    case OpSetWait:
+        EndOfVector();
+        Emu->Waiting  = true;
+        Emu->WaitWord = Cmd.I[ 0 ];
+        return false;
+
+    case OpLongDelay:
+        Emu->CardTime += Emu->Timing.Delay( Cmd.I[ 0 ] );
+        break;
+
+    case OpStepperAbs:
+        EndOfVector();
+        StepperMove( Cmd.I[ 0 ], Cmd.I[ 1 ], Emu->CardTime );
+        break;
+
+    case OpStepperWait:
+        EndOfVector();
+
+        if ( Cmd.I[ 0 ] == 1 || Cmd.I[ 0 ] == 2 )
+        {
+            const double End = StepperEnd( Cmd.I[ 0 ] - 1 );
+            if ( Emu->CardTime < End ) Emu->CardTime = End;
+
+        }
+
+        break;
+
+    case OpWaitForEncoder:
+        EndOfVector();
+
+        if ( Cmd.I[ 1 ] == 0 || Cmd.I[ 1 ] == 1 )
+        {
+            const double Reach = EncoderReach( Cmd.I[ 1 ], Cmd.I[ 0 ], Emu->CardTime );
+
+            if ( Reach == HUGE_VAL )
+            {
+                Emu->EncWait = true;
+                return false;
+
+            }
+
+            if ( Emu->CardTime < Reach ) Emu->CardTime = Reach;
+
+        }
+
+        break;
+
+    case OpStoreEncoder:
+        if ( Cmd.I[ 0 ] == 1 || Cmd.I[ 0 ] == 2 )
+        {
+            for ( UINT e = 0; e < 2; e++ ) Emu->EncStored[ Cmd.I[ 0 ] - 1 ][ e ] = EncoderCount( e, Emu->CardTime );
+
+        }
+
+        break;
+
+    case OpSetFlyX:
+        EndOfVector();
+        Emu->Fly           = true;
+        Emu->FlyScale[ 0 ] = Cmd.D[ 0 ];
+        Emu->FlyScale[ 1 ] = 0.0;
+        Emu->FlyRef[ 0 ]   = floor( EncoderAt( 0, Emu->CardTime ) );
+        break;
+
+    case OpActivateFlyXYEncoder:
+        EndOfVector();
+        Emu->Fly           = true;
+        Emu->FlyScale[ 0 ] = Cmd.D[ 0 ];
+        Emu->FlyScale[ 1 ] = Cmd.D[ 1 ];
+        Emu->FlyRef[ 0 ]   = Cmd.I[ 0 ];
+        Emu->FlyRef[ 1 ]   = Cmd.I[ 1 ];
+        break;
+
+    case OpFlyReturn:
+        EndOfVector();
+        Emu->Fly = false;
+        Move( Cmd.I[ 0 ], Cmd.I[ 1 ], false );
+        break;
+
+    case OpJumpAbs:     MoveAbs( Cmd.I[ 0 ], Cmd.I[ 1 ], false );                                  break;
+    case OpMarkAbs:     MoveAbs( Cmd.I[ 0 ], Cmd.I[ 1 ], true );                                   break;
+    case OpJumpAbs3D:   MoveAbs( Cmd.I[ 0 ], Cmd.I[ 1 ], false );                                  break;
+    case OpMarkAbs3D:   MoveAbs( Cmd.I[ 0 ], Cmd.I[ 1 ], true );                                   break;
+    case OpJumpRel:     Move( Emu->PosX + Cmd.I[ 0 ], Emu->PosY + Cmd.I[ 1 ], false );             break;
+    case OpMarkRel:     Move( Emu->PosX + Cmd.I[ 0 ], Emu->PosY + Cmd.I[ 1 ], true );              break;
+    case OpArcAbs:      ArcAbs( Cmd.I[ 0 ], Cmd.I[ 1 ], Cmd.D[ 0 ] );                               break;
+    case OpArcRel:      Arc( Emu->PosX + Cmd.I[ 0 ], Emu->PosY + Cmd.I[ 1 ], Cmd.D[ 0 ] );          break;
+    case OpSetPixel:    Pixels( 1 );                                                                break;
+    case OpSetNPixel:   Pixels( Cmd.I[ 2 ] );                                                       break;
+
+    case OpSetTrigger:
+    case OpSetTrigger4:
+    {
+        const UINT Signals[ 4 ] = { (UINT) Cmd.I[ 1 ], (UINT) Cmd.I[ 2 ], (UINT) Cmd.J[ 2 ], (UINT) Cmd.J[ 3 ] };
+        StartMeasure( Cmd.I[ 0 ], Cmd.Op == OpSetTrigger ? 2 : 4, Signals );
+        break;
+
+    }
+
+    case OpSetLaserPulses:
+    case OpSetFirstPulseKiller:
+    case OpWriteDaX:
+    case OpSetDefocus:
+        break;
+
+    case OpSubCall:
+    case OpSubCallAbs:
+        if ( (UINT) Cmd.I[ 0 ] < TableSize && Emu->SubPtr[ Cmd.I[ 0 ] ] != Unset )
+        {
+            EndOfVector();
+            Call( Emu->SubPtr[ Cmd.I[ 0 ] ], Next, Cmd.Op == OpSubCallAbs );
+            return true;
+
+        }
+
+        break;
+
+    case OpListCall:
+    case OpListCallAbs:
+        EndOfVector();
+        Call( Cmd.I[ 0 ], Next, Cmd.Op == OpListCallAbs );
+        return true;
+
+    case OpListJumpPos:
+        Jump = Cmd.I[ 0 ];
+        break;
+
+    case OpSelectCharSet:
+        Emu->CharSet = Cmd.I[ 0 ] & 3;
+        break;
+
+    case OpMarkText:
+    case OpMarkTextAbs:
+    {
+        UINT After;
+        const std::string Text = ReadText( Emu->Pc, Cmd.Arg, &After );
+        EndOfVector();
+        MarkString( Text, Cmd.Op == OpMarkTextAbs, After );
+        return true;
+
+    }
+
+    case OpMarkChar:
+    case OpMarkCharAbs:
+        EndOfVector();
+        MarkString( std::string( 1, (char) Cmd.I[ 0 ] ), Cmd.Op == OpMarkCharAbs, Next );
+        return true;
+
+    case OpMarkSerial:
+    case OpMarkSerialAbs:
+    {
+        const UINT s = Emu->SerialSet;
+        Emu->LastSerial = Emu->Serial[ s ];
+        Emu->Serial[ s ] += Emu->SerialStep[ s ];
+        EndOfVector();
+        MarkString( Digits( Emu->LastSerial, Cmd.I[ 0 ], Cmd.I[ 1 ] ), Cmd.Op == OpMarkSerialAbs, Next );
+        return true;
+
+    }
+
+    case OpMarkDate:
+    case OpMarkDateAbs:
+        EndOfVector();
+        MarkDate( Cmd.I[ 0 ], Cmd.I[ 1 ], Cmd.Op == OpMarkDateAbs, Next );
+        return true;
+
+    case OpMarkTime:
+    case OpMarkTimeAbs:
+        EndOfVector();
+        MarkTime( Cmd.I[ 0 ], Cmd.I[ 1 ], Cmd.Op == OpMarkTimeAbs, Next );
+        return true;
+
+    case OpSelectSerialSet:
+        Emu->SerialSet = Cmd.I[ 0 ] % SerialSets;
+        break;
+
+    case OpSetSerialStep:
+        Emu->Serial[ Emu->SerialSet ]     = (UINT) Cmd.I[ 0 ];
+        Emu->SerialStep[ Emu->SerialSet ] = (UINT) Cmd.I[ 1 ];
+        break;
+
+    case OpSaveAndRestartTimer:
+        EndOfVector();
+        Emu->LastTime   = Emu->CardTime - Emu->TimerStart;
+        Emu->TimerStart = Emu->CardTime;
+        break;
+
+    case OpSetExtStartPos:
+        Emu->ExtStartPos = Cmd.I[ 0 ];
+        break;
+
+    case OpSetControlMode:
+        Emu->ControlMode = Cmd.I[ 0 ];
+        break;
+
+    case OpSetFreeVariable:
+        if ( (UINT) Cmd.I[ 0 ] < FreeVariables ) Emu->FreeVar[ Cmd.I[ 0 ] ] = Cmd.I[ 1 ];
+        break;
+
+    //  Only one scan head is emulated, head no. 0 (both) and 1 apply
+    case OpSetOffset:
+        if ( Cmd.Arg < 2 )
+        {
+            Emu->Offset[ 0 ] = Cmd.I[ 0 ];
+            Emu->Offset[ 1 ] = Cmd.I[ 1 ];
+
+        }
+
+        break;
+
+    case OpSetMatrix:
+        if ( Cmd.Arg < 2 && Cmd.I[ 0 ] >= 1 && Cmd.I[ 0 ] <= 2 && Cmd.I[ 1 ] >= 1 && Cmd.I[ 1 ] <= 2 )
+        {
+            Emu->Matrix[ Cmd.I[ 0 ] - 1 ][ Cmd.I[ 1 ] - 1 ] = Cmd.D[ 0 ];
+
+        }
+
+        break;
+
+    default:
+        Emu->Timing.Apply( Cmd );
+        break;
+
+    }
+
+    Emu->Pc = Jump;
+    return true;
+
+}
+
+static void Run( double Until )
+{
+    UINT Steps = 0;
+
+    while (   Emu->Busy && !Emu->Waiting && !Emu->Paused && !Emu->EncWait
+           && Emu->CardTime < Until && Steps++ < MaxSteps
+          )
+    {
+        if ( Emu->Dynamics || Emu->Measuring ) Follow( Emu->CardTime, false );
+
+        const double T0 = Emu->CardTime;
+        Emu->Timing.Last.Duration = 0.0;
+
+        const bool More = Step();
+
+        if ( Emu->Dynamics || Emu->Measuring ) Follow( T0, true );
+        if ( !More ) break;
+
+    }
+
+}
+
+//  An idle card follows the simulated time
+static void Idle()
+{
+    if ( ( !Emu->Busy || Emu->Waiting || Emu->Paused || Emu->Stalled || Emu->EncWait ) && Emu->CardTime < Emu->SimNow )
+    {
+        Emu->CardTime = Emu->SimNow;
+
+    }
+
+    if (   ( Emu->Dynamics || Emu->Measuring )
+        && !( Emu->Busy && !Emu->Waiting && !Emu->Paused && !Emu->Stalled && !Emu->EncWait )
+       )
+    {
+        Follow( Emu->CardTime, false );
+
+    }
+
+}
+
+static void Sync( bool HostCall )
+{
+    if ( HostCall ) Emu->HostCalls++;
+
+    if ( Emu->Scale > 0.0 )
+    {
+        const std::chrono::duration< double > Wall = std::chrono::steady_clock::now() - Emu->WallBase;
+        const double Now = Emu->SimBase + Wall.count() * Emu->Scale;
+
+        if ( Now > Emu->SimNow ) Emu->SimNow = Now;
+
+    }
+    else if ( HostCall )
+    {
+        Emu->SimNow += Emu->CallLatency > MinLatency ? Emu->CallLatency : MinLatency;
+
+    }
+
+    Run( Emu->SimNow );
+    Idle();
+
+}
+
+static void ResetCard()
+{
+    Card& c = *Emu;
+
+    c.Mem.assign( MemTotal, ListMake( OpEndOfList ) );
+    c.Mem1 = 4000;
+    c.Mem2 = 4000;
+    c.InPos = 0;
+    c.InList = 1;
+    c.Open = false;
+    c.ProtectedNext = c.Mem1 + c.Mem2;
+
+    for ( UINT i = 0; i < TableSize; i++ )
+    {
+        c.SubPtr[ i ] = c.CharPtr[ i ] = c.TextPtr[ i ] = Unset;
+
+    }
+
+    c.Busy = c.Waiting = c.Paused = c.Stalled = c.EncWait = false;
+    c.WaitWord = 0;
+    c.Pc = 0;
+    c.ExecList = 1;
+    c.Stack.clear();
+
+    for ( UINT m = 0; m < 2; m++ )
+    {
+        c.StepPeriod[ m ] = 100;
+        c.StepFrom[ m ] = c.StepTo[ m ] = 0.0;
+        c.StepStart[ m ] = c.CardTime;
+
+    }
+
+    for ( UINT e = 0; e < 2; e++ )
+    {
+        c.EncRate[ e ] = 0.0;
+        c.EncSimulated[ e ] = false;
+        c.EncBase[ e ] = 0.0;
+        c.EncStart[ e ] = c.SimNow;
+        c.EncStored[ 0 ][ e ] = c.EncStored[ 1 ][ e ] = 0;
+        c.FlyScale[ e ] = c.FlyRef[ e ] = 0.0;
+
+    }
+
+    c.Fly = false;
+    c.MarkingInfo = 0;
+
+    c.PosX = c.PosY = 0.0;
+    c.Matrix[ 0 ][ 0 ] = c.Matrix[ 1 ][ 1 ] = 1.0;
+    c.Matrix[ 0 ][ 1 ] = c.Matrix[ 1 ][ 0 ] = 0.0;
+    c.Offset[ 0 ] = c.Offset[ 1 ] = 0.0;
+    c.Timing.Reset();
+    c.Galvo.Reset( c.Timing.X, c.Timing.Y );
+    c.GalvoTime = c.CardTime;
+
+    c.CharSet = 0;
+
+    for ( UINT i = 0; i < SerialSets; i++ )
+    {
+        c.Serial[ i ] = 0.0;
+        c.SerialStep[ i ] = 1.0;
+
+    }
+
+    c.SerialSet = 0;
+    c.LastSerial = 0.0;
+
+    c.ControlMode = 0;
+    c.ExtStartPos = 0;
+    c.MaxCounts = 0;
+    c.Counts = 0;
+
+    c.Measuring = false;
+    c.SamplePeriod = 0;
+    c.Channels = 0;
+    c.Samples = 0;
+
+    for ( UINT h = 0; h < 2; h++ )
+    {
+        for ( UINT a = 0; a < 2; a++ )
+        {
+            c.HeadData[ h ][ a ] = c.HeadNext[ h ][ a ] = SendRealPos;
+            c.HeadSwitch[ h ][ a ] = 0.0;
+
+        }
+
+    }
+
+    memset( c.FreeVar, 0, sizeof( c.FreeVar ) );
+    c.LastError = c.AccError = 0;
+    c.TimerStart = c.CardTime;
+    c.LastTime = 0.0;
+
+}
+
+//  Emulated RTC5 functions
+
+static UINT __stdcall EmuInitDll()                                 { EMU_ENTRY; return 0; }
+static void __stdcall EmuFreeDll()                                 { EMU_ENTRY; Stop(); }
+static void __stdcall EmuSetRtc4Mode()                             { EMU_ENTRY; Emu->RtcMode = 4; }
+static void __stdcall EmuSetRtc5Mode()                             { EMU_ENTRY; Emu->RtcMode = 5; }
+static UINT __stdcall EmuGetRtcMode()                              { EMU_ENTRY; return Emu->RtcMode; }
+static UINT __stdcall EmuGetError()                                { EMU_ENTRY; return Emu->AccError; }
+static UINT __stdcall EmuGetLastError()                            { EMU_ENTRY; return Emu->LastError; }
+static UINT __stdcall EmuNGetLastError( UINT CardNo )              { EMU_ENTRY; return CardNo == 1 ? Emu->LastError : 0; }
+static UINT __stdcall EmuCountCards()                              { EMU_ENTRY; return 1; }
+static UINT __stdcall EmuSelectRtc( UINT CardNo )                  { EMU_ENTRY; return CardNo == 1 ? 1 : 0; }
+static UINT __stdcall EmuAcquireRtc( UINT CardNo )                 { EMU_ENTRY; return CardNo == 1 ? 1 : 0; }
+static UINT __stdcall EmuReleaseRtc( UINT CardNo )                 { EMU_ENTRY; return CardNo == 1 ? 1 : 0; }
+static UINT __stdcall EmuGetDllVersion()                           { EMU_ENTRY; return 535; }
+static UINT __stdcall EmuLoadCorrectionFile( const char*, UINT, UINT ) { EMU_ENTRY; return 0; }
+static void __stdcall EmuSelectCorTable( UINT, UINT )              { EMU_ENTRY; }
+static void __stdcall EmuSetLaserMode( UINT )                      { EMU_ENTRY; }
+static void __stdcall EmuSetLaserControl( UINT )                   { EMU_ENTRY; }
+static void __stdcall EmuSetStandby( UINT, UINT )                  { EMU_ENTRY; }
+static void __stdcall EmuWriteDaX( UINT, UINT )                    { EMU_ENTRY; }
+static void __stdcall EmuTimeUpdate()                              { EMU_ENTRY; }
+
+static void __stdcall EmuResetError( UINT Code )
+{
+    EMU_ENTRY;
+    Emu->LastError &= ~Code;
+    Emu->AccError  &= ~Code;
+
+}
+
+static void __stdcall EmuNResetError( UINT CardNo, UINT Code )
+{
+    EMU_ENTRY;
+
+    if ( CardNo == 1 )
+    {
+        Emu->LastError &= ~Code;
+        Emu->AccError  &= ~Code;
+
+    }
+
+}
+
+static UINT __stdcall EmuLoadProgramFile( const char* )
+{
+    EMU_ENTRY;
+
+    if ( Emu->Busy ) return ErrBusy;
+
+    ResetCard();
+    return 0;
+
+}
+
+static UINT __stdcall EmuNLoadProgramFile( UINT CardNo, const char* )
+{
+    EMU_ENTRY;
+
+    if ( CardNo != 1 ) return ErrParam;
+    if ( Emu->Busy ) return ErrBusy;
+
+    ResetCard();
+    return 0;
+
+}
+
+//  The table of the file format of RTC5Poly.h, one table for all No
+static LONG LoadVarPolyDelay( const char* Name, UINT No )
+{
+    std::vector< double > Angle, Scale;
+
+    if ( !Name || PolyReadTable( Name, No, Angle, Scale ) ) return ErrParam;
+
+    Emu->Timing.SetVarPolyTable( Angle.data(), Scale.data(), (UINT) Angle.size() );
+    return 0;
+
+}
+
+static LONG __stdcall EmuLoadVarPolyDelay( const char* Name, UINT No )
+{
+    EMU_ENTRY;
+    return LoadVarPolyDelay( Name, No );
+
+}
+
+static LONG __stdcall EmuNLoadVarPolyDelay( UINT CardNo, const char* Name, UINT No )
+{
+    EMU_ENTRY;
+    return CardNo == 1 ? LoadVarPolyDelay( Name, No ) : ErrParam;
+
+}
+
+static void __stdcall EmuConfigList( UINT Mem1, UINT Mem2 )
+{
+    EMU_ENTRY;
+
+    if ( Emu->Busy || (uint64_t) Mem1 + Mem2 > MemTotal )
+    {
+        Emu->LastError |= ErrParam;
+        Emu->AccError  |= ErrParam;
+        return;
+
+    }
+
+    Emu->Mem1 = Mem1;
+    Emu->Mem2 = Mem2;
+    Emu->ProtectedNext = Mem1 + Mem2;
+    Emu->InPos = 0;
+    Emu->InList = 1;
+    Emu->Open = false;
+
+}
+
+static UINT __stdcall EmuGetListSpace()
+{
+    EMU_ENTRY;
+
+    if ( !Emu->InList ) return MemTotal - Emu->InPos;
+
+    const UINT Start = ListStart( Emu->InList );
+    const UINT Size  = ListSize( Emu->InList );
+
+    if ( Emu->Busy && Emu->ExecList == Emu->InList && Emu->Pc < MemTotal )
+    {
+        return ( Emu->Pc + Size - Emu->InPos - 1 ) % Size;
+
+    }
+
+    return Size - ( Emu->InPos - Start );
+
+}
+
+static void __stdcall EmuSetStartListPos( UINT ListNo, UINT Pos )
+{
+    EMU_ENTRY;
+
+    const UINT List = ListNo == 2 ? 2 : 1;
+
+    if ( Pos >= ListSize( List ) )
+    {
+        Emu->LastError |= ErrParam;
+        Emu->AccError  |= ErrParam;
+        return;
+
+    }
+
+    Emu->InList = List;
+    Emu->InPos  = ListStart( List ) + Pos;
+    Emu->Open   = true;
+
+}
+
+static void __stdcall EmuSetStartList( UINT ListNo )
+{
+    EMU_ENTRY;
+    Emu->InList = ListNo == 2 ? 2 : 1;
+    Emu->InPos  = ListStart( Emu->InList );
+    Emu->Open   = true;
+
+}
+
+static void __stdcall EmuSetStartList1()                           { EmuSetStartList( 1 ); }
+static void __stdcall EmuSetStartList2()                           { EmuSetStartList( 2 ); }
+
+static UINT __stdcall EmuLoadList( UINT ListNo, UINT Pos )
+{
+    {
+        EMU_ENTRY;
+
+        const UINT List = ListNo == 2 ? 2 : 1;
+
+        if ( Emu->Busy && Emu->ExecList == List ) return 0;
+
+    }
+
+    EmuSetStartListPos( ListNo, Pos );
+    return 1;
+
+}
+
+static void __stdcall EmuSetInputPointer( UINT Pos )
+{
+    EMU_ENTRY;
+
+    if ( Emu->InList && Pos < ListSize( Emu->InList ) ) Emu->InPos = ListStart( Emu->InList ) + Pos;
+
+}
+
+static UINT __stdcall EmuGetInputPointer()                         { EMU_ENTRY; return Emu->InPos; }
+static void __stdcall EmuLoadSub( UINT Index )                     { EMU_ENTRY; StartLoading( Index, Emu->SubPtr ); }
+static void __stdcall EmuLoadChar( UINT Char )                     { EMU_ENTRY; StartLoading( Char, Emu->CharPtr ); }
+static void __stdcall EmuLoadTextTable( UINT Index )               { EMU_ENTRY; StartLoading( Index, Emu->TextPtr ); }
+static UINT __stdcall EmuGetCharPointer( UINT Char )               { EMU_ENTRY; return Char < TableSize ? Emu->CharPtr[ Char ] : Unset; }
+static UINT __stdcall EmuGetSubPointer( UINT Index )               { EMU_ENTRY; return Index < TableSize ? Emu->SubPtr[ Index ] : Unset; }
+static UINT __stdcall EmuGetTextTablePointer( UINT Index )         { EMU_ENTRY; return Index < TableSize ? Emu->TextPtr[ Index ] : Unset; }
+
+static void __stdcall EmuSetCharPointer( UINT Char, UINT Pos )     { EMU_ENTRY; if ( Char  < TableSize ) Emu->CharPtr[ Char ]  = Pos; }
+static void __stdcall EmuSetSubPointer( UINT Index, UINT Pos )     { EMU_ENTRY; if ( Index < TableSize ) Emu->SubPtr[ Index ]  = Pos; }
+static void __stdcall EmuSetTextTablePointer( UINT Index, UINT Pos ) { EMU_ENTRY; if ( Index < TableSize ) Emu->TextPtr[ Index ] = Pos; }
+
+static void __stdcall EmuGetListPointer( UINT* ListNo, UINT* Pos )
+{
+    EMU_ENTRY;
+    *ListNo = Emu->InList;
+    *Pos    = Emu->InPos;
+
+}
+
+static void __stdcall EmuExecuteAtPointer( UINT Pos )              { EMU_ENTRY; Start( Pos ); }
+static void __stdcall EmuExecuteList( UINT ListNo )                { EMU_ENTRY; Start( ListStart( ListNo == 2 ? 2 : 1 ) ); }
+static void __stdcall EmuExecuteList1()                            { EmuExecuteList( 1 ); }
+static void __stdcall EmuExecuteList2()                            { EmuExecuteList( 2 ); }
+
+static void __stdcall EmuExecuteListPos( UINT ListNo, UINT Pos )
+{
+    EMU_ENTRY;
+    Start( ListStart( ListNo == 2 ? 2 : 1 ) + Pos );
+
+}
+
+static void __stdcall EmuGetOutPointer( UINT* ListNo, UINT* Pos )
+{
+    EMU_ENTRY;
+    *ListNo = Emu->ExecList;
+    *Pos    = Emu->Pc;
+
+}
+
+static void __stdcall EmuGetStatus( UINT* Status, UINT* Pos )
+{
+    EMU_ENTRY;
+
+    if ( Emu->Busy && ( Emu->Waiting || Emu->Paused ) )
+    {
+        *Status = 0x0100;
+
+    }
+    else
+    {
+        *Status = Emu->Busy ? 1 : 0;
+
+    }
+
+    *Pos = Emu->Pc;
+
+}
+
+static UINT __stdcall EmuReadStatus()
+{
+    EMU_ENTRY;
+
+    UINT Status = 0;
+
+    if ( Emu->InList == 1 ) Status |= 0x01;     //  LOAD1
+    if ( Emu->InList == 2 ) Status |= 0x02;     //  LOAD2
+
+    if ( Emu->Busy )
+    {
+        Status |= Emu->ExecList == 2 ? 0x20 : 0x10; //  BUSY1, BUSY2
+
+    }
+
+    return Status;
+
+}
+
+static UINT __stdcall EmuGetWaitStatus()                           { EMU_ENTRY; return Emu->Waiting ? Emu->WaitWord : 0; }
+static void __stdcall EmuStopExecution()                           { EMU_ENTRY; Stop(); }
+static void __stdcall EmuPauseList()                               { EMU_ENTRY; if ( Emu->Busy ) Emu->Paused = true; }
+
+static void __stdcall EmuRestartList()
+{
+    EMU_ENTRY;
+
+    if ( Emu->Paused )
+    {
+        Emu->Paused = false;
+        if ( Emu->CardTime < Emu->SimNow ) Emu->CardTime = Emu->SimNow;
+
+    }
+
+}
+
+static void __stdcall EmuReleaseWait()
+{
+    EMU_ENTRY;
+
+    if ( Emu->Waiting )
+    {
+        Emu->Waiting = false;
+        Emu->Pc = NextPos( Emu->Pc );
+        if ( Emu->CardTime < Emu->SimNow ) Emu->CardTime = Emu->SimNow;
+
+    }
+
+}
+
+static void __stdcall EmuSetExtStartPos( UINT Pos )                { EMU_ENTRY; Emu->ExtStartPos = Pos; }
+static void __stdcall EmuSetMaxCounts( UINT Counts )               { EMU_ENTRY; Emu->MaxCounts = Counts; Emu->Counts = 0; }
+static UINT __stdcall EmuGetCounts()                               { EMU_ENTRY; return Emu->Counts; }
+static void __stdcall EmuSetControlMode( UINT Mode )               { EMU_ENTRY; Emu->ControlMode = Mode; }
+static void __stdcall EmuSimulateExtStop()                         { EMU_ENTRY; Stop(); }
+static void __stdcall EmuSimulateExtStartCtrl()                    { (void) RTC5EmuExtStart(); }
+static UINT __stdcall EmuGetStartStopInfo()                        { EMU_ENTRY; return Emu->Busy ? 0x10 : 0; }
+
+static void __stdcall EmuSetSerialStep( UINT No, UINT Step )
+{
+    EMU_ENTRY;
+    Emu->Serial[ Emu->SerialSet ]     = No;
+    Emu->SerialStep[ Emu->SerialSet ] = Step;
+
+}
+
+static void   __stdcall EmuSelectSerialSet( UINT No )              { EMU_ENTRY; Emu->SerialSet = No % SerialSets; }
+static void   __stdcall EmuSetSerial( UINT No )                    { EMU_ENTRY; Emu->Serial[ Emu->SerialSet ] = No; }
+static double __stdcall EmuGetSerial()                             { EMU_ENTRY; return Emu->LastSerial; }
+
+static double __stdcall EmuGetListSerial( UINT* SetNo )
+{
+    EMU_ENTRY;
+    *SetNo = Emu->SerialSet;
+    return Emu->Serial[ Emu->SerialSet ];
+
+}
+
+static void __stdcall EmuSetFreeVariable( UINT VarNo, UINT Value ) { EMU_ENTRY; if ( VarNo < FreeVariables ) Emu->FreeVar[ VarNo ] = Value; }
+static UINT __stdcall EmuGetFreeVariable( UINT VarNo )             { EMU_ENTRY; return VarNo < FreeVariables ? Emu->FreeVar[ VarNo ] : 0; }
+
+static double __stdcall EmuGetTime()                               { EMU_ENTRY; return Emu->LastTime; }
+static double __stdcall EmuGetLapTime()                            { EMU_ENTRY; return Emu->CardTime - Emu->TimerStart; }
+
+//  List commands
+
+static void __stdcall EmuListNop()                                 { EMU_ENTRY; Put( ListMake( OpNop ) ); }
+static void __stdcall EmuListContinue()                            { EMU_ENTRY; Put( ListMake( OpListContinue ) ); }
+static void __stdcall EmuSetEndOfList()                            { EMU_ENTRY; Put( ListMake( OpEndOfList ) ); }
+static void __stdcall EmuListReturn()                              { EMU_ENTRY; Put( ListMake( OpListReturn ) ); }
+static void __stdcall EmuSetWait( UINT WaitWord )                  { EMU_ENTRY; Put( ListMake( OpSetWait, WaitWord ) ); }
+static void __stdcall EmuLongDelay( UINT Delay )                   { EMU_ENTRY; Put( ListMake( OpLongDelay, Delay ) ); }
+static void __stdcall EmuListJumpPos( UINT Pos )                   { EMU_ENTRY; Put( ListMake( OpListJumpPos, Pos ) ); }
+static void __stdcall EmuJumpAbs( LONG X, LONG Y )                 { EMU_ENTRY; Put( ListMake( OpJumpAbs, X, Y ) ); }
+static void __stdcall EmuJumpRel( LONG dX, LONG dY )               { EMU_ENTRY; Put( ListMake( OpJumpRel, dX, dY ) ); }
+static void __stdcall EmuMarkAbs( LONG X, LONG Y )                 { EMU_ENTRY; Put( ListMake( OpMarkAbs, X, Y ) ); }
+static void __stdcall EmuJumpAbs3D( LONG X, LONG Y, LONG Z )       { EMU_ENTRY; Put( ListMake( OpJumpAbs3D, X, Y, Z ) ); }
+static void __stdcall EmuMarkAbs3D( LONG X, LONG Y, LONG Z )       { EMU_ENTRY; Put( ListMake( OpMarkAbs3D, X, Y, Z ) ); }
+static void __stdcall EmuSetDefocusList( LONG Shift )              { EMU_ENTRY; Put( ListMake( OpSetDefocus, Shift ) ); }
+static void __stdcall EmuMarkRel( LONG dX, LONG dY )               { EMU_ENTRY; Put( ListMake( OpMarkRel, dX, dY ) ); }
+static void __stdcall EmuSetJumpSpeed( double Speed )              { EMU_ENTRY; Put( ListMakeD( OpSetJumpSpeed, Speed ) ); }
+static void __stdcall EmuSetMarkSpeed( double Speed )              { EMU_ENTRY; Put( ListMakeD( OpSetMarkSpeed, Speed ) ); }
+static void __stdcall EmuSetScannerDelays( UINT Jump, UINT Mark, UINT Polygon ) { EMU_ENTRY; Put( ListMake( OpSetScannerDelays, Jump, Mark, Polygon ) ); }
+static void __stdcall EmuSetLaserDelays( LONG On, UINT Off )       { EMU_ENTRY; Put( ListMake( OpSetLaserDelays, On, Off ) ); }
+static void __stdcall EmuSetLaserPulses( UINT Half, UINT Length )  { EMU_ENTRY; Put( ListMake( OpSetLaserPulses, Half, Length ) ); }
+static void __stdcall EmuSetFirstPulseKillerList( UINT Length )    { EMU_ENTRY; Put( ListMake( OpSetFirstPulseKiller, Length ) ); }
+static void __stdcall EmuSubCall( UINT Index )                     { EMU_ENTRY; Put( ListMake( OpSubCall, Index ) ); }
+static void __stdcall EmuSubCallAbs( UINT Index )                  { EMU_ENTRY; Put( ListMake( OpSubCallAbs, Index ) ); }
+static void __stdcall EmuListCall( UINT Pos )                      { EMU_ENTRY; Put( ListMake( OpListCall, Pos ) ); }
+static void __stdcall EmuListCallAbs( UINT Pos )                   { EMU_ENTRY; Put( ListMake( OpListCallAbs, Pos ) ); }
+static void __stdcall EmuSelectCharSet( UINT No )                  { EMU_ENTRY; Put( ListMake( OpSelectCharSet, No ) ); }
+static void __stdcall EmuMarkText( const char* Text )              { EMU_ENTRY; PutText( OpMarkText, Text ); }
+static void __stdcall EmuMarkTextAbs( const char* Text )           { EMU_ENTRY; PutText( OpMarkTextAbs, Text ); }
+static void __stdcall EmuMarkChar( UINT Char )                     { EMU_ENTRY; Put( ListMake( OpMarkChar, Char ) ); }
+static void __stdcall EmuMarkCharAbs( UINT Char )                  { EMU_ENTRY; Put( ListMake( OpMarkCharAbs, Char ) ); }
+static void __stdcall EmuMarkSerial( UINT Mode, UINT Digits )      { EMU_ENTRY; Put( ListMake( OpMarkSerial, Mode, Digits ) ); }
+static void __stdcall EmuMarkSerialAbs( UINT Mode, UINT Digits )   { EMU_ENTRY; Put( ListMake( OpMarkSerialAbs, Mode, Digits ) ); }
+static void __stdcall EmuMarkDate( UINT Part, UINT Mode )          { EMU_ENTRY; Put( ListMake( OpMarkDate, Part, Mode ) ); }
+static void __stdcall EmuMarkDateAbs( UINT Part, UINT Mode )       { EMU_ENTRY; Put( ListMake( OpMarkDateAbs, Part, Mode ) ); }
+static void __stdcall EmuMarkTime( UINT Part, UINT Mode )          { EMU_ENTRY; Put( ListMake( OpMarkTime, Part, Mode ) ); }
+static void __stdcall EmuMarkTimeAbs( UINT Part, UINT Mode )       { EMU_ENTRY; Put( ListMake( OpMarkTimeAbs, Part, Mode ) ); }
+static void __stdcall EmuSelectSerialSetList( UINT No )            { EMU_ENTRY; Put( ListMake( OpSelectSerialSet, No ) ); }
+static void __stdcall EmuSetSerialStepList( UINT No, UINT Step )   { EMU_ENTRY; Put( ListMake( OpSetSerialStep, No, Step ) ); }
+static void __stdcall EmuSaveAndRestartTimer()                     { EMU_ENTRY; Put( ListMake( OpSaveAndRestartTimer ) ); }
+static void __stdcall EmuSetExtStartPosList( UINT Pos )            { EMU_ENTRY; Put( ListMake( OpSetExtStartPos, Pos ) ); }
+static void __stdcall EmuSetControlModeList( UINT Mode )           { EMU_ENTRY; Put( ListMake( OpSetControlMode, Mode ) ); }
+static void __stdcall EmuSetFreeVariableList( UINT VarNo, UINT Value ) { EMU_ENTRY; Put( ListMake( OpSetFreeVariable, VarNo, Value ) ); }
+
+static void __stdcall EmuSetOffsetList( UINT HeadNo, LONG X, LONG Y, UINT AtOnce )
+{
+    EMU_ENTRY;
+
+    ListCommand Cmd = ListMake( OpSetOffset, X, Y, AtOnce );
+    Cmd.Arg = (uint16_t) HeadNo;
+    Put( Cmd );
+
+}
+
+static void __stdcall EmuSetMatrixList( UINT HeadNo, UINT Ind1, UINT Ind2, double Mij, UINT AtOnce )
+{
+    EMU_ENTRY;
+
+    ListCommand Cmd = ListMake( OpSetMatrix, Ind1, Ind2, AtOnce );
+    Cmd.Arg    = (uint16_t) HeadNo;
+    Cmd.D[ 0 ] = Mij;
+    Put( Cmd );
+
+}
+
+static void __stdcall EmuArcAbs( LONG X, LONG Y, double Angle )   { EMU_ENTRY; ListCommand Cmd = ListMake( OpArcAbs, X, Y ); Cmd.D[ 0 ] = Angle; Put( Cmd ); }
+static void __stdcall EmuArcRel( LONG dX, LONG dY, double Angle ) { EMU_ENTRY; ListCommand Cmd = ListMake( OpArcRel, dX, dY ); Cmd.D[ 0 ] = Angle; Put( Cmd ); }
+static void __stdcall EmuSetPixel( UINT Pulse, UINT Analog )      { EMU_ENTRY; Put( ListMake( OpSetPixel, Pulse, Analog ) ); }
+static void __stdcall EmuSetNPixel( UINT Pulse, UINT Analog, UINT Number ) { EMU_ENTRY; Put( ListMake( OpSetNPixel, Pulse, Analog, Number ) ); }
+static void __stdcall EmuSetSkyWritingModeList( UINT Mode )        { EMU_ENTRY; Put( ListMake( OpSetSkyWritingMode, Mode ) ); }
+static void __stdcall EmuSetSkyWritingLimitList( double CosAngle ) { EMU_ENTRY; Put( ListMakeD( OpSetSkyWritingLimit, CosAngle ) ); }
+
+static void __stdcall EmuSetPixelLine( UINT Channel, UINT HalfPeriod, double dX, double dY )
+{
+    EMU_ENTRY;
+
+    ListCommand Cmd = ListMakeD( OpSetPixelLine, dX, dY );
+    Cmd.Arg    = (uint16_t) Channel;
+    Cmd.I[ 0 ] = HalfPeriod;
+    Put( Cmd );
+
+}
+
+static void __stdcall EmuSetDelayModeList( UINT VarPoly, UINT DirectMove3D, UINT EdgeLevel, UINT MinJumpDelay, UINT JumpLengthLimit )
+{
+    EMU_ENTRY;
+
+    ListCommand Cmd = ListMake( OpSetDelayMode, VarPoly, DirectMove3D, EdgeLevel );
+    Cmd.J[ 0 ] = MinJumpDelay;
+    Cmd.J[ 1 ] = JumpLengthLimit;
+    Put( Cmd );
+
+}
+
+static void __stdcall EmuSetSkyWritingParaList( double Timelag, LONG LaserOnShift, UINT Nprev, UINT Npost )
+{
+    EMU_ENTRY;
+
+    ListCommand Cmd = ListMake( OpSetSkyWritingPara, LaserOnShift, Nprev, Npost );
+    Cmd.D[ 0 ] = Timelag;
+    Put( Cmd );
+
+}
+
+//  Run-in and run-out of Timelag [us] each
+static void __stdcall EmuSetSkyWritingList( double Timelag, LONG LaserOnShift )
+{
+    EMU_ENTRY;
+
+    const UINT n = (UINT) ceil( Timelag / 10.0 );
+    ListCommand Cmd = ListMake( OpSetSkyWritingPara, LaserOnShift, n, n );
+    Cmd.D[ 0 ] = Timelag;
+    Put( Cmd );
+
+}
+
+static void __stdcall EmuSetTrigger( UINT Period, UINT Signal1, UINT Signal2 )
+{
+    EMU_ENTRY;
+
+    Put( ListMake( OpSetTrigger, Period, Signal1, Signal2 ) );
+
+}
+
+static void __stdcall EmuSetTrigger4( UINT Period, UINT Signal1, UINT Signal2, UINT Signal3, UINT Signal4 )
+{
+    EMU_ENTRY;
+
+    ListCommand Cmd = ListMake( OpSetTrigger4, Period, Signal1, Signal2 );
+    Cmd.J[ 2 ] = Signal3;
+    Cmd.J[ 3 ] = Signal4;
+    Put( Cmd );
+
+}
+
+static void __stdcall EmuMeasurementStatus( UINT* Busy, UINT* Pos )
+{
+    EMU_ENTRY;
+
+    if ( Busy ) *Busy = Emu->Measuring ? 1 : 0;
+    if ( Pos )  *Pos  = Emu->Samples;
+
+}
+
+static void __stdcall EmuGetWaveform( UINT Channel, UINT Number, ULONG_PTR Ptr )
+{
+    EMU_ENTRY;
+
+    if ( Channel < 1 || Channel > Emu->Channels || !Ptr )
+    {
+        Emu->LastError |= ErrParam;
+        Emu->AccError  |= ErrParam;
+        return;
+
+    }
+
+    const UINT n = Number < Emu->Samples ? Number : Emu->Samples;
+    memcpy( (LONG*) Ptr, Emu->Wave[ Channel - 1 ].data(), n * sizeof( LONG ) );
+
+}
+
+static void __stdcall EmuStopTrigger()                             { EMU_ENTRY; Emu->Measuring = false; }
+
+//  Stepper motors
+
+static void __stdcall EmuStepperInit( UINT No, UINT Period, LONG, LONG Pos, UINT, UINT, UINT )
+{
+    EMU_ENTRY;
+
+    if ( No < 1 || No > 2 || !Period )
+    {
+        Emu->LastError |= ErrParam;
+        Emu->AccError  |= ErrParam;
+        return;
+
+    }
+
+    const UINT m = No - 1;
+    Emu->StepPeriod[ m ] = Period;
+    Emu->StepFrom[ m ]   = Emu->StepTo[ m ] = Pos;
+    Emu->StepStart[ m ]  = Emu->SimNow;
+
+}
+
+static void __stdcall EmuStepperAbs( LONG Pos1, LONG Pos2, UINT )  { EMU_ENTRY; StepperMove( Pos1, Pos2, Emu->SimNow ); }
+static void __stdcall EmuStepperAbsList( LONG Pos1, LONG Pos2 )    { EMU_ENTRY; Put( ListMake( OpStepperAbs, Pos1, Pos2 ) ); }
+static void __stdcall EmuStepperWait( UINT No )                    { EMU_ENTRY; Put( ListMake( OpStepperWait, No ) ); }
+
+static void __stdcall EmuGetStepperStatus( UINT* Status1, LONG* Pos1, UINT* Status2, LONG* Pos2 )
+{
+    EMU_ENTRY;
+
+    UINT* Status[ 2 ] = { Status1, Status2 };
+    LONG* Pos[ 2 ]    = { Pos1, Pos2 };
+
+    for ( UINT m = 0; m < 2; m++ )
+    {
+        if ( Status[ m ] ) *Status[ m ] = Emu->SimNow < StepperEnd( m ) ? 1 : 0;
+        if ( Pos[ m ] )    *Pos[ m ]    = (LONG) floor( StepperAt( m, Emu->SimNow ) + 0.5 );
+
+    }
+
+}
+
+//  Encoders and marking on the fly
+
+static void __stdcall EmuSimulateEncoder( UINT EncoderNo )
+{
+    EMU_ENTRY;
+    EncoderRebase();
+
+    for ( UINT e = 0; e < 2; e++ ) Emu->EncSimulated[ e ] = ( EncoderNo >> e ) & 1;
+
+}
+
+static void __stdcall EmuGetEncoder( LONG* Encoder0, LONG* Encoder1 )
+{
+    EMU_ENTRY;
+
+    if ( Encoder0 ) *Encoder0 = EncoderCount( 0, Emu->SimNow );
+    if ( Encoder1 ) *Encoder1 = EncoderCount( 1, Emu->SimNow );
+
+}
+
+static void __stdcall EmuReadEncoder( LONG* Encoder0_1, LONG* Encoder1_1, LONG* Encoder0_2, LONG* Encoder1_2 )
+{
+    EMU_ENTRY;
+
+    if ( Encoder0_1 ) *Encoder0_1 = Emu->EncStored[ 0 ][ 0 ];
+    if ( Encoder1_1 ) *Encoder1_1 = Emu->EncStored[ 0 ][ 1 ];
+    if ( Encoder0_2 ) *Encoder0_2 = Emu->EncStored[ 1 ][ 0 ];
+    if ( Encoder1_2 ) *Encoder1_2 = Emu->EncStored[ 1 ][ 1 ];
+
+}
+
+static UINT __stdcall EmuGetMarkingInfo()                          { EMU_ENTRY; return Emu->MarkingInfo; }
+static void __stdcall EmuClearFlyOverflowCtrl( UINT Mode )         { EMU_ENTRY; Emu->MarkingInfo &= ~Mode; }
+static void __stdcall EmuSetFlyX( double ScaleX )                  { EMU_ENTRY; Put( ListMakeD( OpSetFlyX, ScaleX ) ); }
+static void __stdcall EmuFlyReturn( LONG X, LONG Y )               { EMU_ENTRY; Put( ListMake( OpFlyReturn, X, Y ) ); }
+static void __stdcall EmuWaitForEncoder( LONG Value, UINT EncoderNo )  { EMU_ENTRY; Put( ListMake( OpWaitForEncoder, Value, EncoderNo ) ); }
+static void __stdcall EmuStoreEncoder( UINT Pos )                  { EMU_ENTRY; Put( ListMake( OpStoreEncoder, Pos ) ); }
+
+static void __stdcall EmuActivateFlyXYEncoder( double ScaleX, double ScaleY, LONG EncX, LONG EncY )
+{
+    EMU_ENTRY;
+
+    ListCommand Cmd = ListMakeD( OpActivateFlyXYEncoder, ScaleX, ScaleY );
+    Cmd.I[ 0 ] = EncX;
+    Cmd.I[ 1 ] = EncY;
+    Put( Cmd );
+
+}
+
+//  Scan heads
+
+static void SwitchHead( UINT h, UINT a )
+{
+    if ( Emu->SimNow >= Emu->HeadSwitch[ h ][ a ] ) Emu->HeadData[ h ][ a ] = Emu->HeadNext[ h ][ a ];
+
+}
+
+static LONG ReadSignal( UINT Signal )
+{
+    if ( Signal == 7 ) return (LONG) floor( Emu->Timing.X + 0.5 );
+    if ( Signal == 8 ) return (LONG) floor( Emu->Timing.Y + 0.5 );
+    if ( Signal < 1 || Signal > 4 ) return 0;
+
+    const UINT h = ( Signal - 1 ) / 2;
+    const UINT a = ( Signal - 1 ) % 2;
+    SwitchHead( h, a );
+
+    UINT Word;
+
+    switch ( Emu->HeadData[ h ][ a ] )
+    {
+        case SendRealPos:   return (LONG) floor( ( Emu->Dynamics ? ( a ? Emu->Galvo.Y : Emu->Galvo.X )
+                                                             : ( a ? Emu->Timing.Y : Emu->Timing.X ) ) + 0.5 );
+        case 0x0500:        Word = 0x00F8; break;   //  status
+        case 0x0514:        Word = 380;    break;   //  galvo temperature [0.1 C]
+        case 0x0515:        Word = 350;    break;   //  head temperature [0.1 C]
+        case 0x0516:        Word = 1530;   break;   //  AGC [10 mV]
+        case 0x0517:        Word = 500;    break;   //  Vcc DSP [10 mV]
+        case 0x0518:        Word = 330;    break;   //  Vcc DSP IO
+        case 0x0519:        Word = 1500;   break;   //  Vcc analog
+        case 0x051A:        Word = 500;    break;   //  Vcc ADC
+        case 0x0522:        Word = 0x0A12; break;   //  firmware
+        default:            Word = 0;      break;   //  status 2 and unknown data
+
+    }
+
+    return (LONG) ( Word << 4 );
+
+}
+
+static void __stdcall EmuControlCommand( UINT Head, UINT Axis, UINT Data )
+{
+    EMU_ENTRY;
+
+    if ( Head < 1 || Head > 2 || Axis < 1 || Axis > 2 )
+    {
+        Emu->LastError |= ErrParam;
+        Emu->AccError  |= ErrParam;
+        return;
+
+    }
+
+    SwitchHead( Head - 1, Axis - 1 );
+    Emu->HeadNext[ Head - 1 ][ Axis - 1 ]   = Data;
+    Emu->HeadSwitch[ Head - 1 ][ Axis - 1 ] = Emu->SimNow + HeadLatency;
+
+}
+
+static LONG __stdcall EmuGetValue( UINT Signal )                   { EMU_ENTRY; return ReadSignal( Signal ); }
+
+//  Reads the four signals at SignalPtr at once
+static void __stdcall EmuGetValues( ULONG_PTR SignalPtr, ULONG_PTR ResultPtr )
+{
+    EMU_ENTRY;
+
+    if ( !SignalPtr || !ResultPtr )
+    {
+        Emu->LastError |= ErrParam;
+        Emu->AccError  |= ErrParam;
+        return;
+
+    }
+
+    const UINT* Signals = (const UINT*) SignalPtr;
+    LONG*       Results = (LONG*) ResultPtr;
+
+    for ( UINT i = 0; i < 4; i++ ) Results[ i ] = ReadSignal( Signals[ i ] );
+
+}
+
+static UINT __stdcall EmuGetHeadStatus( UINT Head )                { EMU_ENTRY; return Head == 1 || Head == 2 ? 0x0F : 0; }
+
+static void __stdcall EmuWriteDaXList( UINT x, UINT Value )
+{
+    EMU_ENTRY;
+
+    ListCommand Cmd = ListMake( OpWriteDaX, Value );
+    Cmd.Arg = (uint16_t) x;
+    Put( Cmd );
+
+}
+
+//  RTC5EmuOpen
+//
+//  Description:
+//
+//  Creates the emulated card and binds the function pointers of RTC5expl.h
+//  to it. Call it instead of RTC5open, close it by RTC5EmuClose.
+//
+//      Return      Meaning
+//
+//       0          Success
+//      -2          The emulator or the RTC5DLL is already in use
+//
+
+long RTC5EmuOpen( void )
+{
+    std::lock_guard< std::mutex > Guard( EmuLock );
+
+    if ( Emu || init_rtc5_dll ) return -2;
+
+    Emu = new Card;
+    Emu->RtcMode     = 5;
+    Emu->CardTime    = 0.0;
+    Emu->SimNow      = 0.0;
+    Emu->SimBase     = 0.0;
+    Emu->Scale       = 1.0;
+    Emu->CallLatency = 0.0;
+    Emu->TextBytes   = ListTextBytes;
+    Emu->WallBase    = std::chrono::steady_clock::now();
+    Emu->HostCalls   = 0;
+    Emu->Dynamics    = false;
+    ResetCard();
+
+    init_rtc5_dll               = EmuInitDll;
+    free_rtc5_dll               = EmuFreeDll;
+    set_rtc4_mode               = EmuSetRtc4Mode;
+    set_rtc5_mode               = EmuSetRtc5Mode;
+    get_rtc_mode                = EmuGetRtcMode;
+    get_error                   = EmuGetError;
+    get_last_error              = EmuGetLastError;
+    reset_error                 = EmuResetError;
+    n_get_last_error            = EmuNGetLastError;
+    n_reset_error               = EmuNResetError;
+    rtc5_count_cards            = EmuCountCards;
+    select_rtc                  = EmuSelectRtc;
+    acquire_rtc                 = EmuAcquireRtc;
+    release_rtc                 = EmuReleaseRtc;
+    get_dll_version             = EmuGetDllVersion;
+    load_program_file           = EmuLoadProgramFile;
+    n_load_program_file         = EmuNLoadProgramFile;
+    load_correction_file        = EmuLoadCorrectionFile;
+    load_varpolydelay           = EmuLoadVarPolyDelay;
+    n_load_varpolydelay         = EmuNLoadVarPolyDelay;
+    select_cor_table            = EmuSelectCorTable;
+    set_laser_mode              = EmuSetLaserMode;
+    set_laser_control           = EmuSetLaserControl;
+    set_standby                 = EmuSetStandby;
+    write_da_x                  = EmuWriteDaX;
+    time_update                 = EmuTimeUpdate;
+
+    config_list                 = EmuConfigList;
+    get_list_space              = EmuGetListSpace;
+    set_start_list_pos          = EmuSetStartListPos;
+    set_start_list              = EmuSetStartList;
+    set_start_list_1            = EmuSetStartList1;
+    set_start_list_2            = EmuSetStartList2;
+    load_list                   = EmuLoadList;
+    set_input_pointer           = EmuSetInputPointer;
+    get_input_pointer           = EmuGetInputPointer;
+    get_list_pointer            = EmuGetListPointer;
+    load_sub                    = EmuLoadSub;
+    load_char                   = EmuLoadChar;
+    load_text_table             = EmuLoadTextTable;
+    get_char_pointer            = EmuGetCharPointer;
+    get_sub_pointer             = EmuGetSubPointer;
+    get_text_table_pointer      = EmuGetTextTablePointer;
+    set_char_pointer            = EmuSetCharPointer;
+    set_sub_pointer             = EmuSetSubPointer;
+    set_text_table_pointer      = EmuSetTextTablePointer;
+
+    execute_at_pointer          = EmuExecuteAtPointer;
+    execute_list                = EmuExecuteList;
+    execute_list_1              = EmuExecuteList1;
+    execute_list_2              = EmuExecuteList2;
+    execute_list_pos            = EmuExecuteListPos;
+    get_out_pointer             = EmuGetOutPointer;
+    get_status                  = EmuGetStatus;
+    read_status                 = EmuReadStatus;
+    get_wait_status             = EmuGetWaitStatus;
+    stop_execution              = EmuStopExecution;
+    pause_list                  = EmuPauseList;
+    restart_list                = EmuRestartList;
+    release_wait                = EmuReleaseWait;
+
+    set_extstartpos             = EmuSetExtStartPos;
+    set_max_counts              = EmuSetMaxCounts;
+    get_counts                  = EmuGetCounts;
+    set_control_mode            = EmuSetControlMode;
+    simulate_ext_stop           = EmuSimulateExtStop;
+    simulate_ext_start_ctrl     = EmuSimulateExtStartCtrl;
+    get_startstop_info          = EmuGetStartStopInfo;
+
+    set_serial_step             = EmuSetSerialStep;
+    select_serial_set           = EmuSelectSerialSet;
+    set_serial                  = EmuSetSerial;
+    get_serial                  = EmuGetSerial;
+    get_list_serial             = EmuGetListSerial;
+    set_free_variable           = EmuSetFreeVariable;
+    get_free_variable           = EmuGetFreeVariable;
+    get_time                    = EmuGetTime;
+    get_lap_time                = EmuGetLapTime;
+
+    list_nop                    = EmuListNop;
+    list_continue               = EmuListContinue;
+    set_end_of_list             = EmuSetEndOfList;
+    list_return                 = EmuListReturn;
+    set_wait                    = EmuSetWait;
+    long_delay                  = EmuLongDelay;
+    list_jump_pos               = EmuListJumpPos;
+    jump_abs                    = EmuJumpAbs;
+    jump_rel                    = EmuJumpRel;
+    mark_abs                    = EmuMarkAbs;
+    mark_rel                    = EmuMarkRel;
+    jump_abs_3d                 = EmuJumpAbs3D;
+    mark_abs_3d                 = EmuMarkAbs3D;
+    set_defocus_list            = EmuSetDefocusList;
+    set_jump_speed              = EmuSetJumpSpeed;
+    set_mark_speed              = EmuSetMarkSpeed;
+    set_scanner_delays          = EmuSetScannerDelays;
+    set_laser_delays            = EmuSetLaserDelays;
+    set_laser_pulses            = EmuSetLaserPulses;
+    set_firstpulse_killer_list  = EmuSetFirstPulseKillerList;
+    write_da_x_list             = EmuWriteDaXList;
+    sub_call                    = EmuSubCall;
+    sub_call_abs                = EmuSubCallAbs;
+    list_call                   = EmuListCall;
+    list_call_abs               = EmuListCallAbs;
+    select_char_set             = EmuSelectCharSet;
+    mark_text                   = EmuMarkText;
+    mark_text_abs               = EmuMarkTextAbs;
+    mark_char                   = EmuMarkChar;
+    mark_char_abs               = EmuMarkCharAbs;
+    mark_serial                 = EmuMarkSerial;
+    mark_serial_abs             = EmuMarkSerialAbs;
+    mark_date                   = EmuMarkDate;
+    mark_date_abs               = EmuMarkDateAbs;
+    mark_time                   = EmuMarkTime;
+    mark_time_abs               = EmuMarkTimeAbs;
+    select_serial_set_list      = EmuSelectSerialSetList;
+    set_serial_step_list        = EmuSetSerialStepList;
+    save_and_restart_timer      = EmuSaveAndRestartTimer;
+    set_extstartpos_list        = EmuSetExtStartPosList;
+    set_control_mode_list       = EmuSetControlModeList;
+    set_free_variable_list      = EmuSetFreeVariableList;
+    set_offset_list             = EmuSetOffsetList;
+    set_matrix_list             = EmuSetMatrixList;
+    arc_abs                     = EmuArcAbs;
+    arc_rel                     = EmuArcRel;
+    set_pixel_line              = EmuSetPixelLine;
+    set_pixel                   = EmuSetPixel;
+    set_n_pixel                 = EmuSetNPixel;
+    set_delay_mode_list         = EmuSetDelayModeList;
+    set_sky_writing_para_list   = EmuSetSkyWritingParaList;
+    set_sky_writing_list        = EmuSetSkyWritingList;
+    set_sky_writing_mode_list   = EmuSetSkyWritingModeList;
+    set_sky_writing_limit_list  = EmuSetSkyWritingLimitList;
+    set_trigger                 = EmuSetTrigger;
+    set_trigger4                = EmuSetTrigger4;
+    measurement_status          = EmuMeasurementStatus;
+    get_waveform                = EmuGetWaveform;
+    stop_trigger                = EmuStopTrigger;
+    control_command             = EmuControlCommand;
+    get_value                   = EmuGetValue;
+    get_values                  = EmuGetValues;
+    get_head_status             = EmuGetHeadStatus;
+    stepper_init                = EmuStepperInit;
+    stepper_abs                 = EmuStepperAbs;
+    stepper_abs_list            = EmuStepperAbsList;
+    stepper_wait                = EmuStepperWait;
+    get_stepper_status          = EmuGetStepperStatus;
+    simulate_encoder            = EmuSimulateEncoder;
+    get_encoder                 = EmuGetEncoder;
+    read_encoder                = EmuReadEncoder;
+    get_marking_info            = EmuGetMarkingInfo;
+    clear_fly_overflow_ctrl     = EmuClearFlyOverflowCtrl;
+    set_fly_x                   = EmuSetFlyX;
+    activate_fly_xy_encoder     = EmuActivateFlyXYEncoder;
+    fly_return                  = EmuFlyReturn;
+    wait_for_encoder            = EmuWaitForEncoder;
+    store_encoder               = EmuStoreEncoder;
+
+    return 0;
+
+}
+
+//  RTC5EmuClose
+//
+//  Description:
+//
+//  Removes the emulated card. All function pointers bound by RTC5EmuOpen
+//  are reset to NULL.
+//
+
+void RTC5EmuClose( void )
+{
+    std::lock_guard< std::mutex > Guard( EmuLock );
+
+    if ( !Emu ) return;
+
+    //  All pointers of RTC5expl.h are reset, RTC5open may be used afterwards
+    init_rtc5_dll = 0;
+    free_rtc5_dll = 0;
+    set_rtc4_mode = 0; set_rtc5_mode = 0; get_rtc_mode = 0;
+    get_error = 0; get_last_error = 0; reset_error = 0;
+    n_get_last_error = 0; n_reset_error = 0;
+    rtc5_count_cards = 0; select_rtc = 0; acquire_rtc = 0; release_rtc = 0;
+    get_dll_version = 0; load_program_file = 0; n_load_program_file = 0;
+    load_correction_file = 0; select_cor_table = 0;
+    load_varpolydelay = 0; n_load_varpolydelay = 0;
+    set_laser_mode = 0; set_laser_control = 0; set_standby = 0; write_da_x = 0;
+    time_update = 0;
+    config_list = 0; get_list_space = 0; set_start_list_pos = 0; set_start_list = 0;
+    set_start_list_1 = 0; set_start_list_2 = 0; load_list = 0;
+    set_input_pointer = 0; get_input_pointer = 0; get_list_pointer = 0;
+    load_sub = 0; load_char = 0; load_text_table = 0;
+    get_char_pointer = 0; get_sub_pointer = 0; get_text_table_pointer = 0;
+    set_char_pointer = 0; set_sub_pointer = 0; set_text_table_pointer = 0;
+    execute_at_pointer = 0; execute_list = 0; execute_list_1 = 0; execute_list_2 = 0;
+    execute_list_pos = 0; get_out_pointer = 0; get_status = 0; read_status = 0;
+    get_wait_status = 0; stop_execution = 0; pause_list = 0; restart_list = 0;
+    release_wait = 0;
+    set_extstartpos = 0; set_max_counts = 0; get_counts = 0; set_control_mode = 0;
+    simulate_ext_stop = 0; simulate_ext_start_ctrl = 0; get_startstop_info = 0;
+    set_serial_step = 0; select_serial_set = 0; set_serial = 0; get_serial = 0;
+    get_list_serial = 0; set_free_variable = 0; get_free_variable = 0;
+    get_time = 0; get_lap_time = 0;
+    list_nop = 0; list_continue = 0; set_end_of_list = 0; list_return = 0;
+    set_wait = 0; long_delay = 0; list_jump_pos = 0;
+    jump_abs = 0; jump_rel = 0; mark_abs = 0; mark_rel = 0;
+    jump_abs_3d = 0; mark_abs_3d = 0; set_defocus_list = 0;
+    set_jump_speed = 0; set_mark_speed = 0; set_scanner_delays = 0;
+    set_laser_delays = 0; set_laser_pulses = 0; set_firstpulse_killer_list = 0;
+    write_da_x_list = 0;
+    sub_call = 0; sub_call_abs = 0; list_call = 0; list_call_abs = 0;
+    select_char_set = 0; mark_text = 0; mark_text_abs = 0; mark_char = 0; mark_char_abs = 0;
+    mark_serial = 0; mark_serial_abs = 0; mark_date = 0; mark_date_abs = 0;
+    mark_time = 0; mark_time_abs = 0;
+    select_serial_set_list = 0; set_serial_step_list = 0; save_and_restart_timer = 0;
+    set_extstartpos_list = 0; set_control_mode_list = 0; set_free_variable_list = 0;
+    set_offset_list = 0; set_matrix_list = 0;
+    arc_abs = 0; arc_rel = 0; set_pixel_line = 0; set_pixel = 0; set_n_pixel = 0;
+    set_delay_mode_list = 0; set_sky_writing_para_list = 0; set_sky_writing_list = 0;
+    set_sky_writing_mode_list = 0; set_sky_writing_limit_list = 0;
+    set_trigger = 0; set_trigger4 = 0; measurement_status = 0; get_waveform = 0; stop_trigger = 0;
+    control_command = 0; get_value = 0; get_values = 0; get_head_status = 0;
+    stepper_init = 0; stepper_abs = 0; stepper_abs_list = 0; stepper_wait = 0; get_stepper_status = 0;
+    simulate_encoder = 0; get_encoder = 0; read_encoder = 0; get_marking_info = 0; clear_fly_overflow_ctrl = 0;
+    set_fly_x = 0; activate_fly_xy_encoder = 0; fly_return = 0; wait_for_encoder = 0; store_encoder = 0;
+
+    delete Emu;
+    Emu = 0;
+
+}
+
+void RTC5EmuSetTimeScale( double Scale )
+{
+    std::lock_guard< std::mutex > Guard( EmuLock );
+
+    if ( !Emu ) return;
+
+    Emu->Scale    = Scale > 0.0 ? Scale : 0.0;
+    Emu->SimBase  = Emu->SimNow;
+    Emu->WallBase = std::chrono::steady_clock::now();
+
+}
+
+void RTC5EmuSetCallLatency( double Seconds )
+{
+    std::lock_guard< std::mutex > Guard( EmuLock );
+
+    if ( Emu ) Emu->CallLatency = Seconds > 0.0 ? Seconds : 0.0;
+
+}
+
+void RTC5EmuAdvance( double Seconds )
+{
+    std::lock_guard< std::mutex > Guard( EmuLock );
+
+    if ( !Emu || !( Seconds > 0.0 ) ) return;
+
+    Emu->SimBase += Seconds;
+    Emu->SimNow  += Seconds;
+    Run( Emu->SimNow );
+    Idle();
+
+}
+
+//  RTC5EmuSetEncoder
+//
+//  Description:
+//
+//  Sets the rate of an external encoder, e.g. of a conveyor, from the
+//  simulated time on. The count goes on from its value at that time. A
+//  simulated encoder counts at 1 MHz regardless.
+//
+
+void RTC5EmuSetTextBytes( UINT Bytes )
+{
+    std::lock_guard< std::mutex > Guard( EmuLock );
+
+    if ( Emu ) Emu->TextBytes = Bytes < 1 ? 1 : Bytes > ListTextBytes ? ListTextBytes : Bytes;
+
+}
+
+void RTC5EmuSetEncoder( UINT EncoderNo, double Rate )
+{
+    std::lock_guard< std::mutex > Guard( EmuLock );
+
+    if ( !Emu || EncoderNo > 1 ) return;
+
+    Sync( false );
+    EncoderRebase();
+    Emu->EncRate[ EncoderNo ] = Rate;
+    Run( Emu->SimNow );
+    Idle();
+
+}
+
+//  RTC5EmuRunToIdle
+//
+//  Description:
+//
+//  Lets simulated time pass until the card is no longer busy, i.e. it has
+//  finished, waits for set_wait, for the input pointer or for an encoder
+//  count not reached at the current rate. Used in free
+//  running mode for host waits which should not count as host calls.
+//
+
+void RTC5EmuRunToIdle( void )
+{
+    std::lock_guard< std::mutex > Guard( EmuLock );
+
+    if ( !Emu ) return;
+
+    Run( HUGE_VAL );
+
+    if ( Emu->CardTime > Emu->SimNow )
+    {
+        Emu->SimBase += Emu->CardTime - Emu->SimNow;
+        Emu->SimNow   = Emu->CardTime;
+
+    }
+
+    Idle();
+
+}
+
+//  RTC5EmuSetGalvo
+//
+//  Description:
+//
+//  Sets the dynamics of the head. The model is copied, configured and
+//  starts at rest at the output position. NULL removes it, the real
+//  position is the output position again.
+//
+
+void RTC5EmuSetGalvo( const GalvoModel* Model )
+{
+    std::lock_guard< std::mutex > Guard( EmuLock );
+
+    if ( !Emu ) return;
+
+    Emu->Dynamics = Model != 0;
+
+    if ( !Model ) return;
+
+    Emu->Galvo = *Model;
+    Emu->Galvo.Configure();
+    Emu->Galvo.Reset( Emu->Timing.X, Emu->Timing.Y );
+    Emu->GalvoTime = Emu->CardTime;
+
+}
+
+double RTC5EmuTime( void )
+{
+    std::lock_guard< std::mutex > Guard( EmuLock );
+
+    return Emu ? Emu->SimNow : 0.0;
+
+}
+
+uint64_t RTC5EmuHostCalls( void )
+{
+    std::lock_guard< std::mutex > Guard( EmuLock );
+
+    return Emu ? Emu->HostCalls : 0;
+
+}
+
+//  RTC5EmuExtStart
+//
+//  Description:
+//
+//  Activates the /START input. The card starts at the position set by
+//  set_extstartpos, if external starts are enabled (set_control_mode bit
+//  #0), the card is not busy and set_max_counts allows another start.
+//
+
+UINT RTC5EmuExtStart( void )
+{
+    std::lock_guard< std::mutex > Guard( EmuLock );
+
+    if ( !Emu ) return 0;
+
+    Sync( false );    //  a hardware input, no host call
+
+    if (   !( Emu->ControlMode & 1 ) || Emu->Busy
+        || ( Emu->MaxCounts && Emu->Counts >= Emu->MaxCounts )
+       )
+    {
+        return 0;
+
+    }
+
+    Emu->Counts++;
+    Start( Emu->ExtStartPos );
+
+    return 1;
+
+}
@@ -0,0 +1,58 @@
+//  File
+//      RTC5Emu.h
+//
+//  Abstract
+//      In-process emulation of a single RTC5 card.
+//      RTC5EmuOpen is used instead of RTC5open: it binds the function
+//      pointers of RTC5expl.h to the emulator, so programs written for
+//      explicit linking run unchanged without card and driver.
+//      The emulator keeps a list memory of ListCommand records, executes it
+//      in simulated time (10 us ticks) and counts every host call.
+//
+//      Time scale 1.0 runs the card in real time, time scale 0 runs it free:
+//      the simulated time advances by the modelled call latency on every
+//      host call and by RTC5EmuAdvance and RTC5EmuRunToIdle, the card runs
+//      concurrently up to the simulated time.
+//
+//      RTC5EmuSetGalvo gives the head the dynamics of a GalvoModel: the
+//      real position read by the status channels and measured by signals
+//      1 and 2 then lags the output position like a real scanner.
+//
+//      RTC5EmuSetEncoder lets an encoder count at a given rate, like the
+//      encoder of a conveyor for marking on the fly.
+//
+//      RTC5EmuSetTextBytes stores fewer characters of a text per list
+//      position, so a text takes more positions than the records of a
+//      ListJob hold it in, like on a card the host cannot count exactly.
+//
+//  Comment
+//      Functions of RTC5expl.h not emulated stay NULL after RTC5EmuOpen.
+//      Only card no. 1 exists, n_* functions are bound as far as the demos
+//      need them.
+//
+//  Necessary Sources
+//      RTC5Emu.h, RTC5Emu.cpp, RTC5Galvo.h, RTC5Galvo.cpp, RTC5List.h,
+//      RTC5Poly.h, RTC5Poly.cpp, RTC5Util.h, RTC5expl.h, RTC5expl.c
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+
+#include "RTC5Galvo.h"
+#include "RTC5expl.h"
+
+long     RTC5EmuOpen( void );                       //  0: success, -2: already open
+void     RTC5EmuClose( void );
+
+void     RTC5EmuSetTimeScale( double Scale );       //  simulated s per wall clock s, 0: free running
+void     RTC5EmuSetCallLatency( double Seconds );   //  host call overhead in free running mode
+void     RTC5EmuAdvance( double Seconds );          //  let simulated time pass
+void     RTC5EmuRunToIdle( void );                  //  let simulated time pass until the card is idle
+double   RTC5EmuTime( void );                       //  simulated time [s]
+uint64_t RTC5EmuHostCalls( void );                  //  number of RTC5 function calls so far
+UINT     RTC5EmuExtStart( void );                   //  /START input, 1 if the start was accepted
+void     RTC5EmuSetGalvo( const GalvoModel* Model );    //  NULL: the head is at the output position
+void     RTC5EmuSetEncoder( UINT EncoderNo, double Rate );  //  [counts/s] of external encoder 0 or 1
+void     RTC5EmuSetTextBytes( UINT Bytes );         //  characters per text position, 1 .. ListTextBytes
@@ -0,0 +1,234 @@
+//  File
+//      RTC5Feeder.cpp
+//
+//  Abstract
+//      Streaming of precompiled list commands into list 1
+//
+//  Comment
+//      In and Out are positions within list 1. The space left for loading
+//      is computed from the out pointer of the last poll, which is never
+//      ahead of the real one, so the input pointer cannot overtake it.
+//      LoadGap positions stay free as a safety margin, a chunk never ends
+//      between a text command and its text records.
+//
+//  Necessary Sources
+//      RTC5Feeder.h, RTC5Job.h, RTC5List.h, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <chrono>
+#include <thread>
+
+#include "RTC5Feeder.h"
+#include "RTC5Util.h"
+
+static const UINT LoadGap = 16;             //  free positions between input and out pointer
+
+ListFeeder::ListFeeder()
+    : PollInterval( 1e-3 ), Pause( SleepFor ), Records( 0 ), Chunks( 0 ), Polls( 0 ), Waits( 0 ),
+      Size( 0 ), Gap( 0 ), Begin( 0 ), In( 0 ), Out( 0 ), ErrorMask( 0 ),
+      Started( false ), WaitPending( false ), Flushing( false )
+{
+}
+
+//  Open
+//
+//  Description:
+//
+//  Prepares list 1 for streaming. The list is not started before StartGap
+//  positions are loaded or Finish is called.
+//
+//      Parameter   Meaning
+//
+//      ListSize    size of list 1 as configured by config_list
+//      StartGap    positions loaded ahead of the out pointer before the
+//                  list is started or released from set_wait
+//
+
+UINT ListFeeder::Open( UINT ListSize, UINT StartGap )
+{
+    if ( ListSize < 4 * LoadGap || StartGap + 2 * LoadGap > ListSize ) return FeedRangeError;
+
+    UINT Busy, Pos;
+    get_status( &Busy, &Pos );
+
+    if ( Busy ) return FeedBusy;
+
+    Size        = ListSize;
+    Gap         = StartGap;
+    Begin       = 0;
+    In          = 0;
+    Out         = 0;
+    Started     = false;
+    WaitPending = false;
+    Flushing    = false;
+    ErrorMask   = get_last_error();
+
+    set_start_list_pos( 1, 0 );
+
+    return FeedNoError;
+
+}
+
+UINT ListFeeder::Fill() const
+{
+    return ( In + Size - Out ) % Size;
+
+}
+
+UINT ListFeeder::Space() const
+{
+    const UINT Used = Fill() + LoadGap;
+
+    return Used < Size ? Size - Used : 0;
+
+}
+
+//  Poll
+//
+//  Description:
+//
+//  Reads the out pointer and starts, holds or releases the list as
+//  Demo2's PlotLine does.
+//
+
+void ListFeeder::Poll()
+{
+    UINT Busy, Pos;
+    get_status( &Busy, &Pos );
+    Polls++;
+
+    if ( !Started )
+    {
+        if ( Fill() >= Gap || Flushing )
+        {
+            execute_list_pos( 1, Begin );
+            Started = true;
+
+        }
+
+        return;
+
+    }
+
+    Out = Pos % Size;
+
+    //  List running: if the out pointer comes too close, let the list wait
+    if ( Busy == 0x0001 && !WaitPending && !Flushing && Fill() < Gap / 2 )
+    {
+        set_wait( FeedWaitWord );
+        In = get_input_pointer() % Size;
+        WaitPending = true;
+        Waits++;
+
+    }
+
+    //  List held by set_wait: release it, if the input pointer is far enough ahead
+    if (   !( Busy & 0x00ff ) && ( Busy & 0xff00 ) && WaitPending && ( Fill() > Gap || Flushing )
+        && get_wait_status() == FeedWaitWord
+       )
+    {
+        release_wait();
+        WaitPending = false;
+
+    }
+
+}
+
+//  Feed
+//
+//  Description:
+//
+//  Transfers Count records, waiting for space in list 1 as needed.
+//
+
+UINT ListFeeder::Feed( const ListCommand* Cmd, size_t Count )
+{
+    size_t i = 0;
+
+    while ( i < Count )
+    {
+        size_t n = Space();
+
+        //  Wait for a reasonable chunk instead of polling for every position
+        if ( n < Size / 8 && n < Count - i && Started )
+        {
+            Pause( PollInterval );
+            Poll();
+            continue;
+
+        }
+
+        if ( n > Count - i ) n = Count - i;
+
+        //  Text records stay with their text command
+        while ( n && i + n < Count && Cmd[ i + n ].Op == OpTextData ) n--;
+
+        //  The text does not fit yet, wait like for any other space
+        if ( !n )
+        {
+            Pause( PollInterval );
+            Poll();
+            continue;
+
+        }
+
+        ListReplay( Cmd + i, n );
+        In = get_input_pointer() % Size;
+        i += n;
+        Records += n;
+        Chunks++;
+
+        Poll();
+
+        if ( get_last_error() & ~ErrorMask ) return FeedCardError;
+
+    }
+
+    return FeedNoError;
+
+}
+
+UINT ListFeeder::Feed( const JobFile& Job )
+{
+    Setup.clear();
+    JobSetup( Job.Header(), Setup );
+
+    const UINT Error = Feed( Setup.data(), Setup.size() );
+
+    return Error ? Error : Feed( Job.Records(), Job.Count() );
+
+}
+
+//  Finish
+//
+//  Description:
+//
+//  Terminates the stream by set_end_of_list and waits until the card has
+//  executed it.
+//
+
+UINT ListFeeder::Finish()
+{
+    const ListCommand End = ListMake( OpEndOfList );
+    const UINT Error = Feed( &End, 1 );
+
+    Flushing = true;
+
+    UINT Busy, Pos;
+
+    for ( ;; )
+    {
+        Poll();
+        get_status( &Busy, &Pos );
+
+        if ( !Busy ) break;
+
+        Pause( PollInterval );
+
+    }
+
+    Out = In;
+    return Error ? Error : ( get_last_error() & ~ErrorMask ? FeedCardError : FeedNoError );
+
+}
@@ -0,0 +1,73 @@
+//  File
+//      RTC5Feeder.h
+//
+//  Abstract
+//      Streaming of precompiled list commands into list 1.
+//      The ListFeeder uses list 1 as a circular queue like Demo2 does:
+//      records are transferred in chunks as far as the list has space,
+//      the list is started as soon as StartGap positions are loaded, and
+//      set_wait holds the card if the out pointer comes too close to the
+//      input pointer. Jobs of any length stream through a small list.
+//
+//  Comment
+//      The feeder owns list 1 from Open until Finish returns. Records are
+//      read directly from the caller's memory, e.g. a mapped JobFile, and
+//      are neither copied nor parsed.
+//
+//  Necessary Sources
+//      RTC5Feeder.h, RTC5Feeder.cpp, RTC5Job.h, RTC5Job.cpp, RTC5List.h,
+//      RTC5List.cpp, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+
+#include "RTC5List.h"
+#include "RTC5Job.h"
+
+//  Error codes of the feeder
+const UINT   FeedNoError          =            0;
+const UINT   FeedBusy             =            1;   //  card busy on list 1
+const UINT   FeedRangeError       =            2;   //  list size or start gap out of range
+const UINT   FeedCardError        =            3;   //  RTC5 error while feeding, see get_last_error
+
+const UINT   FeedWaitWord         =            1;   //  set_wait of the feeder, other wait words are left alone
+
+class ListFeeder
+{
+public:
+    ListFeeder();
+
+    UINT Open( UINT ListSize, UINT StartGap = 1000 );
+    UINT Feed( const ListCommand* Cmd, size_t Count );
+    UINT Feed( const JobFile& Job );        //  parameters of the header, then the records
+    UINT Finish();                          //  set_end_of_list, wait for the end of the list
+
+    UINT Fill() const;                      //  positions loaded, not executed yet
+
+    double   PollInterval;                  //  pause while list 1 is full [s]
+    void   ( *Pause )( double Seconds );    //  sleeps by default
+
+    uint64_t Records;                       //  records transferred
+    uint64_t Chunks;                        //  ListReplay calls
+    uint64_t Polls;                         //  get_status calls
+    uint64_t Waits;                         //  set_wait inserted
+
+private:
+    void Poll();
+    UINT Space() const;
+
+    UINT Size;                              //  positions of list 1
+    UINT Gap;                               //  StartGap
+    UINT Begin;                             //  first position of the stream
+    UINT In;                                //  input pointer
+    UINT Out;                               //  out pointer at the last poll
+    UINT ErrorMask;
+    bool Started;
+    bool WaitPending;
+    bool Flushing;
+    ListJob Setup;                          //  parameters of a job header, kept from job to job
+
+};
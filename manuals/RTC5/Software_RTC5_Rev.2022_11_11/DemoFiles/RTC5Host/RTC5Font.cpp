@@ -0,0 +1,460 @@
+//  File
+//      RTC5Font.cpp
+//
+//  Abstract
+//      Compiled single-stroke fonts for the RTC5 character tables
+//
+//  Comment
+//      The Hershey font files (*.jhf) contain one glyph per line:
+//          columns 0..4    glyph number (ignored, the line order counts)
+//          columns 5..7    number of coordinate pairs incl. the bounds pair
+//          columns 8..9    left and right bound
+//          columns 10..    coordinate pairs, " R" lifts the pen
+//      Each coordinate is stored as a character offset to 'R', y points
+//      downwards. Long glyphs may be wrapped onto continuation lines.
+//
+//  Necessary Sources
+//      RTC5Font.h, RTC5List.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <string>
+
+#include "RTC5Font.h"
+#include "RTC5List.h"
+
+static const uint32_t GlyphStoreVersion = 1;
+
+GlyphStore::GlyphStore()
+{
+    memset( &Header, 0, sizeof( Header ) );
+    memcpy( Header.Magic, "RSF1", 4 );
+    Header.Version = GlyphStoreVersion;
+    memset( Index, 0xFF, sizeof( Index ) );
+
+}
+
+//  CompileHershey
+//
+//  Description:
+//
+//  Reads a Hershey font file and converts it into the glyph store.
+//  The glyphs are assigned to consecutive character codes in the order
+//  they appear in the file, starting with FirstCode (32 for the usual
+//  ASCII ordered files like futural.jhf).
+//
+//
+//      Parameter   Meaning
+//
+//      Name        path of the *.jhf file
+//
+//      FirstCode   character code of the first glyph in the file
+//
+//      Return      FontNoError, FontFileError or FontFormatError
+//
+
+UINT GlyphStore::CompileHershey( const char* Name, UINT FirstCode )
+{
+    FILE* File = fopen( Name, "rb" );
+
+    if ( !File ) return FontFileError;
+
+    Glyphs.clear();
+    Vertex.clear();
+
+    std::string Line;
+    char        Buffer[ 1024 ];
+    UINT        Code = FirstCode;
+    UINT        Error = FontNoError;
+
+    while ( !Error && fgets( Buffer, sizeof( Buffer ), File ) )
+    {
+        Line = Buffer;
+
+        while ( !Line.empty() && ( Line[ Line.size() - 1 ] == '\n' || Line[ Line.size() - 1 ] == '\r' ) )
+        {
+            Line.erase( Line.size() - 1 );
+
+        }
+
+        if ( Line.size() < 10 ) continue;       //  blank or trailing line
+
+        const UINT Pairs = (UINT) atoi( Line.substr( 5, 3 ).c_str() );
+
+        //  Append the continuation lines of a wrapped glyph
+        while ( Line.size() < 8 + 2 * Pairs && fgets( Buffer, sizeof( Buffer ), File ) )
+        {
+            std::string Next( Buffer );
+
+            while ( !Next.empty() && ( Next[ Next.size() - 1 ] == '\n' || Next[ Next.size() - 1 ] == '\r' ) )
+            {
+                Next.erase( Next.size() - 1 );
+
+            }
+
+            Line += Next;
+
+        }
+
+        if ( !Pairs || Line.size() < 8 + 2 * Pairs || Code >= FontCharsPerSet )
+        {
+            Error = FontFormatError;
+            break;
+
+        }
+
+        const int Left  = Line[ 8 ] - 'R';
+        const int Right = Line[ 9 ] - 'R';
+
+        GlyphRecord Glyph;
+        Glyph.Code        = (uint16_t) Code++;
+        Glyph.Left        = (int8_t) Left;
+        Glyph.Advance     = (uint8_t) ( Right - Left );
+        Glyph.FirstVertex = (uint32_t) Vertex.size();
+        Glyph.VertexCount = 0;
+        Glyph.Reserved    = 0;
+
+        for ( UINT i = 1; i < Pairs; i++ )
+        {
+            const char cx = Line[ 8 + 2 * i ];
+            const char cy = Line[ 9 + 2 * i ];
+            GlyphVertex v;
+
+            if ( cx == ' ' && cy == 'R' )
+            {
+                v.x = (int8_t) FontPenUp;
+                v.y = 0;
+
+            }
+            else
+            {
+                v.x = (int8_t) ( cx - 'R' - Left );     //  origin at the left bound
+                v.y = (int8_t) -( cy - 'R' );           //  y upwards
+
+            }
+
+            Vertex.push_back( v );
+            Glyph.VertexCount++;
+
+        }
+
+        Glyphs.push_back( Glyph );
+
+    }
+
+    fclose( File );
+
+    if ( !Error && Glyphs.empty() ) Error = FontFormatError;
+    if ( !Error ) Finish();
+
+    return Error;
+
+}
+
+//  Save
+//
+//  Description:
+//
+//  Writes the compiled glyph store. The file is read back by Load
+//  without any further parsing.
+//
+
+UINT GlyphStore::Save( const char* Name ) const
+{
+    FILE* File = fopen( Name, "wb" );
+
+    if ( !File ) return FontFileError;
+
+    bool Ok = fwrite( &Header, sizeof( Header ), 1, File ) == 1;
+    if ( Ok && !Glyphs.empty() ) Ok = fwrite( &Glyphs[ 0 ], sizeof( GlyphRecord ), Glyphs.size(), File ) == Glyphs.size();
+    if ( Ok && !Vertex.empty() ) Ok = fwrite( &Vertex[ 0 ], sizeof( GlyphVertex ), Vertex.size(), File ) == Vertex.size();
+
+    if ( fclose( File ) ) Ok = false;
+
+    return Ok ? FontNoError : FontFileError;
+
+}
+
+//  Load
+//
+//  Description:
+//
+//  Reads a glyph store written by Save and verifies its hash. Counts
+//  beyond the size of the file and a code given twice are format errors.
+//
+
+UINT GlyphStore::Load( const char* Name )
+{
+    FILE* File = fopen( Name, "rb" );
+
+    if ( !File ) return FontFileError;
+
+    GlyphStoreHeader h;
+    UINT Error = FontNoError;
+
+    if (   fread( &h, sizeof( h ), 1, File ) != 1
+        || memcmp( h.Magic, "RSF1", 4 )
+        || h.Version != GlyphStoreVersion
+        || h.GlyphCount > FontCharsPerSet
+       )
+    {
+        Error = FontFormatError;
+
+    }
+    else
+    {
+        //  The counts must fit into the rest of the file before anything is allocated
+        const long Begin = ftell( File );
+        long       End   = -1;
+
+        if ( Begin >= 0 && !fseek( File, 0, SEEK_END ) ) End = ftell( File );
+
+        if (   End < Begin
+            || fseek( File, Begin, SEEK_SET )
+            ||   (uint64_t) h.GlyphCount * sizeof( GlyphRecord ) + (uint64_t) h.VertexCount * sizeof( GlyphVertex )
+               > (uint64_t) ( End - Begin )
+           )
+        {
+            Error = FontFormatError;
+
+        }
+
+    }
+
+    if ( !Error )
+    {
+        Glyphs.resize( h.GlyphCount );
+        Vertex.resize( h.VertexCount );
+
+        if (   ( h.GlyphCount  && fread( &Glyphs[ 0 ], sizeof( GlyphRecord ), h.GlyphCount,  File ) != h.GlyphCount  )
+            || ( h.VertexCount && fread( &Vertex[ 0 ], sizeof( GlyphVertex ), h.VertexCount, File ) != h.VertexCount )
+           )
+        {
+            Error = FontFormatError;
+
+        }
+
+    }
+
+    fclose( File );
+
+    if ( !Error )
+    {
+        bool Seen[ FontCharsPerSet ] = { false };
+
+        for ( size_t i = 0; i < Glyphs.size() && !Error; i++ )
+        {
+            if (   Glyphs[ i ].Code >= FontCharsPerSet
+                || Seen[ Glyphs[ i ].Code ]
+                || (uint64_t) Glyphs[ i ].FirstVertex + Glyphs[ i ].VertexCount > Vertex.size()
+               )
+            {
+                Error = FontFormatError;
+
+            }
+            else
+            {
+                Seen[ Glyphs[ i ].Code ] = true;
+
+            }
+
+        }
+
+    }
+
+    if ( !Error )
+    {
+        Finish();
+
+        if ( Header.Hash != h.Hash ) Error = FontFormatError;
+
+    }
+
+    if ( Error )
+    {
+        Glyphs.clear();
+        Vertex.clear();
+        Finish();
+
+    }
+
+    return Error;
+
+}
+
+//  Finish
+//
+//  Description:
+//
+//  Rebuilds the code index, the vertical extent and the hash
+//  after the glyphs have been changed.
+//
+
+void GlyphStore::Finish()
+{
+    memset( Index, 0xFF, sizeof( Index ) );
+
+    int32_t Top = 0, Bottom = 0;
+    bool    First = true;
+
+    for ( size_t i = 0; i < Glyphs.size(); i++ )
+    {
+        Index[ Glyphs[ i ].Code ] = (int16_t) i;
+
+    }
+
+    for ( size_t i = 0; i < Vertex.size(); i++ )
+    {
+        if ( (uint8_t) Vertex[ i ].x == FontPenUp ) continue;
+
+        if ( First || Vertex[ i ].y > Top    ) Top    = Vertex[ i ].y;
+        if ( First || Vertex[ i ].y < Bottom ) Bottom = Vertex[ i ].y;
+        First = false;
+
+    }
+
+    Header.GlyphCount  = (uint32_t) Glyphs.size();
+    Header.VertexCount = (uint32_t) Vertex.size();
+    Header.Top         = Top;
+    Header.Bottom      = Bottom;
+
+    uint64_t Hash = ListHashBytes( 0, 0 );
+    if ( !Glyphs.empty() ) Hash = ListHashBytes( &Glyphs[ 0 ], Glyphs.size() * sizeof( GlyphRecord ), Hash );
+    if ( !Vertex.empty() ) Hash = ListHashBytes( &Vertex[ 0 ], Vertex.size() * sizeof( GlyphVertex ), Hash );
+    Header.Hash = Hash;
+
+}
+
+const GlyphRecord* GlyphStore::Find( UINT Code ) const
+{
+    if ( Code >= FontCharsPerSet || Index[ Code ] < 0 ) return 0;
+
+    return &Glyphs[ Index[ Code ] ];
+
+}
+
+const GlyphVertex* GlyphStore::Vertices( const GlyphRecord& Glyph ) const
+{
+    return Glyph.VertexCount ? &Vertex[ Glyph.FirstVertex ] : 0;
+
+}
+
+//  TextWidth
+//
+//  Description:
+//
+//  Returns the length [bits] of the text when marked with mark_text.
+//  Characters missing in the store do not advance.
+//
+
+double GlyphStore::TextWidth( const char* Text, double BitsPerUnit ) const
+{
+    double Width = 0.0;
+
+    for ( ; *Text; Text++ )
+    {
+        const GlyphRecord* Glyph = Find( (unsigned char) *Text );
+
+        if ( Glyph ) Width += Glyph->Advance * BitsPerUnit;
+
+    }
+
+    return Width;
+
+}
+
+//  LoadCharSet
+//
+//  Description:
+//
+//  Transfers all glyphs of the store to the character set CharSet of the
+//  current card. Each glyph is written with relative commands only and
+//  ends with a jump to the next character's origin, so both mark_text and
+//  mark_text_abs can be used. The hot spot of a character is the left end
+//  of the lowest point of the font.
+//  A tag derived from the store's hash, the scale and the character set is
+//  kept in the free variable TagVariable of the card. If the card already
+//  holds the same tag, the transfer is skipped.
+//
+//
+//      Parameter   Meaning
+//
+//      Store       compiled glyph store
+//
+//      CharSet     character set 0..3, select it by select_char_set
+//
+//      BitsPerUnit scale factor from font units to bits
+//
+//      TagVariable number of the free variable reserved for the tag
+//
+//      Reloaded    optional, set to true if the glyphs have been transferred
+//
+//  NOTE
+//      load_program_file clears the character tables and the free variables,
+//      a subsequent call will transfer the glyphs again.
+
+UINT LoadCharSet( const GlyphStore& Store, UINT CharSet, double BitsPerUnit,
+                  UINT TagVariable, bool* Reloaded )
+{
+    if ( Reloaded ) *Reloaded = false;
+
+    if ( CharSet >= FontCharSets || !( BitsPerUnit > 0.0 ) ) return FontRangeError;
+
+    const uint64_t Scale = (uint64_t) llround( BitsPerUnit * 65536.0 );
+    const uint64_t Key   = ListHashBytes( &CharSet, sizeof( CharSet ), ListHashBytes( &Scale, sizeof( Scale ), Store.Hash() ) );
+    UINT           Tag   = (UINT) ( Key ^ ( Key >> 32 ) );
+
+    if ( !Tag ) Tag = 1;    //  0 is the value of an unused free variable
+
+    if ( get_free_variable( TagVariable ) == Tag ) return FontNoError;
+
+    for ( UINT Code = 0; Code < FontCharsPerSet; Code++ )
+    {
+        const GlyphRecord* Glyph = Store.Find( Code );
+
+        if ( !Glyph ) continue;
+
+        load_char( CharSet * FontCharsPerSet + Code );
+
+        const GlyphVertex* v = Store.Vertices( *Glyph );
+        LONG x = 0, y = 0;      //  current position relative to the hot spot
+        bool PenUp = true;
+
+        for ( UINT i = 0; i < Glyph->VertexCount; i++, v++ )
+        {
+            if ( (uint8_t) v->x == FontPenUp )
+            {
+                PenUp = true;
+                continue;
+
+            }
+
+            const LONG tx = (LONG) lround( v->x * BitsPerUnit );
+            const LONG ty = (LONG) lround( ( v->y - Store.Bottom() ) * BitsPerUnit );
+
+            if ( PenUp ) jump_rel( tx - x, ty - y );
+            else         mark_rel( tx - x, ty - y );
+
+            x = tx;
+            y = ty;
+            PenUp = false;
+
+        }
+
+        jump_rel( (LONG) lround( Glyph->Advance * BitsPerUnit ) - x, -y );
+        list_return();
+
+    }
+
+    set_free_variable( TagVariable, Tag );
+
+    if ( Reloaded ) *Reloaded = true;
+
+    return FontNoError;
+
+}
@@ -0,0 +1,94 @@
+//  File
+//      RTC5Font.h
+//
+//  Abstract
+//      Compiled single-stroke fonts for the RTC5 character tables.
+//      A GlyphStore is compiled once from a Hershey font file (*.jhf)
+//      into a compact binary file with precomputed advance widths and a
+//      content hash. LoadCharSet transfers the whole store to one of the
+//      four character sets of the RTC5 via load_char, so a string is
+//      marked by a single mark_text command afterwards.
+//
+//  Necessary Sources
+//      RTC5Font.h, RTC5Font.cpp, RTC5List.h, RTC5List.cpp, RTC5expl.h,
+//      RTC5expl.c
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "RTC5expl.h"
+
+//  Error codes of the font functions
+const UINT   FontNoError          =            0;
+const UINT   FontFileError        =            1;   //  file not found or not writable
+const UINT   FontFormatError      =            2;   //  invalid font or glyph store file
+const UINT   FontRangeError       =            3;   //  parameter out of range
+
+const UINT   FontCharSets         =            4;   //  RTC5 character sets 0..3
+const UINT   FontCharsPerSet      =          256;
+const UINT   FontPenUp            =         0x80;   //  vertex x value of a pen up
+
+//  Glyph store file layout (little endian, all records naturally aligned):
+//      GlyphStoreHeader
+//      GlyphRecord[ GlyphCount ]
+//      GlyphVertex[ VertexCount ]
+struct GlyphStoreHeader
+{
+    char     Magic[ 4 ];        //  "RSF1"
+    uint32_t Version;
+    uint32_t GlyphCount;
+    uint32_t VertexCount;
+    int32_t  Top;               //  highest point of all glyphs [font units]
+    int32_t  Bottom;            //  lowest point of all glyphs [font units]
+    uint64_t Hash;              //  FNV-1a of the glyph records and vertices
+};
+
+struct GlyphRecord
+{
+    uint16_t Code;              //  character code 0..255
+    int8_t   Left;              //  left side bearing [font units]
+    uint8_t  Advance;           //  advance width [font units]
+    uint32_t FirstVertex;       //  index into the vertex array
+    uint16_t VertexCount;
+    uint16_t Reserved;
+};
+
+//  One vertex in font units, y pointing upwards.
+//  x == (int8_t) FontPenUp lifts the pen before the next vertex.
+struct GlyphVertex { int8_t x, y; };
+
+class GlyphStore
+{
+public:
+    GlyphStore();
+
+    UINT CompileHershey( const char* Name, UINT FirstCode = 32 );
+    UINT Save( const char* Name ) const;
+    UINT Load( const char* Name );
+
+    const GlyphRecord*  Find( UINT Code ) const;
+    const GlyphVertex*  Vertices( const GlyphRecord& Glyph ) const;
+    double              TextWidth( const char* Text, double BitsPerUnit ) const;
+
+    UINT     GlyphCount()  const { return (UINT) Glyphs.size(); }
+    UINT     VertexCount() const { return (UINT) Vertex.size(); }
+    uint64_t Hash()        const { return Header.Hash; }
+    int32_t  Bottom()      const { return Header.Bottom; }
+    int32_t  Height()      const { return Header.Top - Header.Bottom; }
+
+private:
+    void     Finish();
+
+    GlyphStoreHeader          Header;
+    std::vector< GlyphRecord > Glyphs;
+    std::vector< GlyphVertex > Vertex;
+    int16_t                   Index[ FontCharsPerSet ];   //  Code -> Glyphs, -1 if missing
+
+};
+
+UINT LoadCharSet( const GlyphStore& Store, UINT CharSet, double BitsPerUnit,
+                  UINT TagVariable, bool* Reloaded = 0 );
@@ -0,0 +1,280 @@
+//  File
+//      RTC5Galvo.cpp
+//
+//  Abstract
+//      Dynamics of a galvanometer scanner
+//
+//  Comment
+//      Per axis x'' = w^2 ( u - x ) - 2 Damping w x', u the command of
+//      Delay periods before, moved towards x to within MaxError. With u
+//      held constant over a period the error e = ( x - u, x' ) evolves as
+//      e( t + Tick ) = exp( A Tick ) e( t ), the matrix exponential is
+//      taken by a Taylor series of A Tick / 16 squared four times. If the
+//      velocity changes by more than MaxAccel allows, the change is cut
+//      and the position follows with the mean velocity of the period.
+//      The limits make the step inexact, Delay does not.
+//      The default of 2 kHz, damping 0.8 gives a tracking delay of
+//      2 Damping / w = 127 us, no dead time and no limits.
+//
+//  Necessary Sources
+//      RTC5Galvo.h, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "RTC5Galvo.h"
+#include "RTC5Util.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define GALVO_SSE2
+#include <emmintrin.h>
+#endif
+
+static const double NoLimit              =        1e300;
+static const double RestError            =         1e-4;   //  [bits] settled
+static const double RestSpeed            =         1e-2;   //  [bits/s] settled
+static const int    Squarings            =            4;
+static const int    Terms                =           12;
+
+static void Multiply( const double a[ 2 ][ 2 ], const double b[ 2 ][ 2 ], double c[ 2 ][ 2 ] )
+{
+    double r[ 2 ][ 2 ];
+
+    for ( int i = 0; i < 2; i++ )
+    {
+        for ( int j = 0; j < 2; j++ ) r[ i ][ j ] = a[ i ][ 0 ] * b[ 0 ][ j ] + a[ i ][ 1 ] * b[ 1 ][ j ];
+
+    }
+
+    memcpy( c, r, sizeof( r ) );
+
+}
+
+//  exp( A Tick ) of an axis
+static void Transition( double Frequency, double Damping, double Phi[ 2 ][ 2 ] )
+{
+    const double w = 2.0 * Pi * Frequency;
+    const double h = Tick / ( 1 << Squarings );
+    const double A[ 2 ][ 2 ] = { { 0.0, h }, { -w * w * h, -2.0 * Damping * w * h } };
+
+    double Term[ 2 ][ 2 ] = { { 1.0, 0.0 }, { 0.0, 1.0 } };
+    double Sum[ 2 ][ 2 ]  = { { 1.0, 0.0 }, { 0.0, 1.0 } };
+
+    for ( int k = 1; k <= Terms; k++ )
+    {
+        Multiply( Term, A, Term );
+
+        for ( int i = 0; i < 2; i++ )
+        {
+            for ( int j = 0; j < 2; j++ )
+            {
+                Term[ i ][ j ] /= k;
+                Sum[ i ][ j ]  += Term[ i ][ j ];
+
+            }
+
+        }
+
+    }
+
+    for ( int s = 0; s < Squarings; s++ ) Multiply( Sum, Sum, Sum );
+
+    memcpy( Phi, Sum, sizeof( Sum ) );
+
+}
+
+GalvoModel::GalvoModel()
+    : Vectorized( true )
+{
+    for ( UINT a = 0; a < 2; a++ )
+    {
+        Axis[ a ].Frequency = 2000.0;
+        Axis[ a ].Damping   = 0.8;
+        Axis[ a ].Delay     = 0;
+        Axis[ a ].MaxError  = 0.0;
+        Axis[ a ].MaxAccel  = 0.0;
+
+    }
+
+    Configure();
+    Reset();
+
+}
+
+void GalvoModel::Configure()
+{
+    for ( UINT a = 0; a < 2; a++ )
+    {
+        Transition( Axis[ a ].Frequency, Axis[ a ].Damping, Phi[ a ] );
+
+        if ( Axis[ a ].Delay >= GalvoHistory ) Axis[ a ].Delay = GalvoHistory - 1;
+
+        ErrorLimit[ a ] = Axis[ a ].MaxError > 0.0 ? Axis[ a ].MaxError : NoLimit;
+        StepLimit[ a ]  = Axis[ a ].MaxAccel > 0.0 ? Axis[ a ].MaxAccel * Tick : NoLimit;
+
+    }
+
+}
+
+void GalvoModel::Reset( double PosX, double PosY )
+{
+    X  = PosX;
+    Y  = PosY;
+    VX = VY = 0.0;
+    Head = 0;
+
+    for ( UINT i = 0; i < GalvoHistory; i++ )
+    {
+        History[ 0 ][ i ] = PosX;
+        History[ 1 ][ i ] = PosY;
+
+    }
+
+}
+
+void GalvoModel::Step( double CmdX, double CmdY )
+{
+    double rX, rY;
+    Run( &CmdX, &CmdY, 1, &rX, &rY );
+
+}
+
+bool GalvoModel::Settled( double CmdX, double CmdY ) const
+{
+    if ( fabs( X - CmdX ) > RestError || fabs( Y - CmdY ) > RestError ) return false;
+    if ( fabs( VX ) > RestSpeed || fabs( VY ) > RestSpeed ) return false;
+
+    for ( UINT a = 0; a < 2; a++ )
+    {
+        const double Cmd = a ? CmdY : CmdX;
+
+        for ( UINT d = 1; d <= Axis[ a ].Delay; d++ )
+        {
+            if ( History[ a ][ ( Head - d ) & ( GalvoHistory - 1 ) ] != Cmd ) return false;
+
+        }
+
+    }
+
+    return true;
+
+}
+
+//  Run
+//
+//  Description:
+//
+//  Steps Count periods.
+//
+//      Parameter   Meaning
+//
+//      CmdX, CmdY  command of each period
+//      RealX       receives the real position at the end of each period,
+//      RealY       may be NULL
+//
+
+void GalvoModel::Run( const double* CmdX, const double* CmdY, size_t Count, double* RealX, double* RealY )
+{
+    //  e = x - u within the error limit, so u + Phi00 e = x + ( Phi00 - 1 ) e,
+    //  the velocity changes by dv = Phi10 e + ( Phi11 - 1 ) v
+    const UINT Mask = GalvoHistory - 1;
+    const UINT DX = Axis[ 0 ].Delay, DY = Axis[ 1 ].Delay;
+    UINT h = Head;
+    size_t i = 0;
+
+#ifdef GALVO_SSE2
+    if ( Vectorized )
+    {
+        const __m128d q00  = _mm_set_pd( Phi[ 1 ][ 0 ][ 0 ] - 1.0, Phi[ 0 ][ 0 ][ 0 ] - 1.0 );
+        const __m128d p01  = _mm_set_pd( Phi[ 1 ][ 0 ][ 1 ], Phi[ 0 ][ 0 ][ 1 ] );
+        const __m128d p10  = _mm_set_pd( Phi[ 1 ][ 1 ][ 0 ], Phi[ 0 ][ 1 ][ 0 ] );
+        const __m128d q11  = _mm_set_pd( Phi[ 1 ][ 1 ][ 1 ] - 1.0, Phi[ 0 ][ 1 ][ 1 ] - 1.0 );
+        const __m128d emax = _mm_set_pd( ErrorLimit[ 1 ], ErrorLimit[ 0 ] );
+        const __m128d emin = _mm_sub_pd( _mm_setzero_pd(), emax );
+        const __m128d dmax = _mm_set_pd( StepLimit[ 1 ], StepLimit[ 0 ] );
+        const __m128d dmin = _mm_sub_pd( _mm_setzero_pd(), dmax );
+        const __m128d Half = _mm_set1_pd( 0.5 * Tick );
+
+        __m128d x = _mm_set_pd( Y, X );
+        __m128d v = _mm_set_pd( VY, VX );
+
+        for ( ; i < Count; i++, h++ )
+        {
+            History[ 0 ][ h & Mask ] = CmdX[ i ];
+            History[ 1 ][ h & Mask ] = CmdY[ i ];
+
+            const __m128d u  = _mm_set_pd( History[ 1 ][ ( h - DY ) & Mask ], History[ 0 ][ ( h - DX ) & Mask ] );
+            const __m128d e  = _mm_min_pd( _mm_max_pd( _mm_sub_pd( x, u ), emin ), emax );
+            const __m128d dv = _mm_add_pd( _mm_mul_pd( p10, e ), _mm_mul_pd( q11, v ) );
+            const __m128d dc = _mm_min_pd( _mm_max_pd( dv, dmin ), dmax );
+            const __m128d Cut = _mm_cmpneq_pd( dv, dc );
+
+            //  A lane over the acceleration limit moves by the mean velocity
+            if ( _mm_movemask_pd( Cut ) )
+            {
+                const __m128d x1 = _mm_add_pd( x, _mm_add_pd( _mm_mul_pd( q00, e ), _mm_mul_pd( p01, v ) ) );
+                const __m128d xc = _mm_add_pd( x, _mm_mul_pd( _mm_add_pd( _mm_add_pd( v, v ), dc ), Half ) );
+                x = _mm_or_pd( _mm_and_pd( Cut, xc ), _mm_andnot_pd( Cut, x1 ) );
+
+            }
+            else
+            {
+                x = _mm_add_pd( x, _mm_add_pd( _mm_mul_pd( q00, e ), _mm_mul_pd( p01, v ) ) );
+
+            }
+
+            v = _mm_add_pd( v, dc );
+
+            if ( RealX ) _mm_storel_pd( RealX + i, x );
+            if ( RealY ) _mm_storeh_pd( RealY + i, x );
+
+        }
+
+        double r[ 2 ];
+        _mm_storeu_pd( r, x );
+        X = r[ 0 ];
+        Y = r[ 1 ];
+        _mm_storeu_pd( r, v );
+        VX = r[ 0 ];
+        VY = r[ 1 ];
+
+    }
+#endif
+
+    double x[ 2 ] = { X, Y }, v[ 2 ] = { VX, VY };
+
+    for ( ; i < Count; i++, h++ )
+    {
+        History[ 0 ][ h & Mask ] = CmdX[ i ];
+        History[ 1 ][ h & Mask ] = CmdY[ i ];
+
+        for ( UINT a = 0; a < 2; a++ )
+        {
+            const double u  = History[ a ][ ( h - ( a ? DY : DX ) ) & Mask ];
+            const double e  = std::min( std::max( x[ a ] - u, -ErrorLimit[ a ] ), ErrorLimit[ a ] );
+            const double dv = Phi[ a ][ 1 ][ 0 ] * e + ( Phi[ a ][ 1 ][ 1 ] - 1.0 ) * v[ a ];
+            const double dc = std::min( std::max( dv, -StepLimit[ a ] ), StepLimit[ a ] );
+
+            if ( dc != dv ) x[ a ] = x[ a ] + ( ( v[ a ] + v[ a ] ) + dc ) * ( 0.5 * Tick );
+            else            x[ a ] = x[ a ] + ( ( Phi[ a ][ 0 ][ 0 ] - 1.0 ) * e + Phi[ a ][ 0 ][ 1 ] * v[ a ] );
+
+            v[ a ] = v[ a ] + dc;
+
+        }
+
+        if ( RealX ) RealX[ i ] = x[ 0 ];
+        if ( RealY ) RealY[ i ] = x[ 1 ];
+
+    }
+
+    X  = x[ 0 ];
+    Y  = x[ 1 ];
+    VX = v[ 0 ];
+    VY = v[ 1 ];
+    Head = h;
+
+}
@@ -0,0 +1,69 @@
+//  File
+//      RTC5Galvo.h
+//
+//  Abstract
+//      Dynamics of a galvanometer scanner.
+//      Each axis follows its command, seen Delay periods late, as a
+//      second-order system of natural frequency Frequency and damping
+//      Damping. The servo limits the tracking error to MaxError and the
+//      acceleration to MaxAccel. The GalvoModel steps both axes in the
+//      10 us periods of the card, e.g. to see where the head is while the
+//      laser is on. The emulator runs it for the real position of the
+//      head, see RTC5EmuSetGalvo.
+//
+//  Comment
+//      A step holds the command constant over the period and is exact for
+//      that as long as no limit applies, i.e. stable for any frequency.
+//      Configure computes the step from the axis parameters, call it after
+//      changing them. Run steps a block of periods with both axes in the
+//      lanes of SSE2 registers where available.
+//
+//  Necessary Sources
+//      RTC5Galvo.h, RTC5Galvo.cpp, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stddef.h>
+
+#include "RTC5expl.h"
+
+const UINT   GalvoHistory         =           64;   //  longest Delay + 1, a power of 2
+
+struct GalvoAxis
+{
+    double   Frequency;         //  [Hz] natural frequency
+    double   Damping;           //  1: critically damped
+    UINT     Delay;             //  [10 us] dead time of the command, below GalvoHistory
+    double   MaxError;          //  [bits] tracking error limit, 0: none
+    double   MaxAccel;          //  [bits/s^2] acceleration limit, 0: none
+
+};
+
+class GalvoModel
+{
+public:
+    GalvoModel();
+
+    void     Configure();
+    void     Reset( double X = 0.0, double Y = 0.0 );  //  at rest at X, Y
+    void     Step( double CmdX, double CmdY );          //  one period of 10 us
+    void     Run( const double* CmdX, const double* CmdY, size_t Count, double* RealX, double* RealY );
+    bool     Settled( double CmdX, double CmdY ) const; //  at rest at the command, steps change nothing
+
+    //  Settings
+    GalvoAxis Axis[ 2 ];                            //  X, Y
+    bool     Vectorized;                            //  false: scalar loop, for comparison
+
+    //  State
+    double   X, Y;                                  //  [bits] real position
+    double   VX, VY;                                //  [bits/s]
+
+private:
+    double   Phi[ 2 ][ 2 ][ 2 ];                    //  per axis, step of position error and velocity
+    double   ErrorLimit[ 2 ], StepLimit[ 2 ];       //  [bits], [bits/s] per period
+    double   History[ 2 ][ GalvoHistory ];          //  commands of the last periods
+    UINT     Head;                                  //  next entry of History
+
+};
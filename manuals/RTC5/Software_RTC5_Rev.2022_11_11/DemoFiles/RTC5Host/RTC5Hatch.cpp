@@ -0,0 +1,751 @@
+//  File
+//      RTC5Hatch.cpp
+//
+//  Abstract
+//      Hatching of areas for list command streams
+//
+//  Comment
+//      The lines of a pass lie at v = ( k + 0.5 ) Pitch in the rotated
+//      frame of the field, not of the region, so neighbouring regions are
+//      hatched on the same lines. An edge is crossed by the lines with
+//      Low <= v < High of its end points, a vertex on a line is crossed
+//      once and horizontal edges never.
+//      The active edges are a table of double columns: an edge enters as
+//      soon as a line reaches its lower end and is only marked dead by the
+//      intersection, the table is compacted when half of it is dead.
+//      Chains are built line by line: a span continues the first chain of
+//      the line below that overlaps it and was not continued yet, both
+//      sorted by their left ends.
+//      A link starts and ends on the contour. It is inside the region if
+//      it crosses no edge between its ends and its middle is inside by
+//      the even-odd rule; touching an edge counts as crossing, such links
+//      are jumped.
+//
+//  Necessary Sources
+//      RTC5Hatch.h, RTC5Feeder.h, RTC5Job.h, RTC5List.h, RTC5Util.h,
+//      RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "RTC5Hatch.h"
+#include "RTC5Util.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define HATCH_SSE2
+#include <emmintrin.h>
+#endif
+
+static const size_t MaxAhead             =           64;   //  regions hatched ahead of the writer per thread
+static const UINT   MaxArcChords         =         4096;
+static const size_t NoSpan               = (size_t) -1;
+
+//  HatchPass
+//
+//  The block of one region, the passes of all angles
+
+class HatchPass
+{
+public:
+    explicit HatchPass( const HatchEngine& e );
+
+    void     Region( const HatchRegion& r, ListJob& Out );
+
+    uint64_t Edges, Lines, Links, Jumps;
+
+private:
+    HatchPass& operator=( const HatchPass& );
+
+    struct Edge
+    {
+        double Low, High;       //  [bits] v of the lower and the upper end
+        double U, Slope;        //  u at Low, du / dv
+
+    };
+
+    struct Segment
+    {
+        double Low, High;       //  [bits] v of the lower and the upper end, equal if horizontal
+        double U0, V0, U1, V1;
+        size_t First, Last;     //  bands reached, Last excluded
+
+    };
+
+    struct Span
+    {
+        double U0, U1, V;
+        size_t Next;            //  of the chain
+
+    };
+
+    void     Pass( const HatchRegion& r, double Angle, ListJob& Out );
+    void     Band( double First, size_t Count );
+    bool     Inside( size_t b, double u0, double v0, double u1, double v1 ) const;
+    size_t   Intersect( double v );
+    void     Compact( double v );
+    void     Point( double X, double Y, bool Mark, ListJob& Out );
+    void     Move( double u, double v, bool Mark, ListJob& Out );
+
+    const HatchEngine& Engine;
+    std::vector< Edge > Sorted;
+    std::vector< Segment > Bounds;              //  all edges incl. horizontal
+    std::vector< size_t > BandStart, BandEdges; //  Bounds reaching between two lines, per band
+    std::vector< double > Low, High, U, Slope;  //  active edges
+    size_t   Active, Dead;
+    std::vector< double > Xs;
+    std::vector< Span > Spans;
+    std::vector< size_t > Heads, Below, Here;
+    double   Cos, Sin;
+    double   PosX, PosY;        //  [bits] of the last record
+    bool     Placed;
+
+};
+
+HatchPass::HatchPass( const HatchEngine& e )
+    : Edges( 0 ), Lines( 0 ), Links( 0 ), Jumps( 0 ), Engine( e ), Active( 0 ), Dead( 0 ), Cos( 1.0 ), Sin( 0.0 ),
+      PosX( 0.0 ), PosY( 0.0 ), Placed( false )
+{
+}
+
+void HatchPass::Point( double X, double Y, bool Mark, ListJob& Out )
+{
+    const LONG x = (LONG) floor( X + 0.5 ), y = (LONG) floor( Y + 0.5 );
+
+    if ( !Mark && Placed && x == (LONG) PosX && y == (LONG) PosY ) return;
+
+    Out.push_back( ListMake( Mark ? OpMarkAbs : OpJumpAbs, x, y ) );
+    if ( !Mark ) Jumps++;
+
+    PosX   = x;
+    PosY   = y;
+    Placed = true;
+
+}
+
+//  u, v of the rotated frame
+void HatchPass::Move( double u, double v, bool Mark, ListJob& Out )
+{
+    Point( u * Cos - v * Sin, u * Sin + v * Cos, Mark, Out );
+
+}
+
+void HatchPass::Region( const HatchRegion& r, ListJob& Out )
+{
+    Placed = false;
+
+    if ( Engine.Outline )
+    {
+        for ( size_t c = 0; c < r.size(); c++ )
+        {
+            const HatchContour& k = r[ c ];
+            if ( k.size() < 2 ) continue;
+
+            for ( size_t i = 0; i <= k.size(); i++ ) Point( k[ i % k.size() ].X, k[ i % k.size() ].Y, i > 0, Out );
+
+        }
+
+    }
+
+    for ( size_t a = 0; a < Engine.Angles.size(); a++ )
+    {
+        Pass( r, Engine.Angles[ a ], Out );
+        if ( Engine.CrossHatch ) Pass( r, Engine.Angles[ a ] + 90.0, Out );
+
+    }
+
+}
+
+//  Intersects the active edges with line v into Xs, returns the count
+size_t HatchPass::Intersect( double v )
+{
+    size_t n = 0, i = 0;
+    Edges += Active;
+
+#ifdef HATCH_SSE2
+    if ( Engine.Vectorized )
+    {
+        const __m128d V = _mm_set1_pd( v );
+        double x[ 2 ];
+
+        for ( ; i + 2 <= Active; i += 2 )
+        {
+            const __m128d d = _mm_sub_pd( V, _mm_loadu_pd( &Low[ i ] ) );
+            const int Mask  = _mm_movemask_pd( _mm_cmplt_pd( V, _mm_loadu_pd( &High[ i ] ) ) );
+
+            _mm_storeu_pd( x, _mm_add_pd( _mm_loadu_pd( &U[ i ] ), _mm_mul_pd( d, _mm_loadu_pd( &Slope[ i ] ) ) ) );
+
+            //  Both stored, the count advances past the live ones
+            Xs[ n ] = x[ 0 ];
+            n += Mask & 1;
+            Xs[ n ] = x[ 1 ];
+            n += Mask >> 1;
+
+        }
+
+    }
+#endif
+
+    for ( ; i < Active; i++ )
+    {
+        Xs[ n ] = U[ i ] + ( v - Low[ i ] ) * Slope[ i ];
+        n += v < High[ i ] ? 1 : 0;
+
+    }
+
+    Dead = Active - n;
+    return n;
+
+}
+
+//  Drops the edges below line v
+void HatchPass::Compact( double v )
+{
+    size_t n = 0;
+
+    for ( size_t i = 0; i < Active; i++ )
+    {
+        if ( High[ i ] <= v ) continue;
+
+        Low[ n ]   = Low[ i ];
+        High[ n ]  = High[ i ];
+        U[ n ]     = U[ i ];
+        Slope[ n ] = Slope[ i ];
+        n++;
+
+    }
+
+    Active = n;
+    Dead   = 0;
+
+}
+
+void HatchPass::Pass( const HatchRegion& r, double Angle, ListJob& Out )
+{
+    const double Pitch = Engine.Pitch;
+
+    Cos = cos( Angle * Pi / 180.0 );
+    Sin = sin( Angle * Pi / 180.0 );
+
+    //  Edge table in the rotated frame, lines horizontal
+    Sorted.clear();
+    Bounds.clear();
+
+    for ( size_t c = 0; c < r.size(); c++ )
+    {
+        const HatchContour& k = r[ c ];
+
+        for ( size_t i = 0; i < k.size(); i++ )
+        {
+            const HatchPoint& p = k[ i ];
+            const HatchPoint& q = k[ ( i + 1 ) % k.size() ];
+            const double u0 = p.X * Cos + p.Y * Sin, v0 = p.Y * Cos - p.X * Sin;
+            const double u1 = q.X * Cos + q.Y * Sin, v1 = q.Y * Cos - q.X * Sin;
+
+            const Segment b = { std::min( v0, v1 ), std::max( v0, v1 ), u0, v0, u1, v1, 0, 0 };
+            Bounds.push_back( b );
+
+            if ( v0 == v1 ) continue;
+
+            Edge e;
+            e.Low   = std::min( v0, v1 );
+            e.High  = std::max( v0, v1 );
+            e.U     = v0 < v1 ? u0 : u1;
+            e.Slope = ( u1 - u0 ) / ( v1 - v0 );
+            Sorted.push_back( e );
+
+        }
+
+    }
+
+    if ( Sorted.empty() ) return;
+
+    std::sort( Sorted.begin(), Sorted.end(), []( const Edge& a, const Edge& b ) { return a.Low < b.Low; } );
+
+    double Top = Sorted[ 0 ].High;
+    for ( size_t i = 1; i < Sorted.size(); i++ ) Top = std::max( Top, Sorted[ i ].High );
+
+    Low.resize( Sorted.size() );
+    High.resize( Sorted.size() );
+    U.resize( Sorted.size() );
+    Slope.resize( Sorted.size() );
+    Xs.resize( Sorted.size() + 2 );
+    Active = Dead = 0;
+
+    Spans.clear();
+    Heads.clear();
+    Below.clear();
+
+    //  Spans of every line, chained to those below
+    const double First = ceil( Sorted[ 0 ].Low / Pitch - 0.5 );
+    size_t Next = 0, Count = 0;
+
+    for ( double k = First; ( k + 0.5 ) * Pitch < Top; k++, Count++ )
+    {
+        const double v = ( k + 0.5 ) * Pitch;
+
+        if ( 2 * Dead > Active ) Compact( v );
+
+        for ( ; Next < Sorted.size() && Sorted[ Next ].Low <= v; Next++ )
+        {
+            const Edge& e = Sorted[ Next ];
+            if ( e.High <= v ) continue;
+
+            Low[ Active ]   = e.Low;
+            High[ Active ]  = e.High;
+            U[ Active ]     = e.U;
+            Slope[ Active ] = e.Slope;
+            Active++;
+
+        }
+
+        const size_t n = Intersect( v );
+        std::sort( Xs.begin(), Xs.begin() + n );
+
+        Here.clear();
+        size_t b = 0;
+
+        for ( size_t i = 0; i + 1 < n; i += 2 )
+        {
+            if ( Xs[ i + 1 ] - Xs[ i ] < 1.0 ) continue;
+
+            const Span s = { Xs[ i ], Xs[ i + 1 ], v, NoSpan };
+            const size_t j = Spans.size();
+            Spans.push_back( s );
+            Here.push_back( j );
+
+            while ( b < Below.size() && Spans[ Below[ b ] ].U1 < s.U0 ) b++;
+
+            if ( b < Below.size() && Spans[ Below[ b ] ].U0 <= s.U1 ) Spans[ Below[ b++ ] ].Next = j;
+            else Heads.push_back( j );
+
+        }
+
+        Below.swap( Here );
+
+    }
+
+    Out.reserve( Out.size() + 2 * Spans.size() );
+
+    if ( Engine.Serpentine && Engine.LinkDistance > 0.0 ) Band( ( First + 0.5 ) * Pitch, Count );
+
+    if ( !Engine.Serpentine )
+    {
+        for ( size_t i = 0; i < Spans.size(); i++ )
+        {
+            Move( Spans[ i ].U0, Spans[ i ].V, false, Out );
+            Move( Spans[ i ].U1, Spans[ i ].V, true, Out );
+            Lines++;
+
+        }
+
+        return;
+
+    }
+
+    for ( size_t h = 0; h < Heads.size(); h++ )
+    {
+        //  The chain starts at the end of its first span closer to the head
+        const Span& f = Spans[ Heads[ h ] ];
+        const double u = PosX * Cos + PosY * Sin, v = PosY * Cos - PosX * Sin;
+        bool Forward = !Placed || fabs( f.U0 - u ) + fabs( f.V - v ) <= fabs( f.U1 - u ) + fabs( f.V - v );
+        double LastU = 0.0, LastV = 0.0;
+
+        for ( size_t i = Heads[ h ]; i != NoSpan; i = Spans[ i ].Next )
+        {
+            const Span& s = Spans[ i ];
+            const double From = Forward ? s.U0 : s.U1, To = Forward ? s.U1 : s.U0;
+            const bool   Link = i != Heads[ h ] && Engine.LinkDistance > 0.0
+                             && hypot( From - LastU, s.V - LastV ) <= Engine.LinkDistance
+                             && Inside( (size_t) floor( LastV / Pitch - First ), LastU, LastV, From, s.V );
+
+            Move( From, s.V, Link, Out );
+            Move( To, s.V, true, Out );
+            Lines++;
+            if ( Link ) Links++;
+
+            LastU   = To;
+            LastV   = s.V;
+            Forward = !Forward;
+
+        }
+
+    }
+
+}
+
+//  Band
+//
+//  Description:
+//
+//  Sorts the edges into the Count - 1 bands between the lines, the first
+//  line at v = First. An edge is listed in every band it reaches into,
+//  touching included.
+//
+
+void HatchPass::Band( double First, size_t Count )
+{
+    const double Pitch = Engine.Pitch;
+    const size_t Bands = Count > 1 ? Count - 1 : 0;
+
+    BandStart.assign( Bands + 2, 0 );
+
+    for ( size_t i = 0; i < Bounds.size(); i++ )
+    {
+        Segment& k = Bounds[ i ];
+        const double b0 = std::max( ceil( ( k.Low - First ) / Pitch ) - 1.0, 0.0 );
+        const double b1 = std::min( floor( ( k.High - First ) / Pitch ) + 1.0, (double) Bands );
+
+        k.First = (size_t) b0;
+        k.Last  = b1 > b0 ? (size_t) b1 : k.First;
+
+        for ( size_t b = k.First; b < k.Last; b++ ) BandStart[ b + 2 ]++;
+
+    }
+
+    //  Counts to starts, shifted by one so the fill advances them to their final place
+    for ( size_t b = 2; b < Bands + 2; b++ ) BandStart[ b ] += BandStart[ b - 1 ];
+
+    BandEdges.resize( BandStart[ Bands + 1 ] );
+
+    for ( size_t i = 0; i < Bounds.size(); i++ )
+    {
+        for ( size_t b = Bounds[ i ].First; b < Bounds[ i ].Last; b++ ) BandEdges[ BandStart[ b + 1 ]++ ] = i;
+
+    }
+
+    BandStart.pop_back();
+
+}
+
+//  Inside
+//
+//  Description:
+//
+//  Tells whether the link from u0, v0 to u1, v1, both on the contour and
+//  on the lines of band b, lies within the region. The edges of the band
+//  are tested in the rotated frame. The ends of the link are moved
+//  inwards by Margin so the edges they lie on are not taken as crossed,
+//  a link along the edges stays on the contour.
+//
+
+bool HatchPass::Inside( size_t b, double u0, double v0, double u1, double v1 ) const
+{
+    const double Margin = 1e-3;                     //  [bits]
+    const double du = u1 - u0, dv = v1 - v0, Length = hypot( du, dv );
+
+    if ( Length <= 2.0 * Margin ) return true;
+    if ( b + 1 >= BandStart.size() ) return false;
+
+    const double e  = Margin / Length;
+    const double au = u0 + du * e, av = v0 + dv * e, bu = u1 - du * e, bv = v1 - dv * e;
+    const double mu = 0.5 * ( u0 + u1 ), mv = 0.5 * ( v0 + v1 );
+    bool In = false, OnContour = false;
+
+    for ( size_t j = BandStart[ b ]; j < BandStart[ b + 1 ]; j++ )
+    {
+        const Segment& k = Bounds[ BandEdges[ j ] ];
+
+        //  Even-odd rule for the middle, as the lines are crossed, a middle on the contour is inside
+        if ( k.Low <= mv && mv <= k.High && k.Low < k.High )
+        {
+            const double u = k.U0 + ( mv - k.V0 ) * ( k.U1 - k.U0 ) / ( k.V1 - k.V0 );
+
+            if ( fabs( u - mu ) <= Margin ) OnContour = true;
+            else if ( mv < k.High && u < mu ) In = !In;
+
+        }
+
+        const double d1 = du * ( k.V0 - av ) - dv * ( k.U0 - au ), d2 = du * ( k.V1 - av ) - dv * ( k.U1 - au );
+
+        if ( fabs( d1 ) <= Margin * Length && fabs( d2 ) <= Margin * Length ) continue;     //  along the edge
+
+        const double d3 = ( k.U1 - k.U0 ) * ( av - k.V0 ) - ( k.V1 - k.V0 ) * ( au - k.U0 );
+        const double d4 = ( k.U1 - k.U0 ) * ( bv - k.V0 ) - ( k.V1 - k.V0 ) * ( bu - k.U0 );
+
+        if ( d1 * d2 <= 0.0 && d3 * d4 <= 0.0 ) return false;
+
+    }
+
+    return In || OnContour;
+
+}
+
+HatchEngine::HatchEngine()
+    : Pitch( 100.0 ), Angles( 1, 0.0 ), CrossHatch( false ), Outline( true ), Serpentine( true ), LinkDistance( 0.0 ),
+      Closure( 2.0 ), Tolerance( 4.0 ), Threads( 0 ), Vectorized( true ), Edges( 0 ), Lines( 0 ), Links( 0 ), Jumps( 0 ),
+      Records( 0 ), FeedError( 0 ), HatchTime( 0.0 ), WriteTime( 0.0 )
+{
+}
+
+void HatchEngine::Clear()
+{
+    Regions.clear();
+
+}
+
+void HatchEngine::AddContour( const HatchContour& Contour, bool NewRegion )
+{
+    if ( NewRegion || Regions.empty() ) Regions.push_back( HatchRegion() );
+    Regions.back().push_back( Contour );
+
+}
+
+//  AddJob
+//
+//  Description:
+//
+//  Adds the closed polylines of jump_abs, jump_rel, mark_abs, mark_rel,
+//  arc_abs and arc_rel records, other records are skipped. A polyline is
+//  closed if it ends within Closure of its start. A contour overlapping
+//  the bounding box of the region before joins it, so the holes of a
+//  letter follow its outline.
+//
+
+void HatchEngine::AddJob( const ListCommand* Cmd, size_t Count )
+{
+    HatchContour Line;
+    double PosX = 0.0, PosY = 0.0;
+    double Box[ 4 ] = { 0.0, 0.0, 0.0, 0.0 };     //  of the last region added here
+    bool   Boxed = false;
+
+    auto Close = [ & ]()
+    {
+        //  A triangle at least, its last point on the first
+        if ( Line.size() > 3 && hypot( Line.back().X - Line[ 0 ].X, Line.back().Y - Line[ 0 ].Y ) <= Closure )
+        {
+            Line.pop_back();
+
+            double b[ 4 ] = { Line[ 0 ].X, Line[ 0 ].Y, Line[ 0 ].X, Line[ 0 ].Y };
+
+            for ( size_t i = 1; i < Line.size(); i++ )
+            {
+                b[ 0 ] = std::min( b[ 0 ], Line[ i ].X );
+                b[ 1 ] = std::min( b[ 1 ], Line[ i ].Y );
+                b[ 2 ] = std::max( b[ 2 ], Line[ i ].X );
+                b[ 3 ] = std::max( b[ 3 ], Line[ i ].Y );
+
+            }
+
+            const bool Join = Boxed && b[ 0 ] <= Box[ 2 ] && b[ 2 ] >= Box[ 0 ] && b[ 1 ] <= Box[ 3 ] && b[ 3 ] >= Box[ 1 ];
+
+            AddContour( Line, !Join );
+
+            if ( !Join ) for ( UINT j = 0; j < 4; j++ ) Box[ j ] = b[ j ];
+            else
+            {
+                Box[ 0 ] = std::min( Box[ 0 ], b[ 0 ] );
+                Box[ 1 ] = std::min( Box[ 1 ], b[ 1 ] );
+                Box[ 2 ] = std::max( Box[ 2 ], b[ 2 ] );
+                Box[ 3 ] = std::max( Box[ 3 ], b[ 3 ] );
+
+            }
+
+            Boxed = true;
+
+        }
+
+        Line.clear();
+
+    };
+
+    for ( size_t i = 0; i < Count; i++ )
+    {
+        const ListCommand& c = Cmd[ i ];
+        const bool Rel = c.Op == OpJumpRel || c.Op == OpMarkRel || c.Op == OpArcRel;
+        const double X = Rel ? PosX + c.I[ 0 ] : c.I[ 0 ], Y = Rel ? PosY + c.I[ 1 ] : c.I[ 1 ];
+
+        switch ( c.Op )
+        {
+        case OpJumpAbs:
+        case OpJumpRel:
+            Close();
+            PosX = X;
+            PosY = Y;
+            break;
+
+        case OpMarkAbs:
+        case OpMarkRel:
+        {
+            const HatchPoint From = { PosX, PosY }, To = { X, Y };
+            if ( Line.empty() ) Line.push_back( From );
+            Line.push_back( To );
+            PosX = X;
+            PosY = Y;
+            break;
+
+        }
+
+        case OpArcAbs:
+        case OpArcRel:
+        {
+            //  Clockwise for positive angles, as the card
+            const double a  = c.D[ 0 ] * Pi / 180.0;
+            const double vX = PosX - X, vY = PosY - Y;
+            const double r  = hypot( vX, vY );
+            const double Step = r > Tolerance ? 2.0 * acos( 1.0 - Tolerance / r ) : Pi;
+            const UINT   n  = (UINT) std::min( (double) MaxArcChords, std::max( 1.0, ceil( fabs( a ) / Step ) ) );
+            const HatchPoint From = { PosX, PosY };
+
+            if ( Line.empty() ) Line.push_back( From );
+
+            for ( UINT k = 1; k <= n; k++ )
+            {
+                const double b = a * k / n;
+                const HatchPoint p = { X + vX * cos( b ) + vY * sin( b ), Y + vY * cos( b ) - vX * sin( b ) };
+                Line.push_back( p );
+
+            }
+
+            PosX = Line.back().X;
+            PosY = Line.back().Y;
+            break;
+
+        }
+
+        default:
+            break;
+
+        }
+
+    }
+
+    Close();
+
+}
+
+UINT HatchEngine::Hatch( ListJob& Out )
+{
+    return Run( &Out, 0 );
+
+}
+
+UINT HatchEngine::Hatch( ListFeeder& Feeder )
+{
+    return Run( 0, &Feeder );
+
+}
+
+//  Run
+//
+//  Description:
+//
+//  The threads hatch the regions into blocks, the calling thread writes
+//  the blocks in the order of the regions as they are done and frees
+//  them. A thread waits while its region is more than MaxAhead regions
+//  per thread ahead of the writer.
+//
+//      Return                  Meaning
+//
+//      HatchNoError            all regions written
+//      HatchRangeError         Pitch not positive or Angles empty
+//      HatchFeedError          the ListFeeder failed with FeedError, the
+//                              regions before were written
+//
+
+UINT HatchEngine::Run( ListJob* Out, ListFeeder* Feeder )
+{
+    Edges = Lines = Links = Jumps = Records = 0;
+    FeedError = FeedNoError;
+    HatchTime = WriteTime = 0.0;
+
+    if ( !( Pitch > 0.0 ) || Angles.empty() ) return HatchRangeError;
+
+    const size_t Count = Regions.size();
+    const UINT   n     = (UINT) std::min( (size_t) std::max( 1u, Threads ? Threads : std::thread::hardware_concurrency() ),
+                                          std::max( Count, (size_t) 1 ) );
+    const auto   t0    = std::chrono::steady_clock::now();
+
+    std::vector< ListJob > Blocks( Count );
+    std::vector< uint8_t > Done( Count, 0 );
+    std::mutex Lock;
+    std::condition_variable Ready, Room;
+    std::atomic< size_t > Next( 0 );
+    size_t Written = 0, Hatched = 0;
+    bool   Abort = false;
+
+    auto Work = [ & ]()
+    {
+        HatchPass p( *this );
+
+        for ( size_t k; ( k = Next++ ) < Count; )
+        {
+            {
+                std::unique_lock< std::mutex > Guard( Lock );
+                Room.wait( Guard, [ & ]() { return Abort || k < Written + MaxAhead * n; } );
+                if ( Abort ) break;
+
+            }
+
+            ListJob Block;
+            p.Region( Regions[ k ], Block );
+
+            std::lock_guard< std::mutex > Guard( Lock );
+            Blocks[ k ].swap( Block );
+            Done[ k ] = 1;
+            if ( ++Hatched == Count ) HatchTime = Seconds( t0 );
+            Ready.notify_one();
+
+        }
+
+        std::lock_guard< std::mutex > Guard( Lock );
+        Edges += p.Edges;
+        Lines += p.Lines;
+        Links += p.Links;
+        Jumps += p.Jumps;
+
+    };
+
+    std::vector< std::thread > Workers;
+    for ( UINT t = 0; t < n; t++ ) Workers.push_back( std::thread( Work ) );
+
+    UINT Error = HatchNoError;
+
+    for ( size_t k = 0; k < Count; k++ )
+    {
+        ListJob Block;
+
+        {
+            std::unique_lock< std::mutex > Guard( Lock );
+            Ready.wait( Guard, [ & ]() { return Done[ k ] != 0; } );
+            Block.swap( Blocks[ k ] );
+
+        }
+
+        if ( Out ) Out->insert( Out->end(), Block.begin(), Block.end() );
+
+        if ( Feeder && !Block.empty() ) FeedError = Feeder->Feed( Block.data(), Block.size() );
+
+        Records += Block.size();
+
+        std::lock_guard< std::mutex > Guard( Lock );
+
+        if ( FeedError )
+        {
+            Error = HatchFeedError;
+            Abort = true;
+            Room.notify_all();
+            break;
+
+        }
+
+        Written = k + 1;
+        Room.notify_all();
+
+    }
+
+    for ( size_t t = 0; t < Workers.size(); t++ ) Workers[ t ].join();
+
+    if ( Count == 0 || Abort ) HatchTime = Seconds( t0 );
+    WriteTime = Seconds( t0 );
+
+    return Error;
+
+}
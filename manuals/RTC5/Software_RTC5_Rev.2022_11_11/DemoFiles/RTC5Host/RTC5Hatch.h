@@ -0,0 +1,107 @@
+//  File
+//      RTC5Hatch.h
+//
+//  Abstract
+//      Hatching of areas for list command streams.
+//      A HatchEngine fills regions bounded by closed contours with parallel
+//      lines of a given pitch at one or more angles, cross-hatched if
+//      requested, and writes them as jump_abs and mark_abs records into a
+//      job or straight into a ListFeeder. The contours come from a program
+//      by AddContour or from the closed polylines of a job by AddJob, e.g.
+//      a converted HPGL plot or the outlines of a font.
+//      A region is filled by the even-odd rule: an island within a hole
+//      within an outline is marked again.
+//
+//  Comment
+//      The regions are hatched in parallel, every thread takes one region
+//      after the other, and the blocks are written in the order of the
+//      regions while the threads go on. With a ListFeeder the list starts
+//      marking while the later regions are hatched.
+//      Per angle the region is rotated so that the lines are horizontal.
+//      The edges are sorted by their lowest point, the active ones are
+//      kept as a table of double columns and intersected with a line two
+//      at a time with SSE2 where available.
+//      Serpentine ordering follows chains of spans lying above each other
+//      and alternates their direction, two spans of a chain closer than
+//      LinkDistance are linked by a straight mark instead of a jump if the
+//      link stays within the region, e.g. not across the notch of a
+//      concave contour.
+//
+//  Necessary Sources
+//      RTC5Hatch.h, RTC5Hatch.cpp, RTC5Feeder.h, RTC5Feeder.cpp, RTC5Job.h,
+//      RTC5Job.cpp, RTC5List.h, RTC5List.cpp, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "RTC5Feeder.h"
+#include "RTC5List.h"
+
+//  Error codes of the engine
+const UINT   HatchNoError         =            0;
+const UINT   HatchRangeError      =            1;   //  pitch not positive or no angle
+const UINT   HatchFeedError       =            2;   //  ListFeeder error, see HatchEngine::FeedError
+
+struct HatchPoint
+{
+    double   X, Y;              //  [bits]
+
+};
+
+//  Closed, the last point is joined to the first
+typedef std::vector< HatchPoint > HatchContour;
+
+//  Contours filled together by the even-odd rule
+typedef std::vector< HatchContour > HatchRegion;
+
+class HatchEngine
+{
+public:
+    HatchEngine();
+
+    void     Clear();
+    void     AddContour( const HatchContour& Contour, bool NewRegion = true );
+    void     AddJob( const ListCommand* Cmd, size_t Count );
+
+    UINT     Hatch( ListJob& Out );
+    UINT     Hatch( ListFeeder& Feeder );           //  opened by the caller, not finished
+
+    //  Input, the contours of AddContour and AddJob
+    std::vector< HatchRegion > Regions;
+
+    //  Settings
+    double   Pitch;                                 //  [bits] between the lines
+    std::vector< double > Angles;                   //  [deg] of the lines, one pass per angle
+    bool     CrossHatch;                            //  a second pass at every angle + 90 deg
+    bool     Outline;                               //  mark the contours before the lines
+    bool     Serpentine;                            //  false: every line left to right in the order of the lines
+    double   LinkDistance;                          //  [bits] longest link marked inside the region, 0: jumps only
+    double   Closure;                               //  [bits] gap of a polyline of AddJob still closed
+    double   Tolerance;                             //  [bits] of the arc chords of AddJob
+    UINT     Threads;                               //  0: one per processor
+    bool     Vectorized;                            //  false: scalar loops, for comparison
+
+    //  Results
+    uint64_t Edges;                                 //  intersected, summed over the passes
+    uint64_t Lines;                                 //  spans marked
+    uint64_t Links;                                 //  spans joined by a mark
+    uint64_t Jumps;
+    uint64_t Records;                               //  written
+    UINT     FeedError;                             //  of the ListFeeder with HatchFeedError
+    double   HatchTime;                             //  [s] wall clock until the last region was hatched
+    double   WriteTime;                             //  [s] wall clock until the last block was written
+
+private:
+    HatchEngine( const HatchEngine& );
+    HatchEngine& operator=( const HatchEngine& );
+
+    friend class HatchPass;
+
+    UINT     Run( ListJob* Out, ListFeeder* Feeder );
+
+};
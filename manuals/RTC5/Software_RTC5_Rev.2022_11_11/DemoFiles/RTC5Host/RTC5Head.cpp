@@ -0,0 +1,294 @@
+//  File
+//      RTC5Head.cpp
+//
+//  Abstract
+//      Telemetry of intelliSCAN heads
+//
+//  Comment
+//      A round of a value costs, per head, two control_command and, with
+//      RestorePosition, two more, and one get_values for all heads. The
+//      polling thread sleeps for Settle instead of calling read_status.
+//      Rounds are started every Interval, a round taking longer delays
+//      the next one only.
+//
+//  Necessary Sources
+//      RTC5Head.h, RTC5Monitor.h, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <chrono>
+
+#include "RTC5Head.h"
+#include "RTC5Util.h"
+
+static const UINT   SendRealPos          =       0x0501;
+static const UINT   SendData[ HeadStatusWord ] =
+{
+    0x0500, 0x0512, 0x0514, 0x0515, 0x0516, 0x0517, 0x0518, 0x0519, 0x051A, 0x0522
+
+};
+
+static double SteadyClock()
+{
+    return std::chrono::duration< double >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+
+}
+
+HeadTelemetry::HeadTelemetry( size_t Capacity )
+    : Interval( 10e-3 ), Settle( 100e-6 ), Clock( SteadyClock ), Pause( SleepFor ), RestorePosition( true ),
+      Rounds( 0 ), Calls( 0 ), Dropped( 0 ), Mask( 0 ), StartTime( 0.0 ), Ring( Capacity ), RoundCount( 0 ),
+      CallCount( 0 ), Lost( 0 ), Stopping( false )
+{
+    for ( UINT h = 0; h < 2; h++ )
+    {
+        for ( UINT a = 0; a < 3; a++ )
+        {
+            for ( UINT v = 0; v < HeadValues; v++ ) Table[ h ][ a ][ v ] = 0;
+
+        }
+
+    }
+
+}
+
+HeadTelemetry::~HeadTelemetry()
+{
+    Stop();
+
+}
+
+//  Start
+//
+//  Description:
+//
+//  Starts polling. The values are polled one per round in the given order
+//  and again from the first, so each one is refreshed every Count rounds.
+//  The table and the history are cleared.
+//
+//      Parameter   Meaning
+//
+//      Heads       HeadA, HeadB or both
+//      Values      HeadStatus ... HeadStatusWord
+//      Count       number of Values
+//
+
+UINT HeadTelemetry::Start( UINT Heads, const UINT* Values, UINT Count )
+{
+    if ( Worker.joinable() ) return HeadBusy;
+    if ( !Heads || Heads > ( HeadA | HeadB ) || !Values || !Count ) return HeadRangeError;
+
+    for ( UINT i = 0; i < Count; i++ )
+    {
+        if ( Values[ i ] >= HeadValues ) return HeadRangeError;
+
+    }
+
+    for ( UINT h = 0; h < 2; h++ )
+    {
+        for ( UINT a = 0; a < 3; a++ )
+        {
+            for ( UINT v = 0; v < HeadValues; v++ ) Table[ h ][ a ][ v ].store( 0, std::memory_order_relaxed );
+
+        }
+
+    }
+
+    Mask       = Heads;
+    Selected.assign( Values, Values + Count );
+    StartTime  = Clock();
+    Rounds     = 0;
+    Calls      = 0;
+    Dropped    = 0;
+    RoundCount = 0;
+    CallCount  = 0;
+    Lost       = 0;
+    Stopping   = false;
+    History.clear();
+
+    Worker = std::thread( &HeadTelemetry::Run, this );
+
+    return HeadNoError;
+
+}
+
+void HeadTelemetry::Stop()
+{
+    if ( !Worker.joinable() ) return;
+
+    Stopping = true;
+    Worker.join();
+    Collect();
+
+}
+
+void HeadTelemetry::Run()
+{
+    double Next = Clock();
+
+    for ( size_t i = 0; ; i++ )
+    {
+        Round( Selected[ i % Selected.size() ] );
+        RoundCount++;
+
+        if ( Stopping ) break;
+
+        Next += Interval;
+        const double Wait = Next - Clock();
+
+        if ( Wait > 0.0 ) Pause( Wait );
+        else              Next = Clock();
+
+    }
+
+}
+
+//  Round
+//
+//  Description:
+//
+//  Reads one value of both axes of the heads polled.
+//
+//      Parameter   Meaning
+//
+//      Value       HeadStatus ... HeadStatusWord
+//
+
+void HeadTelemetry::Round( UINT Value )
+{
+    if ( Value == HeadStatusWord )
+    {
+        for ( UINT Head = 1; Head <= 2; Head++ )
+        {
+            if ( !( Mask & Head ) ) continue;
+
+            const UINT Word = get_head_status( Head );
+            Store( Head, 0, Value, (int16_t) Word, Clock() );
+            CallCount++;
+
+        }
+
+        return;
+
+    }
+
+    UINT Signals[ 4 ] = { 0, 0, 0, 0 };
+    LONG Results[ 4 ];
+
+    for ( UINT Head = 1; Head <= 2; Head++ )
+    {
+        if ( !( Mask & Head ) ) continue;
+
+        for ( UINT Axis = 1; Axis <= 2; Axis++ )
+        {
+            const UINT Channel = 2 * ( Head - 1 ) + Axis - 1;
+
+            control_command( Head, Axis, SendData[ Value ] );
+            Signals[ Channel ] = Channel + 1;   //  StatusAX, StatusAY, StatusBX, StatusBY
+            CallCount++;
+
+        }
+
+    }
+
+    Pause( Settle );
+
+    get_values( (ULONG_PTR) Signals, (ULONG_PTR) Results );
+    CallCount++;
+
+    const double Time = Clock();
+
+    for ( UINT Channel = 0; Channel < 4; Channel++ )
+    {
+        if ( !Signals[ Channel ] ) continue;
+
+        const UINT Head = Channel / 2 + 1;
+        const UINT Axis = Channel % 2 + 1;
+
+        Store( Head, Axis, Value, (int16_t) ( Results[ Channel ] >> 4 ), Time );
+
+        if ( RestorePosition )
+        {
+            control_command( Head, Axis, SendRealPos );
+            CallCount++;
+
+        }
+
+    }
+
+}
+
+void HeadTelemetry::Store( UINT Head, UINT Axis, UINT Value, int16_t Data, double Time )
+{
+    const uint64_t Stamp = (uint64_t) ( ( Time - StartTime ) * 1e6 ) + 1;
+
+    Table[ Head - 1 ][ Axis ][ Value ].store( Stamp << 16 | (uint16_t) Data, std::memory_order_release );
+
+    HeadSample s;
+    s.Time  = Time;
+    s.Head  = (uint16_t) Head;
+    s.Axis  = (uint16_t) Axis;
+    s.Value = (uint16_t) Value;
+    s.Data  = Data;
+
+    if ( !Ring.Push( s ) ) Lost++;
+
+}
+
+//  Latest
+//
+//  Description:
+//
+//  Returns the value read last. Data and Time belong to the same reading.
+//
+//      Parameter   Meaning
+//
+//      Head        1: A, 2: B
+//      Axis        1: X, 2: Y, 0 for HeadStatusWord
+//      Value       HeadStatus ... HeadStatusWord
+//      Data        receives the data word
+//      Time        receives the time it was read [s] of Clock, may be NULL
+//
+
+bool HeadTelemetry::Latest( UINT Head, UINT Axis, UINT Value, int16_t* Data, double* Time ) const
+{
+    if ( Head < 1 || Head > 2 || Axis > 2 || Value >= HeadValues ) return false;
+
+    const uint64_t Entry = Table[ Head - 1 ][ Axis ][ Value ].load( std::memory_order_acquire );
+
+    if ( !Entry ) return false;
+
+    *Data = (int16_t) ( Entry & 0xffff );
+    if ( Time ) *Time = StartTime + (double) ( ( Entry >> 16 ) - 1 ) * 1e-6;
+
+    return true;
+
+}
+
+double HeadTelemetry::Unit( UINT Value )
+{
+    if ( Value == HeadGalvoTemp || Value == HeadTemp ) return 0.1;
+    if ( Value >= HeadAGC && Value <= HeadVccADC )     return 0.01;
+
+    return 1.0;
+
+}
+
+//  Collect
+//
+//  Description:
+//
+//  Moves the values of the ring into History and updates the counters.
+//  Called by one thread at a time, and by Stop.
+//
+
+void HeadTelemetry::Collect()
+{
+    HeadSample s;
+
+    while ( Ring.Pop( s ) ) History.push_back( s );
+
+    Rounds  = RoundCount;
+    Calls   = CallCount;
+    Dropped = Lost;
+
+}
@@ -0,0 +1,117 @@
+//  File
+//      RTC5Head.h
+//
+//  Abstract
+//      Telemetry of intelliSCAN heads.
+//      Demo7 reads a value of the head by control_command, a wait of 100 us
+//      spent calling read_status ten times, and get_value, one value after
+//      the other on the thread driving the card. A HeadTelemetry polls the
+//      selected values of heads A and B on a thread of its own: per round
+//      it selects one value on all status channels, sleeps while the heads
+//      switch their data and reads the channels by one get_values. The
+//      head status word is read by get_head_status. The latest value of
+//      every head, axis and value is kept in a table any thread reads
+//      without a lock, all values read in a history ring.
+//
+//  Comment
+//      The status channels carry the real position again after a round if
+//      RestorePosition is set, as Demo7 leaves them. During a round they
+//      carry other data, so a measurement of signals 1 to 4 is only valid
+//      while the telemetry is stopped.
+//      Only the polling thread writes the table and the ring and only the
+//      thread calling Collect reads the ring. A full ring drops values and
+//      counts them.
+//
+//  Necessary Sources
+//      RTC5Head.h, RTC5Head.cpp, RTC5Monitor.h, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "RTC5Monitor.h"
+
+//  Error codes of the telemetry
+const UINT   HeadNoError          =            0;
+const UINT   HeadBusy             =            1;   //  polling thread running
+const UINT   HeadRangeError       =            2;   //  no head or value selected, value unknown
+
+//  Values of a head, Data is the code of control_command
+const UINT   HeadStatus           =            0;   //  Data 0x0500
+const UINT   HeadStatus2          =            1;   //  0x0512
+const UINT   HeadGalvoTemp        =            2;   //  0x0514, 1 bit = 0.1 C
+const UINT   HeadTemp             =            3;   //  0x0515, 1 bit = 0.1 C
+const UINT   HeadAGC              =            4;   //  0x0516, 1 bit = 10 mV
+const UINT   HeadVccDSP           =            5;   //  0x0517, supply voltages taken as 10 mV per bit
+const UINT   HeadVccDSPIO         =            6;   //  0x0518
+const UINT   HeadVccANA           =            7;   //  0x0519
+const UINT   HeadVccADC           =            8;   //  0x051A
+const UINT   HeadFirmware         =            9;   //  0x0522
+const UINT   HeadStatusWord       =           10;   //  get_head_status, Axis 0
+const UINT   HeadValues           =           11;
+
+const UINT   HeadA                =            1;   //  bits of the heads polled
+const UINT   HeadB                =            2;
+
+struct HeadSample
+{
+    double   Time;              //  [s] of Clock, when the value was read
+    uint16_t Head;              //  1: A, 2: B
+    uint16_t Axis;              //  1: X, 2: Y, 0 for HeadStatusWord
+    uint16_t Value;             //  HeadStatus...
+    int16_t  Data;              //  as Demo7's GetValue, get_value >> 4
+
+};
+
+class HeadTelemetry
+{
+public:
+    explicit HeadTelemetry( size_t Capacity = 1 << 14 );
+    ~HeadTelemetry();
+
+    UINT     Start( UINT Heads, const UINT* Values, UINT Count );
+    void     Stop();                                //  joins the polling thread and collects the rest
+    void     Collect();                             //  moves the ring into History
+
+    //  Any thread, without a lock, false if not read yet
+    bool     Latest( UINT Head, UINT Axis, UINT Value, int16_t* Data, double* Time = 0 ) const;
+    static double Unit( UINT Value );               //  C or V per bit, 1 for status words
+
+    double   Interval;                              //  [s] between rounds
+    double   Settle;                                //  [s] from control_command until the data is read
+    double ( *Clock )();                            //  [s], steady clock by default
+    void   ( *Pause )( double Seconds );            //  sleeps by default
+    bool     RestorePosition;                       //  SendRealPos after every round
+
+    //  Collected
+    std::vector< HeadSample > History;
+    uint64_t Rounds;
+    uint64_t Calls;                                 //  RTC5 functions called
+    uint64_t Dropped;                               //  values lost by a full ring
+
+private:
+    HeadTelemetry( const HeadTelemetry& );
+    HeadTelemetry& operator=( const HeadTelemetry& );
+
+    void     Run();
+    void     Round( UINT Value );
+    void     Store( UINT Head, UINT Axis, UINT Value, int16_t Data, double Time );
+
+    UINT     Mask;
+    std::vector< UINT > Selected;
+    double   StartTime;
+
+    //  Data in the low 16 bits, us since Start + 1 above, 0 if not read
+    std::atomic< uint64_t > Table[ 2 ][ 3 ][ HeadValues ];
+    MonitorRing< HeadSample > Ring;
+    std::atomic< uint64_t > RoundCount, CallCount, Lost;
+    std::atomic< bool > Stopping;
+    std::thread Worker;
+
+};
@@ -0,0 +1,315 @@
+//  File
+//      RTC5Job.cpp
+//
+//  Abstract
+//      Precompiled job files
+//
+//  Comment
+//      Win32 maps the file by CreateFileMapping / MapViewOfFile, Linux by
+//      mmap. The view is read only.
+//
+//  Necessary Sources
+//      RTC5Job.h, RTC5List.h, RTC5List.cpp, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "RTC5Job.h"
+
+static const uint32_t JobFileVersion = 1;
+
+static_assert( sizeof( JobFileHeader ) == 128, "JobFileHeader is part of the file format" );
+static_assert( sizeof( ListCommand ) == 32, "ListCommand is part of the file format" );
+
+//  JobDefaults
+//
+//  Description:
+//
+//  Initializes Header with the magic, the version and the default
+//  parameters of the demos.
+//
+
+void JobDefaults( JobFileHeader& Header )
+{
+    memset( &Header, 0, sizeof( Header ) );
+    memcpy( Header.Magic, "RJB1", 4 );
+    Header.Version          = JobFileVersion;
+    Header.HeaderSize       = sizeof( JobFileHeader );
+    Header.RecordSize       = sizeof( ListCommand );
+    Header.JumpSpeed        = 1000.0;
+    Header.MarkSpeed        =  250.0;
+    Header.JumpDelay        = 250/10;
+    Header.MarkDelay        = 100/10;
+    Header.PolygonDelay     =  50/10;
+    Header.LaserOnDelay     =  100*1;
+    Header.LaserOffDelay    =  100*1;
+    Header.LaserHalfPeriod  =   50*8;
+    Header.LaserPulseWidth  =    5*8;
+    Header.FirstPulseKiller =  200*8;
+
+}
+
+//  The header of a job file with the parameters of Params
+static void JobLayout( JobFileHeader& Header, const JobFileHeader& Params, const ListCommand* Cmd, size_t Count )
+{
+    Header = Params;
+    memcpy( Header.Magic, "RJB1", 4 );
+    Header.Version      = JobFileVersion;
+    Header.HeaderSize   = sizeof( JobFileHeader );
+    Header.RecordSize   = sizeof( ListCommand );
+    Header.RecordOffset = ( sizeof( JobFileHeader ) + JobAlignment - 1 ) / JobAlignment * JobAlignment;
+    Header.RecordCount  = Count;
+    Header.Hash         = ListHash( Cmd, Count );
+
+}
+
+//  JobWrite
+//
+//  Description:
+//
+//  Writes a job file: the parameters of Params, the records Cmd.
+//
+//      Parameter   Meaning
+//
+//      Name        path of the job file
+//      Params      parameters, the layout fields are set by JobWrite
+//      Cmd         list commands
+//      Count       number of records
+//
+//      Return      JobNoError or JobFileError
+//
+
+UINT JobWrite( const char* Name, const JobFileHeader& Params, const ListCommand* Cmd, size_t Count )
+{
+    JobFileHeader Header;
+    JobLayout( Header, Params, Cmd, Count );
+
+    FILE* File = fopen( Name, "wb" );
+
+    if ( !File ) return JobFileError;
+
+    static const char Padding[ JobAlignment ] = { 0 };
+    bool Ok = fwrite( &Header, sizeof( Header ), 1, File ) == 1;
+    Ok = Ok && fwrite( Padding, 1, (size_t) Header.RecordOffset - sizeof( Header ), File ) == Header.RecordOffset - sizeof( Header );
+    Ok = Ok && ( !Count || fwrite( Cmd, sizeof( ListCommand ), Count, File ) == Count );
+    Ok = !fclose( File ) && Ok;
+
+    return Ok ? JobNoError : JobFileError;
+
+}
+
+//  JobImage
+//
+//  Description:
+//
+//  Writes the job file of JobWrite into memory, e.g. shared memory handed
+//  to another process. With Image NULL only the size is returned.
+//
+//      Return      size of the job file in bytes
+//
+
+size_t JobImage( const JobFileHeader& Params, const ListCommand* Cmd, size_t Count, void* Image )
+{
+    const size_t Offset = ( sizeof( JobFileHeader ) + JobAlignment - 1 ) / JobAlignment * JobAlignment;
+
+    if ( Image )
+    {
+        JobFileHeader Header;
+        JobLayout( Header, Params, Cmd, Count );
+
+        memset( Image, 0, Offset );
+        memcpy( Image, &Header, sizeof( Header ) );
+
+        if ( Count ) memcpy( (char*) Image + Offset, Cmd, Count * sizeof( ListCommand ) );
+
+    }
+
+    return Offset + Count * sizeof( ListCommand );
+
+}
+
+//  JobSetup
+//
+//  Description:
+//
+//  The list commands setting the parameters of Header.
+//
+
+void JobSetup( const JobFileHeader& Header, ListJob& Setup )
+{
+    Setup.push_back( ListMake( OpSetLaserPulses, Header.LaserHalfPeriod, Header.LaserPulseWidth ) );
+    Setup.push_back( ListMake( OpSetFirstPulseKiller, Header.FirstPulseKiller ) );
+    Setup.push_back( ListMake( OpSetScannerDelays, Header.JumpDelay, Header.MarkDelay, Header.PolygonDelay ) );
+    Setup.push_back( ListMake( OpSetLaserDelays, Header.LaserOnDelay, Header.LaserOffDelay ) );
+    Setup.push_back( ListMakeD( OpSetJumpSpeed, Header.JumpSpeed ) );
+    Setup.push_back( ListMakeD( OpSetMarkSpeed, Header.MarkSpeed ) );
+
+}
+
+JobFile::JobFile()
+    : Head( 0 ), Cmd( 0 ), View( 0 ), Size( 0 )
+#ifdef _WIN32
+    , File( INVALID_HANDLE_VALUE ), Mapping( 0 )
+#else
+    , File( -1 )
+#endif
+{
+}
+
+JobFile::~JobFile()
+{
+    Close();
+
+}
+
+//  Open
+//
+//  Description:
+//
+//  Maps the job file Name. The header and the record layout are checked,
+//  the records are only hashed with Verify set, since this touches every
+//  page of the file.
+//
+//      Return      JobNoError, JobFileError or JobFormatError
+//
+
+UINT JobFile::Open( const char* Name, bool Verify )
+{
+    Close();
+
+#ifdef _WIN32
+    File = CreateFileA( Name, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0 );
+
+    if ( File == INVALID_HANDLE_VALUE ) return JobFileError;
+#else
+    File = open( Name, O_RDONLY );
+
+    if ( File < 0 ) return JobFileError;
+#endif
+
+    return Map( Verify );
+
+}
+
+#ifndef _WIN32
+//  Attach
+//
+//  Description:
+//
+//  Maps the job file open as Descriptor like Open does. The descriptor is
+//  closed by Close, also if it holds no job file.
+//
+//      Return      JobNoError, JobFileError or JobFormatError
+//
+
+UINT JobFile::Attach( int Descriptor, bool Verify )
+{
+    Close();
+
+    if ( Descriptor < 0 ) return JobFileError;
+
+    File = Descriptor;
+    return Map( Verify );
+
+}
+#endif
+
+UINT JobFile::Map( bool Verify )
+{
+#ifdef _WIN32
+    LARGE_INTEGER FileSize;
+
+    if ( !GetFileSizeEx( File, &FileSize ) || !FileSize.QuadPart )
+    {
+        Close();
+        return JobFormatError;
+
+    }
+
+    Size    = (size_t) FileSize.QuadPart;
+    Mapping = CreateFileMappingA( File, 0, PAGE_READONLY, 0, 0, 0 );
+    View    = Mapping ? MapViewOfFile( Mapping, FILE_MAP_READ, 0, 0, 0 ) : 0;
+#else
+    struct stat Stat;
+
+    if ( fstat( File, &Stat ) || !Stat.st_size )
+    {
+        Close();
+        return JobFormatError;
+
+    }
+
+    Size = (size_t) Stat.st_size;
+    View = mmap( 0, Size, PROT_READ, MAP_SHARED, File, 0 );
+
+    if ( View == MAP_FAILED ) View = 0;
+    else                      madvise( View, Size, MADV_SEQUENTIAL );
+#endif
+
+    if ( !View )
+    {
+        Close();
+        return JobFileError;
+
+    }
+
+    const JobFileHeader* h = (const JobFileHeader*) View;
+
+    if (   Size < sizeof( JobFileHeader ) || memcmp( h->Magic, "RJB1", 4 )
+        || h->Version != JobFileVersion || h->HeaderSize != sizeof( JobFileHeader )
+        || h->RecordSize != sizeof( ListCommand ) || h->RecordOffset % JobAlignment
+        || h->RecordOffset > Size || h->RecordCount > ( Size - h->RecordOffset ) / sizeof( ListCommand )
+       )
+    {
+        Close();
+        return JobFormatError;
+
+    }
+
+    Head = h;
+    Cmd  = (const ListCommand*) ( (const char*) View + h->RecordOffset );
+
+    if ( Verify && ListHash( Cmd, Count() ) != h->Hash )
+    {
+        Close();
+        return JobFormatError;
+
+    }
+
+    return JobNoError;
+
+}
+
+void JobFile::Close()
+{
+#ifdef _WIN32
+    if ( View ) UnmapViewOfFile( View );
+    if ( Mapping ) CloseHandle( Mapping );
+    if ( File != INVALID_HANDLE_VALUE ) CloseHandle( File );
+
+    Mapping = 0;
+    File    = INVALID_HANDLE_VALUE;
+#else
+    if ( View ) munmap( View, Size );
+    if ( File >= 0 ) close( File );
+
+    File = -1;
+#endif
+
+    View = 0;
+    Head = 0;
+    Cmd  = 0;
+    Size = 0;
+
+}
@@ -0,0 +1,100 @@
+//  File
+//      RTC5Job.h
+//
+//  Abstract
+//      Precompiled job files.
+//      A job file holds a header with speeds, delays and laser parameters
+//      followed by the list commands as ListCommand records. The records
+//      start at a 64 byte aligned file offset, so a JobFile maps the file
+//      into memory and hands the records to ListReplay or the ListFeeder
+//      without parsing or copying them.
+//
+//  Comment
+//      File layout (little endian):
+//          JobFileHeader           128 bytes
+//          padding                 up to RecordOffset
+//          ListCommand[ RecordCount ]
+//      The numbering of ListOp is part of the format, see RTC5List.h.
+//
+//  Necessary Sources
+//      RTC5Job.h, RTC5Job.cpp, RTC5List.h, RTC5List.cpp, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+
+#include "RTC5List.h"
+
+//  Error codes of the job file functions
+const UINT   JobNoError           =            0;
+const UINT   JobFileError         =            1;   //  file not found, not writable or not mappable
+const UINT   JobFormatError       =            2;   //  no job file, wrong version or corrupted
+
+const UINT   JobAlignment         =           64;   //  file offset alignment of the records
+
+struct JobFileHeader
+{
+    char     Magic[ 4 ];        //  "RJB1"
+    uint32_t Version;
+    uint32_t HeaderSize;        //  sizeof( JobFileHeader )
+    uint32_t RecordSize;        //  sizeof( ListCommand )
+    uint64_t RecordOffset;      //  file offset of the first record
+    uint64_t RecordCount;
+    uint64_t Hash;              //  ListHash of the records
+
+    //  Parameters, issued as list commands ahead of the records
+    double   JumpSpeed;         //  [bits/ms]
+    double   MarkSpeed;         //  [bits/ms]
+    uint32_t JumpDelay;         //  [10 us]
+    uint32_t MarkDelay;         //  [10 us]
+    uint32_t PolygonDelay;      //  [10 us]
+    int32_t  LaserOnDelay;      //  [1 us], LaserDelayUnit of RTC5Timing.h
+    uint32_t LaserOffDelay;     //  [1 us]
+    uint32_t LaserHalfPeriod;   //  [1/8 us]
+    uint32_t LaserPulseWidth;   //  [1/8 us]
+    uint32_t FirstPulseKiller;  //  [1/8 us]
+    uint32_t Reserved[ 10 ];
+
+};
+
+void JobDefaults( JobFileHeader& Header );
+UINT JobWrite( const char* Name, const JobFileHeader& Params, const ListCommand* Cmd, size_t Count );
+size_t JobImage( const JobFileHeader& Params, const ListCommand* Cmd, size_t Count, void* Image );
+void JobSetup( const JobFileHeader& Header, ListJob& Setup );
+
+class JobFile
+{
+public:
+    JobFile();
+    ~JobFile();
+
+    UINT Open( const char* Name, bool Verify = false );
+#ifndef _WIN32
+    UINT Attach( int Descriptor, bool Verify = false );     //  takes the descriptor, e.g. of shared memory
+#endif
+    void Close();
+
+    const JobFileHeader& Header()  const { return *Head; }
+    const ListCommand*   Records() const { return Cmd; }
+    size_t               Count()   const { return (size_t) Head->RecordCount; }
+
+private:
+    JobFile( const JobFile& );
+    JobFile& operator=( const JobFile& );
+
+    UINT Map( bool Verify );
+
+    const JobFileHeader* Head;
+    const ListCommand*   Cmd;
+    void*                View;
+    size_t               Size;
+#ifdef _WIN32
+    void*                File;
+    void*                Mapping;
+#else
+    int                  File;
+#endif
+
+};
@@ -0,0 +1,193 @@
+//  File
+//      RTC5List.cpp
+//
+//  Abstract
+//      Host side representation of RTC5 list commands
+//
+//  Comment
+//      ListReplay transfers precompiled commands to the card through the
+//      function pointers of RTC5expl.h, i.e. to the list currently opened
+//      by set_start_list, load_list, load_sub, load_char etc.
+//
+//  Necessary Sources
+//      RTC5List.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <string>
+
+#include "RTC5List.h"
+
+//  ListAppendText
+//
+//  Description:
+//
+//  Appends a text command (OpMarkText, OpMarkTextAbs) and the OpTextData
+//  records holding its text to Job.
+//
+
+void ListAppendText( ListJob& Job, UINT Op, const char* Text )
+{
+    const size_t Length = Text ? strlen( Text ) : 0;
+    ListCommand  Cmd = ListMake( Op );
+    Cmd.Arg = (uint16_t) ( Length > 0xFFFF ? 0xFFFF : Length );
+    Job.push_back( Cmd );
+
+    for ( size_t i = 0; i < Cmd.Arg; i += ListTextBytes )
+    {
+        ListCommand Data = ListMake( OpTextData );
+        const size_t n = Cmd.Arg - i < ListTextBytes ? Cmd.Arg - i : ListTextBytes;
+        Data.Arg = (uint16_t) n;
+        memcpy( ListText( Data ), Text + i, n );
+        Job.push_back( Data );
+
+    }
+
+}
+
+//  ListReplay
+//
+//  Description:
+//
+//  Issues the list commands Cmd[ 0 .. Count - 1 ] to the card.
+//
+//      Parameter   Meaning
+//
+//      Cmd         precompiled commands
+//      Count       number of records incl. OpTextData records
+//
+//      Return      number of list commands issued
+//
+
+size_t ListReplay( const ListCommand* Cmd, size_t Count )
+{
+    size_t Issued = 0;
+
+    for ( size_t i = 0; i < Count; i++ )
+    {
+        const ListCommand& c = Cmd[ i ];
+
+        switch ( c.Op )
+        {
+        case OpNop:                 list_nop();                                             break;
+        case OpEndOfList:           set_end_of_list();                                      break;
+        case OpListReturn:          list_return();                                          break;
+        case OpListContinue:        list_continue();                                        break;
+        case OpSetWait:             set_wait( c.I[ 0 ] );                                   break;
+        case OpLongDelay:           long_delay( c.I[ 0 ] );                                 break;
+        case OpJumpAbs:             jump_abs( c.I[ 0 ], c.I[ 1 ] );                         break;
+        case OpJumpRel:             jump_rel( c.I[ 0 ], c.I[ 1 ] );                         break;
+        case OpMarkAbs:             mark_abs( c.I[ 0 ], c.I[ 1 ] );                         break;
+        case OpMarkRel:             mark_rel( c.I[ 0 ], c.I[ 1 ] );                         break;
+        case OpSetJumpSpeed:        set_jump_speed( c.D[ 0 ] );                             break;
+        case OpSetMarkSpeed:        set_mark_speed( c.D[ 0 ] );                             break;
+        case OpSetScannerDelays:    set_scanner_delays( c.I[ 0 ], c.I[ 1 ], c.I[ 2 ] );     break;
+        case OpSetLaserDelays:      set_laser_delays( c.I[ 0 ], c.I[ 1 ] );                 break;
+        case OpSetLaserPulses:      set_laser_pulses( c.I[ 0 ], c.I[ 1 ] );                 break;
+        case OpSetFirstPulseKiller: set_firstpulse_killer_list( c.I[ 0 ] );                 break;
+        case OpWriteDaX:            write_da_x_list( c.Arg, c.I[ 0 ] );                     break;
+        case OpSubCall:             sub_call( c.I[ 0 ] );                                   break;
+        case OpSubCallAbs:          sub_call_abs( c.I[ 0 ] );                               break;
+        case OpListCall:            list_call( c.I[ 0 ] );                                  break;
+        case OpListCallAbs:         list_call_abs( c.I[ 0 ] );                              break;
+        case OpListJumpPos:         list_jump_pos( c.I[ 0 ] );                              break;
+        case OpSelectCharSet:       select_char_set( c.I[ 0 ] );                            break;
+        case OpMarkChar:            mark_char( c.I[ 0 ] );                                  break;
+        case OpMarkCharAbs:         mark_char_abs( c.I[ 0 ] );                              break;
+        case OpMarkSerial:          mark_serial( c.I[ 0 ], c.I[ 1 ] );                      break;
+        case OpMarkSerialAbs:       mark_serial_abs( c.I[ 0 ], c.I[ 1 ] );                  break;
+        case OpMarkDate:            mark_date( c.I[ 0 ], c.I[ 1 ] );                        break;
+        case OpMarkDateAbs:         mark_date_abs( c.I[ 0 ], c.I[ 1 ] );                    break;
+        case OpMarkTime:            mark_time( c.I[ 0 ], c.I[ 1 ] );                        break;
+        case OpMarkTimeAbs:         mark_time_abs( c.I[ 0 ], c.I[ 1 ] );                    break;
+        case OpSelectSerialSet:     select_serial_set_list( c.I[ 0 ] );                     break;
+        case OpSetSerialStep:       set_serial_step_list( c.I[ 0 ], c.I[ 1 ] );             break;
+        case OpSaveAndRestartTimer: save_and_restart_timer();                               break;
+        case OpSetExtStartPos:      set_extstartpos_list( c.I[ 0 ] );                       break;
+        case OpSetControlMode:      set_control_mode_list( c.I[ 0 ] );                      break;
+        case OpSetFreeVariable:     set_free_variable_list( c.I[ 0 ], c.I[ 1 ] );           break;
+        case OpSetOffset:           set_offset_list( c.Arg, c.I[ 0 ], c.I[ 1 ], c.I[ 2 ] ); break;
+        case OpSetMatrix:           set_matrix_list( c.Arg, c.I[ 0 ], c.I[ 1 ], c.D[ 0 ], c.I[ 2 ] );   break;
+        case OpArcAbs:              arc_abs( c.I[ 0 ], c.I[ 1 ], c.D[ 0 ] );                break;
+        case OpArcRel:              arc_rel( c.I[ 0 ], c.I[ 1 ], c.D[ 0 ] );                break;
+        case OpSetPixelLine:        set_pixel_line( c.Arg, c.I[ 0 ], c.D[ 0 ], c.D[ 1 ] );  break;
+        case OpSetPixel:            set_pixel( c.I[ 0 ], c.I[ 1 ] );                        break;
+        case OpSetNPixel:           set_n_pixel( c.I[ 0 ], c.I[ 1 ], c.I[ 2 ] );            break;
+        case OpSetDelayMode:        set_delay_mode_list( c.I[ 0 ], c.I[ 1 ], c.I[ 2 ], c.J[ 0 ], c.J[ 1 ] );    break;
+        case OpSetSkyWritingPara:   set_sky_writing_para_list( c.D[ 0 ], c.I[ 0 ], c.I[ 1 ], c.I[ 2 ] );        break;
+        case OpSetSkyWritingMode:   set_sky_writing_mode_list( c.I[ 0 ] );                  break;
+        case OpSetSkyWritingLimit:  set_sky_writing_limit_list( c.D[ 0 ] );                 break;
+        case OpSetTrigger:          set_trigger( c.I[ 0 ], c.I[ 1 ], c.I[ 2 ] );            break;
+        case OpSetTrigger4:         set_trigger4( c.I[ 0 ], c.I[ 1 ], c.I[ 2 ], c.J[ 2 ], c.J[ 3 ] );   break;
+        case OpJumpAbs3D:           jump_abs_3d( c.I[ 0 ], c.I[ 1 ], c.I[ 2 ] );            break;
+        case OpMarkAbs3D:           mark_abs_3d( c.I[ 0 ], c.I[ 1 ], c.I[ 2 ] );            break;
+        case OpSetDefocus:          set_defocus_list( c.I[ 0 ] );                           break;
+        case OpStepperAbs:          stepper_abs_list( c.I[ 0 ], c.I[ 1 ] );                 break;
+        case OpStepperWait:         stepper_wait( c.I[ 0 ] );                               break;
+        case OpSetFlyX:             set_fly_x( c.D[ 0 ] );                                  break;
+        case OpActivateFlyXYEncoder:    activate_fly_xy_encoder( c.D[ 0 ], c.D[ 1 ], c.I[ 0 ], c.I[ 1 ] );  break;
+        case OpFlyReturn:           fly_return( c.I[ 0 ], c.I[ 1 ] );                       break;
+        case OpWaitForEncoder:      wait_for_encoder( c.I[ 0 ], c.I[ 1 ] );                 break;
+        case OpStoreEncoder:        store_encoder( c.I[ 0 ] );                              break;
+
+        case OpMarkText:
+        case OpMarkTextAbs:
+        {
+            std::string Text;
+
+            while ( Text.size() < c.Arg && i + 1 < Count && Cmd[ i + 1 ].Op == OpTextData )
+            {
+                i++;
+                Text.append( ListText( Cmd[ i ] ), Cmd[ i ].Arg );
+
+            }
+
+            if ( c.Op == OpMarkText ) mark_text( Text.c_str() );
+            else                      mark_text_abs( Text.c_str() );
+
+            break;
+
+        }
+
+        default:                    //  OpTextData without OpMarkText
+            continue;
+
+        }
+
+        Issued++;
+
+    }
+
+    return Issued;
+
+}
+
+//  ListHash
+//
+//  Description:
+//
+//  FNV-1a of the records, used for identifying jobs and geometry blocks.
+//  Continue a hash by passing the previous result as Hash. ListHashBytes
+//  hashes any other data the same way, e.g. a glyph store.
+//
+
+uint64_t ListHash( const ListCommand* Cmd, size_t Count, uint64_t Hash )
+{
+    return ListHashBytes( Cmd, Count * sizeof( ListCommand ), Hash );
+
+}
+
+uint64_t ListHashBytes( const void* Data, size_t Size, uint64_t Hash )
+{
+    const unsigned char* p = (const unsigned char*) Data;
+
+    for ( size_t i = 0; i < Size; i++ )
+    {
+        Hash ^= p[ i ];
+        Hash *= 0x100000001B3ULL;
+
+    }
+
+    return Hash;
+
+}
@@ -0,0 +1,156 @@
+//  File
+//      RTC5List.h
+//
+//  Abstract
+//      Host side representation of RTC5 list commands.
+//      A ListCommand is a fixed size record holding one list command of
+//      RTC5expl.h together with its parameters. The emulator keeps its list
+//      memory in this format, precompiled jobs are stored in it.
+//      The numbering of ListOp is part of the file formats, new commands are
+//      appended at the end only.
+//
+//  Necessary Sources
+//      RTC5List.h, RTC5List.cpp, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "RTC5expl.h"
+
+enum ListOp
+{
+    OpNop = 0,                  //  list_nop
+    OpEndOfList,                //  set_end_of_list
+    OpListReturn,               //  list_return
+    OpListContinue,             //  list_continue
+    OpSetWait,                  //  set_wait( I0 )
+    OpLongDelay,                //  long_delay( I0 )
+    OpJumpAbs,                  //  jump_abs( I0, I1 )
+    OpJumpRel,                  //  jump_rel( I0, I1 )
+    OpMarkAbs,                  //  mark_abs( I0, I1 )
+    OpMarkRel,                  //  mark_rel( I0, I1 )
+    OpSetJumpSpeed,             //  set_jump_speed( D0 )
+    OpSetMarkSpeed,             //  set_mark_speed( D0 )
+    OpSetScannerDelays,         //  set_scanner_delays( I0, I1, I2 )
+    OpSetLaserDelays,           //  set_laser_delays( I0, I1 )
+    OpSetLaserPulses,           //  set_laser_pulses( I0, I1 )
+    OpSetFirstPulseKiller,      //  set_firstpulse_killer_list( I0 )
+    OpWriteDaX,                 //  write_da_x_list( Arg, I0 )
+    OpSubCall,                  //  sub_call( I0 )
+    OpSubCallAbs,               //  sub_call_abs( I0 )
+    OpListCall,                 //  list_call( I0 )
+    OpListCallAbs,              //  list_call_abs( I0 )
+    OpListJumpPos,              //  list_jump_pos( I0 )
+    OpSelectCharSet,            //  select_char_set( I0 )
+    OpMarkText,                 //  mark_text, Arg = length, text records follow
+    OpMarkTextAbs,              //  mark_text_abs, as OpMarkText
+    OpMarkChar,                 //  mark_char( I0 )
+    OpMarkCharAbs,              //  mark_char_abs( I0 )
+    OpMarkSerial,               //  mark_serial( I0, I1 )
+    OpMarkSerialAbs,            //  mark_serial_abs( I0, I1 )
+    OpMarkDate,                 //  mark_date( I0, I1 )
+    OpMarkDateAbs,              //  mark_date_abs( I0, I1 )
+    OpMarkTime,                 //  mark_time( I0, I1 )
+    OpMarkTimeAbs,              //  mark_time_abs( I0, I1 )
+    OpSelectSerialSet,          //  select_serial_set_list( I0 )
+    OpSetSerialStep,            //  set_serial_step_list( I0, I1 )
+    OpSaveAndRestartTimer,      //  save_and_restart_timer
+    OpSetExtStartPos,           //  set_extstartpos_list( I0 )
+    OpSetControlMode,           //  set_control_mode_list( I0 )
+    OpSetFreeVariable,          //  set_free_variable_list( I0, I1 )
+    OpTextData,                 //  Arg characters of a text in bytes 4..31
+    OpSetOffset,                //  set_offset_list( Arg, I0, I1, I2 )
+    OpSetMatrix,                //  set_matrix_list( Arg, I0, I1, D0, I2 )
+    OpArcAbs,                   //  arc_abs( I0, I1, D0 )
+    OpArcRel,                   //  arc_rel( I0, I1, D0 )
+    OpSetPixelLine,             //  set_pixel_line( Arg, I0, D0, D1 )
+    OpSetPixel,                 //  set_pixel( I0, I1 )
+    OpSetNPixel,                //  set_n_pixel( I0, I1, I2 )
+    OpSetDelayMode,             //  set_delay_mode_list( I0, I1, I2, J0, J1 )
+    OpSetSkyWritingPara,        //  set_sky_writing_para_list( D0, I0, I1, I2 )
+    OpSetSkyWritingMode,        //  set_sky_writing_mode_list( I0 )
+    OpSetSkyWritingLimit,       //  set_sky_writing_limit_list( D0 )
+    OpSetTrigger,               //  set_trigger( I0, I1, I2 )
+    OpSetTrigger4,              //  set_trigger4( I0, I1, I2, J2, J3 )
+    OpJumpAbs3D,                //  jump_abs_3d( I0, I1, I2 )
+    OpMarkAbs3D,                //  mark_abs_3d( I0, I1, I2 )
+    OpSetDefocus,               //  set_defocus_list( I0 )
+    OpStepperAbs,               //  stepper_abs_list( I0, I1 )
+    OpStepperWait,              //  stepper_wait( I0 )
+    OpSetFlyX,                  //  set_fly_x( D0 )
+    OpActivateFlyXYEncoder,     //  activate_fly_xy_encoder( D0, D1, I0, I1 )
+    OpFlyReturn,                //  fly_return( I0, I1 )
+    OpWaitForEncoder,           //  wait_for_encoder( I0, I1 )
+    OpStoreEncoder              //  store_encoder( I0 )
+
+};
+
+struct ListCommand
+{
+    uint16_t Op;                //  ListOp
+    uint16_t Arg;               //  small unsigned parameter
+    int32_t  I[ 3 ];
+    union
+    {
+        double   D[ 2 ];
+        int32_t  J[ 4 ];
+
+    };
+
+};
+
+const UINT   ListTextBytes        =           28;   //  characters per OpTextData record
+
+//  Number of OpTextData records following an OpMarkText of Length characters
+inline UINT ListTextRecords( size_t Length )
+{
+    return (UINT) ( ( Length + ListTextBytes - 1 ) / ListTextBytes );
+
+}
+
+inline char* ListText( ListCommand& Cmd )
+{
+    return (char*) Cmd.I;
+
+}
+
+inline const char* ListText( const ListCommand& Cmd )
+{
+    return (const char*) Cmd.I;
+
+}
+
+inline ListCommand ListMake( UINT Op, int32_t I0 = 0, int32_t I1 = 0, int32_t I2 = 0 )
+{
+    ListCommand Cmd;
+    memset( &Cmd, 0, sizeof( Cmd ) );
+    Cmd.Op = (uint16_t) Op;
+    Cmd.I[ 0 ] = I0;
+    Cmd.I[ 1 ] = I1;
+    Cmd.I[ 2 ] = I2;
+    return Cmd;
+
+}
+
+inline ListCommand ListMakeD( UINT Op, double D0, double D1 = 0.0 )
+{
+    ListCommand Cmd = ListMake( Op );
+    Cmd.D[ 0 ] = D0;
+    Cmd.D[ 1 ] = D1;
+    return Cmd;
+
+}
+
+//  A precompiled job: list commands in list memory order
+typedef std::vector< ListCommand > ListJob;
+
+void     ListAppendText( ListJob& Job, UINT Op, const char* Text );
+size_t   ListReplay( const ListCommand* Cmd, size_t Count );
+uint64_t ListHash( const ListCommand* Cmd, size_t Count, uint64_t Hash = 0xCBF29CE484222325ULL );
+uint64_t ListHashBytes( const void* Data, size_t Size, uint64_t Hash = 0xCBF29CE484222325ULL );
@@ -0,0 +1,345 @@
+//  File
+//      RTC5Monitor.cpp
+//
+//  Abstract
+//      Fill level telemetry of list 1
+//
+//  Comment
+//      One sample costs get_status and get_input_pointer, get_status
+//      returns the out pointer together with the busy and wait state.
+//      The fill level is taken modulo the size of list 1, as for the
+//      circular queue of the ListFeeder.
+//
+//      Trace layout: the fill level is a counter, every kind of event a
+//      track of its own within the process "RTC5 list 1", every host
+//      thread calling Span another one. Times are in us since Start.
+//
+//  Necessary Sources
+//      RTC5Monitor.h, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "RTC5Monitor.h"
+#include "RTC5Util.h"
+
+static const UINT   EventKinds[ 3 ]      = { MonitorLow, MonitorDry, MonitorWaiting };
+static const char*  EventNames[ 3 ]      = { "below watermark", "dry", "waiting" };
+static const UINT   HostTrack            =           10;   //  trace thread of the first host thread
+
+static double SteadyClock()
+{
+    return std::chrono::duration< double >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+
+}
+
+ListMonitor::ListMonitor( size_t Capacity )
+    : Interval( 1e-3 ), Clock( SteadyClock ), Pause( SleepFor ), ReadSpace( false ), Dropped( 0 ), DroppedEvents( 0 ),
+      LowCount( 0 ), DryCount( 0 ), WaitCount( 0 ), MinFill( 0 ), Size( 0 ), Water( 0 ), StartTime( 0.0 ),
+      SampleRing( Capacity ), EventRing( Capacity / 16 + 16 ), Lost( 0 ), LostEvents( 0 ), Stopping( false )
+{
+}
+
+ListMonitor::~ListMonitor()
+{
+    Stop();
+
+}
+
+//  Start
+//
+//  Description:
+//
+//  Starts sampling list 1. Samples and events collected before are
+//  cleared.
+//
+//      Parameter   Meaning
+//
+//      ListSize    size of list 1 as configured by config_list
+//      LowWater    fill level [positions] below which MonitorLow is raised
+//
+
+UINT ListMonitor::Start( UINT ListSize, UINT LowWater )
+{
+    if ( Worker.joinable() ) return MonitorBusy;
+    if ( !ListSize || LowWater > ListSize ) return MonitorRangeError;
+
+    Size      = ListSize;
+    Water     = LowWater;
+    StartTime = Clock();
+    Dropped   = 0;
+    DroppedEvents = 0;
+    LowCount  = 0;
+    DryCount  = 0;
+    WaitCount = 0;
+    MinFill   = ListSize;
+    Lost      = 0;
+    LostEvents = 0;
+    Stopping  = false;
+    Samples.clear();
+    Events.clear();
+
+    {
+        std::lock_guard< std::mutex > Guard( SpanLock );
+        Spans.clear();
+        Threads.clear();
+
+    }
+
+    Worker = std::thread( &ListMonitor::Run, this );
+
+    return MonitorNoError;
+
+}
+
+void ListMonitor::Stop()
+{
+    if ( !Worker.joinable() ) return;
+
+    Stopping = true;
+    Worker.join();
+    Collect();
+
+}
+
+void ListMonitor::Run()
+{
+    UINT Flags = 0;
+
+    for ( ;; )
+    {
+        Sample( Flags );
+
+        if ( Stopping ) break;
+
+        Pause( Interval );
+
+    }
+
+    //  Conditions still open end with the monitor
+    for ( UINT k = 0; k < 3; k++ )
+    {
+        if ( !( Flags & EventKinds[ k ] ) ) continue;
+
+        const MonitorEvent e = { Clock(), EventKinds[ k ], 0, 0 };
+        if ( !EventRing.Push( e ) ) LostEvents++;
+
+    }
+
+}
+
+//  Sample
+//
+//  Description:
+//
+//  Takes one sample and pushes an event for every condition starting or
+//  ending since the last one.
+//
+//      Parameter   Meaning
+//
+//      Flags       conditions of the last sample, updated
+//
+
+void ListMonitor::Sample( UINT& Flags )
+{
+    UINT Status, Pos;
+    get_status( &Status, &Pos );
+
+    MonitorSample s;
+    s.Time  = Clock();
+    s.In    = get_input_pointer();
+    s.Out   = Pos;
+    s.Fill  = ( s.In % Size + Size - s.Out % Size ) % Size;
+    s.Space = ReadSpace ? get_list_space() : 0;
+    s.Flags = 0;
+
+    if ( Status )
+    {
+        const bool Waiting = !( Status & 0x00ff ) && ( Status & 0xff00 );
+
+        s.Flags |= MonitorRunning;
+        if ( s.Fill < Water )        s.Flags |= MonitorLow;
+        if ( Waiting )               s.Flags |= MonitorWaiting;
+        if ( !Waiting && !s.Fill )   s.Flags |= MonitorDry;
+
+    }
+
+    if ( !SampleRing.Push( s ) ) Lost++;
+
+    for ( UINT k = 0; k < 3; k++ )
+    {
+        const UINT Kind = EventKinds[ k ];
+
+        if ( ( s.Flags ^ Flags ) & Kind )
+        {
+            const MonitorEvent e = { s.Time, Kind, s.Flags & Kind ? 1u : 0u, s.Fill };
+            if ( !EventRing.Push( e ) ) LostEvents++;
+
+        }
+
+    }
+
+    Flags = s.Flags;
+
+}
+
+//  Collect
+//
+//  Description:
+//
+//  Moves the samples and events of the rings into Samples and Events and
+//  updates the counters. Called by one thread at a time, e.g. periodically
+//  by the thread feeding the list, and by Stop.
+//
+
+void ListMonitor::Collect()
+{
+    MonitorSample s;
+
+    while ( SampleRing.Pop( s ) )
+    {
+        if ( s.Flags & MonitorRunning ) MinFill = std::min( MinFill, s.Fill );
+
+        Samples.push_back( s );
+
+    }
+
+    MonitorEvent e;
+
+    while ( EventRing.Pop( e ) )
+    {
+        if ( e.Begin && e.Kind == MonitorLow )     LowCount++;
+        if ( e.Begin && e.Kind == MonitorDry )     DryCount++;
+        if ( e.Begin && e.Kind == MonitorWaiting ) WaitCount++;
+
+        Events.push_back( e );
+
+    }
+
+    Dropped = Lost;
+    DroppedEvents = LostEvents;
+
+}
+
+void ListMonitor::Span( const char* Name, double Begin, double End )
+{
+    std::lock_guard< std::mutex > Guard( SpanLock );
+
+    const std::thread::id Id = std::this_thread::get_id();
+    const UINT Thread = (UINT) ( std::find( Threads.begin(), Threads.end(), Id ) - Threads.begin() );
+
+    if ( Thread == Threads.size() ) Threads.push_back( Id );
+
+    HostSpan h;
+    h.Name   = Name;
+    h.Begin  = Begin;
+    h.End    = End;
+    h.Thread = Thread;
+    Spans.push_back( h );
+
+}
+
+static void WriteName( FILE* File, const std::string& Name )
+{
+    fputc( '"', File );
+
+    for ( size_t i = 0; i < Name.size(); i++ )
+    {
+        const char c = Name[ i ];
+
+        if ( c == '"' || c == '\\' ) fputc( '\\', File );
+        if ( (unsigned char) c >= 0x20 ) fputc( c, File );
+
+    }
+
+    fputc( '"', File );
+
+}
+
+//  WriteTrace
+//
+//  Description:
+//
+//  Writes all collected samples, events and spans as a Chrome trace JSON
+//  file. Samples repeating the fill level of the one before are omitted.
+//
+
+UINT ListMonitor::WriteTrace( const char* Name )
+{
+    Collect();
+
+    FILE* File = fopen( Name, "w" );
+    if ( !File ) return MonitorFileError;
+
+    fprintf( File, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+    fprintf( File, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"RTC5 list 1\"}}" );
+
+    for ( UINT k = 0; k < 3; k++ )
+    {
+        fprintf( File, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"card %s\"}}",
+                 k + 1, EventNames[ k ] );
+
+    }
+
+    //  Fill level
+    UINT Last = ~0u, LastSpace = ~0u;
+
+    for ( size_t i = 0; i < Samples.size(); i++ )
+    {
+        const MonitorSample& s = Samples[ i ];
+
+        if ( s.Fill == Last && s.Space == LastSpace && i + 1 < Samples.size() ) continue;
+
+        fprintf( File, ",\n{\"name\":\"list 1\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"fill\":%u",
+                 ( s.Time - StartTime ) * 1e6, s.Fill );
+        if ( ReadSpace ) fprintf( File, ",\"space\":%u", s.Space );
+        fprintf( File, "}}" );
+
+        Last      = s.Fill;
+        LastSpace = s.Space;
+
+    }
+
+    //  Conditions
+    for ( size_t i = 0; i < Events.size(); i++ )
+    {
+        const MonitorEvent& e = Events[ i ];
+        const UINT k = e.Kind == MonitorLow ? 0 : e.Kind == MonitorDry ? 1 : 2;
+
+        fprintf( File, ",\n{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"fill\":%u}}",
+                 EventNames[ k ], e.Begin ? "B" : "E", ( e.Time - StartTime ) * 1e6, k + 1, e.Fill );
+
+    }
+
+    //  Host threads
+    std::lock_guard< std::mutex > Guard( SpanLock );
+
+    for ( size_t t = 0; t < Threads.size(); t++ )
+    {
+        fprintf( File, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"host thread %u\"}}",
+                 HostTrack + (UINT) t, (UINT) t + 1 );
+
+    }
+
+    for ( size_t i = 0; i < Spans.size(); i++ )
+    {
+        const HostSpan& h = Spans[ i ];
+
+        fprintf( File, ",\n{\"name\":" );
+        WriteName( File, h.Name );
+        fprintf( File, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                 ( h.Begin - StartTime ) * 1e6, ( h.End - h.Begin ) * 1e6, HostTrack + h.Thread );
+
+    }
+
+    fprintf( File, "\n]}\n" );
+
+    const bool Failed = ferror( File ) != 0;
+
+    return fclose( File ) || Failed ? MonitorFileError : MonitorNoError;
+
+}
@@ -0,0 +1,176 @@
+//  File
+//      RTC5Monitor.h
+//
+//  Abstract
+//      Fill level telemetry of list 1.
+//      Demo2's PlotLine only prints a warning when it has to hold the card
+//      by set_wait. A ListMonitor samples the input pointer, the out
+//      pointer and the status, and optionally get_list_space, on a
+//      background thread into a lock-free ring. The fill level is the
+//      number of positions loaded but not yet executed. Events are raised
+//      when it drops below a watermark, when the card runs dry, i.e. its
+//      out pointer reaches the input pointer, and while the card waits.
+//      WriteTrace exports the samples, the events and the spans recorded
+//      by host threads in the Chrome trace format, which chrome://tracing
+//      and Perfetto display on one time line.
+//
+//  Comment
+//      Only the sampler thread writes the rings and only the thread calling
+//      Collect reads them, so neither blocks the other. If the collecting
+//      thread falls behind, samples are dropped and counted, the sampler
+//      never waits. Events are kept in a ring of their own and are lost
+//      only if that one overflows too.
+//      Span may be called from any thread, it takes a lock.
+//
+//  Necessary Sources
+//      RTC5Monitor.h, RTC5Monitor.cpp, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RTC5expl.h"
+
+//  Error codes of the monitor
+const UINT   MonitorNoError       =            0;
+const UINT   MonitorBusy          =            1;   //  sampler running
+const UINT   MonitorRangeError    =            2;   //  list size or watermark out of range
+const UINT   MonitorFileError     =            3;   //  trace not writable
+
+//  Flags of a sample, kinds of events
+const UINT   MonitorLow           =            1;   //  fill level below the watermark
+const UINT   MonitorDry           =            2;   //  card running, out pointer at the input pointer
+const UINT   MonitorWaiting       =            4;   //  card held by set_wait or pause_list
+const UINT   MonitorRunning       =            8;   //  card executing list 1
+
+struct MonitorSample
+{
+    double   Time;              //  [s] of Clock
+    uint32_t In, Out;           //  input and out pointer
+    uint32_t Fill;              //  positions loaded ahead of the out pointer
+    uint32_t Space;             //  get_list_space, 0 unless ReadSpace
+    uint32_t Flags;
+
+};
+
+struct MonitorEvent
+{
+    double   Time;              //  [s] of Clock
+    uint32_t Kind;              //  MonitorLow, MonitorDry, MonitorWaiting
+    uint32_t Begin;             //  1: the condition starts, 0: it ends
+    uint32_t Fill;
+
+};
+
+//  Single producer, single consumer ring of a power of 2 capacity
+template< typename T >
+class MonitorRing
+{
+public:
+    explicit MonitorRing( size_t Capacity )
+        : Mask( 0 ), Head( 0 ), Tail( 0 )
+    {
+        size_t n = 1;
+        while ( n < Capacity ) n <<= 1;
+
+        Buffer.resize( n );
+        Mask = n - 1;
+
+    }
+
+    bool Push( const T& Item )                      //  producer only
+    {
+        const size_t h = Head.load( std::memory_order_relaxed );
+
+        if ( h - Tail.load( std::memory_order_acquire ) > Mask ) return false;
+
+        Buffer[ h & Mask ] = Item;
+        Head.store( h + 1, std::memory_order_release );
+        return true;
+
+    }
+
+    bool Pop( T& Item )                             //  consumer only
+    {
+        const size_t t = Tail.load( std::memory_order_relaxed );
+
+        if ( t == Head.load( std::memory_order_acquire ) ) return false;
+
+        Item = Buffer[ t & Mask ];
+        Tail.store( t + 1, std::memory_order_release );
+        return true;
+
+    }
+
+private:
+    std::vector< T > Buffer;
+    size_t   Mask;
+    std::atomic< size_t > Head;                     //  written by the producer
+    char     Pad[ 64 ];                             //  keeps Head and Tail on different cache lines
+    std::atomic< size_t > Tail;                     //  written by the consumer
+
+};
+
+class ListMonitor
+{
+public:
+    explicit ListMonitor( size_t Capacity = 1 << 16 );
+    ~ListMonitor();
+
+    UINT     Start( UINT ListSize, UINT LowWater );
+    void     Stop();                                //  joins the sampler and collects the rest
+    void     Collect();                             //  moves the rings into Samples and Events
+
+    //  Host activity for the trace, Begin and End [s] of Clock
+    void     Span( const char* Name, double Begin, double End );
+    UINT     WriteTrace( const char* Name );
+
+    double   Interval;                              //  [s] between samples
+    double ( *Clock )();                            //  [s], steady clock by default
+    void   ( *Pause )( double Seconds );            //  sleeps by default
+    bool     ReadSpace;                             //  get_list_space per sample as well
+
+    //  Collected
+    std::vector< MonitorSample > Samples;
+    std::vector< MonitorEvent >  Events;
+    uint64_t Dropped;                               //  samples lost by a full ring
+    uint64_t DroppedEvents;                         //  events lost by a full ring, counts below miss them
+    uint64_t LowCount, DryCount, WaitCount;         //  events begun
+    UINT     MinFill;                               //  while running
+
+private:
+    ListMonitor( const ListMonitor& );
+    ListMonitor& operator=( const ListMonitor& );
+
+    struct HostSpan
+    {
+        std::string Name;
+        double   Begin, End;
+        UINT     Thread;
+
+    };
+
+    void     Run();
+    void     Sample( UINT& Flags );
+
+    UINT     Size, Water;
+    double   StartTime;
+    MonitorRing< MonitorSample > SampleRing;
+    MonitorRing< MonitorEvent >  EventRing;
+    std::atomic< uint64_t > Lost;
+    std::atomic< uint64_t > LostEvents;
+    std::atomic< bool > Stopping;
+    std::thread Worker;
+    std::mutex SpanLock;
+    std::vector< HostSpan > Spans;
+    std::vector< std::thread::id > Threads;
+
+};
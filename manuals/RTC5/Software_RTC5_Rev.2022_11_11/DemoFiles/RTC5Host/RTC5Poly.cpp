@@ -0,0 +1,256 @@
+//  File
+//      RTC5Poly.cpp
+//
+//  Abstract
+//      Tables of the variable polygon delay
+//
+//  Comment
+//      The error of a corner grows with its angle, the delays found are
+//      made ascending with the angle so that noise of the search does not
+//      give a sharper corner a shorter delay. The longest delay becomes
+//      PolygonDelay, the table holds the others as factors of it.
+//
+//  Necessary Sources
+//      RTC5Poly.h, RTC5Tune.h, RTC5Galvo.h, RTC5List.h, RTC5Util.h,
+//      RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "RTC5List.h"
+#include "RTC5Poly.h"
+#include "RTC5Tune.h"
+#include "RTC5Util.h"
+
+static const double JumpSpeed            =       5000.0;   //  [bits/ms] to the start of a corner
+
+PolyDelayTable::PolyDelayTable()
+    : MarkSpeed( 1000.0 ), MaxError( 10.0 ), Length( 2000.0 ), Angles( 19 ), MaxDelay( 100 ), PolygonDelay( 0 ),
+      Evaluations( 0 )
+{
+}
+
+//  FromLag
+//
+//  Description:
+//
+//  Sets both axes of Galvo to the tracking delay Lag = 2 Damping / w of a
+//  second-order head, e.g. TrackAnalyzer::Lag * TrackAnalyzer::Period.
+//
+
+void PolyDelayTable::FromLag( double Lag, double Damping )
+{
+    if ( Lag <= 0.0 || Damping <= 0.0 ) return;
+
+    for ( UINT a = 0; a < 2; a++ )
+    {
+        Galvo.Axis[ a ].Frequency = Damping / ( Pi * Lag );
+        Galvo.Axis[ a ].Damping   = Damping;
+
+    }
+
+    Galvo.Configure();
+
+}
+
+//  Compute
+//
+//  Description:
+//
+//  Finds the delay of each angle and fills Entries and PolygonDelay.
+//
+//      Return      Meaning
+//
+//      PolyNoError     all corners within MaxError
+//      PolyRangeError  Angles below 2, MarkSpeed or Length not positive
+//      PolyInfeasible  some corners beyond MaxError at MaxDelay, their
+//                      entries hold MaxDelay
+//
+
+UINT PolyDelayTable::Compute()
+{
+    Entries.clear();
+    PolygonDelay = 0;
+    Evaluations  = 0;
+
+    if ( Angles < 2 || MarkSpeed <= 0.0 || Length <= 0.0 ) return PolyRangeError;
+
+    UINT Error = PolyNoError;
+    UINT Floor = 0;
+
+    for ( UINT i = 0; i < Angles; i++ )
+    {
+        PolyEntry e;
+        e.Angle = 180.0 * i / ( Angles - 1 );
+
+        const double a = e.Angle * Pi / 180.0;
+        const LONG   L = (LONG) Length;
+
+        ListCommand Corner[ 3 ];
+        Corner[ 0 ] = ListMake( OpJumpAbs, -L, 0 );
+        Corner[ 1 ] = ListMake( OpMarkAbs, 0, 0 );
+        Corner[ 2 ] = ListMake( OpMarkAbs, (LONG) floor( Length * cos( a ) + 0.5 ), (LONG) floor( Length * sin( a ) + 0.5 ) );
+
+        DelayTuner Tuner;
+        Tuner.Galvo = Galvo;
+        Tuner.SetJob( Corner, 3 );
+
+        TuneParameters Par = { JumpSpeed, MarkSpeed, MaxDelay, MaxDelay, 0, 0, 0 };
+        TuneResult r;
+
+        //  Shortest delay within MaxError, at least that of the last angle
+        UINT Lo = Floor, Hi = MaxDelay;
+
+        Par.PolygonDelay = Hi;
+        Tuner.Evaluate( Par, r );
+        Evaluations++;
+        e.Error = r.PathError;
+
+        if ( r.PathError > MaxError )
+        {
+            Error = PolyInfeasible;
+            Lo    = Hi;
+
+        }
+
+        while ( Lo < Hi )
+        {
+            Par.PolygonDelay = ( Lo + Hi ) / 2;
+            Tuner.Evaluate( Par, r );
+            Evaluations++;
+
+            if ( r.PathError <= MaxError )
+            {
+                Hi      = Par.PolygonDelay;
+                e.Error = r.PathError;
+
+            }
+            else
+            {
+                Lo = Par.PolygonDelay + 1;
+
+            }
+
+        }
+
+        e.Delay = Floor = Hi;
+        e.Scale = 0.0;
+        Entries.push_back( e );
+
+    }
+
+    PolygonDelay = Floor;
+
+    for ( size_t i = 0; i < Entries.size(); i++ )
+    {
+        Entries[ i ].Scale = PolygonDelay ? (double) Entries[ i ].Delay / PolygonDelay : 0.0;
+
+    }
+
+    return Error;
+
+}
+
+UINT PolyDelayTable::WriteTable( const char* Name, UINT No ) const
+{
+    FILE* File = fopen( Name, "w" );
+    if ( !File ) return PolyFileError;
+
+    fprintf( File, "; Variable polygon delay, PolygonDelay=%u us\n", PolygonDelay * 10 );
+    fprintf( File, "; Head %.0f Hz, damping %.2f, %.0f bits/ms, max error %.1f bits\n", Galvo.Axis[ 0 ].Frequency,
+             Galvo.Axis[ 0 ].Damping, MarkSpeed, MaxError );
+    fprintf( File, "[VarPolyTable%u]\n", No );
+
+    for ( size_t i = 0; i < Entries.size(); i++ )
+    {
+        fprintf( File, "Angle=%g\nScale=%.4f\n", Entries[ i ].Angle, Entries[ i ].Scale );
+
+    }
+
+    return fclose( File ) ? PolyFileError : PolyNoError;
+
+}
+
+//  Load
+//
+//  Description:
+//
+//  Writes the table to file Name and loads it by load_varpolydelay. The
+//  caller enables it by set_delay_mode( 1, ... ) and sets PolygonDelay by
+//  set_scanner_delays.
+//
+
+UINT PolyDelayTable::Load( const char* Name, UINT No ) const
+{
+    if ( !load_varpolydelay ) return PolyFileError;
+
+    const UINT Error = WriteTable( Name, No );
+    if ( Error ) return Error;
+
+    return load_varpolydelay( Name, No ) ? PolyFileError : PolyNoError;
+
+}
+
+void PolyDelayTable::Print( FILE* Out ) const
+{
+    fprintf( Out, "angle [deg]   delay [us]   scale   error [bits]\n" );
+
+    for ( size_t i = 0; i < Entries.size(); i++ )
+    {
+        const PolyEntry& e = Entries[ i ];
+        fprintf( Out, "%11.1f   %10u   %5.3f   %12.2f\n", e.Angle, e.Delay * 10, e.Scale, e.Error );
+
+    }
+
+    fprintf( Out, "PolygonDelay %u us, %llu runs of the tuner\n", PolygonDelay * 10, (unsigned long long) Evaluations );
+
+}
+
+UINT PolyReadTable( const char* Name, UINT No, std::vector< double >& Angle, std::vector< double >& Scale )
+{
+    Angle.clear();
+    Scale.clear();
+
+    FILE* File = fopen( Name, "r" );
+    if ( !File ) return PolyFileError;
+
+    char Section[ 32 ], Line[ 256 ];
+    sprintf( Section, "[VarPolyTable%u]", No );
+    bool In = false, Found = false;
+
+    while ( fgets( Line, sizeof( Line ), File ) )
+    {
+        char* p = Line;
+        while ( *p == ' ' || *p == '\t' ) p++;
+
+        if ( *p == '[' )
+        {
+            In = !strncmp( p, Section, strlen( Section ) );
+            Found |= In;
+            continue;
+
+        }
+
+        if ( !In ) continue;
+
+        if      ( !strncmp( p, "Angle=", 6 ) ) Angle.push_back( atof( p + 6 ) );
+        else if ( !strncmp( p, "Scale=", 6 ) ) Scale.push_back( atof( p + 6 ) );
+
+    }
+
+    fclose( File );
+
+    if ( !Found || Angle.empty() || Angle.size() != Scale.size() )
+    {
+        Angle.clear();
+        Scale.clear();
+        return PolyFileError;
+
+    }
+
+    return PolyNoError;
+
+}
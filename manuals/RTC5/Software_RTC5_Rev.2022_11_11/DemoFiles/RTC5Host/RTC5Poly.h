@@ -0,0 +1,88 @@
+//  File
+//      RTC5Poly.h
+//
+//  Abstract
+//      Tables of the variable polygon delay.
+//      The demos set one PolygonDelay for every corner, long enough for
+//      the sharpest. With set_delay_mode( 1, ... ) the card scales it by
+//      the angle of the corner, by a table loaded by load_varpolydelay if
+//      there is one. A PolyDelayTable runs a corner of each angle of the
+//      table through the DelayTuner with its GalvoModel and finds the
+//      shortest delay that keeps the corner within MaxError at MarkSpeed.
+//      The head is the GalvoModel as set, or taken from the tracking delay
+//      a TrackAnalyzer found in a captured waveform, see FromLag.
+//
+//      Table file, read by PolyReadTable and the emulator:
+//          [VarPolyTable<No>]
+//          Angle=<deg>                 one pair per entry, angles ascending
+//          Scale=<factor>              of the polygon delay, 0..1
+//      Lines starting with ';' are comments.
+//
+//  Comment
+//      A corner is marked from rest along Length bits into the corner and
+//      Length bits out of it, the path error of the tuner is the corner
+//      error. The delay is searched by bisection in 10 us steps.
+//
+//  Necessary Sources
+//      RTC5Poly.h, RTC5Poly.cpp, RTC5Tune.h, RTC5Tune.cpp, RTC5Galvo.h,
+//      RTC5Galvo.cpp, RTC5Timing.h, RTC5Timing.cpp, RTC5List.h, RTC5List.cpp,
+//      RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "RTC5Galvo.h"
+
+//  Error codes of the table
+const UINT   PolyNoError          =            0;
+const UINT   PolyRangeError       =            1;   //  fewer than 2 angles, no speed or length
+const UINT   PolyInfeasible       =            2;   //  MaxError exceeded at MaxDelay, table written anyway
+const UINT   PolyFileError        =            3;   //  file not writable or no table No in it
+
+struct PolyEntry
+{
+    double   Angle;             //  [deg] change of direction, 0: straight on
+    UINT     Delay;             //  [10 us] shortest within MaxError
+    double   Error;             //  [bits] with it
+    double   Scale;             //  Delay / PolygonDelay
+
+};
+
+class PolyDelayTable
+{
+public:
+    PolyDelayTable();
+
+    void     FromLag( double Lag, double Damping = 0.8 );  //  Lag [s] tracking delay
+    UINT     Compute();
+
+    UINT     WriteTable( const char* Name, UINT No = 0 ) const;
+    UINT     Load( const char* Name, UINT No = 0 ) const;  //  written and load_varpolydelay
+    void     Print( FILE* Out ) const;
+
+    //  Settings
+    GalvoModel Galvo;
+    double   MarkSpeed;                             //  [bits/ms] fastest of the jobs
+    double   MaxError;                              //  [bits]
+    double   Length;                                //  [bits] into and out of the corner
+    UINT     Angles;                                //  entries from 0 to 180 deg
+    UINT     MaxDelay;                              //  [10 us]
+
+    //  Results
+    std::vector< PolyEntry > Entries;
+    UINT     PolygonDelay;                          //  [10 us] for set_scanner_delays, the longest
+    uint64_t Evaluations;
+
+private:
+    PolyDelayTable( const PolyDelayTable& );
+    PolyDelayTable& operator=( const PolyDelayTable& );
+
+};
+
+//  Reads table No of a table file, returns PolyNoError or PolyFileError
+UINT PolyReadTable( const char* Name, UINT No, std::vector< double >& Angle, std::vector< double >& Scale );
@@ -0,0 +1,763 @@
+//  File
+//      RTC5Prepare.cpp
+//
+//  Abstract
+//      Chunked preparation of large jobs while they are marked
+//
+//  Comment
+//      Transform keeps the position in job coordinates as doubles and the
+//      position written in list coordinates as integers. An absolute
+//      vector is mapped and rounded, a relative one is written as the
+//      difference of the mapped end and the position written. Where the
+//      position is unknown, at the start of a job or after a subroutine,
+//      text or pixels, the offset is left out until the next absolute
+//      vector, relative vectors are still exact among themselves.
+//      Optimize starts a run of polylines from the position before it, or
+//      keeps the first polyline first if that is unknown, and always takes
+//      the polyline with the closest start next.
+//
+//  Necessary Sources
+//      RTC5Prepare.h, RTC5Feeder.h, RTC5Job.h, RTC5List.h, RTC5Util.h,
+//      RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "RTC5Prepare.h"
+#include "RTC5Util.h"
+
+static const size_t MaxAhead             =            4;   //  chunks prepared ahead of the writer per thread
+static const UINT   None                 =   0xFFFFFFFF;
+
+static int32_t Round( double v )
+{
+    return (int32_t) floor( v + 0.5 );
+
+}
+
+//  End of an arc around CenterX, CenterY from X, Y, clockwise for a
+//  positive Angle [deg] as on the card
+static void ArcEnd( double CenterX, double CenterY, double Angle, double* X, double* Y )
+{
+    const double vX = *X - CenterX, vY = *Y - CenterY;
+    const double a  = Angle * Pi / 180.0;
+
+    *X = CenterX + vX * cos( a ) + vY * sin( a );
+    *Y = CenterY + vY * cos( a ) - vX * sin( a );
+
+}
+
+//  Commands after which the position of the scanner is not known
+static bool LosesPosition( UINT Op )
+{
+    switch ( Op )
+    {
+    case OpSubCall:
+    case OpSubCallAbs:
+    case OpListCall:
+    case OpListCallAbs:
+    case OpListJumpPos:
+    case OpMarkText:
+    case OpMarkTextAbs:
+    case OpMarkChar:
+    case OpMarkCharAbs:
+    case OpMarkSerial:
+    case OpMarkSerialAbs:
+    case OpMarkDate:
+    case OpMarkDateAbs:
+    case OpMarkTime:
+    case OpMarkTimeAbs:
+    case OpSetPixel:
+    case OpSetNPixel:
+        return true;
+
+    default:
+        return false;
+
+    }
+
+}
+
+//  Commands neither using nor changing the position of the scanner
+static bool KeepsPosition( UINT Op )
+{
+    switch ( Op )
+    {
+    case OpNop:
+    case OpSetWait:
+    case OpLongDelay:
+    case OpSetJumpSpeed:
+    case OpSetMarkSpeed:
+    case OpSetScannerDelays:
+    case OpSetLaserDelays:
+    case OpSetLaserPulses:
+    case OpSetFirstPulseKiller:
+    case OpWriteDaX:
+    case OpSelectCharSet:
+    case OpSelectSerialSet:
+    case OpSetSerialStep:
+    case OpSaveAndRestartTimer:
+    case OpSetExtStartPos:
+    case OpSetControlMode:
+    case OpSetFreeVariable:
+    case OpSetDelayMode:
+    case OpSetSkyWritingPara:
+    case OpSetSkyWritingMode:
+    case OpSetSkyWritingLimit:
+    case OpSetTrigger:
+    case OpSetTrigger4:
+    case OpSetDefocus:
+    case OpStepperAbs:
+    case OpStepperWait:
+        return true;
+
+    default:
+        return false;
+
+    }
+
+}
+
+//  Commands continuing a polyline
+static bool IsPolyline( UINT Op )
+{
+    return Op == OpMarkAbs || Op == OpMarkRel || Op == OpArcAbs || Op == OpArcRel;
+
+}
+
+//  Prepares the chunks of one worker
+
+class ChunkPrepare
+{
+public:
+    ChunkPrepare( const PrepareEngine& Engine );
+
+    void     Chunk( UINT k, CommandBuffer& Out );
+
+    uint64_t Reordered;
+    double   JumpLength;
+
+private:
+    ChunkPrepare( const ChunkPrepare& );
+    ChunkPrepare& operator=( const ChunkPrepare& );
+
+    struct Polyline
+    {
+        size_t   Begin, End;                        //  records in the block
+        double   X0, Y0;                            //  [bits] start
+        double   X1, Y1;                            //  end
+
+    };
+
+    void     Map( double X, double Y, bool Offset, int32_t* oX, int32_t* oY ) const;
+    void     Transform( const ListCommand* Cmd, size_t Count, ListJob& Out ) const;
+    void     Order( ListJob& Block, bool Last );
+    void     Order( ListJob& Block, bool Known, bool KeepLast, double* X, double* Y );
+
+    const PrepareEngine& e;
+    bool     Identity;
+    bool     Mirror;
+    std::vector< Polyline > Lines;                  //  of the current run
+    std::vector< uint8_t > Used;
+    ListJob  Local;
+    ListJob  Block;                                 //  the chunk through the stages
+
+};
+
+ChunkPrepare::ChunkPrepare( const PrepareEngine& Engine )
+    : Reordered( 0 ), JumpLength( 0.0 ), e( Engine )
+{
+    Identity = e.Matrix[ 0 ] == 1.0 && e.Matrix[ 1 ] == 0.0 && e.Matrix[ 2 ] == 0.0 && e.Matrix[ 3 ] == 1.0
+            && e.Offset[ 0 ] == 0.0 && e.Offset[ 1 ] == 0.0;
+    Mirror   = e.Matrix[ 0 ] * e.Matrix[ 3 ] - e.Matrix[ 1 ] * e.Matrix[ 2 ] < 0.0;
+
+}
+
+void ChunkPrepare::Map( double X, double Y, bool Offset, int32_t* oX, int32_t* oY ) const
+{
+    *oX = Round( e.Matrix[ 0 ] * X + e.Matrix[ 1 ] * Y + ( Offset ? e.Offset[ 0 ] : 0.0 ) );
+    *oY = Round( e.Matrix[ 2 ] * X + e.Matrix[ 3 ] * Y + ( Offset ? e.Offset[ 1 ] : 0.0 ) );
+
+}
+
+//  Transform
+//
+//  Description:
+//
+//  Appends the records of a chunk to Out with Matrix and Offset applied
+//  to the vectors. sX, sY is the position in job coordinates, tX, tY the
+//  position written.
+//
+
+void ChunkPrepare::Transform( const ListCommand* Cmd, size_t Count, ListJob& Out ) const
+{
+    double  sX = 0.0, sY = 0.0;
+    int32_t tX = 0, tY = 0;
+    bool    Known = false;
+
+    for ( size_t i = 0; i < Count; i++ )
+    {
+        ListCommand c = Cmd[ i ];
+
+        switch ( c.Op )
+        {
+        case OpJumpAbs:
+        case OpMarkAbs:
+        case OpJumpAbs3D:
+        case OpMarkAbs3D:
+        case OpFlyReturn:
+            sX = c.I[ 0 ];
+            sY = c.I[ 1 ];
+            Known = true;
+            Map( sX, sY, true, &tX, &tY );
+            c.I[ 0 ] = tX;
+            c.I[ 1 ] = tY;
+            break;
+
+        case OpJumpRel:
+        case OpMarkRel:
+        {
+            int32_t x, y;
+            sX += c.I[ 0 ];
+            sY += c.I[ 1 ];
+            Map( sX, sY, Known, &x, &y );
+            c.I[ 0 ] = x - tX;
+            c.I[ 1 ] = y - tY;
+            tX = x;
+            tY = y;
+            break;
+
+        }
+
+        case OpArcAbs:
+        case OpArcRel:
+        {
+            const double CenterX = c.Op == OpArcAbs ? c.I[ 0 ] : sX + c.I[ 0 ];
+            const double CenterY = c.Op == OpArcAbs ? c.I[ 1 ] : sY + c.I[ 1 ];
+            int32_t x, y;
+
+            Map( CenterX, CenterY, Known || c.Op == OpArcAbs, &x, &y );
+            c.I[ 0 ] = c.Op == OpArcAbs ? x : x - tX;
+            c.I[ 1 ] = c.Op == OpArcAbs ? y : y - tY;
+            if ( Mirror ) c.D[ 0 ] = -c.D[ 0 ];
+
+            ArcEnd( CenterX, CenterY, Cmd[ i ].D[ 0 ], &sX, &sY );
+            Map( sX, sY, Known, &tX, &tY );
+            break;
+
+        }
+
+        case OpSetPixelLine:
+        {
+            const double dX = c.D[ 0 ], dY = c.D[ 1 ];
+            c.D[ 0 ] = e.Matrix[ 0 ] * dX + e.Matrix[ 1 ] * dY;
+            c.D[ 1 ] = e.Matrix[ 2 ] * dX + e.Matrix[ 3 ] * dY;
+            break;
+
+        }
+
+        case OpMarkText:
+        case OpMarkTextAbs:
+        {
+            //  The text records are copied unchanged
+            const size_t n = std::min( (size_t) ListTextRecords( c.Arg ), Count - i - 1 );
+            Out.push_back( c );
+            Out.insert( Out.end(), Cmd + i + 1, Cmd + i + 1 + n );
+            i += n;
+            Known = false;
+            sX = sY = 0.0;
+            tX = tY = 0;
+            continue;
+
+        }
+
+        default:
+            if ( LosesPosition( c.Op ) )
+            {
+                Known = false;
+                sX = sY = 0.0;
+                tX = tY = 0;
+
+            }
+
+            break;
+
+        }
+
+        Out.push_back( c );
+
+    }
+
+}
+
+//  Order
+//
+//  Description:
+//
+//  Finds the runs of polylines of the block: jump_abs, each followed by
+//  marks and arcs, up to the next other command. The position before a
+//  run is followed through the block. The end of a run must stay where
+//  it is unless the next command after the parameters sets an absolute
+//  position, or the block ends and the next chunk begins with jump_abs.
+//
+//      Parameter   Meaning
+//
+//      Last        the block of the last chunk, its end is the end of the job
+//
+
+void ChunkPrepare::Order( ListJob& Block, bool Last )
+{
+    const size_t Count = Block.size();
+    double X = 0.0, Y = 0.0;
+    bool   Known = false;
+    size_t i = 0;
+
+    while ( i < Count )
+    {
+        if ( Block[ i ].Op == OpJumpAbs )
+        {
+            //  The run up to the first other command
+            Lines.clear();
+
+            while ( i < Count && Block[ i ].Op == OpJumpAbs )
+            {
+                Polyline p;
+                p.Begin = i;
+                p.X0 = p.X1 = Block[ i ].I[ 0 ];
+                p.Y0 = p.Y1 = Block[ i ].I[ 1 ];
+
+                for ( i++; i < Count && IsPolyline( Block[ i ].Op ); i++ )
+                {
+                    const ListCommand& c = Block[ i ];
+
+                    switch ( c.Op )
+                    {
+                    case OpMarkAbs: p.X1 = c.I[ 0 ];     p.Y1 = c.I[ 1 ];     break;
+                    case OpMarkRel: p.X1 += c.I[ 0 ];    p.Y1 += c.I[ 1 ];    break;
+                    case OpArcAbs:  ArcEnd( c.I[ 0 ], c.I[ 1 ], c.D[ 0 ], &p.X1, &p.Y1 );                      break;
+                    case OpArcRel:  ArcEnd( p.X1 + c.I[ 0 ], p.Y1 + c.I[ 1 ], c.D[ 0 ], &p.X1, &p.Y1 );        break;
+
+                    }
+
+                }
+
+                p.End = i;
+                Lines.push_back( p );
+
+            }
+
+            size_t j = i;
+            while ( j < Count && KeepsPosition( Block[ j ].Op ) ) j++;
+
+            const bool Free = j < Count ? Block[ j ].Op == OpJumpAbs || Block[ j ].Op == OpJumpAbs3D : !Last;
+
+            Order( Block, Known, !Free, &X, &Y );
+            Known = true;
+            continue;
+
+        }
+
+        const ListCommand& c = Block[ i ];
+
+        switch ( c.Op )
+        {
+        case OpJumpAbs3D:
+        case OpMarkAbs:
+        case OpMarkAbs3D:
+        case OpFlyReturn:   X = c.I[ 0 ];     Y = c.I[ 1 ];     Known = true;   break;
+        case OpJumpRel:
+        case OpMarkRel:     X += c.I[ 0 ];    Y += c.I[ 1 ];                    break;
+        case OpArcAbs:      ArcEnd( c.I[ 0 ], c.I[ 1 ], c.D[ 0 ], &X, &Y );               break;
+        case OpArcRel:      ArcEnd( X + c.I[ 0 ], Y + c.I[ 1 ], c.D[ 0 ], &X, &Y );       break;
+
+        default:
+            if ( LosesPosition( c.Op ) ) Known = false;
+            break;
+
+        }
+
+        i += c.Op == OpMarkText || c.Op == OpMarkTextAbs ? 1 + ListTextRecords( c.Arg ) : 1;
+
+    }
+
+}
+
+//  Reorders the run of Lines by nearest neighbour from *X, *Y, which is
+//  set to the end of the run. With KeepLast the last polyline stays last,
+//  so a command using the position after the run finds it unchanged.
+void ChunkPrepare::Order( ListJob& Block, bool Known, bool KeepLast, double* pX, double* pY )
+{
+    const size_t n = Lines.size(), Free = KeepLast ? n - 1 : n;
+    size_t First = 0;
+    double X = *pX, Y = *pY;
+
+    if ( !Known )
+    {
+        X = Lines[ 0 ].X1;
+        Y = Lines[ 0 ].Y1;
+        First = 1;
+
+    }
+
+    if ( !e.Optimize || Free < First + 2 )
+    {
+        for ( size_t k = First; k < n; k++ )
+        {
+            JumpLength += hypot( Lines[ k ].X0 - X, Lines[ k ].Y0 - Y );
+            X = Lines[ k ].X1;
+            Y = Lines[ k ].Y1;
+
+        }
+
+        *pX = X;
+        *pY = Y;
+        return;
+
+    }
+
+    const size_t Begin = Lines[ 0 ].Begin;
+    Used.assign( n, 0 );
+    Local.clear();
+
+    if ( First ) Local.insert( Local.end(), Block.begin() + Lines[ 0 ].Begin, Block.begin() + Lines[ 0 ].End );
+
+    for ( size_t k = First; k < n; k++ )
+    {
+        size_t Best = n;
+        double BestDistance = 0.0;
+
+        for ( size_t m = First; m < Free; m++ )
+        {
+            if ( Used[ m ] ) continue;
+
+            const double dX = Lines[ m ].X0 - X, dY = Lines[ m ].Y0 - Y;
+            const double d  = dX * dX + dY * dY;
+
+            if ( Best == n || d < BestDistance )
+            {
+                Best = m;
+                BestDistance = d;
+
+            }
+
+        }
+
+        if ( Best == n )
+        {
+            Best = n - 1;
+            BestDistance = ( Lines[ Best ].X0 - X ) * ( Lines[ Best ].X0 - X ) + ( Lines[ Best ].Y0 - Y ) * ( Lines[ Best ].Y0 - Y );
+
+        }
+
+        const Polyline& p = Lines[ Best ];
+        Used[ Best ] = 1;
+        if ( Best != k ) Reordered++;
+        JumpLength += sqrt( BestDistance );
+        X = p.X1;
+        Y = p.Y1;
+        Local.insert( Local.end(), Block.begin() + p.Begin, Block.begin() + p.End );
+
+    }
+
+    std::copy( Local.begin(), Local.end(), Block.begin() + Begin );
+    *pX = X;
+    *pY = Y;
+
+}
+
+//  Chunk
+//
+//  Description:
+//
+//  Writes chunk k through the stages to Out. The block of the stages
+//  keeps its memory from chunk to chunk.
+//
+
+void ChunkPrepare::Chunk( UINT k, CommandBuffer& Out )
+{
+    const ListCommand* Cmd   = e.Job + e.ChunkStart[ k ];
+    const size_t       Count = e.ChunkStart[ k + 1 ] - e.ChunkStart[ k ];
+
+    Block.clear();
+
+    if ( Identity ) Block.insert( Block.end(), Cmd, Cmd + Count );
+    else Transform( Cmd, Count, Block );
+
+    Order( Block, k + 1 == e.Chunks );
+
+    if ( e.Stage ) e.Stage( k, Block, e.Context );
+
+    Out.Add( Block.data(), Block.size() );
+
+}
+
+//  PrepareEngine
+
+PrepareEngine::PrepareEngine()
+    : ChunkSize( 4096 ), Optimize( true ), Stage( 0 ), Context( 0 ), Threads( 0 ),
+      Chunks( 0 ), PlanTime( 0.0 ),
+      Records( 0 ), Reordered( 0 ), Steals( 0 ), Allocations( 0 ), JumpLength( 0.0 ), FeedError( FeedNoError ),
+      FirstChunkTime( 0.0 ), PrepareTime( 0.0 ), WriteTime( 0.0 ), Job( 0 )
+{
+    Matrix[ 0 ] = Matrix[ 3 ] = 1.0;
+    Matrix[ 1 ] = Matrix[ 2 ] = 0.0;
+    Offset[ 0 ] = Offset[ 1 ] = 0.0;
+
+}
+
+//  Plan
+//
+//  Description:
+//
+//  Splits the job into chunks of at least ChunkSize records, each but the
+//  first starting with a jump_abs. Only the operations are read, the job
+//  is not copied.
+//
+//      Return                  Meaning
+//
+//      PrepareNoError          planned
+//      PrepareRangeError       ChunkSize 0
+//
+
+UINT PrepareEngine::Plan( const ListCommand* Cmd, size_t Count )
+{
+    const auto t0 = std::chrono::steady_clock::now();
+
+    Job    = Cmd;
+    Chunks = 0;
+    ChunkStart.clear();
+
+    if ( !ChunkSize ) return PrepareRangeError;
+
+    ChunkStart.push_back( 0 );
+
+    for ( size_t i = ChunkSize; i < Count; i++ )
+    {
+        if ( Cmd[ i ].Op == OpJumpAbs || Cmd[ i ].Op == OpJumpAbs3D )
+        {
+            ChunkStart.push_back( i );
+            i += ChunkSize - 1;
+
+        }
+
+    }
+
+    if ( Count ) ChunkStart.push_back( Count );
+
+    Chunks   = (UINT) ChunkStart.size() - 1;
+    PlanTime = Seconds( t0 );
+
+    return PrepareNoError;
+
+}
+
+//  Run
+//
+//  Description:
+//
+//  Writes the chunks in their order to Out or feeds them to the ListFeeder
+//  while the following chunks are prepared.
+//
+//      Return                  Meaning
+//
+//      PrepareNoError          all chunks written
+//      PrepareRangeError       not planned
+//      PrepareFeedError        the ListFeeder failed with FeedError, the
+//                              chunks before were written
+//
+
+UINT PrepareEngine::Run( ListJob& Out )
+{
+    return Run( &Out, 0 );
+
+}
+
+UINT PrepareEngine::Run( ListFeeder& Feeder )
+{
+    return Run( 0, &Feeder );
+
+}
+
+UINT PrepareEngine::Run( ListJob* Out, ListFeeder* Feeder )
+{
+    Records   = Reordered = Steals = Allocations = 0;
+    JumpLength = 0.0;
+    FeedError = FeedNoError;
+    FirstChunkTime = PrepareTime = WriteTime = 0.0;
+
+    if ( ChunkStart.empty() ) return PrepareRangeError;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const UINT n  = std::max( 1u, Threads ? Threads : std::thread::hardware_concurrency() );
+    const UINT Count = Chunks;
+    const UINT w  = std::min( n, std::max( Count, 1u ) );
+
+    //  The queues of the threads, chunk t, t + w, ... for thread t
+    struct Queue
+    {
+        std::mutex Lock;
+        std::vector< UINT > Chunks;
+        size_t   Head;
+
+    };
+
+    std::vector< Queue > Queues( w );
+
+    for ( UINT t = 0; t < w; t++ )
+    {
+        Queues[ t ].Head = 0;
+        for ( UINT k = t; k < Count; k += w ) Queues[ t ].Chunks.push_back( k );
+
+    }
+
+    //  The next chunk of thread t, its own or the lowest of another queue
+    auto Take = [ & ]( UINT t ) -> UINT
+    {
+        {
+            std::lock_guard< std::mutex > Guard( Queues[ t ].Lock );
+            if ( Queues[ t ].Head < Queues[ t ].Chunks.size() ) return Queues[ t ].Chunks[ Queues[ t ].Head++ ];
+
+        }
+
+        for ( ;; )
+        {
+            UINT Victim = None, Lowest = None;
+
+            for ( UINT v = 0; v < w; v++ )
+            {
+                std::lock_guard< std::mutex > Guard( Queues[ v ].Lock );
+                if ( Queues[ v ].Head == Queues[ v ].Chunks.size() ) continue;
+
+                if ( Queues[ v ].Chunks[ Queues[ v ].Head ] < Lowest )
+                {
+                    Victim = v;
+                    Lowest = Queues[ v ].Chunks[ Queues[ v ].Head ];
+
+                }
+
+            }
+
+            if ( Victim == None ) return None;
+
+            std::lock_guard< std::mutex > Guard( Queues[ Victim ].Lock );
+
+            if (   Queues[ Victim ].Head < Queues[ Victim ].Chunks.size()
+                && Queues[ Victim ].Chunks[ Queues[ Victim ].Head ] == Lowest
+               )
+            {
+                Queues[ Victim ].Head++;
+                return Lowest;
+
+            }
+
+        }
+
+    };
+
+    //  Chunks prepared by the workers, written here in their order, the
+    //  slabs of a chunk return to the arena of the writer
+    const uint64_t Allocated = Pool.Allocations;
+    CommandArena Arena( Pool );
+    std::vector< CommandBuffer > Blocks( Count );
+    std::vector< uint8_t > Done( Count, 0 );
+    std::mutex Lock;
+    std::condition_variable Ready, Room;
+    std::atomic< UINT > Starting( 0 );
+    size_t Written = 0, Prepared = 0;
+    bool   Abort = false;
+
+    for ( UINT k = 0; k < Count; k++ ) Blocks[ k ].Use( Arena );
+
+    auto Work = [ & ]()
+    {
+        const UINT t = Starting++;
+        CommandArena Slabs( Pool );
+        ChunkPrepare p( *this );
+        uint64_t Stolen = 0;
+
+        for ( UINT k; ( k = Take( t ) ) != None; )
+        {
+            if ( k % w != t ) Stolen++;
+
+            {
+                std::unique_lock< std::mutex > Guard( Lock );
+                Room.wait( Guard, [ & ]() { return Abort || k < Written + MaxAhead * w; } );
+                if ( Abort ) break;
+
+            }
+
+            CommandBuffer Block( Slabs );
+            p.Chunk( k, Block );
+
+            std::lock_guard< std::mutex > Guard( Lock );
+            Blocks[ k ].Swap( Block );
+            Done[ k ] = 1;
+            if ( ++Prepared == Count ) PrepareTime = Seconds( t0 );
+            Ready.notify_one();
+
+        }
+
+        std::lock_guard< std::mutex > Guard( Lock );
+        Reordered  += p.Reordered;
+        JumpLength += p.JumpLength;
+        Steals     += Stolen;
+
+    };
+
+    std::vector< std::thread > Workers;
+    for ( UINT t = 0; t < w && Count; t++ ) Workers.push_back( std::thread( Work ) );
+
+    UINT Error = PrepareNoError;
+
+    CommandBuffer Block( Arena );
+
+    for ( UINT k = 0; k < Count && !FeedError; k++ )
+    {
+        {
+            std::unique_lock< std::mutex > Guard( Lock );
+            Ready.wait( Guard, [ & ]() { return Done[ k ] != 0; } );
+            Block.Swap( Blocks[ k ] );
+
+        }
+
+        if ( Out ) Block.CopyTo( *Out );
+
+        if ( Feeder ) FeedError = Block.Feed( *Feeder );
+
+        Records += Block.Count();
+        Block.Clear();
+        if ( k == 0 ) FirstChunkTime = Seconds( t0 );
+
+        std::lock_guard< std::mutex > Guard( Lock );
+        Written = k + 1;
+        Room.notify_all();
+
+    }
+
+    if ( FeedError )
+    {
+        std::lock_guard< std::mutex > Guard( Lock );
+        Error = PrepareFeedError;
+        Abort = true;
+        Room.notify_all();
+
+    }
+
+    for ( size_t t = 0; t < Workers.size(); t++ ) Workers[ t ].join();
+
+    WriteTime = Seconds( t0 );
+    Allocations = Pool.Allocations - Allocated;
+    if ( !Count ) FirstChunkTime = WriteTime;
+    if ( !Count || Abort ) PrepareTime = WriteTime;
+
+    return Error;
+
+}
@@ -0,0 +1,112 @@
+//  File
+//      RTC5Prepare.h
+//
+//  Abstract
+//      Chunked preparation of large jobs while they are marked.
+//      A PrepareEngine splits a job into chunks that do not depend on each
+//      other, transforms, optimizes and encodes them on a pool of worker
+//      threads and writes them in their order into a job or straight into
+//      a ListFeeder. Marking starts as soon as chunk 0 is prepared, so the
+//      time to the first mark does not grow with the size of the job.
+//
+//  Comment
+//      A chunk holds at least ChunkSize records and ends before the next
+//      jump_abs, so the relative vectors of a chunk never refer to a
+//      position of the chunk before. A job without absolute jumps is one
+//      chunk.
+//      The stages of a chunk, in this order:
+//          Transform   Matrix and Offset applied to the vectors on the
+//                      host, positions rounded once, relative vectors
+//                      follow the rounded absolute positions and do not
+//                      drift. Arcs stay circles under rotation, mirroring
+//                      and uniform scale only.
+//          Optimize    polylines, a jump_abs followed by marks and arcs,
+//                      reordered by nearest neighbour between two other
+//                      commands, so parameters stay with their vectors.
+//                      The last polyline stays last unless the next
+//                      command after the parameters is a jump_abs, so
+//                      relative vectors, arcs and marks after the run
+//                      start where they did.
+//          Stage       a function of the caller, e.g. encoding the chunk
+//                      into other commands.
+//      The chunks are dealt round robin to one queue per thread. A thread
+//      takes the chunks of its queue in order and, when its queue is
+//      empty, steals the lowest chunk of the other queues, so the chunk
+//      the writer waits for is never stuck behind a long one. A thread
+//      waits while its chunk is more than MaxAhead chunks per thread ahead
+//      of the writer.
+//      The records are read from the caller's memory, which must stay
+//      valid from Plan until Run returns. The prepared chunks are held in
+//      CommandBuffers of a SlabPool kept by the engine, once it has grown
+//      to the chunks in flight a Run allocates no memory per chunk.
+//
+//  Necessary Sources
+//      RTC5Prepare.h, RTC5Prepare.cpp, RTC5Arena.h, RTC5Arena.cpp,
+//      RTC5Feeder.h, RTC5Feeder.cpp, RTC5Job.h, RTC5Job.cpp, RTC5List.h,
+//      RTC5List.cpp, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "RTC5Arena.h"
+#include "RTC5Feeder.h"
+#include "RTC5List.h"
+
+//  Error codes of the engine
+const UINT   PrepareNoError       =            0;
+const UINT   PrepareRangeError    =            1;   //  ChunkSize 0 or not planned
+const UINT   PrepareFeedError     =            2;   //  ListFeeder error, see PrepareEngine::FeedError
+
+class PrepareEngine
+{
+public:
+    PrepareEngine();
+
+    UINT     Plan( const ListCommand* Cmd, size_t Count );  //  split the job into chunks
+    UINT     Run( ListJob& Out );
+    UINT     Run( ListFeeder& Feeder );             //  opened by the caller, not finished
+
+    //  Settings, read by Plan
+    size_t   ChunkSize;                             //  records of a chunk at least
+
+    //  Settings, read by Run
+    double   Matrix[ 4 ];                           //  M11, M12, M21, M22 of the transformation
+    double   Offset[ 2 ];                           //  [bits] after the matrix
+    bool     Optimize;                              //  reorder the polylines of a chunk
+    void   ( *Stage )( UINT Chunk, ListJob& Block, void* Context );    //  last stage, NULL: none
+    void*    Context;                               //  of Stage
+    UINT     Threads;                               //  0: one per processor
+
+    //  Results of Plan
+    UINT     Chunks;
+    double   PlanTime;                              //  [s] wall clock
+
+    //  Results of Run
+    uint64_t Records;                               //  written
+    uint64_t Reordered;                             //  polylines moved by Optimize
+    uint64_t Steals;                                //  chunks taken from the queue of another thread
+    uint64_t Allocations;                           //  slabs allocated from the heap
+    double   JumpLength;                            //  [bits] of the jump_abs between polylines, after Optimize
+    UINT     FeedError;                             //  of the ListFeeder with PrepareFeedError
+    double   FirstChunkTime;                        //  [s] wall clock until chunk 0 was written
+    double   PrepareTime;                           //  [s] wall clock until the last chunk was prepared
+    double   WriteTime;                             //  [s] wall clock until the last chunk was written
+
+private:
+    PrepareEngine( const PrepareEngine& );
+    PrepareEngine& operator=( const PrepareEngine& );
+
+    friend class ChunkPrepare;
+
+    UINT     Run( ListJob* Out, ListFeeder* Feeder );
+
+    const ListCommand* Job;
+    std::vector< size_t > ChunkStart;               //  per chunk into Job, one more than chunks
+    SlabPool Pool;                                  //  of the prepared chunks, kept from Run to Run
+
+};
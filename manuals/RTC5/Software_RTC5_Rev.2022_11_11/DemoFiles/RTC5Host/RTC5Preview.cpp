@@ -0,0 +1,944 @@
+//  File
+//      RTC5Preview.cpp
+//
+//  Abstract
+//      Preview images of list command streams
+//
+//  Comment
+//      A line covers one pixel per column, or per row if it is steeper than
+//      45 deg: the pixel its centre line crosses at the centre of the
+//      column, the ends clamped to the line. Its dwell is spread evenly
+//      over these pixels. The tiles a line crosses follow from the first
+//      and the last pixel of the line in every column of tiles, the drawing
+//      of a tile restricts the columns to those which may hit it and checks
+//      the rows per pixel. Both compute the row by the same float
+//      expression, so a pixel is drawn by exactly one tile.
+//
+//      The PNG files are written with stored (uncompressed) deflate blocks,
+//      no compression library is needed.
+//
+//  Necessary Sources
+//      RTC5Preview.h, RTC5Timing.h, RTC5List.h, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "RTC5Preview.h"
+#include "RTC5Timing.h"
+#include "RTC5Util.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define PREVIEW_SSE2
+#include <emmintrin.h>
+#endif
+
+static const double PixelUnit            =  1e-6 / 64.0;   //  [s] pulse length of set_pixel, set_n_pixel
+static const double FieldMin             =    -524288.0;   //  [bits]
+static const double FieldSize            =    1048576.0;
+static const UINT   MaxDepth             =            8;   //  nested subroutines and characters
+static const UINT   MaxArcChords         =         4096;
+static const UINT   HeatDecades          =            3;   //  dwell range of the heatmap
+
+//  PreviewWalk
+//
+//  The strokes of a job in output coordinates
+
+class PreviewWalk
+{
+public:
+    PreviewWalk( const PreviewRenderer& r, std::vector< PreviewStroke >& Out );
+
+    void     Walk( const ListCommand* Cmd, size_t Count, double OriginX, double OriginY, UINT Depth );
+
+    uint64_t Unresolved;
+
+private:
+    PreviewWalk& operator=( const PreviewWalk& );
+
+    void     Transform( double X, double Y, double* oX, double* oY ) const;
+    void     Add( double X0, double Y0, double X1, double Y1, double Dwell );
+    void     Move( double X, double Y, bool Mark );
+    void     Arc( double CenterX, double CenterY, double Angle );
+    void     Pixels( const ListCommand& Cmd );
+    void     Text( const char* Text, size_t Length, bool Abs, UINT Depth );
+
+    const PreviewRenderer& Renderer;
+    std::vector< PreviewStroke >& Strokes;
+    TimingModel Model;
+    double   PosX, PosY;        //  list coordinates
+    double   Matrix[ 2 ][ 2 ];
+    double   Offset[ 2 ];
+    UINT     CharSet;
+
+};
+
+PreviewWalk::PreviewWalk( const PreviewRenderer& r, std::vector< PreviewStroke >& Out )
+    : Unresolved( 0 ), Renderer( r ), Strokes( Out ), PosX( 0.0 ), PosY( 0.0 ), CharSet( 0 )
+{
+    Matrix[ 0 ][ 0 ] = Matrix[ 1 ][ 1 ] = 1.0;
+    Matrix[ 0 ][ 1 ] = Matrix[ 1 ][ 0 ] = 0.0;
+    Offset[ 0 ] = Offset[ 1 ] = 0.0;
+
+}
+
+void PreviewWalk::Transform( double X, double Y, double* oX, double* oY ) const
+{
+    *oX = Matrix[ 0 ][ 0 ] * X + Matrix[ 0 ][ 1 ] * Y + Offset[ 0 ];
+    *oY = Matrix[ 1 ][ 0 ] * X + Matrix[ 1 ][ 1 ] * Y + Offset[ 1 ];
+
+}
+
+void PreviewWalk::Add( double X0, double Y0, double X1, double Y1, double Dwell )
+{
+    const PreviewStroke s = { (float) X0, (float) Y0, (float) X1, (float) Y1, (float) Dwell };
+    Strokes.push_back( s );
+
+}
+
+void PreviewWalk::Move( double X, double Y, bool Mark )
+{
+    const double FromX = Model.X, FromY = Model.Y;
+    double oX, oY;
+    Transform( X, Y, &oX, &oY );
+
+    if ( Mark )
+    {
+        const double Corner = Model.Time.T[ TimePolygonDelay ];
+        Model.Mark( oX, oY );
+
+        //  The laser stays on at the corner during the polygon delay
+        if ( Model.Time.T[ TimePolygonDelay ] > Corner ) Add( FromX, FromY, FromX, FromY, Model.Time.T[ TimePolygonDelay ] - Corner );
+
+        Add( FromX, FromY, oX, oY, Model.Last.Duration );
+
+    }
+    else
+    {
+        Model.Jump( oX, oY );
+
+        if ( Renderer.Jumps ) Add( FromX, FromY, oX, oY, -1.0 );
+
+    }
+
+    PosX = X;
+    PosY = Y;
+
+}
+
+void PreviewWalk::Arc( double CenterX, double CenterY, double Angle )
+{
+    const double FromX = Model.X, FromY = Model.Y, Corner = Model.Time.T[ TimePolygonDelay ];
+    double oX, oY;
+    Transform( CenterX, CenterY, &oX, &oY );
+    Model.Arc( oX, oY, Angle );
+
+    if ( Model.Time.T[ TimePolygonDelay ] > Corner ) Add( FromX, FromY, FromX, FromY, Model.Time.T[ TimePolygonDelay ] - Corner );
+
+    //  Chords of the arc in list coordinates, transformed
+    const double a = Angle * Pi / 180.0;
+    const double vX = PosX - CenterX, vY = PosY - CenterY;
+    const double r  = sqrt( ( FromX - oX ) * ( FromX - oX ) + ( FromY - oY ) * ( FromY - oY ) );
+    const double Step = r > Renderer.Tolerance ? 2.0 * acos( 1.0 - Renderer.Tolerance / r ) : Pi;
+    const UINT n = (UINT) std::min( (double) MaxArcChords, std::max( 1.0, ceil( fabs( a ) / Step ) ) );
+
+    double X0 = FromX, Y0 = FromY;
+
+    for ( UINT k = 1; k <= n; k++ )
+    {
+        const double b = a * k / n;
+        double X1, Y1;
+        Transform( CenterX + vX * cos( b ) + vY * sin( b ), CenterY + vY * cos( b ) - vX * sin( b ), &X1, &Y1 );
+        Add( X0, Y0, X1, Y1, Model.Last.Duration / n );
+        X0 = X1;
+        Y0 = Y1;
+
+    }
+
+    PosX = CenterX + vX * cos( a ) + vY * sin( a );
+    PosY = CenterY + vY * cos( a ) - vX * sin( a );
+    Transform( PosX, PosY, &Model.X, &Model.Y );
+
+}
+
+//  A run of pixels as one stroke through them
+void PreviewWalk::Pixels( const ListCommand& Cmd )
+{
+    const UINT n = Cmd.Op == OpSetPixel ? 1 : (UINT) Cmd.I[ 2 ];
+    const double X0 = Model.X, Y0 = Model.Y;
+
+    Model.Pixels( n );
+
+    if ( n ) Add( X0, Y0, X0 + ( n - 1 ) * Model.PixelX, Y0 + ( n - 1 ) * Model.PixelY, n * Cmd.I[ 0 ] * PixelUnit );
+
+    PosX += Model.X - X0;
+    PosY += Model.Y - Y0;
+
+}
+
+//  Characters marked like sub_call or sub_call_abs of their table entries
+void PreviewWalk::Text( const char* Text, size_t Length, bool Abs, UINT Depth )
+{
+    Model.EndOfVector();
+
+    for ( size_t i = 0; i < Length; i++ )
+    {
+        const UINT Code = CharSet * 256 + (unsigned char) Text[ i ];
+
+        if ( Code < Renderer.Chars.size() && Renderer.Chars[ Code ].Cmd && Depth < MaxDepth )
+        {
+            Walk( Renderer.Chars[ Code ].Cmd, Renderer.Chars[ Code ].Count, Abs ? PosX : 0.0, Abs ? PosY : 0.0, Depth + 1 );
+            Model.EndOfVector();
+
+        }
+
+    }
+
+}
+
+void PreviewWalk::Walk( const ListCommand* Cmd, size_t Count, double OriginX, double OriginY, UINT Depth )
+{
+    for ( size_t i = 0; i < Count; i++ )
+    {
+        const ListCommand& c = Cmd[ i ];
+
+        switch ( c.Op )
+        {
+        case OpTextData:    break;
+
+        case OpJumpAbs:     Move( OriginX + c.I[ 0 ], OriginY + c.I[ 1 ], false );        break;
+        case OpMarkAbs:     Move( OriginX + c.I[ 0 ], OriginY + c.I[ 1 ], true );         break;
+        case OpJumpAbs3D:   Move( OriginX + c.I[ 0 ], OriginY + c.I[ 1 ], false );        break;
+        case OpMarkAbs3D:   Move( OriginX + c.I[ 0 ], OriginY + c.I[ 1 ], true );         break;
+        case OpJumpRel:     Move( PosX + c.I[ 0 ], PosY + c.I[ 1 ], false );              break;
+        case OpMarkRel:     Move( PosX + c.I[ 0 ], PosY + c.I[ 1 ], true );               break;
+        case OpArcAbs:      Arc( OriginX + c.I[ 0 ], OriginY + c.I[ 1 ], c.D[ 0 ] );      break;
+        case OpArcRel:      Arc( PosX + c.I[ 0 ], PosY + c.I[ 1 ], c.D[ 0 ] );            break;
+        case OpSetPixel:
+        case OpSetNPixel:   Pixels( c );                                                  break;
+        case OpSelectCharSet: CharSet = c.I[ 0 ] & 3;                                     break;
+
+        case OpSubCall:
+        case OpSubCallAbs:
+            Model.EndOfVector();
+
+            if ( (UINT) c.I[ 0 ] < Renderer.Subs.size() && Renderer.Subs[ c.I[ 0 ] ].Cmd && Depth < MaxDepth )
+            {
+                const bool Abs = c.Op == OpSubCallAbs;
+                Walk( Renderer.Subs[ c.I[ 0 ] ].Cmd, Renderer.Subs[ c.I[ 0 ] ].Count, Abs ? PosX : 0.0, Abs ? PosY : 0.0, Depth + 1 );
+
+            }
+            else
+            {
+                Unresolved++;
+
+            }
+
+            break;
+
+        case OpListReturn:
+            Model.EndOfVector();
+
+            if ( Depth ) return;
+
+            break;
+
+        case OpLongDelay:   Model.Delay( c.I[ 0 ] );                                      break;
+        case OpNop:         Model.Nop();                                                  break;
+        case OpStepperAbs:  Model.StepperAbs( c.I[ 0 ], c.I[ 1 ] );                       break;
+        case OpStepperWait: Model.StepperWait( c.I[ 0 ] );                                break;
+        case OpWaitForEncoder:  Model.WaitForEncoder( c.I[ 0 ], c.I[ 1 ] );               break;
+        case OpFlyReturn:   Move( c.I[ 0 ], c.I[ 1 ], false );                            break;
+
+        case OpEndOfList:
+        case OpSetWait:
+        case OpSaveAndRestartTimer:
+            Model.EndOfVector();
+            break;
+
+        case OpMarkText:
+        case OpMarkTextAbs:
+        {
+            //  The text follows in OpTextData records
+            std::string s;
+
+            for ( size_t k = i + 1; k < Count && Cmd[ k ].Op == OpTextData && s.size() < c.Arg; k++ )
+            {
+                s.append( ListText( Cmd[ k ] ), Cmd[ k ].Arg );
+
+            }
+
+            Text( s.data(), s.size(), c.Op == OpMarkTextAbs, Depth );
+            break;
+
+        }
+
+        case OpMarkChar:
+        case OpMarkCharAbs:
+        {
+            const char Char = (char) c.I[ 0 ];
+            Text( &Char, 1, c.Op == OpMarkCharAbs, Depth );
+            break;
+
+        }
+
+        case OpMarkSerial:
+        case OpMarkSerialAbs:
+        case OpMarkDate:
+        case OpMarkDateAbs:
+        case OpMarkTime:
+        case OpMarkTimeAbs:
+        case OpListCall:
+        case OpListCallAbs:
+        case OpListJumpPos:
+            Model.EndOfVector();
+            Unresolved++;
+            break;
+
+        //  Only one scan head is drawn, head no. 0 (both) and 1 apply
+        case OpSetOffset:
+            if ( c.Arg < 2 )
+            {
+                Offset[ 0 ] = c.I[ 0 ];
+                Offset[ 1 ] = c.I[ 1 ];
+
+            }
+
+            break;
+
+        case OpSetMatrix:
+            if ( c.Arg < 2 && c.I[ 0 ] >= 1 && c.I[ 0 ] <= 2 && c.I[ 1 ] >= 1 && c.I[ 1 ] <= 2 )
+            {
+                Matrix[ c.I[ 0 ] - 1 ][ c.I[ 1 ] - 1 ] = c.D[ 0 ];
+
+            }
+
+            break;
+
+        default:
+            Model.Apply( c );
+            break;
+
+        }
+
+    }
+
+}
+
+//  A stroke in pixel coordinates along its major axis U, V the other one,
+//  U0 <= U1. Pixel A of the major axis is hit at row MinorAt( A ).
+struct PreviewLine
+{
+    bool     Steep;             //  U is the y axis
+    int      A0, A1;            //  first and last pixel along U
+    float    U0, U1, V0, Slope;
+    float    Dwell;             //  per pixel, < 0 for a jump
+
+    void     Make( const PreviewStroke& s )
+    {
+        Steep = fabsf( s.Y1 - s.Y0 ) > fabsf( s.X1 - s.X0 );
+
+        float u0 = Steep ? s.Y0 : s.X0, v0 = Steep ? s.X0 : s.Y0;
+        float u1 = Steep ? s.Y1 : s.X1, v1 = Steep ? s.X1 : s.Y1;
+
+        if ( u0 > u1 )
+        {
+            std::swap( u0, u1 );
+            std::swap( v0, v1 );
+
+        }
+
+        U0    = u0;
+        U1    = u1;
+        V0    = v0;
+        Slope = u1 > u0 ? ( v1 - v0 ) / ( u1 - u0 ) : 0.0f;
+        A0    = (int) floorf( u0 );
+        A1    = (int) floorf( u1 );
+        Dwell = s.Dwell < 0.0f ? -1.0f : s.Dwell / ( A1 - A0 + 1 );
+
+    }
+
+    int      MinorAt( int A ) const
+    {
+        const float c = std::min( std::max( (float) A + 0.5f, U0 ), U1 );
+        return (int) floorf( V0 + ( c - U0 ) * Slope );
+
+    }
+
+};
+
+PreviewRenderer::PreviewRenderer()
+    : Width( 1024 ), Height( 1024 ), Fit( true ), Margin( 8 ), Jumps( false ), Tolerance( 4.0 ),
+      TileSize( 128 ), Threads( 0 ), Vectorized( true ),
+      MinX( 0.0 ), MinY( 0.0 ), Scale( 1.0 ), MaxDwell( 0.0 ), Strokes( 0 ), Pixels( 0 ), Unresolved( 0 ),
+      WalkTime( 0.0 ), BinTime( 0.0 ), DrawTime( 0.0 ), TilesX( 0 ), TilesY( 0 )
+{
+}
+
+void PreviewRenderer::SetSub( UINT Index, const ListCommand* Cmd, size_t Count )
+{
+    if ( Index >= Subs.size() )
+    {
+        const Table None = { 0, 0 };
+        Subs.resize( Index + 1, None );
+
+    }
+
+    Subs[ Index ].Cmd   = Cmd;
+    Subs[ Index ].Count = Count;
+
+}
+
+void PreviewRenderer::SetChar( UINT CharSet, UINT Code, const ListCommand* Cmd, size_t Count )
+{
+    if ( CharSet > 3 || Code > 255 ) return;
+
+    const Table None = { 0, 0 };
+    Chars.resize( 4 * 256, None );
+    Chars[ CharSet * 256 + Code ].Cmd   = Cmd;
+    Chars[ CharSet * 256 + Code ].Count = Count;
+
+}
+
+//  Render
+//
+//  Description:
+//
+//  Walks the job, maps the field to the image and draws it.
+//
+//      Return                  Meaning
+//
+//      PreviewNoError          Image and Dwell hold the preview
+//      PreviewRangeError       Width, Height or TileSize 0
+//
+
+UINT PreviewRenderer::Render( const ListCommand* Cmd, size_t Count )
+{
+    if ( !Width || !Height || !TileSize ) return PreviewRangeError;
+
+    const UINT n = std::max( 1u, Threads ? Threads : std::thread::hardware_concurrency() );
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    std::vector< PreviewStroke > In;
+
+    {
+        PreviewWalk w( *this, In );
+        w.Walk( Cmd, Count, 0.0, 0.0, 0 );
+        Unresolved = w.Unresolved;
+
+    }
+
+    Strokes = In.size();
+
+    //  Field
+    if ( Fit && !In.empty() )
+    {
+        float x0 = In[ 0 ].X0, x1 = x0, y0 = In[ 0 ].Y0, y1 = y0;
+
+        for ( size_t i = 0; i < In.size(); i++ )
+        {
+            const PreviewStroke& s = In[ i ];
+            x0 = std::min( x0, std::min( s.X0, s.X1 ) );
+            x1 = std::max( x1, std::max( s.X0, s.X1 ) );
+            y0 = std::min( y0, std::min( s.Y0, s.Y1 ) );
+            y1 = std::max( y1, std::max( s.Y0, s.Y1 ) );
+
+        }
+
+        const double w = Width > 2 * Margin + 1 ? Width - 2 * Margin - 1 : 1;
+        const double h = Height > 2 * Margin + 1 ? Height - 2 * Margin - 1 : 1;
+
+        Scale = std::max( ( x1 - x0 ) / w, ( y1 - y0 ) / h );
+        if ( Scale <= 0.0 ) Scale = 1.0;
+
+        MinX = 0.5 * ( x0 + x1 ) - 0.5 * Width * Scale;
+        MinY = 0.5 * ( y0 + y1 ) - 0.5 * Height * Scale;
+
+    }
+    else
+    {
+        Scale = FieldSize / std::min( Width, Height );
+        MinX  = FieldMin + 0.5 * ( FieldSize - Width * Scale );
+        MinY  = FieldMin + 0.5 * ( FieldSize - Height * Scale );
+
+    }
+
+    //  To pixels, y downwards
+    const double Chunk = (double) In.size() / n;
+
+    Parallel( n, [ this, &In, Chunk ]( UINT t )
+    {
+        const size_t End = (size_t) ( Chunk * ( t + 1 ) );
+
+        for ( size_t i = (size_t) ( Chunk * t ); i < End && i < In.size(); i++ )
+        {
+            PreviewStroke& s = In[ i ];
+            s.X0 = (float) ( ( s.X0 - MinX ) / Scale );
+            s.X1 = (float) ( ( s.X1 - MinX ) / Scale );
+            s.Y0 = (float) ( Height - ( s.Y0 - MinY ) / Scale );
+            s.Y1 = (float) ( Height - ( s.Y1 - MinY ) / Scale );
+
+        }
+
+    } );
+
+    WalkTime = Seconds( t0 );
+    t0 = std::chrono::steady_clock::now();
+
+    Bin( In, n );
+
+    BinTime = Seconds( t0 );
+    t0 = std::chrono::steady_clock::now();
+
+    Draw( In, n );
+
+    DrawTime = Seconds( t0 );
+
+    return PreviewNoError;
+
+}
+
+//  Calls f with the tiles the line crosses, column by column of tiles
+template< class F > static void ForTiles( const PreviewLine& l, int Major, int Minor, int T, int TilesMajor, F f )
+{
+    const int a0 = std::max( l.A0, 0 ), a1 = std::min( l.A1, Major - 1 );
+
+    for ( int c = a0 / T; a0 <= a1 && c <= a1 / T && c < TilesMajor; c++ )
+    {
+        const int p  = std::max( a0, c * T ), q = std::min( a1, c * T + T - 1 );
+        const int j0 = l.MinorAt( p ), j1 = l.MinorAt( q );
+        const int r0 = std::max( std::min( j0, j1 ), 0 ), r1 = std::min( std::max( j0, j1 ), Minor - 1 );
+
+        for ( int r = r0 / T; r0 <= r1 && r <= r1 / T; r++ ) f( c, r );
+
+    }
+
+}
+
+//  Bin
+//
+//  Description:
+//
+//  Sorts the strokes by tiles, counting sort of the chunks of n threads,
+//  the strokes of a tile stay in job order.
+//
+
+void PreviewRenderer::Bin( const std::vector< PreviewStroke >& In, UINT n )
+{
+    const int T = (int) TileSize;
+
+    TilesX = ( Width + TileSize - 1 ) / TileSize;
+    TilesY = ( Height + TileSize - 1 ) / TileSize;
+
+    const size_t Tiles = (size_t) TilesX * TilesY;
+    const double Chunk = (double) In.size() / n;
+    std::vector< std::vector< uint32_t > > Counts( n, std::vector< uint32_t >( Tiles, 0 ) );
+
+    //  Visits the tiles of stroke i
+    auto Visit = [ this, &In, T ]( size_t i, uint32_t* Slot, std::vector< uint32_t >& Next )
+    {
+        PreviewLine l;
+        l.Make( In[ i ] );
+
+        const UINT tx = TilesX, ty = TilesY;
+
+        if ( l.Steep )
+        {
+            ForTiles( l, (int) Height, (int) Width, T, (int) ty, [ & ]( int c, int r ) { Slot[ Next[ (size_t) c * tx + r ]++ ] = (uint32_t) i; } );
+
+        }
+        else
+        {
+            ForTiles( l, (int) Width, (int) Height, T, (int) tx, [ & ]( int c, int r ) { Slot[ Next[ (size_t) r * tx + c ]++ ] = (uint32_t) i; } );
+
+        }
+
+    };
+
+    //  Pass 1: counts per thread and tile, the slots are not written
+    Parallel( n, [ & ]( UINT t )
+    {
+        std::vector< uint32_t >& Count = Counts[ t ];
+        const size_t End = std::min( (size_t) ( Chunk * ( t + 1 ) ), In.size() );
+
+        for ( size_t i = (size_t) ( Chunk * t ); i < End; i++ )
+        {
+            PreviewLine l;
+            l.Make( In[ i ] );
+
+            if ( l.Steep ) ForTiles( l, (int) Height, (int) Width, T, (int) TilesY, [ & ]( int c, int r ) { Count[ (size_t) c * TilesX + r ]++; } );
+            else           ForTiles( l, (int) Width, (int) Height, T, (int) TilesX, [ & ]( int c, int r ) { Count[ (size_t) r * TilesX + c ]++; } );
+
+        }
+
+    } );
+
+    //  Start of every tile and of every thread within it
+    TileStart.assign( Tiles + 1, 0 );
+    uint32_t Sum = 0;
+
+    for ( size_t k = 0; k < Tiles; k++ )
+    {
+        TileStart[ k ] = Sum;
+
+        for ( UINT t = 0; t < n; t++ )
+        {
+            const uint32_t c = Counts[ t ][ k ];
+            Counts[ t ][ k ] = Sum;
+            Sum += c;
+
+        }
+
+    }
+
+    TileStart[ Tiles ] = Sum;
+    TileStrokes.resize( Sum );
+
+    //  Pass 2: stroke indices into the slots
+    Parallel( n, [ & ]( UINT t )
+    {
+        const size_t End = std::min( (size_t) ( Chunk * ( t + 1 ) ), In.size() );
+
+        for ( size_t i = (size_t) ( Chunk * t ); i < End; i++ ) Visit( i, TileStrokes.data(), Counts[ t ] );
+
+    } );
+
+}
+
+//  Draws the line into the tile of Size pixels at Major, Minor. Level and
+//  Heat are the tile buffers, row by row of the image.
+static uint64_t DrawLine( const PreviewLine& l, int Major, int Minor, int Size, int MajorEnd, int MinorEnd,
+                          uint8_t* Level, float* Heat, bool Vectorized )
+{
+    int a0 = std::max( l.A0, Major ), a1 = std::min( l.A1, MajorEnd - 1 );
+
+    //  Columns whose row may lie within the tile
+    if ( l.Slope != 0.0f && a0 <= a1 )
+    {
+        const float s0 = l.U0 + ( Minor - l.V0 ) / l.Slope, s1 = l.U0 + ( MinorEnd - l.V0 ) / l.Slope;
+        const float Lo = std::min( s0, s1 ) - 2.0f, Hi = std::max( s0, s1 ) + 2.0f;
+
+        if ( Lo > (float) a0 ) a0 = (int) std::min( Lo, (float) a1 + 1.0f );
+        if ( Hi < (float) a1 ) a1 = (int) std::max( Hi, (float) a0 - 1.0f );
+
+    }
+
+    const uint8_t Kind  = l.Dwell < 0.0f ? 1 : 2;
+    const float   Dwell = l.Dwell < 0.0f ? 0.0f : l.Dwell;
+    const size_t  Step  = l.Steep ? 1 : Size;       //  Level index per row
+    const size_t  Col   = l.Steep ? Size : 1;       //  per column
+    uint64_t Drawn = 0;
+    int a = a0;
+
+#ifdef PREVIEW_SSE2
+    if ( Vectorized )
+    {
+        const __m128  Half = _mm_set_ps( 3.5f, 2.5f, 1.5f, 0.5f );
+        const __m128  U0   = _mm_set1_ps( l.U0 ), U1 = _mm_set1_ps( l.U1 );
+        const __m128  V0   = _mm_set1_ps( l.V0 ), Slope = _mm_set1_ps( l.Slope );
+        const __m128i Lo   = _mm_set1_epi32( Minor - 1 ), Hi = _mm_set1_epi32( MinorEnd );
+        const __m128i One  = _mm_set1_epi32( 1 );
+
+        for ( ; a + 3 <= a1; a += 4 )
+        {
+            //  Rows of four columns, floor of the row by truncation corrected downwards
+            const __m128  c = _mm_min_ps( _mm_max_ps( _mm_add_ps( _mm_set1_ps( (float) a ), Half ), U0 ), U1 );
+            const __m128  v = _mm_add_ps( V0, _mm_mul_ps( _mm_sub_ps( c, U0 ), Slope ) );
+            __m128i j = _mm_cvttps_epi32( v );
+            j = _mm_sub_epi32( j, _mm_and_si128( _mm_castps_si128( _mm_cmplt_ps( v, _mm_cvtepi32_ps( j ) ) ), One ) );
+
+            const int Mask = _mm_movemask_ps( _mm_castsi128_ps( _mm_and_si128( _mm_cmpgt_epi32( j, Lo ), _mm_cmplt_epi32( j, Hi ) ) ) );
+
+            if ( !Mask ) continue;
+
+            int Row[ 4 ];
+            _mm_storeu_si128( (__m128i*) Row, j );
+
+            for ( int k = 0; k < 4; k++ )
+            {
+                if ( !( Mask & ( 1 << k ) ) ) continue;
+
+                const size_t p = ( Row[ k ] - Minor ) * Step + ( a + k - Major ) * Col;
+                Level[ p ] = std::max( Level[ p ], Kind );
+                Heat[ p ] += Dwell;
+                Drawn++;
+
+            }
+
+        }
+
+    }
+#endif
+
+    for ( ; a <= a1; a++ )
+    {
+        const float c = std::min( std::max( (float) a + 0.5f, l.U0 ), l.U1 );
+        const int   j = (int) floorf( l.V0 + ( c - l.U0 ) * l.Slope );
+
+        if ( j < Minor || j >= MinorEnd ) continue;
+
+        const size_t p = ( j - Minor ) * Step + ( a - Major ) * Col;
+        Level[ p ] = std::max( Level[ p ], Kind );
+        Heat[ p ] += Dwell;
+        Drawn++;
+
+    }
+
+    return Drawn;
+
+}
+
+//  Draw
+//
+//  Description:
+//
+//  The threads take one tile after the other, draw its strokes into their
+//  buffers and copy them into the image.
+//
+
+void PreviewRenderer::Draw( const std::vector< PreviewStroke >& In, UINT n )
+{
+    const int T = (int) TileSize;
+    const size_t Tiles = (size_t) TilesX * TilesY;
+    const uint8_t Gray[ 3 ] = { PreviewBackground, PreviewJump, PreviewMark };
+
+    Image.assign( (size_t) Width * Height, PreviewBackground );
+    Dwell.assign( (size_t) Width * Height, 0.0f );
+
+    std::atomic< size_t >   Next( 0 );
+    std::atomic< uint64_t > Drawn( 0 );
+    std::vector< float >    Max( n, 0.0f );
+
+    Parallel( n, [ & ]( UINT t )
+    {
+        std::vector< uint8_t > Level( (size_t) T * T );
+        std::vector< float >   Heat( (size_t) T * T );
+        uint64_t Count = 0;
+
+        for ( size_t k; ( k = Next++ ) < Tiles; )
+        {
+            const int x0 = (int) ( k % TilesX ) * T, y0 = (int) ( k / TilesX ) * T;
+            const int x1 = std::min( x0 + T, (int) Width ), y1 = std::min( y0 + T, (int) Height );
+
+            if ( TileStart[ k ] == TileStart[ k + 1 ] ) continue;
+
+            std::fill( Level.begin(), Level.end(), 0 );
+            std::fill( Heat.begin(), Heat.end(), 0.0f );
+
+            for ( uint32_t i = TileStart[ k ]; i < TileStart[ k + 1 ]; i++ )
+            {
+                PreviewLine l;
+                l.Make( In[ TileStrokes[ i ] ] );
+
+                if ( l.Steep ) Count += DrawLine( l, y0, x0, T, y1, x1, Level.data(), Heat.data(), Vectorized );
+                else           Count += DrawLine( l, x0, y0, T, x1, y1, Level.data(), Heat.data(), Vectorized );
+
+            }
+
+            for ( int y = y0; y < y1; y++ )
+            {
+                for ( int x = x0; x < x1; x++ )
+                {
+                    const size_t p = (size_t) ( y - y0 ) * T + ( x - x0 );
+                    Image[ (size_t) y * Width + x ] = Gray[ Level[ p ] ];
+                    Dwell[ (size_t) y * Width + x ] = Heat[ p ];
+                    Max[ t ] = std::max( Max[ t ], Heat[ p ] );
+
+                }
+
+            }
+
+        }
+
+        Drawn += Count;
+
+    } );
+
+    Pixels   = Drawn;
+    MaxDwell = *std::max_element( Max.begin(), Max.end() );
+
+}
+
+UINT PreviewRenderer::WritePgm( const char* Name ) const
+{
+    if ( Image.empty() ) return PreviewRangeError;
+
+    FILE* File = fopen( Name, "wb" );
+    if ( !File ) return PreviewFileError;
+
+    fprintf( File, "P5\n%u %u\n255\n", Width, Height );
+    fwrite( Image.data(), 1, Image.size(), File );
+
+    const bool Failed = ferror( File ) != 0;
+
+    return fclose( File ) || Failed ? PreviewFileError : PreviewNoError;
+
+}
+
+//  PNG file
+
+struct CrcTable
+{
+    uint32_t T[ 256 ];
+
+    CrcTable()
+    {
+        for ( uint32_t n = 0; n < 256; n++ )
+        {
+            uint32_t r = n;
+
+            for ( int k = 0; k < 8; k++ ) r = r & 1 ? 0xEDB88320u ^ ( r >> 1 ) : r >> 1;
+
+            T[ n ] = r;
+
+        }
+
+    }
+
+};
+
+static uint32_t Crc( uint32_t c, const uint8_t* Data, size_t Size )
+{
+    static const CrcTable Table;                    //  built once, also by concurrent writers
+
+    c = ~c;
+
+    for ( size_t i = 0; i < Size; i++ ) c = Table.T[ ( c ^ Data[ i ] ) & 0xFF ] ^ ( c >> 8 );
+
+    return ~c;
+
+}
+
+static void Put32( std::vector< uint8_t >& Out, uint32_t v )
+{
+    Out.push_back( (uint8_t) ( v >> 24 ) );
+    Out.push_back( (uint8_t) ( v >> 16 ) );
+    Out.push_back( (uint8_t) ( v >> 8 ) );
+    Out.push_back( (uint8_t) v );
+
+}
+
+static void Chunk( FILE* File, const char* Type, const std::vector< uint8_t >& Data )
+{
+    std::vector< uint8_t > Head;
+    Put32( Head, (uint32_t) Data.size() );
+    Head.insert( Head.end(), Type, Type + 4 );
+
+    const uint32_t c = Crc( Crc( 0, Head.data() + 4, 4 ), Data.data(), Data.size() );
+
+    fwrite( Head.data(), 1, Head.size(), File );
+    fwrite( Data.data(), 1, Data.size(), File );
+
+    Head.clear();
+    Put32( Head, c );
+    fwrite( Head.data(), 1, 4, File );
+
+}
+
+//  Color of the heatmap, black for no dwell, then red, yellow and white
+//  over HeatDecades decades up to Max
+static void HeatColor( float Dwell, double Max, uint8_t* Rgb )
+{
+    double f = Dwell > 0.0f && Max > 0.0 ? 1.0 + log10( Dwell / Max ) / HeatDecades : 0.0;
+
+    f = std::max( 0.0, std::min( 1.0, f ) );
+
+    for ( int k = 0; k < 3; k++ ) Rgb[ k ] = (uint8_t) ( 255.0 * std::max( 0.0, std::min( 1.0, 3.0 * f - k ) ) + 0.5 );
+
+}
+
+//  WritePng
+//
+//  Description:
+//
+//  Writes the image, or the dwell map as a heatmap in RGB.
+//
+//      Parameter   Meaning
+//
+//      Name        file name
+//      Heatmap     true: dwell map, brightness logarithmic over three
+//                  decades below MaxDwell
+//
+
+UINT PreviewRenderer::WritePng( const char* Name, bool Heatmap ) const
+{
+    if ( Image.empty() ) return PreviewRangeError;
+
+    FILE* File = fopen( Name, "wb" );
+    if ( !File ) return PreviewFileError;
+
+    static const uint8_t Signature[ 8 ] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    fwrite( Signature, 1, 8, File );
+
+    std::vector< uint8_t > Data;
+    Put32( Data, Width );
+    Put32( Data, Height );
+    Data.push_back( 8 );                    //  bit depth
+    Data.push_back( Heatmap ? 2 : 0 );      //  RGB or gray
+    Data.push_back( 0 );
+    Data.push_back( 0 );
+    Data.push_back( 0 );
+    Chunk( File, "IHDR", Data );
+
+    //  Rows with filter type 0 in stored deflate blocks of a zlib stream
+    const size_t Row   = ( Heatmap ? 3 : 1 ) * (size_t) Width + 1;
+    const size_t Total = Row * Height;
+    const size_t Block = 65535;
+    std::vector< uint8_t > Raw( Row );
+    uint32_t s1 = 1, s2 = 0;
+
+    Data.clear();
+    Data.push_back( 0x78 );
+    Data.push_back( 0x01 );
+
+    for ( size_t y = 0, Done = 0; y < Height; y++ )
+    {
+        Raw[ 0 ] = 0;
+
+        for ( size_t x = 0; x < Width; x++ )
+        {
+            if ( Heatmap ) HeatColor( Dwell[ y * Width + x ], MaxDwell, &Raw[ 1 + 3 * x ] );
+            else           Raw[ 1 + x ] = Image[ y * Width + x ];
+
+        }
+
+        for ( size_t i = 0; i < Row; i++, Done++ )
+        {
+            if ( Done % Block == 0 )
+            {
+                const size_t   Size = std::min( Block, Total - Done );
+                const uint16_t Len  = (uint16_t) Size, NLen = (uint16_t) ~Len;
+                Data.push_back( Done + Size == Total ? 1 : 0 );
+                Data.push_back( (uint8_t) Len );
+                Data.push_back( (uint8_t) ( Len >> 8 ) );
+                Data.push_back( (uint8_t) NLen );
+                Data.push_back( (uint8_t) ( NLen >> 8 ) );
+
+            }
+
+            Data.push_back( Raw[ i ] );
+            s1 = ( s1 + Raw[ i ] ) % 65521;
+            s2 = ( s2 + s1 ) % 65521;
+
+        }
+
+    }
+
+    Put32( Data, ( s2 << 16 ) | s1 );
+    Chunk( File, "IDAT", Data );
+
+    Data.clear();
+    Chunk( File, "IEND", Data );
+
+    const bool Failed = ferror( File ) != 0;
+
+    return fclose( File ) || Failed ? PreviewFileError : PreviewNoError;
+
+}
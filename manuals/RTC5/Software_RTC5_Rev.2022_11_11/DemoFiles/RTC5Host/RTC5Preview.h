@@ -0,0 +1,115 @@
+//  File
+//      RTC5Preview.h
+//
+//  Abstract
+//      Preview images of list command streams.
+//      A PreviewRenderer walks a job the way the card executes it: jumps,
+//      marks, arcs and pixels, sub_call and sub_call_abs of subroutines
+//      and mark_text and mark_char by the characters of the selected
+//      character set, both passed by SetSub and SetChar, all in output
+//      coordinates after set_matrix_list and set_offset_list. It draws the
+//      marks, optionally the jumps, into a gray image and sums the time the
+//      laser is on per pixel into a dwell map, e.g. to check a job before
+//      a test mark and to find spots burnt by polygon delays.
+//      The image is written as PGM or PNG, the dwell map as a PNG heatmap,
+//      both readable by common image viewers.
+//
+//  Comment
+//      The laser is on along marks and arcs at their speed, at corners for
+//      the polygon delay and at pixels for their pulse length. Arcs are
+//      split into chords deviating by at most Tolerance bits.
+//      The image is divided into tiles of TileSize pixels. The strokes are
+//      sorted by the tiles they cross, then the threads draw one tile at a
+//      time into buffers of their own, every pixel of a line belongs to one
+//      tile only. Lines are drawn four pixels at a time with SSE2 where
+//      available.
+//      mark_serial, mark_date, mark_time, list_call and list_jump_pos depend
+//      on the card and are counted as Unresolved.
+//
+//  Necessary Sources
+//      RTC5Preview.h, RTC5Preview.cpp, RTC5Timing.h, RTC5Timing.cpp,
+//      RTC5List.h, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "RTC5List.h"
+
+//  Error codes of the preview
+const UINT   PreviewNoError       =            0;
+const UINT   PreviewRangeError    =            1;   //  image size, tile size or field empty
+const UINT   PreviewFileError     =            2;   //  image not writable
+
+//  Gray values of the image
+const uint8_t PreviewBackground   =          255;
+const uint8_t PreviewJump         =          200;
+const uint8_t PreviewMark         =            0;
+
+//  A line in output coordinates, X0 == X1 and Y0 == Y1 for a dot
+struct PreviewStroke
+{
+    float    X0, Y0, X1, Y1;    //  [bits]
+    float    Dwell;             //  [s] laser on along the whole stroke, < 0 for a jump
+
+};
+
+class PreviewRenderer
+{
+public:
+    PreviewRenderer();
+
+    //  The records are not copied and must stay valid while Render is used
+    void     SetSub( UINT Index, const ListCommand* Cmd, size_t Count );
+    void     SetChar( UINT CharSet, UINT Code, const ListCommand* Cmd, size_t Count );
+
+    UINT     Render( const ListCommand* Cmd, size_t Count );
+
+    UINT     WritePgm( const char* Name ) const;
+    UINT     WritePng( const char* Name, bool Heatmap = false ) const;
+
+    //  Settings
+    UINT     Width, Height;                         //  [pixels]
+    bool     Fit;                                   //  field: bounding box of the strokes, else the whole field
+    UINT     Margin;                                //  [pixels] around the fitted field
+    bool     Jumps;                                 //  draw the jumps
+    double   Tolerance;                             //  [bits] of the arc chords
+    UINT     TileSize;                              //  [pixels]
+    UINT     Threads;                               //  0: one per processor
+    bool     Vectorized;                            //  false: scalar loops, for comparison
+
+    //  Results
+    std::vector< uint8_t > Image;                   //  Width * Height, top row first
+    std::vector< float >   Dwell;                   //  [s] per pixel, as Image
+    double   MinX, MinY, Scale;                     //  [bits], [bits/pixel] of the lower left corner
+    double   MaxDwell;                              //  [s] of the hottest pixel
+    uint64_t Strokes;
+    uint64_t Pixels;                                //  pixels drawn
+    uint64_t Unresolved;
+    double   WalkTime, BinTime, DrawTime;           //  [s] wall clock
+
+private:
+    PreviewRenderer( const PreviewRenderer& );
+    PreviewRenderer& operator=( const PreviewRenderer& );
+
+    struct Table
+    {
+        const ListCommand* Cmd;
+        size_t Count;
+
+    };
+
+    friend class PreviewWalk;
+
+    void     Bin( const std::vector< PreviewStroke >& In, UINT n );
+    void     Draw( const std::vector< PreviewStroke >& In, UINT n );
+
+    std::vector< Table > Subs, Chars;
+    std::vector< uint32_t > TileStart, TileStrokes;  //  stroke indices per tile
+    UINT     TilesX, TilesY;
+
+};
@@ -0,0 +1,528 @@
+//  File
+//      RTC5Ring.cpp
+//
+//  Abstract
+//      A command ring in shared memory between two processes
+//
+//  Comment
+//      Head and Tail count records from the start and never wrap, the
+//      position in the ring is the index & Mask. Each side caches the
+//      index of the other side and reads it again only when the cached
+//      value shows the ring full or empty, so the cache line of the other
+//      index moves between the cores once per batch, not per record.
+//      Doorbell: the sleeping side sets its Sleeping flag, reads the index
+//      of the other side again and waits on the bell word as read before.
+//      The other side stores its index, then reads the flag (both sequentially
+//      consistent), so either the sleeper sees the new index or the other
+//      side sees the flag and rings. A ring between reading the bell and
+//      the futex wait makes the wait return at once.
+//
+//  Necessary Sources
+//      RTC5Ring.h, RTC5Feeder.h, RTC5Feeder.cpp, RTC5List.h, RTC5expl.h
+//
+//  Environment: Linux
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "RTC5Ring.h"
+
+static const uint32_t RingVersion = 1;
+
+//  The part of the header written once by Create
+struct RingLayout
+{
+    char     Magic[ 4 ];        //  "RCR1"
+    uint32_t Version;
+    uint32_t RecordSize;        //  sizeof( ListCommand )
+    uint32_t Reserved;
+    uint64_t Capacity;          //  records, a power of two
+    uint64_t DataOffset;        //  [bytes] of the records in the memfd, a multiple of the page size
+
+};
+
+struct RingHeader
+{
+    RingLayout Layout;
+
+    alignas( 64 ) std::atomic< uint64_t > Head;     //  records committed, written by the producer
+    std::atomic< uint32_t > Ended;                  //  Finish was called
+
+    alignas( 64 ) std::atomic< uint64_t > Tail;     //  records released, written by the consumer
+
+    alignas( 64 ) std::atomic< uint32_t > DataBell; //  rung by the producer
+    std::atomic< uint32_t > DataSleeping;           //  the consumer waits on DataBell
+
+    alignas( 64 ) std::atomic< uint32_t > SpaceBell;    //  rung by the consumer
+    std::atomic< uint32_t > SpaceSleeping;          //  the producer waits on SpaceBell
+
+};
+
+static_assert( sizeof( ListCommand ) == 32, "ListCommand is part of the ring format" );
+static_assert( ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "the indices are shared between processes" );
+static_assert( sizeof( std::atomic< uint32_t > ) == sizeof( uint32_t ), "the bells are futex words" );
+
+static void FutexWait( std::atomic< uint32_t >& Word, uint32_t Value, double Seconds )
+{
+    timespec t;
+    t.tv_sec  = (time_t) Seconds;
+    t.tv_nsec = (long) ( ( Seconds - (double) t.tv_sec ) * 1e9 );
+
+    syscall( SYS_futex, (uint32_t*) &Word, FUTEX_WAIT, Value, &t, 0, 0 );
+
+}
+
+static void FutexWake( std::atomic< uint32_t >& Word )
+{
+    syscall( SYS_futex, (uint32_t*) &Word, FUTEX_WAKE, INT_MAX, 0, 0, 0 );
+
+}
+
+static size_t PageSize()
+{
+    return (size_t) sysconf( _SC_PAGESIZE );
+
+}
+
+CommandRing::CommandRing()
+    : Spins( 64 ), Timeout( 1.0 ), MaxRead( 0 ), Records( 0 ), Sleeps( 0 ), Rings( 0 ),
+      File( -1 ), Shared( 0 ), Data( 0 ), Size( 0 ), Mask( 0 ), Cached( 0 )
+{
+}
+
+CommandRing::~CommandRing()
+{
+    Close();
+
+}
+
+//  Create
+//
+//  Description:
+//
+//  Creates an empty ring of Capacity records in a new memfd. The records
+//  must fill whole pages, with 4 kB pages at least 128 of them.
+//
+//      Return      RingNoError, RingSystemError or RingFormatError
+//
+
+UINT CommandRing::Create( size_t Capacity )
+{
+    Close();
+
+    const size_t Page = PageSize();
+
+    if ( Capacity < 128 || Capacity & ( Capacity - 1 ) || Capacity * sizeof( ListCommand ) % Page ) return RingFormatError;
+
+    RingLayout Layout;
+    memset( &Layout, 0, sizeof( Layout ) );
+    memcpy( Layout.Magic, "RCR1", 4 );
+    Layout.Version    = RingVersion;
+    Layout.RecordSize = sizeof( ListCommand );
+    Layout.Capacity   = Capacity;
+    Layout.DataOffset = ( sizeof( RingHeader ) + Page - 1 ) / Page * Page;
+
+    File = memfd_create( "RTC5Ring", MFD_CLOEXEC );
+
+    if (   File < 0 || ftruncate( File, (off_t) ( Layout.DataOffset + Capacity * sizeof( ListCommand ) ) )
+        || pwrite( File, &Layout, sizeof( Layout ), 0 ) != (ssize_t) sizeof( Layout )
+       )
+    {
+        const int Error = errno;
+        Close();
+        errno = Error;
+        return RingSystemError;
+
+    }
+
+    return Map();
+
+}
+
+//  Attach
+//
+//  Description:
+//
+//  Maps the ring open as Descriptor, e.g. inherited from the process that
+//  created it. The descriptor is closed by Close, also if it holds no
+//  ring.
+//
+//      Return      RingNoError, RingSystemError or RingFormatError
+//
+
+UINT CommandRing::Attach( int Descriptor )
+{
+    Close();
+
+    if ( Descriptor < 0 ) return RingSystemError;
+
+    File = Descriptor;
+    return Map();
+
+}
+
+UINT CommandRing::Map()
+{
+    const size_t Page = PageSize();
+    RingLayout   Layout;
+    struct stat  Stat;
+
+    if ( fstat( File, &Stat ) || pread( File, &Layout, sizeof( Layout ), 0 ) != (ssize_t) sizeof( Layout ) )
+    {
+        Close();
+        return RingFormatError;
+
+    }
+
+    const uint64_t Bytes = Layout.Capacity * sizeof( ListCommand );
+
+    if (   memcmp( Layout.Magic, "RCR1", 4 ) || Layout.Version != RingVersion
+        || Layout.RecordSize != sizeof( ListCommand ) || Layout.Capacity < 128
+        || Layout.Capacity & ( Layout.Capacity - 1 ) || Bytes % Page
+        || Layout.DataOffset % Page || Layout.DataOffset < sizeof( RingHeader )
+        || (uint64_t) Stat.st_size != Layout.DataOffset + Bytes
+       )
+    {
+        Close();
+        return RingFormatError;
+
+    }
+
+    void* View = mmap( 0, (size_t) Layout.DataOffset, PROT_READ | PROT_WRITE, MAP_SHARED, File, 0 );
+
+    //  Address space for the records twice, then both halves mapped onto them
+    char* Base = (char*) mmap( 0, (size_t) Bytes * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+
+    const bool Mapped =    View != MAP_FAILED && Base != MAP_FAILED
+                        && mmap( Base, (size_t) Bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+                                 File, (off_t) Layout.DataOffset ) != MAP_FAILED
+                        && mmap( Base + Bytes, (size_t) Bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+                                 File, (off_t) Layout.DataOffset ) != MAP_FAILED;
+
+    if ( !Mapped )
+    {
+        const int Error = errno;
+
+        if ( View != MAP_FAILED ) munmap( View, (size_t) Layout.DataOffset );
+        if ( Base != MAP_FAILED ) munmap( Base, (size_t) Bytes * 2 );
+
+        Close();
+        errno = Error;
+        return RingSystemError;
+
+    }
+
+    Shared  = (RingHeader*) View;
+    Data    = (ListCommand*) Base;
+    Size    = (size_t) Layout.Capacity;
+    Mask    = Layout.Capacity - 1;
+    Cached  = 0;
+    Records = Sleeps = Rings = 0;
+
+    return RingNoError;
+
+}
+
+void CommandRing::Close()
+{
+    if ( Data ) munmap( Data, Size * sizeof( ListCommand ) * 2 );
+    if ( Shared ) munmap( Shared, (size_t) Shared->Layout.DataOffset );
+    if ( File >= 0 ) close( File );
+
+    File = -1;
+    Shared = 0;
+    Data = 0;
+    Size = 0;
+    Mask = 0;
+
+}
+
+size_t CommandRing::Fill() const
+{
+    return (size_t) ( Shared->Head.load( std::memory_order_acquire ) - Shared->Tail.load( std::memory_order_acquire ) );
+
+}
+
+//  Wait
+//
+//  Description:
+//
+//  Waits for progress of the other side: Tail of the consumer for Space,
+//  otherwise Head or Ended of the producer. Cached is the index seen last.
+//
+//      Return      RingNoError or RingTimeout
+//
+
+UINT CommandRing::Wait( bool Space )
+{
+    std::atomic< uint64_t >& Other    = Space ? Shared->Tail : Shared->Head;
+    std::atomic< uint32_t >& Bell     = Space ? Shared->SpaceBell : Shared->DataBell;
+    std::atomic< uint32_t >& Sleeping = Space ? Shared->SpaceSleeping : Shared->DataSleeping;
+    const uint64_t Seen = Cached;
+
+    for ( UINT s = 0; s < Spins; s++ )
+    {
+        Cached = Other.load( std::memory_order_acquire );
+
+        if ( Cached != Seen || ( !Space && Shared->Ended.load( std::memory_order_acquire ) ) ) return RingNoError;
+
+        std::this_thread::yield();
+
+    }
+
+    const auto Deadline = std::chrono::steady_clock::now() + std::chrono::duration< double >( Timeout );
+
+    for ( ;; )
+    {
+        const uint32_t Rung = Bell.load();
+        Sleeping.store( 1 );
+        Cached = Other.load();
+
+        if ( Cached != Seen || ( !Space && Shared->Ended.load() ) )
+        {
+            Sleeping.store( 0 );
+            return RingNoError;
+
+        }
+
+        const double Left = std::chrono::duration< double >( Deadline - std::chrono::steady_clock::now() ).count();
+
+        if ( Left <= 0.0 )
+        {
+            Sleeping.store( 0 );
+            return RingTimeout;
+
+        }
+
+        FutexWait( Bell, Rung, Left );
+        Sleeps++;
+
+    }
+
+}
+
+//  Reserve
+//
+//  Description:
+//
+//  The free records in a row at the write position, to be filled in
+//  place and published by Commit. Waits for the consumer while the ring
+//  is full, NULL and Count 0 if it made no progress within Timeout.
+//
+
+ListCommand* CommandRing::Reserve( size_t* Count )
+{
+    const uint64_t h = Shared->Head.load( std::memory_order_relaxed );
+
+    for ( ;; )
+    {
+        if ( h - Cached > Size / 2 ) Cached = Shared->Tail.load( std::memory_order_acquire );
+
+        if ( h - Cached < Size ) break;
+
+        if ( Wait( true ) )
+        {
+            *Count = 0;
+            return 0;
+
+        }
+
+    }
+
+    *Count = Size - (size_t) ( h - Cached );
+    return Data + ( h & Mask );
+
+}
+
+void CommandRing::Commit( size_t Count )
+{
+    Shared->Head.store( Shared->Head.load( std::memory_order_relaxed ) + Count );
+    Records += Count;
+
+    if ( Shared->DataSleeping.load() )
+    {
+        Shared->DataBell.fetch_add( 1 );
+        FutexWake( Shared->DataBell );
+        Rings++;
+
+    }
+
+}
+
+//  Write
+//
+//  Description:
+//
+//  Copies Count records into the ring, waiting for the consumer while the
+//  ring is full.
+//
+//      Return      RingNoError or RingTimeout, Records tells how many
+//                  were written
+//
+
+UINT CommandRing::Write( const ListCommand* Cmd, size_t Count )
+{
+    size_t i = 0;
+
+    while ( i < Count )
+    {
+        size_t       Free;
+        ListCommand* To = Reserve( &Free );
+        size_t       n  = std::min( Free, Count - i );
+
+        if ( !To ) return RingTimeout;
+
+        //  Text records stay with their text command
+        while ( n && i + n < Count && Cmd[ i + n ].Op == OpTextData ) n--;
+
+        if ( !n )
+        {
+            const UINT Error = Wait( true );
+
+            if ( Error ) return Error;
+
+            continue;
+
+        }
+
+        memcpy( To, Cmd + i, n * sizeof( ListCommand ) );
+        Commit( n );
+        i += n;
+
+    }
+
+    return RingNoError;
+
+}
+
+void CommandRing::Finish()
+{
+    Shared->Ended.store( 1 );
+
+    if ( Shared->DataSleeping.load() )
+    {
+        Shared->DataBell.fetch_add( 1 );
+        FutexWake( Shared->DataBell );
+        Rings++;
+
+    }
+
+}
+
+//  Read
+//
+//  Description:
+//
+//  The published records in a row at the read position, waiting for the
+//  producer while the ring is empty. They stay valid until Release.
+//
+//      Return      RingNoError with Count > 0, RingEnded or RingTimeout
+//
+
+UINT CommandRing::Read( const ListCommand** Cmd, size_t* Count )
+{
+    const uint64_t t = Shared->Tail.load( std::memory_order_relaxed );
+
+    *Cmd   = Data + ( t & Mask );
+    *Count = 0;
+
+    for ( ;; )
+    {
+        if ( Cached <= t ) Cached = Shared->Head.load( std::memory_order_acquire );
+
+        if ( Cached > t ) break;
+
+        //  Ended is set after the last Commit, Head is read once more
+        if ( Shared->Ended.load( std::memory_order_acquire ) )
+        {
+            Cached = Shared->Head.load( std::memory_order_acquire );
+
+            if ( Cached > t ) break;
+
+            return RingEnded;
+
+        }
+
+        const UINT Error = Wait( false );
+
+        if ( Error ) return Error;
+
+    }
+
+    size_t n = (size_t) ( Cached - t );
+
+    if ( MaxRead && n > MaxRead )
+    {
+        const size_t Published = n;
+        n = MaxRead;
+
+        while ( n && ( *Cmd )[ n ].Op == OpTextData ) n--;
+
+        if ( !n ) n = Published;
+
+    }
+
+    *Count = n;
+    return RingNoError;
+
+}
+
+void CommandRing::Release( size_t Count )
+{
+    Shared->Tail.store( Shared->Tail.load( std::memory_order_relaxed ) + Count );
+    Records += Count;
+
+    if ( Shared->SpaceSleeping.load() )
+    {
+        Shared->SpaceBell.fetch_add( 1 );
+        FutexWake( Shared->SpaceBell );
+        Rings++;
+
+    }
+
+}
+
+//  RingFeed
+//
+//  Description:
+//
+//  Feeds the records of Ring into list 1 in place until the producer has
+//  finished. A record is released once the ListFeeder has transferred it,
+//  so MaxRead of about a quarter of the list keeps the producer going
+//  while the card executes. After RingTimeout RingFeed may be called
+//  again.
+//
+//      Return      RingNoError, RingTimeout or RingFeedError
+//
+
+UINT RingFeed( CommandRing& Ring, ListFeeder& Feeder )
+{
+    for ( ;; )
+    {
+        const ListCommand* Cmd;
+        size_t Count;
+        const UINT Error = Ring.Read( &Cmd, &Count );
+
+        if ( Error == RingEnded ) return RingNoError;
+        if ( Error ) return Error;
+
+        if ( Feeder.Feed( Cmd, Count ) ) return RingFeedError;
+
+        Ring.Release( Count );
+
+    }
+
+}
@@ -0,0 +1,102 @@
+//  File
+//      RTC5Ring.h
+//
+//  Abstract
+//      A command ring in shared memory between two processes.
+//      A CommandRing passes ListCommand records from a producer process,
+//      e.g. HPGL import, hatching or raster preparation, to a consumer
+//      process feeding the card, so a crash of the job generation does not
+//      take the card feeding with it. The records are written in place by
+//      the producer and handed to the ListFeeder in place by the consumer,
+//      nothing is copied through a socket or pipe.
+//
+//  Comment
+//      One producer and one consumer. The ring is a memfd: a header page
+//      with the write index (Head) and the read index (Tail) on cache lines
+//      of their own, followed by Capacity records. The records are mapped
+//      twice in a row, so every span of up to Capacity records is
+//      contiguous also across the end of the ring.
+//      Records are ListCommand as in job files, the numbering of ListOp is
+//      part of the format. A side finding the ring full or empty polls it
+//      Spins times, then sleeps on a futex doorbell in the header, which the
+//      other side rings only while someone sleeps.
+//      Commit and Write publish whole commands only, a text command is
+//      never published without its text records.
+//      The descriptor of the ring is passed to the other process by fork
+//      or SCM_RIGHTS. A wait ends after Timeout with RingTimeout, so a side
+//      can check whether the other one is still alive.
+//
+//  Necessary Sources
+//      RTC5Ring.h, RTC5Ring.cpp, RTC5Feeder.h, RTC5Feeder.cpp, RTC5Job.h,
+//      RTC5Job.cpp, RTC5List.h, RTC5List.cpp, RTC5expl.h
+//
+//  Environment: Linux
+
+#pragma once
+
+#include <stdint.h>
+
+#include "RTC5Feeder.h"
+#include "RTC5List.h"
+
+//  Error codes of the ring
+const UINT   RingNoError          =            0;
+const UINT   RingSystemError      =            1;   //  memfd or mapping, see errno
+const UINT   RingFormatError      =            2;   //  descriptor holds no ring, capacity not a power of two
+const UINT   RingTimeout          =            3;   //  the other side made no progress within Timeout
+const UINT   RingEnded            =            4;   //  Finish was called and all records are read
+const UINT   RingFeedError        =            5;   //  ListFeeder error, see RingFeed
+
+struct RingHeader;
+
+class CommandRing
+{
+public:
+    CommandRing();
+    ~CommandRing();
+
+    UINT     Create( size_t Capacity );             //  records, a power of two of at least 128
+    UINT     Attach( int Descriptor );              //  of a ring created by another process, takes the descriptor
+    int      Descriptor() const { return File; }
+    void     Close();
+
+    //  Producer
+    ListCommand* Reserve( size_t* Count );          //  free records in a row, waits while full, NULL: RingTimeout
+    void     Commit( size_t Count );                //  publishes the first Count reserved records
+    UINT     Write( const ListCommand* Cmd, size_t Count );     //  waits for space as needed
+    void     Finish();                              //  no more records
+
+    //  Consumer
+    UINT     Read( const ListCommand** Cmd, size_t* Count );    //  waits for records, at most MaxRead
+    void     Release( size_t Count );               //  the first Count records read are done
+
+    size_t   Capacity() const { return Size; }
+    size_t   Fill() const;                          //  published, not released
+
+    //  Settings
+    UINT     Spins;                                 //  polls before sleeping on the doorbell
+    double   Timeout;                               //  [s] per wait
+    size_t   MaxRead;                               //  records per Read, 0: all published
+
+    //  Results of this side
+    uint64_t Records;                               //  committed or released
+    uint64_t Sleeps;                                //  waits on the doorbell
+    uint64_t Rings;                                 //  wakes of the other side
+
+private:
+    CommandRing( const CommandRing& );
+    CommandRing& operator=( const CommandRing& );
+
+    UINT     Map();
+    UINT     Wait( bool Space );
+
+    int      File;
+    RingHeader* Shared;                             //  header page
+    ListCommand* Data;                              //  2 * Size records, the second half mirrors the first
+    size_t   Size;
+    uint64_t Mask;
+    uint64_t Cached;                                //  last index read of the other side
+
+};
+
+UINT RingFeed( CommandRing& Ring, ListFeeder& Feeder );     //  consumes until RingEnded
@@ -0,0 +1,244 @@
+//  File
+//      RTC5Serial.cpp
+//
+//  Abstract
+//      Part serialization with a preloaded list
+//
+//  Comment
+//      The part list is loaded as
+//          select_char_set
+//          per field: jump_abs, mark_text / mark_serial / mark_date / mark_time
+//          set_end_of_list
+//      and started by set_extstartpos. The serial number sets are
+//      initialized by the host once, the card increments them after every
+//      mark_serial. Fields of different sets switch by select_serial_set_list.
+//      A second field of the same set would mark the next number, Preload
+//      rejects it.
+//
+//  Necessary Sources
+//      RTC5Serial.h, RTC5Serial.cpp, RTC5expl.h, RTC5expl.c
+//
+//  Environment: Win32, Linux
+
+#include "RTC5Serial.h"
+
+SerialJob::SerialJob()
+    : CharSet( 0 )
+{
+    for ( UINT i = 0; i < SerialSets; i++ )
+    {
+        First[ i ] = 1;
+        Step[ i ]  = 1;
+
+    }
+
+}
+
+void SerialJob::Literal( LONG X, LONG Y, const char* Text )
+{
+    SerialField f = SerialField();
+    f.Kind = SerialLiteral;
+    f.X    = X;
+    f.Y    = Y;
+    f.Text = Text ? Text : "";
+    Fields.push_back( f );
+
+}
+
+void SerialJob::Number( LONG X, LONG Y, UINT Set, UINT Mode, UINT Digits )
+{
+    SerialField f = SerialField();
+    f.Kind   = SerialNumber;
+    f.X      = X;
+    f.Y      = Y;
+    f.Set    = Set;
+    f.Mode   = Mode;
+    f.Digits = Digits;
+    Fields.push_back( f );
+
+}
+
+void SerialJob::Date( LONG X, LONG Y, UINT Part, UINT Mode )
+{
+    SerialField f = SerialField();
+    f.Kind = SerialDate;
+    f.X    = X;
+    f.Y    = Y;
+    f.Part = Part;
+    f.Mode = Mode;
+    Fields.push_back( f );
+
+}
+
+void SerialJob::Time( LONG X, LONG Y, UINT Part, UINT Mode )
+{
+    SerialField f = SerialField();
+    f.Kind = SerialTime;
+    f.X    = X;
+    f.Y    = Y;
+    f.Part = Part;
+    f.Mode = Mode;
+    Fields.push_back( f );
+
+}
+
+SerialEngine::SerialEngine()
+    : ListStart( 0 ), Length( 0 )
+{
+}
+
+//  LoadTextTable
+//
+//  Description:
+//
+//  Loads the texts Entries as text table entries First, First + 1, ...
+//  mark_date and mark_time mark the entry with the index of the value
+//  instead of its digits with Mode bit #2 set, e.g. month names or
+//  letter codes for the year.
+//
+//      Parameter   Meaning
+//
+//      First       first text table entry
+//      Entries     texts, marked with the current character set
+//
+
+UINT SerialEngine::LoadTextTable( UINT First, const std::vector< std::string >& Entries )
+{
+    if ( First + Entries.size() > 1024 ) return SerialRangeError;
+
+    const UINT Error = get_last_error();
+
+    for ( size_t i = 0; i < Entries.size(); i++ )
+    {
+        load_text_table( First + (UINT) i );
+        mark_text( Entries[ i ].c_str() );
+        list_return();
+
+    }
+
+    return get_last_error() & ~Error ? SerialCardError : SerialNoError;
+
+}
+
+//  Preload
+//
+//  Description:
+//
+//  Loads the part list of Job and prepares the card for external starts:
+//  the serial number sets are initialized, the external start position is
+//  set to the part list and external starts are enabled. A set used by
+//  more than one serial number field is a range error.
+//
+//      Parameter   Meaning
+//
+//      Job         part description
+//      ListNo      list 1 or 2, the card must not be busy on it
+//      Pos         position within the list
+//      MaxParts    number of external starts accepted, 0: no limit
+//
+
+UINT SerialEngine::Preload( const SerialJob& Job, UINT ListNo, UINT Pos, UINT MaxParts )
+{
+    if ( ListNo < 1 || ListNo > 2 || Job.CharSet >= 4 ) return SerialRangeError;
+
+    //  One field per serial number set, see the comment of the header
+    bool Used[ SerialSets ] = { false };
+
+    for ( size_t i = 0; i < Job.Fields.size(); i++ )
+    {
+        const SerialField& f = Job.Fields[ i ];
+
+        if ( f.Kind != SerialNumber ) continue;
+
+        if ( f.Set >= SerialSets || Used[ f.Set ] ) return SerialRangeError;
+
+        Used[ f.Set ] = true;
+
+    }
+
+    //  Disable external starts while the list is replaced
+    set_control_mode( 0 );
+
+    if ( !load_list( ListNo, Pos ) ) return SerialBusy;
+
+    const UINT Error = get_last_error();
+    ListStart = get_input_pointer();
+
+    select_char_set( Job.CharSet );
+
+    UINT Set = SerialSets;      //  not selected yet
+
+    for ( size_t i = 0; i < Job.Fields.size(); i++ )
+    {
+        const SerialField& f = Job.Fields[ i ];
+
+        if ( f.Kind == SerialNumber && f.Set != Set )
+        {
+            select_serial_set_list( f.Set );
+            Set = f.Set;
+
+        }
+
+        jump_abs( f.X, f.Y );
+
+        switch ( f.Kind )
+        {
+        case SerialLiteral: mark_text( f.Text.c_str() );        break;
+        case SerialNumber:  mark_serial( f.Mode, f.Digits );    break;
+        case SerialDate:    mark_date( f.Part, f.Mode );        break;
+        default:            mark_time( f.Part, f.Mode );        break;
+
+        }
+
+    }
+
+    set_end_of_list();
+
+    UINT Dummy, End;
+    get_list_pointer( &Dummy, &End );
+    Length = End >= ListStart ? End - ListStart : 0;   //  0: the part list wrapped around
+
+    if ( get_last_error() & ~Error ) return SerialCardError;
+
+    //  Serial number sets, the card increments them after every mark_serial
+    for ( UINT i = 0; i < SerialSets; i++ )
+    {
+        select_serial_set( i );
+        set_serial_step( Job.First[ i ], Job.Step[ i ] );
+
+    }
+
+    select_serial_set( 0 );
+
+    set_extstartpos( ListStart );
+    set_max_counts( MaxParts );
+    set_control_mode( 1 );      //  external start enabled
+
+    return SerialNoError;
+
+}
+
+//  Start
+//
+//  Description:
+//
+//  Starts one part by software, equivalent to an external start.
+//
+
+void SerialEngine::Start()
+{
+    simulate_ext_start_ctrl();
+
+}
+
+UINT SerialEngine::PartsDone() const
+{
+    return get_counts();
+
+}
+
+double SerialEngine::LastSerial() const
+{
+    return get_serial();
+
+}
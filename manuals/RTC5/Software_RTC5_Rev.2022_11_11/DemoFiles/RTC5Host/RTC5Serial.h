@@ -0,0 +1,93 @@
+//  File
+//      RTC5Serial.h
+//
+//  Abstract
+//      Part serialization with a preloaded list.
+//      A SerialJob describes the marking of one part: literal texts, serial
+//      numbers of up to four serial number sets and date and time fields.
+//      SerialEngine::Preload loads the list of the part once and prepares
+//      the card for external starts. Every /START marks one part and the
+//      card advances the serial numbers by itself, so there is no host
+//      traffic between parts.
+//
+//  Comment
+//      The card advances a set after every mark_serial, so a part holds at
+//      most one serial number field per set. The same number twice on a
+//      part takes two sets with equal first numbers and steps.
+//
+//  Necessary Sources
+//      RTC5Serial.h, RTC5Serial.cpp, RTC5expl.h, RTC5expl.c
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "RTC5expl.h"
+
+//  Error codes of the serialization functions
+const UINT   SerialNoError        =            0;
+const UINT   SerialBusy           =            1;   //  card busy on the requested list
+const UINT   SerialRangeError     =            2;   //  parameter out of range
+const UINT   SerialCardError      =            3;   //  RTC5 error while loading, see get_last_error
+
+const UINT   SerialSets           =            4;   //  serial number sets of the RTC5
+
+enum SerialKind
+{
+    SerialLiteral = 0,          //  mark_text( Text )
+    SerialNumber,               //  mark_serial( Mode, Digits ) of serial number set Set, one per set
+    SerialDate,                 //  mark_date( Part, Mode )
+    SerialTime                  //  mark_time( Part, Mode )
+
+};
+
+struct SerialField
+{
+    UINT        Kind;           //  SerialKind
+    LONG        X, Y;           //  start of the field [bits]
+    std::string Text;           //  SerialLiteral only
+    UINT        Part;           //  SerialDate, SerialTime
+    UINT        Mode;
+    UINT        Digits;         //  SerialNumber only
+    UINT        Set;            //  SerialNumber only
+
+};
+
+struct SerialJob
+{
+    SerialJob();
+
+    void Literal( LONG X, LONG Y, const char* Text );
+    void Number( LONG X, LONG Y, UINT Set, UINT Mode, UINT Digits );
+    void Date( LONG X, LONG Y, UINT Part, UINT Mode );
+    void Time( LONG X, LONG Y, UINT Part, UINT Mode );
+
+    UINT        CharSet;        //  character set loaded by load_char
+    UINT        First[ SerialSets ];    //  first serial number of each set
+    UINT        Step[ SerialSets ];     //  increment of each set
+    std::vector< SerialField > Fields;
+
+};
+
+class SerialEngine
+{
+public:
+    SerialEngine();
+
+    UINT LoadTextTable( UINT First, const std::vector< std::string >& Entries );
+    UINT Preload( const SerialJob& Job, UINT ListNo, UINT Pos, UINT MaxParts = 0 );
+    void Start();                               //  software /START, one host call per part
+
+    UINT   PartsDone() const;                   //  external starts accepted so far
+    double LastSerial() const;                  //  last serial number marked
+    UINT   StartPos() const  { return ListStart; }
+    UINT   ListLength() const { return Length; }
+
+private:
+    UINT ListStart;             //  absolute position of the part list
+    UINT Length;                //  list positions of the part list
+
+};
@@ -0,0 +1,806 @@
+//  File
+//      RTC5Server.cpp
+//
+//  Abstract
+//      A local job server sharing one RTC5 among several processes
+//
+//  Comment
+//      Serve runs an event loop on the listening socket, the connections
+//      and a pipe, a second thread feeds the card. Both share the job table
+//      under Lock; the feeder thread writes to the pipe when a job ended,
+//      so the loop answers the clients waiting for it. Stop only writes to
+//      the pipe, which is safe in a signal handler.
+//      A job failing in the ListFeeder is stopped by stop_execution, so the
+//      next job finds list 1 idle.
+//
+//  Necessary Sources
+//      RTC5Server.h, RTC5Feeder.h, RTC5Feeder.cpp, RTC5Job.h, RTC5Job.cpp,
+//      RTC5List.h, RTC5List.cpp, RTC5expl.h
+//
+//  Environment: Linux
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "RTC5Feeder.h"
+#include "RTC5Server.h"
+
+static const UINT MsgSubmit = 1;
+static const UINT MsgStatus = 2;
+static const UINT MsgWait   = 3;
+static const UINT MsgCancel = 4;
+
+static const int  Sealed    = F_SEAL_SHRINK | F_SEAL_WRITE;   //  required of a payload
+
+//  Request and reply, replies carry no type
+struct Message
+{
+    char     Magic[ 4 ];        //  "RJS1"
+    uint32_t Type;
+    uint64_t Id;
+    int32_t  Priority;
+    uint32_t Error;             //  ServerNoError ...
+    uint32_t State;
+    uint32_t JobError;
+    uint64_t Records;
+    double   QueueTime;
+    double   MarkTime;
+    uint64_t Reserved;
+
+};
+
+static_assert( sizeof( Message ) == 64, "Message is part of the protocol" );
+
+static double Now()
+{
+    return std::chrono::duration< double >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+
+}
+
+static void Clear( Message& m, UINT Type )
+{
+    memset( &m, 0, sizeof( m ) );
+    memcpy( m.Magic, "RJS1", 4 );
+    m.Type = Type;
+
+}
+
+JobServer::JobServer()
+    : ListSize( 4000 ), StartGap( 1000 ), MaxQueued( 256 ), History( 1024 ), Pause( 0 ),
+      Submitted( 0 ), Done( 0 ), Failed( 0 ), Cancelled( 0 ), Refused( 0 ), Records( 0 ), Connections( 0 ),
+      MaxQueue( 0 ), IdleTime( 0.0 ), SwitchTime( 0.0 ),
+      Listen( -1 ), Quit( false ), Queued( 0 ), Stopping( false ), LastId( 0 )
+{
+    Pipe[ 0 ] = Pipe[ 1 ] = -1;
+    Name[ 0 ] = 0;
+
+}
+
+JobServer::~JobServer()
+{
+    Close();
+
+}
+
+//  Open
+//
+//  Description:
+//
+//  Creates the listening socket Path. Clients may connect from now on,
+//  their requests are taken by Serve.
+//
+//      Return      ServerNoError or ServerSystemError
+//
+
+UINT JobServer::Open( const char* Path )
+{
+    Close();
+
+    sockaddr_un Addr;
+    memset( &Addr, 0, sizeof( Addr ) );
+    Addr.sun_family = AF_UNIX;
+
+    if ( strlen( Path ) >= sizeof( Addr.sun_path ) || strlen( Path ) >= sizeof( Name ) )
+    {
+        errno = ENAMETOOLONG;
+        return ServerSystemError;
+
+    }
+
+    strcpy( Addr.sun_path, Path );
+    unlink( Path );
+
+    Listen = socket( AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0 );
+
+    if (   Listen < 0 || bind( Listen, (const sockaddr*) &Addr, sizeof( Addr ) )
+        || listen( Listen, 64 ) || pipe2( Pipe, O_CLOEXEC | O_NONBLOCK )
+       )
+    {
+        const int Error = errno;
+        Close();
+        errno = Error;
+        return ServerSystemError;
+
+    }
+
+    strcpy( Name, Path );
+    return ServerNoError;
+
+}
+
+void JobServer::Close()
+{
+    for ( size_t i = 0; i < Clients.size(); i++ ) close( Clients[ i ] );
+    for ( size_t e = 0; e < Jobs.size(); e++ ) delete Jobs[ e ].Payload;
+
+    if ( Listen >= 0 ) close( Listen );
+    if ( Pipe[ 0 ] >= 0 ) close( Pipe[ 0 ] );
+    if ( Pipe[ 1 ] >= 0 ) close( Pipe[ 1 ] );
+    if ( Name[ 0 ] ) unlink( Name );
+
+    Clients.clear();
+    Waiters.clear();
+    Jobs.clear();
+    Listen    = -1;
+    Pipe[ 0 ] = Pipe[ 1 ] = -1;
+    Name[ 0 ] = 0;
+    Queued    = 0;
+
+}
+
+void JobServer::Stop()
+{
+    Quit = true;
+    Wake( 'q' );
+
+}
+
+//  A full pipe wakes the loop as well
+void JobServer::Wake( char Why )
+{
+    if ( Pipe[ 1 ] >= 0 && write( Pipe[ 1 ], &Why, 1 ) < 0 ) return;
+
+}
+
+//  Serve
+//
+//  Description:
+//
+//  Takes the requests of the clients and feeds the queued jobs into the
+//  card until Stop is called. The job being marked is finished, the jobs
+//  still queued are cancelled, then Serve returns. Connections are closed,
+//  the socket stays open for the next Serve.
+//
+//      Return      ServerNoError or ServerSystemError
+//
+
+UINT JobServer::Serve()
+{
+    if ( Listen < 0 ) return ServerSystemError;
+
+    Submitted = Done = Failed = Cancelled = Refused = Records = Connections = 0;
+    MaxQueue   = 0;
+    IdleTime   = 0.0;
+    SwitchTime = 0.0;
+    Stopping   = false;
+
+    std::thread Feeder( &JobServer::Feed, this );
+    std::vector< pollfd > Fds;
+    std::vector< int > Drop;
+    UINT Error = ServerNoError;
+
+    while ( !Quit )
+    {
+        Fds.clear();
+        Fds.push_back( pollfd() );
+        Fds.back().fd     = Listen;
+        Fds.back().events = POLLIN;
+        Fds.push_back( pollfd() );
+        Fds.back().fd     = Pipe[ 0 ];
+        Fds.back().events = POLLIN;
+
+        for ( size_t c = 0; c < Clients.size(); c++ )
+        {
+            Fds.push_back( pollfd() );
+            Fds.back().fd     = Clients[ c ];
+            Fds.back().events = POLLIN;
+
+        }
+
+        if ( poll( Fds.data(), Fds.size(), -1 ) < 0 )
+        {
+            if ( errno == EINTR ) continue;
+
+            Error = ServerSystemError;
+            break;
+
+        }
+
+        if ( Fds[ 1 ].revents )
+        {
+            char Why[ 64 ];
+
+            while ( read( Pipe[ 0 ], Why, sizeof( Why ) ) > 0 );
+
+        }
+
+        Drop.clear();
+
+        for ( size_t i = 2; i < Fds.size(); i++ )
+        {
+            if ( Fds[ i ].revents && !Request( Fds[ i ].fd ) ) Drop.push_back( Fds[ i ].fd );
+
+        }
+
+        Answer( Drop );
+
+        for ( size_t d = 0; d < Drop.size(); d++ )
+        {
+            std::vector< int >::iterator c = std::find( Clients.begin(), Clients.end(), Drop[ d ] );
+
+            if ( c == Clients.end() ) continue;
+
+            Clients.erase( c );
+            close( Drop[ d ] );
+
+            for ( size_t w = Waiters.size(); w-- > 0; )
+            {
+                if ( Waiters[ w ].Socket == Drop[ d ] ) Waiters.erase( Waiters.begin() + w );
+
+            }
+
+        }
+
+        if ( Fds[ 0 ].revents & POLLIN )
+        {
+            const int Client = accept4( Listen, 0, 0, SOCK_CLOEXEC );
+
+            if ( Client >= 0 )
+            {
+                Clients.push_back( Client );
+                Connections++;
+
+            }
+
+        }
+
+    }
+
+    Quit = false;
+
+    {
+        std::lock_guard< std::mutex > Guard( Lock );
+        Stopping = true;
+
+        for ( int e; ( e = Next() ) >= 0; ) End( e, ServerCancelled );
+
+    }
+
+    Queue.notify_all();
+    Feeder.join();
+
+    Drop.clear();
+    Answer( Drop );
+
+    for ( size_t c = 0; c < Clients.size(); c++ ) close( Clients[ c ] );
+
+    Clients.clear();
+    Waiters.clear();
+
+    return Error;
+
+}
+
+//  The feeder thread: the queued job of the highest priority, the first
+//  submitted of equal priorities
+void JobServer::Feed()
+{
+    std::unique_lock< std::mutex > Guard( Lock );
+    double LastEnd = Now();
+
+    for ( ;; )
+    {
+        const double Idle = Now();
+        bool Waited = false;
+
+        while ( !Stopping && !Queued )
+        {
+            Queue.wait( Guard );
+            Waited = true;
+
+        }
+
+        if ( Stopping ) break;
+
+        const double Start = Now();
+
+        if ( Waited ) IdleTime  += Start - Idle;
+        else          SwitchTime = std::max( SwitchTime, Start - LastEnd );
+
+        Entry& Job = Jobs[ Next() ];
+        Job.Status.State     = ServerMarking;
+        Job.Status.QueueTime = Start - Job.Submitted;
+        Job.Started          = Start;
+        Queued--;
+
+        const uint64_t Id      = Job.Id;
+        const JobFile* Payload = Job.Payload;
+        Guard.unlock();
+
+        ListFeeder Feeder;
+
+        if ( Pause ) Feeder.Pause = Pause;
+
+        UINT Error = Feeder.Open( ListSize, StartGap );
+
+        if ( !Error ) Error = Feeder.Feed( *Payload );
+        if ( !Error ) Error = Feeder.Finish();
+        if ( Error )  stop_execution();
+
+        LastEnd = Now();
+        Guard.lock();
+
+        //  Only ended jobs are removed, the entry is still there
+        const int e = Find( Id );
+        Jobs[ e ].Status.Error    = Error;
+        Jobs[ e ].Status.MarkTime = LastEnd - Start;
+        Records += Feeder.Records;
+        End( e, Error ? ServerFailed : ServerDone );
+        Wake( 'j' );
+
+    }
+
+}
+
+//  Ends job e in State, the oldest ended jobs beyond History are removed.
+//  Lock must be held.
+void JobServer::End( size_t e, UINT State )
+{
+    Entry& Job = Jobs[ e ];
+
+    if ( Job.Status.State == ServerQueued )
+    {
+        Job.Status.QueueTime = Now() - Job.Submitted;
+        Queued--;
+
+    }
+
+    Job.Status.State = State;
+    delete Job.Payload;
+    Job.Payload = 0;
+
+    if ( State == ServerDone )   Done++;
+    if ( State == ServerFailed ) Failed++;
+    if ( State == ServerCancelled ) Cancelled++;
+
+    size_t Ended = 0;
+
+    for ( size_t i = 0; i < Jobs.size(); i++ ) Ended += Jobs[ i ].Status.State >= ServerDone;
+
+    for ( size_t i = 0; i < Jobs.size() && Ended > History; )
+    {
+        if ( Jobs[ i ].Status.State >= ServerDone )
+        {
+            Jobs.erase( Jobs.begin() + i );
+            Ended--;
+
+        }
+        else i++;
+
+    }
+
+}
+
+int JobServer::Find( uint64_t Id ) const
+{
+    for ( size_t e = 0; e < Jobs.size(); e++ )
+    {
+        if ( Jobs[ e ].Id == Id ) return (int) e;
+
+    }
+
+    return -1;
+
+}
+
+int JobServer::Next() const
+{
+    int Best = -1;
+
+    for ( size_t e = 0; e < Jobs.size(); e++ )
+    {
+        if ( Jobs[ e ].Status.State == ServerQueued && ( Best < 0 || Jobs[ e ].Priority > Jobs[ Best ].Priority ) ) Best = (int) e;
+
+    }
+
+    return Best;
+
+}
+
+//  Takes a request of a client and replies, false if the client is to be
+//  dropped
+bool JobServer::Request( int Socket )
+{
+    Message m;
+    char    Control[ CMSG_SPACE( sizeof( int ) ) ];
+    iovec   Io = { &m, sizeof( m ) };
+    msghdr  Header;
+    memset( &Header, 0, sizeof( Header ) );
+    Header.msg_iov        = &Io;
+    Header.msg_iovlen     = 1;
+    Header.msg_control    = Control;
+    Header.msg_controllen = sizeof( Control );
+
+    const ssize_t n = recvmsg( Socket, &Header, MSG_DONTWAIT | MSG_CMSG_CLOEXEC );
+    int Payload = -1;
+
+    for ( cmsghdr* c = n > 0 ? CMSG_FIRSTHDR( &Header ) : 0; c; c = CMSG_NXTHDR( &Header, c ) )
+    {
+        if ( c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS && c->cmsg_len == CMSG_LEN( sizeof( int ) ) )
+        {
+            memcpy( &Payload, CMSG_DATA( c ), sizeof( int ) );
+
+        }
+
+    }
+
+    if ( n < 0 && ( errno == EAGAIN || errno == EINTR ) ) return true;
+
+    if (   n != (ssize_t) sizeof( m ) || memcmp( m.Magic, "RJS1", 4 ) || Header.msg_flags & ( MSG_TRUNC | MSG_CTRUNC )
+        || ( Payload >= 0 && m.Type != MsgSubmit )
+       )
+    {
+        if ( Payload >= 0 ) close( Payload );
+
+        return false;
+
+    }
+
+    JobStatus Status;
+    UINT      Error = ServerNoError;
+
+    if ( m.Type == MsgSubmit )
+    {
+        const int Seals = Payload >= 0 ? fcntl( Payload, F_GET_SEALS ) : -1;
+        JobFile*  File  = new JobFile;
+
+        if ( Seals < 0 || ( Seals & Sealed ) != Sealed )
+        {
+            if ( Payload >= 0 ) close( Payload );
+
+            Error = ServerFormatError;
+
+        }
+        else if ( File->Attach( Payload ) ) Error = ServerFormatError;
+
+        std::unique_lock< std::mutex > Guard( Lock );
+
+        if ( !Error && Queued >= MaxQueued ) Error = ServerBusy;
+
+        if ( Error )
+        {
+            Refused++;
+            Guard.unlock();
+            delete File;
+            return Reply( Socket, 0, Error, 0 );
+
+        }
+
+        Entry Job;
+        Job.Id                = ++LastId;
+        Job.Priority          = m.Priority;
+        Job.Payload           = File;
+        Job.Status.State      = ServerQueued;
+        Job.Status.Error      = 0;
+        Job.Status.Records    = File->Count();
+        Job.Status.QueueTime  = 0.0;
+        Job.Status.MarkTime   = 0.0;
+        Job.Submitted         = Now();
+        Job.Started           = 0.0;
+        Jobs.push_back( Job );
+        Status = Job.Status;
+        Queued++;
+        Submitted++;
+        MaxQueue = std::max( MaxQueue, Queued );
+        Guard.unlock();
+
+        Queue.notify_one();
+        return Reply( Socket, Job.Id, ServerNoError, &Status );
+
+    }
+
+    if ( m.Type != MsgStatus && m.Type != MsgWait && m.Type != MsgCancel ) return false;
+
+    {
+        std::lock_guard< std::mutex > Guard( Lock );
+        const int e = Find( m.Id );
+
+        if ( e < 0 ) Error = ServerUnknown;
+        else
+        {
+            if ( m.Type == MsgCancel )
+            {
+                if ( Jobs[ e ].Status.State == ServerQueued ) End( e, ServerCancelled );
+                else                                         Error = ServerStateError;
+
+            }
+
+            //  End may have removed ended jobs, with History 0 this one
+            const int j = Find( m.Id );
+
+            if ( j < 0 ) return Reply( Socket, m.Id, ServerNoError, 0 );
+
+            const Entry& Job = Jobs[ j ];
+            Status = Job.Status;
+
+            if ( Status.State == ServerQueued )  Status.QueueTime = Now() - Job.Submitted;
+            if ( Status.State == ServerMarking ) Status.MarkTime  = Now() - Job.Started;
+
+            if ( m.Type == MsgWait && Status.State < ServerDone )
+            {
+                Waiter w = { Socket, m.Id };
+                Waiters.push_back( w );
+                return true;
+
+            }
+
+        }
+
+    }
+
+    return Reply( Socket, m.Id, Error, Error == ServerUnknown ? 0 : &Status );
+
+}
+
+bool JobServer::Reply( int Socket, uint64_t Id, UINT Error, const JobStatus* Status )
+{
+    Message m;
+    Clear( m, 0 );
+    m.Id    = Id;
+    m.Error = Error;
+
+    if ( Status )
+    {
+        m.State     = Status->State;
+        m.JobError  = Status->Error;
+        m.Records   = Status->Records;
+        m.QueueTime = Status->QueueTime;
+        m.MarkTime  = Status->MarkTime;
+
+    }
+
+    return send( Socket, &m, sizeof( m ), MSG_NOSIGNAL | MSG_DONTWAIT ) == (ssize_t) sizeof( m );
+
+}
+
+//  Replies to the clients waiting for jobs that have ended
+void JobServer::Answer( std::vector< int >& Drop )
+{
+    for ( size_t w = 0; w < Waiters.size(); )
+    {
+        JobStatus Status;
+        UINT      Error = ServerNoError;
+
+        {
+            std::lock_guard< std::mutex > Guard( Lock );
+            const int e = Find( Waiters[ w ].Id );
+
+            if ( e >= 0 && Jobs[ e ].Status.State < ServerDone )
+            {
+                w++;
+                continue;
+
+            }
+
+            if ( e < 0 ) Error  = ServerUnknown;
+            else         Status = Jobs[ e ].Status;
+
+        }
+
+        if ( !Reply( Waiters[ w ].Socket, Waiters[ w ].Id, Error, Error ? 0 : &Status ) ) Drop.push_back( Waiters[ w ].Socket );
+
+        Waiters.erase( Waiters.begin() + w );
+
+    }
+
+}
+
+JobClient::JobClient()
+    : Socket( -1 )
+{
+}
+
+JobClient::~JobClient()
+{
+    Close();
+
+}
+
+//  Connect
+//
+//  Description:
+//
+//  Connects to the server listening on Path.
+//
+//      Return      ServerNoError or ServerSystemError, e.g. no server
+//
+
+UINT JobClient::Connect( const char* Path )
+{
+    Close();
+
+    sockaddr_un Addr;
+    memset( &Addr, 0, sizeof( Addr ) );
+    Addr.sun_family = AF_UNIX;
+
+    if ( strlen( Path ) >= sizeof( Addr.sun_path ) )
+    {
+        errno = ENAMETOOLONG;
+        return ServerSystemError;
+
+    }
+
+    strcpy( Addr.sun_path, Path );
+    Socket = socket( AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0 );
+
+    if ( Socket < 0 || connect( Socket, (const sockaddr*) &Addr, sizeof( Addr ) ) )
+    {
+        const int Error = errno;
+        Close();
+        errno = Error;
+        return ServerSystemError;
+
+    }
+
+    return ServerNoError;
+
+}
+
+void JobClient::Close()
+{
+    if ( Socket >= 0 ) close( Socket );
+
+    Socket = -1;
+
+}
+
+//  Submit
+//
+//  Description:
+//
+//  Submits a job: the parameters of Params, the records Cmd. The job file
+//  is written into a sealed memfd, the server maps it from there.
+//
+//      Parameter   Meaning
+//
+//      Priority    higher priorities are marked first
+//      Id          of the job for Status, Wait and Cancel
+//
+//      Return      ServerNoError, ServerSystemError, ServerFormatError,
+//                  ServerBusy or ServerClosed
+//
+
+UINT JobClient::Submit( const JobFileHeader& Params, const ListCommand* Cmd, size_t Count, int Priority, uint64_t* Id )
+{
+    const size_t Size    = JobImage( Params, Cmd, Count, 0 );
+    const int    Payload = memfd_create( "RTC5Job", MFD_CLOEXEC | MFD_ALLOW_SEALING );
+
+    if ( Payload < 0 ) return ServerSystemError;
+
+    void* Image = ftruncate( Payload, (off_t) Size ) ? MAP_FAILED : mmap( 0, Size, PROT_READ | PROT_WRITE, MAP_SHARED, Payload, 0 );
+
+    if ( Image == MAP_FAILED )
+    {
+        close( Payload );
+        return ServerSystemError;
+
+    }
+
+    JobImage( Params, Cmd, Count, Image );
+    munmap( Image, Size );
+
+    if ( fcntl( Payload, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL ) )
+    {
+        close( Payload );
+        return ServerSystemError;
+
+    }
+
+    const UINT Error = Request( MsgSubmit, 0, Priority, Payload, Id, 0 );
+    close( Payload );
+    return Error;
+
+}
+
+UINT JobClient::Submit( const JobFile& Job, int Priority, uint64_t* Id )
+{
+    return Submit( Job.Header(), Job.Records(), Job.Count(), Priority, Id );
+
+}
+
+UINT JobClient::Status( uint64_t Id, JobStatus* Status )
+{
+    return Request( MsgStatus, Id, 0, -1, 0, Status );
+
+}
+
+//  Blocks until the job has ended
+UINT JobClient::Wait( uint64_t Id, JobStatus* Status )
+{
+    return Request( MsgWait, Id, 0, -1, 0, Status );
+
+}
+
+UINT JobClient::Cancel( uint64_t Id )
+{
+    return Request( MsgCancel, Id, 0, -1, 0, 0 );
+
+}
+
+UINT JobClient::Request( UINT Type, uint64_t Id, int Priority, int Payload, uint64_t* Reply, JobStatus* Status )
+{
+    if ( Socket < 0 ) return ServerClosed;
+
+    Message m;
+    Clear( m, Type );
+    m.Id       = Id;
+    m.Priority = Priority;
+
+    char    Control[ CMSG_SPACE( sizeof( int ) ) ];
+    iovec   Io = { &m, sizeof( m ) };
+    msghdr  Header;
+    memset( &Header, 0, sizeof( Header ) );
+    memset( Control, 0, sizeof( Control ) );
+    Header.msg_iov    = &Io;
+    Header.msg_iovlen = 1;
+
+    if ( Payload >= 0 )
+    {
+        Header.msg_control    = Control;
+        Header.msg_controllen = sizeof( Control );
+
+        cmsghdr* c    = CMSG_FIRSTHDR( &Header );
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type  = SCM_RIGHTS;
+        c->cmsg_len   = CMSG_LEN( sizeof( int ) );
+        memcpy( CMSG_DATA( c ), &Payload, sizeof( int ) );
+
+    }
+
+    ssize_t n;
+
+    do n = sendmsg( Socket, &Header, MSG_NOSIGNAL );
+    while ( n < 0 && errno == EINTR );
+
+    if ( n != (ssize_t) sizeof( m ) ) return ServerClosed;
+
+    do n = recv( Socket, &m, sizeof( m ), 0 );
+    while ( n < 0 && errno == EINTR );
+
+    if ( n != (ssize_t) sizeof( m ) || memcmp( m.Magic, "RJS1", 4 ) ) return ServerClosed;
+
+    if ( Reply ) *Reply = m.Id;
+
+    if ( Status )
+    {
+        Status->State     = m.State;
+        Status->Error     = m.JobError;
+        Status->Records   = m.Records;
+        Status->QueueTime = m.QueueTime;
+        Status->MarkTime  = m.MarkTime;
+
+    }
+
+    return m.Error;
+
+}
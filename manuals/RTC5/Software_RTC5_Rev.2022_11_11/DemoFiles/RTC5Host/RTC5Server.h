@@ -0,0 +1,178 @@
+//  File
+//      RTC5Server.h
+//
+//  Abstract
+//      A local job server sharing one RTC5 among several processes.
+//      Only one process can own a card (acquire_rtc), so every program
+//      marking on it used to initialize the card itself and had to end
+//      before the next one started. A JobServer owns the card instead: it
+//      is initialized once, client processes connect by a Unix domain
+//      socket and submit jobs, the server queues them by priority and
+//      streams them one after the other by the ListFeeder.
+//      A job travels as a job file (see RTC5Job.h) in shared memory: the
+//      JobClient writes it into a sealed memfd and passes the descriptor
+//      with the request, the server maps it read only. The records are
+//      neither copied through the socket nor parsed.
+//
+//  Comment
+//      Requests and replies are messages of fixed size on a SOCK_SEQPACKET
+//      socket, a client has one request outstanding at a time:
+//          Submit  job file descriptor and priority: job id
+//          Status  job id: state, error, records fed, times
+//          Wait    job id: the status as soon as the job has ended
+//          Cancel  job id of a queued job
+//      Higher priorities are marked first, jobs of equal priority in the
+//      order of submission. A job being marked is not interrupted. Every
+//      job sets the parameters of its header, the card is not initialized
+//      between jobs. Queued jobs outlive the connection of their client,
+//      ended jobs are kept for Status and Wait up to History of them.
+//      The payload must be sealed against shrinking and writing, so a
+//      client can neither change nor truncate a job the server maps.
+//      Access is controlled by the file permissions of the socket.
+//      One server drives the card selected by select_rtc, several cards
+//      are shared by one server process per card.
+//
+//  Necessary Sources
+//      RTC5Server.h, RTC5Server.cpp, RTC5Feeder.h, RTC5Feeder.cpp,
+//      RTC5Job.h, RTC5Job.cpp, RTC5List.h, RTC5List.cpp, RTC5expl.h
+//
+//  Environment: Linux
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "RTC5Job.h"
+
+//  Error codes of the server and the client
+const UINT   ServerNoError        =            0;
+const UINT   ServerSystemError    =            1;   //  socket, shared memory or thread, see errno
+const UINT   ServerFormatError    =            2;   //  payload no sealed job file, bad request
+const UINT   ServerBusy           =            3;   //  MaxQueued jobs queued
+const UINT   ServerUnknown        =            4;   //  no such job or no longer kept
+const UINT   ServerStateError     =            5;   //  job not queued, cannot be cancelled
+const UINT   ServerClosed         =            6;   //  connection lost, server stopped
+
+//  States of a job
+const UINT   ServerQueued         =            0;
+const UINT   ServerMarking        =            1;
+const UINT   ServerDone           =            2;
+const UINT   ServerFailed         =            3;   //  ListFeeder error, see JobStatus::Error
+const UINT   ServerCancelled      =            4;   //  by Cancel or when the server stopped
+
+struct JobStatus
+{
+    UINT     State;
+    UINT     Error;                                 //  of the ListFeeder if failed
+    uint64_t Records;                               //  of the job
+    double   QueueTime;                             //  [s] from submission until marking or cancelled
+    double   MarkTime;                              //  [s] wall clock of the ListFeeder
+
+};
+
+class JobServer
+{
+public:
+    JobServer();
+    ~JobServer();
+
+    UINT     Open( const char* Path );              //  socket, an existing file of this name is replaced
+    UINT     Serve();                               //  until Stop, the card must be initialized
+    void     Stop();                                //  from any thread or a signal handler
+    void     Close();
+
+    //  Settings, read by Serve
+    UINT     ListSize;                              //  of list 1 as configured by config_list
+    UINT     StartGap;                              //  of the ListFeeder
+    UINT     MaxQueued;                             //  further submissions are refused with ServerBusy
+    UINT     History;                               //  ended jobs kept for Status and Wait
+    void   ( *Pause )( double Seconds );            //  of the ListFeeder, NULL: its default
+
+    //  Results, valid after Serve returned
+    uint64_t Submitted;
+    uint64_t Done;
+    uint64_t Failed;
+    uint64_t Cancelled;
+    uint64_t Refused;                               //  by ServerBusy or ServerFormatError
+    uint64_t Records;                               //  fed
+    uint64_t Connections;
+    UINT     MaxQueue;                              //  most jobs queued at once
+    double   IdleTime;                              //  [s] wall clock of the feeder without a job
+    double   SwitchTime;                            //  [s] longest from the end of a job to the next start, queue not empty
+
+private:
+    JobServer( const JobServer& );
+    JobServer& operator=( const JobServer& );
+
+    struct Entry
+    {
+        uint64_t Id;
+        int      Priority;
+        JobFile* Payload;                           //  until the job has ended
+        JobStatus Status;
+        double   Submitted;                         //  [s] wall clock
+        double   Started;
+
+    };
+
+    struct Waiter
+    {
+        int      Socket;
+        uint64_t Id;
+
+    };
+
+    void     Feed();
+    bool     Request( int Socket );
+    bool     Reply( int Socket, uint64_t Id, UINT Error, const JobStatus* Status );
+    void     Answer( std::vector< int >& Drop );
+    void     End( size_t e, UINT State );
+    int      Find( uint64_t Id ) const;
+    int      Next() const;
+    void     Wake( char Why );
+
+    int      Listen;
+    int      Pipe[ 2 ];                             //  wakes the event loop
+    std::atomic< bool > Quit;                       //  set by Stop
+    char     Name[ 108 ];
+
+    std::mutex Lock;                                //  Jobs, Queued, Stopping
+    std::condition_variable Queue;
+    std::vector< Entry > Jobs;                      //  queued, marking and kept
+    UINT     Queued;
+    bool     Stopping;
+    uint64_t LastId;
+    std::vector< Waiter > Waiters;                  //  event loop only
+    std::vector< int > Clients;
+
+};
+
+class JobClient
+{
+public:
+    JobClient();
+    ~JobClient();
+
+    UINT     Connect( const char* Path );
+    void     Close();
+
+    UINT     Submit( const JobFileHeader& Params, const ListCommand* Cmd, size_t Count, int Priority, uint64_t* Id );
+    UINT     Submit( const JobFile& Job, int Priority, uint64_t* Id );
+    UINT     Status( uint64_t Id, JobStatus* Status );
+    UINT     Wait( uint64_t Id, JobStatus* Status );
+    UINT     Cancel( uint64_t Id );
+
+private:
+    JobClient( const JobClient& );
+    JobClient& operator=( const JobClient& );
+
+    UINT     Request( UINT Type, uint64_t Id, int Priority, int Payload, uint64_t* Reply, JobStatus* Status );
+
+    int      Socket;
+
+};
@@ -0,0 +1,436 @@
+//  File
+//      RTC5Sky.cpp
+//
+//  Abstract
+//      Planning of sky writing per polyline
+//
+//  Comment
+//      The job is walked one record at a time by a TimeEstimator with sky
+//      writing off, its model gives the corners in output coordinates with
+//      the cosines the card compares with the limit. The times of a
+//      polyline separate into its start, its end and its corners, so a
+//      polyline is planned by sorting its corners by cosine: mode 3 with
+//      the j sharpest corners skied costs the run-in and run-out of j
+//      corners plus the delays of the others. The cheapest candidate whose
+//      remaining corners stay within MaxError wins, ties go to less sky
+//      writing. A polyline ended by a subroutine or text ends without sky
+//      writing, the mode is set to 0 before these.
+//
+//  Necessary Sources
+//      RTC5Sky.h, RTC5Timing.h, RTC5List.h, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "RTC5Sky.h"
+#include "RTC5Timing.h"
+#include "RTC5Util.h"
+
+static const double Equal                =        1e-12;   //  [s] costs taken as equal
+static const UINT   AngleBins            =            6;   //  of 30 deg in Print
+
+static bool IsSky( UINT Op )
+{
+    return Op == OpSetSkyWritingPara || Op == OpSetSkyWritingMode || Op == OpSetSkyWritingLimit;
+
+}
+
+static bool IsPiece( UINT Op )
+{
+    return Op == OpMarkAbs || Op == OpMarkRel || Op == OpArcAbs || Op == OpArcRel;
+
+}
+
+//  Commands marking polylines of their own
+static bool IsForeign( UINT Op )
+{
+    switch ( Op )
+    {
+    case OpSubCall:
+    case OpSubCallAbs:
+    case OpListCall:
+    case OpListCallAbs:
+    case OpListJumpPos:
+    case OpMarkText:
+    case OpMarkTextAbs:
+    case OpMarkChar:
+    case OpMarkCharAbs:
+    case OpMarkSerial:
+    case OpMarkSerialAbs:
+    case OpMarkDate:
+    case OpMarkDateAbs:
+    case OpMarkTime:
+    case OpMarkTimeAbs:
+        return true;
+
+    default:
+        return false;
+
+    }
+
+}
+
+//  Commands ending a polyline in the TimeEstimator
+static bool Closes( UINT Op )
+{
+    switch ( Op )
+    {
+    case OpJumpAbs:
+    case OpJumpRel:
+    case OpSetPixel:
+    case OpSetNPixel:
+    case OpLongDelay:
+    case OpStepperAbs:
+    case OpStepperWait:
+    case OpFlyReturn:
+    case OpWaitForEncoder:
+    case OpListReturn:
+    case OpEndOfList:
+    case OpSetWait:
+    case OpSaveAndRestartTimer:
+        return true;
+
+    default:
+        return IsForeign( Op );
+
+    }
+
+}
+
+static double Clamp( double Cos )
+{
+    return Cos < -1.0 ? -1.0 : Cos > 1.0 ? 1.0 : Cos;
+
+}
+
+SkyPlanner::SkyPlanner()
+    : TimeLag( 127.0 ), LaserOnShift( 0 ), Prev( 0 ), Post( 0 ), MaxError( 10.0 ), Skied( 0 ), OverError( 0 ),
+      Switches( 0 ), Before( 0.0 ), After( 0.0 ), Predicted( 0.0 )
+{
+}
+
+void SkyPlanner::SetSub( UINT Index, const ListCommand* Cmd, size_t Count )
+{
+    if ( Index >= Subs.size() )
+    {
+        const Table None = { 0, 0 };
+        Subs.resize( Index + 1, None );
+
+    }
+
+    Subs[ Index ].Cmd   = Cmd;
+    Subs[ Index ].Count = Count;
+
+}
+
+//  Choose
+//
+//  Description:
+//
+//  Chooses the mode of the polyline p, its corners are at the end of
+//  Corners.
+//
+//      Parameter   Meaning
+//
+//      Start, End  [s] delays at the start and the end without sky writing
+//      SkyStart    [s] run-in at the start
+//      SkyEnd      [s] run-out at the end
+//      SkyTurn     [s] run-out and run-in at a corner
+//
+
+void SkyPlanner::Choose( SkyPolyline& p, double Start, double End, double SkyStart, double SkyEnd, double SkyTurn )
+{
+    const size_t n = p.Corners;
+    SkyCorner* c = Corners.data() + p.FirstCorner;
+
+    //  Sharpest first, Rest[ j ] and Worst[ j ] of the corners from j on
+    std::vector< size_t > Order( n );
+    for ( size_t k = 0; k < n; k++ ) Order[ k ] = k;
+    std::sort( Order.begin(), Order.end(), [ c ]( size_t a, size_t b ) { return c[ a ].Cos < c[ b ].Cos; } );
+
+    std::vector< double > Rest( n + 1, 0.0 ), Worst( n + 1, 0.0 );
+
+    for ( size_t k = n; k-- > 0; )
+    {
+        Rest[ k ]  = Rest[ k + 1 ] + c[ Order[ k ] ].PolyTime;
+        Worst[ k ] = std::max( Worst[ k + 1 ], c[ Order[ k ] ].PolyError );
+        if ( c[ Order[ k ] ].PolyError > MaxError ) OverError++;
+
+    }
+
+    const double Base = Start + Rest[ 0 ] + End;
+    double Best = Worst[ 0 ] <= MaxError ? Base : 1e300;
+    size_t Sky  = 0;
+    bool   Off  = Worst[ 0 ] <= MaxError;
+
+    for ( size_t j = 0; j <= n; j++ )
+    {
+        //  A limit separates the j sharpest from the others
+        if ( j && j < n && !( c[ Order[ j - 1 ] ].Cos < c[ Order[ j ] ].Cos ) ) continue;
+        if ( Worst[ j ] > MaxError ) continue;
+
+        const double t = SkyStart + SkyEnd + j * SkyTurn + Rest[ j ];
+
+        if ( t < Best - Equal )
+        {
+            Best = t;
+            Sky  = j;
+            Off  = false;
+
+        }
+
+    }
+
+    p.Mode  = Off ? 0 : !Sky ? 2 : Sky == n ? 1 : 3;
+    p.Limit = p.Mode == 3 ? 0.5 * ( c[ Order[ Sky - 1 ] ].Cos + c[ Order[ Sky ] ].Cos ) : 0.0;
+    p.Saved = Base - Best;
+
+    for ( size_t k = 0; k < n; k++ ) c[ Order[ k ] ].Sky = !Off && k < Sky;
+
+    Skied     += Off ? 0 : Sky;
+    Predicted -= p.Saved;
+
+}
+
+//  Plan
+//
+//  Description:
+//
+//  Plans the sky writing of a job.
+//
+//      Parameter   Meaning
+//
+//      Cmd         list commands
+//      Count       number of records incl. OpTextData records
+//      Out         receives the job with the sky writing commands
+//
+//      Return      Meaning
+//
+//      SkyNoError      Out, Corners, Polylines and the times are valid
+//      SkyRangeError   no job, neither Prev, Post nor TimeLag set
+//
+
+UINT SkyPlanner::Plan( const ListCommand* Cmd, size_t Count, ListJob& Out )
+{
+    Corners.clear();
+    Polylines.clear();
+    Skied = OverError = Switches = 0;
+    Before = After = Predicted = 0.0;
+    Out.clear();
+
+    const UINT Lag = (UINT) ceil( TimeLag * 1e-6 / Tick - 1e-9 );
+    const UINT Pre = Prev ? Prev : Lag;
+    const UINT Pst = Post ? Post : Lag;
+
+    if ( !Cmd || !Count || !Pre || !Pst ) return SkyRangeError;
+
+    const double Tau = TimeLag * 1e-6;
+
+    TimeEstimator Walk;
+    for ( UINT s = 0; s < Subs.size(); s++ ) if ( Subs[ s ].Cmd ) Walk.SetSub( s, Subs[ s ].Cmd, Subs[ s ].Count );
+
+    const TimingModel& m = Walk.Model;
+
+    SkyPolyline p;
+    bool   Open = false;
+    double DirX = 1.0, DirY = 0.0, InSpeed = 0.0, InLength = 0.0;
+    double Start = 0.0, End = 0.0;
+
+    for ( size_t i = 0; i < Count; i++ )
+    {
+        const ListCommand& c = Cmd[ i ];
+
+        if ( IsSky( c.Op ) ) continue;
+
+        if ( Open && Closes( c.Op ) )
+        {
+            p.End = i;
+            Choose( p, Start, End, Pre * Tick + Start, IsForeign( c.Op ) ? End : Pst * Tick, ( Pre + Pst ) * Tick );
+            Polylines.push_back( p );
+            Open = false;
+
+        }
+
+        Walk.Estimate( &c, 1, 0, false );
+
+        if ( !IsPiece( c.Op ) ) continue;
+
+        //  Directions at the start and the end as TimingModel::Mark and Arc
+        const TimingMotion& l = m.Last;
+        double dX, dY, eX, eY, Length;
+
+        if ( c.Op == OpMarkAbs || c.Op == OpMarkRel )
+        {
+            const double vX = m.X - l.X0, vY = m.Y - l.Y0;
+            Length = sqrt( vX * vX + vY * vY );
+            dX = eX = Length > 0.0 ? vX / Length : DirX;
+            dY = eY = Length > 0.0 ? vY / Length : DirY;
+
+        }
+        else
+        {
+            const double vX = l.X0 - l.CenterX, vY = l.Y0 - l.CenterY;
+            const double r  = sqrt( vX * vX + vY * vY );
+            const double a  = l.Angle * Pi / 180.0;
+            const double s  = l.Angle < 0.0 ? -1.0 : 1.0;
+            const double wX = vX * cos( a ) + vY * sin( a );
+            const double wY = vY * cos( a ) - vX * sin( a );
+
+            Length = r * fabs( a );
+            dX = r > 0.0 ?  s * vY / r : DirX;
+            dY = r > 0.0 ? -s * vX / r : DirY;
+            eX = r > 0.0 ?  s * wY / r : DirX;
+            eY = r > 0.0 ? -s * wX / r : DirY;
+
+        }
+
+        if ( !Open )
+        {
+            Open          = true;
+            p.Begin       = i;
+            p.FirstCorner = Corners.size();
+            p.Corners     = 0;
+            Start         = m.LaserOnDelay < 0 ? -m.LaserOnDelay * LaserDelayUnit : 0.0;
+
+        }
+        else
+        {
+            SkyCorner k;
+            k.Record = i;
+            k.Cos    = DirX * dX + DirY * dY;
+            k.Speed  = InSpeed;
+            k.Sky    = false;
+
+            if ( m.EdgeLevel && InLength > m.EdgeLevel ) k.PolyTime = m.MarkDelay * Tick;
+            else k.PolyTime = m.PolygonDelay * Tick * m.PolygonScale( k.Cos );
+
+            k.PolyError = Tau > 0.0 ? InSpeed * 1e3 * Tau * exp( -k.PolyTime / Tau ) * sqrt( 0.5 * ( 1.0 - Clamp( k.Cos ) ) )
+                                    : 0.0;
+
+            Corners.push_back( k );
+            p.Corners++;
+
+        }
+
+        DirX     = eX;
+        DirY     = eY;
+        InSpeed  = m.MarkSpeed;
+        InLength = Length;
+        End      = std::max( m.MarkDelay * Tick, m.LaserOffDelay * LaserDelayUnit );
+
+    }
+
+    if ( Open )
+    {
+        p.End = Count;
+        Choose( p, Start, End, Pre * Tick + Start, Pst * Tick, ( Pre + Pst ) * Tick );
+        Polylines.push_back( p );
+
+    }
+
+    //  The job with the switches, the mode set only where it changes
+    ListCommand Para = ListMake( OpSetSkyWritingPara, LaserOnShift, Pre, Pst );
+    Para.D[ 0 ] = TimeLag;
+    Out.reserve( Count + 2 * Polylines.size() + 1 );
+    Out.push_back( Para );
+    Switches = 1;
+
+    UINT   Mode  = 0;
+    double Limit = 0.0;
+    bool   Known = false;
+    size_t Next  = 0;
+
+    for ( size_t i = 0; i < Count; i++ )
+    {
+        const ListCommand& c = Cmd[ i ];
+
+        if ( IsSky( c.Op ) ) continue;
+
+        if ( Next < Polylines.size() && i == Polylines[ Next ].Begin )
+        {
+            const SkyPolyline& q = Polylines[ Next++ ];
+
+            if ( q.Mode == 3 && ( !Known || Limit != q.Limit ) )
+            {
+                Out.push_back( ListMakeD( OpSetSkyWritingLimit, q.Limit ) );
+                Limit = q.Limit;
+                Known = true;
+                Switches++;
+
+            }
+
+            if ( q.Mode != Mode )
+            {
+                Out.push_back( ListMake( OpSetSkyWritingMode, q.Mode ) );
+                Mode = q.Mode;
+                Switches++;
+
+            }
+
+        }
+        else if ( Mode && IsForeign( c.Op ) )
+        {
+            Out.push_back( ListMake( OpSetSkyWritingMode, 0 ) );
+            Mode = 0;
+            Switches++;
+
+        }
+
+        Out.push_back( c );
+
+    }
+
+    TimeEstimator Estimator;
+    for ( UINT s = 0; s < Subs.size(); s++ ) if ( Subs[ s ].Cmd ) Estimator.SetSub( s, Subs[ s ].Cmd, Subs[ s ].Count );
+
+    Before = Estimator.Estimate( Cmd, Count );
+    Estimator.Reset();
+    After = Estimator.Estimate( Out.data(), Out.size() );
+
+    return SkyNoError;
+
+}
+
+void SkyPlanner::Print( FILE* Out ) const
+{
+    UINT Modes[ 4 ] = { 0, 0, 0, 0 };
+
+    for ( size_t i = 0; i < Polylines.size(); i++ ) Modes[ Polylines[ i ].Mode & 3 ]++;
+
+    fprintf( Out, "%u polylines: %u without sky writing, %u mode 2, %u mode 3, %u mode 1\n", (UINT) Polylines.size(),
+             Modes[ 0 ], Modes[ 2 ], Modes[ 3 ], Modes[ 1 ] );
+    fprintf( Out, "%u corners, %llu skied, %llu beyond %.1f bits with the polygon delay, %llu commands written\n\n",
+             (UINT) Corners.size(), (unsigned long long) Skied, (unsigned long long) OverError, MaxError,
+             (unsigned long long) Switches );
+
+    UINT   Count[ AngleBins ] = { 0 }, Sky[ AngleBins ] = { 0 }, Over[ AngleBins ] = { 0 };
+    double Error[ AngleBins ] = { 0.0 };
+
+    for ( size_t i = 0; i < Corners.size(); i++ )
+    {
+        const SkyCorner& k = Corners[ i ];
+        const UINT b = std::min( (UINT) ( acos( Clamp( k.Cos ) ) * AngleBins / Pi ), AngleBins - 1 );
+
+        Count[ b ]++;
+        if ( k.Sky ) Sky[ b ]++;
+        if ( k.PolyError > MaxError ) Over[ b ]++;
+        Error[ b ] = std::max( Error[ b ], k.PolyError );
+
+    }
+
+    fprintf( Out, " turn [deg]   corners    skied   beyond   polygon delay error [bits]\n" );
+
+    for ( UINT b = 0; b < AngleBins; b++ )
+    {
+        fprintf( Out, "  %3u..%3u  %8u %8u %8u   %8.1f\n", b * 180 / AngleBins, ( b + 1 ) * 180 / AngleBins, Count[ b ],
+                 Sky[ b ], Over[ b ], Error[ b ] );
+
+    }
+
+    fprintf( Out, "\ncycle time %.3f ms, planned %.3f ms (%+.3f ms, %+.3f ms by the plan)\n", Before * 1e3, After * 1e3,
+             ( After - Before ) * 1e3, Predicted * 1e3 );
+
+}
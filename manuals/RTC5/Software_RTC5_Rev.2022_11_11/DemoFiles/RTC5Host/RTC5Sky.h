@@ -0,0 +1,112 @@
+//  File
+//      RTC5Sky.h
+//
+//  Abstract
+//      Planning of sky writing per polyline.
+//      Sky writing lets the head run in and out of a corner with the laser
+//      off instead of waiting for it with the polygon delay. It marks the
+//      corner sharp but costs Nprev + Npost periods, the polygon delay
+//      costs less at shallow corners but leaves the corner rounded by the
+//      lag of the head. A SkyPlanner looks at every corner of a job, its
+//      angle and the mark speed into it, and chooses per polyline the
+//      sky writing mode and limit of the shortest time that keeps every
+//      corner within MaxError. It writes the job with the mode switches
+//      and tells the cycle time before and after by the TimeEstimator.
+//
+//  Comment
+//      A corner marked with a polygon delay P is rounded by about
+//          v TimeLag exp( -P / TimeLag ) sin( angle / 2 )
+//      v the mark speed into the corner, angle the change of direction:
+//      the head lags v TimeLag behind the command, the lag decays during
+//      the delay and is cut by the new direction. Corners of sky writing
+//      are taken as sharp.
+//      The candidates of a polyline are no sky writing, mode 2 (start and
+//      end only), mode 3 with a limit between any two corner cosines and
+//      mode 1 (every corner). Times are those of the TimingModel.
+//      The planner owns sky writing: sky writing commands of the job are
+//      dropped, set_sky_writing_para_list is written first and the mode is
+//      set to 0 again before subroutines, texts and list calls, whose
+//      polylines are not planned.
+//
+//  Necessary Sources
+//      RTC5Sky.h, RTC5Sky.cpp, RTC5Timing.h, RTC5Timing.cpp, RTC5List.h,
+//      RTC5List.cpp, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+#include "RTC5List.h"
+
+//  Error codes of the planner
+const UINT   SkyNoError           =            0;
+const UINT   SkyRangeError        =            1;   //  no job, no run-in or run-out
+
+struct SkyCorner
+{
+    size_t   Record;            //  of the mark or arc leaving the corner
+    double   Cos;               //  of the change of direction, 1: straight on
+    double   Speed;             //  [bits/ms] into the corner
+    double   PolyTime;          //  [s] polygon or mark delay
+    double   PolyError;         //  [bits] rounding with it
+    bool     Sky;
+
+};
+
+struct SkyPolyline
+{
+    size_t   Begin, End;        //  records of the first mark or arc and after the last
+    size_t   FirstCorner, Corners;
+    UINT     Mode;              //  set_sky_writing_mode_list
+    double   Limit;             //  set_sky_writing_limit_list with mode 3
+    double   Saved;             //  [s] against no sky writing, < 0 if slower
+
+};
+
+class SkyPlanner
+{
+public:
+    SkyPlanner();
+
+    //  The records are not copied and must stay valid while Plan is used
+    void     SetSub( UINT Index, const ListCommand* Cmd, size_t Count );
+
+    UINT     Plan( const ListCommand* Cmd, size_t Count, ListJob& Out );
+    void     Print( FILE* Out ) const;
+
+    //  Settings
+    double   TimeLag;                               //  [us] of the head, Timelag of set_sky_writing_para_list
+    LONG     LaserOnShift;                          //  LaserOnShift of set_sky_writing_para_list
+    UINT     Prev, Post;                            //  [10 us] run-in and run-out, 0: TimeLag
+    double   MaxError;                              //  [bits] corner rounding
+
+    //  Results
+    std::vector< SkyCorner >   Corners;
+    std::vector< SkyPolyline > Polylines;
+    uint64_t Skied;                                 //  corners with sky writing
+    uint64_t OverError;                             //  corners beyond MaxError with the polygon delay
+    uint64_t Switches;                              //  sky writing commands written
+    double   Before, After;                         //  [s] TimeEstimator of the job and the plan
+    double   Predicted;                             //  [s] After - Before by the plan
+
+private:
+    SkyPlanner( const SkyPlanner& );
+    SkyPlanner& operator=( const SkyPlanner& );
+
+    struct Table
+    {
+        const ListCommand* Cmd;
+        size_t Count;
+
+    };
+
+    void     Choose( SkyPolyline& p, double Start, double End, double SkyStart, double SkyEnd, double SkyTurn );
+
+    std::vector< Table > Subs;
+
+};
@@ -0,0 +1,719 @@
+//  File
+//      RTC5Slice.cpp
+//
+//  Abstract
+//      Slicing of STL meshes into layers
+//
+//  Comment
+//      Binary STL (little endian):
+//          header                  80 bytes
+//          uint32_t                number of triangles
+//          per triangle            50 bytes: normal float[ 3 ], vertices
+//                                  float[ 3 ][ 3 ], attributes uint16_t
+//      The stored normals are not used, a triangle is oriented by the order
+//      of its vertices, counterclockwise seen from outside.
+//      Walking around a triangle, the cut enters it on the edge going down
+//      through the layer and leaves on the edge going up, so the contours
+//      run counterclockwise around the material seen from above. An edge is
+//      named by its lower and its upper vertex, the next segment of a
+//      contour is the one entering by the edge the last one left by.
+//      Win32 maps the file by CreateFileMapping / MapViewOfFile, Linux by
+//      mmap, like a JobFile.
+//
+//  Necessary Sources
+//      RTC5Slice.h, RTC5Hatch.h, RTC5Feeder.h, RTC5List.h, RTC5Util.h,
+//      RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <math.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "RTC5Slice.h"
+#include "RTC5Util.h"
+
+static const size_t HeaderBytes          =           84;   //  header and number of triangles
+static const size_t TriangleBytes        =           50;
+static const size_t MaxAhead             =            4;   //  layers sliced ahead of the writer per thread
+static const double MaxField             =     524287.0;   //  [bits]
+static const double MinStep              =          0.5;   //  [bits] shorter segments are joined
+
+//  The vertices of triangle t, x, y, z of each
+static void Vertices( const uint8_t* View, size_t t, float* v )
+{
+    memcpy( v, View + HeaderBytes + t * TriangleBytes + 12, 9 * sizeof( float ) );
+
+}
+
+//  Height of layer k, the same expression wherever a vertex is compared
+static double LayerZ( const SliceEngine& e, UINT k )
+{
+    return e.Min[ 2 ] + ( k + 0.5 ) * e.LayerHeight;
+
+}
+
+//  The layers a triangle from Lo to High crosses, Lo < z <= High, false if none
+static bool LayerRange( const SliceEngine& e, double Lo, double High, UINT& First, UINT& Last )
+{
+    if ( !e.Layers ) return false;
+
+    const double Top = (double) e.Layers - 1.0;
+    double f = floor( ( Lo - e.Min[ 2 ] ) / e.LayerHeight - 0.5 ) + 1.0;
+    double l = floor( ( High - e.Min[ 2 ] ) / e.LayerHeight - 0.5 );
+
+    First = (UINT) std::min( std::max( f, 0.0 ), Top );
+    Last  = (UINT) std::min( std::max( l, 0.0 ), Top );
+
+    //  Rounding of the division, the comparison decides
+    while ( First > 0 && LayerZ( e, First - 1 ) > Lo ) First--;
+    while ( First < e.Layers && LayerZ( e, First ) <= Lo ) First++;
+    while ( Last + 1 < e.Layers && LayerZ( e, Last + 1 ) <= High ) Last++;
+    while ( Last > 0 && LayerZ( e, Last ) > High ) Last--;
+
+    return First < e.Layers && First <= Last && LayerZ( e, Last ) <= High;
+
+}
+
+//  SliceCut
+//
+//  The block of one layer: its contours, hatched
+
+class SliceCut
+{
+public:
+    explicit SliceCut( const SliceEngine& e );
+
+    void     Layer( UINT k, ListJob& Out );
+
+    uint64_t Segments, Contours, OpenChains, Lines;
+
+private:
+    SliceCut( const SliceCut& );
+    SliceCut& operator=( const SliceCut& );
+
+    struct Segment
+    {
+        float    Key[ 2 ][ 6 ];     //  edges entered and left by, lower and upper vertex
+        double   X, Y;              //  [bits] where it enters
+
+    };
+
+    void     Cut( UINT k );
+    void     Link();
+    int32_t  Find( const float* Key ) const;
+
+    const SliceEngine& Engine;
+
+    std::vector< Segment > Segs;
+    std::vector< int32_t > Table;   //  open addressing by the entry edge
+    std::vector< uint8_t > Used;
+    HatchRegion Region;
+    HatchEngine Hatch;
+
+};
+
+static uint64_t KeyHash( const float* Key )
+{
+    uint32_t w[ 6 ];
+    memcpy( w, Key, sizeof( w ) );
+
+    uint64_t h = 0x9E3779B97F4A7C15ULL;
+
+    for ( UINT i = 0; i < 6; i++ )
+    {
+        h ^= w[ i ];
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+
+    }
+
+    return h;
+
+}
+
+SliceCut::SliceCut( const SliceEngine& e )
+    : Segments( 0 ), Contours( 0 ), OpenChains( 0 ), Lines( 0 ), Engine( e )
+{
+    Hatch.Pitch        = e.Pitch;
+    Hatch.Outline      = e.Outline;
+    Hatch.LinkDistance = e.LinkDistance;
+    Hatch.Threads      = 1;
+
+}
+
+void SliceCut::Cut( UINT k )
+{
+    const SliceEngine& e = Engine;
+    const double z = LayerZ( e, k );
+    const UINT   b = k / e.BandLayers;
+
+    Segs.clear();
+
+    for ( uint32_t i = e.BandStart[ b ]; i < e.BandStart[ b + 1 ]; i++ )
+    {
+        float v[ 9 ];
+        Vertices( e.View, e.BandTriangles[ i ], v );
+
+        const bool Up[ 3 ] = { v[ 2 ] >= z, v[ 5 ] >= z, v[ 8 ] >= z };
+        if ( Up[ 0 ] == Up[ 1 ] && Up[ 1 ] == Up[ 2 ] ) continue;
+
+        Segment s;
+        double  x = 0.0, y = 0.0;
+
+        for ( UINT j = 0; j < 3; j++ )
+        {
+            const UINT a = j, c = ( j + 1 ) % 3;
+            if ( Up[ a ] == Up[ c ] ) continue;
+
+            //  Down: the segment enters, up: it leaves
+            const float* Lo   = Up[ a ] ? v + 3 * c : v + 3 * a;
+            const float* High = Up[ a ] ? v + 3 * a : v + 3 * c;
+            const UINT   Side = Up[ a ] ? 0 : 1;
+
+            memcpy( s.Key[ Side ],     Lo,   3 * sizeof( float ) );
+            memcpy( s.Key[ Side ] + 3, High, 3 * sizeof( float ) );
+
+            if ( Side == 0 )
+            {
+                const double t = ( z - Lo[ 2 ] ) / ( (double) High[ 2 ] - Lo[ 2 ] );
+                x = Lo[ 0 ] + t * ( (double) High[ 0 ] - Lo[ 0 ] );
+                y = Lo[ 1 ] + t * ( (double) High[ 1 ] - Lo[ 1 ] );
+
+            }
+
+        }
+
+        s.X = x * e.Scale + e.OffsetX;
+        s.Y = y * e.Scale + e.OffsetY;
+        Segs.push_back( s );
+
+    }
+
+    Segments += Segs.size();
+
+}
+
+int32_t SliceCut::Find( const float* Key ) const
+{
+    const size_t Mask = Table.size() - 1;
+
+    for ( size_t h = (size_t) KeyHash( Key ) & Mask; Table[ h ] >= 0; h = ( h + 1 ) & Mask )
+    {
+        if ( !memcmp( Segs[ Table[ h ] ].Key[ 0 ], Key, 6 * sizeof( float ) ) ) return Table[ h ];
+
+    }
+
+    return -1;
+
+}
+
+void SliceCut::Link()
+{
+    const size_t n = Segs.size();
+    size_t Slots = 16;
+    while ( Slots < 2 * n ) Slots *= 2;
+
+    Table.assign( Slots, -1 );
+    Used.assign( n, 0 );
+    Region.clear();
+
+    for ( size_t i = 0; i < n; i++ )
+    {
+        size_t h = (size_t) KeyHash( Segs[ i ].Key[ 0 ] ) & ( Slots - 1 );
+        while ( Table[ h ] >= 0 ) h = ( h + 1 ) & ( Slots - 1 );
+        Table[ h ] = (int32_t) i;
+
+    }
+
+    HatchContour c;
+
+    for ( size_t i = 0; i < n; i++ )
+    {
+        if ( Used[ i ] ) continue;
+
+        c.clear();
+        bool    Closed = false;
+        int32_t s      = (int32_t) i;
+
+        for ( ;; )
+        {
+            Used[ s ] = 1;
+
+            const HatchPoint p = { Segs[ s ].X, Segs[ s ].Y };
+            if ( c.empty() || fabs( p.X - c.back().X ) + fabs( p.Y - c.back().Y ) >= MinStep ) c.push_back( p );
+
+            s = Find( Segs[ s ].Key[ 1 ] );
+
+            if ( s == (int32_t) i ) Closed = true;
+            if ( s < 0 || Used[ s ] ) break;
+
+        }
+
+        if ( !Closed )
+        {
+            OpenChains++;
+            continue;
+
+        }
+
+        if ( c.size() > 1 && fabs( c[ 0 ].X - c.back().X ) + fabs( c[ 0 ].Y - c.back().Y ) < MinStep ) c.pop_back();
+
+        if ( c.size() >= 3 )
+        {
+            Region.push_back( c );
+            Contours++;
+
+        }
+
+    }
+
+}
+
+void SliceCut::Layer( UINT k, ListJob& Out )
+{
+    const SliceEngine& e = Engine;
+
+    Cut( k );
+    Link();
+
+    if ( k > 0 && e.RecoatDelay ) Out.push_back( ListMake( OpLongDelay, e.RecoatDelay ) );
+
+    const size_t Begin = Out.size();
+
+    if ( e.Fill )
+    {
+        Hatch.Regions.assign( 1, HatchRegion() );
+        Hatch.Regions[ 0 ].swap( Region );
+        Hatch.Angles.assign( 1, e.Angle + k * e.Rotation );
+        Hatch.Hatch( Out );
+        Lines += Hatch.Lines;
+
+    }
+    else
+    {
+        for ( size_t r = 0; r < Region.size(); r++ )
+        {
+            const HatchContour& c = Region[ r ];
+
+            for ( size_t i = 0; i <= c.size(); i++ )
+            {
+                const HatchPoint& p = c[ i % c.size() ];
+                Out.push_back( ListMake( i ? OpMarkAbs : OpJumpAbs, (int32_t) floor( p.X + 0.5 ), (int32_t) floor( p.Y + 0.5 ) ) );
+
+            }
+
+        }
+
+    }
+
+    if ( e.ZStep )
+    {
+        const int32_t Z = (int32_t) k * e.ZStep;
+
+        for ( size_t i = Begin; i < Out.size(); i++ )
+        {
+            ListCommand& Cmd = Out[ i ];
+
+            if ( Cmd.Op == OpJumpAbs || Cmd.Op == OpMarkAbs )
+            {
+                Cmd.Op     = (uint16_t) ( Cmd.Op == OpJumpAbs ? OpJumpAbs3D : OpMarkAbs3D );
+                Cmd.I[ 2 ] = Z;
+
+            }
+
+        }
+
+    }
+
+}
+
+//  SliceEngine
+
+SliceEngine::SliceEngine()
+    : Triangles( 0 ),
+      LayerHeight( 0.05 ), Scale( 1000.0 ), OffsetX( 0.0 ), OffsetY( 0.0 ), ZStep( 0 ), Defocus( 0 ), Fill( true ),
+      Pitch( 100.0 ), Angle( 0.0 ), Rotation( 67.0 ), Outline( true ), LinkDistance( 0.0 ), RecoatDelay( 0 ),
+      BandLayers( 16 ), Threads( 0 ),
+      Layers( 0 ), Segments( 0 ), Contours( 0 ), OpenChains( 0 ), Lines( 0 ), Records( 0 ), FeedError( FeedNoError ),
+      IndexTime( 0.0 ), FirstLayerTime( 0.0 ), WriteTime( 0.0 ),
+      View( 0 ), Size( 0 )
+#ifdef _WIN32
+    , File( INVALID_HANDLE_VALUE ), Mapping( 0 )
+#else
+    , File( -1 )
+#endif
+{
+    for ( UINT a = 0; a < 3; a++ ) Min[ a ] = Max[ a ] = 0.0;
+
+}
+
+SliceEngine::~SliceEngine()
+{
+    Close();
+
+}
+
+//  Open
+//
+//  Description:
+//
+//  Maps the binary STL file Name and computes the bounding box of the
+//  mesh. An ASCII STL is refused as a format error.
+//
+//      Return      SliceNoError, SliceFileError or SliceFormatError
+//
+
+UINT SliceEngine::Open( const char* Name )
+{
+    Close();
+
+#ifdef _WIN32
+    File = CreateFileA( Name, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0 );
+
+    if ( File == INVALID_HANDLE_VALUE ) return SliceFileError;
+
+    LARGE_INTEGER FileSize;
+
+    if ( !GetFileSizeEx( File, &FileSize ) || !FileSize.QuadPart )
+    {
+        Close();
+        return SliceFormatError;
+
+    }
+
+    Size    = (size_t) FileSize.QuadPart;
+    Mapping = CreateFileMappingA( File, 0, PAGE_READONLY, 0, 0, 0 );
+    View    = Mapping ? (const uint8_t*) MapViewOfFile( Mapping, FILE_MAP_READ, 0, 0, 0 ) : 0;
+#else
+    File = open( Name, O_RDONLY );
+
+    if ( File < 0 ) return SliceFileError;
+
+    struct stat Stat;
+
+    if ( fstat( File, &Stat ) || !Stat.st_size )
+    {
+        Close();
+        return SliceFormatError;
+
+    }
+
+    Size = (size_t) Stat.st_size;
+
+    void* p = mmap( 0, Size, PROT_READ, MAP_SHARED, File, 0 );
+    View = p == MAP_FAILED ? 0 : (const uint8_t*) p;
+#endif
+
+    if ( !View )
+    {
+        Close();
+        return SliceFileError;
+
+    }
+
+    uint32_t Count = 0;
+    if ( Size >= HeaderBytes ) memcpy( &Count, View + 80, sizeof( Count ) );
+
+    if ( Size < HeaderBytes || !Count || Count > ( Size - HeaderBytes ) / TriangleBytes )
+    {
+        Close();
+        return SliceFormatError;
+
+    }
+
+    Triangles = Count;
+
+    float Lo[ 3 ] = { INFINITY, INFINITY, INFINITY }, High[ 3 ] = { -INFINITY, -INFINITY, -INFINITY };
+
+    for ( size_t t = 0; t < Triangles; t++ )
+    {
+        float v[ 9 ];
+        Vertices( View, t, v );
+
+        for ( UINT i = 0; i < 9; i++ )
+        {
+            Lo[ i % 3 ]   = std::min( Lo[ i % 3 ], v[ i ] );
+            High[ i % 3 ] = std::max( High[ i % 3 ], v[ i ] );
+
+        }
+
+    }
+
+    for ( UINT a = 0; a < 3; a++ )
+    {
+        Min[ a ] = Lo[ a ];
+        Max[ a ] = High[ a ];
+
+    }
+
+    if ( !( Min[ 0 ] <= Max[ 0 ] && Min[ 1 ] <= Max[ 1 ] && Min[ 2 ] <= Max[ 2 ] ) )
+    {
+        Close();
+        return SliceFormatError;
+
+    }
+
+    return SliceNoError;
+
+}
+
+void SliceEngine::Close()
+{
+#ifdef _WIN32
+    if ( View ) UnmapViewOfFile( View );
+    if ( Mapping ) CloseHandle( Mapping );
+    if ( File != INVALID_HANDLE_VALUE ) CloseHandle( File );
+
+    Mapping = 0;
+    File    = INVALID_HANDLE_VALUE;
+#else
+    if ( View ) munmap( (void*) View, Size );
+    if ( File >= 0 ) close( File );
+
+    File = -1;
+#endif
+
+    View      = 0;
+    Size      = 0;
+    Triangles = 0;
+
+    BandStart.clear();
+    BandTriangles.clear();
+
+}
+
+//  Slice
+//
+//  Description:
+//
+//  Slices the mesh and appends the layers to Out, or feeds them to the
+//  ListFeeder while the later layers are sliced.
+//
+//      Return                  Meaning
+//
+//      SliceNoError            all layers written
+//      SliceRangeError         no mesh, a setting not positive or the mesh
+//                              beyond the field
+//      SliceFeedError          the ListFeeder failed with FeedError
+//
+
+UINT SliceEngine::Slice( ListJob& Out )
+{
+    return Run( &Out, 0 );
+
+}
+
+UINT SliceEngine::Slice( ListFeeder& Feeder )
+{
+    return Run( 0, &Feeder );
+
+}
+
+UINT SliceEngine::Run( ListJob* Out, ListFeeder* Feeder )
+{
+    Layers    = 0;
+    Segments  = Contours = OpenChains = Lines = Records = 0;
+    FeedError = FeedNoError;
+    IndexTime = FirstLayerTime = WriteTime = 0.0;
+
+    if ( !View || !( LayerHeight > 0.0 ) || !( Scale > 0.0 ) || !BandLayers || ( Fill && !( Pitch > 0.0 ) ) )
+    {
+        return SliceRangeError;
+
+    }
+
+    for ( UINT c = 0; c < 4; c++ )
+    {
+        const double x = ( c & 1 ? Max[ 0 ] : Min[ 0 ] ) * Scale + OffsetX;
+        const double y = ( c & 2 ? Max[ 1 ] : Min[ 1 ] ) * Scale + OffsetY;
+        if ( !( fabs( x ) <= MaxField && fabs( y ) <= MaxField ) ) return SliceRangeError;
+
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const UINT n  = std::max( 1u, Threads ? Threads : std::thread::hardware_concurrency() );
+
+    Layers = (UINT) std::max( 0.0, ceil( ( Max[ 2 ] - Min[ 2 ] ) / LayerHeight ) );
+
+    const UINT Bands = ( Layers + BandLayers - 1 ) / BandLayers;
+
+    //  Band index: counted per thread and band, then filled at the offsets
+    std::vector< std::vector< uint32_t > > Counts( n, std::vector< uint32_t >( Bands + 1, 0 ) );
+
+    Parallel( n, [ & ]( UINT t )
+    {
+        const size_t Begin = (size_t) Triangles * t / n, End = (size_t) Triangles * ( t + 1 ) / n;
+        std::vector< uint32_t >& Count = Counts[ t ];
+
+        for ( size_t i = Begin; i < End; i++ )
+        {
+            float v[ 9 ];
+            Vertices( View, i, v );
+
+            UINT First, Last;
+            if ( !LayerRange( *this, std::min( v[ 2 ], std::min( v[ 5 ], v[ 8 ] ) ),
+                              std::max( v[ 2 ], std::max( v[ 5 ], v[ 8 ] ) ), First, Last ) ) continue;
+
+            for ( UINT b = First / BandLayers; b <= Last / BandLayers; b++ ) Count[ b ]++;
+
+        }
+
+    } );
+
+    BandStart.assign( Bands + 1, 0 );
+    std::vector< std::vector< uint32_t > > Offsets( n, std::vector< uint32_t >( Bands, 0 ) );
+    uint32_t Total = 0;
+
+    for ( UINT b = 0; b < Bands; b++ )
+    {
+        BandStart[ b ] = Total;
+
+        for ( UINT t = 0; t < n; t++ )
+        {
+            Offsets[ t ][ b ] = Total;
+            Total += Counts[ t ][ b ];
+
+        }
+
+    }
+
+    BandStart[ Bands ] = Total;
+    BandTriangles.resize( Total );
+
+    Parallel( n, [ & ]( UINT t )
+    {
+        const size_t Begin = (size_t) Triangles * t / n, End = (size_t) Triangles * ( t + 1 ) / n;
+        std::vector< uint32_t >& Offset = Offsets[ t ];
+
+        for ( size_t i = Begin; i < End; i++ )
+        {
+            float v[ 9 ];
+            Vertices( View, i, v );
+
+            UINT First, Last;
+            if ( !LayerRange( *this, std::min( v[ 2 ], std::min( v[ 5 ], v[ 8 ] ) ),
+                              std::max( v[ 2 ], std::max( v[ 5 ], v[ 8 ] ) ), First, Last ) ) continue;
+
+            for ( UINT b = First / BandLayers; b <= Last / BandLayers; b++ ) BandTriangles[ Offset[ b ]++ ] = (uint32_t) i;
+
+        }
+
+    } );
+
+    IndexTime = Seconds( t0 );
+
+    //  Layers sliced by the workers, written here in their order
+    const UINT w = std::min( n, std::max( Layers, 1u ) );
+
+    std::vector< ListJob > Blocks( Layers );
+    std::vector< uint8_t > Done( Layers, 0 );
+    std::mutex Lock;
+    std::condition_variable Ready, Room;
+    std::atomic< UINT > Next( 0 );
+    size_t Written = 0;
+    bool   Abort = false;
+
+    auto Work = [ & ]()
+    {
+        SliceCut c( *this );
+
+        for ( UINT k; ( k = Next++ ) < Layers; )
+        {
+            {
+                std::unique_lock< std::mutex > Guard( Lock );
+                Room.wait( Guard, [ & ]() { return Abort || k < Written + MaxAhead * w; } );
+                if ( Abort ) break;
+
+            }
+
+            ListJob Block;
+            c.Layer( k, Block );
+
+            std::lock_guard< std::mutex > Guard( Lock );
+            Blocks[ k ].swap( Block );
+            Done[ k ] = 1;
+            Ready.notify_one();
+
+        }
+
+        std::lock_guard< std::mutex > Guard( Lock );
+        Segments   += c.Segments;
+        Contours   += c.Contours;
+        OpenChains += c.OpenChains;
+        Lines      += c.Lines;
+
+    };
+
+    std::vector< std::thread > Workers;
+    for ( UINT t = 0; t < w; t++ ) Workers.push_back( std::thread( Work ) );
+
+    UINT Error = SliceNoError;
+
+    if ( Defocus )
+    {
+        const ListCommand Cmd = ListMake( OpSetDefocus, Defocus );
+
+        if ( Out ) Out->push_back( Cmd );
+        if ( Feeder ) FeedError = Feeder->Feed( &Cmd, 1 );
+
+        Records++;
+
+    }
+
+    for ( UINT k = 0; k < Layers && !FeedError; k++ )
+    {
+        ListJob Block;
+
+        {
+            std::unique_lock< std::mutex > Guard( Lock );
+            Ready.wait( Guard, [ & ]() { return Done[ k ] != 0; } );
+            Block.swap( Blocks[ k ] );
+
+        }
+
+        if ( Out ) Out->insert( Out->end(), Block.begin(), Block.end() );
+
+        if ( Feeder && !Block.empty() ) FeedError = Feeder->Feed( Block.data(), Block.size() );
+
+        Records += Block.size();
+        if ( k == 0 ) FirstLayerTime = Seconds( t0 );
+
+        std::lock_guard< std::mutex > Guard( Lock );
+        Written = k + 1;
+        Room.notify_all();
+
+    }
+
+    if ( FeedError )
+    {
+        std::lock_guard< std::mutex > Guard( Lock );
+        Error = SliceFeedError;
+        Abort = true;
+        Room.notify_all();
+
+    }
+
+    for ( size_t t = 0; t < Workers.size(); t++ ) Workers[ t ].join();
+
+    WriteTime = Seconds( t0 );
+    if ( !Layers ) FirstLayerTime = WriteTime;
+
+    return Error;
+
+}
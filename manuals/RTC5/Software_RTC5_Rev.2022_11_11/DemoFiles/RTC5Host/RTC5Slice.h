@@ -0,0 +1,110 @@
+//  File
+//      RTC5Slice.h
+//
+//  Abstract
+//      Slicing of STL meshes into layers for laser based additive jobs.
+//      A SliceEngine maps a binary STL file, cuts the mesh at every layer
+//      and writes the contours and the hatch of each layer as list commands
+//      into a job or straight into a ListFeeder, layer after layer, so the
+//      first layer marks while the later ones are sliced. With ZStep the
+//      vectors are jump_abs_3d and mark_abs_3d at the focus of the layer.
+//
+//  Comment
+//      The layers lie at z = Min[ 2 ] + ( k + 0.5 ) LayerHeight. A vertex
+//      on a layer counts as above it, so a cut never passes a vertex
+//      twice. The cut points are found by the edges of the mesh, the ends
+//      of the segments are joined by the vertices of their edge, which
+//      assumes a closed mesh whose triangles share their vertices bit for
+//      bit, as the exporters write them.
+//      An index holds the triangles per band of BandLayers layers, it is
+//      built by all threads in one pass over the file, then the layers are
+//      sliced and hatched in parallel and written in their order.
+//
+//  Necessary Sources
+//      RTC5Slice.h, RTC5Slice.cpp, RTC5Hatch.h, RTC5Hatch.cpp, RTC5Feeder.h,
+//      RTC5Feeder.cpp, RTC5List.h, RTC5List.cpp, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "RTC5Feeder.h"
+#include "RTC5Hatch.h"
+#include "RTC5List.h"
+
+//  Error codes of the engine
+const UINT   SliceNoError         =            0;
+const UINT   SliceFileError       =            1;   //  file not found or not mappable
+const UINT   SliceFormatError     =            2;   //  no binary STL or truncated
+const UINT   SliceRangeError      =            3;   //  no mesh, settings not positive or beyond the field
+const UINT   SliceFeedError       =            4;   //  ListFeeder error, see SliceEngine::FeedError
+
+class SliceEngine
+{
+public:
+    SliceEngine();
+    ~SliceEngine();
+
+    UINT     Open( const char* Name );
+    void     Close();
+
+    UINT     Slice( ListJob& Out );
+    UINT     Slice( ListFeeder& Feeder );           //  opened by the caller, not finished
+
+    //  Mesh, after Open
+    uint32_t Triangles;
+    double   Min[ 3 ], Max[ 3 ];                    //  [mm] bounding box
+
+    //  Settings
+    double   LayerHeight;                           //  [mm]
+    double   Scale;                                 //  [bits/mm] in x and y
+    double   OffsetX, OffsetY;                      //  [bits] of the origin of the mesh
+    LONG     ZStep;                                 //  [bits] of z per layer, 0: 2D vectors
+    LONG     Defocus;                               //  [bits] set_defocus_list ahead of the layers, 0: none
+    bool     Fill;                                  //  false: contours only
+    double   Pitch;                                 //  [bits] of the hatch
+    double   Angle;                                 //  [deg] of the hatch of layer 0
+    double   Rotation;                              //  [deg] added per layer
+    bool     Outline;                               //  mark the contours before the hatch
+    double   LinkDistance;                          //  [bits] see HatchEngine
+    UINT     RecoatDelay;                           //  [10 us] long_delay between the layers, 0: none
+    UINT     BandLayers;                            //  layers per band of the index
+    UINT     Threads;                               //  0: one per processor
+
+    //  Results
+    UINT     Layers;
+    uint64_t Segments;                              //  cut
+    uint64_t Contours;                              //  closed
+    uint64_t OpenChains;                            //  dropped, the mesh has holes
+    uint64_t Lines;                                 //  hatch spans
+    uint64_t Records;                               //  written
+    UINT     FeedError;                             //  of the ListFeeder with SliceFeedError
+    double   IndexTime;                             //  [s] wall clock of the band index
+    double   FirstLayerTime;                        //  [s] wall clock until layer 0 was written
+    double   WriteTime;                             //  [s] wall clock until the last layer was written
+
+private:
+    SliceEngine( const SliceEngine& );
+    SliceEngine& operator=( const SliceEngine& );
+
+    friend class SliceCut;
+
+    UINT     Run( ListJob* Out, ListFeeder* Feeder );
+
+    const uint8_t* View;
+    size_t   Size;
+#ifdef _WIN32
+    void*    File;
+    void*    Mapping;
+#else
+    int      File;
+#endif
+
+    std::vector< uint32_t > BandStart;              //  per band into BandTriangles, one more than bands
+    std::vector< uint32_t > BandTriangles;
+
+};
@@ -0,0 +1,380 @@
+//  File
+//      RTC5Slots.cpp
+//
+//  Abstract
+//      Job slots in the list memory of the RTC5
+//
+//  Comment
+//      Free space is not stored, it is the complement of the slots of a
+//      list. With the usual number of resident jobs (tens to hundreds)
+//      a first fit over the sorted slot positions is fast enough.
+//
+//  Necessary Sources
+//      RTC5Slots.h, RTC5List.h, RTC5List.cpp, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <algorithm>
+
+#include "RTC5Slots.h"
+
+SlotManager::SlotManager()
+    : Hits( 0 ), Loads( 0 ), Evictions( 0 ), Clock( 0 ), Armed( 0 ), HasArmed( false )
+{
+    Init( 4000, 4000 );
+
+}
+
+void SlotManager::Init( UINT Mem1, UINT Mem2 )
+{
+    Slots.clear();
+    Start[ 0 ]  = Length[ 0 ] = 0;
+    Start[ 1 ]  = 0;
+    Length[ 1 ] = Mem1;
+    Start[ 2 ]  = Mem1;
+    Length[ 2 ] = Mem2;
+    HasArmed    = false;
+
+}
+
+int SlotManager::Find( uint64_t Id ) const
+{
+    for ( size_t i = 0; i < Slots.size(); i++ )
+    {
+        if ( Slots[ i ].Id == Id ) return (int) i;
+
+    }
+
+    return -1;
+
+}
+
+//  Ranges
+//
+//  Description:
+//
+//  The absolute positions [Begin, End) of slot s. Each list wraps within
+//  itself like the input pointer of the card: a job past the end of its
+//  list continues at the start of the same list as a second range.
+//  Returns the number of ranges, 1 or 2.
+//
+
+UINT SlotManager::Ranges( const Slot& s, UINT* Begin, UINT* End ) const
+{
+    const UINT First = Start[ s.List ], Last = First + Length[ s.List ];
+
+    Begin[ 0 ] = s.Pos;
+    End[ 0 ]   = std::min( s.Pos + s.Size, Last );
+
+    if ( s.Pos + s.Size <= Last ) return 1;
+
+    Begin[ 1 ] = First;
+    End[ 1 ]   = std::min( First + ( s.Pos + s.Size - Last ), s.Pos );
+    return 2;
+
+}
+
+//  Positions and sizes of the slots within list List, sorted
+void SlotManager::UsedIn( UINT List, std::vector< std::pair< UINT, UINT > >& Used ) const
+{
+    Used.clear();
+
+    for ( size_t i = 0; i < Slots.size(); i++ )
+    {
+        if ( Slots[ i ].List != List ) continue;
+
+        UINT Begin[ 2 ], End[ 2 ];
+        const UINT n = Ranges( Slots[ i ], Begin, End );
+
+        for ( UINT r = 0; r < n; r++ )
+        {
+            if ( Begin[ r ] < End[ r ] ) Used.push_back( std::make_pair( Begin[ r ], End[ r ] - Begin[ r ] ) );
+
+        }
+
+    }
+
+    std::sort( Used.begin(), Used.end() );
+
+}
+
+//  FitIn
+//
+//  Description:
+//
+//  First fit of Size positions into the free space of list List.
+//  Returns the absolute position or SlotNone.
+//
+
+UINT SlotManager::FitIn( UINT List, UINT Size ) const
+{
+    std::vector< std::pair< UINT, UINT > > Used;
+    UsedIn( List, Used );
+
+    UINT Free = Start[ List ];
+
+    for ( size_t i = 0; i < Used.size(); i++ )
+    {
+        if ( Used[ i ].first >= Free + Size ) return Free;
+
+        Free = std::max( Free, Used[ i ].first + Used[ i ].second );
+
+    }
+
+    return Free + Size <= Start[ List ] + Length[ List ] ? Free : SlotNone;
+
+}
+
+//  Allocate
+//
+//  Description:
+//
+//  Finds Size free positions in a list the card is not busy on, evicting
+//  the least recently used jobs of these lists if necessary. Only lists
+//  of at least Size positions are searched and evicted from, without one
+//  nothing is evicted.
+//
+//      Parameter   Meaning
+//
+//      BusyLists   bit #0: list 1 busy, bit #1: list 2 busy
+//
+
+bool SlotManager::Allocate( UINT Size, UINT BusyLists, UINT* List, UINT* Pos )
+{
+    UINT Lists = 0;     //  bit #0: list 1 can take the job, bit #1: list 2
+
+    for ( UINT l = 1; l <= 2; l++ )
+    {
+        if ( !( BusyLists & ( 1 << ( l - 1 ) ) ) && Length[ l ] >= Size ) Lists |= 1 << ( l - 1 );
+
+    }
+
+    if ( !Lists ) return false;
+
+    for ( ;; )
+    {
+        for ( UINT l = 1; l <= 2; l++ )
+        {
+            if ( !( Lists & ( 1 << ( l - 1 ) ) ) ) continue;
+
+            const UINT p = FitIn( l, Size );
+
+            if ( p != SlotNone )
+            {
+                *List = l;
+                *Pos  = p;
+                return true;
+
+            }
+
+        }
+
+        int Victim = -1;
+
+        for ( size_t i = 0; i < Slots.size(); i++ )
+        {
+            const Slot& s = Slots[ i ];
+
+            if ( !( Lists & ( 1 << ( s.List - 1 ) ) ) ) continue;
+            if ( HasArmed && s.Id == Armed ) continue;
+
+            if ( Victim < 0 || s.LastUse < Slots[ Victim ].LastUse ) Victim = (int) i;
+
+        }
+
+        if ( Victim < 0 ) return false;
+
+        Slots.erase( Slots.begin() + Victim );
+        Evictions++;
+
+    }
+
+}
+
+//  Load
+//
+//  Description:
+//
+//  Makes the job Id resident. A resident job is only marked as recently
+//  used, otherwise Cmd is transferred into a free slot.
+//
+//      Parameter   Meaning
+//
+//      Id          job identification, e.g. ListHash of the commands
+//      Cmd         precompiled commands, set_end_of_list is appended if
+//                  the last command is none
+//      Count       number of records
+//
+
+UINT SlotManager::Load( uint64_t Id, const ListCommand* Cmd, size_t Count )
+{
+    const int i = Find( Id );
+
+    if ( i >= 0 )
+    {
+        Slots[ i ].LastUse = ++Clock;
+        Hits++;
+        return SlotNoError;
+
+    }
+
+    const bool Terminated = Count && Cmd[ Count - 1 ].Op == OpEndOfList;
+    const UINT Size = (UINT) Count + ( Terminated ? 0 : 1 );
+
+    if ( Size > Length[ 1 ] && Size > Length[ 2 ] ) return SlotNoSpace;
+
+    const UINT BusyLists = ( read_status() >> 4 ) & 3;     //  BUSY1, BUSY2
+
+    UINT List, Pos;
+
+    if ( !Allocate( Size, BusyLists, &List, &Pos ) ) return SlotBusy;
+
+    if ( !load_list( List, Pos - Start[ List ] ) ) return SlotBusy;
+
+    const UINT Error = get_last_error();
+
+    ListReplay( Cmd, Count );
+    if ( !Terminated ) set_end_of_list();
+
+    //  The card may need more positions than records, e.g. for texts, the
+    //  input pointer wraps at the end of the list to its start
+    const UINT In   = get_input_pointer();
+    const UINT Used = ( In + Length[ List ] - Pos ) % Length[ List ];
+
+    Slot s;
+    s.Id      = Id;
+    s.List    = List;
+    s.Pos     = Pos;
+    s.Size    = std::max( Size, Used );
+    s.LastUse = ++Clock;
+
+    //  Jobs overwritten by a larger than expected job are gone, behind it and
+    //  at the start of its list if the job wrapped
+    UINT Begin[ 2 ], End[ 2 ];
+    const UINT n = Ranges( s, Begin, End );
+
+    for ( size_t k = Slots.size(); k-- > 0; )
+    {
+        const Slot& o = Slots[ k ];
+
+        UINT oBegin[ 2 ], oEnd[ 2 ];
+        const UINT m = Ranges( o, oBegin, oEnd );
+        bool Overlap = false;
+
+        for ( UINT r = 0; r < n; r++ )
+        {
+            for ( UINT q = 0; q < m; q++ ) Overlap = Overlap || ( oBegin[ q ] < End[ r ] && Begin[ r ] < oEnd[ q ] );
+
+        }
+
+        if ( Overlap )
+        {
+            if ( HasArmed && o.Id == Armed ) HasArmed = false;
+
+            Slots.erase( Slots.begin() + k );
+            Evictions++;
+
+        }
+
+    }
+
+    if ( get_last_error() & ~Error ) return SlotCardError;
+
+    Slots.push_back( s );
+    Loads++;
+
+    return SlotNoError;
+
+}
+
+//  Select
+//
+//  Description:
+//
+//  Selects the resident job Id for the next external start.
+//
+
+UINT SlotManager::Select( uint64_t Id )
+{
+    const int i = Find( Id );
+
+    if ( i < 0 ) return SlotUnknown;
+
+    Slots[ i ].LastUse = ++Clock;
+    Armed    = Id;
+    HasArmed = true;
+    set_extstartpos( Slots[ i ].Pos );
+
+    return SlotNoError;
+
+}
+
+UINT SlotManager::Execute( uint64_t Id )
+{
+    const int i = Find( Id );
+
+    if ( i < 0 ) return SlotUnknown;
+
+    Slots[ i ].LastUse = ++Clock;
+    execute_at_pointer( Slots[ i ].Pos );
+
+    return SlotNoError;
+
+}
+
+void SlotManager::Evict( uint64_t Id )
+{
+    const int i = Find( Id );
+
+    if ( i < 0 ) return;
+
+    if ( HasArmed && Id == Armed ) HasArmed = false;
+
+    Slots.erase( Slots.begin() + i );
+    Evictions++;
+
+}
+
+UINT SlotManager::Position( uint64_t Id ) const
+{
+    const int i = Find( Id );
+
+    return i < 0 ? SlotNone : Slots[ i ].Pos;
+
+}
+
+UINT SlotManager::FreeSpace() const
+{
+    UINT Free = Length[ 1 ] + Length[ 2 ];
+
+    for ( size_t i = 0; i < Slots.size(); i++ ) Free -= Slots[ i ].Size;
+
+    return Free;
+
+}
+
+UINT SlotManager::LargestFree() const
+{
+    UINT Largest = 0;
+
+    for ( UINT l = 1; l <= 2; l++ )
+    {
+        std::vector< std::pair< UINT, UINT > > Used;
+        UsedIn( l, Used );
+
+        UINT Free = Start[ l ];
+
+        for ( size_t i = 0; i < Used.size(); i++ )
+        {
+            Largest = std::max( Largest, Used[ i ].first > Free ? Used[ i ].first - Free : 0 );
+            Free    = std::max( Free, Used[ i ].first + Used[ i ].second );
+
+        }
+
+        Largest = std::max( Largest, Start[ l ] + Length[ l ] - Free );
+
+    }
+
+    return Largest;
+
+}
@@ -0,0 +1,86 @@
+//  File
+//      RTC5Slots.h
+//
+//  Abstract
+//      Job slots in the list memory of the RTC5.
+//      The SlotManager places precompiled jobs (ListJob) into list 1 and
+//      list 2 like Demo5 does with its two figures, but for any number of
+//      jobs: free space is tracked per list, the least recently used jobs
+//      are evicted when a new job does not fit. A resident job is selected
+//      for the next /START by a single set_extstartpos, so a recipe change
+//      costs no list download.
+//
+//  Comment
+//      Sizes are counted in list positions as reported by get_input_pointer.
+//      A slot in a list the card is busy on cannot be loaded; the manager
+//      prefers the list the card is not busy on. The job selected for
+//      external starts is never evicted.
+//
+//  Necessary Sources
+//      RTC5Slots.h, RTC5Slots.cpp, RTC5List.h, RTC5List.cpp, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "RTC5List.h"
+
+//  Error codes of the slot manager
+const UINT   SlotNoError          =            0;
+const UINT   SlotBusy             =            1;   //  no space in a list the card is not busy on
+const UINT   SlotNoSpace          =            2;   //  job larger than list 1 and list 2
+const UINT   SlotUnknown          =            3;   //  job not resident
+const UINT   SlotCardError        =            4;   //  RTC5 error while loading, see get_last_error
+
+const UINT   SlotNone             =   0xFFFFFFFF;   //  position of a job not resident
+
+class SlotManager
+{
+public:
+    SlotManager();
+
+    void Init( UINT Mem1, UINT Mem2 );      //  as config_list, all slots are free
+
+    UINT Load( uint64_t Id, const ListCommand* Cmd, size_t Count );
+    UINT Load( uint64_t Id, const ListJob& Job ) { return Load( Id, Job.data(), Job.size() ); }
+    UINT Select( uint64_t Id );             //  next /START marks the job
+    UINT Execute( uint64_t Id );            //  start by software
+    void Evict( uint64_t Id );
+
+    UINT Position( uint64_t Id ) const;     //  absolute start position or SlotNone
+    UINT FreeSpace() const;
+    UINT LargestFree() const;
+    UINT Resident() const { return (UINT) Slots.size(); }
+
+    uint64_t Hits;                          //  Load of a resident job
+    uint64_t Loads;                         //  jobs transferred to the card
+    uint64_t Evictions;
+
+private:
+    struct Slot
+    {
+        uint64_t Id;
+        UINT     List;
+        UINT     Pos;                       //  absolute start position
+        UINT     Size;                      //  list positions incl. set_end_of_list, may wrap to the start of the list
+        uint64_t LastUse;
+
+    };
+
+    int  Find( uint64_t Id ) const;
+    UINT Ranges( const Slot& s, UINT* Begin, UINT* End ) const;
+    void UsedIn( UINT List, std::vector< std::pair< UINT, UINT > >& Used ) const;
+    UINT FitIn( UINT List, UINT Size ) const;
+    bool Allocate( UINT Size, UINT BusyLists, UINT* List, UINT* Pos );
+
+    std::vector< Slot > Slots;
+    UINT     Start[ 3 ];                    //  absolute start of list 1 and 2
+    UINT     Length[ 3 ];
+    uint64_t Clock;
+    uint64_t Armed;                         //  job selected by set_extstartpos
+    bool     HasArmed;
+
+};
@@ -0,0 +1,358 @@
+//  File
+//      RTC5Subs.cpp
+//
+//  Abstract
+//      Subroutine deduplication for repetitive jobs
+//
+//  Comment
+//      Compile works in two passes: the first one splits the input into
+//      blocks and counts equal blocks, the second one emits sub_call for
+//      blocks occurring at least twice and copies all others.
+//      A block of n records costs n + 1 records once plus 2 (offset and
+//      sub_call) per occurrence instead of n per occurrence.
+//
+//  Necessary Sources
+//      RTC5Subs.h, RTC5List.h, RTC5List.cpp, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "RTC5Subs.h"
+
+//  One block or one other command of the input job
+struct SubItem
+{
+    size_t   Begin, End;        //  records of the input job
+    bool     Block;
+    LONG     X, Y;              //  first jump of the block
+    UINT     Rep;               //  first item with equal geometry
+
+};
+
+static bool SameRecords( const ListCommand* a, const ListCommand* b, size_t Count )
+{
+    return !memcmp( a, b, Count * sizeof( ListCommand ) );
+
+}
+
+//  Copy of the block moved to the origin
+static void Normalize( const ListJob& In, const SubItem& Item, ListJob& Block )
+{
+    Block.assign( In.begin() + Item.Begin, In.begin() + Item.End );
+
+    for ( size_t i = 0; i < Block.size(); i++ )
+    {
+        Block[ i ].I[ 0 ] -= Item.X;
+        Block[ i ].I[ 1 ] -= Item.Y;
+
+    }
+
+}
+
+//  Takes a set_offset_list or set_matrix_list record into Offset and Matrix
+static void ApplyTransform( const ListCommand& c, LONG* Offset, double* Matrix )
+{
+    if ( c.Op == OpSetOffset )
+    {
+        Offset[ 0 ] = c.I[ 0 ];
+        Offset[ 1 ] = c.I[ 1 ];
+
+    }
+    else if ( c.I[ 0 ] >= 1 && c.I[ 0 ] <= 2 && c.I[ 1 ] >= 1 && c.I[ 1 ] <= 2 )
+    {
+        Matrix[ ( c.I[ 0 ] - 1 ) * 2 + c.I[ 1 ] - 1 ] = c.D[ 0 ];
+
+    }
+
+}
+
+SubCompiler::SubCompiler( UINT FirstSub, UINT HeadNo )
+    : BlockGap( 2000 ), MinRecords( 3 ), First( FirstSub ), Head( HeadNo )
+{
+    memset( &Stats, 0, sizeof( Stats ) );
+    Offset[ 0 ] = Offset[ 1 ] = 0;
+    Matrix[ 0 ] = Matrix[ 3 ] = 1.0;
+    Matrix[ 1 ] = Matrix[ 2 ] = 0.0;
+
+}
+
+void SubCompiler::SetOffset( LONG X, LONG Y, ListJob& Out )
+{
+    if ( X == Offset[ 0 ] && Y == Offset[ 1 ] ) return;
+
+    ListCommand Cmd = ListMake( OpSetOffset, X, Y, 1 );
+    Cmd.Arg = (uint16_t) Head;
+    Out.push_back( Cmd );
+    Offset[ 0 ] = X;
+    Offset[ 1 ] = Y;
+
+}
+
+void SubCompiler::SetMatrix( double M11, double M12, double M21, double M22, ListJob& Out )
+{
+    const double M[ 4 ] = { M11, M12, M21, M22 };
+
+    for ( UINT i = 0; i < 4; i++ )
+    {
+        if ( M[ i ] == Matrix[ i ] ) continue;
+
+        ListCommand Cmd = ListMake( OpSetMatrix, 1 + i / 2, 1 + i % 2, 1 );
+        Cmd.Arg    = (uint16_t) Head;
+        Cmd.D[ 0 ] = M[ i ];
+        Out.push_back( Cmd );
+        Matrix[ i ] = M[ i ];
+
+    }
+
+}
+
+void SubCompiler::Finish( ListJob& Out )
+{
+    const size_t Size = Out.size();
+
+    SetOffset( 0, 0, Out );
+    SetMatrix( 1.0, 0.0, 0.0, 1.0, Out );
+    Stats.OutRecords += Out.size() - Size;
+
+}
+
+UINT SubCompiler::Intern( const ListJob& Block )
+{
+    const uint64_t Hash = ListHash( Block.data(), Block.size() );
+
+    for ( std::multimap< uint64_t, UINT >::const_iterator it = Table.lower_bound( Hash );
+          it != Table.end() && it->first == Hash; ++it
+        )
+    {
+        const ListJob& Sub = Subs[ it->second ];
+
+        if ( Sub.size() == Block.size() + 1 && SameRecords( Sub.data(), Block.data(), Block.size() ) )
+        {
+            return it->second;
+
+        }
+
+    }
+
+    if ( First + Subs.size() >= SubIndices ) return SubIndices;
+
+    Subs.push_back( Block );
+    Subs.back().push_back( ListMake( OpListReturn ) );
+    Table.insert( std::make_pair( Hash, (UINT) Subs.size() - 1 ) );
+    Stats.SubRecords += Subs.back().size();
+
+    return (UINT) Subs.size() - 1;
+
+}
+
+//  Compile
+//
+//  Description:
+//
+//  Appends In to Out with repeated blocks replaced by subroutine calls.
+//  The subroutines are collected in the compiler and loaded by LoadSubs.
+//
+//      Parameter   Meaning
+//
+//      In          job with absolute vectors (jump_abs, mark_abs)
+//      Out         compiled job
+//
+//      set_offset_list and set_matrix_list of In for the head of the
+//      compiler move the records following them. They are taken into the
+//      offset and matrix emitted with these records, those for head 0
+//      (both heads) are copied as well. In starts at the defaults.
+//
+
+UINT SubCompiler::Compile( const ListJob& In, ListJob& Out )
+{
+    const size_t OutSize = Out.size();
+    std::vector< SubItem >  Items;
+    std::vector< UINT >     Count;
+    std::multimap< uint64_t, UINT > Reps;
+    ListJob Block, Other;
+    LONG    InOffset[ 2 ] = { 0, 0 };               //  set_offset_list of In so far
+    double  InMatrix[ 4 ] = { 1.0, 0.0, 0.0, 1.0 }; //  set_matrix_list of In so far
+
+    //  Split into blocks and count equal blocks
+    for ( size_t i = 0; i < In.size(); )
+    {
+        SubItem Item;
+        Item.Begin = i;
+        Item.Block = In[ i ].Op == OpJumpAbs;
+        Item.X     = In[ i ].I[ 0 ];
+        Item.Y     = In[ i ].I[ 1 ];
+        Item.Rep   = (UINT) Items.size();
+
+        LONG x = Item.X, y = Item.Y;
+        i++;
+
+        while ( Item.Block && i < In.size() )
+        {
+            const ListCommand& c = In[ i ];
+
+            if (   c.Op != OpMarkAbs
+                && ( c.Op != OpJumpAbs || labs( c.I[ 0 ] - x ) > BlockGap || labs( c.I[ 1 ] - y ) > BlockGap )
+               )
+            {
+                break;
+
+            }
+
+            x = c.I[ 0 ];
+            y = c.I[ 1 ];
+            i++;
+
+        }
+
+        Item.End = i;
+
+        if ( Item.Block )
+        {
+            Stats.Blocks++;
+            Normalize( In, Item, Block );
+            const uint64_t Hash = ListHash( Block.data(), Block.size() );
+
+            for ( std::multimap< uint64_t, UINT >::const_iterator it = Reps.lower_bound( Hash );
+                  it != Reps.end() && it->first == Hash; ++it
+                )
+            {
+                const SubItem& r = Items[ it->second ];
+
+                if ( r.End - r.Begin != Block.size() ) continue;
+
+                Normalize( In, r, Other );
+
+                if ( SameRecords( Other.data(), Block.data(), Block.size() ) )
+                {
+                    Item.Rep = it->second;
+                    break;
+
+                }
+
+            }
+
+            if ( Item.Rep == Items.size() ) Reps.insert( std::make_pair( Hash, Item.Rep ) );
+
+        }
+
+        Items.push_back( Item );
+        Count.push_back( 0 );
+        Count[ Item.Rep ]++;
+
+    }
+
+    //  Emit
+    for ( size_t k = 0; k < Items.size(); k++ )
+    {
+        const SubItem&     Item = Items[ k ];
+        const ListCommand& c    = In[ Item.Begin ];
+
+        if ( !Item.Block && ( c.Op == OpSetOffset || c.Op == OpSetMatrix ) && ( c.Arg == Head || !c.Arg ) )
+        {
+            ApplyTransform( c, InOffset, InMatrix );
+
+            if ( c.Arg == Head ) continue;          //  emitted with the next records
+
+            ApplyTransform( c, Offset, Matrix );
+            Out.push_back( c );
+            continue;
+
+        }
+
+        if ( Item.Block && Count[ Item.Rep ] > 1 && Item.End - Item.Begin >= MinRecords )
+        {
+            Normalize( In, Item, Block );
+            const UINT Index = Intern( Block );
+
+            if ( Index < SubIndices )
+            {
+                //  The block at the origin, moved to Item.X, Item.Y before the matrix of In
+                const double* m = InMatrix;
+
+                SetMatrix( m[ 0 ], m[ 1 ], m[ 2 ], m[ 3 ], Out );
+                SetOffset( InOffset[ 0 ] + (LONG) floor( m[ 0 ] * Item.X + m[ 1 ] * Item.Y + 0.5 ),
+                           InOffset[ 1 ] + (LONG) floor( m[ 2 ] * Item.X + m[ 3 ] * Item.Y + 0.5 ), Out );
+                Out.push_back( ListMake( OpSubCall, First + Index ) );
+                Stats.Instances++;
+                continue;
+
+            }
+
+        }
+
+        //  Inline, with offset and matrix of In
+        SetOffset( InOffset[ 0 ], InOffset[ 1 ], Out );
+        SetMatrix( InMatrix[ 0 ], InMatrix[ 1 ], InMatrix[ 2 ], InMatrix[ 3 ], Out );
+        Out.insert( Out.end(), In.begin() + Item.Begin, In.begin() + Item.End );
+
+    }
+
+    Stats.InRecords  += In.size();
+    Stats.OutRecords += Out.size() - OutSize;
+    Finish( Out );
+
+    return SubNoError;
+
+}
+
+//  Instance
+//
+//  Description:
+//
+//  Appends a rotated and scaled copy of Block to Out.
+//
+//      Parameter   Meaning
+//
+//      Block       absolute vectors around the origin
+//      X, Y        position of the origin of the copy [bits]
+//      Angle       rotation [rad], counter-clockwise
+//      Scale       scale factor
+//
+
+UINT SubCompiler::Instance( const ListJob& Block, LONG X, LONG Y, double Angle, double Scale, ListJob& Out )
+{
+    const UINT Index = Intern( Block );
+
+    if ( Index >= SubIndices ) return SubRangeError;
+
+    const size_t OutSize = Out.size();
+    const double c = Scale * cos( Angle );
+    const double s = Scale * sin( Angle );
+
+    SetMatrix( c, -s, s, c, Out );
+    SetOffset( X, Y, Out );
+    Out.push_back( ListMake( OpSubCall, First + Index ) );
+
+    Stats.Instances++;
+    Stats.InRecords  += Block.size();
+    Stats.OutRecords += Out.size() - OutSize;
+
+    return SubNoError;
+
+}
+
+//  LoadSubs
+//
+//  Description:
+//
+//  Loads all subroutines into the protected list memory area by load_sub.
+//  The next list commands are appended to the last subroutine, call
+//  set_start_list or load_list before loading further lists.
+//
+
+UINT SubCompiler::LoadSubs() const
+{
+    const UINT Error = get_last_error();
+
+    for ( size_t i = 0; i < Subs.size(); i++ )
+    {
+        load_sub( First + (UINT) i );
+        ListReplay( Subs[ i ].data(), Subs[ i ].size() );
+
+    }
+
+    return get_last_error() & ~Error ? SubCardError : SubNoError;
+
+}
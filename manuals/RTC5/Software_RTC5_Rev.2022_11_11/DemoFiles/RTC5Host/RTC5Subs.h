@@ -0,0 +1,79 @@
+//  File
+//      RTC5Subs.h
+//
+//  Abstract
+//      Subroutine deduplication for repetitive jobs.
+//      The SubCompiler splits a job into geometry blocks (a jump_abs and the
+//      vectors following it up to the next long jump), stores every block
+//      occurring more than once a single time as a subroutine and replaces
+//      each occurrence by set_offset_list and sub_call. Rotated or scaled
+//      copies of a block are added by Instance with set_matrix_list.
+//      LoadSubs transfers the subroutines by load_sub.
+//
+//  Comment
+//      Blocks are compared after moving their first jump to the origin, the
+//      hash (ListHash) only preselects, equal blocks are compared record by
+//      record. set_offset_list and set_matrix_list of the input move the
+//      blocks following them, their sub_call gets both combined. The output
+//      job leaves offset and matrix at their defaults.
+//
+//  Necessary Sources
+//      RTC5Subs.h, RTC5Subs.cpp, RTC5List.h, RTC5List.cpp, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+#include "RTC5List.h"
+
+//  Error codes of the subroutine compiler
+const UINT   SubNoError           =            0;
+const UINT   SubRangeError        =            1;   //  no subroutine index left
+const UINT   SubCardError         =            2;   //  RTC5 error while loading, see get_last_error
+
+const UINT   SubIndices           =         1024;   //  subroutine table of the RTC5
+
+struct SubStats
+{
+    size_t   InRecords;         //  records of the input jobs
+    size_t   OutRecords;        //  records of the output jobs
+    size_t   SubRecords;        //  records of all subroutines
+    UINT     Blocks;            //  geometry blocks found
+    UINT     Instances;         //  blocks replaced by sub_call
+
+};
+
+class SubCompiler
+{
+public:
+    SubCompiler( UINT FirstSub = 0, UINT HeadNo = 1 );
+
+    UINT Compile( const ListJob& In, ListJob& Out );
+    UINT Instance( const ListJob& Block, LONG X, LONG Y, double Angle, double Scale, ListJob& Out );
+    void Finish( ListJob& Out );            //  offset and matrix back to defaults
+
+    UINT LoadSubs() const;
+    UINT SubCount() const { return (UINT) Subs.size(); }
+    const ListJob& Sub( UINT Index ) const { return Subs[ Index ]; }   //  records of subroutine First + Index
+
+    LONG     BlockGap;          //  a longer jump starts a new block [bits]
+    UINT     MinRecords;        //  shorter blocks are kept inline
+    SubStats Stats;
+
+private:
+    UINT Intern( const ListJob& Block );    //  subroutine index, SubIndices if full
+    void SetOffset( LONG X, LONG Y, ListJob& Out );
+    void SetMatrix( double M11, double M12, double M21, double M22, ListJob& Out );
+
+    std::vector< ListJob >                       Subs;
+    std::multimap< uint64_t, UINT >              Table;     //  ListHash -> Subs
+    UINT     First;
+    UINT     Head;
+    LONG     Offset[ 2 ];       //  current set_offset_list of the output
+    double   Matrix[ 4 ];       //  current set_matrix_list of the output
+
+};
@@ -0,0 +1,742 @@
+//  File
+//      RTC5Tile.cpp
+//
+//  Abstract
+//      Tiling of jobs larger than the scan field
+//
+//  Comment
+//      Tile Column, Row covers the job coordinates from GridX + Column *
+//      TileSize on up to the next tile, likewise in y. Its center is
+//      rounded to whole bits, the vectors of the tile are shifted by it and
+//      clipped by a FieldClipper to the bits of the tile, so a vector
+//      crossing a border is marked in both tiles up to their borders.
+//      The index holds the tiles a mark crosses, walked column by column
+//      along the mark, and the tiles of the bounding box of an arc's
+//      circle. It is counted first and then filled, like the band index of
+//      the SliceEngine.
+//      A parameter command is kept per kind: Op, and the channel for
+//      write_da_x_list. At a vector the last command of each kind before it
+//      is in effect, found by binary search in the list of the kind.
+//
+//  Necessary Sources
+//      RTC5Tile.h, RTC5Clip.h, RTC5Feeder.h, RTC5List.h, RTC5Util.h,
+//      RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "RTC5Clip.h"
+#include "RTC5Tile.h"
+#include "RTC5Util.h"
+
+static const size_t MaxAhead             =            2;   //  tiles prepared ahead of the writer per thread
+static const double MaxTile              =    1048574.0;   //  [bits] the field around the center of a tile
+static const UINT   MaxPasses            =          100;   //  of 2-opt
+static const uint32_t None               =   0xFFFFFFFF;
+
+//  Commands carried into the tiles
+static bool IsParameter( UINT Op )
+{
+    switch ( Op )
+    {
+    case OpSetJumpSpeed:
+    case OpSetMarkSpeed:
+    case OpSetScannerDelays:
+    case OpSetLaserDelays:
+    case OpSetLaserPulses:
+    case OpSetFirstPulseKiller:
+    case OpWriteDaX:
+    case OpSetDelayMode:
+    case OpSetSkyWritingPara:
+    case OpSetSkyWritingMode:
+    case OpSetSkyWritingLimit:
+    case OpSetDefocus:
+        return true;
+
+    default:
+        return false;
+
+    }
+
+}
+
+static uint32_t Kind( const ListCommand& c )
+{
+    return c.Op == OpWriteDaX ? c.Op | (uint32_t) c.Arg << 16 : c.Op;
+
+}
+
+static int32_t Round( double v )
+{
+    return (int32_t) floor( v + 0.5 );
+
+}
+
+//  Prepares the tiles of one worker
+
+class TilePrepare
+{
+public:
+    TilePrepare( const TileEngine& Engine );
+
+    void     Tile( UINT k, ListJob& Out );
+
+    uint64_t Clipped;
+
+private:
+    TilePrepare( const TilePrepare& );
+    TilePrepare& operator=( const TilePrepare& );
+
+    void     Parameters( uint32_t Before );
+
+    const TileEngine& e;
+    FieldClipper Clipper;
+    ListJob  Local;
+    std::vector< uint32_t > Emitted;                //  per kind, None: not yet in the tile
+    std::vector< uint32_t > Changed;
+
+};
+
+TilePrepare::TilePrepare( const TileEngine& Engine )
+    : Clipped( 0 ), e( Engine )
+{
+}
+
+//  The parameters in effect before parameter command Before, as far as
+//  they differ from those in the tile
+void TilePrepare::Parameters( uint32_t Before )
+{
+    Changed.clear();
+
+    for ( size_t k = 0; k < e.Kinds.size(); k++ )
+    {
+        const std::vector< uint32_t >& List = e.Kinds[ k ];
+        const std::vector< uint32_t >::const_iterator i = std::lower_bound( List.begin(), List.end(), Before );
+
+        if ( i == List.begin() ) continue;
+
+        const uint32_t p = *( i - 1 );
+
+        if ( p == Emitted[ k ] ) continue;
+
+        if (   Emitted[ k ] == None
+            || memcmp( &e.Parameters[ p ], &e.Parameters[ Emitted[ k ] ], sizeof( ListCommand ) )
+           )
+        {
+            Changed.push_back( p );
+
+        }
+
+        Emitted[ k ] = p;
+
+    }
+
+    std::sort( Changed.begin(), Changed.end() );
+
+    for ( size_t i = 0; i < Changed.size(); i++ ) Local.push_back( e.Parameters[ Changed[ i ] ] );
+
+}
+
+//  Tile
+//
+//  Description:
+//
+//  Writes tile k of the order to Out: the stage move, the parameters and
+//  the vectors of the tile clipped to it, relative to its center.
+//
+
+void TilePrepare::Tile( UINT k, ListJob& Out )
+{
+    const UINT t = e.Order[ k ];
+    LONG C[ 2 ], Pos[ 2 ], From[ 2 ];
+
+    e.Center( t, C );
+    e.StagePosition( t, Pos );
+
+    if ( k ) e.StagePosition( e.Order[ k - 1 ], From );
+
+    if ( !k || Pos[ 0 ] != From[ 0 ] || Pos[ 1 ] != From[ 1 ] )
+    {
+        Out.push_back( ListMake( OpStepperAbs, Pos[ 0 ], Pos[ 1 ] ) );
+
+        for ( UINT m = 0; m < 2; m++ )
+        {
+            if ( !k || Pos[ m ] != From[ m ] ) Out.push_back( ListMake( OpStepperWait, m + 1 ) );
+
+        }
+
+    }
+
+    //  The vectors of the tile relative to its center
+    Local.clear();
+    Emitted.assign( e.Kinds.size(), None );
+
+    uint32_t Before = None;
+    bool     Pen = false;
+    int32_t  PenX = 0, PenY = 0, PenZ = 0;
+
+    for ( uint32_t i = e.TileStart[ t ]; i < e.TileStart[ t + 1 ]; i++ )
+    {
+        const uint32_t v = e.TileVectors[ i ];
+        const TileEngine::Vector& m = e.Marks[ v ];
+        ListCommand c = e.Job[ v ];
+        const bool Is3D = c.Op == OpMarkAbs3D;
+
+        if ( m.Parameters != Before )
+        {
+            Parameters( m.Parameters );
+            Before = m.Parameters;
+
+        }
+
+        if ( !Pen || m.X0 != PenX || m.Y0 != PenY || ( Is3D && m.Z0 != PenZ ) )
+        {
+            Local.push_back( ListMake( Is3D ? OpJumpAbs3D : OpJumpAbs, m.X0 - C[ 0 ], m.Y0 - C[ 1 ], Is3D ? m.Z0 : 0 ) );
+
+        }
+
+        c.I[ 0 ] -= C[ 0 ];
+        c.I[ 1 ] -= C[ 1 ];
+        Local.push_back( c );
+
+        Pen  = true;
+        PenX = m.X1;
+        PenY = m.Y1;
+        PenZ = Is3D ? c.I[ 2 ] : m.Z0;
+
+    }
+
+    //  Clipped to the bits of the tile
+    const UINT Column = t % e.Columns, Row = t / e.Columns;
+
+    Clipper.Field[ 0 ] = (LONG) ceil( e.GridX + Column * (double) e.TileSize ) - C[ 0 ];
+    Clipper.Field[ 1 ] = (LONG) ceil( e.GridY + Row * (double) e.TileSize ) - C[ 1 ];
+    Clipper.Field[ 2 ] = (LONG) ceil( e.GridX + ( Column + 1 ) * (double) e.TileSize ) - 1 - C[ 0 ];
+    Clipper.Field[ 3 ] = (LONG) ceil( e.GridY + ( Row + 1 ) * (double) e.TileSize ) - 1 - C[ 1 ];
+
+    Clipper.Reset();
+    Clipper.Clip( Local.data(), Local.size(), Out );
+    Clipped += Clipper.Clipped;
+
+}
+
+//  TileEngine
+
+TileEngine::TileEngine()
+    : TileSize( 800000 ), OriginX( 0.0 ), OriginY( 0.0 ), Optimize( true ), Threads( 0 ),
+      Columns( 0 ), Rows( 0 ), Tiles( 0 ), Vectors( 0 ), Entries( 0 ), Skipped( 0 ), Travel( 0.0 ),
+      SerpentineTravel( 0.0 ), PlanTime( 0.0 ),
+      Records( 0 ), Clipped( 0 ), FeedError( FeedNoError ), FirstTileTime( 0.0 ), WriteTime( 0.0 ),
+      GridX( 0.0 ), GridY( 0.0 )
+{
+    for ( UINT m = 0; m < 2; m++ )
+    {
+        StageScale[ m ]    = 0.01;
+        StageHome[ m ]     = 0;
+        StepperPeriod[ m ] = 100;
+
+    }
+
+}
+
+void TileEngine::Center( UINT Tile, LONG* C ) const
+{
+    C[ 0 ] = Round( GridX + ( Tile % Columns + 0.5 ) * TileSize );
+    C[ 1 ] = Round( GridY + ( Tile / Columns + 0.5 ) * TileSize );
+
+}
+
+void TileEngine::StagePosition( UINT Tile, LONG* Pos ) const
+{
+    LONG C[ 2 ];
+    Center( Tile, C );
+
+    for ( UINT m = 0; m < 2; m++ ) Pos[ m ] = StageHome[ m ] + Round( C[ m ] * StageScale[ m ] );
+
+}
+
+//  Travel time [s] of the stage, both motors at once
+double TileEngine::Move( const LONG* From, const LONG* To ) const
+{
+    double t = 0.0;
+
+    for ( UINT m = 0; m < 2; m++ ) t = std::max( t, fabs( (double) To[ m ] - From[ m ] ) * StepperPeriod[ m ] * 1e-6 );
+
+    return t;
+
+}
+
+double TileEngine::PathTravel( const std::vector< UINT >& Path ) const
+{
+    LONG   At[ 2 ] = { StageHome[ 0 ], StageHome[ 1 ] };
+    double t = 0.0;
+
+    for ( size_t i = 0; i < Path.size(); i++ )
+    {
+        LONG To[ 2 ];
+        StagePosition( Path[ i ], To );
+        t += Move( At, To );
+        At[ 0 ] = To[ 0 ];
+        At[ 1 ] = To[ 1 ];
+
+    }
+
+    return t;
+
+}
+
+//  Index
+//
+//  Description:
+//
+//  Counts vector v in the tiles it may cross (Fill NULL) or enters it there
+//  at the Cursor of the tile. A mark is walked column by column, the rows
+//  of a column are those of its part in the column, widened by one bit.
+//
+
+void TileEngine::Index( uint32_t v, uint32_t* Cursor, uint32_t* Fill ) const
+{
+    const Vector&      m = Marks[ v ];
+    const ListCommand& c = Job[ v ];
+    const double       T = TileSize;
+
+    auto Column = [ & ]( double x ) { return (UINT) std::min( std::max( floor( ( x - GridX ) / T ), 0.0 ), Columns - 1.0 ); };
+    auto Row    = [ & ]( double y ) { return (UINT) std::min( std::max( floor( ( y - GridY ) / T ), 0.0 ), Rows - 1.0 ); };
+    auto Enter  = [ & ]( UINT i, UINT j )
+    {
+        const UINT t = i + Columns * j;
+
+        if ( Fill ) Fill[ Cursor[ t ]++ ] = v;
+        else        Cursor[ t ]++;
+
+    };
+
+    if ( c.Op == OpArcAbs )
+    {
+        const double r = hypot( (double) m.X0 - c.I[ 0 ], (double) m.Y0 - c.I[ 1 ] ) + 1.0;
+
+        for ( UINT j = Row( c.I[ 1 ] - r ); j <= Row( c.I[ 1 ] + r ); j++ )
+        {
+            for ( UINT i = Column( c.I[ 0 ] - r ); i <= Column( c.I[ 0 ] + r ); i++ ) Enter( i, j );
+
+        }
+
+        return;
+
+    }
+
+    const double x0 = std::min( m.X0, m.X1 ), x1 = std::max( m.X0, m.X1 );
+
+    for ( UINT i = Column( x0 ); i <= Column( x1 ); i++ )
+    {
+        double ya = m.Y0, yb = m.Y1;
+
+        if ( m.X1 != m.X0 )
+        {
+            const double xa = std::max( x0, GridX + i * T ), xb = std::min( x1, GridX + ( i + 1 ) * T );
+            const double s  = ( (double) m.Y1 - m.Y0 ) / ( (double) m.X1 - m.X0 );
+            ya = m.Y0 + ( xa - m.X0 ) * s;
+            yb = m.Y0 + ( xb - m.X0 ) * s;
+
+        }
+
+        for ( UINT j = Row( std::min( ya, yb ) - 1.0 ); j <= Row( std::max( ya, yb ) + 1.0 ); j++ ) Enter( i, j );
+
+    }
+
+}
+
+//  Plan
+//
+//  Description:
+//
+//  Takes over the job, builds the grid over its vectors and the index of
+//  the tiles and orders the tiles with vectors. The job is copied, it
+//  need not stay valid.
+//
+//      Return                  Meaning
+//
+//      TileNoError             planned, Tiles may be 0
+//      TileRangeError          TileSize not positive or beyond the field,
+//                              a StepperPeriod 0
+//
+
+UINT TileEngine::Plan( const ListCommand* Cmd, size_t Count )
+{
+    const auto t0 = std::chrono::steady_clock::now();
+
+    Job.clear();
+    Marks.clear();
+    Parameters.clear();
+    Kinds.clear();
+    Order.clear();
+    TileStart.clear();
+    TileVectors.clear();
+    Columns = Rows = Tiles = 0;
+    Vectors = Entries = Skipped = 0;
+    Travel  = SerpentineTravel = PlanTime = 0.0;
+
+    if ( TileSize <= 0 || TileSize > MaxTile || !StepperPeriod[ 0 ] || !StepperPeriod[ 1 ] ) return TileRangeError;
+
+    //  Marks and arcs made absolute, the parameters sorted by kind
+    std::vector< uint32_t > Keys;
+    int32_t PenX = 0, PenY = 0, PenZ = 0;
+    double  Box[ 4 ] = { HUGE_VAL, HUGE_VAL, -HUGE_VAL, -HUGE_VAL };
+
+    for ( size_t i = 0; i < Count; i++ )
+    {
+        ListCommand c = Cmd[ i ];
+        Vector m;
+        m.X0 = PenX;
+        m.Y0 = PenY;
+        m.Z0 = PenZ;
+        m.Parameters = (uint32_t) Parameters.size();
+
+        switch ( c.Op )
+        {
+        case OpJumpAbs:     PenX = c.I[ 0 ];  PenY = c.I[ 1 ];                          continue;
+        case OpJumpRel:     PenX += c.I[ 0 ]; PenY += c.I[ 1 ];                         continue;
+        case OpJumpAbs3D:   PenX = c.I[ 0 ];  PenY = c.I[ 1 ]; PenZ = c.I[ 2 ];         continue;
+
+        case OpMarkRel:
+            c.Op = OpMarkAbs;
+            c.I[ 0 ] += PenX;
+            c.I[ 1 ] += PenY;
+
+        //  fall through
+        case OpMarkAbs:
+        case OpMarkAbs3D:
+            m.X1 = c.I[ 0 ];
+            m.Y1 = c.I[ 1 ];
+            if ( c.Op == OpMarkAbs3D ) PenZ = c.I[ 2 ];
+
+            Box[ 0 ] = std::min( Box[ 0 ], (double) std::min( m.X0, m.X1 ) );
+            Box[ 1 ] = std::min( Box[ 1 ], (double) std::min( m.Y0, m.Y1 ) );
+            Box[ 2 ] = std::max( Box[ 2 ], (double) std::max( m.X0, m.X1 ) );
+            Box[ 3 ] = std::max( Box[ 3 ], (double) std::max( m.Y0, m.Y1 ) );
+            break;
+
+        case OpArcRel:
+            c.Op = OpArcAbs;
+            c.I[ 0 ] += PenX;
+            c.I[ 1 ] += PenY;
+
+        //  fall through
+        case OpArcAbs:
+        {
+            //  Clockwise by Angle around the center
+            const double a  = c.D[ 0 ] * Pi / 180.0;
+            const double vX = (double) PenX - c.I[ 0 ], vY = (double) PenY - c.I[ 1 ];
+            const double r  = hypot( vX, vY );
+            m.X1 = Round( c.I[ 0 ] + vX * cos( a ) + vY * sin( a ) );
+            m.Y1 = Round( c.I[ 1 ] + vY * cos( a ) - vX * sin( a ) );
+
+            Box[ 0 ] = std::min( Box[ 0 ], c.I[ 0 ] - r );
+            Box[ 1 ] = std::min( Box[ 1 ], c.I[ 1 ] - r );
+            Box[ 2 ] = std::max( Box[ 2 ], c.I[ 0 ] + r );
+            Box[ 3 ] = std::max( Box[ 3 ], c.I[ 1 ] + r );
+            break;
+
+        }
+
+        case OpTextData:
+            continue;
+
+        default:
+        {
+            if ( !IsParameter( c.Op ) )
+            {
+                Skipped++;
+                continue;
+
+            }
+
+            const size_t k = std::find( Keys.begin(), Keys.end(), Kind( c ) ) - Keys.begin();
+
+            if ( k == Keys.size() )
+            {
+                Keys.push_back( Kind( c ) );
+                Kinds.resize( Keys.size() );
+
+            }
+
+            Kinds[ k ].push_back( (uint32_t) Parameters.size() );
+            Parameters.push_back( c );
+            continue;
+
+        }
+
+        }
+
+        Job.push_back( c );
+        Marks.push_back( m );
+        PenX = m.X1;
+        PenY = m.Y1;
+
+    }
+
+    Vectors = Marks.size();
+
+    if ( !Vectors )
+    {
+        PlanTime = Seconds( t0 );
+        return TileNoError;
+
+    }
+
+    //  The grid aligned to the origin, the index counted and filled
+    const double T = TileSize;
+    GridX   = OriginX + floor( ( Box[ 0 ] - OriginX ) / T ) * T;
+    GridY   = OriginY + floor( ( Box[ 1 ] - OriginY ) / T ) * T;
+    Columns = (UINT) floor( ( Box[ 2 ] - GridX ) / T ) + 1;
+    Rows    = (UINT) floor( ( Box[ 3 ] - GridY ) / T ) + 1;
+
+    std::vector< uint32_t > Cursor( (size_t) Columns * Rows + 1, 0 );
+
+    for ( uint32_t v = 0; v < Vectors; v++ ) Index( v, Cursor.data(), 0 );
+
+    TileStart.assign( Cursor.size(), 0 );
+
+    for ( size_t t = 0; t + 1 < Cursor.size(); t++ )
+    {
+        TileStart[ t + 1 ] = TileStart[ t ] + Cursor[ t ];
+        Cursor[ t ] = TileStart[ t ];
+        if ( TileStart[ t + 1 ] > TileStart[ t ] ) Tiles++;
+
+    }
+
+    TileVectors.resize( TileStart.back() );
+    Entries = TileVectors.size();
+
+    for ( uint32_t v = 0; v < Vectors; v++ ) Index( v, Cursor.data(), TileVectors.data() );
+
+    //  Serpentine: rows from the bottom, every other row from the right
+    for ( UINT j = 0; j < Rows; j++ )
+    {
+        for ( UINT n = 0; n < Columns; n++ )
+        {
+            const UINT t = ( j & 1 ? Columns - 1 - n : n ) + Columns * j;
+            if ( TileStart[ t + 1 ] > TileStart[ t ] ) Order.push_back( t );
+
+        }
+
+    }
+
+    SerpentineTravel = PathTravel( Order );
+
+    if ( Optimize )
+    {
+        //  Nearest neighbour from home on
+        const size_t n = Order.size();
+        std::vector< LONG > P( 2 * n );
+
+        for ( size_t i = 0; i < n; i++ ) StagePosition( Order[ i ], &P[ 2 * i ] );
+
+        std::vector< UINT > Path;
+        std::vector< uint8_t > Used( n, 0 );
+        LONG At[ 2 ] = { StageHome[ 0 ], StageHome[ 1 ] };
+
+        for ( size_t s = 0; s < n; s++ )
+        {
+            size_t Best = n;
+            double BestTime = HUGE_VAL;
+
+            for ( size_t i = 0; i < n; i++ )
+            {
+                if ( Used[ i ] ) continue;
+
+                const double d = Move( At, &P[ 2 * i ] );
+
+                if ( d < BestTime )
+                {
+                    BestTime = d;
+                    Best     = i;
+
+                }
+
+            }
+
+            Used[ Best ] = 1;
+            Path.push_back( (UINT) Best );
+            At[ 0 ] = P[ 2 * Best ];
+            At[ 1 ] = P[ 2 * Best + 1 ];
+
+        }
+
+        //  2-opt on the open path, its start fixed at home
+        const LONG Home[ 2 ] = { StageHome[ 0 ], StageHome[ 1 ] };
+        auto Pos = [ & ]( size_t i ) { return &P[ 2 * Path[ i ] ]; };
+        bool Better = true;
+
+        for ( UINT Pass = 0; Better && Pass < MaxPasses; Pass++ )
+        {
+            Better = false;
+
+            for ( size_t i = 0; i < n; i++ )
+            {
+                const LONG* Prev = i ? Pos( i - 1 ) : Home;
+
+                for ( size_t j = i + 1; j < n; j++ )
+                {
+                    double d = Move( Prev, Pos( j ) ) - Move( Prev, Pos( i ) );
+                    if ( j + 1 < n ) d += Move( Pos( i ), Pos( j + 1 ) ) - Move( Pos( j ), Pos( j + 1 ) );
+
+                    if ( d < -1e-9 )
+                    {
+                        std::reverse( Path.begin() + i, Path.begin() + j + 1 );
+                        Better = true;
+
+                    }
+
+                }
+
+            }
+
+        }
+
+        std::vector< UINT > Planned( n );
+        for ( size_t i = 0; i < n; i++ ) Planned[ i ] = Order[ Path[ i ] ];
+        Order.swap( Planned );
+
+    }
+
+    Travel   = PathTravel( Order );
+    PlanTime = Seconds( t0 );
+
+    return TileNoError;
+
+}
+
+//  Run
+//
+//  Description:
+//
+//  Writes the tiles in the planned order to Out or feeds them to the
+//  ListFeeder while the following tiles are prepared.
+//
+//      Return                  Meaning
+//
+//      TileNoError             all tiles written
+//      TileRangeError          not planned
+//      TileFeedError           the ListFeeder failed with FeedError
+//
+
+UINT TileEngine::Run( ListJob& Out )
+{
+    return Run( &Out, 0 );
+
+}
+
+UINT TileEngine::Run( ListFeeder& Feeder )
+{
+    return Run( 0, &Feeder );
+
+}
+
+UINT TileEngine::Run( ListJob* Out, ListFeeder* Feeder )
+{
+    Records   = Clipped = 0;
+    FeedError = FeedNoError;
+    FirstTileTime = WriteTime = 0.0;
+
+    if ( Vectors && TileStart.empty() ) return TileRangeError;
+    if ( TileSize <= 0 || TileSize > MaxTile ) return TileRangeError;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const UINT n  = std::max( 1u, Threads ? Threads : std::thread::hardware_concurrency() );
+    const UINT Count = (UINT) Order.size();
+
+    //  Tiles prepared by the workers, written here in their order
+    const UINT w = std::min( n, std::max( Count, 1u ) );
+
+    std::vector< ListJob > Blocks( Count );
+    std::vector< uint8_t > Done( Count, 0 );
+    std::mutex Lock;
+    std::condition_variable Ready, Room;
+    std::atomic< UINT > Next( 0 );
+    size_t Written = 0;
+    bool   Abort = false;
+
+    auto Work = [ & ]()
+    {
+        TilePrepare p( *this );
+
+        for ( UINT k; ( k = Next++ ) < Count; )
+        {
+            {
+                std::unique_lock< std::mutex > Guard( Lock );
+                Room.wait( Guard, [ & ]() { return Abort || k < Written + MaxAhead * w; } );
+                if ( Abort ) break;
+
+            }
+
+            ListJob Block;
+            p.Tile( k, Block );
+
+            std::lock_guard< std::mutex > Guard( Lock );
+            Blocks[ k ].swap( Block );
+            Done[ k ] = 1;
+            Ready.notify_one();
+
+        }
+
+        std::lock_guard< std::mutex > Guard( Lock );
+        Clipped += p.Clipped;
+
+    };
+
+    std::vector< std::thread > Workers;
+    for ( UINT t = 0; t < w && Count; t++ ) Workers.push_back( std::thread( Work ) );
+
+    UINT Error = TileNoError;
+
+    for ( UINT k = 0; k < Count && !FeedError; k++ )
+    {
+        ListJob Block;
+
+        {
+            std::unique_lock< std::mutex > Guard( Lock );
+            Ready.wait( Guard, [ & ]() { return Done[ k ] != 0; } );
+            Block.swap( Blocks[ k ] );
+
+        }
+
+        if ( Out ) Out->insert( Out->end(), Block.begin(), Block.end() );
+
+        if ( Feeder && !Block.empty() ) FeedError = Feeder->Feed( Block.data(), Block.size() );
+
+        Records += Block.size();
+        if ( k == 0 ) FirstTileTime = Seconds( t0 );
+
+        std::lock_guard< std::mutex > Guard( Lock );
+        Written = k + 1;
+        Room.notify_all();
+
+    }
+
+    if ( FeedError )
+    {
+        std::lock_guard< std::mutex > Guard( Lock );
+        Error = TileFeedError;
+        Abort = true;
+        Room.notify_all();
+
+    }
+
+    for ( size_t t = 0; t < Workers.size(); t++ ) Workers[ t ].join();
+
+    WriteTime = Seconds( t0 );
+    if ( !Count ) FirstTileTime = WriteTime;
+
+    return Error;
+
+}
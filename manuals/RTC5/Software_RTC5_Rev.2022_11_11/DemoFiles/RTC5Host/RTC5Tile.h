@@ -0,0 +1,117 @@
+//  File
+//      RTC5Tile.h
+//
+//  Abstract
+//      Tiling of jobs larger than the scan field.
+//      A TileEngine lays a grid of square tiles over a job in job
+//      coordinates, indexes its vectors per tile and orders the tiles to
+//      keep the stage travel short. Each tile is written as a stage move by
+//      stepper_abs_list and stepper_wait followed by the vectors of the
+//      tile, clipped to it and shifted to the field center. The tiles are
+//      prepared by worker threads ahead of the one being written, so tile
+//      N + 1 is ready while tile N marks.
+//
+//  Comment
+//      Stage position of a tile: StageHome + StageScale * center of the
+//      tile in job coordinates, i.e. at StageHome the job origin lies
+//      under the field center. The sign of StageScale gives the direction
+//      of an axis.
+//      The job holds vectors (jump, mark, arc, 2D and 3D, absolute or
+//      relative) and the speed, delay, laser, sky writing and defocus
+//      commands. Each tile starts with the parameters in effect at its
+//      first vector, a parameter changing between two vectors of a tile is
+//      repeated there. All other commands are not tiled and counted as
+//      Skipped.
+//      The tiles are ordered by nearest neighbour from StageHome on and
+//      improved by 2-opt, the travel time of a move is that of the slower
+//      motor.
+//
+//  Necessary Sources
+//      RTC5Tile.h, RTC5Tile.cpp, RTC5Clip.h, RTC5Clip.cpp, RTC5Feeder.h,
+//      RTC5Feeder.cpp, RTC5Hatch.h, RTC5List.h, RTC5List.cpp, RTC5Util.h,
+//      RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "RTC5Feeder.h"
+#include "RTC5List.h"
+
+//  Error codes of the tiler
+const UINT   TileNoError          =            0;
+const UINT   TileRangeError       =            1;   //  no plan, tile size not positive or beyond the field
+const UINT   TileFeedError        =            2;   //  ListFeeder error, see TileEngine::FeedError
+
+class TileEngine
+{
+public:
+    TileEngine();
+
+    UINT     Plan( const ListCommand* Cmd, size_t Count );  //  index the job and order the tiles
+    UINT     Run( ListJob& Out );
+    UINT     Run( ListFeeder& Feeder );             //  opened by the caller, not finished
+    void     StagePosition( UINT Tile, LONG* Pos ) const;   //  [steps] of tile Column + Columns * Row
+
+    //  Settings, read by Plan
+    LONG     TileSize;                              //  [bits] edge of a tile, at most the field
+    double   OriginX, OriginY;                      //  [bits] a corner of the grid in job coordinates
+    double   StageScale[ 2 ];                       //  [steps/bit] of stepper motor 1 and 2
+    LONG     StageHome[ 2 ];                        //  [steps] the job origin under the field center
+    UINT     StepperPeriod[ 2 ];                    //  [us] per step, as passed to stepper_init
+    bool     Optimize;                              //  false: rows in serpentine order, for comparison
+
+    //  Settings, read by Run
+    UINT     Threads;                               //  0: one per processor
+
+    //  Results of Plan
+    UINT     Columns, Rows;                         //  of the grid
+    UINT     Tiles;                                 //  with vectors
+    uint64_t Vectors;                               //  marks and arcs indexed
+    uint64_t Entries;                               //  in the index, a vector per tile it crosses
+    uint64_t Skipped;                               //  commands not tiled
+    double   Travel;                                //  [s] of the stage in the planned order
+    double   SerpentineTravel;                      //  [s] of the stage in serpentine order
+    double   PlanTime;                              //  [s] wall clock
+    std::vector< UINT > Order;                      //  tiles to mark, Column + Columns * Row
+
+    //  Results of Run
+    uint64_t Records;                               //  written
+    uint64_t Clipped;                               //  vectors cut at a tile border
+    UINT     FeedError;                             //  of the ListFeeder with TileFeedError
+    double   FirstTileTime;                         //  [s] wall clock until tile 0 was written
+    double   WriteTime;                             //  [s] wall clock until the last tile was written
+
+private:
+    TileEngine( const TileEngine& );
+    TileEngine& operator=( const TileEngine& );
+
+    friend class TilePrepare;
+
+    struct Vector
+    {
+        int32_t  X0, Y0, Z0;                        //  [bits] start in job coordinates
+        int32_t  X1, Y1;                            //  end
+        uint32_t Parameters;                        //  parameter commands before it
+
+    };
+
+    UINT     Run( ListJob* Out, ListFeeder* Feeder );
+    void     Index( uint32_t v, uint32_t* Cursor, uint32_t* Fill ) const;
+    void     Center( UINT Tile, LONG* C ) const;
+    double   Move( const LONG* From, const LONG* To ) const;
+    double   PathTravel( const std::vector< UINT >& Path ) const;
+
+    ListJob  Job;                                   //  marks and arcs made absolute, in job coordinates
+    std::vector< Vector > Marks;                    //  per record of Job
+    std::vector< ListCommand > Parameters;          //  in job order
+    std::vector< std::vector< uint32_t > > Kinds;   //  parameters per kind of command, ascending
+    double   GridX, GridY;                          //  [bits] corner of tile 0, 0
+    std::vector< uint32_t > TileStart;              //  per tile into TileVectors, one more than tiles
+    std::vector< uint32_t > TileVectors;
+
+};
@@ -0,0 +1,730 @@
+//  File
+//      RTC5Timing.cpp
+//
+//  Abstract
+//      Execution time of list commands
+//
+//  Comment
+//      Vectors and arcs are output in 10 us steps at the programmed speed,
+//      their time is rounded up to whole steps. A jump is followed by the
+//      jump delay, shortened linearly below JumpLengthLimit if
+//      set_delay_mode_list sets one. A mark followed by another mark or arc
+//      costs the polygon delay, scaled by angle / 180 deg with VarPoly set,
+//      or by the table of load_varpolydelay interpolated linearly if one is
+//      loaded, or the mark delay if the mark is longer than EdgeLevel. A polyline
+//      ends with the mark delay or with LaserOffDelay, whichever is longer.
+//      A negative LaserOnDelay is waited for at the start of a polyline, a
+//      positive one before the first pixel of a pixel line.
+//
+//      Sky writing replaces the delays by run-in (Nprev) and run-out
+//      (Npost) periods:
+//          Mode 1      at every mark vector
+//          Mode 2      at the start and the end of every polyline
+//          Mode 3      as mode 2, and at corners whose cosine is below the
+//                      limit of set_sky_writing_limit_list
+//
+//      A stepper motor moves from stepper_abs_list on at one step per
+//      StepperPeriod while the list goes on, stepper_wait waits until it
+//      has arrived. There is no ramp.
+//
+//      wait_for_encoder waits until the count of the encoder, running at
+//      EncoderRate from EncoderStart on, reaches the value in the direction
+//      of counting. The correction of set_fly_x and activate_fly_xy_encoder
+//      moves the scanner with the conveyor but does not change the time of
+//      the vectors, fly_return is timed as a jump.
+//
+//      The TimeEstimator resolves sub_call and sub_call_abs of subroutines
+//      passed by SetSub. Text commands and list_call / list_jump_pos refer
+//      to the list memory of a card and are counted as Unresolved.
+//
+//  Necessary Sources
+//      RTC5Timing.h, RTC5List.h, RTC5List.cpp, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <math.h>
+
+#include "RTC5Timing.h"
+#include "RTC5Util.h"
+
+static const double PixelUnit            =  1e-6 / 64.0;   //  [s] set_pixel_line
+static const UINT   MaxDepth             =            8;   //  nested subroutines
+
+static const char* ClassNames[ TimeClasses ] =
+{
+    "jump", "mark", "arc", "pixel", "jump delay", "mark delay", "polygon delay",
+    "laser delay", "sky writing", "long delay", "stage", "encoder", "other"
+
+};
+
+const char* TimeClassName( UINT Class )
+{
+    return Class < TimeClasses ? ClassNames[ Class ] : "";
+
+}
+
+double TimeBreakdown::Total() const
+{
+    double Sum = 0.0;
+
+    for ( UINT i = 0; i < TimeClasses; i++ ) Sum += T[ i ];
+
+    return Sum;
+
+}
+
+void TimeBreakdown::Add( const TimeBreakdown& Other )
+{
+    for ( UINT i = 0; i < TimeClasses; i++ ) T[ i ] += Other.T[ i ];
+
+}
+
+//  Time of a vector of Length bits in whole 10 us steps
+static double Steps( double Length, double Speed )
+{
+    return ceil( Length / ( Speed * 1e3 * Tick ) - 1e-9 ) * Tick;
+
+}
+
+TimingModel::TimingModel()
+{
+    Reset();
+
+}
+
+void TimingModel::Reset()
+{
+    X = Y = 0.0;
+    Time.Clear();
+
+    JumpSpeed       = 1000.0;
+    MarkSpeed       =  250.0;
+    JumpDelay       = MarkDelay = PolygonDelay = 0;
+    LaserOnDelay    = 0;
+    LaserOffDelay   = 0;
+    VarPoly         = EdgeLevel = 0;
+    VarPolyTable.clear();
+    MinJumpDelay    = JumpLengthLimit = 0;
+    SkyMode         = SkyPrev = SkyPost = 0;
+    SkyLimit        = 0.0;
+    PixelHalfPeriod = 0;
+    PixelX          = PixelY = 0.0;
+
+    for ( UINT m = 0; m < 2; m++ )
+    {
+        StepperPeriod[ m ] = 100;
+        StepperPos[ m ]    = 0;
+        StepperDone[ m ]   = 0.0;
+        EncoderRate[ m ]   = 0.0;
+        EncoderStart[ m ]  = 0.0;
+
+    }
+
+    memset( &Last, 0, sizeof( Last ) );
+
+    InPolyline      = false;
+    PixelStart      = false;
+    DirX            = 1.0;
+    DirY            = 0.0;
+    LastLength      = 0.0;
+
+}
+
+//  Apply
+//
+//  Description:
+//
+//  Takes over the parameters of speed, delay, sky writing and pixel line
+//  commands. Returns false for all other commands.
+//
+
+bool TimingModel::Apply( const ListCommand& Cmd )
+{
+    switch ( Cmd.Op )
+    {
+    case OpSetJumpSpeed:        if ( Cmd.D[ 0 ] > 0.0 ) JumpSpeed = Cmd.D[ 0 ];       return true;
+    case OpSetMarkSpeed:        if ( Cmd.D[ 0 ] > 0.0 ) MarkSpeed = Cmd.D[ 0 ];       return true;
+
+    case OpSetScannerDelays:
+        JumpDelay    = Cmd.I[ 0 ];
+        MarkDelay    = Cmd.I[ 1 ];
+        PolygonDelay = Cmd.I[ 2 ];
+        return true;
+
+    case OpSetLaserDelays:
+        LaserOnDelay  = Cmd.I[ 0 ];
+        LaserOffDelay = Cmd.I[ 1 ];
+        return true;
+
+    case OpSetDelayMode:
+        VarPoly         = Cmd.I[ 0 ];
+        EdgeLevel       = Cmd.I[ 2 ];
+        MinJumpDelay    = Cmd.J[ 0 ];
+        JumpLengthLimit = Cmd.J[ 1 ];
+        return true;
+
+    case OpSetSkyWritingPara:
+        SkyPrev = Cmd.I[ 1 ];
+        SkyPost = Cmd.I[ 2 ];
+        return true;
+
+    case OpSetSkyWritingMode:   SkyMode  = Cmd.I[ 0 ];                                return true;
+    case OpSetSkyWritingLimit:  SkyLimit = Cmd.D[ 0 ];                                return true;
+
+    case OpSetPixelLine:
+        PixelHalfPeriod = Cmd.I[ 0 ];
+        PixelX          = Cmd.D[ 0 ];
+        PixelY          = Cmd.D[ 1 ];
+        PixelStart      = true;
+        return true;
+
+    default:
+        return false;
+
+    }
+
+}
+
+double TimingModel::Add( UINT Class, double Seconds )
+{
+    Time.T[ Class ] += Seconds;
+    return Seconds;
+
+}
+
+//  Delay between the last mark and the next mark or arc in direction dX, dY
+double TimingModel::Corner( double dX, double dY )
+{
+    if ( !InPolyline )
+    {
+        double t = 0.0;
+
+        if ( SkyMode )        t += Add( TimeSkyWriting, SkyPrev * Tick );
+        if ( LaserOnDelay < 0 ) t += Add( TimeLaserDelay, -LaserOnDelay * LaserDelayUnit );
+
+        return t;
+
+    }
+
+    const double Cos = DirX * dX + DirY * dY;
+
+    if ( SkyMode == 1 || ( SkyMode == 3 && Cos < SkyLimit ) )
+    {
+        return Add( TimeSkyWriting, ( SkyPrev + SkyPost ) * Tick );
+
+    }
+
+    if ( EdgeLevel && LastLength > EdgeLevel )
+    {
+        return Add( TimeMarkDelay, MarkDelay * Tick );
+
+    }
+
+    return Add( TimePolygonDelay, PolygonDelay * Tick * PolygonScale( Cos ) );
+
+}
+
+double TimingModel::PolygonScale( double Cos ) const
+{
+    if ( !VarPoly ) return 1.0;
+
+    const double Angle = acos( Cos < -1.0 ? -1.0 : Cos > 1.0 ? 1.0 : Cos ) / Pi;
+
+    if ( VarPolyTable.empty() ) return Angle;
+
+    const double d = Angle * 180.0;
+    const UINT   i = d < 180.0 ? (UINT) d : 179;
+
+    return VarPolyTable[ i ] + ( VarPolyTable[ i + 1 ] - VarPolyTable[ i ] ) * ( d - i );
+
+}
+
+//  SetVarPolyTable
+//
+//  Description:
+//
+//  Resamples a table of load_varpolydelay to whole degrees. Angles before
+//  the first and after the last entry take the factor of that entry.
+//  Count 0 removes the table.
+//
+
+void TimingModel::SetVarPolyTable( const double* Angle, const double* Scale, UINT Count )
+{
+    VarPolyTable.clear();
+
+    if ( !Count ) return;
+
+    VarPolyTable.resize( 181 );
+
+    UINT k = 0;
+
+    for ( UINT d = 0; d <= 180; d++ )
+    {
+        while ( k + 1 < Count && Angle[ k + 1 ] <= d ) k++;
+
+        if ( k + 1 >= Count || d <= Angle[ k ] )
+        {
+            VarPolyTable[ d ] = Scale[ k ];
+
+        }
+        else
+        {
+            const double f = ( d - Angle[ k ] ) / ( Angle[ k + 1 ] - Angle[ k ] );
+            VarPolyTable[ d ] = Scale[ k ] + ( Scale[ k + 1 ] - Scale[ k ] ) * f;
+
+        }
+
+    }
+
+}
+
+void TimingModel::Motion( double Start, double FromX, double FromY )
+{
+    Last.Start   = Start;
+    Last.X0      = FromX;
+    Last.Y0      = FromY;
+    Last.CenterX = Last.CenterY = Last.Angle = 0.0;
+
+}
+
+double TimingModel::EndOfPolyline()
+{
+    if ( !InPolyline ) return 0.0;
+
+    InPolyline = false;
+
+    if ( SkyMode ) return Add( TimeSkyWriting, SkyPost * Tick );
+
+    const double Mark = MarkDelay * Tick;
+    const double Off  = LaserOffDelay * LaserDelayUnit;
+
+    return Add( TimeMarkDelay, Mark ) + ( Off > Mark ? Add( TimeLaserDelay, Off - Mark ) : 0.0 );
+
+}
+
+double TimingModel::EndOfVector()
+{
+    return EndOfPolyline();
+
+}
+
+double TimingModel::Jump( double ToX, double ToY )
+{
+    double t = EndOfPolyline();
+
+    Motion( t, X, Y );
+
+    const double Length = sqrt( ( ToX - X ) * ( ToX - X ) + ( ToY - Y ) * ( ToY - Y ) );
+    double       Delay  = JumpDelay * Tick;
+
+    if ( JumpLengthLimit && Length < JumpLengthLimit && MinJumpDelay < JumpDelay )
+    {
+        Delay = ( MinJumpDelay + ( JumpDelay - MinJumpDelay ) * Length / JumpLengthLimit ) * Tick;
+
+    }
+
+    Last.Duration = Add( TimeJump, Steps( Length, JumpSpeed ) );
+    t += Last.Duration;
+    t += Add( TimeJumpDelay, Delay );
+    X = ToX;
+    Y = ToY;
+
+    return t;
+
+}
+
+double TimingModel::Mark( double ToX, double ToY )
+{
+    const double dX = ToX - X, dY = ToY - Y;
+    const double Length = sqrt( dX * dX + dY * dY );
+
+    //  A zero length mark keeps the direction
+    double t = Length > 0.0 ? Corner( dX / Length, dY / Length ) : Corner( DirX, DirY );
+
+    Motion( t, X, Y );
+    Last.Duration = Add( TimeMark, Steps( Length, MarkSpeed ) );
+    t += Last.Duration;
+
+    if ( Length > 0.0 )
+    {
+        DirX = dX / Length;
+        DirY = dY / Length;
+
+    }
+
+    X = ToX;
+    Y = ToY;
+    LastLength = Length;
+    InPolyline = true;
+
+    return t;
+
+}
+
+double TimingModel::Arc( double CenterX, double CenterY, double Angle )
+{
+    const double vX = X - CenterX, vY = Y - CenterY;
+    const double r  = sqrt( vX * vX + vY * vY );
+    const double a  = Angle * Pi / 180.0;
+    const double s  = Angle < 0.0 ? -1.0 : 1.0;
+
+    //  Clockwise tangent at the start
+    double t = r > 0.0 ? Corner( s * vY / r, -s * vX / r ) : Corner( DirX, DirY );
+
+    const double Length = r * fabs( a );
+    Motion( t, X, Y );
+    Last.CenterX  = CenterX;
+    Last.CenterY  = CenterY;
+    Last.Angle    = Angle;
+    Last.Duration = Add( TimeArc, Steps( Length, MarkSpeed ) );
+    t += Last.Duration;
+
+    const double eX = vX * cos( a ) + vY * sin( a );
+    const double eY = vY * cos( a ) - vX * sin( a );
+
+    if ( r > 0.0 )
+    {
+        DirX =  s * eY / r;
+        DirY = -s * eX / r;
+
+    }
+
+    X = CenterX + eX;
+    Y = CenterY + eY;
+    LastLength = Length;
+    InPolyline = true;
+
+    return t;
+
+}
+
+double TimingModel::Pixels( UINT Count )
+{
+    double t = 0.0;
+
+    if ( PixelStart )
+    {
+        t += EndOfPolyline();
+        if ( LaserOnDelay > 0 ) t += Add( TimeLaserDelay, LaserOnDelay * LaserDelayUnit );
+        PixelStart = false;
+
+    }
+
+    Motion( t, X, Y );
+    Last.Duration = Add( TimePixel, Count * 2.0 * PixelHalfPeriod * PixelUnit );
+    t += Last.Duration;
+    X += Count * PixelX;
+    Y += Count * PixelY;
+
+    return t;
+
+}
+
+double TimingModel::Delay( UINT Ticks )
+{
+    return EndOfPolyline() + Add( TimeLongDelay, Ticks * Tick );
+
+}
+
+double TimingModel::StepperAbs( LONG Pos1, LONG Pos2 )
+{
+    const double t   = EndOfPolyline();
+    const LONG   Pos[ 2 ] = { Pos1, Pos2 };
+    const double Now = Time.Total();
+
+    for ( UINT m = 0; m < 2; m++ )
+    {
+        const double From = StepperDone[ m ] > Now ? StepperDone[ m ] : Now;
+        StepperDone[ m ] = From + fabs( (double) Pos[ m ] - StepperPos[ m ] ) * StepperPeriod[ m ] * 1e-6;
+        StepperPos[ m ]  = Pos[ m ];
+
+    }
+
+    return t;
+
+}
+
+double TimingModel::StepperWait( UINT No )
+{
+    const double t = EndOfPolyline();
+
+    if ( No < 1 || No > 2 ) return t;
+
+    const double Wait = StepperDone[ No - 1 ] - Time.Total();
+
+    return t + ( Wait > 0.0 ? Add( TimeStage, Wait ) : 0.0 );
+
+}
+
+double TimingModel::WaitForEncoder( LONG Value, UINT No )
+{
+    const double t = EndOfPolyline();
+
+    if ( No > 1 || EncoderRate[ No ] == 0.0 ) return t;
+
+    const double Wait = ( Value - EncoderStart[ No ] ) / EncoderRate[ No ] - Time.Total();
+
+    return t + ( Wait > 0.0 ? Add( TimeEncoder, Wait ) : 0.0 );
+
+}
+
+double TimingModel::Nop()
+{
+    return Add( TimeOther, Tick );
+
+}
+
+TimeEstimator::TimeEstimator()
+{
+    Reset();
+
+}
+
+void TimeEstimator::Reset()
+{
+    Model.Reset();
+    Commands   = 0;
+    Unresolved = 0;
+    PosX = PosY = 0.0;
+    Matrix[ 0 ][ 0 ] = Matrix[ 1 ][ 1 ] = 1.0;
+    Matrix[ 0 ][ 1 ] = Matrix[ 1 ][ 0 ] = 0.0;
+    Offset[ 0 ] = Offset[ 1 ] = 0.0;
+    SegmentStart.Clear();
+    SegmentBegin = 0;
+
+}
+
+//  SetSub
+//
+//  Description:
+//
+//  Makes subroutine Index known to the estimator. The records are not
+//  copied and must stay valid while Estimate is used.
+//
+
+void TimeEstimator::SetSub( UINT Index, const ListCommand* Cmd, size_t Count )
+{
+    if ( Index >= Subs.size() )
+    {
+        const Sub None = { 0, 0 };
+        Subs.resize( Index + 1, None );
+
+    }
+
+    Subs[ Index ].Cmd   = Cmd;
+    Subs[ Index ].Count = Count;
+
+}
+
+void TimeEstimator::Transform( double X, double Y, double* oX, double* oY ) const
+{
+    *oX = Matrix[ 0 ][ 0 ] * X + Matrix[ 0 ][ 1 ] * Y + Offset[ 0 ];
+    *oY = Matrix[ 1 ][ 0 ] * X + Matrix[ 1 ][ 1 ] * Y + Offset[ 1 ];
+
+}
+
+void TimeEstimator::Move( double X, double Y, bool Mark )
+{
+    double oX, oY;
+    Transform( X, Y, &oX, &oY );
+
+    if ( Mark ) Model.Mark( oX, oY );
+    else        Model.Jump( oX, oY );
+
+    PosX = X;
+    PosY = Y;
+
+}
+
+void TimeEstimator::Arc( double CenterX, double CenterY, double Angle )
+{
+    double oX, oY;
+    Transform( CenterX, CenterY, &oX, &oY );
+    Model.Arc( oX, oY, Angle );
+
+    const double a  = Angle * Pi / 180.0;
+    const double vX = PosX - CenterX, vY = PosY - CenterY;
+    PosX = CenterX + vX * cos( a ) + vY * sin( a );
+    PosY = CenterY + vY * cos( a ) - vX * sin( a );
+    Transform( PosX, PosY, &Model.X, &Model.Y );
+
+}
+
+//  Closes the segment ending with record Pos
+void TimeEstimator::Split( size_t Pos, std::vector< TimeSegment >* Segments )
+{
+    if ( Segments )
+    {
+        TimeSegment s;
+        s.Begin = SegmentBegin;
+        s.End   = Pos;
+
+        for ( UINT i = 0; i < TimeClasses; i++ ) s.Time.T[ i ] = Model.Time.T[ i ] - SegmentStart.T[ i ];
+
+        Segments->push_back( s );
+
+    }
+
+    SegmentStart = Model.Time;
+    SegmentBegin = Pos;
+
+}
+
+void TimeEstimator::Walk( const ListCommand* Cmd, size_t Count, double OriginX, double OriginY, UINT Depth,
+                          std::vector< TimeSegment >* Segments )
+{
+    for ( size_t i = 0; i < Count; i++ )
+    {
+        const ListCommand& c = Cmd[ i ];
+
+        if ( c.Op == OpTextData ) continue;
+
+        Commands++;
+
+        switch ( c.Op )
+        {
+        case OpJumpAbs:     Move( OriginX + c.I[ 0 ], OriginY + c.I[ 1 ], false );        break;
+        case OpMarkAbs:     Move( OriginX + c.I[ 0 ], OriginY + c.I[ 1 ], true );         break;
+        case OpJumpAbs3D:   Move( OriginX + c.I[ 0 ], OriginY + c.I[ 1 ], false );        break;
+        case OpMarkAbs3D:   Move( OriginX + c.I[ 0 ], OriginY + c.I[ 1 ], true );         break;
+        case OpJumpRel:     Move( PosX + c.I[ 0 ], PosY + c.I[ 1 ], false );              break;
+        case OpMarkRel:     Move( PosX + c.I[ 0 ], PosY + c.I[ 1 ], true );               break;
+        case OpArcAbs:      Arc( OriginX + c.I[ 0 ], OriginY + c.I[ 1 ], c.D[ 0 ] );      break;
+        case OpArcRel:      Arc( PosX + c.I[ 0 ], PosY + c.I[ 1 ], c.D[ 0 ] );            break;
+
+        case OpSetPixel:
+        case OpSetNPixel:
+        {
+            const UINT n = c.Op == OpSetPixel ? 1 : (UINT) c.I[ 2 ];
+            const double X0 = Model.X, Y0 = Model.Y;
+            Model.Pixels( n );
+            PosX += Model.X - X0;
+            PosY += Model.Y - Y0;
+            break;
+
+        }
+
+        case OpLongDelay:   Model.Delay( c.I[ 0 ] );                                      break;
+        case OpNop:         Model.Nop();                                                  break;
+        case OpStepperAbs:  Model.StepperAbs( c.I[ 0 ], c.I[ 1 ] );                       break;
+        case OpStepperWait: Model.StepperWait( c.I[ 0 ] );                                break;
+        case OpWaitForEncoder:  Model.WaitForEncoder( c.I[ 0 ], c.I[ 1 ] );               break;
+        case OpFlyReturn:   Move( c.I[ 0 ], c.I[ 1 ], false );                            break;
+
+        case OpSubCall:
+        case OpSubCallAbs:
+            Model.EndOfVector();
+
+            if ( (UINT) c.I[ 0 ] < Subs.size() && Subs[ c.I[ 0 ] ].Cmd && Depth < MaxDepth )
+            {
+                const bool Abs = c.Op == OpSubCallAbs;
+                Walk( Subs[ c.I[ 0 ] ].Cmd, Subs[ c.I[ 0 ] ].Count, Abs ? PosX : 0.0, Abs ? PosY : 0.0, Depth + 1, 0 );
+
+            }
+            else
+            {
+                Unresolved++;
+
+            }
+
+            break;
+
+        case OpListReturn:
+            Model.EndOfVector();
+
+            if ( Depth ) return;
+
+            break;
+
+        case OpEndOfList:
+        case OpSetWait:
+        case OpSaveAndRestartTimer:
+            Model.EndOfVector();
+
+            if ( !Depth ) Split( i + 1, Segments );
+
+            break;
+
+        case OpMarkText:
+        case OpMarkTextAbs:
+        case OpMarkChar:
+        case OpMarkCharAbs:
+        case OpMarkSerial:
+        case OpMarkSerialAbs:
+        case OpMarkDate:
+        case OpMarkDateAbs:
+        case OpMarkTime:
+        case OpMarkTimeAbs:
+        case OpListCall:
+        case OpListCallAbs:
+        case OpListJumpPos:
+            Model.EndOfVector();
+            Unresolved++;
+            break;
+
+        //  Only one scan head is modelled, head no. 0 (both) and 1 apply
+        case OpSetOffset:
+            if ( c.Arg < 2 )
+            {
+                Offset[ 0 ] = c.I[ 0 ];
+                Offset[ 1 ] = c.I[ 1 ];
+
+            }
+
+            break;
+
+        case OpSetMatrix:
+            if ( c.Arg < 2 && c.I[ 0 ] >= 1 && c.I[ 0 ] <= 2 && c.I[ 1 ] >= 1 && c.I[ 1 ] <= 2 )
+            {
+                Matrix[ c.I[ 0 ] - 1 ][ c.I[ 1 ] - 1 ] = c.D[ 0 ];
+
+            }
+
+            break;
+
+        default:
+            Model.Apply( c );
+            break;
+
+        }
+
+    }
+
+}
+
+//  Estimate
+//
+//  Description:
+//
+//  Walks the job and returns its execution time [s]. The job is taken as
+//  complete, i.e. a final polyline ends with its mark delay.
+//
+//      Parameter   Meaning
+//
+//      Cmd         list commands
+//      Count       number of records incl. OpTextData records
+//      Segments    optional, receives one segment per save_and_restart_timer,
+//                  set_wait and set_end_of_list and one for the rest
+//      Complete    false: the job is continued by the next call, a final
+//                  polyline stays open
+//
+//      Model.Time holds the breakdown accumulated since Reset.
+//
+
+double TimeEstimator::Estimate( const ListCommand* Cmd, size_t Count, std::vector< TimeSegment >* Segments,
+                                bool Complete )
+{
+    const double Start = Model.Time.Total();
+
+    SegmentStart = Model.Time;
+    SegmentBegin = 0;
+
+    Walk( Cmd, Count, 0.0, 0.0, 0, Segments );
+
+    if ( Complete ) Model.EndOfVector();
+
+    if ( SegmentBegin < Count ) Split( Count, Segments );
+
+    return Model.Time.Total() - Start;
+
+}
@@ -0,0 +1,189 @@
+//  File
+//      RTC5Timing.h
+//
+//  Abstract
+//      Execution time of list commands.
+//      The TimingModel holds the speeds, delays and the scanner position of
+//      a card and tells the time of each vector, arc, pixel and delay. The
+//      emulator runs its list memory with it, the TimeEstimator walks a job
+//      offline with the same model and returns the time per category, per
+//      segment and in total, e.g. for quoting cycle times without a card.
+//      Estimate and emulator agree by construction, neither is a check of
+//      the model against a real card.
+//
+//  Comment
+//      The model works in output coordinates, i.e. after set_matrix_list
+//      and set_offset_list. See RTC5Timing.cpp for the approximations.
+//
+//  Necessary Sources
+//      RTC5Timing.h, RTC5Timing.cpp, RTC5List.h, RTC5List.cpp, RTC5Util.h,
+//      RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "RTC5List.h"
+
+//  Unit of set_laser_delays, of LaserOnDelay and LaserOffDelay in the models and job files
+const double LaserDelayUnit       =         1e-6;   //  [s]
+
+//  Categories of a time breakdown
+enum TimeClass
+{
+    TimeJump = 0,               //  jump vectors
+    TimeMark,                   //  mark vectors
+    TimeArc,                    //  arc_abs, arc_rel
+    TimePixel,                  //  set_pixel, set_n_pixel
+    TimeJumpDelay,
+    TimeMarkDelay,
+    TimePolygonDelay,
+    TimeLaserDelay,             //  laser delays exceeding the scanner delays
+    TimeSkyWriting,             //  run-in and run-out of sky writing
+    TimeLongDelay,              //  long_delay
+    TimeStage,                  //  stepper_wait for the stage
+    TimeEncoder,                //  wait_for_encoder for the conveyor
+    TimeOther,                  //  list_nop
+    TimeClasses
+
+};
+
+struct TimeBreakdown
+{
+    double   T[ TimeClasses ];  //  [s]
+
+    void     Clear()            { memset( T, 0, sizeof( T ) ); }
+    double   Total() const;
+    void     Add( const TimeBreakdown& Other );
+
+};
+
+const char* TimeClassName( UINT Class );
+
+//  The motion of the last Jump, Mark, Arc or Pixels call
+struct TimingMotion
+{
+    double   Start;             //  [s] delays before the motion
+    double   Duration;          //  [s] 0: no motion
+    double   X0, Y0;            //  start position
+    double   CenterX, CenterY;  //  of an arc
+    double   Angle;             //  [deg] of an arc, 0 for a straight motion
+
+};
+
+class TimingModel
+{
+public:
+    TimingModel();
+
+    void     Reset();                               //  defaults of the emulator, position 0, 0
+    bool     Apply( const ListCommand& Cmd );       //  parameter commands, true if Cmd is one
+
+    //  The following return the time [s] and add it to Time
+    double   Jump( double X, double Y );
+    double   Mark( double X, double Y );
+    double   Arc( double CenterX, double CenterY, double Angle );  //  Angle [deg], clockwise
+    double   Pixels( UINT Count );
+    double   Delay( UINT Ticks );                   //  long_delay
+    double   StepperAbs( LONG Pos1, LONG Pos2 );    //  stepper_abs_list, the motors move while the list goes on
+    double   StepperWait( UINT No );                //  stepper_wait, motor 1 or 2
+    double   WaitForEncoder( LONG Value, UINT No ); //  wait_for_encoder, encoder 0 or 1
+    double   Nop();
+    double   EndOfVector();                         //  any command other than a vector
+
+    //  Factor of the polygon delay at a corner of cosine Cos
+    double   PolygonScale( double Cos ) const;
+
+    //  load_varpolydelay, Count entries of Angle [deg] ascending and Scale
+    void     SetVarPolyTable( const double* Angle, const double* Scale, UINT Count );
+
+    double   X, Y;                                  //  scanner position
+    TimeBreakdown Time;
+    TimingMotion  Last;                             //  for sampling the position in time
+
+    //  Parameters as set by the list commands
+    double   JumpSpeed, MarkSpeed;                  //  [bits/ms]
+    UINT     JumpDelay, MarkDelay, PolygonDelay;    //  [10 us]
+    LONG     LaserOnDelay;                          //  [LaserDelayUnit]
+    UINT     LaserOffDelay;                         //  [LaserDelayUnit]
+    UINT     VarPoly, EdgeLevel;                    //  set_delay_mode_list, EdgeLevel [bits]
+    std::vector< double > VarPolyTable;             //  factor per degree 0..180, empty: angle / 180
+    UINT     MinJumpDelay, JumpLengthLimit;         //  [10 us], [bits]
+    UINT     SkyMode, SkyPrev, SkyPost;             //  set_sky_writing_mode_list, Nprev, Npost [10 us]
+    double   SkyLimit;                              //  cosine of the limit angle
+    UINT     PixelHalfPeriod;                       //  [1/64 us]
+    double   PixelX, PixelY;                        //  pixel step [bits]
+
+    //  Stepper motors 1 and 2
+    UINT     StepperPeriod[ 2 ];                    //  [us] per step, stepper_init
+    LONG     StepperPos[ 2 ];                       //  [steps] target of the last move
+    double   StepperDone[ 2 ];                      //  [s] of Time.Total() the motor arrives
+
+    //  Encoders 0 and 1, counting EncoderStart + EncoderRate * Time.Total()
+    double   EncoderRate[ 2 ];                      //  [counts/s] 0: wait_for_encoder takes no time
+    double   EncoderStart[ 2 ];                     //  [counts]
+
+private:
+    double   Add( UINT Class, double Seconds );
+    double   Corner( double dX, double dY );
+    double   EndOfPolyline();
+    void     Motion( double Start, double FromX, double FromY );
+
+    bool     InPolyline;                            //  last vector was a mark or an arc
+    bool     PixelStart;                            //  set_pixel_line, no pixel yet
+    double   DirX, DirY;                            //  unit direction at the end of it
+    double   LastLength;
+
+};
+
+//  One section of a job between save_and_restart_timer, set_wait or
+//  set_end_of_list commands
+struct TimeSegment
+{
+    size_t   Begin, End;        //  records of the job
+    TimeBreakdown Time;
+
+};
+
+class TimeEstimator
+{
+public:
+    TimeEstimator();
+
+    void     Reset();                               //  model and counters
+    void     SetSub( UINT Index, const ListCommand* Cmd, size_t Count );
+    double   Estimate( const ListCommand* Cmd, size_t Count, std::vector< TimeSegment >* Segments = 0,
+                       bool Complete = true );
+
+    TimingModel Model;          //  state carries over from one Estimate to the next
+    uint64_t Commands;          //  commands walked incl. subroutines
+    uint64_t Unresolved;        //  text commands and unknown subroutines, counted with no time
+
+private:
+    struct Sub
+    {
+        const ListCommand* Cmd;
+        size_t Count;
+
+    };
+
+    void     Walk( const ListCommand* Cmd, size_t Count, double OriginX, double OriginY, UINT Depth,
+                   std::vector< TimeSegment >* Segments );
+    void     Transform( double X, double Y, double* oX, double* oY ) const;
+    void     Move( double X, double Y, bool Mark );
+    void     Arc( double CenterX, double CenterY, double Angle );
+    void     Split( size_t Pos, std::vector< TimeSegment >* Segments );
+
+    std::vector< Sub > Subs;
+    double   PosX, PosY;        //  list coordinates
+    double   Matrix[ 2 ][ 2 ];
+    double   Offset[ 2 ];
+    TimeBreakdown SegmentStart; //  Model.Time at the start of the segment
+    size_t   SegmentBegin;
+
+};
@@ -0,0 +1,770 @@
+//  File
+//      RTC5Track.cpp
+//
+//  Abstract
+//      Tracking error analysis of captured waveforms
+//
+//  Comment
+//      The streams are processed in blocks of float samples. Per block the
+//      squared error is computed for all samples at once, then the command
+//      is scanned for runs of motion and standstill. Sums, maxima and the
+//      settling search work on whole runs, only the run boundaries are
+//      found sample by sample.
+//      The real position is read Lag samples ahead of the command, so
+//      errors during a motion do not contain the tracking delay. Settling
+//      times are counted from the end of the command and do contain it.
+//
+//  Necessary Sources
+//      RTC5Track.h, RTC5Wave.h, RTC5Wave.cpp, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "RTC5Track.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define TRACK_SSE2
+#include <emmintrin.h>
+#endif
+
+static const size_t BlockSamples         =        65536;   //  samples read per block
+static const size_t AlignSamples         =        65536;   //  samples compared by Align
+static const size_t SumBlock             =         1024;   //  float sums added up in double beyond
+static const size_t NotFound             = (size_t) -1;
+static const size_t PrintRows            =           10;   //  histogram rows printed
+
+//  Kernels
+
+#ifdef TRACK_SSE2
+static float HorizontalSum( __m128 v )
+{
+    v = _mm_add_ps( v, _mm_movehl_ps( v, v ) );
+    v = _mm_add_ss( v, _mm_shuffle_ps( v, v, 1 ) );
+    return _mm_cvtss_f32( v );
+
+}
+
+static float HorizontalMax( __m128 v )
+{
+    v = _mm_max_ps( v, _mm_movehl_ps( v, v ) );
+    v = _mm_max_ss( v, _mm_shuffle_ps( v, v, 1 ) );
+    return _mm_cvtss_f32( v );
+
+}
+#endif
+
+static void ToFloat( const int32_t* In, float* Out, size_t n, bool Simd )
+{
+    size_t i = 0;
+
+#ifdef TRACK_SSE2
+    if ( Simd )
+    {
+        for ( ; i + 4 <= n; i += 4 )
+        {
+            _mm_storeu_ps( Out + i, _mm_cvtepi32_ps( _mm_loadu_si128( (const __m128i*) ( In + i ) ) ) );
+
+        }
+
+    }
+#else
+    (void) Simd;
+#endif
+
+    for ( ; i < n; i++ ) Out[ i ] = (float) In[ i ];
+
+}
+
+//  E2[ i ] = ( rx - cx )^2 + ( ry - cy )^2
+static void ErrorSquared( const float* cx, const float* cy, const float* rx, const float* ry, float* E2, size_t n,
+                          bool Simd )
+{
+    size_t i = 0;
+
+#ifdef TRACK_SSE2
+    if ( Simd )
+    {
+        for ( ; i + 4 <= n; i += 4 )
+        {
+            const __m128 dx = _mm_sub_ps( _mm_loadu_ps( rx + i ), _mm_loadu_ps( cx + i ) );
+            const __m128 dy = _mm_sub_ps( _mm_loadu_ps( ry + i ), _mm_loadu_ps( cy + i ) );
+            _mm_storeu_ps( E2 + i, _mm_add_ps( _mm_mul_ps( dx, dx ), _mm_mul_ps( dy, dy ) ) );
+
+        }
+
+    }
+#else
+    (void) Simd;
+#endif
+
+    for ( ; i < n; i++ )
+    {
+        const float dx = rx[ i ] - cx[ i ], dy = ry[ i ] - cy[ i ];
+        E2[ i ] = dx * dx + dy * dy;
+
+    }
+
+}
+
+//  Dot[ i ] = ( rx - cx ) * ux + ( ry - cy ) * uy
+static void Projection( const float* cx, const float* cy, const float* rx, const float* ry, float ux, float uy,
+                        float* Dot, size_t n, bool Simd )
+{
+    size_t i = 0;
+
+#ifdef TRACK_SSE2
+    if ( Simd )
+    {
+        const __m128 vx = _mm_set1_ps( ux ), vy = _mm_set1_ps( uy );
+
+        for ( ; i + 4 <= n; i += 4 )
+        {
+            const __m128 dx = _mm_sub_ps( _mm_loadu_ps( rx + i ), _mm_loadu_ps( cx + i ) );
+            const __m128 dy = _mm_sub_ps( _mm_loadu_ps( ry + i ), _mm_loadu_ps( cy + i ) );
+            _mm_storeu_ps( Dot + i, _mm_add_ps( _mm_mul_ps( dx, vx ), _mm_mul_ps( dy, vy ) ) );
+
+        }
+
+    }
+#else
+    (void) Simd;
+#endif
+
+    for ( ; i < n; i++ ) Dot[ i ] = ( rx[ i ] - cx[ i ] ) * ux + ( ry[ i ] - cy[ i ] ) * uy;
+
+}
+
+//  Sum and maximum of v[ 0 .. n )
+static void SumMax( const float* v, size_t n, double* Sum, float* Max, bool Simd )
+{
+    for ( size_t b = 0; b < n; b += SumBlock )
+    {
+        const size_t e = std::min( n, b + SumBlock );
+        size_t i = b;
+        float  s = 0.0f, m = *Max;
+
+#ifdef TRACK_SSE2
+        if ( Simd )
+        {
+            __m128 vs = _mm_setzero_ps(), vm = _mm_set1_ps( m );
+
+            for ( ; i + 4 <= e; i += 4 )
+            {
+                const __m128 x = _mm_loadu_ps( v + i );
+                vs = _mm_add_ps( vs, x );
+                vm = _mm_max_ps( vm, x );
+
+            }
+
+            s = HorizontalSum( vs );
+            m = HorizontalMax( vm );
+
+        }
+#else
+        (void) Simd;
+#endif
+
+        for ( ; i < e; i++ )
+        {
+            s += v[ i ];
+            if ( v[ i ] > m ) m = v[ i ];
+
+        }
+
+        *Sum += s;
+        *Max  = m;
+
+    }
+
+}
+
+static float Maximum( const float* v, size_t n, float Max, bool Simd )
+{
+    size_t i = 0;
+
+#ifdef TRACK_SSE2
+    if ( Simd )
+    {
+        __m128 vm = _mm_set1_ps( Max );
+
+        for ( ; i + 4 <= n; i += 4 ) vm = _mm_max_ps( vm, _mm_loadu_ps( v + i ) );
+
+        Max = HorizontalMax( vm );
+
+    }
+#else
+    (void) Simd;
+#endif
+
+    for ( ; i < n; i++ ) if ( v[ i ] > Max ) Max = v[ i ];
+
+    return Max;
+
+}
+
+//  Last i in [ 0, n ) with v[ i ] > Limit, NotFound if none
+static size_t LastAbove( const float* v, size_t n, float Limit, bool Simd )
+{
+    size_t i = n;
+
+#ifdef TRACK_SSE2
+    if ( Simd )
+    {
+        const __m128 l = _mm_set1_ps( Limit );
+
+        while ( i % 4 )
+        {
+            i--;
+            if ( v[ i ] > Limit ) return i;
+
+        }
+
+        while ( i && !_mm_movemask_ps( _mm_cmpgt_ps( _mm_loadu_ps( v + i - 4 ), l ) ) ) i -= 4;
+
+    }
+#else
+    (void) Simd;
+#endif
+
+    while ( i )
+    {
+        i--;
+        if ( v[ i ] > Limit ) return i;
+
+    }
+
+    return NotFound;
+
+}
+
+//  End of a motion at constant velocity starting before j: first k >= j
+//  where the command stops or its velocity changes by more than Step
+static size_t MotionEnd( const float* cx, const float* cy, size_t j, size_t n, float Step, bool Simd )
+{
+    const float Minus = -Step;
+
+#ifdef TRACK_SSE2
+    if ( Simd && j >= 2 )
+    {
+        const __m128 Zero = _mm_setzero_ps(), Hi = _mm_set1_ps( Step ), Lo = _mm_set1_ps( Minus );
+
+        for ( ; j + 4 <= n; j += 4 )
+        {
+            const __m128 ux = _mm_sub_ps( _mm_loadu_ps( cx + j ), _mm_loadu_ps( cx + j - 1 ) );
+            const __m128 uy = _mm_sub_ps( _mm_loadu_ps( cy + j ), _mm_loadu_ps( cy + j - 1 ) );
+            const __m128 ax = _mm_sub_ps( ux, _mm_sub_ps( _mm_loadu_ps( cx + j - 1 ), _mm_loadu_ps( cx + j - 2 ) ) );
+            const __m128 ay = _mm_sub_ps( uy, _mm_sub_ps( _mm_loadu_ps( cy + j - 1 ), _mm_loadu_ps( cy + j - 2 ) ) );
+
+            __m128 End = _mm_and_ps( _mm_cmpeq_ps( ux, Zero ), _mm_cmpeq_ps( uy, Zero ) );
+            End = _mm_or_ps( End, _mm_or_ps( _mm_cmpgt_ps( ax, Hi ), _mm_cmplt_ps( ax, Lo ) ) );
+            End = _mm_or_ps( End, _mm_or_ps( _mm_cmpgt_ps( ay, Hi ), _mm_cmplt_ps( ay, Lo ) ) );
+
+            if ( _mm_movemask_ps( End ) ) break;
+
+        }
+
+    }
+#else
+    (void) Simd;
+#endif
+
+    for ( ; j < n; j++ )
+    {
+        const float ux = cx[ j ] - cx[ j - 1 ], uy = cy[ j ] - cy[ j - 1 ];
+        const float ax = ux - ( cx[ j - 1 ] - cx[ j - 2 ] ), ay = uy - ( cy[ j - 1 ] - cy[ j - 2 ] );
+
+        if ( ( ux == 0.0f && uy == 0.0f ) || ax > Step || ax < Minus || ay > Step || ay < Minus ) break;
+
+    }
+
+    return j;
+
+}
+
+//  End of a standstill: first k >= j where the command moves
+static size_t StillEnd( const float* cx, const float* cy, size_t j, size_t n, bool Simd )
+{
+#ifdef TRACK_SSE2
+    if ( Simd )
+    {
+        for ( ; j + 4 <= n; j += 4 )
+        {
+            const __m128 Moves = _mm_or_ps( _mm_cmpneq_ps( _mm_loadu_ps( cx + j ), _mm_loadu_ps( cx + j - 1 ) ),
+                                            _mm_cmpneq_ps( _mm_loadu_ps( cy + j ), _mm_loadu_ps( cy + j - 1 ) ) );
+
+            if ( _mm_movemask_ps( Moves ) ) break;
+
+        }
+
+    }
+#else
+    (void) Simd;
+#endif
+
+    for ( ; j < n && cx[ j ] == cx[ j - 1 ] && cy[ j ] == cy[ j - 1 ]; j++ );
+
+    return j;
+
+}
+
+//  TrackHistogram
+
+TrackHistogram::TrackHistogram( double aWidth, UINT Bins )
+    : Width( aWidth ), Count( Bins + 1, 0 ), N( 0 ), Sum( 0.0 ), Max( 0.0 )
+{
+}
+
+void TrackHistogram::Clear()
+{
+    std::fill( Count.begin(), Count.end(), 0 );
+    N   = 0;
+    Sum = 0.0;
+    Max = 0.0;
+
+}
+
+void TrackHistogram::Add( double Value )
+{
+    const double b = Value / Width;
+    const size_t Last = Count.size() - 1;
+
+    Count[ b < 0.0 ? 0 : b >= Last ? Last : (size_t) b ]++;
+    N++;
+    Sum += Value;
+    if ( Value > Max || N == 1 ) Max = Value;
+
+}
+
+double TrackHistogram::Quantile( double q ) const
+{
+    const uint64_t Target = (uint64_t) ceil( q * N );
+    uint64_t Sum = 0;
+
+    for ( size_t b = 0; b + 1 < Count.size(); b++ )
+    {
+        Sum += Count[ b ];
+        if ( Sum >= Target && Sum ) return std::min( ( b + 1 ) * Width, Max );
+
+    }
+
+    return Max;
+
+}
+
+void TrackHistogram::Print( FILE* Out, const char* Name, const char* Unit, double Scale ) const
+{
+    fprintf( Out, "%s [%s]: %llu values, mean %.2f, p50 %.2f, p90 %.2f, p99 %.2f, max %.2f\n",
+             Name, Unit, (unsigned long long) N,
+             N ? Sum / N * Scale : 0.0, Quantile( 0.5 ) * Scale, Quantile( 0.9 ) * Scale,
+             Quantile( 0.99 ) * Scale, Max * Scale );
+
+    //  Nonempty range in at most PrintRows rows
+    size_t First = 0, Last = Count.size();
+
+    while ( First < Count.size() && !Count[ First ] ) First++;
+    while ( Last > First && !Count[ Last - 1 ] ) Last--;
+
+    const size_t Group = std::max< size_t >( 1, ( Last - First + PrintRows - 1 ) / PrintRows );
+    std::vector< uint64_t > Rows;
+
+    for ( size_t b = First; b < Last; b += Group )
+    {
+        uint64_t n = 0;
+        for ( size_t k = b; k < std::min( Last, b + Group ); k++ ) n += Count[ k ];
+        Rows.push_back( n );
+
+    }
+
+    const uint64_t Top = Rows.empty() ? 0 : *std::max_element( Rows.begin(), Rows.end() );
+
+    for ( size_t r = 0; r < Rows.size(); r++ )
+    {
+        const size_t b = First + r * Group;
+        const size_t e = std::min( Last, b + Group );
+        char Bar[ 41 ];
+        const size_t Length = (size_t) ( Rows[ r ] * 40 / Top );
+        memset( Bar, '#', Length );
+        Bar[ Length ] = 0;
+
+        if ( e < Count.size() ) fprintf( Out, "    %8.2f .. %8.2f %10llu %s\n", b * Width * Scale, e * Width * Scale, (unsigned long long) Rows[ r ], Bar );
+        else                    fprintf( Out, "    %8.2f ..          %10llu %s\n", b * Width * Scale, (unsigned long long) Rows[ r ], Bar );
+
+    }
+
+}
+
+//  TrackAnalyzer
+
+TrackAnalyzer::TrackAnalyzer()
+    : Period( 10e-6 ), MaxLag( 64 ), Tolerance( 2.0 ), VelocityStep( 2.5 ), Vectorized( true ),
+      ErrorHistogram( 1.0, 40 ), OvershootHistogram( 1.0, 40 ), SettlingHistogram( 20e-6, 40 )
+{
+    Reset();
+
+}
+
+void TrackAnalyzer::Reset()
+{
+    Lag       = 0;
+    Samples   = 0;
+    Unsettled = 0;
+    RmsError  = 0.0;
+    MaxError  = 0.0;
+    SumE2     = 0.0;
+    Moved     = 0;
+    Started   = false;
+    Moving    = false;
+    Still     = false;
+    LastOut   = 0;
+    Segments.clear();
+    ErrorHistogram.Clear();
+    OvershootHistogram.Clear();
+    SettlingHistogram.Clear();
+
+}
+
+//  Align
+//
+//  Description:
+//
+//  Finds the tracking delay as the shift of the real position, 0 ...
+//  MaxLag samples, with the least squared distance to the command, sets
+//  and returns Lag.
+//
+//      Parameter   Meaning
+//
+//      Count       samples of every stream, the real position is compared
+//                  up to Count, the command up to Count - MaxLag
+//
+
+int TrackAnalyzer::Align( const float* CmdX, const float* CmdY, const float* RealX, const float* RealY, size_t Count )
+{
+    Lag = 0;
+
+    if ( Count <= (size_t) MaxLag ) return Lag;
+
+    const size_t n = std::min( Count - MaxLag, AlignSamples );
+    E2.resize( n );
+    double Best = -1.0;
+
+    for ( int l = 0; l <= MaxLag; l++ )
+    {
+        ErrorSquared( CmdX, CmdY, RealX + l, RealY + l, E2.data(), n, Vectorized );
+
+        double Sum = 0.0;
+        float  Max = 0.0f;
+        SumMax( E2.data(), n, &Sum, &Max, Vectorized );
+
+        if ( Best < 0.0 || Sum < Best )
+        {
+            Best = Sum;
+            Lag  = l;
+
+        }
+
+    }
+
+    return Lag;
+
+}
+
+//  Add
+//
+//  Description:
+//
+//  Analyzes the next Count samples of the aligned streams, i.e. RealX[ i ]
+//  was taken Lag samples after CmdX[ i ].
+//
+
+void TrackAnalyzer::Add( const float* CmdX, const float* CmdY, const float* RealX, const float* RealY, size_t Count )
+{
+    if ( !Count ) return;
+
+    E2.resize( Count );
+    Dot.resize( Count );
+    ErrorSquared( CmdX, CmdY, RealX, RealY, E2.data(), Count, Vectorized );
+
+    size_t i = 0;
+
+    if ( !Started )
+    {
+        PrevX   = CmdX[ 0 ];
+        PrevY   = CmdY[ 0 ];
+        VX      = 0.0f;
+        VY      = 0.0f;
+        Started = true;
+
+    }
+
+    const float Step = (float) VelocityStep;
+    const float Tol2 = (float) ( Tolerance * Tolerance );
+
+    while ( i < Count )
+    {
+        const float px = i ? CmdX[ i - 1 ] : PrevX, py = i ? CmdY[ i - 1 ] : PrevY;
+        float vx = CmdX[ i ] - px, vy = CmdY[ i ] - py;
+        size_t j = i + 1;
+
+        if ( vx != 0.0f || vy != 0.0f )
+        {
+            //  A corner without stop
+            if ( Moving && ( fabs( vx - VX ) > Step || fabs( vy - VY ) > Step ) ) CloseSegment( false );
+
+            if ( !Moving )
+            {
+                CloseStill();
+                memset( &Seg, 0, sizeof( Seg ) );
+                Seg.Begin = Samples + i;
+                StartX    = px;
+                StartY    = py;
+                SegSum    = 0.0;
+                Moving    = true;
+
+            }
+
+            //  The velocity before j = i + 1 is vx, vy
+            if ( j < Count )
+            {
+                const float ux = CmdX[ j ] - CmdX[ j - 1 ], uy = CmdY[ j ] - CmdY[ j - 1 ];
+
+                if ( ( ux != 0.0f || uy != 0.0f ) && fabs( ux - vx ) <= Step && fabs( uy - vy ) <= Step )
+                {
+                    j = MotionEnd( CmdX, CmdY, j + 1, Count, Step, Vectorized );
+
+                }
+
+            }
+
+            if ( j > i + 1 )
+            {
+                vx = CmdX[ j - 1 ] - CmdX[ j - 2 ];
+                vy = CmdY[ j - 1 ] - CmdY[ j - 2 ];
+
+            }
+
+            double Sum = 0.0;
+            SumMax( E2.data() + i, j - i, &Sum, &Seg.MaxError, Vectorized );
+            SegSum  += Sum;
+            SumE2   += Sum;
+            Moved   += j - i;
+            Seg.End  = Samples + j - 1;
+            EndX     = CmdX[ j - 1 ];
+            EndY     = CmdY[ j - 1 ];
+            VX       = vx;
+            VY       = vy;
+
+        }
+        else
+        {
+            if ( Moving ) CloseSegment( true );
+
+            j = StillEnd( CmdX, CmdY, j, Count, Vectorized );
+
+            if ( Still )
+            {
+                LastStill = Samples + j - 1;
+
+                Projection( CmdX + i, CmdY + i, RealX + i, RealY + i, (float) DirX, (float) DirY, Dot.data(), j - i,
+                            Vectorized );
+                Seg.Overshoot = Maximum( Dot.data(), j - i, Seg.Overshoot, Vectorized );
+
+                const size_t k = LastAbove( E2.data() + i, j - i, Tol2, Vectorized );
+                if ( k != NotFound ) LastOut = Samples + i + k;
+
+            }
+
+            VX = 0.0f;
+            VY = 0.0f;
+
+        }
+
+        i = j;
+
+    }
+
+    PrevX    = CmdX[ Count - 1 ];
+    PrevY    = CmdY[ Count - 1 ];
+    Samples += Count;
+
+}
+
+//  CloseSegment
+//
+//  Description:
+//
+//  Ends the motion at Seg.End. If the command stops, Seg waits for the
+//  standstill to be measured, otherwise it is stored.
+//
+
+void TrackAnalyzer::CloseSegment( bool Stop )
+{
+    const uint64_t n = Seg.End - Seg.Begin + 1;
+    const double   v = sqrt( (double) VX * VX + (double) VY * VY );
+
+    Seg.Length   = (float) sqrt( ( EndX - StartX ) * ( EndX - StartX ) + ( EndY - StartY ) * ( EndY - StartY ) );
+    Seg.Speed    = (float) ( v / Period * 1e-3 );
+    Seg.RmsError = (float) sqrt( SegSum / n );
+    Seg.MaxError = sqrt( Seg.MaxError );
+    Seg.Settling = -1.0f;
+    Moving       = false;
+
+    if ( Seg.MaxError > MaxError ) MaxError = Seg.MaxError;
+
+    if ( Stop )
+    {
+        //  Overshoot along the last direction of the motion
+        DirX      = v > 0.0 ? VX / v : 0.0;
+        DirY      = v > 0.0 ? VY / v : 0.0;
+        LastOut   = Seg.End;
+        LastStill = Seg.End;
+        Still     = true;
+        return;
+
+    }
+
+    Store();
+
+}
+
+//  CloseStill
+//
+//  Description:
+//
+//  Ends the standstill after Seg. The head settled after the last sample
+//  beyond Tolerance, unless that is the last sample of the standstill.
+//
+
+void TrackAnalyzer::CloseStill()
+{
+    if ( !Still ) return;
+
+    Still = false;
+
+    if ( LastOut == LastStill && LastOut > Seg.End )
+    {
+        Unsettled++;
+
+    }
+    else
+    {
+        Seg.Settling = (float) ( ( LastOut - Seg.End + Lag ) * Period );
+        SettlingHistogram.Add( Seg.Settling );
+
+    }
+
+    OvershootHistogram.Add( Seg.Overshoot );
+    Store();
+
+}
+
+void TrackAnalyzer::Store()
+{
+    ErrorHistogram.Add( Seg.MaxError );
+    Segments.push_back( Seg );
+
+}
+
+void TrackAnalyzer::Finish()
+{
+    if ( Moving ) CloseSegment( false );
+
+    CloseStill();
+
+    RmsError = Moved ? sqrt( SumE2 / Moved ) : 0.0;
+
+}
+
+//  Analyze
+//
+//  Description:
+//
+//  Reads a wave file in blocks, aligns the real position by Align on the
+//  first block and analyzes all samples.
+//
+//      Parameter   Meaning
+//
+//      File        open wave file
+//      CommandX    channels 1 ... 4 of the file, as recorded by
+//      ...         WaveCapture with the signals 7, 8, 1, 2
+//
+
+UINT TrackAnalyzer::Analyze( WaveFile& File, UINT CommandX, UINT CommandY, UINT RealX, UINT RealY )
+{
+    const WaveFileHeader& Head = File.Header();
+    const UINT Channel[ 4 ] = { CommandX, CommandY, RealX, RealY };
+
+    for ( UINT c = 0; c < 4; c++ ) if ( !Channel[ c ] || Channel[ c ] > Head.Channels ) return TrackRangeError;
+
+    Reset();
+    Period = Head.Period * 10e-6;
+
+    const uint64_t N = Head.SampleCount;
+    std::vector< int32_t > Raw( BlockSamples + MaxLag );
+    std::vector< float > Stream[ 4 ];
+
+    for ( UINT c = 0; c < 4; c++ ) Stream[ c ].resize( BlockSamples + MaxLag );
+
+    uint64_t First = 0;
+
+    while ( First + Lag < N )
+    {
+        //  The first block is read MaxLag samples longer for Align
+        const size_t Extra = First ? 0 : MaxLag;
+        const size_t n     = (size_t) std::min< uint64_t >( BlockSamples + Extra, N - Lag - First );
+
+        for ( UINT c = 0; c < 4; c++ )
+        {
+            const uint64_t From = c < 2 ? First : First + Lag;
+            const size_t   m    = (size_t) std::min< uint64_t >( n, N - From );
+
+            if ( File.Read( Channel[ c ], From, m, Raw.data() ) != m ) return TrackFileError;
+
+            ToFloat( Raw.data(), Stream[ c ].data(), m, Vectorized );
+
+        }
+
+        size_t Used = n;
+
+        if ( !First )
+        {
+            Align( Stream[ 0 ].data(), Stream[ 1 ].data(), Stream[ 2 ].data(), Stream[ 3 ].data(), n );
+
+            //  Realign the real position read without shift
+            Used = (size_t) std::min< uint64_t >( BlockSamples, N - Lag );
+            Used = std::min( Used, n - Lag );
+            memmove( Stream[ 2 ].data(), Stream[ 2 ].data() + Lag, Used * sizeof( float ) );
+            memmove( Stream[ 3 ].data(), Stream[ 3 ].data() + Lag, Used * sizeof( float ) );
+
+        }
+
+        Add( Stream[ 0 ].data(), Stream[ 1 ].data(), Stream[ 2 ].data(), Stream[ 3 ].data(), Used );
+        First += Used;
+
+    }
+
+    Finish();
+    return TrackNoError;
+
+}
+
+void TrackAnalyzer::Print( FILE* Out ) const
+{
+    size_t Stopped = 0;
+
+    for ( size_t i = 0; i < Segments.size(); i++ ) if ( Segments[ i ].Settling >= 0.0f ) Stopped++;
+
+    fprintf( Out, "%llu samples of %.0f us, tracking delay %d samples (%.0f us)\n",
+             (unsigned long long) Samples, Period * 1e6, Lag, Lag * Period * 1e6 );
+    fprintf( Out, "%llu segments, %llu settled, %llu not settled, RMS error %.2f bits, max error %.2f bits\n",
+             (unsigned long long) Segments.size(), (unsigned long long) Stopped, (unsigned long long) Unsettled,
+             RmsError, MaxError );
+
+    ErrorHistogram.Print( Out, "Max error per segment", "bits" );
+    OvershootHistogram.Print( Out, "Overshoot", "bits" );
+    SettlingHistogram.Print( Out, "Settling", "us", 1e6 );
+
+}
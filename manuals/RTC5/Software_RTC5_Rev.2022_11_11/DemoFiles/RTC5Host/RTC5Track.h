@@ -0,0 +1,123 @@
+//  File
+//      RTC5Track.h
+//
+//  Abstract
+//      Tracking error analysis of captured waveforms.
+//      A wave file of WaveCapture holds the commanded position (signals
+//      7, 8: SampleX, SampleY) and the real position of the scan head
+//      (signals 1, 2 after control_command( ..., SendRealPos ) as in
+//      Demo7). The TrackAnalyzer aligns both streams by the tracking delay
+//      of the head, splits the command into segments and computes per
+//      segment
+//          RmsError, MaxError  distance of the real from the commanded
+//                              position during the motion, tracking delay
+//                              removed
+//          Overshoot           beyond the end point along the motion
+//          Settling            time from the end of the command until the
+//                              head stays within Tolerance of the end point
+//      and summary histograms of them, e.g. for choosing the jump and mark
+//      delays by the settling times measured instead of by trial.
+//
+//  Comment
+//      A segment is a motion of the command at constant velocity or along
+//      an arc, it ends where the command stops or changes its velocity
+//      abruptly. Overshoot and settling are measured only if the command
+//      stops, i.e. during the scanner delays.
+//      The inner loops use SSE2 where available.
+//
+//  Necessary Sources
+//      RTC5Track.h, RTC5Track.cpp, RTC5Wave.h, RTC5Wave.cpp, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+#include "RTC5Wave.h"
+
+//  Error codes of the analysis
+const UINT   TrackNoError         =            0;
+const UINT   TrackFileError       =            1;   //  wave file not readable
+const UINT   TrackRangeError      =            2;   //  channel out of range
+
+struct TrackSegment
+{
+    uint64_t Begin, End;        //  first and last sample of the motion
+    float    Length;            //  [bits]
+    float    Speed;             //  [bits/ms]
+    float    RmsError;          //  [bits]
+    float    MaxError;          //  [bits]
+    float    Overshoot;         //  [bits], 0 if not stopped
+    float    Settling;          //  [s], < 0 if not stopped or not settled
+
+};
+
+class TrackHistogram
+{
+public:
+    TrackHistogram( double Width = 1.0, UINT Bins = 20 );
+
+    void     Clear();
+    void     Add( double Value );
+    double   Quantile( double q ) const;            //  upper edge of the bin, Max in the overflow
+    void     Print( FILE* Out, const char* Name, const char* Unit, double Scale = 1.0 ) const;
+
+    double   Width;                                 //  of a bin
+    std::vector< uint64_t > Count;                  //  last bin counts all values beyond
+    uint64_t N;
+    double   Sum, Max;
+
+};
+
+class TrackAnalyzer
+{
+public:
+    TrackAnalyzer();
+
+    void     Reset();
+    UINT     Analyze( WaveFile& File, UINT CommandX = 1, UINT CommandY = 2, UINT RealX = 3, UINT RealY = 4 );
+
+    //  Streams already read, e.g. from another source
+    int      Align( const float* CmdX, const float* CmdY, const float* RealX, const float* RealY, size_t Count );
+    void     Add( const float* CmdX, const float* CmdY, const float* RealX, const float* RealY, size_t Count );
+    void     Finish();
+
+    //  Settings
+    double   Period;                                //  [s] of a sample, set by Analyze
+    int      MaxLag;                                //  [samples] tracking delay searched by Align
+    double   Tolerance;                             //  [bits] settled
+    double   VelocityStep;                          //  [bits/sample] abrupt change of the velocity
+    bool     Vectorized;                            //  false: scalar loops, for comparison
+
+    //  Results
+    int      Lag;                                   //  [samples] tracking delay, set by Align
+    uint64_t Samples;
+    uint64_t Unsettled;                             //  stopped segments not settled before the next motion
+    double   RmsError, MaxError;                    //  [bits] of all motions
+    std::vector< TrackSegment > Segments;
+    TrackHistogram ErrorHistogram;                  //  MaxError of the segments [bits]
+    TrackHistogram OvershootHistogram;              //  [bits]
+    TrackHistogram SettlingHistogram;               //  [s]
+
+    void     Print( FILE* Out ) const;
+
+private:
+    void     CloseSegment( bool Stop );
+    void     CloseStill();
+    void     Store();
+
+    std::vector< float > E2, Dot;                   //  per sample of a block
+    float    PrevX, PrevY, VX, VY;                  //  command
+    bool     Started, Moving, Still;
+    TrackSegment Seg;
+    double   SegSum, StartX, StartY, EndX, EndY, DirX, DirY;
+    uint64_t LastOut;                               //  last sample beyond Tolerance while still
+    uint64_t LastStill;                             //  last sample of the standstill
+    double   SumE2;
+    uint64_t Moved;
+
+};
@@ -0,0 +1,571 @@
+//  File
+//      RTC5Tune.cpp
+//
+//  Abstract
+//      Tuning of the scanner and laser delays
+//
+//  Comment
+//      A run samples the command in 10 us periods the way the emulator
+//      measures SampleX, SampleY and steps the GalvoModel with it. The
+//      laser turns on LaserOnDelay after the start of the first motion of
+//      a polyline and off LaserOffDelay after the end of its last one. The
+//      head position at these instants is interpolated between samples.
+//      A polyline never lit counts its length as StartError and EndError.
+//      The path of a polyline is kept as pieces, arcs split such that a
+//      chord deviates by less than 1/4 bit. The PathError of a sample is
+//      its distance from the nearest of the last Window pieces up to the
+//      one being output, the head lags behind the command.
+//
+//  Necessary Sources
+//      RTC5Tune.h, RTC5Galvo.h, RTC5Timing.h, RTC5List.h, RTC5Util.h,
+//      RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "RTC5Timing.h"
+#include "RTC5Tune.h"
+#include "RTC5Util.h"
+
+static const size_t Window               =           64;   //  pieces searched for the PathError
+static const UINT   MaxArcPieces         =         4096;
+
+struct TunePiece
+{
+    double   X0, Y0, X1, Y1;
+
+};
+
+//  Squared distance of X, Y from the piece
+static double Distance2( double X, double Y, const TunePiece& p )
+{
+    const double dX = p.X1 - p.X0, dY = p.Y1 - p.Y0;
+    const double L2 = dX * dX + dY * dY;
+    double f = L2 > 0.0 ? ( ( X - p.X0 ) * dX + ( Y - p.Y0 ) * dY ) / L2 : 0.0;
+
+    f = f < 0.0 ? 0.0 : f > 1.0 ? 1.0 : f;
+
+    const double eX = p.X0 + f * dX - X, eY = p.Y0 + f * dY - Y;
+    return eX * eX + eY * eY;
+
+}
+
+//  One run of a job with one set of parameters
+class TuneRun
+{
+public:
+    TuneRun( const TuneParameters& Par, const GalvoModel& Head, TuneResult& Result );
+
+    void     Command( const ListCommand& c );
+    void     Finish();
+
+private:
+    void     Sample( double T0, bool Motion );
+    void     Mark( double T0 );
+    void     EndPolyline( bool WasOpen );
+    void     CheckLit();
+
+    TimingModel Model;
+    GalvoModel  Galvo;
+    TuneResult& R;
+
+    double   Next;                  //  [s] time of the next sample
+    double   PrevX, PrevY;          //  real position of the last sample
+    bool     WasOn;
+
+    //  Polyline
+    bool     Open, Active;
+    double   OnAt, OffAt;           //  [s] laser
+    double   StartX, StartY, EndX, EndY, Length;
+    double   LastMarkEnd;           //  [s] end of the last motion
+    bool     Lit;
+    std::vector< TunePiece > Pieces;
+    size_t   CmdFirst, CmdCount;    //  pieces of the command being sampled
+    bool     CmdArc;
+
+};
+
+TuneRun::TuneRun( const TuneParameters& Par, const GalvoModel& Head, TuneResult& Result )
+    : Galvo( Head ), R( Result ), Next( 0.0 ), PrevX( 0.0 ), PrevY( 0.0 ), WasOn( false ), Open( false ),
+      Active( false ), OnAt( 0.0 ), OffAt( 0.0 ), StartX( 0.0 ), StartY( 0.0 ), EndX( 0.0 ), EndY( 0.0 ),
+      Length( 0.0 ), LastMarkEnd( 0.0 ), Lit( false ), CmdFirst( 0 ), CmdCount( 0 ), CmdArc( false )
+{
+    Model.Reset();
+    Model.JumpSpeed     = Par.JumpSpeed;
+    Model.MarkSpeed     = Par.MarkSpeed;
+    Model.JumpDelay     = Par.JumpDelay;
+    Model.MarkDelay     = Par.MarkDelay;
+    Model.PolygonDelay  = Par.PolygonDelay;
+    Model.LaserOnDelay  = Par.LaserOnDelay;
+    Model.LaserOffDelay = Par.LaserOffDelay;
+
+    Galvo.Configure();
+    Galvo.Reset();
+
+    R.Par        = Par;
+    R.CycleTime  = 0.0;
+    R.PathError  = R.StartError = R.EndError = R.Error = 0.0;
+    R.Feasible   = false;
+
+}
+
+void TuneRun::Command( const ListCommand& c )
+{
+    const double T0 = Model.Time.Total();
+    const bool   WasOpen = Open;
+    const bool   Jump = c.Op == OpJumpAbs || c.Op == OpJumpRel;
+
+    switch ( c.Op )
+    {
+    case OpJumpAbs:     Model.Jump( c.I[ 0 ], c.I[ 1 ] );                             break;
+    case OpJumpRel:     Model.Jump( Model.X + c.I[ 0 ], Model.Y + c.I[ 1 ] );         break;
+    case OpMarkAbs:     Model.Mark( c.I[ 0 ], c.I[ 1 ] );              Mark( T0 );    return;
+    case OpMarkRel:     Model.Mark( Model.X + c.I[ 0 ], Model.Y + c.I[ 1 ] ); Mark( T0 ); return;
+    case OpArcAbs:      Model.Arc( c.I[ 0 ], c.I[ 1 ], c.D[ 0 ] );     Mark( T0 );    return;
+    case OpArcRel:      Model.Arc( Model.X + c.I[ 0 ], Model.Y + c.I[ 1 ], c.D[ 0 ] ); Mark( T0 ); return;
+    case OpLongDelay:   Model.Delay( c.I[ 0 ] );                                      break;
+    case OpSetDelayMode: Model.Apply( c );                                            return;
+
+    //  Replaced by the candidate
+    case OpSetJumpSpeed:
+    case OpSetMarkSpeed:
+    case OpSetScannerDelays:
+    case OpSetLaserDelays:
+    case OpTextData:
+        return;
+
+    default:            Model.EndOfVector();                                          break;
+
+    }
+
+    EndPolyline( WasOpen );
+    CmdFirst = Pieces.size();
+    CmdCount = 0;
+    Sample( T0, Jump );
+
+}
+
+//  After a mark or an arc
+void TuneRun::Mark( double T0 )
+{
+    const TimingMotion& m = Model.Last;
+
+    if ( !Open )
+    {
+        CheckLit();
+
+        Open   = true;
+        Active = true;
+        Lit    = false;
+        OnAt   = T0 + m.Start + Model.LaserOnDelay * LaserDelayUnit;
+        OffAt  = 1e300;
+        StartX = m.X0;
+        StartY = m.Y0;
+        Length = 0.0;
+        Pieces.clear();
+
+    }
+
+    CmdFirst = Pieces.size();
+    CmdArc   = m.Angle != 0.0;
+
+    if ( CmdArc )
+    {
+        const double vX = m.X0 - m.CenterX, vY = m.Y0 - m.CenterY;
+        const double r  = sqrt( vX * vX + vY * vY );
+        const double a  = fabs( m.Angle ) * Pi / 180.0;
+        const double n  = r > 0.0 ? ceil( a / sqrt( 2.0 / r ) ) : 1.0;
+        const UINT   Count = n < 1.0 ? 1 : n > MaxArcPieces ? MaxArcPieces : (UINT) n;
+
+        double X0 = m.X0, Y0 = m.Y0;
+
+        for ( UINT k = 1; k <= Count; k++ )
+        {
+            const double b  = m.Angle * Pi / 180.0 * k / Count;
+            const TunePiece p = { X0, Y0, m.CenterX + vX * cos( b ) + vY * sin( b ), m.CenterY + vY * cos( b ) - vX * sin( b ) };
+            Pieces.push_back( p );
+            X0 = p.X1;
+            Y0 = p.Y1;
+
+        }
+
+        Length += r * a;
+
+    }
+    else
+    {
+        const TunePiece p = { m.X0, m.Y0, Model.X, Model.Y };
+        Pieces.push_back( p );
+        Length += sqrt( ( Model.X - m.X0 ) * ( Model.X - m.X0 ) + ( Model.Y - m.Y0 ) * ( Model.Y - m.Y0 ) );
+
+    }
+
+    CmdCount    = Pieces.size() - CmdFirst;
+    EndX        = Model.X;
+    EndY        = Model.Y;
+    LastMarkEnd = T0 + m.Start + m.Duration;
+
+    Sample( T0, true );
+
+}
+
+void TuneRun::EndPolyline( bool WasOpen )
+{
+    if ( !WasOpen ) return;
+
+    Open  = false;
+    OffAt = LastMarkEnd + Model.LaserOffDelay * LaserDelayUnit;
+
+}
+
+//  A polyline never lit is missing as a whole
+void TuneRun::CheckLit()
+{
+    if ( !Active || Lit ) return;
+
+    R.StartError = std::max( R.StartError, Length );
+    R.EndError   = std::max( R.EndError, Length );
+
+}
+
+//  Samples of the command started at T0 up to the model time, Motion:
+//  the command is the one of Model.Last, otherwise the position is held
+void TuneRun::Sample( double T0, bool Motion )
+{
+    const TimingMotion& m = Model.Last;
+    const double T1 = Model.Time.Total();
+
+    while ( Next <= T1 + 1e-12 )
+    {
+        const double t = Next - T0;
+        double cX, cY, f = 1.0;
+
+        if ( !Motion || m.Duration <= 0.0 || t >= m.Start + m.Duration )
+        {
+            cX = Model.X;
+            cY = Model.Y;
+
+        }
+        else if ( t <= m.Start )
+        {
+            cX = m.X0;
+            cY = m.Y0;
+            f  = 0.0;
+
+        }
+        else if ( m.Angle != 0.0 )
+        {
+            f = ( t - m.Start ) / m.Duration;
+
+            const double a  = f * m.Angle * Pi / 180.0;
+            const double vX = m.X0 - m.CenterX, vY = m.Y0 - m.CenterY;
+            cX = m.CenterX + vX * cos( a ) + vY * sin( a );
+            cY = m.CenterY + vY * cos( a ) - vX * sin( a );
+
+        }
+        else
+        {
+            f  = ( t - m.Start ) / m.Duration;
+            cX = m.X0 + ( Model.X - m.X0 ) * f;
+            cY = m.Y0 + ( Model.Y - m.Y0 ) * f;
+
+        }
+
+        Galvo.Step( cX, cY );
+
+        const bool On = Active && Next >= OnAt && Next < OffAt;
+
+        //  Real position at a switch of the laser between the samples
+        if ( On != WasOn )
+        {
+            const double s = On ? std::max( OnAt, Next - Tick ) : std::min( OffAt, Next );
+            const double g = ( s - ( Next - Tick ) ) / Tick;
+            const double X = PrevX + ( Galvo.X - PrevX ) * g;
+            const double Y = PrevY + ( Galvo.Y - PrevY ) * g;
+
+            if ( On )
+            {
+                R.StartError = std::max( R.StartError, sqrt( ( X - StartX ) * ( X - StartX ) + ( Y - StartY ) * ( Y - StartY ) ) );
+                Lit = true;
+
+            }
+            else
+            {
+                R.EndError = std::max( R.EndError, sqrt( ( X - EndX ) * ( X - EndX ) + ( Y - EndY ) * ( Y - EndY ) ) );
+
+            }
+
+        }
+
+        if ( On && !Pieces.empty() )
+        {
+            size_t Cursor = Pieces.size() - 1;
+
+            if ( CmdCount )
+            {
+                const size_t k = CmdArc ? (size_t) ( f * CmdCount ) : 0;
+                Cursor = CmdFirst + std::min( k, CmdCount - 1 );
+
+            }
+
+            double d = 1e300;
+
+            for ( size_t i = Cursor + 1; i-- > 0 && Cursor - i < Window; ) d = std::min( d, Distance2( Galvo.X, Galvo.Y, Pieces[ i ] ) );
+
+            R.PathError = std::max( R.PathError, sqrt( d ) );
+
+        }
+
+        PrevX = Galvo.X;
+        PrevY = Galvo.Y;
+        WasOn = On;
+        Next += Tick;
+
+    }
+
+}
+
+void TuneRun::Finish()
+{
+    const double T0 = Model.Time.Total();
+    const bool   WasOpen = Open;
+
+    Model.EndOfVector();
+    EndPolyline( WasOpen );
+    CmdCount = 0;
+    Sample( T0, false );
+    CheckLit();
+
+    R.CycleTime = Model.Time.Total();
+    R.Error     = std::max( R.PathError, std::max( R.StartError, R.EndError ) );
+
+}
+
+DelayTuner::DelayTuner()
+    : MaxError( 10.0 ), MinJumpSpeed( 2000.0 ), MaxJumpSpeed( 8000.0 ), MinMarkSpeed( 1000.0 ), MaxMarkSpeed( 1000.0 ),
+      JumpSpeeds( 4 ), MarkSpeeds( 1 ), MaxScannerDelay( 100 ), MaxLaserDelay( 500 ), Threads( 0 ), Evaluations( 0 )
+{
+    Best.Feasible = false;
+
+}
+
+UINT DelayTuner::SetJob( const ListCommand* Cmd, size_t Count )
+{
+    if ( !Cmd || !Count ) return TuneRangeError;
+
+    Job.assign( Cmd, Cmd + Count );
+
+    return TuneNoError;
+
+}
+
+void DelayTuner::Evaluate( const TuneParameters& Par, TuneResult& Result ) const
+{
+    TuneRun Run( Par, Galvo, Result );
+
+    for ( size_t i = 0; i < Job.size(); i++ ) Run.Command( Job[ i ] );
+
+    Run.Finish();
+    Result.Feasible = Result.Error <= MaxError;
+
+}
+
+//  Search
+//
+//  Description:
+//
+//  Finds the delays of the speed pair in Result.Par, see RTC5Tune.h.
+//
+//      Parameter   Meaning
+//
+//      Result      speeds on entry, the run of the delays found on return
+//      Runs        incremented by the runs of the job
+//
+
+void DelayTuner::Search( TuneResult& Result, uint64_t& Runs ) const
+{
+    TuneParameters p = Result.Par;
+    TuneResult     r;
+
+    p.JumpDelay     = p.MarkDelay = p.PolygonDelay = MaxScannerDelay;
+    p.LaserOnDelay  = 0;
+    p.LaserOffDelay = MaxLaserDelay;
+
+    Evaluate( p, Result );
+    Runs++;
+
+    if ( !Result.Feasible ) return;
+
+    //  Shortest delay in [ Lo, *Delay ] within MaxError, *Delay is within
+    UINT* const Delays[ 4 ] = { &p.LaserOffDelay, &p.MarkDelay, &p.PolygonDelay, &p.JumpDelay };
+
+    for ( UINT k = 0; k < 4; k++ )
+    {
+        UINT* const Delay = Delays[ k ];
+        UINT Hi = *Delay;
+        UINT Lo = Delay == &p.MarkDelay ? std::min( Hi, (UINT) ceil( p.LaserOffDelay * LaserDelayUnit / Tick ) ) : 0;
+
+        while ( Lo < Hi )
+        {
+            *Delay = ( Lo + Hi ) / 2;
+            Evaluate( p, r );
+            Runs++;
+
+            if ( r.Feasible ) Hi = *Delay;
+            else              Lo = *Delay + 1;
+
+        }
+
+        *Delay = Hi;
+
+    }
+
+    //  Longest laser on delay within MaxError
+    LONG Lo = 0, Hi = (LONG) MaxLaserDelay;
+
+    while ( Lo < Hi )
+    {
+        p.LaserOnDelay = ( Lo + Hi + 1 ) / 2;
+        Evaluate( p, r );
+        Runs++;
+
+        if ( r.Feasible ) Lo = p.LaserOnDelay;
+        else              Hi = p.LaserOnDelay - 1;
+
+    }
+
+    p.LaserOnDelay = Lo;
+
+    Evaluate( p, Result );
+    Runs++;
+
+}
+
+//  Tune
+//
+//  Description:
+//
+//  Searches all speed pairs of the grid. Best receives the shortest cycle
+//  time within MaxError or, if there is none, the smallest error.
+//
+
+UINT DelayTuner::Tune()
+{
+    if ( Job.empty() || MinJumpSpeed <= 0.0 || MinMarkSpeed <= 0.0 || MaxJumpSpeed < MinJumpSpeed ||
+         MaxMarkSpeed < MinMarkSpeed || !JumpSpeeds || !MarkSpeeds )
+    {
+        return TuneRangeError;
+
+    }
+
+    Candidates.resize( JumpSpeeds * MarkSpeeds );
+
+    for ( UINT j = 0; j < JumpSpeeds; j++ )
+    {
+        for ( UINT m = 0; m < MarkSpeeds; m++ )
+        {
+            TuneParameters& p = Candidates[ j * MarkSpeeds + m ].Par;
+            p.JumpSpeed = JumpSpeeds > 1 ? MinJumpSpeed + ( MaxJumpSpeed - MinJumpSpeed ) * j / ( JumpSpeeds - 1 ) : MinJumpSpeed;
+            p.MarkSpeed = MarkSpeeds > 1 ? MinMarkSpeed + ( MaxMarkSpeed - MinMarkSpeed ) * m / ( MarkSpeeds - 1 ) : MinMarkSpeed;
+
+        }
+
+    }
+
+    UINT n = Threads ? Threads : std::thread::hardware_concurrency();
+    n = std::max( 1u, std::min( n, (UINT) Candidates.size() ) );
+
+    std::atomic< size_t >   Index( 0 );
+    std::atomic< uint64_t > Runs( 0 );
+    std::vector< std::thread > Workers;
+
+    for ( UINT t = 0; t < n; t++ )
+    {
+        Workers.push_back( std::thread( [ this, &Index, &Runs ]()
+        {
+            uint64_t Count = 0;
+
+            for ( size_t i; ( i = Index++ ) < Candidates.size(); ) Search( Candidates[ i ], Count );
+
+            Runs += Count;
+
+        } ) );
+
+    }
+
+    for ( size_t t = 0; t < Workers.size(); t++ ) Workers[ t ].join();
+
+    Evaluations = Runs;
+
+    const TuneResult* b = &Candidates[ 0 ];
+
+    for ( size_t i = 1; i < Candidates.size(); i++ )
+    {
+        const TuneResult& c = Candidates[ i ];
+
+        if ( c.Feasible != b->Feasible ? c.Feasible : c.Feasible ? c.CycleTime < b->CycleTime : c.Error < b->Error ) b = &c;
+
+    }
+
+    Best = *b;
+
+    return Best.Feasible ? TuneNoError : TuneInfeasible;
+
+}
+
+//  WriteProfile
+//
+//  Description:
+//
+//  Writes Best as the [Marking] section of an RTC5.ini file, delays in us,
+//  speeds in bits/ms.
+//
+
+UINT DelayTuner::WriteProfile( const char* Name ) const
+{
+    FILE* File = fopen( Name, "w" );
+    if ( !File ) return TuneFileError;
+
+    const TuneParameters& p = Best.Par;
+
+    fprintf( File, "; Marking error %.1f bits (limit %.1f bits), %.3f ms per job\n", Best.Error, MaxError,
+             Best.CycleTime * 1e3 );
+    fprintf( File, "; Head %.0f Hz, damping %.2f\n\n", Galvo.Axis[ 0 ].Frequency, Galvo.Axis[ 0 ].Damping );
+    fprintf( File, "[Marking]\n" );
+    fprintf( File, "LaserOnDelay=%g\n",  p.LaserOnDelay * LaserDelayUnit * 1e6 );
+    fprintf( File, "LaserOffDelay=%g\n", p.LaserOffDelay * LaserDelayUnit * 1e6 );
+    fprintf( File, "MarkSpeed=%g\n",     p.MarkSpeed );
+    fprintf( File, "JumpSpeed=%g\n",     p.JumpSpeed );
+    fprintf( File, "MarkDelay=%u\n",     p.MarkDelay * 10 );
+    fprintf( File, "JumpDelay=%u\n",     p.JumpDelay * 10 );
+    fprintf( File, "PolyDelay=%u\n",     p.PolygonDelay * 10 );
+
+    const bool Failed = ferror( File ) != 0;
+
+    return fclose( File ) || Failed ? TuneFileError : TuneNoError;
+
+}
+
+void DelayTuner::Print( FILE* Out ) const
+{
+    fprintf( Out, "jump speed  mark speed   jump  mark  poly  laser on  laser off [us]    cycle [ms]   path  start    end [bits]\n" );
+
+    for ( size_t i = 0; i < Candidates.size(); i++ )
+    {
+        const TuneResult&     c = Candidates[ i ];
+        const TuneParameters& p = c.Par;
+
+        fprintf( Out, "%10.0f  %10.0f  %5u %5u %5u  %8.1f  %9.1f       %10.3f  %6.1f %6.1f %6.1f  %s\n",
+                 p.JumpSpeed, p.MarkSpeed, p.JumpDelay * 10, p.MarkDelay * 10, p.PolygonDelay * 10,
+                 p.LaserOnDelay * LaserDelayUnit * 1e6, p.LaserOffDelay * LaserDelayUnit * 1e6, c.CycleTime * 1e3,
+                 c.PathError, c.StartError, c.EndError,
+                 !c.Feasible ? "beyond MaxError" : c.Par.JumpSpeed == Best.Par.JumpSpeed && c.Par.MarkSpeed == Best.Par.MarkSpeed ? "best" : "" );
+
+    }
+
+}
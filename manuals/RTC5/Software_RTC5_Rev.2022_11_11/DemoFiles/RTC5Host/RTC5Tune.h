@@ -0,0 +1,112 @@
+//  File
+//      RTC5Tune.h
+//
+//  Abstract
+//      Tuning of the scanner and laser delays.
+//      The demos copy JumpDelay, MarkDelay, PolygonDelay and the laser
+//      delays from one to the other. A DelayTuner runs a job through the
+//      TimingModel of the emulator and a GalvoModel of the head and
+//      searches the speeds and delays of the shortest cycle time for which
+//      the marking error stays within MaxError. The result is written as
+//      the [Marking] section of an RTC5.ini file.
+//
+//      Marking error, the largest of
+//          PathError       distance of the head from the polyline being
+//                          marked while the laser is on, e.g. at corners
+//                          cut by a short polygon delay or while the head
+//                          still rings after a short jump delay
+//          StartError      distance of the head from the start of a
+//                          polyline when the laser turns on
+//          EndError        distance of the head from the end of a polyline
+//                          when the laser turns off
+//
+//  Comment
+//      The speed pairs of the grid are searched in parallel threads, one
+//      pair at a time by a thread. For a pair the delays start at their
+//      maximum and are shortened one after the other by bisection while
+//      the error stays within MaxError: LaserOffDelay, MarkDelay (not
+//      below the laser off delay), PolygonDelay and JumpDelay. The laser
+//      on delay is lengthened as far as the start of the polylines allows.
+//      The job may hold jumps, marks, arcs, long_delay and
+//      set_delay_mode_list. Its own speed and delay commands are replaced
+//      by the candidates, all other commands end a polyline.
+//
+//  Necessary Sources
+//      RTC5Tune.h, RTC5Tune.cpp, RTC5Galvo.h, RTC5Galvo.cpp, RTC5Timing.h,
+//      RTC5Timing.cpp, RTC5List.h, RTC5List.cpp, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+#include "RTC5Galvo.h"
+#include "RTC5List.h"
+
+//  Error codes of the tuner
+const UINT   TuneNoError          =            0;
+const UINT   TuneRangeError       =            1;   //  no job, empty speed range
+const UINT   TuneInfeasible       =            2;   //  MaxError exceeded at the longest delays
+const UINT   TuneFileError        =            3;   //  profile not writable
+
+struct TuneParameters
+{
+    double   JumpSpeed, MarkSpeed;                  //  [bits/ms]
+    UINT     JumpDelay, MarkDelay, PolygonDelay;    //  [10 us]
+    LONG     LaserOnDelay;                          //  [LaserDelayUnit]
+    UINT     LaserOffDelay;                         //  [LaserDelayUnit]
+
+};
+
+struct TuneResult
+{
+    TuneParameters Par;
+    double   CycleTime;                             //  [s]
+    double   PathError, StartError, EndError;       //  [bits]
+    double   Error;                                 //  largest of the three
+    bool     Feasible;                              //  Error within MaxError
+
+};
+
+class DelayTuner
+{
+public:
+    DelayTuner();
+
+    UINT     SetJob( const ListCommand* Cmd, size_t Count );   //  copied
+    UINT     Tune();
+
+    //  One run of the job, may be called by several threads at once
+    void     Evaluate( const TuneParameters& Par, TuneResult& Result ) const;
+
+    UINT     WriteProfile( const char* Name ) const;
+    void     Print( FILE* Out ) const;
+
+    //  Settings
+    GalvoModel Galvo;
+    double   MaxError;                              //  [bits]
+    double   MinJumpSpeed, MaxJumpSpeed;            //  [bits/ms]
+    double   MinMarkSpeed, MaxMarkSpeed;
+    UINT     JumpSpeeds, MarkSpeeds;                //  grid points of the ranges
+    UINT     MaxScannerDelay;                       //  [10 us]
+    UINT     MaxLaserDelay;                         //  [LaserDelayUnit]
+    UINT     Threads;                               //  0: one per processor
+
+    //  Results
+    std::vector< TuneResult > Candidates;           //  best delays per speed pair
+    TuneResult Best;
+    uint64_t Evaluations;
+
+private:
+    DelayTuner( const DelayTuner& );
+    DelayTuner& operator=( const DelayTuner& );
+
+    void     Search( TuneResult& Result, uint64_t& Runs ) const;
+
+    std::vector< ListCommand > Job;
+
+};
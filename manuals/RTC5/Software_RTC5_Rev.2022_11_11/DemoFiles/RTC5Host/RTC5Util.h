@@ -0,0 +1,52 @@
+//  File
+//      RTC5Util.h
+//
+//  Abstract
+//      Constants and small helpers shared by the host modules.
+//
+//  Comment
+//      Header only: Pi, the 10 us clock of the list commands, the wall clock
+//      time since a time point, the sleep the pollers pause with by default
+//      and a fork and join of a function on n threads.
+//
+//  Necessary Sources
+//      RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "RTC5expl.h"
+
+const double Pi                   = 3.14159265358979323846;
+const double Tick                 =        10e-6;   //  [s] of the list clock, delays and periods
+
+//  [s] wall clock since Since
+inline double Seconds( std::chrono::steady_clock::time_point Since )
+{
+    return std::chrono::duration< double >( std::chrono::steady_clock::now() - Since ).count();
+
+}
+
+inline void SleepFor( double Seconds )
+{
+    std::this_thread::sleep_for( std::chrono::duration< double >( Seconds ) );
+
+}
+
+//  Runs f( 0 ) .. f( n - 1 ) on n threads, f( 0 ) on the calling one
+template< class F > void Parallel( UINT n, F f )
+{
+    std::vector< std::thread > Workers;
+
+    for ( UINT t = 1; t < n; t++ ) Workers.push_back( std::thread( f, t ) );
+
+    f( 0 );
+
+    for ( size_t t = 0; t < Workers.size(); t++ ) Workers[ t ].join();
+
+}
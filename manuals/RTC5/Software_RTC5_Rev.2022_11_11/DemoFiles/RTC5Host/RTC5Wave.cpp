@@ -0,0 +1,464 @@
+//  File
+//      RTC5Wave.cpp
+//
+//  Abstract
+//      Continuous waveform capture
+//
+//  Comment
+//      Instrument plans the windows with the timing model. Text commands
+//      and subroutines which the estimator cannot resolve are taken with
+//      no time, so a window may exceed the buffer. The card stops the
+//      measurement when the buffer is full, the block is marked by
+//      WaveOverflow and counted in Overflows.
+//
+//  Necessary Sources
+//      RTC5Wave.h, RTC5Timing.h, RTC5List.h, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#include <string.h>
+
+#include <chrono>
+
+#include "RTC5Util.h"
+#include "RTC5Wave.h"
+
+static const double MaxFill = 0.95;         //  a window is split within a polyline beyond this part
+
+static double Now()
+{
+    return std::chrono::duration< double >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+
+}
+
+static int Seek( FILE* File, uint64_t Offset )
+{
+#ifdef _WIN32
+    return _fseeki64( File, (__int64) Offset, SEEK_SET );
+#else
+    return fseeko( File, (off_t) Offset, SEEK_SET );
+#endif
+
+}
+
+static bool IsVector( UINT Op )
+{
+    switch ( Op )
+    {
+    case OpMarkAbs:
+    case OpMarkRel:
+    case OpArcAbs:
+    case OpArcRel:
+    case OpSetPixel:
+    case OpSetNPixel:
+        return true;
+
+    default:
+        return false;
+
+    }
+
+}
+
+WaveCapture::WaveCapture()
+    : Fill( 0.8 ), PollInterval( 1e-3 ), Pause( SleepFor ), Samples( 0 ), Blocks( 0 ), Overflows( 0 ),
+      Planned( 0 ), Served( 0 ), Period( 1 ), Channels( 2 ), File( 0 ), WriteFailed( false ), Offset( 0 ), StartTime( 0.0 ),
+      Stopping( false )
+{
+    Signal[ 0 ] = 1;
+    Signal[ 1 ] = 2;
+    Signal[ 2 ] = 0;
+    Signal[ 3 ] = 0;
+
+}
+
+WaveCapture::~WaveCapture()
+{
+    if ( Worker.joinable() ) Stop();
+
+}
+
+//  Configure
+//
+//  Description:
+//
+//  Sets the measurement of the following Instrument calls.
+//
+//      Parameter   Meaning
+//
+//      Period      sample period [10 us], 1 ... 2^16 - 1
+//      Channels    2: set_trigger, 4: set_trigger4
+//      Signals     Channels signal numbers as for set_trigger, e.g. 7, 8
+//                  for the output position
+//
+
+UINT WaveCapture::Configure( UINT aPeriod, UINT aChannels, const UINT* Signals )
+{
+    if ( !aPeriod || aPeriod > 0xffff || ( aChannels != 2 && aChannels != 4 ) || !Signals ) return WaveRangeError;
+    if ( Worker.joinable() ) return WaveBusy;
+
+    Period   = aPeriod;
+    Channels = aChannels;
+
+    for ( UINT i = 0; i < 4; i++ ) Signal[ i ] = i < Channels ? Signals[ i ] : 0;
+
+    return WaveNoError;
+
+}
+
+UINT WaveCapture::WindowSamples() const
+{
+    return WaveBufferValues / Channels;
+
+}
+
+void WaveCapture::Arm( ListJob& Out ) const
+{
+    ListCommand Cmd = ListMake( Channels == 2 ? OpSetTrigger : OpSetTrigger4, Period, Signal[ 0 ], Signal[ 1 ] );
+    Cmd.J[ 2 ] = Signal[ 2 ];
+    Cmd.J[ 3 ] = Signal[ 3 ];
+    Out.push_back( Cmd );
+
+}
+
+void WaveCapture::Disarm( ListJob& Out ) const
+{
+    ListCommand Cmd = ListMake( Channels == 2 ? OpSetTrigger : OpSetTrigger4, 0, Signal[ 0 ], Signal[ 1 ] );
+    Cmd.J[ 2 ] = Signal[ 2 ];
+    Cmd.J[ 3 ] = Signal[ 3 ];
+    Out.push_back( ListMake( OpLongDelay, 1 ) );    //  ends a polyline, its delays are still sampled
+    Out.push_back( Cmd );
+    Out.push_back( ListMake( OpSetWait, WaveWaitWord ) );
+
+}
+
+//  Instrument
+//
+//  Description:
+//
+//  Appends the job to Out with the measurement commands. Windows are split
+//  before the first jump beyond Fill of the buffer, within a polyline only
+//  if it would not fit otherwise. The last window ends at the end of the
+//  job, i.e. Out must not end with set_end_of_list already.
+//
+//      Parameter   Meaning
+//
+//      Cmd         job without set_end_of_list, Timing must hold the
+//                  parameters valid at its start
+//      Count       number of records incl. OpTextData records
+//      Out         receives the instrumented job
+//
+
+void WaveCapture::Instrument( const ListCommand* Cmd, size_t Count, ListJob& Out )
+{
+    const double Full  = WindowSamples() * Period * 10e-6;
+    const double Limit = Fill * Full;
+    double Window = 0.0;
+
+    Out.reserve( Out.size() + Count + 16 );
+    Arm( Out );
+    Planned++;
+
+    size_t i = 0;
+
+    while ( i < Count )
+    {
+        size_t n = 1;
+        while ( i + n < Count && Cmd[ i + n ].Op == OpTextData ) n++;
+
+        const double t = Timing.Estimate( Cmd + i, n, 0, false );
+
+        if (   ( ( Cmd[ i ].Op == OpJumpAbs || Cmd[ i ].Op == OpJumpRel ) && Window >= Limit )
+            || ( IsVector( Cmd[ i ].Op ) && Window > 0.0 && Window + t > MaxFill * Full )
+           )
+        {
+            Disarm( Out );
+            Arm( Out );
+            Planned++;
+            Window = 0.0;
+
+        }
+
+        Out.insert( Out.end(), Cmd + i, Cmd + i + n );
+        Window += t;
+        i += n;
+
+    }
+
+    Disarm( Out );
+
+}
+
+//  Start
+//
+//  Description:
+//
+//  Creates the wave file and starts the capture thread. It reads every
+//  window the card waits with WaveWaitWord for and releases the card.
+//
+
+UINT WaveCapture::Start( const char* Name )
+{
+    if ( Worker.joinable() ) return WaveBusy;
+
+    File = fopen( Name, "wb" );
+    if ( !File ) return WaveFileError;
+
+    WaveFileHeader Head;
+    memset( &Head, 0, sizeof( Head ) );
+    memcpy( Head.Magic, "RWV1", 4 );
+
+    if ( fwrite( &Head, sizeof( Head ), 1, File ) != 1 )
+    {
+        fclose( File );
+        File = 0;
+        return WaveFileError;
+
+    }
+
+    Offset    = sizeof( Head );
+    StartTime = Now();
+    Samples   = 0;
+    Blocks    = 0;
+    Overflows = 0;
+    Served    = 0;
+    WriteFailed = false;
+    Index.clear();
+    Stopping  = false;
+
+    Worker = std::thread( &WaveCapture::Run, this );
+
+    return WaveNoError;
+
+}
+
+void WaveCapture::Run()
+{
+    UINT Busy, Pos;
+
+    for ( ;; )
+    {
+        get_status( &Busy, &Pos );
+
+        if ( !( Busy & 0x00ff ) && ( Busy & 0xff00 ) && get_wait_status() == WaveWaitWord )
+        {
+            Drain();
+            release_wait();
+            Served++;
+            continue;
+
+        }
+
+        if ( !Busy && Stopping ) break;
+
+        Pause( PollInterval );
+
+    }
+
+    //  Measurement not ended by Instrument's set_wait, e.g. by set_trigger of the caller
+    if ( Served < Planned || !Planned )
+    {
+        stop_trigger();
+        Drain();
+
+    }
+
+}
+
+//  Drain
+//
+//  Description:
+//
+//  Appends the samples of the measurement buffer as one block. After a
+//  failed write the file is not extended any more, Stop returns
+//  WaveFileError.
+//
+
+void WaveCapture::Drain()
+{
+    UINT Busy, Count;
+    measurement_status( &Busy, &Count );
+
+    if ( !Count || !File || WriteFailed ) return;
+
+    Buffer.resize( (size_t) Count * Channels );
+
+    for ( UINT c = 0; c < Channels; c++ ) get_waveform( c + 1, Count, (ULONG_PTR) ( Buffer.data() + (size_t) c * Count ) );
+
+    WaveBlockHeader Block;
+    memset( &Block, 0, sizeof( Block ) );
+    memcpy( Block.Magic, "BLK1", 4 );
+    Block.Count       = Count;
+    Block.FirstSample = Samples;
+    Block.HostTime    = Now() - StartTime;
+    Block.Window      = (uint32_t) Blocks;
+    Block.Flags       = Count >= WindowSamples() ? WaveOverflow : 0;
+
+    if ( fwrite( &Block, sizeof( Block ), 1, File ) != 1
+        || fwrite( Buffer.data(), sizeof( int32_t ), Buffer.size(), File ) != Buffer.size() )
+    {
+        WriteFailed = true;
+        return;
+
+    }
+
+    WaveIndexEntry Entry;
+    Entry.FirstSample = Block.FirstSample;
+    Entry.Offset      = Offset;
+    Entry.HostTime    = Block.HostTime;
+    Entry.Count       = Block.Count;
+    Entry.Flags       = Block.Flags;
+    Index.push_back( Entry );
+
+    Offset  += sizeof( Block ) + Buffer.size() * sizeof( int32_t );
+    Samples += Count;
+    Blocks++;
+
+    if ( Block.Flags & WaveOverflow ) Overflows++;
+
+}
+
+//  Stop
+//
+//  Description:
+//
+//  Waits until the card has finished the list, reads the last window and
+//  completes the wave file by the index and the header.
+//
+
+UINT WaveCapture::Stop()
+{
+    if ( !Worker.joinable() ) return WaveNoError;
+
+    Stopping = true;
+    Worker.join();
+
+    WaveFileHeader Head;
+    memset( &Head, 0, sizeof( Head ) );
+    memcpy( Head.Magic, "RWV1", 4 );
+    Head.Version     = 1;
+    Head.HeaderSize  = sizeof( Head );
+    Head.Channels    = Channels;
+    Head.Period      = Period;
+    Head.BlockCount  = (uint32_t) Index.size();
+    Head.SampleCount = Samples;
+    Head.IndexOffset = Offset;
+
+    for ( UINT i = 0; i < 4; i++ ) Head.Signal[ i ] = Signal[ i ];
+
+    bool Ok = !WriteFailed;
+    Ok = Ok && ( Index.empty() || fwrite( Index.data(), sizeof( WaveIndexEntry ), Index.size(), File ) == Index.size() );
+    Ok = Ok && !Seek( File, 0 ) && fwrite( &Head, sizeof( Head ), 1, File ) == 1;
+    Ok = !fclose( File ) && Ok;
+    File = 0;
+
+    return Ok ? WaveNoError : WaveFileError;
+
+}
+
+//  WaveFile
+
+WaveFile::WaveFile()
+    : File( 0 )
+{
+    memset( &Head, 0, sizeof( Head ) );
+
+}
+
+WaveFile::~WaveFile()
+{
+    Close();
+
+}
+
+UINT WaveFile::Open( const char* Name )
+{
+    Close();
+
+    File = fopen( Name, "rb" );
+    if ( !File ) return WaveFileError;
+
+    if (   fread( &Head, sizeof( Head ), 1, File ) != 1 || memcmp( Head.Magic, "RWV1", 4 )
+        || Head.HeaderSize != sizeof( Head ) || ( Head.Channels != 2 && Head.Channels != 4 ) || !Head.IndexOffset
+       )
+    {
+        Close();
+        return WaveFormatError;
+
+    }
+
+    Index.resize( Head.BlockCount );
+
+    if (   Seek( File, Head.IndexOffset )
+        || ( Index.size() && fread( Index.data(), sizeof( WaveIndexEntry ), Index.size(), File ) != Index.size() )
+       )
+    {
+        Close();
+        return WaveFormatError;
+
+    }
+
+    return WaveNoError;
+
+}
+
+void WaveFile::Close()
+{
+    if ( File ) fclose( File );
+
+    File = 0;
+    Index.clear();
+
+}
+
+//  Read
+//
+//  Description:
+//
+//  Reads samples of one channel across blocks and returns the number read.
+//
+//      Parameter   Meaning
+//
+//      Channel     1 ... Channels, as for get_waveform
+//      First       first sample
+//      Count       samples to read into Out
+//
+
+size_t WaveFile::Read( UINT Channel, uint64_t First, size_t Count, int32_t* Out )
+{
+    if ( !File || Channel < 1 || Channel > Head.Channels ) return 0;
+
+    //  First block ending after First
+    size_t Lo = 0, Hi = Index.size();
+
+    while ( Lo < Hi )
+    {
+        const size_t Mid = ( Lo + Hi ) / 2;
+
+        if ( Index[ Mid ].FirstSample + Index[ Mid ].Count <= First ) Lo = Mid + 1;
+        else Hi = Mid;
+
+    }
+
+    size_t Done = 0;
+
+    for ( size_t b = Lo; b < Index.size() && Done < Count; b++ )
+    {
+        const WaveIndexEntry& e = Index[ b ];
+        const uint64_t From = First + Done - e.FirstSample;
+        size_t n = (size_t) ( e.Count - From );
+
+        if ( n > Count - Done ) n = Count - Done;
+
+        const uint64_t Pos = e.Offset + sizeof( WaveBlockHeader )
+                           + ( (uint64_t) ( Channel - 1 ) * e.Count + From ) * sizeof( int32_t );
+
+        if ( Seek( File, Pos ) || fread( Out + Done, sizeof( int32_t ), n, File ) != n ) break;
+
+        Done += n;
+
+    }
+
+    return Done;
+
+}
@@ -0,0 +1,176 @@
+//  File
+//      RTC5Wave.h
+//
+//  Abstract
+//      Continuous waveform capture.
+//      Demo7 samples one buffer by set_trigger and prints it. A WaveCapture
+//      records a whole job instead: Instrument splits the job into
+//      measurement windows shorter than the measurement buffer, a
+//      background thread reads every window by measurement_status and
+//      get_waveform and appends it to a wave file. set_trigger4 records
+//      four channels.
+//
+//      The measurement buffer can only be read from its start and a new
+//      measurement overwrites it, so every window ends with
+//          long_delay( 1 )             end the polyline, its delays sampled
+//          set_trigger( 0, ... )       stop the measurement
+//          set_wait( WaveWaitWord )    hold the card until the window is read
+//          set_trigger( Period, ... )  next window
+//      Windows end before jumps, i.e. with the laser off, the card only
+//      waits for the transfer of one buffer. The mark and laser off delays
+//      of the last polyline run within the window, otherwise set_wait would
+//      end the polyline after the measurement stopped. No sample of the
+//      marking is lost, the wave file holds the samples without the waits:
+//      one per period, one at the start of each window and one at its end
+//      if that falls on a sample time.
+//
+//      Wave file layout (little endian):
+//          WaveFileHeader              64 bytes
+//          per window:
+//              WaveBlockHeader         32 bytes
+//              int32_t[ Count ]        channel 1
+//              ...                     further channels
+//          WaveIndexEntry[ BlockCount ] at IndexOffset
+//      Sample i was taken i * Period * 10 us of measuring time after the
+//      first sample.
+//
+//  Comment
+//      The capture thread calls RTC5 functions concurrently to the thread
+//      loading the list, e.g. by a ListFeeder. The ListFeeder releases its
+//      own waits only, see FeedWaitWord.
+//
+//  Necessary Sources
+//      RTC5Wave.h, RTC5Wave.cpp, RTC5Timing.h, RTC5Timing.cpp, RTC5List.h,
+//      RTC5List.cpp, RTC5Util.h, RTC5expl.h
+//
+//  Environment: Win32, Linux
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "RTC5List.h"
+#include "RTC5Timing.h"
+
+//  Error codes of the wave functions
+const UINT   WaveNoError          =            0;
+const UINT   WaveFileError        =            1;   //  file not writable or not readable
+const UINT   WaveFormatError      =            2;   //  no wave file or corrupted
+const UINT   WaveRangeError       =            3;   //  period, channels or signals out of range
+const UINT   WaveBusy             =            4;   //  capture running
+
+const UINT   WaveWaitWord         =            2;   //  set_wait between two windows
+const UINT   WaveBufferValues     =      1 << 16;   //  measurement buffer, shared by the channels
+const UINT   WaveOverflow         =            1;   //  block flag: buffer full, samples missing
+
+struct WaveFileHeader
+{
+    char     Magic[ 4 ];        //  "RWV1"
+    uint32_t Version;
+    uint32_t HeaderSize;        //  sizeof( WaveFileHeader )
+    uint32_t Channels;          //  2 or 4
+    uint32_t Period;            //  [10 us]
+    uint32_t Signal[ 4 ];       //  signals of set_trigger / set_trigger4
+    uint32_t BlockCount;
+    uint64_t SampleCount;       //  per channel
+    uint64_t IndexOffset;       //  0 while recording
+    uint32_t Reserved[ 2 ];
+
+};
+
+struct WaveBlockHeader
+{
+    char     Magic[ 4 ];        //  "BLK1"
+    uint32_t Count;             //  samples per channel
+    uint64_t FirstSample;
+    double   HostTime;          //  [s] since the start of the capture, when read
+    uint32_t Window;
+    uint32_t Flags;             //  WaveOverflow
+
+};
+
+struct WaveIndexEntry
+{
+    uint64_t FirstSample;
+    uint64_t Offset;            //  file offset of the WaveBlockHeader
+    double   HostTime;
+    uint32_t Count;
+    uint32_t Flags;
+
+};
+
+class WaveCapture
+{
+public:
+    WaveCapture();
+    ~WaveCapture();
+
+    UINT Configure( UINT Period, UINT Channels, const UINT* Signals );
+    void Instrument( const ListCommand* Cmd, size_t Count, ListJob& Out );
+    UINT Start( const char* Name );
+    UINT Stop();                            //  waits for the end of the list and closes the file, WaveFileError
+                                            //  if a block or the index was not written
+
+    UINT WindowSamples() const;             //  samples per channel of a full buffer
+
+    TimeEstimator Timing;                   //  window lengths, set the parameters of the job first
+    double   Fill;                          //  part of the buffer a window is planned for
+    double   PollInterval;                  //  [s]
+    void   ( *Pause )( double Seconds );    //  sleeps by default
+
+    uint64_t Samples;                       //  per channel
+    uint64_t Blocks;
+    uint64_t Overflows;                     //  windows exceeding the buffer
+    uint64_t Planned;                       //  windows of Instrument, counted up to Stop
+
+private:
+    WaveCapture( const WaveCapture& );
+    WaveCapture& operator=( const WaveCapture& );
+
+    void Run();
+    void Drain();
+    void Arm( ListJob& Out ) const;
+    void Disarm( ListJob& Out ) const;
+
+    uint64_t Served;                        //  windows read at a set_wait
+    UINT     Period;
+    UINT     Channels;
+    UINT     Signal[ 4 ];
+    FILE*    File;
+    bool     WriteFailed;                   //  a block not written, the file is incomplete
+    uint64_t Offset;
+    double   StartTime;
+    std::vector< WaveIndexEntry > Index;
+    std::vector< int32_t > Buffer;
+    std::thread Worker;
+    std::atomic< bool > Stopping;
+
+};
+
+class WaveFile
+{
+public:
+    WaveFile();
+    ~WaveFile();
+
+    UINT   Open( const char* Name );
+    void   Close();
+
+    const WaveFileHeader& Header() const { return Head; }
+    const std::vector< WaveIndexEntry >& Blocks() const { return Index; }
+    size_t Read( UINT Channel, uint64_t First, size_t Count, int32_t* Out );
+
+private:
+    WaveFile( const WaveFile& );
+    WaveFile& operator=( const WaveFile& );
+
+    FILE*  File;
+    WaveFileHeader Head;
+    std::vector< WaveIndexEntry > Index;
+
+};
@@ -0,0 +1,101 @@
+//  File
+//      VarPolyTable.cpp
+//
+//  Abstract
+//      A console application for computing the table of the variable
+//      polygon delay for load_varpolydelay from a model of the scan head.
+//      The head is a GalvoModel of the given natural frequency and damping
+//      0.8, or taken from the tracking delay in a wave file captured with
+//      the command in channels 1, 2 and the real position in channels 3, 4
+//      (see HostBench track).
+//
+//  Usage
+//      VarPolyTable <table file> [mark speed bits/ms] [max error bits] [head Hz | wave file]
+//
+//  Necessary Sources
+//      RTC5Poly.h, RTC5Track.h, RTC5Wave.h and the RTC5Host library
+//
+//  Environment: Win32, Linux
+
+// System header files
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "RTC5Poly.h"
+#include "RTC5Track.h"
+#include "RTC5Wave.h"
+
+int main( int argc, char* argv[] )
+{
+    if ( argc < 2 )
+    {
+        printf( "Usage: VarPolyTable <table file> [mark speed bits/ms] [max error bits] [head Hz | wave file]\n" );
+        return 1;
+
+    }
+
+    PolyDelayTable Table;
+
+    if ( argc > 2 ) Table.MarkSpeed = atof( argv[ 2 ] );
+    if ( argc > 3 ) Table.MaxError  = atof( argv[ 3 ] );
+
+    if ( argc > 4 )
+    {
+        WaveFile File;
+
+        if ( File.Open( argv[ 4 ] ) == WaveNoError )
+        {
+            TrackAnalyzer Analyzer;
+            const UINT ErrorCode = Analyzer.Analyze( File );
+
+            if ( ErrorCode || Analyzer.Lag <= 0 )
+            {
+                printf( "Wave file %s: Error %d detected\n", argv[ 4 ], ErrorCode ? ErrorCode : TrackRangeError );
+                return 1;
+
+            }
+
+            Table.FromLag( Analyzer.Lag * Analyzer.Period );
+            printf( "Tracking delay:  %.1f us\n", Analyzer.Lag * Analyzer.Period * 1e6 );
+
+        }
+        else
+        {
+            for ( UINT a = 0; a < 2; a++ ) Table.Galvo.Axis[ a ].Frequency = atof( argv[ 4 ] );
+            Table.Galvo.Configure();
+
+        }
+
+    }
+
+    printf( "Head:            %.0f Hz, damping %.2f\n", Table.Galvo.Axis[ 0 ].Frequency, Table.Galvo.Axis[ 0 ].Damping );
+    printf( "Mark speed:      %.0f bits/ms\n", Table.MarkSpeed );
+    printf( "Max error:       %.1f bits\n\n", Table.MaxError );
+
+    UINT ErrorCode = Table.Compute();
+
+    if ( ErrorCode == PolyRangeError )
+    {
+        printf( "Parameters out of range\n" );
+        return 1;
+
+    }
+
+    Table.Print( stdout );
+
+    if ( ErrorCode == PolyInfeasible ) printf( "Max error exceeded at %u us\n", Table.MaxDelay * 10 );
+
+    ErrorCode = Table.WriteTable( argv[ 1 ] );
+
+    if ( ErrorCode )
+    {
+        printf( "Table file %s: Error %d detected\n", argv[ 1 ], ErrorCode );
+        return 1;
+
+    }
+
+    printf( "Table:           %s, PolyDelay=%u for RTC5.ini\n", argv[ 1 ], Table.PolygonDelay * 10 );
+
+    return 0;
+
+}